@@ -0,0 +1,20 @@
+# Find the lz4 headers and library, pkg-config is used for hints when it is available
+
+find_package(PkgConfig QUIET)
+if(PKG_CONFIG_FOUND)
+    pkg_check_modules(PC_LZ4 QUIET liblz4)
+endif()
+
+find_path(LZ4_INCLUDE_DIRS NAMES lz4.h HINTS ${PC_LZ4_INCLUDE_DIRS} PATHS /usr/local/include /usr/include)
+find_library(LZ4_LIBRARIES NAMES lz4 HINTS ${PC_LZ4_LIBRARY_DIRS} PATHS /usr/local/lib /usr/lib)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(LZ4 "lz4 not found, lz4 compression is off, install liblz4-dev or lz4-devel for it" LZ4_INCLUDE_DIRS LZ4_LIBRARIES)
+
+if(LZ4_FOUND AND NOT TARGET LZ4::LZ4)
+    add_library(LZ4::LZ4 UNKNOWN IMPORTED)
+    set_target_properties(LZ4::LZ4 PROPERTIES
+        IMPORTED_LOCATION "${LZ4_LIBRARIES}"
+        INTERFACE_INCLUDE_DIRECTORIES "${LZ4_INCLUDE_DIRS}"
+    )
+endif()
@@ -0,0 +1,20 @@
+# Find the zstd headers and library, pkg-config is used for hints when it is available
+
+find_package(PkgConfig QUIET)
+if(PKG_CONFIG_FOUND)
+    pkg_check_modules(PC_ZSTD QUIET libzstd)
+endif()
+
+find_path(ZSTD_INCLUDE_DIRS NAMES zstd.h HINTS ${PC_ZSTD_INCLUDE_DIRS} PATHS /usr/local/include /usr/include)
+find_library(ZSTD_LIBRARIES NAMES zstd HINTS ${PC_ZSTD_LIBRARY_DIRS} PATHS /usr/local/lib /usr/lib)
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(ZSTD "zstd not found, zstd compression is off, install libzstd-dev or libzstd-devel for it" ZSTD_INCLUDE_DIRS ZSTD_LIBRARIES)
+
+if(ZSTD_FOUND AND NOT TARGET ZSTD::ZSTD)
+    add_library(ZSTD::ZSTD UNKNOWN IMPORTED)
+    set_target_properties(ZSTD::ZSTD PROPERTIES
+        IMPORTED_LOCATION "${ZSTD_LIBRARIES}"
+        INTERFACE_INCLUDE_DIRECTORIES "${ZSTD_INCLUDE_DIRS}"
+    )
+endif()
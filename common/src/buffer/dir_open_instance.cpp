@@ -24,34 +24,39 @@ uint64_t CuckooFd::ObtainFd()
 
 void CuckooFd::AddOpenInstance(uint64_t fd, std::shared_ptr<OpenInstance> openInstance)
 {
-    std::unique_lock lock(openInstanceMapMutex);
-    if (auto [it, inserted] = openInstanceMap.try_emplace(fd, std::move(openInstance)); !inserted) {
+    if (!openInstanceMap.Insert(fd, openInstance)) {
         CUCKOO_LOG(LOG_ERROR) << "AddOpenInstance(): fd" << fd << " already exists";
     }
 }
 
-int CuckooFd::DeleteOpenInstance(uint64_t fd, bool subCnt)
+void CuckooFd::AddInodeOpenInstance(std::shared_ptr<OpenInstance> openInstance)
 {
-    int ret = -EBADF;
-    std::unique_lock<std::shared_mutex> openInstanceMapLock(openInstanceMapMutex);
-    auto it = openInstanceMap.find(fd);
-    if (it != openInstanceMap.end()) {
-        auto openInstance = it->second;
-        openInstanceMap.erase(it);
-        openInstanceMapLock.unlock();
-        std::unique_lock<std::shared_mutex> inodeToOpenInstanceLock(inodeToOpenInstanceMutex);
-        auto inodeId = openInstance->inodeId;
-        inodeToOpenInstanceMap[inodeId].erase(openInstance);
-        if (inodeToOpenInstanceMap[inodeId].empty()) {
-            inodeToOpenInstanceMap.erase(inodeId);
+    uint64_t inodeId = openInstance->inodeId;
+    inodeToOpenInstanceMap.Modify(inodeId, [&](auto &map) -> size_t {
+        map[inodeId].insert(openInstance);
+        return 1;
+    });
+}
+
+int CuckooFd::DeleteOpenInstance(uint64_t fd)
+{
+    std::shared_ptr<OpenInstance> openInstance;
+    if (!openInstanceMap.Erase(fd, &openInstance)) {
+        return -EBADF;
+    }
+    uint64_t inodeId = openInstance->inodeId;
+    inodeToOpenInstanceMap.Modify(inodeId, [&](auto &map) -> size_t {
+        auto it = map.find(inodeId);
+        if (it == map.end()) {
+            return 0;
         }
-        inodeToOpenInstanceLock.unlock();
-        if (subCnt) {
-            ReleaseOpenInstance();
+        it->second.erase(openInstance);
+        if (it->second.empty()) {
+            map.erase(it);
         }
-        ret = 0;
-    }
-    return ret;
+        return 1;
+    });
+    return 0;
 }
 
 uint64_t CuckooFd::AttachFd(uint64_t inodeId,
@@ -69,7 +74,7 @@ uint64_t CuckooFd::AttachFd(uint64_t inodeId,
     }
     uint64_t fd = ObtainFd();
     if (isRead) {
-        openInstance->readBuffer = readBuffer;
+        openInstance->SetReadBuffer(readBuffer, readBuffer == nullptr ? 0 : static_cast<int>(size));
     }
     openInstance->inodeId = inodeId;
     openInstance->fd = fd;
@@ -79,10 +84,9 @@ uint64_t CuckooFd::AttachFd(uint64_t inodeId,
     openInstance->currentSize = size;
     openInstance->nodeId = nodeId;
     openInstance->backupNodeId = backupNodeId;
-    openInstance->path = path;
+    openInstance->path = std::move(path);
     AddOpenInstance(fd, openInstance);
-    std::unique_lock<std::shared_mutex> inodeToOpenInstanceLock(inodeToOpenInstanceMutex);
-    inodeToOpenInstanceMap[inodeId].insert(openInstance);
+    AddInodeOpenInstance(std::move(openInstance));
     return fd;
 }
 
@@ -91,16 +95,15 @@ uint64_t CuckooFd::AttachFd(const std::string & /*path*/, std::shared_ptr<OpenIn
     uint64_t fd = ObtainFd();
     openInstance->fd = fd;
     AddOpenInstance(fd, openInstance);
-    std::unique_lock<std::shared_mutex> inodeToOpenInstanceLock(inodeToOpenInstanceMutex);
-    inodeToOpenInstanceMap[openInstance->inodeId].insert(openInstance);
+    AddInodeOpenInstance(std::move(openInstance));
     return fd;
 }
 
 std::shared_ptr<OpenInstance> CuckooFd::GetOpenInstanceByFd(uint64_t fd)
 {
-    std::shared_lock<std::shared_mutex> openInstanceMapLock(openInstanceMapMutex);
-    if (openInstanceMap.contains(fd)) {
-        return openInstanceMap[fd];
+    std::shared_ptr<OpenInstance> openInstance;
+    if (openInstanceMap.Find(fd, openInstance)) {
+        return openInstance;
     }
     CUCKOO_LOG(LOG_ERROR) << "GetOpenInstanceByFd(): fd" << fd << " not found";
     return nullptr;
@@ -108,12 +111,7 @@ std::shared_ptr<OpenInstance> CuckooFd::GetOpenInstanceByFd(uint64_t fd)
 
 int CuckooFd::AddDirOpenInstance(uint64_t fd, DirOpenInstance *dirOpenInstance)
 {
-    std::unique_lock<std::shared_mutex> dirOpenInstanceLock(dirOpenInstanceMutex);
-    if (!dirOpenInstanceMap.contains(fd)) {
-        dirOpenInstanceMap[fd] = dirOpenInstance;
-        return 0;
-    }
-    return -EBADF;
+    return dirOpenInstanceMap.Insert(fd, dirOpenInstance) ? 0 : -EBADF;
 }
 
 uint64_t CuckooFd::AttachDirFd(uint64_t /*inodeId*/)
@@ -129,55 +127,33 @@ uint64_t CuckooFd::AttachDirFd(uint64_t /*inodeId*/)
 
 DirOpenInstance *CuckooFd::GetDirOpenInstanceByFd(uint64_t fd)
 {
-    std::shared_lock<std::shared_mutex> dirOpenInstanceLock(dirOpenInstanceMutex);
-    return dirOpenInstanceMap.contains(fd) ? dirOpenInstanceMap[fd] : nullptr;
+    DirOpenInstance *dirOpenInstance = nullptr;
+    return dirOpenInstanceMap.Find(fd, dirOpenInstance) ? dirOpenInstance : nullptr;
 }
 
 int CuckooFd::DeleteDirOpenInstance(uint64_t fd)
 {
-    int ret = -EBADF;
-    std::unique_lock<std::shared_mutex> dirOpenInstanceLock(dirOpenInstanceMutex);
-    auto it = dirOpenInstanceMap.find(fd);
-    if (it != dirOpenInstanceMap.end()) {
-        DirOpenInstance *dirOpenInstance = it->second;
-        dirOpenInstanceMap.erase(it);
-        dirOpenInstanceLock.unlock();
-        delete dirOpenInstance;
-        ret = 0;
+    DirOpenInstance *dirOpenInstance = nullptr;
+    if (!dirOpenInstanceMap.Erase(fd, &dirOpenInstance)) {
+        return -EBADF;
     }
-    return ret;
+    delete dirOpenInstance;
+    return 0;
 }
 
-std::shared_ptr<OpenInstance> CuckooFd::WaitGetNewOpenInstance(bool addCnt)
+std::shared_ptr<OpenInstance> CuckooFd::WaitGetNewOpenInstance(bool wait)
 {
-    if (addCnt) {
-        std::mutex mu;
-        std::unique_lock<std::mutex> sleepLock(mu);
-        newOpenInstanceCV.wait(sleepLock, [this]() { return currOpenInstance.load() < MAX_OPENINSTANCE_NUM; });
-    }
-
-    std::shared_ptr<OpenInstance> instance;
-    try {
-        instance = std::make_shared<OpenInstance>();
-    } catch (const std::bad_alloc &) {
-        instance = nullptr;
-    }
-    if (instance && addCnt) {
-        ++currOpenInstance;
-    }
-
-    return instance;
+    return openInstancePool->Get(wait);
 }
 
-void CuckooFd::ReleaseOpenInstance()
+void CuckooFd::SetOpenInstanceMemoryBudget(uint64_t budget)
 {
-    --currOpenInstance;
-    newOpenInstanceCV.notify_one();
+    openInstancePool->SetMemoryBudget(budget);
 }
 
 std::unordered_set<std::shared_ptr<OpenInstance>> CuckooFd::GetInodetoOpenInstanceSet(uint64_t inodeId)
 {
-    std::shared_lock<std::shared_mutex> lock(inodeToOpenInstanceMutex);
-    return inodeToOpenInstanceMap.contains(inodeId) ? inodeToOpenInstanceMap.at(inodeId)
-                                                    : std::unordered_set<std::shared_ptr<OpenInstance>>{};
+    std::unordered_set<std::shared_ptr<OpenInstance>> openInstanceSet;
+    inodeToOpenInstanceMap.Read(inodeId, [&openInstanceSet](const auto &set) { openInstanceSet = set; });
+    return openInstanceSet;
 }
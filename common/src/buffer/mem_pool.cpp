@@ -0,0 +1,272 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "buffer/mem_pool.h"
+
+#include <sched.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+/* bytes a thread caches per pool, bounds the magazine of pools with large blocks */
+constexpr size_t MAGAZINE_BYTES = 4 * 1024 * 1024;
+constexpr size_t MAGAZINE_MIN_SIZE = 2;
+constexpr size_t MAGAZINE_MAX_SIZE = 64;
+constexpr size_t BLOCK_ALIGNMENT = 512;
+
+namespace {
+
+struct Magazine
+{
+    const MemPool::Shared *key = nullptr;
+    std::weak_ptr<MemPool::Shared> owner;
+    std::vector<void *> blocks;
+};
+
+/* set once the magazines of the thread are destroyed, trivial so it outlives them */
+thread_local bool t_magazinesGone = false;
+
+struct MagazineHolder
+{
+    std::vector<Magazine> magazines;
+
+    ~MagazineHolder()
+    {
+        t_magazinesGone = true;
+        for (auto &magazine : magazines) {
+            std::shared_ptr<MemPool::Shared> shared = magazine.owner.lock();
+            if (shared != nullptr) {
+                shared->Give(magazine.blocks, 0);
+            } else {
+                for (void *block : magazine.blocks) {
+                    ::free(block);
+                }
+            }
+        }
+    }
+};
+
+size_t NumaNodeCount()
+{
+    static size_t nodeCount = []() -> size_t {
+        /* e.g. "0-1" or "0" */
+        std::ifstream possible("/sys/devices/system/node/possible");
+        std::string nodes;
+        if (!std::getline(possible, nodes) || nodes.empty()) {
+            return 1;
+        }
+        size_t pos = nodes.find_last_of("-,");
+        std::string last = pos == std::string::npos ? nodes : nodes.substr(pos + 1);
+        return std::max<size_t>(std::strtoul(last.c_str(), nullptr, 10) + 1, 1);
+    }();
+    return nodeCount;
+}
+
+} // namespace
+
+MemPool::Shared::~Shared()
+{
+    for (auto &depot : depots) {
+        for (void *block : depot.blocks) {
+            ::free(block);
+        }
+        pthread_spin_destroy(&depot.lock);
+    }
+}
+
+MemPool::Depot &MemPool::Shared::LocalDepot()
+{
+    if (!numaAware.load(std::memory_order_relaxed)) {
+        return depots[0];
+    }
+    unsigned int cpu = 0;
+    unsigned int node = 0;
+    if (getcpu(&cpu, &node) != 0 || node >= depots.size()) {
+        return depots[0];
+    }
+    return depots[node];
+}
+
+size_t MemPool::Shared::DepotCapacity()
+{
+    if (!numaAware.load(std::memory_order_relaxed)) {
+        return capacity;
+    }
+    return (capacity + depots.size() - 1) / depots.size();
+}
+
+void *MemPool::Shared::NewBlock()
+{
+    char *block = (char *)aligned_alloc(BLOCK_ALIGNMENT, blockSize);
+    if (block != nullptr && numaAware.load(std::memory_order_relaxed)) {
+        /* first touch places the pages on the node of this thread */
+        size_t pageSize = getpagesize();
+        for (size_t offset = 0; offset < blockSize; offset += pageSize) {
+            block[offset] = 0;
+        }
+    }
+    return block;
+}
+
+void MemPool::Shared::Take(std::vector<void *> &blocks, size_t num)
+{
+    Depot &depot = LocalDepot();
+    pthread_spin_lock(&depot.lock);
+    size_t taken = std::min(num, depot.blocks.size());
+    blocks.insert(blocks.end(), depot.blocks.end() - taken, depot.blocks.end());
+    depot.blocks.resize(depot.blocks.size() - taken);
+    pthread_spin_unlock(&depot.lock);
+}
+
+void MemPool::Shared::Give(std::vector<void *> &blocks, size_t keep)
+{
+    if (blocks.size() <= keep) {
+        return;
+    }
+    Depot &depot = LocalDepot();
+    size_t depotCapacity = DepotCapacity();
+    pthread_spin_lock(&depot.lock);
+    while (blocks.size() > keep && depot.blocks.size() < depotCapacity) {
+        depot.blocks.push_back(blocks.back());
+        blocks.pop_back();
+    }
+    pthread_spin_unlock(&depot.lock);
+    while (blocks.size() > keep) {
+        ::free(blocks.back());
+        blocks.pop_back();
+    }
+}
+
+MemPool::~MemPool()
+{
+    /* blocks still cached by threads are freed when the threads exit */
+    m_init.store(false);
+    m_shared.reset();
+}
+
+void MemPool::init(size_t blockSize, size_t capacity)
+{
+    if (m_init.load()) {
+        return;
+    }
+    auto shared = std::make_shared<Shared>();
+    shared->blockSize = blockSize;
+    shared->capacity = capacity;
+    shared->magazineSize = std::clamp(MAGAZINE_BYTES / std::max<size_t>(blockSize, 1),
+                                      MAGAZINE_MIN_SIZE,
+                                      MAGAZINE_MAX_SIZE);
+    shared->depots = std::vector<Depot>(NumaNodeCount());
+    for (auto &depot : shared->depots) {
+        pthread_spin_init(&depot.lock, 0);
+        depot.blocks.reserve(std::min<size_t>(capacity, 1024));
+    }
+    m_shared = std::move(shared);
+    m_init.store(true);
+}
+
+void MemPool::SetNumaAware(bool numaAware)
+{
+    if (m_init.load()) {
+        m_shared->numaAware.store(numaAware && m_shared->depots.size() > 1);
+    }
+}
+
+std::vector<void *> *MemPool::LocalMagazine()
+{
+    if (t_magazinesGone) [[unlikely]] {
+        return nullptr;
+    }
+    thread_local MagazineHolder holder;
+    Shared *key = m_shared.get();
+    for (auto &magazine : holder.magazines) {
+        if (magazine.key != key) {
+            continue;
+        }
+        if (magazine.owner.expired()) [[unlikely]] {
+            /* an earlier pool at the same address is gone, its blocks are of no use */
+            for (void *block : magazine.blocks) {
+                ::free(block);
+            }
+            magazine.blocks.clear();
+            magazine.owner = m_shared;
+        }
+        return &magazine.blocks;
+    }
+    Magazine &magazine = holder.magazines.emplace_back();
+    magazine.key = key;
+    magazine.owner = m_shared;
+    magazine.blocks.reserve(m_shared->magazineSize);
+    return &magazine.blocks;
+}
+
+void *MemPool::alloc()
+{
+    if (!m_init.load()) {
+        return nullptr;
+    }
+    std::vector<void *> *magazine = LocalMagazine();
+    if (magazine == nullptr) [[unlikely]] {
+        std::vector<void *> blocks;
+        m_shared->Take(blocks, 1);
+        return blocks.empty() ? m_shared->NewBlock() : blocks.front();
+    }
+    if (magazine->empty()) {
+        m_shared->Take(*magazine, std::max<size_t>(m_shared->magazineSize / 2, 1));
+    }
+    if (magazine->empty()) {
+        return m_shared->NewBlock();
+    }
+    void *block = magazine->back();
+    magazine->pop_back();
+    return block;
+}
+
+std::vector<void *> MemPool::calloc(int num)
+{
+    if (!m_init.load() || num <= 0) {
+        return {};
+    }
+    std::vector<void *> bulkMem;
+    bulkMem.reserve(num);
+    std::vector<void *> *magazine = LocalMagazine();
+    if (magazine != nullptr) {
+        size_t fromMagazine = std::min<size_t>(num, magazine->size());
+        bulkMem.insert(bulkMem.end(), magazine->end() - fromMagazine, magazine->end());
+        magazine->resize(magazine->size() - fromMagazine);
+    }
+    m_shared->Take(bulkMem, num - bulkMem.size());
+    while (bulkMem.size() < static_cast<size_t>(num)) {
+        void *mem = m_shared->NewBlock();
+        if (mem == nullptr) {
+            /* error */
+            for (auto &m : bulkMem) {
+                free(m);
+            }
+            return {};
+        }
+        bulkMem.emplace_back(mem);
+    }
+    return bulkMem;
+}
+
+void MemPool::free(void *buf)
+{
+    if (!m_init.load()) {
+        return;
+    }
+    if (buf == nullptr) {
+        return;
+    }
+    std::vector<void *> *magazine = LocalMagazine();
+    if (magazine == nullptr) [[unlikely]] {
+        std::vector<void *> blocks = {buf};
+        m_shared->Give(blocks, 0);
+        return;
+    }
+    if (magazine->size() >= m_shared->magazineSize) {
+        m_shared->Give(*magazine, m_shared->magazineSize / 2);
+    }
+    magazine->push_back(buf);
+}
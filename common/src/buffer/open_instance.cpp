@@ -4,5 +4,149 @@
 
 #include "buffer/open_instance.h"
 
+std::atomic<int64_t> OpenInstance::streamBytes = 0;
+
 void OpenInstance::LockOpenInstance() { fileMutex.lock(); }
 void OpenInstance::UnlockOpenInstance() { fileMutex.unlock(); }
+
+void OpenInstance::Reset()
+{
+    /* the pre-read threads use the members below, stop them first */
+    readStream.Reset();
+    fd = UINT64_MAX;
+    inodeId = 0;
+    serialReadEnd = 0;
+    currentSize = 0;
+    originalSize = 0;
+    physicalFd = UINT64_MAX;
+    oflags = 0;
+    nodeId = -1;
+    backupNodeId = -1;
+    nodeFail = false;
+    writeCnt = 0;
+    writeFail = false;
+    readFail = false;
+    isRemoteCall = false;
+    remoteFailed = false;
+    isFlushed = false;
+    isClosed = false;
+    fileLocked = false;
+    SetReadBuffer(nullptr, 0);
+    preReadStarted = false;
+    preReadStopped = false;
+    directReadFile = false;
+    path.clear();
+    isOpened = false;
+    writeStream.Reset();
+}
+
+void OpenInstance::SetReadBuffer(std::shared_ptr<char> buffer, int size)
+{
+    streamBytes.fetch_add(static_cast<int64_t>(size) - readBufferSize, std::memory_order_relaxed);
+    readBuffer = std::move(buffer);
+    readBufferSize = size;
+}
+
+OpenInstancePool::OpenInstancePool(size_t capacity, uint64_t memoryBudget)
+    : capacity(capacity),
+      memoryBudget(memoryBudget)
+{
+    idle.reserve(capacity);
+}
+
+OpenInstancePool::~OpenInstancePool()
+{
+    for (OpenInstance *instance : idle) {
+        delete instance;
+    }
+}
+
+int64_t OpenInstancePool::GetMemoryUsage()
+{
+    return reservedBytes.load() + OpenInstance::streamBytes.load();
+}
+
+size_t OpenInstancePool::GetIdleNum()
+{
+    std::lock_guard<std::mutex> lock(idleMutex);
+    return idle.size();
+}
+
+void OpenInstancePool::SetMemoryBudget(uint64_t budget)
+{
+    memoryBudget.store(budget);
+    std::lock_guard<std::mutex> lock(waitMutex);
+    budgetCV.notify_all();
+}
+
+bool OpenInstancePool::Reserve()
+{
+    constexpr int64_t instanceBytes = sizeof(OpenInstance);
+    int64_t reserved = reservedBytes.load();
+    do {
+        if (reserved + OpenInstance::streamBytes.load() + instanceBytes > static_cast<int64_t>(memoryBudget.load())) {
+            return false;
+        }
+    } while (!reservedBytes.compare_exchange_weak(reserved, reserved + instanceBytes));
+    return true;
+}
+
+std::shared_ptr<OpenInstance> OpenInstancePool::Get(bool wait)
+{
+    if (!Reserve()) {
+        if (!wait) {
+            /* the rpc server never waits, its opens may go over the budget */
+            reservedBytes += sizeof(OpenInstance);
+        } else {
+            std::unique_lock<std::mutex> lock(waitMutex);
+            ++waiters;
+            /* write buffers handed to rpcs are released without a Put, check the budget again now and then */
+            while (!budgetCV.wait_for(lock, BUDGET_RECHECK_INTERVAL, [this]() { return Reserve(); })) {
+            }
+            --waiters;
+        }
+    }
+
+    OpenInstance *instance = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        if (!idle.empty()) {
+            instance = idle.back();
+            idle.pop_back();
+        }
+    }
+    if (instance == nullptr) {
+        instance = new (std::nothrow) OpenInstance();
+        if (instance == nullptr) {
+            reservedBytes -= sizeof(OpenInstance);
+            return nullptr;
+        }
+    }
+    ++inUse;
+    try {
+        return std::shared_ptr<OpenInstance>(instance,
+                                             [pool = shared_from_this()](OpenInstance *ptr) { pool->Put(ptr); });
+    } catch (const std::bad_alloc &) {
+        /* the deleter has been called */
+        return nullptr;
+    }
+}
+
+void OpenInstancePool::Put(OpenInstance *instance)
+{
+    instance->Reset();
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        if (idle.size() < capacity) {
+            idle.push_back(instance);
+            instance = nullptr;
+        }
+    }
+    delete instance;
+    --inUse;
+    reservedBytes -= sizeof(OpenInstance);
+    if (waiters.load() > 0) {
+        std::lock_guard<std::mutex> lock(waitMutex);
+        budgetCV.notify_one();
+    }
+}
\ No newline at end of file
@@ -17,10 +17,14 @@
 #include <sys/types.h>
 
 #include "buffer/open_instance.h"
+#include "buffer/striped_map.h"
 #include "connection.h"
 
 constexpr int START_FD = 3;
-constexpr int MAX_OPENINSTANCE_NUM = 4000;
+/* memory open files may hold before opens wait, overridden by cuckoo_open_file_memory_mb */
+constexpr uint64_t DEFAULT_OPENINSTANCE_MEMORY_BUDGET = 4ULL * 1024 * 1024 * 1024;
+/* closed instances kept for reuse */
+constexpr size_t OPENINSTANCE_POOL_CAPACITY = 4096;
 
 struct DirOpenInstance
 {
@@ -82,25 +86,30 @@ class CuckooFd {
                       bool isRead = true);
     uint64_t AttachFd(const std::string &path, std::shared_ptr<OpenInstance> openInstance);
     std::shared_ptr<OpenInstance> GetOpenInstanceByFd(uint64_t fd);
-    int DeleteOpenInstance(uint64_t fd, bool subCnt = true);
+    int DeleteOpenInstance(uint64_t fd);
     uint64_t AttachDirFd(uint64_t inodeId);
     DirOpenInstance *GetDirOpenInstanceByFd(uint64_t fd);
     int DeleteDirOpenInstance(uint64_t fd);
     uint64_t ObtainFd();
     void AddOpenInstance(uint64_t fd, std::shared_ptr<OpenInstance> openInstance);
     int AddDirOpenInstance(uint64_t fd, DirOpenInstance *dirOpenInstance);
-    std::shared_ptr<OpenInstance> WaitGetNewOpenInstance(bool addCnt = true);
-    void ReleaseOpenInstance();
+    /* the budget is released when the last reference is dropped, wait is false for the rpc server */
+    std::shared_ptr<OpenInstance> WaitGetNewOpenInstance(bool wait = true);
     std::unordered_set<std::shared_ptr<OpenInstance>> GetInodetoOpenInstanceSet(uint64_t inodeId);
+    void SetOpenInstanceMemoryBudget(uint64_t budget);
+    uint32_t GetOpenInstanceNum() { return openInstancePool->GetInUseNum(); }
+    int64_t GetOpenInstanceMemory() { return openInstancePool->GetMemoryUsage(); }
+    uint64_t GetOpenInstanceMemoryBudget() { return openInstancePool->GetMemoryBudget(); }
+    size_t GetIdleOpenInstanceNum() { return openInstancePool->GetIdleNum(); }
 
   private:
-    std::unordered_map<uint64_t, std::shared_ptr<OpenInstance>> openInstanceMap;
-    std::unordered_map<uint64_t, DirOpenInstance *> dirOpenInstanceMap;
-    std::unordered_map<uint64_t, std::unordered_set<std::shared_ptr<OpenInstance>>> inodeToOpenInstanceMap;
+    void AddInodeOpenInstance(std::shared_ptr<OpenInstance> openInstance);
+
+    /* looked up by every rpc and io, changed only on open and close */
+    StripedMap<uint64_t, std::shared_ptr<OpenInstance>> openInstanceMap;
+    StripedMap<uint64_t, DirOpenInstance *> dirOpenInstanceMap;
+    StripedMap<uint64_t, std::unordered_set<std::shared_ptr<OpenInstance>>> inodeToOpenInstanceMap;
     std::atomic<uint64_t> nextFD{START_FD};
-    std::shared_mutex inodeToOpenInstanceMutex;
-    std::shared_mutex openInstanceMapMutex;
-    std::shared_mutex dirOpenInstanceMutex;
-    std::atomic<uint32_t> currOpenInstance = 0;
-    std::condition_variable newOpenInstanceCV;
+    std::shared_ptr<OpenInstancePool> openInstancePool =
+        std::make_shared<OpenInstancePool>(OPENINSTANCE_POOL_CAPACITY, DEFAULT_OPENINSTANCE_MEMORY_BUDGET);
 };
@@ -7,9 +7,22 @@
 #include <pthread.h>
 #include <atomic>
 #include <cstdlib>
-#include <queue>
+#include <memory>
 #include <vector>
 
+/*
+ * Pool of fixed size blocks, aligned to 512 for direct io.
+ *
+ * Every thread keeps a small magazine of free blocks per pool, alloc and free only touch it.
+ * An empty magazine is refilled with half a magazine from a global depot and a full one drains
+ * half into it, so the depot lock is taken once per several operations. The depot is bounded by
+ * capacity, blocks beyond it go back to the system.
+ *
+ * With numa awareness on there is one depot per NUMA node and a thread uses the depot of the node
+ * it runs on. New blocks are first touched by the allocating thread, so their pages are placed on
+ * that node. Blocks are not tracked by node, a block freed by a thread on another node joins the depot
+ * of the freeing thread.
+ */
 class MemPool {
   public:
     static MemPool &GetInstance()
@@ -19,120 +32,44 @@ class MemPool {
     }
 
     MemPool() = default;
+    MemPool(size_t blockSize, size_t capacity) { init(blockSize, capacity); }
+    ~MemPool();
 
-    MemPool(size_t blockSize, size_t capacity)
-    {
-        if (!m_init.exchange(true)) {
-            m_blockSize = blockSize;
-            m_capacity = capacity;
-            m_memLock = new (std::nothrow) pthread_spinlock_t;
-            if (m_memLock != nullptr) {
-                pthread_spin_init(m_memLock, 0);
-            } else {
-                m_init.store(false);
-            }
-        }
-    }
+    void init(size_t blockSize, size_t capacity);
+    void SetNumaAware(bool numaAware);
 
-    ~MemPool()
-    {
-        while (!m_freeBlocks.empty()) {
-            free(m_freeBlocks.front());
-            m_freeBlocks.pop();
-        }
-        if (m_memLock) {
-            delete m_memLock;
-            m_memLock = nullptr;
-        }
-    }
+    void *alloc();
+    std::vector<void *> calloc(int num);
+    void free(void *buf);
 
-    void init(size_t blockSize, size_t capacity)
+    struct alignas(64) Depot
     {
-        if (!m_init.exchange(true)) {
-            m_blockSize = blockSize;
-            m_capacity = capacity;
-            m_memLock = new (std::nothrow) pthread_spinlock_t;
-            if (m_memLock != nullptr) {
-                pthread_spin_init(m_memLock, 0);
-            } else {
-                m_init.store(false);
-            }
-        }
-    }
+        pthread_spinlock_t lock;
+        std::vector<void *> blocks;
+    };
 
-    void *alloc()
+    /* state shared with the magazines of the threads, outlives the pool while a thread caches blocks */
+    struct Shared
     {
-        if (!m_init.load()) {
-            return nullptr;
-        }
-        void *block = nullptr;
-        pthread_spin_lock(m_memLock);
-        if (!m_freeBlocks.empty()) {
-            block = m_freeBlocks.front();
-            m_freeBlocks.pop();
-        }
-        pthread_spin_unlock(m_memLock);
-        block = block ? block : aligned_alloc(512, m_blockSize);
-        m_size += block ? 1 : 0;
-        return block;
-    }
+        size_t blockSize = 0;
+        size_t capacity = 0;
+        size_t magazineSize = 0;
+        std::atomic<bool> numaAware = false;
+        std::vector<Depot> depots;
 
-    std::vector<void *> calloc(int num)
-    {
-        if (!m_init.load()) {
-            return {};
-        }
-        std::vector<void *> bulkMem;
-
-        pthread_spin_lock(m_memLock);
-        while (!m_freeBlocks.empty() && num--) {
-            bulkMem.emplace_back(m_freeBlocks.front());
-            m_freeBlocks.pop();
-        }
-        pthread_spin_unlock(m_memLock);
-        while (num > 0) {
-            void *mem = aligned_alloc(512, m_blockSize);
-            if (mem == nullptr) {
-                break;
-            }
-            bulkMem.emplace_back(mem);
-            num--;
-        }
-
-        if (num > 0) {
-            /* error */
-            for (auto &m : bulkMem) {
-                /* how to free? */
-                ::free(m);
-            }
-            bulkMem.clear();
-        }
-        m_size += bulkMem.size();
-        return bulkMem;
-    }
-
-    void free(void *buf)
-    {
-        if (!m_init.load()) {
-            return;
-        }
-        if (buf == nullptr) {
-            return;
-        }
-        if (m_size-- < m_capacity) {
-            pthread_spin_lock(m_memLock);
-            m_freeBlocks.push(buf);
-            pthread_spin_unlock(m_memLock);
-        } else {
-            ::free(buf);
-        }
-    }
+        ~Shared();
+        Depot &LocalDepot();
+        size_t DepotCapacity();
+        void *NewBlock();
+        /* moves up to num blocks of the depot into blocks */
+        void Take(std::vector<void *> &blocks, size_t num);
+        /* moves blocks from the back of blocks into the depot until keep are left, frees what does not fit */
+        void Give(std::vector<void *> &blocks, size_t keep);
+    };
 
   private:
+    std::vector<void *> *LocalMagazine();
+
     std::atomic<bool> m_init = false;
-    size_t m_blockSize = 0;
-    size_t m_capacity = 0;
-    std::atomic<size_t> m_size = 0;
-    std::queue<void *> m_freeBlocks;
-    pthread_spinlock_t *m_memLock = nullptr;
+    std::shared_ptr<Shared> m_shared;
 };
@@ -5,19 +5,72 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <shared_mutex>
+#include <vector>
 
 #include "read_stream/read_stream.h"
 #include "write_stream/stream_assembler.h"
 
 struct OpenInstance
 {
+    /* constructed on first use, most opens never pre-read */
+    template <typename T>
+    class LazyStream {
+      public:
+        LazyStream() = default;
+        LazyStream(const LazyStream &) = delete;
+        LazyStream &operator=(const LazyStream &) = delete;
+        ~LazyStream() { Reset(); }
+
+        T *operator->() { return Get(); }
+        T &operator*() { return *Get(); }
+        bool Constructed() const { return stream.load(std::memory_order_acquire) != nullptr; }
+
+        T *Get()
+        {
+            T *current = stream.load(std::memory_order_acquire);
+            if (current != nullptr) [[likely]] {
+                return current;
+            }
+            T *created = new T();
+            if (!stream.compare_exchange_strong(current, created, std::memory_order_acq_rel)) {
+                delete created;
+                return current;
+            }
+            streamBytes.fetch_add(sizeof(T), std::memory_order_relaxed);
+            return created;
+        }
+
+        /* only when no one else uses the stream */
+        void Reset()
+        {
+            T *current = stream.exchange(nullptr, std::memory_order_acq_rel);
+            if (current != nullptr) {
+                delete current;
+                streamBytes.fetch_sub(sizeof(T), std::memory_order_relaxed);
+            }
+        }
+
+      private:
+        std::atomic<T *> stream = nullptr;
+    };
+
     OpenInstance() = default;
 
     ~OpenInstance() = default;
     void LockOpenInstance();
     void UnlockOpenInstance();
+    /* back to the state of a new instance, must not be in use */
+    void Reset();
+    /* keeps the content of a small file read at open, charged until the instance is reset */
+    void SetReadBuffer(std::shared_ptr<char> buffer, int size);
+
+    /* bytes held by the streams of all open instances, including their write, pre-read and small file buffers */
+    static std::atomic<int64_t> streamBytes;
 
     // pseudo fd generated by cuckoo
     uint64_t fd = UINT64_MAX;
@@ -40,6 +93,8 @@ struct OpenInstance
     int backupNodeId = -1;
     // whether nodeid is changed
     bool nodeFail = false;
+    // guards nodeId and physicalFd while a read only open fails over to the backup
+    std::shared_mutex nodeMutex;
     // times to call cuckoowrite
     std::atomic<int> writeCnt = 0;
     // whether write fail
@@ -55,6 +110,8 @@ struct OpenInstance
     // is closed called for rpc server
     std::atomic<bool> isClosed = false;
     std::shared_mutex closeMutex;
+    // fcntl or flock lock taken through this instance, fuse unlocks on every flush otherwise
+    std::atomic<bool> fileLocked = false;
 
     // used to store content of small file to read
     std::shared_ptr<char> readBuffer = nullptr;
@@ -71,5 +128,43 @@ struct OpenInstance
     // buffer to aggregate write data
     WriteStream writeStream;
     // buffer to store pre-fetched data. Must be LAST to be DESTRUCTED FIRST
-    ReadStream readStream;
+    LazyStream<ReadStream> readStream;
+};
+
+/*
+ * Recycles open instances and bounds the memory they hold. An instance goes back to the pool when its last
+ * reference is dropped, so the budget is released exactly once whatever path closes the file.
+ */
+class OpenInstancePool : public std::enable_shared_from_this<OpenInstancePool> {
+  public:
+    OpenInstancePool(size_t capacity, uint64_t memoryBudget);
+    ~OpenInstancePool();
+
+    /* waits while the budget is used up if wait is set, nullptr if out of memory */
+    std::shared_ptr<OpenInstance> Get(bool wait);
+    void SetMemoryBudget(uint64_t budget);
+
+    uint64_t GetMemoryBudget() { return memoryBudget.load(); }
+    int64_t GetMemoryUsage();
+    uint32_t GetInUseNum() { return inUse.load(); }
+    size_t GetIdleNum();
+
+  private:
+    /* reserves the memory of one instance if it fits in the budget, check and reserve are one step */
+    bool Reserve();
+    void Put(OpenInstance *instance);
+
+    size_t capacity;
+    std::atomic<uint64_t> memoryBudget;
+    std::atomic<uint32_t> inUse = 0;
+    static constexpr std::chrono::milliseconds BUDGET_RECHECK_INTERVAL{10};
+
+    /* memory of the instances in use */
+    std::atomic<int64_t> reservedBytes = 0;
+    std::mutex idleMutex;
+    std::vector<OpenInstance *> idle;
+
+    std::mutex waitMutex;
+    std::condition_variable budgetCV;
+    std::atomic<int> waiters = 0;
 };
@@ -0,0 +1,110 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+#include <butil/containers/doubly_buffered_data.h>
+
+/*
+ * Map for lookups far more frequent than changes, keyed by integers such as fds and inode ids.
+ *
+ * Every stripe is a butil::DoublyBufferedData: a lookup only locks a mutex owned by its own thread and
+ * never waits for a writer, so lookups scale with cores. A change is applied to the background copy,
+ * the copies are flipped, and the change is applied again once the readers of the old copy are gone.
+ * Changes of different stripes do not block each other.
+ *
+ * Functions passed to Modify run twice, once per copy, and must return the same value both times.
+ */
+template <typename Key, typename Value, int StripeNum = 16>
+class StripedMap {
+  public:
+    using Map = std::unordered_map<Key, Value>;
+
+    bool Find(const Key &key, Value &value)
+    {
+        typename butil::DoublyBufferedData<Map>::ScopedPtr map;
+        if (StripeOf(key).Read(&map) != 0) {
+            return false;
+        }
+        auto it = map->find(key);
+        if (it == map->end()) {
+            return false;
+        }
+        value = it->second;
+        return true;
+    }
+
+    /* false if the key exists */
+    bool Insert(const Key &key, const Value &value)
+    {
+        auto fn = [&key, &value](Map &map) -> size_t { return map.try_emplace(key, value).second; };
+        return StripeOf(key).Modify(fn) != 0;
+    }
+
+    /* the erased value is moved to erased, so it is destroyed outside the stripe lock */
+    bool Erase(const Key &key, Value *erased = nullptr)
+    {
+        auto fn = [&key, erased](Map &map) -> size_t {
+            auto it = map.find(key);
+            if (it == map.end()) {
+                return 0;
+            }
+            if (erased != nullptr) {
+                *erased = std::move(it->second);
+            }
+            map.erase(it);
+            return 1;
+        };
+        return StripeOf(key).Modify(fn) != 0;
+    }
+
+    /* fn(Map &) for changes of the stripe of key beyond insert and erase */
+    template <typename Fn>
+    size_t Modify(const Key &key, Fn &&fn)
+    {
+        return StripeOf(key).Modify(fn);
+    }
+
+    /* fn(const Value &) on the value of key under the read lock, false if absent */
+    template <typename Fn>
+    bool Read(const Key &key, Fn &&fn)
+    {
+        typename butil::DoublyBufferedData<Map>::ScopedPtr map;
+        if (StripeOf(key).Read(&map) != 0) {
+            return false;
+        }
+        auto it = map->find(key);
+        if (it == map->end()) {
+            return false;
+        }
+        fn(it->second);
+        return true;
+    }
+
+    size_t Size()
+    {
+        size_t size = 0;
+        for (auto &stripe : stripes) {
+            typename butil::DoublyBufferedData<Map>::ScopedPtr map;
+            if (stripe.Read(&map) == 0) {
+                size += map->size();
+            }
+        }
+        return size;
+    }
+
+  private:
+    butil::DoublyBufferedData<Map> &StripeOf(const Key &key)
+    {
+        /* fds are sequential, spread neighbours over the stripes */
+        uint64_t hash = static_cast<uint64_t>(key) * 0x9E3779B97F4A7C15ULL;
+        return stripes[(hash >> 32) % StripeNum];
+    }
+
+    butil::DoublyBufferedData<Map> stripes[StripeNum];
+};
@@ -71,4 +71,72 @@ class CuckooPropertyKey : public PropertyKey {
 
     inline static const auto CUCKOO_LOG_RESERVED_TIME =
         PropertyKey::Builder("main", "cuckoo_log_reserved_time", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_READ_MOSTLY =
+        PropertyKey::Builder("main", "cuckoo_read_mostly", CUCKOO, CUCKOO_BOOL).build();
+
+    inline static const auto CUCKOO_ATTR_TIMEOUT =
+        PropertyKey::Builder("main", "cuckoo_attr_timeout", CUCKOO, CUCKOO_DOUBLE).build();
+
+    inline static const auto CUCKOO_ENTRY_TIMEOUT =
+        PropertyKey::Builder("main", "cuckoo_entry_timeout", CUCKOO, CUCKOO_DOUBLE).build();
+
+    inline static const auto CUCKOO_NEGATIVE_TIMEOUT =
+        PropertyKey::Builder("main", "cuckoo_negative_timeout", CUCKOO, CUCKOO_DOUBLE).build();
+
+    inline static const auto CUCKOO_ASYNC_MAX_INFLIGHT =
+        PropertyKey::Builder("main", "cuckoo_async_max_inflight", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_ASYNC_IO_THREADS =
+        PropertyKey::Builder("main", "cuckoo_async_io_threads", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_LOG_ASYNC =
+        PropertyKey::Builder("main", "cuckoo_log_async", CUCKOO, CUCKOO_BOOL).build();
+
+    inline static const auto CUCKOO_LOG_RATE_LIMIT =
+        PropertyKey::Builder("main", "cuckoo_log_rate_limit", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_TRACE_SAMPLE_RATE =
+        PropertyKey::Builder("main", "cuckoo_trace_sample_rate", CUCKOO, CUCKOO_DOUBLE).build();
+
+    inline static const auto CUCKOO_STORAGE_TYPE =
+        PropertyKey::Builder("main", "cuckoo_storage_type", CUCKOO, CUCKOO_STRING).build();
+
+    inline static const auto CUCKOO_LOCAL_STORAGE_PATH =
+        PropertyKey::Builder("main", "cuckoo_local_storage_path", CUCKOO, CUCKOO_STRING).build();
+
+    inline static const auto CUCKOO_MEMPOOL_NUMA =
+        PropertyKey::Builder("main", "cuckoo_mempool_numa", CUCKOO, CUCKOO_BOOL).build();
+
+    inline static const auto CUCKOO_OPEN_FILE_MEMORY_MB =
+        PropertyKey::Builder("main", "cuckoo_open_file_memory_mb", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_WRITE_MERGE_MEMORY_MB =
+        PropertyKey::Builder("main", "cuckoo_write_merge_memory_mb", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_WRITE_INFLIGHT_NUM =
+        PropertyKey::Builder("main", "cuckoo_write_inflight_num", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_HOT_FILE_READ_RATE =
+        PropertyKey::Builder("main", "cuckoo_hot_file_read_rate", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_HOT_FILE_REPLICAS =
+        PropertyKey::Builder("main", "cuckoo_hot_file_replicas", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_REPLICATION_MODE =
+        PropertyKey::Builder("main", "cuckoo_replication_mode", CUCKOO, CUCKOO_STRING).build();
+
+    inline static const auto CUCKOO_ACCESS_TRACE =
+        PropertyKey::Builder("main", "cuckoo_access_trace", CUCKOO, CUCKOO_STRING).build();
+    inline static const auto CUCKOO_CHECKSUM =
+        PropertyKey::Builder("main", "cuckoo_checksum", CUCKOO, CUCKOO_BOOL).build();
+
+    inline static const auto CUCKOO_COMPRESSION =
+        PropertyKey::Builder("main", "cuckoo_compression", CUCKOO, CUCKOO_STRING).build();
+
+    inline static const auto CUCKOO_COMPRESSION_IDLE_SEC =
+        PropertyKey::Builder("main", "cuckoo_compression_idle_sec", CUCKOO, CUCKOO_UINT).build();
+
+    inline static const auto CUCKOO_STORAGE_COMPRESSION =
+        PropertyKey::Builder("main", "cuckoo_storage_compression", CUCKOO, CUCKOO_STRING).build();
 };
@@ -0,0 +1,293 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "cuckoo_definition.h"
+
+/*
+ * per callsite state of CUCKOO_LOG, a token bucket of limit tokens refilled at limit per second.
+ * the refill time in ms and the tokens left share one word, so a message takes one CAS.
+ */
+struct LogSite
+{
+    static constexpr uint32_t TOKEN_BITS = 20;
+    static constexpr uint64_t TOKEN_MASK = (1ULL << TOKEN_BITS) - 1;
+
+    std::atomic<uint64_t> bucket{0};
+    std::atomic<uint32_t> suppressed{0};
+
+    /* reported is set to the number of messages suppressed since the last admitted one */
+    bool Admit(uint32_t limit, uint32_t &reported);
+};
+
+struct LogRecord
+{
+    const char *fileName = nullptr;
+    int32_t lineNumber = 0;
+    CuckooLogLevel severity = LOG_INFO;
+    std::chrono::system_clock::time_point time;
+    std::string message;
+};
+
+/* reusable buffer of one message, streams through the put area and only grows on overflow */
+class LogStreamBuf : public std::streambuf {
+  public:
+    LogStreamBuf() { Grow(INIT_SIZE); }
+
+    std::string_view View() const { return {pbase(), static_cast<size_t>(pptr() - pbase())}; }
+    size_t Size() const { return pptr() - pbase(); }
+    void Clear() { setp(data.data(), data.data() + data.size()); }
+    /* space for size bytes at the end of the message */
+    char *Reserve(size_t size)
+    {
+        if (static_cast<size_t>(epptr() - pptr()) < size) [[unlikely]] {
+            Grow(std::max(data.size() * 2, Size() + size));
+        }
+        char *pos = pptr();
+        pbump(static_cast<int>(size));
+        return pos;
+    }
+    void Patch(size_t offset, const void *bytes, size_t size) { std::memcpy(pbase() + offset, bytes, size); }
+
+  protected:
+    int_type overflow(int_type ch) override
+    {
+        Grow(data.size() * 2);
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+        return traits_type::not_eof(ch);
+    }
+
+  private:
+    static constexpr size_t INIT_SIZE = 256;
+
+    void Grow(size_t size)
+    {
+        size_t used = pptr() - pbase();
+        data.resize(size);
+        setp(data.data(), data.data() + data.size());
+        pbump(static_cast<int>(used));
+    }
+
+    std::string data;
+};
+
+/*
+ * One message being built. Strings and numbers are stored as tagged raw values and only turned
+ * into text by Decode on the flusher thread, anything else is formatted by the stream in place.
+ */
+struct LogLine
+{
+    enum Tag : uint8_t { TEXT = 0, INT, UINT, DOUBLE };
+
+    LogStreamBuf buf;
+    std::ostream stream{&buf};
+
+    template <typename T>
+    void Append(const T &value)
+    {
+        if constexpr (std::is_same_v<T, char>) {
+            if (Plain()) {
+                PutText(std::string_view(&value, 1));
+                return;
+            }
+        } else if constexpr (std::is_pointer_v<std::decay_t<T>> &&
+                             std::is_same_v<std::remove_cv_t<std::remove_pointer_t<std::decay_t<T>>>, char>) {
+            const char *str = value;
+            if (str != nullptr && Plain()) {
+                PutText(str);
+                return;
+            }
+        } else if constexpr (std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>) {
+            if (Plain()) {
+                PutText(value);
+                return;
+            }
+        } else if constexpr (std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>) {
+            /* int8_t and uint8_t are printed as characters by the stream */
+            if (Plain()) {
+                PutText(std::string_view(reinterpret_cast<const char *>(&value), 1));
+                return;
+            }
+        } else if constexpr (std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, wchar_t> &&
+                             !std::is_same_v<T, char8_t> && !std::is_same_v<T, char16_t> &&
+                             !std::is_same_v<T, char32_t>) {
+            if (Plain()) {
+                PutValue(std::is_signed_v<T> ? INT : UINT, static_cast<uint64_t>(value));
+                return;
+            }
+        } else if constexpr (std::is_floating_point_v<T>) {
+            if (Plain()) {
+                PutValue(DOUBLE, static_cast<double>(value));
+                return;
+            }
+        }
+        size_t lengthOffset = BeginText();
+        stream << value;
+        EndText(lengthOffset);
+    }
+
+    /* turns the tagged values of a message into text */
+    static void Decode(std::string_view encoded, std::string &out);
+
+  private:
+    /* with default flags a raw value is printed later exactly as the stream would print it now */
+    bool Plain() const
+    {
+        return stream.flags() == (std::ios_base::dec | std::ios_base::skipws) && stream.width() == 0 &&
+               stream.precision() == 6;
+    }
+
+    void PutText(std::string_view text)
+    {
+        uint32_t length = text.size();
+        char *pos = buf.Reserve(1 + sizeof(length) + length);
+        pos[0] = TEXT;
+        std::memcpy(pos + 1, &length, sizeof(length));
+        std::memcpy(pos + 1 + sizeof(length), text.data(), length);
+    }
+
+    template <typename V>
+    void PutValue(uint8_t tag, V value)
+    {
+        char *pos = buf.Reserve(1 + sizeof(value));
+        pos[0] = tag;
+        std::memcpy(pos + 1, &value, sizeof(value));
+    }
+
+    size_t BeginText()
+    {
+        char *pos = buf.Reserve(1 + sizeof(uint32_t));
+        pos[0] = TEXT;
+        return buf.Size() - sizeof(uint32_t);
+    }
+
+    void EndText(size_t lengthOffset)
+    {
+        uint32_t length = buf.Size() - lengthOffset - sizeof(length);
+        buf.Patch(lengthOffset, &length, sizeof(length));
+    }
+};
+
+/*
+ * Single producer single consumer ring owned by one thread. Slots keep the capacity of their
+ * strings, so in steady state pushing a record does not allocate.
+ */
+class LogRing {
+  public:
+    static constexpr uint32_t CAPACITY = 1024;
+
+    /* copies the record into the ring, false if the ring is full */
+    bool Push(const char *fileName,
+              int32_t lineNumber,
+              CuckooLogLevel severity,
+              std::chrono::system_clock::time_point time,
+              std::string_view message);
+    /* hands every published record to func, returns the number of records */
+    template <typename Func>
+    size_t Drain(Func &&func)
+    {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        uint64_t t = tail.load(std::memory_order_acquire);
+        for (uint64_t i = h; i < t; ++i) {
+            LogRecord &record = slots[i % CAPACITY];
+            func(record);
+            record.message.clear();
+        }
+        head.store(t, std::memory_order_release);
+        return t - h;
+    }
+    bool Empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+
+    std::atomic<bool> closed{false};
+
+  private:
+    std::array<LogRecord, CAPACITY> slots;
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+};
+
+/*
+ * Moves log formatting and output off the calling thread. CUCKOO_LOG streams the message into a
+ * thread local buffer and pushes it to the ring of the thread, the flusher thread adds the
+ * prefix and writes the records to the configured logger.
+ */
+class AsyncLogger {
+  public:
+    static AsyncLogger &GetInstance()
+    {
+        /* never destroyed, threads may still log while static objects are torn down at exit */
+        static AsyncLogger *instance = new AsyncLogger();
+        return *instance;
+    }
+
+    void Start();
+    void Stop();
+    /* writes out everything pushed so far */
+    void Flush();
+
+    /* false before Start, after Stop and on a thread that is exiting */
+    bool Available();
+    LogLine *AcquireLine();
+    /* pushes the line as a record and recycles it */
+    void Submit(LogLine *line,
+                const char *fileName,
+                int32_t lineNumber,
+                CuckooLogLevel severity,
+                std::chrono::system_clock::time_point time);
+
+    uint64_t GetDroppedNum() { return droppedNum.load(std::memory_order_relaxed); }
+
+  private:
+    struct ThreadState
+    {
+        std::shared_ptr<LogRing> ring;
+        std::vector<std::unique_ptr<LogLine>> freeLines;
+    };
+
+    struct ThreadStateHolder
+    {
+        ThreadState *state = nullptr;
+        ~ThreadStateHolder();
+    };
+
+    AsyncLogger() = default;
+    ThreadState *LocalState();
+    size_t DrainAll();
+    void FlushLoop(std::stop_token stoken);
+
+    std::atomic<bool> running{false};
+    std::mutex startMutex;
+    std::jthread flusher;
+
+    std::mutex ringsMutex;
+    std::vector<std::shared_ptr<LogRing>> rings;
+    /* the flusher and Flush callers take turns consuming the rings */
+    std::mutex drainMutex;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCv;
+
+    std::atomic<uint64_t> droppedNum{0};
+    uint64_t reportedDroppedNum = 0;
+};
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstring>
 #include <iostream>
 #include <ostream>
 #include <string>
@@ -15,11 +18,18 @@
 #include "glog/logging.h"
 
 #include "cuckoo_definition.h"
+#include "log/async_log.h"
 
 enum Logger { STD_LOGGER = 1, GLOGGER = 2, EXTERNAL_LOGGER = 3 };
 
 #define FILENAME_ (strrchr(__FILE__, '/') ? (strrchr(__FILE__, '/') + 1) : __FILE__)
-#define CUCKOO_LOG_INTERNAL(level) CuckooLog(FILENAME_, __LINE__, level)
+/* every expansion gets its own lambda, hence its own rate limit state */
+#define CUCKOO_LOG_SITE_                  \
+    ([]() -> LogSite & {                  \
+        static constinit LogSite logSite; \
+        return logSite;                   \
+    }())
+#define CUCKOO_LOG_INTERNAL(level) CuckooLog(FILENAME_, __LINE__, level, &CUCKOO_LOG_SITE_)
 #define CUCKOO_LOG_CM(file, line, level) CuckooLog(file, line, level)
 #define CUCKOO_LOG(level) CUCKOO_LOG_INTERNAL(CuckooLogLevel::level)
 
@@ -97,11 +107,43 @@ class ExternalLog {
     CuckooLogLevel severity_;
 };
 
-using LogProvider = std::variant<StdLog, google::LogMessage, ExternalLog>;
+/* hands the message to AsyncLogger, which adds the prefix and writes it from the flusher thread */
+class AsyncLog {
+  public:
+    AsyncLog(const char *fileName, int32_t lineNumber, CuckooLogLevel severity)
+        : line_(AsyncLogger::GetInstance().AcquireLine()),
+          file_name_(fileName),
+          line_number_(lineNumber),
+          severity_(severity),
+          time_(std::chrono::system_clock::now())
+    {
+    }
+
+    ~AsyncLog() { AsyncLogger::GetInstance().Submit(line_, file_name_, line_number_, severity_, time_); }
+
+    template <typename T>
+    void Append(const T &t)
+    {
+        line_->Append(t);
+    }
+
+    /* unframed, CuckooLog appends through Append */
+    std::ostream &Stream() { return line_->stream; }
+
+  private:
+    LogLine *line_;
+    const char *file_name_;
+    int32_t line_number_;
+    CuckooLogLevel severity_;
+    std::chrono::system_clock::time_point time_;
+};
+
+using LogProvider = std::variant<StdLog, google::LogMessage, ExternalLog, AsyncLog>;
 class CuckooLog {
   public:
     CuckooLog() = default;
-    CuckooLog(const char *file_name, int32_t line_number, CuckooLogLevel severity);
+    CuckooLog(const char *file_name, int32_t line_number, CuckooLogLevel severity, LogSite *site = nullptr);
+    ~CuckooLog();
 
     bool IsEnabled() const;
 
@@ -109,7 +151,11 @@ class CuckooLog {
     CuckooLog &operator<<(const T &t)
     {
         if (IsEnabled()) {
-            Stream() << t;
+            if (AsyncLog *async = std::get_if<AsyncLog>(&logProvider)) {
+                async->Append(t);
+            } else {
+                Stream() << t;
+            }
         }
         return *this;
     }
@@ -127,9 +173,23 @@ class CuckooLog {
     static void SetCuckooLogLevel(CuckooLogLevel level);
 
     static std::string GetLogPrefix(const char *fileName, int lineNumber, CuckooLogLevel severity);
+    static std::string GetLogPrefix(const char *fileName,
+                                    int lineNumber,
+                                    CuckooLogLevel severity,
+                                    std::chrono::system_clock::time_point now);
 
     static void SetExternalLogger(const CuckooLogHandler &logger);
 
+    /* format and write messages on a background thread instead of the calling one */
+    static void SetAsync(bool enable);
+
+    /* messages per second admitted from each CUCKOO_LOG callsite below LOG_ERROR, in bursts up to limit, 0 for no limit */
+    static void SetRateLimit(uint32_t limit);
+
+    /* used by AsyncLogger, std logger output is collected in batch and written by WriteBatch */
+    static void WriteRecord(const LogRecord &record, std::string &batch);
+    static void WriteBatch(std::string &batch);
+
     static CuckooLog *GetInstance();
 
   protected:
@@ -153,6 +213,8 @@ class CuckooLog {
     };
     inline static CuckooLogLevel severityThreshold{LOG_INFO};
     inline static Logger defaultLogger{STD_LOGGER};
+    inline static std::atomic<bool> asyncEnabled{false};
+    inline static std::atomic<uint32_t> rateLimit{0};
     inline static std::unordered_map<int, int> glogSeverityMap;
     inline static std::unordered_map<int, std::string> severityPrefixMap{{LOG_TRACE, "[TRACE]"},
                                                                          {LOG_DEBUG, "[DEBUG]"},
@@ -162,6 +224,7 @@ class CuckooLog {
                                                                          {LOG_FATAL, "[FATAL]"}};
     LogProvider logProvider;
     bool isEnabled;
+    uint32_t suppressedNum{0};
     std::string logDir;
     uint32_t reservedNum;
     uint32_t reservedTime; // unit : h
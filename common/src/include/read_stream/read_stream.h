@@ -55,4 +55,6 @@ class ReadStream {
     std::mutex pipeMutex;
     std::atomic<bool> stop = true;
     std::vector<std::thread> threads;
+    // pipe buffers accounted in OpenInstance::streamBytes
+    size_t chargedBytes = 0;
 };
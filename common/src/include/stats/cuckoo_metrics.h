@@ -0,0 +1,59 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+ * Registry of process metrics rendered in Prometheus text format.
+ * Modules register getters for their gauges and counters, CuckooStats counters and latency
+ * histograms are always exported.
+ */
+class CuckooMetrics {
+  public:
+    using Getter = std::function<double()>;
+
+    static CuckooMetrics &GetInstance()
+    {
+        static CuckooMetrics instance;
+        return instance;
+    }
+
+    /*
+     * labels are in Prometheus form without braces, e.g. priority="background".
+     * registering a sample again replaces its getter, so a module started twice exports it once.
+     */
+    void RegisterGauge(const std::string &name, const std::string &help, Getter getter, const std::string &labels = "");
+    void
+    RegisterCounter(const std::string &name, const std::string &help, Getter getter, const std::string &labels = "");
+    /* drop all samples of the metric, must be called before objects captured by its getters go away */
+    void Unregister(const std::string &name);
+
+    std::string Render();
+
+  private:
+    struct Family
+    {
+        std::string help;
+        std::string type;
+        std::vector<std::pair<std::string, Getter>> samples;
+    };
+
+    void Register(const std::string &name,
+                  const std::string &help,
+                  const std::string &type,
+                  Getter getter,
+                  const std::string &labels);
+    static void RenderStats(std::string &out);
+    static void RenderHistograms(std::string &out);
+
+    std::mutex mutex;
+    std::map<std::string, Family> families;
+};
@@ -10,6 +10,8 @@
 #include <cmath>
 #include <stop_token>
 
+#include "stats/latency_histogram.h"
+
 enum {
     FUSE_OPS = 0,
     FUSE_LAT,
@@ -39,6 +41,7 @@ enum {
     META_TRUNCATE,
     META_FLUSH,
     META_FSYNC,
+    META_LOCK,
     BLOCKCACHE_READ,
     BLOCKCACHE_WRITE,
     OBJ_GET,
@@ -72,8 +75,27 @@ class StatFuseTimer {
     ~StatFuseTimer()
     {
         auto end_time = std::chrono::steady_clock::now();
-        CuckooStats::GetInstance().stats[item] +=
-            std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+        uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(end_time - start_time).count();
+        CuckooStats::GetInstance().stats[item] += elapsed / 1000;
+        int hist = HistOf(item);
+        if (hist != HIST_END) {
+            LatencyHistograms::GetInstance().Record(hist, elapsed);
+        }
+    }
+    static constexpr int HistOf(int item)
+    {
+        switch (item) {
+        case FUSE_LAT:
+            return HIST_FUSE;
+        case FUSE_READ_LAT:
+            return HIST_FUSE_READ;
+        case FUSE_WRITE_LAT:
+            return HIST_FUSE_WRITE;
+        case META_LAT:
+            return HIST_META_RPC;
+        default:
+            return HIST_END;
+        }
     }
     std::chrono::steady_clock::time_point start_time;
     int item;
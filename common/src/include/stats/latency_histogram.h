@@ -0,0 +1,157 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+enum {
+    HIST_FUSE = 0,
+    HIST_FUSE_READ,
+    HIST_FUSE_WRITE,
+    HIST_META_RPC,
+    HIST_BLOCKCACHE_READ,
+    HIST_OBJ_GET,
+    HIST_OBJ_PUT,
+    HIST_END
+};
+
+struct LatencyPercentiles
+{
+    uint64_t count = 0;
+    /* in nanoseconds, upper bound of the bucket the percentile falls in */
+    uint64_t p50 = 0;
+    uint64_t p90 = 0;
+    uint64_t p99 = 0;
+    uint64_t p999 = 0;
+    uint64_t max = 0;
+};
+
+/*
+ * Log bucketed latency histograms in the spirit of HdrHistogram: every power of two is split into
+ * SUB_BUCKET_NUM linear buckets, so a value is kept with about 6% relative error.
+ * Each thread records into its own block with plain relaxed load/store, reports merge all blocks
+ * and diff against the previous snapshot to get the interval.
+ */
+class LatencyHistograms {
+  public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 4;
+    static constexpr uint32_t SUB_BUCKET_NUM = 1U << SUB_BUCKET_BITS;
+    /* values from 2^MAX_BIT ns (about 68s) on go to the last bucket */
+    static constexpr uint32_t MAX_BIT = 36;
+    static constexpr uint32_t BUCKET_NUM = (MAX_BIT - SUB_BUCKET_BITS + 1) * SUB_BUCKET_NUM;
+
+    using Snapshot = std::array<uint64_t, BUCKET_NUM>;
+
+    static LatencyHistograms &GetInstance()
+    {
+        /* never destroyed, threads may still record while static objects are torn down at exit */
+        static LatencyHistograms *instance = new LatencyHistograms();
+        return *instance;
+    }
+
+    static uint32_t BucketIndex(uint64_t value)
+    {
+        if (value < SUB_BUCKET_NUM) {
+            return static_cast<uint32_t>(value);
+        }
+        uint32_t msb = 63 - std::countl_zero(value);
+        if (msb >= MAX_BIT) {
+            return BUCKET_NUM - 1;
+        }
+        uint32_t shift = msb - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKET_NUM + static_cast<uint32_t>((value >> shift) - SUB_BUCKET_NUM);
+    }
+
+    /* largest value mapped to the bucket */
+    static uint64_t BucketUpperBound(uint32_t index)
+    {
+        if (index < SUB_BUCKET_NUM) {
+            return index;
+        }
+        uint32_t shift = index / SUB_BUCKET_NUM - 1;
+        uint64_t lower = static_cast<uint64_t>(SUB_BUCKET_NUM + index % SUB_BUCKET_NUM) << shift;
+        return lower + (1ULL << shift) - 1;
+    }
+
+    void Record(int hist, uint64_t nanoseconds)
+    {
+        Block &block = LocalBlock();
+        std::atomic<uint64_t> &counter = block.buckets[hist][BucketIndex(nanoseconds)];
+        /* only the owner thread writes its block, no need for a locked add */
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        block.sums[hist].store(block.sums[hist].load(std::memory_order_relaxed) + nanoseconds,
+                               std::memory_order_relaxed);
+    }
+
+    /* cumulative counts of a histogram over all threads */
+    void Collect(int hist, Snapshot &snapshot);
+
+    /* cumulative sum of recorded values in nanoseconds */
+    uint64_t CollectSum(int hist);
+
+    /* percentiles of the counts recorded since last, last is updated to current */
+    static LatencyPercentiles Percentiles(const Snapshot &current, Snapshot &last);
+
+  private:
+    struct Block
+    {
+        std::array<std::array<std::atomic<uint64_t>, BUCKET_NUM>, HIST_END> buckets{};
+        std::array<std::atomic<uint64_t>, HIST_END> sums{};
+        std::atomic<bool> inUse{false};
+    };
+
+    /* hands the block back on thread exit, counts stay in it for the next thread */
+    struct BlockHolder
+    {
+        Block *block = nullptr;
+        ~BlockHolder()
+        {
+            if (block) {
+                block->inUse.store(false, std::memory_order_release);
+            }
+        }
+    };
+
+    Block &LocalBlock()
+    {
+        thread_local BlockHolder holder;
+        if (holder.block == nullptr) [[unlikely]] {
+            holder.block = AcquireBlock();
+        }
+        return *holder.block;
+    }
+
+    Block *AcquireBlock();
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Block>> blocks;
+};
+
+/* records the lifetime of the object into a histogram */
+class StatLatencyTimer {
+  public:
+    StatLatencyTimer(int hist)
+        : hist(hist),
+          startTime(std::chrono::steady_clock::now())
+    {
+    }
+    ~StatLatencyTimer()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - startTime;
+        LatencyHistograms::GetInstance().Record(
+            hist, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+  private:
+    int hist;
+    std::chrono::steady_clock::time_point startTime;
+};
@@ -4,20 +4,34 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <condition_variable>
+#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <optional>
 #include <semaphore>
+#include <string>
 #include <thread>
 #include <vector>
 
+/* foreground tasks are taken before background ones, e.g. prefetch before local cache fill */
+enum class TaskPriority : uint32_t { FOREGROUND = 0, BACKGROUND, PRIORITY_NUM };
+
 struct ThreadTask
 {
     std::string taskName;
     std::function<void()> task;
+    TaskPriority priority = TaskPriority::FOREGROUND;
 };
 
+/*
+ * Every worker owns a queue per priority. Submit from a worker pushes to its own queue, other threads
+ * spread tasks round robin. An idle worker takes from its own queue first and steals from the others
+ * before sleeping, so submit and dequeue only contend on the queue they touch.
+ */
 class ThreadPool {
   public:
     ThreadPool(uint32_t threadNum, uint64_t maxTaskNum, std::string name);
@@ -33,15 +47,39 @@ class ThreadPool {
 
     int Submit(const ThreadTask &func);
 
+    /* number of queued tasks of the priority, not counting running ones */
+    uint64_t GetQueueDepth(TaskPriority priority) const;
+
+    uint64_t GetStealCount() const { return stealCount.load(std::memory_order_relaxed); }
+
   private:
-    void WorkLoop(const std::string &threadName);
+    static constexpr size_t PRIORITY_NUM = static_cast<size_t>(TaskPriority::PRIORITY_NUM);
+    /* after this many foreground tasks in a row a worker looks at background queues first */
+    static constexpr uint32_t BACKGROUND_INTERVAL = 8;
+
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::array<std::deque<ThreadTask>, PRIORITY_NUM> tasks;
+    };
+
+    void WorkLoop(uint32_t index);
+    std::optional<ThreadTask> TakeTask(uint32_t index, bool backgroundFirst);
+    std::optional<ThreadTask> PopLocal(uint32_t index, size_t priority);
+    std::optional<ThreadTask> Steal(uint32_t index, size_t priority);
 
     uint32_t threadNum{};
     uint64_t maxTaskNum{};
     std::string name;
-    std::mutex mutex;
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::atomic<uint32_t> nextQueue{0};
+    std::array<std::atomic<uint64_t>, PRIORITY_NUM> queueDepth{};
+    std::atomic<uint64_t> pendingTasks{0};
+    std::atomic<uint64_t> stealCount{0};
+    /* only used to park idle workers */
+    std::mutex sleepMutex;
     std::condition_variable_any cv;
-    std::queue<ThreadTask> tasks;
+    std::atomic<uint32_t> idleWorkers{0};
     std::vector<std::jthread> threads;
     std::stop_source stopSource;
     std::counting_semaphore<> taskSem;
@@ -7,7 +7,12 @@
 #include <securec.h>
 #include <unistd.h>
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <shared_mutex>
 #include <vector>
@@ -18,6 +23,12 @@
 #include "log/logging.h"
 
 #define CUCKOO_STORE_STREAM_MAX_SIZE (256 * 1024)
+/* out of order data a stream may hold for merging */
+#define WRITE_STREAM_MERGE_MAX_SIZE (4 * 1024 * 1024)
+/* out of order data all streams may hold for merging */
+#define DEFAULT_WRITE_MERGE_MEMORY (256ULL * 1024 * 1024)
+/* remote WriteFile rpcs a stream may have in flight */
+#define DEFAULT_WRITE_INFLIGHT_NUM 8
 
 class ExpandableMemory {
   public:
@@ -43,18 +54,18 @@ class ExpandableMemory {
         size += appendSize;
         return true;
     }
-    bool Replace(size_t offset, size_t size, const ExpandableMemory &fromReplace)
+    bool Replace(size_t offset, size_t replaceSize, const ExpandableMemory &fromReplace)
     {
-        if (!Reserve(size + offset)) {
+        if (!Reserve(replaceSize + offset)) {
             return false;
         }
 
-        errno_t err = memcpy_s(ptr.get() + offset, capacity - offset, fromReplace.Get().get(), size);
+        errno_t err = memcpy_s(ptr.get() + offset, capacity - offset, fromReplace.Get().get(), replaceSize);
         if (err != 0) {
             CUCKOO_LOG(LOG_ERROR) << "Secure func failed: " << err;
             return false;
         }
-        size = std::max(size, offset + size);
+        size = std::max(size, offset + replaceSize);
         return true;
     }
     bool Reserve(size_t reservedSize)
@@ -123,13 +134,13 @@ class FixMemory {
     ~FixMemory()
     {
         if (mem) {
-            writeMemPool.free(mem);
+            FreeBuffer(mem);
         }
     }
     bool Append(const char *buf, size_t appendSize)
     {
         if (mem == nullptr) {
-            mem = (char *)writeMemPool.alloc();
+            mem = AllocBuffer();
             if (mem == nullptr) {
                 CUCKOO_LOG(LOG_ERROR) << "FixMemory get allocated nullptr";
                 return false;
@@ -149,6 +160,18 @@ class FixMemory {
     }
     char *c_str() { return mem; }
     void Clear() { size = 0; }
+    void Release()
+    {
+        if (mem) {
+            FreeBuffer(mem);
+            mem = nullptr;
+        }
+        size = 0;
+    }
+    /* buffers of the pool are charged to the memory of open instances while they are held */
+    static char *AllocBuffer();
+    static void FreeBuffer(char *buffer);
+
     char *mem = nullptr;
     size_t size = 0;
     size_t capacity = CUCKOO_STORE_STREAM_MAX_SIZE;
@@ -189,7 +212,9 @@ class WriteStream {
             }
 
             ExpandableMemory tmpBuf;
-            tmpBuf.Reserve(size);
+            if (!tmpBuf.Reserve(size)) {
+                return nullptr;
+            }
 
             for (auto &slice : slices) {
                 tmpBuf.Replace(slice.offset - offset, slice.size, slice.buf);
@@ -258,7 +283,11 @@ class WriteStream {
     };
 
     WriteStream() = default;
-    ~WriteStream() = default;
+    ~WriteStream()
+    {
+        WaitInflight();
+        mergedMemory.fetch_sub(streamMemory);
+    }
 
     int Push(CuckooWriteBuffer buf, off_t offset, uint64_t currentSize);
     int PersistToFile(const char *buf, size_t size, off_t offset, uint64_t currentSize);
@@ -270,16 +299,68 @@ class WriteStream {
     void SetInodeId(uint64_t newInodeId) { inodeId = newInodeId; }
     void SetDirect(bool isDirect) { direct = isDirect; }
     void SetClient(std::shared_ptr<CuckooIOClient> cuckooIOClient);
+    /* move a read only open with nothing buffered to another fd, and client, nullptr for a local fd */
+    void Rebind(uint64_t newPhysicalFd, std::shared_ptr<CuckooIOClient> cuckooIOClient);
     uint64_t GetSize();
+    /* data buffered or still on its way to the remote file */
+    bool Pending();
+    /* drops the buffered data, the fd and the client, as newly constructed */
+    void Reset();
+
+    static void SetMergeMemoryLimit(uint64_t limit) { mergeMemoryLimit = limit; }
+    static uint64_t GetMergeMemoryLimit() { return mergeMemoryLimit.load(); }
+    static int64_t GetMergedMemory() { return mergedMemory.load(); }
+    static void SetInflightLimit(uint32_t limit) { inflightLimit = std::max(limit, 1U); }
 
   private:
     int64_t Merge(MergedSlice &&slice); // can return negative
+    int PushOutOfOrder(const char *buf, size_t size, off_t offset, uint64_t currentSize);
+    bool StreamOverlaps(off_t offset, size_t size);
+    /* persist the merged slices overlapping [offset, offset + size) */
+    int PersistStream(uint64_t currentSize, off_t offset = 0, size_t size = SIZE_MAX);
+    int PersistMergedSlice(std::set<MergedSlice>::iterator it, uint64_t currentSize);
+    /* send the buffer to the remote file without waiting for the reply, the buffer is released once answered */
+    int PersistToRemote(std::shared_ptr<char> buf, size_t size, off_t offset);
+    int PersistCopyToRemote(const char *buf, size_t size, off_t offset);
+    /* wait for all writes in flight, return the first error of them */
+    int WaitInflight();
+    /* the first error of the writes answered so far, kept until Reset */
+    int CheckInflight();
+    void ReapInflight();
+    bool InflightOverlaps(off_t offset, size_t size);
+
+    struct InflightWrite
+    {
+        off_t offset;
+        size_t size;
+        std::shared_ptr<char> buf;
+        bool done = false;
+        int ret = 0;
+    };
 
+    /*
+     * Remote writes not following data are merged with their neighbours here, slices reaching
+     * CUCKOO_STORE_STREAM_MAX_SIZE are persisted as one extent. Slices never overlap data.
+     */
     std::set<MergedSlice> stream; // (offset, size, content)
+    size_t streamMemory = 0;
     uint64_t physicalFd = UINT64_MAX;
     std::shared_ptr<CuckooIOClient> client = nullptr;
     std::shared_mutex mutex;
     SerialData data;
     uint64_t inodeId = 0;
     bool direct = false;
+
+    /*
+     * Remote writes in flight in the order sent, retired in that order once answered. A write never
+     * goes out while an earlier one it overlaps is in flight, so the remote file sees them in order.
+     */
+    std::mutex inflightMutex;
+    std::condition_variable inflightCv;
+    std::deque<std::shared_ptr<InflightWrite>> inflight;
+    int inflightError = 0;
+
+    static std::atomic<int64_t> mergedMemory;
+    static std::atomic<uint64_t> mergeMemoryLimit;
+    static std::atomic<uint32_t> inflightLimit;
 };
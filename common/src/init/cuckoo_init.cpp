@@ -73,6 +73,8 @@ int32_t CuckooModuleInit::InitLog()
         CUCKOO_LOG(LOG_ERROR) << "Cuckoo init failed caused by init log failed, error code: " << ret;
         return ret;
     }
+    CuckooLog::SetRateLimit(cuckooConfig->GetUint32(CuckooPropertyKey::CUCKOO_LOG_RATE_LIMIT));
+    CuckooLog::SetAsync(cuckooConfig->GetBool(CuckooPropertyKey::CUCKOO_LOG_ASYNC));
 
     CUCKOO_LOG(LOG_INFO) << "Init Cuckoo Log successfully";
     return OK;
@@ -0,0 +1,264 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "log/async_log.h"
+
+#include <time.h>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+
+#include "log/logging.h"
+
+/* set once the thread local state of the thread is destroyed, trivial so it outlives it */
+static thread_local bool t_stateGone = false;
+
+bool LogSite::Admit(uint32_t limit, uint32_t &reported)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+    /* 0 is left for a bucket never used */
+    uint64_t now = static_cast<uint64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000 + 1;
+    uint64_t capacity = std::min<uint64_t>(limit, TOKEN_MASK);
+    uint64_t current = bucket.load(std::memory_order_relaxed);
+    while (true) {
+        uint64_t refillTime = current >> TOKEN_BITS;
+        uint64_t tokens = current & TOKEN_MASK;
+        if (refillTime == 0) {
+            refillTime = now;
+            tokens = capacity;
+        } else if (now > refillTime) {
+            uint64_t refill = (now - refillTime) * capacity / 1000;
+            if (tokens + refill >= capacity) {
+                tokens = capacity;
+                refillTime = now;
+            } else if (refill > 0) {
+                /* keep the fraction of a token not refilled yet */
+                tokens += refill;
+                refillTime += refill * 1000 / capacity;
+            }
+        }
+        if (tokens == 0) {
+            suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        uint64_t next = (refillTime << TOKEN_BITS) | (tokens - 1);
+        if (bucket.compare_exchange_weak(current, next, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    if (suppressed.load(std::memory_order_relaxed) != 0) {
+        reported = suppressed.exchange(0, std::memory_order_relaxed);
+    }
+    return true;
+}
+
+void LogLine::Decode(std::string_view encoded, std::string &out)
+{
+    size_t pos = 0;
+    char number[32];
+    while (pos < encoded.size()) {
+        uint8_t tag = encoded[pos++];
+        if (tag == TEXT) {
+            uint32_t length = 0;
+            std::memcpy(&length, encoded.data() + pos, sizeof(length));
+            pos += sizeof(length);
+            out.append(encoded.data() + pos, length);
+            pos += length;
+            continue;
+        }
+        uint64_t raw = 0;
+        std::memcpy(&raw, encoded.data() + pos, sizeof(raw));
+        pos += sizeof(raw);
+        switch (tag) {
+        case INT:
+            out.append(number, std::to_chars(number, number + sizeof(number), static_cast<int64_t>(raw)).ptr);
+            break;
+        case UINT:
+            out.append(number, std::to_chars(number, number + sizeof(number), raw).ptr);
+            break;
+        case DOUBLE: {
+            double value = 0;
+            std::memcpy(&value, &raw, sizeof(value));
+            /* same as an ostream with default precision */
+            int length = std::snprintf(number, sizeof(number), "%g", value);
+            out.append(number, length);
+            break;
+        }
+        default:
+            return;
+        }
+    }
+}
+
+bool LogRing::Push(const char *fileName,
+                   int32_t lineNumber,
+                   CuckooLogLevel severity,
+                   std::chrono::system_clock::time_point time,
+                   std::string_view message)
+{
+    uint64_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) >= CAPACITY) {
+        return false;
+    }
+    LogRecord &slot = slots[t % CAPACITY];
+    slot.fileName = fileName;
+    slot.lineNumber = lineNumber;
+    slot.severity = severity;
+    slot.time = time;
+    slot.message.assign(message);
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+AsyncLogger::ThreadStateHolder::~ThreadStateHolder()
+{
+    t_stateGone = true;
+    if (state != nullptr) {
+        /* the flusher drops the ring once it is drained */
+        state->ring->closed.store(true, std::memory_order_release);
+        delete state;
+    }
+}
+
+AsyncLogger::ThreadState *AsyncLogger::LocalState()
+{
+    thread_local ThreadStateHolder holder;
+    if (holder.state == nullptr) [[unlikely]] {
+        auto *state = new ThreadState();
+        state->ring = std::make_shared<LogRing>();
+        {
+            std::lock_guard<std::mutex> lock(ringsMutex);
+            rings.push_back(state->ring);
+        }
+        holder.state = state;
+    }
+    return holder.state;
+}
+
+void AsyncLogger::Start()
+{
+    std::lock_guard<std::mutex> lock(startMutex);
+    if (running.load()) {
+        return;
+    }
+    static std::once_flag atExitOnce;
+    std::call_once(atExitOnce, []() { std::atexit([]() { AsyncLogger::GetInstance().Stop(); }); });
+    flusher = std::jthread([this](std::stop_token stoken) { FlushLoop(stoken); });
+    running.store(true);
+}
+
+void AsyncLogger::Stop()
+{
+    std::lock_guard<std::mutex> lock(startMutex);
+    if (!running.exchange(false)) {
+        return;
+    }
+    flusher.request_stop();
+    {
+        std::lock_guard<std::mutex> wakeLock(wakeMutex);
+    }
+    wakeCv.notify_all();
+    flusher.join();
+    /* records pushed by threads that saw running just before it was cleared */
+    Flush();
+}
+
+void AsyncLogger::Flush()
+{
+    std::lock_guard<std::mutex> lock(drainMutex);
+    DrainAll();
+}
+
+bool AsyncLogger::Available() { return running.load(std::memory_order_relaxed) && !t_stateGone; }
+
+LogLine *AsyncLogger::AcquireLine()
+{
+    ThreadState *state = LocalState();
+    /* a message may log while it is being formatted, so keep a free list instead of a single line */
+    if (state->freeLines.empty()) {
+        return new LogLine();
+    }
+    LogLine *line = state->freeLines.back().release();
+    state->freeLines.pop_back();
+    return line;
+}
+
+void AsyncLogger::Submit(LogLine *line,
+                         const char *fileName,
+                         int32_t lineNumber,
+                         CuckooLogLevel severity,
+                         std::chrono::system_clock::time_point time)
+{
+    ThreadState *state = LocalState();
+    if (!state->ring->Push(fileName, lineNumber, severity, time, line->buf.View())) {
+        if (severity >= LOG_ERROR) {
+            /* errors are never dropped, write them from the caller when the ring is full */
+            LogRecord record{fileName, lineNumber, severity, time, {}};
+            LogLine::Decode(line->buf.View(), record.message);
+            std::string batch;
+            CuckooLog::WriteRecord(record, batch);
+            CuckooLog::WriteBatch(batch);
+        } else {
+            droppedNum.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    line->buf.Clear();
+    line->stream.clear();
+    line->stream.flags(std::ios_base::dec | std::ios_base::skipws);
+    line->stream.width(0);
+    line->stream.precision(6);
+    line->stream.fill(' ');
+    state->freeLines.emplace_back(line);
+}
+
+size_t AsyncLogger::DrainAll()
+{
+    std::vector<std::shared_ptr<LogRing>> current;
+    {
+        std::lock_guard<std::mutex> lock(ringsMutex);
+        /* a closed ring gets no more records, drop it once everything in it is written */
+        std::erase_if(rings, [](const std::shared_ptr<LogRing> &ring) {
+            return ring->closed.load(std::memory_order_acquire) && ring->Empty();
+        });
+        current = rings;
+    }
+
+    std::string batch;
+    std::string text;
+    size_t drained = 0;
+    for (auto &ring : current) {
+        drained += ring->Drain([&batch, &text](LogRecord &record) {
+            text.clear();
+            LogLine::Decode(record.message, text);
+            record.message.swap(text);
+            CuckooLog::WriteRecord(record, batch);
+        });
+    }
+    uint64_t dropped = droppedNum.load(std::memory_order_relaxed);
+    if (dropped != reportedDroppedNum) {
+        LogRecord record{FILENAME_, __LINE__, LOG_WARNING, std::chrono::system_clock::now(), {}};
+        record.message = std::to_string(dropped - reportedDroppedNum) + " log messages dropped, log ring full";
+        CuckooLog::WriteRecord(record, batch);
+        reportedDroppedNum = dropped;
+    }
+    CuckooLog::WriteBatch(batch);
+    return drained;
+}
+
+void AsyncLogger::FlushLoop(std::stop_token stoken)
+{
+    constexpr auto idleWait = std::chrono::milliseconds(1);
+    while (!stoken.stop_requested()) {
+        size_t drained = 0;
+        {
+            std::lock_guard<std::mutex> lock(drainMutex);
+            drained = DrainAll();
+        }
+        if (drained == 0) {
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            wakeCv.wait_for(lock, idleWait, [&stoken] { return stoken.stop_requested(); });
+        }
+    }
+}
@@ -31,15 +31,29 @@ std::ostream &CuckooLog::Stream()
 {
     overload logStream{[](StdLog &logger) -> std::ostream & { return logger.Stream(); },
                        [](ExternalLog &logger) -> std::ostream & { return logger.Stream(); },
+                       [](AsyncLog &logger) -> std::ostream & { return logger.Stream(); },
                        [](google::LogMessage &logger) -> std::ostream & { return logger.stream(); }};
 
     return std::visit(logStream, logProvider);
 }
 
-CuckooLog::CuckooLog(const char *file_name, int32_t line_number, CuckooLogLevel severity)
+CuckooLog::CuckooLog(const char *file_name, int32_t line_number, CuckooLogLevel severity, LogSite *site)
     : isEnabled(severity >= severityThreshold)
 {
+    /* errors are never rate limited */
+    if (isEnabled && site != nullptr && severity < LOG_ERROR) {
+        uint32_t limit = rateLimit.load(std::memory_order_relaxed);
+        isEnabled = limit == 0 || site->Admit(limit, suppressedNum);
+    }
     if (isEnabled) {
+        if (asyncEnabled.load(std::memory_order_relaxed)) {
+            if (severity < LOG_FATAL && AsyncLogger::GetInstance().Available()) {
+                logProvider.emplace<AsyncLog>(file_name, line_number, severity);
+                return;
+            }
+            /* keep the order of messages before a fatal one, which may abort */
+            AsyncLogger::GetInstance().Flush();
+        }
         switch (defaultLogger) {
         case STD_LOGGER:
             logProvider.emplace<StdLog>() << GetLogPrefix(file_name, line_number, severity);
@@ -55,6 +69,13 @@ CuckooLog::CuckooLog(const char *file_name, int32_t line_number, CuckooLogLevel
     }
 }
 
+CuckooLog::~CuckooLog()
+{
+    if (suppressedNum > 0 && isEnabled) {
+        *this << " [" << suppressedNum << " similar messages suppressed]";
+    }
+}
+
 CuckooLog *CuckooLog::GetInstance()
 {
     static CuckooLog instance;
@@ -116,7 +137,14 @@ int32_t CuckooLog::InitLog(CuckooLogLevel initSeverityThreshold = LOG_INFO,
 
 std::string CuckooLog::GetLogPrefix(const char *fileName, int lineNumber, CuckooLogLevel severity)
 {
-    auto now = std::chrono::system_clock::now();
+    return GetLogPrefix(fileName, lineNumber, severity, std::chrono::system_clock::now());
+}
+
+std::string CuckooLog::GetLogPrefix(const char *fileName,
+                                    int lineNumber,
+                                    CuckooLogLevel severity,
+                                    std::chrono::system_clock::time_point now)
+{
     auto micros = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()) % 1000000;
 
     std::time_t tt = std::chrono::system_clock::to_time_t(now);
@@ -147,6 +175,49 @@ void CuckooLog::SetExternalLogger(const CuckooLogHandler &logger)
     ExternalLog::externalLogger_ = logger;
 }
 
+void CuckooLog::SetAsync(bool enable)
+{
+    if (enable) {
+        AsyncLogger::GetInstance().Start();
+        asyncEnabled = true;
+    } else {
+        asyncEnabled = false;
+        AsyncLogger::GetInstance().Stop();
+    }
+}
+
+void CuckooLog::SetRateLimit(uint32_t limit) { rateLimit = limit; }
+
+void CuckooLog::WriteRecord(const LogRecord &record, std::string &batch)
+{
+    switch (defaultLogger) {
+    case STD_LOGGER:
+        batch += GetLogPrefix(record.fileName, record.lineNumber, record.severity, record.time);
+        batch += record.message;
+        batch += '\n';
+        break;
+    case EXTERNAL_LOGGER:
+        ExternalLog::externalLogger_(record.severity,
+                                     record.fileName,
+                                     record.lineNumber,
+                                     ("[CUCKOO] " + record.message).c_str());
+        break;
+    case GLOGGER:
+        google::LogMessage(record.fileName, record.lineNumber, glogSeverityMap[record.severity]).stream()
+            << "[CUCKOO]" << severityPrefixMap[record.severity] << " " << record.message;
+        break;
+    }
+}
+
+void CuckooLog::WriteBatch(std::string &batch)
+{
+    if (!batch.empty()) {
+        std::cout.write(batch.data(), batch.size());
+        std::cout.flush();
+        batch.clear();
+    }
+}
+
 void CuckooLog::Cleaner(std::stop_token stoken)
 {
     while (!stoken.stop_requested()) {
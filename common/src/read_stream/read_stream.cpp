@@ -146,6 +146,8 @@ bool ReadStream::Init(OpenInstance *instance, int blocks, size_t pipeSize)
     for (int i = 0; i < pipeNum; i++) {
         pipes[i].Init(pipeCap, std::shared_ptr<char>((char *)mem[i], freeFunc));
     }
+    OpenInstance::streamBytes.fetch_add(static_cast<int64_t>(pipeNum * pipeCap) - static_cast<int64_t>(chargedBytes));
+    chargedBytes = pipeNum * pipeCap;
 
     return true;
 }
@@ -253,4 +255,5 @@ ReadStream::~ReadStream()
             th.join();
         }
     }
+    OpenInstance::streamBytes.fetch_sub(chargedBytes);
 }
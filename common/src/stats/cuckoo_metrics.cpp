@@ -0,0 +1,155 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "stats/cuckoo_metrics.h"
+
+#include <array>
+#include <format>
+
+#include "stats/cuckoo_stats.h"
+
+struct StatsCounter
+{
+    int item;
+    const char *name;
+    const char *help;
+    /* latency sums are kept in microseconds */
+    double scale;
+};
+
+static constexpr std::array<StatsCounter, 12> STATS_COUNTERS = {{
+    {FUSE_READ, "cuckoo_fuse_read_bytes_total", "Bytes read through fuse.", 1},
+    {FUSE_READ_OPS, "cuckoo_fuse_read_ops_total", "Read calls through fuse.", 1},
+    {FUSE_WRITE, "cuckoo_fuse_write_bytes_total", "Bytes written through fuse.", 1},
+    {FUSE_WRITE_OPS, "cuckoo_fuse_write_ops_total", "Write calls through fuse.", 1},
+    {META_OPS, "cuckoo_meta_rpc_total", "Metadata RPCs sent.", 1},
+    {META_LAT, "cuckoo_meta_rpc_seconds_total", "Time spent in metadata RPCs.", 1e-6},
+    {BLOCKCACHE_READ, "cuckoo_blockcache_read_bytes_total", "Bytes read from local block cache.", 1},
+    {BLOCKCACHE_WRITE, "cuckoo_blockcache_write_bytes_total", "Bytes written to local block cache.", 1},
+    {OBJ_GET, "cuckoo_obs_get_bytes_total", "Bytes fetched from object storage.", 1},
+    {OBJ_PUT, "cuckoo_obs_put_bytes_total", "Bytes uploaded to object storage.", 1},
+    {META_OPEN, "cuckoo_fuse_open_total", "Open calls through fuse.", 1},
+    {META_CREATE, "cuckoo_fuse_create_total", "Create calls through fuse.", 1},
+}};
+
+struct HistogramInfo
+{
+    const char *name;
+    const char *help;
+};
+
+static constexpr std::array<HistogramInfo, HIST_END> HISTOGRAMS = {{
+    {"cuckoo_fuse_latency_seconds", "Latency of fuse ops."},
+    {"cuckoo_fuse_read_latency_seconds", "Latency of fuse reads."},
+    {"cuckoo_fuse_write_latency_seconds", "Latency of fuse writes."},
+    {"cuckoo_meta_rpc_latency_seconds", "Latency of metadata RPCs."},
+    {"cuckoo_blockcache_read_latency_seconds", "Latency of local block cache reads."},
+    {"cuckoo_obs_get_latency_seconds", "Latency of object storage GET."},
+    {"cuckoo_obs_put_latency_seconds", "Latency of object storage PUT."},
+}};
+
+/* buckets are exported at powers of two from about 1us to 34s, they line up with histogram buckets */
+constexpr uint32_t EXPORT_MIN_BIT = 10;
+constexpr uint32_t EXPORT_MAX_BIT = 35;
+
+void CuckooMetrics::Register(const std::string &name,
+                             const std::string &help,
+                             const std::string &type,
+                             Getter getter,
+                             const std::string &labels)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    Family &family = families[name];
+    family.help = help;
+    family.type = type;
+    for (auto &[sampleLabels, sampleGetter] : family.samples) {
+        if (sampleLabels == labels) {
+            sampleGetter = std::move(getter);
+            return;
+        }
+    }
+    family.samples.emplace_back(labels, std::move(getter));
+}
+
+void CuckooMetrics::RegisterGauge(const std::string &name,
+                                  const std::string &help,
+                                  Getter getter,
+                                  const std::string &labels)
+{
+    Register(name, help, "gauge", std::move(getter), labels);
+}
+
+void CuckooMetrics::RegisterCounter(const std::string &name,
+                                    const std::string &help,
+                                    Getter getter,
+                                    const std::string &labels)
+{
+    Register(name, help, "counter", std::move(getter), labels);
+}
+
+void CuckooMetrics::Unregister(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    families.erase(name);
+}
+
+void CuckooMetrics::RenderStats(std::string &out)
+{
+    for (auto &counter : STATS_COUNTERS) {
+        double value = CuckooStats::GetInstance().stats[counter.item].load(std::memory_order_relaxed) * counter.scale;
+        out += std::format("# HELP {} {}\n# TYPE {} counter\n{} {}\n",
+                           counter.name,
+                           counter.help,
+                           counter.name,
+                           counter.name,
+                           value);
+    }
+}
+
+void CuckooMetrics::RenderHistograms(std::string &out)
+{
+    LatencyHistograms::Snapshot snapshot;
+    for (int hist = 0; hist < HIST_END; ++hist) {
+        LatencyHistograms::GetInstance().Collect(hist, snapshot);
+        uint64_t sum = LatencyHistograms::GetInstance().CollectSum(hist);
+        const char *name = HISTOGRAMS[hist].name;
+        out += std::format("# HELP {} {}\n# TYPE {} histogram\n", name, HISTOGRAMS[hist].help, name);
+
+        uint64_t cumulative = 0;
+        uint32_t index = 0;
+        for (uint32_t bit = EXPORT_MIN_BIT; bit <= EXPORT_MAX_BIT; ++bit) {
+            uint64_t bound = (1ULL << bit) - 1;
+            uint32_t lastIndex = LatencyHistograms::BucketIndex(bound);
+            for (; index <= lastIndex; ++index) {
+                cumulative += snapshot[index];
+            }
+            out += std::format("{}_bucket{{le=\"{}\"}} {}\n", name, (1ULL << bit) / 1e9, cumulative);
+        }
+        for (; index < LatencyHistograms::BUCKET_NUM; ++index) {
+            cumulative += snapshot[index];
+        }
+        out += std::format("{}_bucket{{le=\"+Inf\"}} {}\n", name, cumulative);
+        out += std::format("{}_sum {}\n{}_count {}\n", name, sum / 1e9, name, cumulative);
+    }
+}
+
+std::string CuckooMetrics::Render()
+{
+    std::string out;
+    RenderStats(out);
+    RenderHistograms(out);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &[name, family] : families) {
+        out += std::format("# HELP {} {}\n# TYPE {} {}\n", name, family.help, name, family.type);
+        for (auto &[labels, getter] : family.samples) {
+            if (labels.empty()) {
+                out += std::format("{} {}\n", name, getter());
+            } else {
+                out += std::format("{}{{{}}} {}\n", name, labels, getter());
+            }
+        }
+    }
+    return out;
+}
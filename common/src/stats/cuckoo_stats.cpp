@@ -10,6 +10,9 @@
 
 #include "log/logging.h"
 
+static constexpr std::array<const char *, HIST_END> HIST_NAMES =
+    {"FUSE", "FUSE Read", "FUSE Write", "Meta RPC", "Block Cache Read", "Object Get", "Object Put"};
+
 std::string formatU64(size_t size)
 {
     if (size == 0)
@@ -67,6 +70,10 @@ void PrintStats(std::string_view mountPath, std::stop_token stoken)
     std::remove(statPath.c_str());
     std::ofstream outFile;
     size_t currentStats[STATS_END];
+    /* stats only grow so that they can be exported as counters, print the difference to last round */
+    size_t lastStats[STATS_END] = {};
+    LatencyHistograms::Snapshot histSnapshot;
+    std::array<LatencyHistograms::Snapshot, HIST_END> lastHistSnapshots{};
     errno_t err = memset_s(currentStats, sizeof(size_t) * STATS_END, 0, sizeof(size_t) * STATS_END);
     if (err != 0) {
         CUCKOO_LOG(LOG_ERROR) << "Secure func failed: " << err;
@@ -75,7 +82,9 @@ void PrintStats(std::string_view mountPath, std::stop_token stoken)
 
     while (!stoken.stop_requested()) {
         for (int i = 0; i < STATS_END; i++) {
-            currentStats[i] = CuckooStats::GetInstance().stats[i].exchange(currentStats[i]);
+            size_t total = CuckooStats::GetInstance().stats[i].load();
+            currentStats[i] = total - lastStats[i];
+            lastStats[i] = total;
         }
         outFile.open(statPath, std::ios::out);
         if (!outFile.is_open()) {
@@ -107,8 +116,8 @@ void PrintStats(std::string_view mountPath, std::stop_token stoken)
 
         // Metadata Operations
         std::println(outFile, "Metadata Operations:");
-        // std::println(outFile, "  Total Operations: {}", formatOp(currentStats[META_OPS]));
-        // std::println(outFile, "  Average Latency: {} μs", formatTime(currentStats[META_LAT],
+        std::println(outFile, "  Total Operations: {}", formatOp(currentStats[META_OPS]));
+        std::println(outFile, "  Average Latency: {} μs", formatTime(currentStats[META_LAT], currentStats[META_OPS]));
 
         std::println(outFile, "  Open: {}", currentStats[META_OPEN]);
         std::println(outFile, "  Open Atomic: {}", currentStats[META_OPEN_ATOMIC]);
@@ -130,6 +139,7 @@ void PrintStats(std::string_view mountPath, std::stop_token stoken)
         std::println(outFile, "  Truncate: {}", currentStats[META_TRUNCATE]);
         std::println(outFile, "  Flush: {}", currentStats[META_FLUSH]);
         std::println(outFile, "  Fsync: {}", currentStats[META_FSYNC]);
+        std::println(outFile, "  Lock: {}", currentStats[META_LOCK]);
 
         // Block Cache and Object Operations
         std::println(outFile, "\nBlock Cache Operations:");
@@ -140,6 +150,22 @@ void PrintStats(std::string_view mountPath, std::stop_token stoken)
         std::println(outFile, "  Gets: {}", currentStats[OBJ_GET]);
         std::println(outFile, "  Puts: {}", currentStats[OBJ_PUT]);
 
+        // Latency percentiles of the last interval
+        std::println(outFile, "\nLatency Percentiles (μs):");
+        for (int i = 0; i < HIST_END; i++) {
+            LatencyHistograms::GetInstance().Collect(i, histSnapshot);
+            auto pct = LatencyHistograms::Percentiles(histSnapshot, lastHistSnapshots[i]);
+            std::println(outFile,
+                         "  {}: ops {} p50 {} p90 {} p99 {} p999 {} max {}",
+                         HIST_NAMES[i],
+                         pct.count,
+                         formatTime(pct.p50, 1),
+                         formatTime(pct.p90, 1),
+                         formatTime(pct.p99, 1),
+                         formatTime(pct.p999, 1),
+                         formatTime(pct.max, 1));
+        }
+
         outFile.close();
         {
             std::unique_lock lock(mtx);
@@ -0,0 +1,70 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "stats/latency_histogram.h"
+
+LatencyHistograms::Block *LatencyHistograms::AcquireBlock()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &block : blocks) {
+        bool expected = false;
+        if (block->inUse.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return block.get();
+        }
+    }
+    blocks.emplace_back(std::make_unique<Block>());
+    blocks.back()->inUse.store(true, std::memory_order_relaxed);
+    return blocks.back().get();
+}
+
+void LatencyHistograms::Collect(int hist, Snapshot &snapshot)
+{
+    snapshot.fill(0);
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &block : blocks) {
+        for (uint32_t i = 0; i < BUCKET_NUM; ++i) {
+            snapshot[i] += block->buckets[hist][i].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+uint64_t LatencyHistograms::CollectSum(int hist)
+{
+    uint64_t sum = 0;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &block : blocks) {
+        sum += block->sums[hist].load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+LatencyPercentiles LatencyHistograms::Percentiles(const Snapshot &current, Snapshot &last)
+{
+    Snapshot interval;
+    LatencyPercentiles result;
+    for (uint32_t i = 0; i < BUCKET_NUM; ++i) {
+        interval[i] = current[i] - last[i];
+        result.count += interval[i];
+    }
+    last = current;
+    if (result.count == 0) {
+        return result;
+    }
+
+    constexpr std::array<double, 4> ratios = {0.5, 0.9, 0.99, 0.999};
+    std::array<uint64_t *, 4> outputs = {&result.p50, &result.p90, &result.p99, &result.p999};
+    size_t next = 0;
+    uint64_t seen = 0;
+    for (uint32_t i = 0; i < BUCKET_NUM; ++i) {
+        if (interval[i] == 0) {
+            continue;
+        }
+        seen += interval[i];
+        while (next < ratios.size() && seen >= static_cast<uint64_t>(ratios[next] * result.count + 0.5)) {
+            *outputs[next++] = BucketUpperBound(i);
+        }
+        result.max = BucketUpperBound(i);
+    }
+    return result;
+}
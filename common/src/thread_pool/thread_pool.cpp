@@ -4,12 +4,20 @@
 
 #include "thread_pool/thread_pool.h"
 
+/* set on pool workers, so that tasks submitted by a task stay on the local queue */
+static thread_local const ThreadPool *t_currentPool = nullptr;
+static thread_local uint32_t t_workerIndex = 0;
+
 ThreadPool::ThreadPool(uint32_t threadNum, uint64_t maxTaskNum, std::string name)
     : threadNum(threadNum),
       maxTaskNum(maxTaskNum),
       name(std::move(name)),
       taskSem(maxTaskNum)
 {
+    uint32_t queueNum = threadNum == 0 ? 1 : threadNum;
+    for (uint32_t i = 0; i < queueNum; ++i) {
+        queues.emplace_back(std::make_unique<WorkerQueue>());
+    }
 }
 
 ThreadPool::~ThreadPool() { Stop(); }
@@ -25,9 +33,9 @@ int ThreadPool::Start()
     std::jthread t;
     std::string threadName;
     try {
-        for (uint32_t i = 0;i < threadNum; ++i) {
+        for (uint32_t i = 0; i < threadNum; ++i) {
             threadName = name + "_" + std::to_string(i);
-            t = std::jthread([this, threadName]() { WorkLoop(threadName); });
+            t = std::jthread([this, i]() { WorkLoop(i); });
             pthread_setname_np(t.native_handle(), threadName.c_str());
             threads.emplace_back(std::move(t));
         }
@@ -42,6 +50,9 @@ int ThreadPool::Start()
 void ThreadPool::Stop()
 {
     stopSource.request_stop();
+    {
+        std::lock_guard lock(sleepMutex);
+    }
     cv.notify_all();
     threads.clear();
 }
@@ -49,33 +60,114 @@ void ThreadPool::Stop()
 int ThreadPool::Submit(const ThreadTask &func)
 {
     taskSem.acquire();
+    size_t priority = static_cast<size_t>(func.priority);
+    if (priority >= PRIORITY_NUM) {
+        priority = static_cast<size_t>(TaskPriority::FOREGROUND);
+    }
+    uint32_t index = t_currentPool == this ? t_workerIndex
+                                           : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    /* counted before the task is visible, a worker taking it at once must not bring the counters below zero */
+    queueDepth[priority].fetch_add(1, std::memory_order_relaxed);
+    pendingTasks.fetch_add(1);
     {
-        std::lock_guard lock(mutex);
-        tasks.push(func);
+        WorkerQueue &queue = *queues[index];
+        std::lock_guard lock(queue.mutex);
+        queue.tasks[priority].push_back(func);
     }
 
-    cv.notify_one();
+    /* pairs with the idle count taken under sleepMutex in WorkLoop, so a parking worker can not miss it */
+    if (idleWorkers.load() > 0) {
+        {
+            std::lock_guard lock(sleepMutex);
+        }
+        cv.notify_one();
+    }
     return 0;
 }
 
-void ThreadPool::WorkLoop(const std::string &)
+uint64_t ThreadPool::GetQueueDepth(TaskPriority priority) const
 {
-    auto token = stopSource.get_token();
-    std::unique_lock lock(mutex);
-    while (!token.stop_requested() || !tasks.empty()) {
-        cv.wait(lock, token, [this, token] { return !tasks.empty() || token.stop_requested(); });
-        if (tasks.empty()) {
-            break;
+    size_t index = static_cast<size_t>(priority);
+    return index < PRIORITY_NUM ? queueDepth[index].load(std::memory_order_relaxed) : 0;
+}
+
+std::optional<ThreadTask> ThreadPool::PopLocal(uint32_t index, size_t priority)
+{
+    WorkerQueue &queue = *queues[index];
+    std::lock_guard lock(queue.mutex);
+    auto &tasks = queue.tasks[priority];
+    if (tasks.empty()) {
+        return std::nullopt;
+    }
+    ThreadTask task = std::move(tasks.front());
+    tasks.pop_front();
+    return task;
+}
+
+std::optional<ThreadTask> ThreadPool::Steal(uint32_t index, size_t priority)
+{
+    for (size_t i = 1; i < queues.size(); ++i) {
+        WorkerQueue &queue = *queues[(index + i) % queues.size()];
+        std::unique_lock lock(queue.mutex, std::try_to_lock);
+        if (!lock.owns_lock() || queue.tasks[priority].empty()) {
+            continue;
+        }
+        /* owner takes from the front, thieves from the back */
+        ThreadTask task = std::move(queue.tasks[priority].back());
+        queue.tasks[priority].pop_back();
+        stealCount.fetch_add(1, std::memory_order_relaxed);
+        return task;
+    }
+    return std::nullopt;
+}
+
+std::optional<ThreadTask> ThreadPool::TakeTask(uint32_t index, bool backgroundFirst)
+{
+    constexpr size_t foreground = static_cast<size_t>(TaskPriority::FOREGROUND);
+    constexpr size_t background = static_cast<size_t>(TaskPriority::BACKGROUND);
+    std::array<size_t, PRIORITY_NUM> order = {foreground, background};
+    if (backgroundFirst) {
+        order = {background, foreground};
+    }
+    for (size_t priority : order) {
+        auto task = PopLocal(index, priority);
+        if (!task) {
+            task = Steal(index, priority);
         }
+        if (task) {
+            queueDepth[priority].fetch_sub(1, std::memory_order_relaxed);
+            pendingTasks.fetch_sub(1);
+            return task;
+        }
+    }
+    return std::nullopt;
+}
 
-        auto task = std::move(tasks.front());
-        tasks.pop();
-        lock.unlock();
+void ThreadPool::WorkLoop(uint32_t index)
+{
+    t_currentPool = this;
+    t_workerIndex = index;
+    auto token = stopSource.get_token();
+    uint32_t foregroundRun = 0;
+    while (true) {
+        auto task = TakeTask(index, foregroundRun >= BACKGROUND_INTERVAL);
+        if (task) {
+            foregroundRun = task->priority == TaskPriority::FOREGROUND ? foregroundRun + 1 : 0;
+            if (task->task) {
+                task->task();
+            }
+            taskSem.release();
+            continue;
+        }
+        foregroundRun = 0;
 
-        if (task.task) {
-            task.task();
+        /* a steal may skip a queue locked by others, so only park when nothing is pending at all */
+        std::unique_lock lock(sleepMutex);
+        idleWorkers.fetch_add(1);
+        cv.wait(lock, token, [this] { return pendingTasks.load() > 0; });
+        idleWorkers.fetch_sub(1);
+        if (pendingTasks.load() == 0 && token.stop_requested()) {
+            break;
         }
-        taskSem.release();
-        lock.lock();
     }
 }
@@ -4,10 +4,29 @@
 
 #include "write_stream/stream_assembler.h"
 
+#include "buffer/open_instance.h"
 #include "disk_cache/disk_cache.h"
 #include "stats/cuckoo_stats.h"
 
 MemPool FixMemory::writeMemPool(CUCKOO_STORE_STREAM_MAX_SIZE, 500);
+std::atomic<int64_t> WriteStream::mergedMemory = 0;
+std::atomic<uint64_t> WriteStream::mergeMemoryLimit = DEFAULT_WRITE_MERGE_MEMORY;
+std::atomic<uint32_t> WriteStream::inflightLimit = DEFAULT_WRITE_INFLIGHT_NUM;
+
+char *FixMemory::AllocBuffer()
+{
+    char *buffer = (char *)writeMemPool.alloc();
+    if (buffer != nullptr) {
+        OpenInstance::streamBytes.fetch_add(CUCKOO_STORE_STREAM_MAX_SIZE, std::memory_order_relaxed);
+    }
+    return buffer;
+}
+
+void FixMemory::FreeBuffer(char *buffer)
+{
+    writeMemPool.free(buffer);
+    OpenInstance::streamBytes.fetch_sub(CUCKOO_STORE_STREAM_MAX_SIZE, std::memory_order_relaxed);
+}
 
 int WriteStream::Push(CuckooWriteBuffer buf, off_t offset, uint64_t currentSize)
 {
@@ -40,19 +59,31 @@ int WriteStream::Push(CuckooWriteBuffer buf, off_t offset, uint64_t currentSize)
     }
 
     std::unique_lock<std::shared_mutex> xlock(mutex);
-    int ret = 0;
-    /* Data not in order or large data, persist the current m_data buffer */
-    if (data.End() != (size_t)offset || buf.size >= CUCKOO_STORE_STREAM_MAX_SIZE) {
+    /* a write sent earlier failed */
+    int ret = CheckInflight();
+    if (ret != 0) {
+        return ret;
+    }
+    /* the new data overwrites the buffered data, persist the current m_data buffer first */
+    if (!data.Empty() && (size_t)offset < data.End() && offset + buf.size > (size_t)data.offset) {
         ret = Persist(currentSize);
         if (ret != 0) {
             return ret;
         }
     }
 
-    /* Large data, persist incoming data */
+    /* Large data, persist what it overwrites, then incoming data */
     if (buf.size >= CUCKOO_STORE_STREAM_MAX_SIZE) {
-        xlock.unlock();
-        return PersistToFile(buf.ptr, buf.size, offset, currentSize);
+        ret = PersistStream(currentSize, offset, buf.size);
+        if (ret != 0) {
+            return ret;
+        }
+        return PersistCopyToRemote(buf.ptr, buf.size, offset);
+    }
+
+    /* Data not in order, keep it for merging with its neighbours */
+    if ((!data.Empty() && data.End() != (size_t)offset) || StreamOverlaps(offset, buf.size)) {
+        return PushOutOfOrder(buf.ptr, buf.size, offset, currentSize);
     }
 
     /* Too much data in m_data, persist */
@@ -63,11 +94,168 @@ int WriteStream::Push(CuckooWriteBuffer buf, off_t offset, uint64_t currentSize)
         }
     }
     /* concatanate new data to m_data, copy */
-    data.Append(buf.ptr, buf.size, offset);
+    if (!data.Append(buf.ptr, buf.size, offset)) {
+        return -ENOMEM;
+    }
+
+    return 0;
+}
+
+/*
+ * Merge data not following m_data into the stream, persist the merged slices once large enough.
+ */
+int WriteStream::PushOutOfOrder(const char *buf, size_t size, off_t offset, uint64_t currentSize)
+{
+    int ret = 0;
+    if (mergedMemory.load() + size > mergeMemoryLimit.load()) {
+        /* no memory to merge, persist directly as if never merged */
+        ret = PersistStream(currentSize, offset, size);
+        if (ret != 0) {
+            return ret;
+        }
+        return PersistCopyToRemote(buf, size, offset);
+    }
+
+    ExpandableMemory mem;
+    if (!mem.Reserve(size) || !mem.Append(buf, size)) {
+        return -ENOMEM;
+    }
+    int64_t delta = Merge(MergedSlice(Slice(mem, size, offset)));
+    streamMemory += delta;
+    mergedMemory += delta;
+
+    /* the merged slice holding the new data */
+    auto it = std::prev(stream.upper_bound(MergedSlice(Slice(ExpandableMemory(), 0, offset))));
+    if (it->size >= CUCKOO_STORE_STREAM_MAX_SIZE) {
+        ret = PersistMergedSlice(it, currentSize);
+        if (ret != 0) {
+            return ret;
+        }
+    }
+    if (streamMemory > WRITE_STREAM_MERGE_MAX_SIZE) {
+        return PersistStream(currentSize);
+    }
+    return 0;
+}
+
+bool WriteStream::StreamOverlaps(off_t offset, size_t size)
+{
+    auto it = stream.upper_bound(MergedSlice(Slice(ExpandableMemory(), 0, offset + size - 1)));
+    return it != stream.begin() && std::prev(it)->offset + std::prev(it)->size > (size_t)offset;
+}
+
+/*
+ * Persist the merged slices overlapping [offset, offset + size) in offset order, all by default.
+ */
+int WriteStream::PersistStream(uint64_t currentSize, off_t offset, size_t size)
+{
+    auto it = stream.upper_bound(MergedSlice(Slice(ExpandableMemory(), 0, offset)));
+    if (it != stream.begin() && std::prev(it)->offset + std::prev(it)->size > (size_t)offset) {
+        --it;
+    }
+    size_t end = size > SIZE_MAX - offset ? SIZE_MAX : offset + size;
+    int ret = 0;
+    while (it != stream.end() && (size_t)it->offset < end) {
+        int err = PersistMergedSlice(it++, currentSize);
+        ret = ret == 0 ? err : ret;
+    }
+    return ret;
+}
+
+int WriteStream::PersistMergedSlice(std::set<MergedSlice>::iterator it, uint64_t currentSize)
+{
+    auto node = stream.extract(it);
+    MergedSlice &slice = node.value();
+    streamMemory -= slice.memoryOccupancy;
+    mergedMemory -= slice.memoryOccupancy;
+    std::shared_ptr<char> buf = slice.Get();
+    if (buf == nullptr) {
+        return -ENOMEM;
+    }
+    return PersistToRemote(buf, slice.size, slice.offset);
+}
 
+int WriteStream::PersistToRemote(std::shared_ptr<char> buf, size_t size, off_t offset)
+{
+    auto write = std::make_shared<InflightWrite>(InflightWrite{offset, size, buf});
+    {
+        std::unique_lock<std::mutex> lock(inflightMutex);
+        inflightCv.wait(lock, [this, offset, size]() {
+            ReapInflight();
+            return inflightError != 0 || (inflight.size() < inflightLimit.load() && !InflightOverlaps(offset, size));
+        });
+        if (inflightError != 0) {
+            return inflightError;
+        }
+        inflight.push_back(write);
+    }
+
+    client->WriteFileAsync(physicalFd, buf.get(), size, offset, [this, write](int ret) {
+        std::shared_ptr<char> answered;
+        std::lock_guard<std::mutex> lock(inflightMutex);
+        answered = std::move(write->buf);
+        write->ret = ret;
+        write->done = true;
+        inflightCv.notify_all();
+    });
     return 0;
 }
 
+int WriteStream::PersistCopyToRemote(const char *buf, size_t size, off_t offset)
+{
+    /* the caller owns buf, copy it for the rpc to outlive the call */
+    char *copy = (char *)malloc(size);
+    if (copy == nullptr) {
+        CUCKOO_LOG(LOG_ERROR) << "WriteStream::PersistCopyToRemote() malloc failed";
+        return -ENOMEM;
+    }
+    errno_t err = memcpy_s(copy, size, buf, size);
+    if (err != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "Secure func failed: " << err;
+        free(copy);
+        return -EIO;
+    }
+    return PersistToRemote(std::shared_ptr<char>(copy, free), size, offset);
+}
+
+/* retire the answered writes at the front, in the order sent */
+void WriteStream::ReapInflight()
+{
+    while (!inflight.empty() && inflight.front()->done) {
+        if (inflightError == 0) {
+            inflightError = inflight.front()->ret;
+        }
+        inflight.pop_front();
+    }
+}
+
+bool WriteStream::InflightOverlaps(off_t offset, size_t size)
+{
+    for (auto &write : inflight) {
+        if (!write->done && write->offset < (off_t)(offset + size) && offset < (off_t)(write->offset + write->size)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int WriteStream::WaitInflight()
+{
+    std::unique_lock<std::mutex> lock(inflightMutex);
+    inflightCv.wait(lock, [this]() {
+        ReapInflight();
+        return inflight.empty();
+    });
+    return inflightError;
+}
+
+int WriteStream::CheckInflight()
+{
+    std::unique_lock<std::mutex> lock(inflightMutex);
+    ReapInflight();
+    return inflightError;
+}
+
 /*
  * Write data directly to file.
  */
@@ -122,12 +310,19 @@ int WriteStream::Complete(uint64_t currentSize, bool isFlush, bool isSync)
 {
     std::unique_lock<std::shared_mutex> xlock(mutex);
     if (client != nullptr) {
+        /* m_data never overlaps the stream, the order they reach the file does not matter */
+        int streamRet = PersistStream(currentSize);
+        /* the close rpc flushes the file, everything sent must have landed */
+        int inflightRet = WaitInflight();
+        streamRet = streamRet != 0 ? streamRet : inflightRet;
+        int ret = 0;
         if (!data.Empty()) {
-            int ret = client->CloseFile(physicalFd, isFlush, isSync, data.buf.c_str(), data.size, data.offset);
+            ret = client->CloseFile(physicalFd, isFlush, isSync, data.buf.c_str(), data.size, data.offset);
             data.Clear();
-            return ret;
+        } else {
+            ret = client->CloseFile(physicalFd, isFlush, isSync, nullptr, 0, 0);
         }
-        return client->CloseFile(physicalFd, isFlush, isSync, nullptr, 0, 0);
+        return streamRet != 0 ? streamRet : ret;
     }
 
     return Persist(currentSize);
@@ -153,8 +348,15 @@ void WriteStream::SetClient(std::shared_ptr<CuckooIOClient> cuckooIOClient)
     client = cuckooIOClient;
 }
 
+void WriteStream::Rebind(uint64_t newPhysicalFd, std::shared_ptr<CuckooIOClient> cuckooIOClient)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    physicalFd = newPhysicalFd;
+    client = std::move(cuckooIOClient);
+}
+
 /*
- * Merge the slice of data. Unused.
+ * Merge the slice of data with the slices it overlaps or touches, return the change of memory occupancy.
  */
 int64_t WriteStream::Merge(MergedSlice &&slice)
 {
@@ -173,13 +375,9 @@ int64_t WriteStream::Merge(MergedSlice &&slice)
     // merge the end of overlap
     while (it != stream.end() && end >= (size_t)it->offset) {
         ret -= it->memoryOccupancy;
-        auto prevIt = it;
-        it = std::next(it);
-        if (end < prevIt->offset + prevIt->size) {
-            end = prevIt->offset + prevIt->size;
-            auto internal_node = stream.extract(prevIt);
-            mergeQ.emplace_back(std::move(internal_node.value()));
-        }
+        end = std::max(end, it->offset + it->size);
+        auto internal_node = stream.extract(it++);
+        mergeQ.emplace_back(std::move(internal_node.value()));
     }
 
     if (mergeQ.empty()) {
@@ -189,6 +387,10 @@ int64_t WriteStream::Merge(MergedSlice &&slice)
     } else {
         mergeQ.emplace_back(std::forward<MergedSlice>(slice)); // new slice is the last to update
         MergedSlice &&ms = MergedSlice(std::move(mergeQ));
+        if (ms.memoryOccupancy > 2 * ms.size && ms.Get() != nullptr) {
+            /* rewritten over and over, keep only the latest content */
+            ms.memoryOccupancy = ms.size;
+        }
         ret += ms.memoryOccupancy;
         stream.insert(std::forward<MergedSlice>(ms));
     }
@@ -206,7 +408,12 @@ int WriteStream::Persist(uint64_t currentSize)
     }
 
     int ret = 0;
-    if (!data.Empty()) {
+    if (!data.Empty() && client != nullptr) {
+        /* hand the buffer over to the rpc, back to the pool once answered */
+        std::shared_ptr<char> buf(data.buf.mem, FixMemory::FreeBuffer);
+        data.buf.mem = nullptr;
+        ret = PersistToRemote(buf, data.size, data.offset);
+    } else if (!data.Empty()) {
         ret = PersistToFile(data.buf.c_str(), data.size, data.offset, currentSize);
     }
     data.Clear();
@@ -215,10 +422,43 @@ int WriteStream::Persist(uint64_t currentSize)
 }
 
 /*
- * Get current data size in m_data buffer
+ * Get current data size in m_data buffer and the stream
  */
 uint64_t WriteStream::GetSize()
 {
     std::shared_lock<std::shared_mutex> lock(mutex);
-    return data.size;
+    uint64_t size = data.size;
+    for (auto &slice : stream) {
+        size += slice.size;
+    }
+    return size;
+}
+
+bool WriteStream::Pending()
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex);
+        if (!data.Empty() || !stream.empty()) {
+            return true;
+        }
+    }
+    std::unique_lock<std::mutex> lock(inflightMutex);
+    ReapInflight();
+    return !inflight.empty();
+}
+
+void WriteStream::Reset()
+{
+    std::unique_lock<std::shared_mutex> lock(mutex);
+    WaitInflight();
+    inflightError = 0;
+    stream.clear();
+    mergedMemory -= streamMemory;
+    streamMemory = 0;
+    physicalFd = UINT64_MAX;
+    client = nullptr;
+    data.Clear();
+    data.buf.Release();
+    inodeId = 0;
+    direct = false;
 }
@@ -34,6 +34,9 @@ class ConnectionPoolBrpcServer {
         cuckoo::meta_proto::MetaServiceImpl metaServiceImpl(pgConnectionPool);
         if (server.AddService(&metaServiceImpl, brpc::SERVER_DOESNT_OWN_SERVICE) != 0)
             throw std::runtime_error("ConnectionPoolBrpcServer: brpc server AddService failed");
+        cuckoo::meta_proto::TraceServiceImpl traceServiceImpl;
+        if (server.AddService(&traceServiceImpl, brpc::SERVER_DOESNT_OWN_SERVICE, "/trace => Trace") != 0)
+            throw std::runtime_error("ConnectionPoolBrpcServer: brpc server AddService failed");
 
         butil::EndPoint point;
         point = butil::EndPoint(butil::IP_ANY, port);
@@ -52,6 +52,7 @@ void CuckooDaemonConnectionPoolProcessMain(unsigned long int main_arg)
     elog(LOG, "CuckooDaemonConnectionPoolProcessMain: init finished.");
 
     CuckooPGPort = PostPortNumber;
+    CuckooTraceSetProcessName("cuckoo_meta_server");
     PG_RunConnectionPoolBrpcServer();
 
     elog(LOG, "CuckooDaemonConnectionPoolProcessMain: connection pool server stopped.");
@@ -82,10 +83,17 @@ void CuckooConnectionPoolShmemInit()
                                  CuckooConnectionPoolShmemBuffer,
                                  CuckooConnectionPoolShmemsize()) != 0)
         CUCKOO_ELOG_ERROR(PROGRAM_ERROR, "CuckooShmemAllocatorInit failed.");
-    if (!initialized) {
-        memset(CuckooConnectionPoolShmemAllocator.signatureCounter,
-               0,
-               sizeof(PaddedAtomic64) *
-                   (1 + CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT + CuckooConnectionPoolShmemAllocator.pageCount));
-    }
+    if (!initialized)
+        CuckooShmemAllocatorReset(&CuckooConnectionPoolShmemAllocator);
+}
+
+size_t CuckooTraceShmemsize() { return CuckooTraceRingSize(CUCKOO_TRACE_DEFAULT_CAPACITY); }
+void CuckooTraceShmemInit()
+{
+    bool initialized;
+
+    CuckooTraceRing *ring = ShmemInitStruct("Cuckoo Trace Ring", CuckooTraceShmemsize(), &initialized);
+    if (!initialized)
+        CuckooTraceRingInit(ring, CUCKOO_TRACE_DEFAULT_CAPACITY);
+    CuckooTraceAttachRing(ring);
 }
\ No newline at end of file
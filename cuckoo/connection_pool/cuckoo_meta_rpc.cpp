@@ -4,6 +4,8 @@
 
 #include "connection_pool/cuckoo_meta_rpc.h"
 
+#include <stdlib.h>
+
 #include <brpc/server.h>
 #include <butil/iobuf.h>
 
@@ -23,4 +25,21 @@ void MetaServiceImpl::MetaCall(google::protobuf::RpcController *cntlBase,
     doneGuard.release();
 }
 
+void TraceServiceImpl::Trace(google::protobuf::RpcController *cntlBase,
+                             const Empty * /*request*/,
+                             Empty * /*response*/,
+                             google::protobuf::Closure *done)
+{
+    brpc::ClosureGuard doneGuard(done);
+    brpc::Controller *cntl = static_cast<brpc::Controller *>(cntlBase);
+
+    cntl->http_response().set_content_type("application/json");
+    size_t size = 0;
+    char *dump = CuckooTraceDumpToMemory(&size);
+    if (dump != NULL) {
+        cntl->response_attachment().append(dump, size);
+        free(dump);
+    }
+}
+
 } // namespace cuckoo::meta_proto
\ No newline at end of file
@@ -57,6 +57,22 @@ void PGConnection::BackgroundWorker()
         if (taskToExec->jobList.size() == 0)
             throw std::runtime_error("pgconnection: taskToExec is empty");
 
+        // 1.1 Trace sampled jobs, the backend continues the trace of the first one through the param block
+        CuckooTraceContext execParent = {0, 0};
+        int64_t execStartNs = 0;
+        for (size_t i = 0; i < taskToExec->jobList.size(); ++i) {
+            cuckoo::meta_proto::AsyncMetaServiceJob *job = taskToExec->jobList[i];
+            if (!CuckooTraceSampled(job->GetTrace()))
+                continue;
+            if (execStartNs == 0) {
+                execStartNs = CuckooTraceNowNs();
+                execParent = job->GetTrace();
+            }
+            CuckooTraceRecord(job->GetTrace(), "pool_queue", job->GetReceiveTimeNs(), execStartNs);
+        }
+        CuckooTraceSpan execSpan;
+        CuckooTraceBeginWithParent(&execSpan, "pg_exec", execParent);
+
         // 2. Start processing
         CuckooErrorCode errorCode = SUCCESS;
         CuckooShmemAllocator *allocator = &CuckooConnectionPoolShmemAllocator;
@@ -95,6 +111,8 @@ void PGConnection::BackgroundWorker()
             }
             CUCKOO_SHMEM_ALLOCATOR_SET_SIGNATURE(CUCKOO_SHMEM_ALLOCATOR_GET_POINTER(allocator, totalParamShift),
                                                  signature);
+            CUCKOO_SHMEM_ALLOCATOR_SET_TRACE(CUCKOO_SHMEM_ALLOCATOR_GET_POINTER(allocator, totalParamShift),
+                                             execSpan.context);
 
             // 2.1.2
             // barch operation can not be plain command
@@ -238,6 +256,11 @@ void PGConnection::BackgroundWorker()
                     signatureList.push_back(0);
                 } else {
                     signatureList.push_back(CuckooShmemAllocatorGetUniqueSignature(allocator));
+                    if (currentParamSegment == 0) {
+                        // lets the backend tell that the param block header belongs to this call
+                        CUCKOO_SHMEM_ALLOCATOR_SET_SIGNATURE(paramBuffer, signatureList.back());
+                        CUCKOO_SHMEM_ALLOCATOR_SET_TRACE(paramBuffer, execSpan.context);
+                    }
                     toSendCommand << "select cuckoo_meta_call_by_serialized_shmem_internal(" << serviceType << ", "
                                   << currentParamSegmentCount << ", " << paramShift + currentParamSegment << ", "
                                   << signatureList.back() << ");";
@@ -327,6 +350,13 @@ void PGConnection::BackgroundWorker()
                 PQclear(res);
         }
 
+        CuckooTraceEnd(&execSpan);
+        for (size_t i = 0; i < taskToExec->jobList.size(); ++i) {
+            const CuckooTraceContext &trace = taskToExec->jobList[i]->GetTrace();
+            if (CuckooTraceSampled(trace) && trace.spanId != execParent.spanId)
+                CuckooTraceRecord(trace, "pg_exec", execStartNs, CuckooTraceNowNs());
+        }
+
         // TBD
         //
         //
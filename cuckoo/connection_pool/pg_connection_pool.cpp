@@ -4,8 +4,21 @@
 
 #include "connection_pool/pg_connection_pool.h"
 
+#include <butil/time.h>
+
 #include "connection_pool/pg_connection.h"
 
+extern "C" {
+#include "connection_pool/connection_pool.h"
+}
+
+int64_t PGConnectionPool::GetShmemStat(void *field)
+{
+    CuckooShmemAllocatorStats stats;
+    CuckooShmemAllocatorGetStats(&CuckooConnectionPoolShmemAllocator, &stats);
+    return (int64_t)*(uint64_t *)((char *)&stats + (uintptr_t)field);
+}
+
 void PGConnectionPool::BackgroundPoolManager()
 {
     while (working) {
@@ -23,6 +36,7 @@ void PGConnectionPool::BackgroundPoolManager()
             // fetch command
             taskToExec = pendingTask.front();
             pendingTask.pop();
+            pendingTaskNum << -1;
             for (int i = 0; i < TaskSupportBatchType::NOT_SUPPORT; ++i) {
                 if (taskToExec != supportBatchTaskList[i].task)
                     continue;
@@ -36,6 +50,9 @@ void PGConnectionPool::BackgroundPoolManager()
             }
         }
         cvPendingTaskNotFull.notify_one();
+        taskWaitLatency << butil::gettimeofday_us() - taskToExec->enqueueTimeUs;
+        batchSize << static_cast<int64_t>(taskToExec->jobList.size());
+        batchSizeMax << static_cast<int64_t>(taskToExec->jobList.size());
 
         // 3. exec bt backgroundworker of connection
         conn->Exec(taskToExec);
@@ -76,6 +93,7 @@ void PGConnectionPool::ReaddWorkingPGConnection(PGConnection *conn)
 PGConnection *PGConnectionPool::GetPGConnection()
 {
     PGConnection *result = NULL;
+    int64_t startUs = butil::gettimeofday_us();
     {
         std::unique_lock<std::mutex> lk(connPoolMutex);
         cvPoolNotEmpty.wait(lk, [this]() -> bool { return !this->connPool.empty(); });
@@ -83,6 +101,7 @@ PGConnection *PGConnectionPool::GetPGConnection()
         result = connPool.front();
         connPool.pop();
     }
+    connWaitLatency << butil::gettimeofday_us() - startUs;
     return result;
 }
 
@@ -126,7 +145,9 @@ void PGConnectionPool::DispatchAsyncMetaServiceJob(cuckoo::meta_proto::AsyncMeta
         {
             std::unique_lock<std::mutex> lk(pendingTaskMutex);
             cvPendingTaskNotFull.wait(lk, [this]() -> bool { return pendingTask.size() < pendingTaskBufferMaxSize; });
+            toInsertTask->enqueueTimeUs = butil::gettimeofday_us();
             pendingTask.push(toInsertTask);
+            pendingTaskNum << 1;
         }
         cvPendingTaskNotEmpty.notify_one();
     }
@@ -0,0 +1,40 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+/* contrib/cuckoo/cuckoo--1.0--1.1.sql */
+
+-- complain if script is sourced in psql, rather than via ALTER EXTENSION
+\echo Use "ALTER EXTENSION cuckoo UPDATE TO '1.1'" to load this file. \quit
+
+----------------------------------------------------------------
+-- shard tables created by 1.0, new shards are created this way by cuckoo_create_distributed_data_table
+----------------------------------------------------------------
+DO $$
+DECLARE
+    shard record;
+BEGIN
+    -- xattr values are binary from 1.1, the text kept so far becomes its utf8 bytes
+    FOR shard IN
+        SELECT c.relname
+        FROM pg_catalog.pg_class c JOIN pg_catalog.pg_attribute a ON a.attrelid = c.oid
+        WHERE c.relnamespace = 'pg_catalog'::regnamespace AND c.relkind = 'r'
+            AND c.relname ~ '^cuckoo_xattr_table_[0-9]+$'
+            AND a.attname = 'xvalue' AND a.atttypid = 'text'::regtype
+    LOOP
+        EXECUTE format('ALTER TABLE pg_catalog.%I ALTER COLUMN xvalue TYPE bytea USING convert_to(xvalue, ''UTF8'')',
+                       shard.relname);
+    END LOOP;
+
+    -- names of a hard linked inode are found by st_ino
+    FOR shard IN
+        SELECT c.relname
+        FROM pg_catalog.pg_class c
+        WHERE c.relnamespace = 'pg_catalog'::regnamespace AND c.relkind = 'r'
+            AND c.relname ~ '^cuckoo_inode_table_[0-9]+$'
+    LOOP
+        EXECUTE format('CREATE INDEX IF NOT EXISTS %I ON pg_catalog.%I USING btree(st_ino)',
+                       shard.relname || '_ino_index', shard.relname);
+    END LOOP;
+END
+$$;
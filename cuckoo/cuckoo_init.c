@@ -150,6 +150,7 @@ static void CuckooShmemRequest(void)
     RequestAddinShmemSpace(ShardTableShmemsize());
     RequestAddinShmemSpace(DirPathShmemsize());
     RequestAddinShmemSpace(CuckooConnectionPoolShmemsize());
+    RequestAddinShmemSpace(CuckooTraceShmemsize());
 }
 static void CuckooShmemInit(void)
 {
@@ -165,6 +166,7 @@ static void CuckooShmemInit(void)
     ShardTableShmemInit();
     DirPathShmemInit();
     CuckooConnectionPoolShmemInit();
+    CuckooTraceShmemInit();
 
     LWLockRelease(AddinShmemInitLock);
 }
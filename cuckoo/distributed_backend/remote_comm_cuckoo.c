@@ -16,6 +16,7 @@
 #include "metadb/meta_handle.h"
 #include "metadb/meta_serialize_interface_helper.h"
 #include "metadb/shard_table.h"
+#include "remote_connection_utils/cuckoo_trace.h"
 #include "transaction/transaction.h"
 #include "transaction/transaction_cleanup.h"
 #include "utils/error_log.h"
@@ -186,6 +187,9 @@ static bool inline ClearPGresultInPGconn(PGconn *conn)
 
 MultipleServerRemoteCommandResult CuckooSendCommandAndWaitForResult()
 {
+    CuckooTraceSpan span;
+    CuckooTraceBegin(&span, "remote_send_wait");
+
     List *workerIdList = NIL;
     List *remoteConnectionCommandDataList = NIL;
     HASH_SEQ_STATUS status;
@@ -330,6 +334,7 @@ MultipleServerRemoteCommandResult CuckooSendCommandAndWaitForResult()
         multipleServerRemoteCommandResult = lappend(multipleServerRemoteCommandResult, resPerServer);
     }
 
+    CuckooTraceEnd(&span);
     return multipleServerRemoteCommandResult;
 }
 
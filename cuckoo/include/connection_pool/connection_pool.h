@@ -15,4 +15,8 @@ extern CuckooShmemAllocator CuckooConnectionPoolShmemAllocator;
 size_t CuckooConnectionPoolShmemsize(void);
 void CuckooConnectionPoolShmemInit(void);
 
+/* spans of the pool and all backends go to one ring, dumped by the pool at /trace */
+size_t CuckooTraceShmemsize(void);
+void CuckooTraceShmemInit(void);
+
 #endif
\ No newline at end of file
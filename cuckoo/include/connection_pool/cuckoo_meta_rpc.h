@@ -31,6 +31,18 @@ class MetaServiceImpl : public MetaService {
                           google::protobuf::Closure *done);
 };
 
+/* dumps the spans of the pool and the backends as Chrome trace json over http, mapped to /trace */
+class TraceServiceImpl : public TraceService {
+  public:
+    TraceServiceImpl() {}
+    virtual ~TraceServiceImpl() {}
+
+    virtual void Trace(google::protobuf::RpcController *cntlBase,
+                       const Empty *request,
+                       Empty *response,
+                       google::protobuf::Closure *done);
+};
+
 } // namespace cuckoo::meta_proto
 
 #endif
\ No newline at end of file
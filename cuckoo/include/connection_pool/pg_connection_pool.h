@@ -6,13 +6,16 @@
 #define CUCKOO_CONNECTION_POOL_PG_CONNECTION_POOL_H
 
 #include <condition_variable>
+#include <cstddef>
 #include <queue>
 #include <string>
 #include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
+#include <bvar/bvar.h>
 #include "connection_pool/task.h"
+#include "utils/cuckoo_shmem_allocator.h"
 
 class PGConnection;
 
@@ -32,7 +35,19 @@ class PGConnectionPool {
     std::condition_variable cvPendingTaskNotFull;
     uint16_t pendingTaskBufferMaxSize;
 
-    enum TaskSupportBatchType { MKDIR = 0, CREATE, STAT, UNLINK, OPEN, CLOSE, NOT_SUPPORT };
+    enum TaskSupportBatchType {
+        MKDIR = 0,
+        CREATE,
+        STAT,
+        UNLINK,
+        OPEN,
+        CLOSE,
+        SETXATTR,
+        GETXATTR,
+        LISTXATTR,
+        REMOVEXATTR,
+        NOT_SUPPORT
+    };
     TaskSupportBatchType ConvertMetaServiceTypeToTaskSupportBatchType(const cuckoo::meta_proto::MetaServiceType type)
     {
         switch (type) {
@@ -48,6 +63,14 @@ class PGConnectionPool {
             return TaskSupportBatchType::OPEN;
         case cuckoo::meta_proto::MetaServiceType::CLOSE:
             return TaskSupportBatchType::CLOSE;
+        case cuckoo::meta_proto::MetaServiceType::SETXATTR:
+            return TaskSupportBatchType::SETXATTR;
+        case cuckoo::meta_proto::MetaServiceType::GETXATTR:
+            return TaskSupportBatchType::GETXATTR;
+        case cuckoo::meta_proto::MetaServiceType::LISTXATTR:
+            return TaskSupportBatchType::LISTXATTR;
+        case cuckoo::meta_proto::MetaServiceType::REMOVEXATTR:
+            return TaskSupportBatchType::REMOVEXATTR;
         default:
             return TaskSupportBatchType::NOT_SUPPORT;
         }
@@ -63,6 +86,40 @@ class PGConnectionPool {
 
     std::thread backgroundPoolManager;
 
+    /* exposed by brpc, scraped in Prometheus format from /brpc_metrics of the meta server */
+    bvar::LatencyRecorder taskWaitLatency{"cuckoo_pool_task_wait"};
+    bvar::LatencyRecorder connWaitLatency{"cuckoo_pool_conn_wait"};
+    bvar::IntRecorder batchSize{"cuckoo_pool_batch_size"};
+    bvar::Maxer<int64_t> batchSizeMax{"cuckoo_pool_batch_size_max"};
+    bvar::Adder<int64_t> pendingTaskNum{"cuckoo_pool_pending_tasks"};
+
+    /* usage of the shared memory the backends hand requests over in, arg is the offset of the field in the stats */
+    static int64_t GetShmemStat(void *field);
+    bvar::PassiveStatus<int64_t> shmemTotalBytes{"cuckoo_pool_shmem_total_bytes", GetShmemStat,
+                                                 (void *)offsetof(CuckooShmemAllocatorStats, totalBytes)};
+    bvar::PassiveStatus<int64_t> shmemUsedBytes{"cuckoo_pool_shmem_used_bytes", GetShmemStat,
+                                                (void *)offsetof(CuckooShmemAllocatorStats, usedBytes)};
+    bvar::PassiveStatus<int64_t> shmemRequestedBytes{"cuckoo_pool_shmem_requested_bytes", GetShmemStat,
+                                                     (void *)offsetof(CuckooShmemAllocatorStats, requestedBytes)};
+    bvar::PassiveStatus<int64_t> shmemCachedBytes{"cuckoo_pool_shmem_cached_bytes", GetShmemStat,
+                                                  (void *)offsetof(CuckooShmemAllocatorStats, cachedBytes)};
+    bvar::PassiveStatus<int64_t> shmemFreeBytes{"cuckoo_pool_shmem_free_bytes", GetShmemStat,
+                                                (void *)offsetof(CuckooShmemAllocatorStats, freeBytes)};
+    bvar::PassiveStatus<int64_t> shmemLargestFreeBlock{"cuckoo_pool_shmem_largest_free_block", GetShmemStat,
+                                                       (void *)offsetof(CuckooShmemAllocatorStats, largestFreeBlock)};
+    bvar::PassiveStatus<int64_t> shmemAllocCount{"cuckoo_pool_shmem_alloc_count", GetShmemStat,
+                                                 (void *)offsetof(CuckooShmemAllocatorStats, allocCount)};
+    bvar::PassiveStatus<int64_t> shmemFreeListHits{"cuckoo_pool_shmem_free_list_hits", GetShmemStat,
+                                                   (void *)offsetof(CuckooShmemAllocatorStats, freeListHits)};
+    bvar::PassiveStatus<int64_t> shmemScannedPages{"cuckoo_pool_shmem_scanned_pages", GetShmemStat,
+                                                   (void *)offsetof(CuckooShmemAllocatorStats, scannedPages)};
+    bvar::PassiveStatus<int64_t> shmemFailCount{"cuckoo_pool_shmem_fail_count", GetShmemStat,
+                                                (void *)offsetof(CuckooShmemAllocatorStats, failCount)};
+    bvar::PassiveStatus<int64_t> shmemAllocNs{"cuckoo_pool_shmem_alloc_ns", GetShmemStat,
+                                              (void *)offsetof(CuckooShmemAllocatorStats, allocNs)};
+    bvar::PassiveStatus<int64_t> shmemAllocMaxNs{"cuckoo_pool_shmem_alloc_max_ns", GetShmemStat,
+                                                 (void *)offsetof(CuckooShmemAllocatorStats, allocMaxNs)};
+
     PGConnection *GetPGConnection();
     void BackgroundPoolManager();
 
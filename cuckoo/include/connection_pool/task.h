@@ -8,6 +8,7 @@
 #include <brpc/server.h>
 #include <vector>
 #include "cuckoo_meta_rpc.pb.h"
+#include "remote_connection_utils/cuckoo_trace.h"
 
 namespace cuckoo::meta_proto
 {
@@ -18,6 +19,9 @@ class AsyncMetaServiceJob {
     const MetaRequest *request;
     Empty *response;
     google::protobuf::Closure *done;
+    CuckooTraceContext trace;
+    /* only taken for sampled requests */
+    int64_t receiveTimeNs;
 
   public:
     AsyncMetaServiceJob(brpc::Controller *cntl,
@@ -27,12 +31,16 @@ class AsyncMetaServiceJob {
         : cntl(cntl),
           request(request),
           response(response),
-          done(done)
+          done(done),
+          trace(CuckooTraceExtract(*request)),
+          receiveTimeNs(CuckooTraceSampled(trace) ? CuckooTraceNowNs() : 0)
     {
     }
     brpc::Controller *GetCntl() { return cntl; }
     const MetaRequest *GetRequest() { return request; }
     Empty *GetResponse() { return response; }
+    const CuckooTraceContext &GetTrace() { return trace; }
+    int64_t GetReceiveTimeNs() { return receiveTimeNs; }
     void Done() { done->Run(); }
 };
 
@@ -42,6 +50,8 @@ class Task {
   public:
     bool isBatch;
     std::vector<cuckoo::meta_proto::AsyncMetaServiceJob *> jobList;
+    /* when the task entered the pending queue, for wait time stats */
+    int64_t enqueueTimeUs = 0;
     Task(int n)
     {
         isBatch = false;
@@ -37,6 +37,7 @@ typedef struct FormData_dfs_inode_table
     TimestampTz st_atim;
     TimestampTz st_mtim;
     TimestampTz st_ctim;
+    /* etag of the data object, or the target of a symlink since a symlink has no data object */
     char etag[128];
     uint64 update_version;
     int32 primary_nodeid;
@@ -76,6 +77,7 @@ typedef enum CuckooInodeTableScankeyType
     INODE_TABLE_PARENT_ID_PART_ID_EQ,
     INODE_TABLE_NAME_GT,
     INODE_TABLE_NAME_EQ,
+    INODE_TABLE_ST_INO_EQ,
     LAST_CUCKOO_INODE_TABLE_SCANKEY_TYPE
 } CuckooInodeTableScankeyType;
 
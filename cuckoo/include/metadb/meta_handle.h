@@ -35,6 +35,13 @@ typedef enum CuckooSupportMetaService
     UTIMENS,
     CHOWN,
     CHMOD,
+    SETXATTR,
+    GETXATTR,
+    LISTXATTR,
+    REMOVEXATTR,
+    SYMLINK,
+    READLINK,
+    LINK,
     NOT_SUPPORTED
 } CuckooSupportMetaService;
 
@@ -58,5 +65,12 @@ void CuckooRenameSubCreateHandle(MetaProcessInfo info);
 void CuckooUtimeNsHandle(MetaProcessInfo info);
 void CuckooChownHandle(MetaProcessInfo info);
 void CuckooChmodHandle(MetaProcessInfo info);
+void CuckooSetXattrHandle(MetaProcessInfo *infoArray, int count);
+void CuckooGetXattrHandle(MetaProcessInfo *infoArray, int count);
+void CuckooListXattrHandle(MetaProcessInfo *infoArray, int count);
+void CuckooRemoveXattrHandle(MetaProcessInfo *infoArray, int count);
+void CuckooSymlinkHandle(MetaProcessInfo info);
+void CuckooReadlinkHandle(MetaProcessInfo info);
+void CuckooLinkHandle(MetaProcessInfo info);
 
 #endif
@@ -55,6 +55,15 @@ typedef struct MetaProcessInfoData
     bool            targetIsDirectory;
     int32_t         srcLockOrder;
 
+    //input(or output) for xattr and symlink
+    const char*     xattrKey;
+    const char*     xattrValue;
+    int32_t         xattrValueSize;
+    int32_t         xattrFlags;
+    char**          xattrKeyList;
+    int             xattrKeyCount;
+    const char*     linkTarget;
+
     //output
     CuckooErrorCode errorCode;
     char*           errorMsg;
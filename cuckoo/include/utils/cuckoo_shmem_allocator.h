@@ -8,10 +8,13 @@
 #ifdef __cplusplus
 #include <atomic>
 using std::atomic_uint_fast64_t;
+using std::atomic_uint_least32_t;
 #else
 #include <stdatomic.h>
 #endif
 
+#include "remote_connection_utils/cuckoo_trace.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -35,27 +38,74 @@ typedef union PaddedAtomic64
     char padding[CUCKOO_SHMEM_ALLOCATOR_PAD_SIZE];
 } PaddedAtomic64;
 
+// counters shared by all processes using the allocator, each on its own cache line
+typedef struct CuckooShmemAllocatorCounters
+{
+    PaddedAtomic64 allocCount;
+    PaddedAtomic64 freeCount;
+    PaddedAtomic64 freeListHits;    // allocations served by a size class free list
+    PaddedAtomic64 scannedPages;    // pages probed by allocations that missed the free list
+    PaddedAtomic64 failCount;
+    PaddedAtomic64 allocNs;
+    PaddedAtomic64 allocMaxNs;
+    PaddedAtomic64 requestedBytes;  // sizes asked for by live allocations
+    PaddedAtomic64 usedBytes;       // capacity of live allocations
+} CuckooShmemAllocatorCounters;
+
 typedef struct CuckooShmemAllocator 
 {
     char* shmem;
     uint64_t size;
     uint32_t pageCount;
+    uint32_t summaryWordCount;
 
     //located in shmem
     PaddedAtomic64* signatureCounter;
     PaddedAtomic64* freeListHint;
+    // per size class lock free stack of freed blocks, low 32 bits are block index + 1, high 32 bits an aba tag
+    PaddedAtomic64* freeListHead;
+    PaddedAtomic64* freeListLength;
+    CuckooShmemAllocatorCounters* counters;
+    // one bit per page, set if the page may have a free block, a clear bit means the page is full
+    atomic_uint_fast64_t* nonFullPageSummary;
+    // one bit per page, set if the page may be entirely free
+    atomic_uint_fast64_t* emptyPageSummary;
+    // next link of every 16KB block while it is in a free list, block index + 1 or 0 for the end
+    atomic_uint_least32_t* freeListNext;
     PaddedAtomic64* pageCntlArray;
     char* allocatableSpaceBase;
 } CuckooShmemAllocator;
 
+typedef struct CuckooShmemAllocatorStats
+{
+    uint64_t totalBytes;
+    uint64_t usedBytes;
+    uint64_t requestedBytes;
+    uint64_t cachedBytes;           // freed blocks held by the size class free lists
+    uint64_t freeBytes;
+    uint64_t largestFreeBlock;
+    uint64_t allocCount;
+    uint64_t freeCount;
+    uint64_t freeListHits;
+    uint64_t scannedPages;
+    uint64_t failCount;
+    uint64_t allocNs;
+    uint64_t allocMaxNs;
+} CuckooShmemAllocatorStats;
+
 
 #define CUCKOO_SHMEM_ALLOCATOR_GET_POINTER(allocator, shift) ((allocator)->allocatableSpaceBase + (shift))
 #define CUCKOO_SHMEM_ALLOCATOR_POINTER_GET_SIZE(pointer) (((MemoryHdr*)((char*)(pointer) - sizeof(MemoryHdr)))->size)
 #define CUCKOO_SHMEM_ALLOCATOR_SET_SIGNATURE(pointer, sign) (((MemoryHdr*)((char*)(pointer) - sizeof(MemoryHdr)))->signature = (sign))
 #define CUCKOO_SHMEM_ALLOCATOR_GET_SIGNATURE(pointer) (((MemoryHdr*)((char*)(pointer) - sizeof(MemoryHdr)))->signature)
+#define CUCKOO_SHMEM_ALLOCATOR_SET_TRACE(pointer, context) (((MemoryHdr*)((char*)(pointer) - sizeof(MemoryHdr)))->trace = (context))
+#define CUCKOO_SHMEM_ALLOCATOR_GET_TRACE(pointer) (((MemoryHdr*)((char*)(pointer) - sizeof(MemoryHdr)))->trace)
 
+// attaches to shmem, the first process has to call CuckooShmemAllocatorReset afterwards
 int CuckooShmemAllocatorInit(CuckooShmemAllocator *allocator, char *shmem, uint64_t size);
 
+void CuckooShmemAllocatorReset(CuckooShmemAllocator *allocator);
+
 int64_t CuckooShmemAllocatorGetUniqueSignature(CuckooShmemAllocator *allocator);
 
 typedef struct MemoryHdr 
@@ -63,11 +113,16 @@ typedef struct MemoryHdr
     int64_t signature;
     uint64_t size;
     uint64_t capacity;
+    // trace context of the request a param block belongs to, passed from connection pool to backend
+    CuckooTraceContext trace;
 } MemoryHdr;
 uint64_t CuckooShmemAllocatorMalloc(CuckooShmemAllocator *allocator, uint64_t size);
 
 void CuckooShmemAllocatorFree(CuckooShmemAllocator *allocator, uint64_t shift);
 
+// walks all pages for the largest free block, meant for metrics rather than hot paths
+void CuckooShmemAllocatorGetStats(CuckooShmemAllocator *allocator, CuckooShmemAllocatorStats *stats);
+
 #ifdef __cplusplus
 }
 #endif
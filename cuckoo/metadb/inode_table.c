@@ -29,6 +29,7 @@ void ConstructCreateInodeTableCommand(StringInfo command, const char *name)
                      "primary_nodeid	   int,"
                      "backup_nodeid	   int);"
                      "CREATE UNIQUE INDEX %s_index ON cuckoo.%s USING btree(parentid_partid, name);"
+                     "CREATE INDEX %s_ino_index ON cuckoo.%s USING btree(st_ino);"
                      "ALTER TABLE cuckoo.%s SET SCHEMA pg_catalog;"
                      "GRANT SELECT ON pg_catalog.%s TO public;"
                      "ALTER EXTENSION cuckoo ADD TABLE %s;",
@@ -37,5 +38,7 @@ void ConstructCreateInodeTableCommand(StringInfo command, const char *name)
                      name,
                      name,
                      name,
+                     name,
+                     name,
                      name);
 }
\ No newline at end of file
@@ -24,6 +24,7 @@
 #include "metadb/meta_process_info.h"
 #include "metadb/meta_serialize_interface_helper.h"
 #include "metadb/shard_table.h"
+#include "metadb/xattr_table.h"
 #include "utils/path_parse.h"
 #include "utils/utils_standalone.h"
 
@@ -36,6 +37,7 @@ static inline uint64_t CombineParentIdWithPartId(uint64_t parent_id, uint16_t pa
 
 static StringInfo GetInodeShardName(int shardId);
 static StringInfo GetInodeIndexShardName(int shardId);
+static StringInfo GetInodeInoIndexShardName(int shardId);
 static StringInfo GetXattrShardName(int shardId);
 static StringInfo GetXattrIndexShardName(int shardId);
 
@@ -84,6 +86,19 @@ static bool InsertIntoInodeTable(Relation relation,
                                  uint64_t update_version,
                                  int32_t primaryNodeId,
                                  int32_t backupNodeId);
+static CuckooErrorCode
+ResolvePathOnLocalWorker(const char *path, uint64_t *parentId_partId, char **fileName, int *shardId);
+static bool FileExistsInInodeTable(int shardId, uint64_t parentId_partId, const char *fileName);
+static SysScanDesc
+BeginXattrScan(Relation xattrRel, int shardId, uint64_t parentId_partId, const char *fileName, const char *key);
+static void MoveXattrOfFile(int shardId,
+                            uint64_t parentId_partId,
+                            const char *fileName,
+                            int dstShardId,
+                            uint64_t dstParentIdPartId,
+                            const char *dstName);
+static void UpdateRowsOfInode(uint64_t inodeId, Datum *updateDatumArray, bool *isNullArray, bool *doUpdateArray);
+static void UpdateNlinkOfInode(uint64_t inodeId, uint64_t nlink);
 // mistyped in original video as well
 #define CHECK_ERROR_CODE_WITH_CONTINUE(errCode) \
     if ((errCode) != SUCCESS) {                 \
@@ -985,12 +1000,18 @@ void CuckooUnlinkHandle(MetaProcessInfo *infoArray, int count)
                                                            &info->node_id,
                                                            NULL,
                                                            NULL);
-            if (!fileExist)
+            if (!fileExist) {
                 info->errorCode = FILE_NOT_EXISTS;
-            else if (nlink != 1 || !S_ISREG(mode))
+            } else if (nlink == 0 || !(S_ISREG(mode) || S_ISLNK(mode))) {
                 info->errorCode = PROGRAM_ERROR;
-            else
+            } else {
+                // the row of this name is gone, other hard links of this inode are still alive
+                if (nlink > 1)
+                    UpdateNlinkOfInode(info->inodeId, nlink - 1);
+                MoveXattrOfFile(entry->shardId, info->parentId_partId, info->name, -1, 0, NULL);
+                info->st_nlink = nlink - 1;
                 info->errorCode = SUCCESS;
+            }
         }
     }
 }
@@ -1369,6 +1390,7 @@ void CuckooRmdirSubUnlinkHandle(MetaProcessInfo info)
                                    UINT64_PRINT_SYMBOL ":%s is not existed in inode_table.",
                                    parentId_partId,
                                    name);
+    MoveXattrOfFile(shardId, parentId_partId, name, -1, 0, NULL);
 
     info->errorCode = SUCCESS;
 }
@@ -1663,7 +1685,15 @@ void CuckooRenameSubRenameLocallyHandle(MetaProcessInfo info)
         CommandCounterIncrement();
 
         table_close(dstInodeRel, RowExclusiveLock);
+
+        MoveXattrOfFile(srcShardId,
+                        info->parentId_partId,
+                        info->name,
+                        dstShardId,
+                        info->dstParentIdPartId,
+                        info->dstName);
     } else {
+
         info->inodeId = DatumGetUInt64(fileInfo[Anum_pg_dfs_file_st_ino - 1]);
         info->st_dev = DatumGetUInt64(fileInfo[Anum_pg_dfs_file_st_dev - 1]);
         info->st_mode = DatumGetUInt32(fileInfo[Anum_pg_dfs_file_st_mode - 1]);
@@ -1678,6 +1708,9 @@ void CuckooRenameSubRenameLocallyHandle(MetaProcessInfo info)
         info->st_mtim = DatumGetTimestampTz(fileInfo[Anum_pg_dfs_file_st_mtim - 1]);
         info->st_ctim = DatumGetTimestampTz(fileInfo[Anum_pg_dfs_file_st_ctim - 1]);
         info->node_id = DatumGetInt32(fileInfo[Anum_pg_dfs_file_primary_nodeid - 1]);
+
+        // xattrs are not carried to another worker yet, drop them with the old name
+        MoveXattrOfFile(srcShardId, info->parentId_partId, info->name, -1, 0, NULL);
     }
 
     info->errorCode = SUCCESS;
@@ -1907,6 +1940,408 @@ void CuckooChmodHandle(MetaProcessInfo info)
 
     info->errorCode = SUCCESS;
 }
+/*
+ * Xattr handlers run a batch of requests in one transaction, so a failing request only sets its errorCode and must
+ * not raise an error that would abort the others.
+ */
+void CuckooSetXattrHandle(MetaProcessInfo *infoArray, int count)
+{
+    pg_qsort(infoArray, count, sizeof(MetaProcessInfo), pg_qsort_meta_process_info_by_path_cmp);
+    for (int i = 0; i < count; ++i) {
+        MetaProcessInfo info = infoArray[i];
+        info->errorCode = SUCCESS;
+        info->errorMsg = NULL;
+
+        int32_t property;
+        CuckooErrorCode errorCode = VerifyPathValidity(info->path, 0, &property);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
+        if (info->xattrKey[0] == '\0')
+            CHECK_ERROR_CODE_WITH_CONTINUE(ARGUMENT_ERROR);
+
+        uint64_t parentId_partId;
+        char *fileName;
+        int shardId;
+        errorCode = ResolvePathOnLocalWorker(info->path, &parentId_partId, &fileName, &shardId);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
+        if (!FileExistsInInodeTable(shardId, parentId_partId, fileName))
+            CHECK_ERROR_CODE_WITH_CONTINUE(FILE_NOT_EXISTS);
+
+        StringInfo xattrShardName = GetXattrShardName(shardId);
+        Relation xattrRel = table_open(GetRelationOidByName_CUCKOO(xattrShardName->data), RowExclusiveLock);
+        TupleDesc tupleDesc = RelationGetDescr(xattrRel);
+        SysScanDesc scanDescriptor = BeginXattrScan(xattrRel, shardId, parentId_partId, fileName, info->xattrKey);
+        HeapTuple heapTuple = systable_getnext(scanDescriptor);
+        bool found = HeapTupleIsValid(heapTuple);
+        if (found && (info->xattrFlags & XATTR_CREATE)) {
+            info->errorCode = XKEY_EXISTS;
+        } else if (!found && (info->xattrFlags & XATTR_REPLACE)) {
+            info->errorCode = XKEY_NOT_EXISTS;
+        } else {
+            bytea *value = (bytea *)palloc(VARHDRSZ + info->xattrValueSize);
+            SET_VARSIZE(value, VARHDRSZ + info->xattrValueSize);
+            memcpy(VARDATA(value), info->xattrValue, info->xattrValueSize);
+
+            Datum values[Natts_cuckoo_xattr_table];
+            bool isNulls[Natts_cuckoo_xattr_table];
+            memset(isNulls, false, sizeof(isNulls));
+            if (found) {
+                bool doReplace[Natts_cuckoo_xattr_table];
+                memset(doReplace, false, sizeof(doReplace));
+                values[Anum_cuckoo_xattr_table_xvalue - 1] = PointerGetDatum(value);
+                doReplace[Anum_cuckoo_xattr_table_xvalue - 1] = true;
+                HeapTuple updatedTuple = heap_modify_tuple(heapTuple, tupleDesc, values, isNulls, doReplace);
+                CatalogTupleUpdate(xattrRel, &updatedTuple->t_self, updatedTuple);
+                heap_freetuple(updatedTuple);
+            } else {
+                values[Anum_cuckoo_xattr_table_parentid_partid - 1] = UInt64GetDatum(parentId_partId);
+                values[Anum_cuckoo_xattr_table_name - 1] = CStringGetTextDatum(fileName);
+                values[Anum_cuckoo_xattr_table_xkey - 1] = CStringGetTextDatum(info->xattrKey);
+                values[Anum_cuckoo_xattr_table_xvalue - 1] = PointerGetDatum(value);
+                HeapTuple newTuple = heap_form_tuple(tupleDesc, values, isNulls);
+                CatalogTupleInsert(xattrRel, newTuple);
+                heap_freetuple(newTuple);
+            }
+            CommandCounterIncrement();
+        }
+        systable_endscan(scanDescriptor);
+        table_close(xattrRel, RowExclusiveLock);
+    }
+}
+
+void CuckooGetXattrHandle(MetaProcessInfo *infoArray, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        MetaProcessInfo info = infoArray[i];
+        info->errorCode = SUCCESS;
+        info->errorMsg = NULL;
+
+        int32_t property;
+        CuckooErrorCode errorCode = VerifyPathValidity(info->path, 0, &property);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
+
+        uint64_t parentId_partId;
+        char *fileName;
+        int shardId;
+        errorCode = ResolvePathOnLocalWorker(info->path, &parentId_partId, &fileName, &shardId);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
+
+        StringInfo xattrShardName = GetXattrShardName(shardId);
+        Relation xattrRel = table_open(GetRelationOidByName_CUCKOO(xattrShardName->data), AccessShareLock);
+        SysScanDesc scanDescriptor = BeginXattrScan(xattrRel, shardId, parentId_partId, fileName, info->xattrKey);
+        HeapTuple heapTuple = systable_getnext(scanDescriptor);
+        bool found = HeapTupleIsValid(heapTuple);
+        if (found) {
+            bool isNull;
+            Datum datum =
+                heap_getattr(heapTuple, Anum_cuckoo_xattr_table_xvalue, RelationGetDescr(xattrRel), &isNull);
+            bytea *value = isNull ? NULL : DatumGetByteaPCopy(datum);
+            info->xattrValue = value ? VARDATA(value) : "";
+            info->xattrValueSize = value ? VARSIZE(value) - VARHDRSZ : 0;
+        }
+        systable_endscan(scanDescriptor);
+        table_close(xattrRel, AccessShareLock);
+
+        // missing key is the common answer, the inode is only looked up to tell it from a missing file
+        if (!found)
+            info->errorCode =
+                FileExistsInInodeTable(shardId, parentId_partId, fileName) ? XKEY_NOT_EXISTS : FILE_NOT_EXISTS;
+    }
+}
+
+void CuckooListXattrHandle(MetaProcessInfo *infoArray, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        MetaProcessInfo info = infoArray[i];
+        info->errorCode = SUCCESS;
+        info->errorMsg = NULL;
+
+        int32_t property;
+        CuckooErrorCode errorCode = VerifyPathValidity(info->path, 0, &property);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
+
+        uint64_t parentId_partId;
+        char *fileName;
+        int shardId;
+        errorCode = ResolvePathOnLocalWorker(info->path, &parentId_partId, &fileName, &shardId);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
+        if (!FileExistsInInodeTable(shardId, parentId_partId, fileName))
+            CHECK_ERROR_CODE_WITH_CONTINUE(FILE_NOT_EXISTS);
+
+        StringInfo xattrShardName = GetXattrShardName(shardId);
+        Relation xattrRel = table_open(GetRelationOidByName_CUCKOO(xattrShardName->data), AccessShareLock);
+        TupleDesc tupleDesc = RelationGetDescr(xattrRel);
+        SysScanDesc scanDescriptor = BeginXattrScan(xattrRel, shardId, parentId_partId, fileName, NULL);
+        List *keyList = NIL;
+        HeapTuple heapTuple;
+        while (HeapTupleIsValid(heapTuple = systable_getnext(scanDescriptor))) {
+            bool isNull;
+            Datum key = heap_getattr(heapTuple, Anum_cuckoo_xattr_table_xkey, tupleDesc, &isNull);
+            if (!isNull)
+                keyList = lappend(keyList, TextDatumGetCString(key));
+        }
+        systable_endscan(scanDescriptor);
+        table_close(xattrRel, AccessShareLock);
+
+        info->xattrKeyCount = list_length(keyList);
+        info->xattrKeyList = palloc(sizeof(char *) * (info->xattrKeyCount + 1));
+        for (int j = 0; j < info->xattrKeyCount; ++j)
+            info->xattrKeyList[j] = list_nth(keyList, j);
+    }
+}
+
+void CuckooRemoveXattrHandle(MetaProcessInfo *infoArray, int count)
+{
+    pg_qsort(infoArray, count, sizeof(MetaProcessInfo), pg_qsort_meta_process_info_by_path_cmp);
+    for (int i = 0; i < count; ++i) {
+        MetaProcessInfo info = infoArray[i];
+        info->errorCode = SUCCESS;
+        info->errorMsg = NULL;
+
+        int32_t property;
+        CuckooErrorCode errorCode = VerifyPathValidity(info->path, 0, &property);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
+
+        uint64_t parentId_partId;
+        char *fileName;
+        int shardId;
+        errorCode = ResolvePathOnLocalWorker(info->path, &parentId_partId, &fileName, &shardId);
+        CHECK_ERROR_CODE_WITH_CONTINUE(errorCode);
+
+        StringInfo xattrShardName = GetXattrShardName(shardId);
+        Relation xattrRel = table_open(GetRelationOidByName_CUCKOO(xattrShardName->data), RowExclusiveLock);
+        SysScanDesc scanDescriptor = BeginXattrScan(xattrRel, shardId, parentId_partId, fileName, info->xattrKey);
+        HeapTuple heapTuple = systable_getnext(scanDescriptor);
+        bool found = HeapTupleIsValid(heapTuple);
+        if (found) {
+            CatalogTupleDelete(xattrRel, &heapTuple->t_self);
+            CommandCounterIncrement();
+        }
+        systable_endscan(scanDescriptor);
+        table_close(xattrRel, RowExclusiveLock);
+
+        if (!found)
+            info->errorCode =
+                FileExistsInInodeTable(shardId, parentId_partId, fileName) ? XKEY_NOT_EXISTS : FILE_NOT_EXISTS;
+    }
+}
+
+/*
+ * Symlink is an inode row with S_IFLNK mode. It has no data object, so the etag column, which otherwise names the
+ * version of that object, holds the link target and st_size its length.
+ */
+void CuckooSymlinkHandle(MetaProcessInfo info)
+{
+    int32_t property;
+    CuckooErrorCode errorCode =
+        VerifyPathValidity(info->path, VERIFY_PATH_VALIDITY_REQUIREMENT_MUST_BE_FILE, &property);
+    if (errorCode != SUCCESS)
+        CUCKOO_ELOG_ERROR(errorCode, "path is invalid.");
+    if (info->linkTarget[0] == '\0')
+        CUCKOO_ELOG_ERROR(ARGUMENT_ERROR, "symlink target is empty.");
+
+    uint64_t parentId = 0;
+    uint64_t inodeId = 0;
+    char *fileName;
+    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
+    errorCode = PathParseTreeInsert(NULL,
+                                    directoryRel,
+                                    info->path,
+                                    PATH_PARSE_FLAG_NOT_ROOT | PATH_PARSE_FLAG_TARGET_TO_BE_CREATED,
+                                    &parentId,
+                                    &fileName,
+                                    &inodeId);
+    if (errorCode != SUCCESS)
+        CUCKOO_ELOG_ERROR(errorCode, "path parse error.");
+    table_close(directoryRel, AccessShareLock);
+
+    uint16_t partId = HashPartId(fileName);
+    uint64_t parentId_partId = CombineParentIdWithPartId(parentId, partId);
+    int shardId, workerId;
+    SearchShardInfoByShardValue(parentId_partId, &shardId, &workerId);
+    if (workerId != GetLocalServerId())
+        CUCKOO_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
+
+    if (FileExistsInInodeTable(shardId, parentId_partId, fileName)) {
+        info->errorCode = FILE_EXISTS;
+        return;
+    }
+
+    TimestampTz now = GetCurrentTimestamp();
+    StringInfo inodeShardName = GetInodeShardName(shardId);
+    Relation workerInodeRel = table_open(GetRelationOidByName_CUCKOO(inodeShardName->data), RowExclusiveLock);
+    InsertIntoInodeTable(workerInodeRel,
+                         NULL,
+                         inodeId,
+                         parentId_partId,
+                         fileName,
+                         0,
+                         S_IFLNK | 0777,
+                         1,
+                         0,
+                         0,
+                         0,
+                         strlen(info->linkTarget),
+                         0,
+                         0,
+                         now,
+                         now,
+                         now,
+                         info->linkTarget,
+                         0,
+                         -1,
+                         -1);
+    table_close(workerInodeRel, RowExclusiveLock);
+
+    info->errorCode = SUCCESS;
+}
+
+void CuckooReadlinkHandle(MetaProcessInfo info)
+{
+    int32_t property;
+    CuckooErrorCode errorCode = VerifyPathValidity(info->path, 0, &property);
+    if (errorCode != SUCCESS)
+        CUCKOO_ELOG_ERROR(errorCode, "path verify error.");
+
+    uint64_t parentId_partId;
+    char *fileName;
+    int shardId;
+    errorCode = ResolvePathOnLocalWorker(info->path, &parentId_partId, &fileName, &shardId);
+    if (errorCode != SUCCESS)
+        CUCKOO_ELOG_ERROR(errorCode, "path parse error.");
+
+    SetUpScanCaches();
+    StringInfo inodeShardName = GetInodeShardName(shardId);
+    StringInfo inodeIndexShardName = GetInodeIndexShardName(shardId);
+    ScanKeyData scanKey[2];
+    scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_EQ];
+    scanKey[0].sk_argument = UInt64GetDatum(parentId_partId);
+    scanKey[1] = InodeTableScanKey[INODE_TABLE_NAME_EQ];
+    scanKey[1].sk_argument = CStringGetTextDatum(fileName);
+    Relation workerInodeRel = table_open(GetRelationOidByName_CUCKOO(inodeShardName->data), AccessShareLock);
+    SysScanDesc scanDescriptor = systable_beginscan(workerInodeRel,
+                                                    GetRelationOidByName_CUCKOO(inodeIndexShardName->data),
+                                                    true,
+                                                    GetTransactionSnapshot(),
+                                                    2,
+                                                    scanKey);
+    HeapTuple heapTuple = systable_getnext(scanDescriptor);
+    TupleDesc tupleDesc = RelationGetDescr(workerInodeRel);
+    if (!HeapTupleIsValid(heapTuple))
+        CUCKOO_ELOG_ERROR(FILE_NOT_EXISTS, "file doesn't exist.");
+
+    bool isNull;
+    mode_t mode = DatumGetUInt32(heap_getattr(heapTuple, Anum_pg_dfs_file_st_mode, tupleDesc, &isNull));
+    if (!S_ISLNK(mode))
+        CUCKOO_ELOG_ERROR(ARGUMENT_ERROR, "target is not a symlink.");
+    // etag of a symlink is its target, see CuckooSymlinkHandle
+    info->linkTarget = TextDatumGetCString(heap_getattr(heapTuple, Anum_pg_dfs_file_etag, tupleDesc, &isNull));
+
+    systable_endscan(scanDescriptor);
+    table_close(workerInodeRel, AccessShareLock);
+
+    info->errorCode = SUCCESS;
+}
+
+/*
+ * Hard link of a regular file. Every name of the inode keeps its own row sharing st_ino, so both names must live on
+ * this worker to update nlink of all rows in one transaction.
+ */
+void CuckooLinkHandle(MetaProcessInfo info)
+{
+    const char *srcPath = info->path;
+    const char *dstPath = info->dstPath;
+
+    int32_t srcProperty, dstProperty;
+    CuckooErrorCode errorCode =
+        VerifyPathValidity(srcPath, VERIFY_PATH_VALIDITY_REQUIREMENT_MUST_BE_FILE, &srcProperty);
+    if (errorCode == SUCCESS)
+        errorCode = VerifyPathValidity(dstPath, VERIFY_PATH_VALIDITY_REQUIREMENT_MUST_BE_FILE, &dstProperty);
+    if (errorCode != SUCCESS)
+        CUCKOO_ELOG_ERROR(errorCode, "path is invalid.");
+
+    // 1.
+    uint64_t srcParentId, dstParentId;
+    uint64_t dstInodeId = 0;
+    char *srcName, *dstName;
+    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
+    errorCode =
+        PathParseTreeInsert(NULL, directoryRel, srcPath, PATH_PARSE_FLAG_NOT_ROOT, &srcParentId, &srcName, NULL);
+    if (errorCode != SUCCESS)
+        CUCKOO_ELOG_ERROR(errorCode, "path parse error.");
+    errorCode = PathParseTreeInsert(NULL,
+                                    directoryRel,
+                                    dstPath,
+                                    PATH_PARSE_FLAG_NOT_ROOT | PATH_PARSE_FLAG_TARGET_TO_BE_CREATED |
+                                        PATH_PARSE_FLAG_INODE_ID_FOR_INPUT,
+                                    &dstParentId,
+                                    &dstName,
+                                    &dstInodeId);
+    if (errorCode != SUCCESS)
+        CUCKOO_ELOG_ERROR(errorCode, "path parse error.");
+    table_close(directoryRel, AccessShareLock);
+
+    uint64_t srcParentIdPartId = CombineParentIdWithPartId(srcParentId, HashPartId(srcName));
+    uint64_t dstParentIdPartId = CombineParentIdWithPartId(dstParentId, HashPartId(dstName));
+    int srcShardId, srcWorkerId, dstShardId, dstWorkerId;
+    SearchShardInfoByShardValue(srcParentIdPartId, &srcShardId, &srcWorkerId);
+    SearchShardInfoByShardValue(dstParentIdPartId, &dstShardId, &dstWorkerId);
+    if (srcWorkerId != GetLocalServerId())
+        CUCKOO_ELOG_ERROR(WRONG_WORKER, "wrong worker.");
+    if (dstWorkerId != srcWorkerId)
+        CUCKOO_ELOG_ERROR(CROSS_WORKER_LINK, "src and dst of hard link are on different workers.");
+
+    if (FileExistsInInodeTable(dstShardId, dstParentIdPartId, dstName))
+        CUCKOO_ELOG_ERROR(FILE_EXISTS, "dst already exists.");
+
+    // 2.
+    SetUpScanCaches();
+    StringInfo srcInodeShardName = GetInodeShardName(srcShardId);
+    StringInfo srcInodeIndexShardName = GetInodeIndexShardName(srcShardId);
+    StringInfo dstInodeShardName = GetInodeShardName(dstShardId);
+    ScanKeyData scanKey[2];
+    scanKey[0] = InodeTableScanKey[INODE_TABLE_PARENT_ID_PART_ID_EQ];
+    scanKey[0].sk_argument = UInt64GetDatum(srcParentIdPartId);
+    scanKey[1] = InodeTableScanKey[INODE_TABLE_NAME_EQ];
+    scanKey[1].sk_argument = CStringGetTextDatum(srcName);
+    Relation srcInodeRel = table_open(GetRelationOidByName_CUCKOO(srcInodeShardName->data), RowExclusiveLock);
+    Relation dstInodeRel = table_open(GetRelationOidByName_CUCKOO(dstInodeShardName->data), RowExclusiveLock);
+    SysScanDesc scanDescriptor = systable_beginscan(srcInodeRel,
+                                                    GetRelationOidByName_CUCKOO(srcInodeIndexShardName->data),
+                                                    true,
+                                                    GetTransactionSnapshot(),
+                                                    2,
+                                                    scanKey);
+    HeapTuple heapTuple = systable_getnext(scanDescriptor);
+    TupleDesc tupleDesc = RelationGetDescr(srcInodeRel);
+    if (!HeapTupleIsValid(heapTuple))
+        CUCKOO_ELOG_ERROR(FILE_NOT_EXISTS, "src doesn't exist.");
+
+    Datum fileInfo[Natts_pg_dfs_inode_table];
+    bool fileInfoNulls[Natts_pg_dfs_inode_table];
+    heap_deform_tuple(heapTuple, tupleDesc, fileInfo, fileInfoNulls);
+    if (!S_ISREG(DatumGetUInt32(fileInfo[Anum_pg_dfs_file_st_mode - 1])))
+        CUCKOO_ELOG_ERROR(ARGUMENT_ERROR, "hard link is only supported for regular file.");
+    uint64_t inodeId = DatumGetUInt64(fileInfo[Anum_pg_dfs_file_st_ino - 1]);
+    uint64_t nlink = DatumGetUInt64(fileInfo[Anum_pg_dfs_file_st_nlink - 1]) + 1;
+
+    // 3.
+    fileInfo[Anum_pg_dfs_file_parentid_partid - 1] = UInt64GetDatum(dstParentIdPartId);
+    fileInfo[Anum_pg_dfs_file_name - 1] = CStringGetTextDatum(dstName);
+    fileInfo[Anum_pg_dfs_file_st_nlink - 1] = UInt64GetDatum(nlink);
+    HeapTuple dstTuple = heap_form_tuple(RelationGetDescr(dstInodeRel), fileInfo, fileInfoNulls);
+    CatalogTupleInsert(dstInodeRel, dstTuple);
+    heap_freetuple(dstTuple);
+    CommandCounterIncrement();
+
+    systable_endscan(scanDescriptor);
+    table_close(dstInodeRel, RowExclusiveLock);
+    table_close(srcInodeRel, RowExclusiveLock);
+
+    // 4.
+    UpdateNlinkOfInode(inodeId, nlink);
+
+    info->errorCode = SUCCESS;
+}
 
 static inline uint16_t HashPartId(const char *fileName)
 {
@@ -1936,14 +2371,21 @@ static StringInfo GetInodeIndexShardName(int shardId)
     return inodeIndexShardName;
 }
 
-static StringInfo __attribute__((unused)) GetXattrShardName(int shardId)
+static StringInfo GetInodeInoIndexShardName(int shardId)
+{
+    StringInfo inodeInoIndexShardName = makeStringInfo();
+    appendStringInfo(inodeInoIndexShardName, "%s_%d_%s", InodeTableName, shardId, "ino_index");
+    return inodeInoIndexShardName;
+}
+
+static StringInfo GetXattrShardName(int shardId)
 {
     StringInfo xattrShardName = makeStringInfo();
     appendStringInfo(xattrShardName, "%s_%d", XattrTableName, shardId);
     return xattrShardName;
 }
 
-static StringInfo __attribute__((unused)) GetXattrIndexShardName(int shardId)
+static StringInfo GetXattrIndexShardName(int shardId)
 {
     StringInfo xattrIndexShardName = makeStringInfo();
     appendStringInfo(xattrIndexShardName, "%s_%d_%s", XattrTableName, shardId, "index");
@@ -2048,9 +2490,10 @@ static bool SearchAndUpdateInodeTableInfo(const char *workerInodeRelationName,
     }
     if (nlink) {
         *nlink = DatumGetUInt64(heap_getattr(heapTuple, Anum_pg_dfs_file_st_nlink, tupleDesc, &isNull));
-        if (doUpdate) {
-            if ((*nlink) + nlinkChangeNum == 0) // refcount changes to 0, need remove this inode row
-            {
+        if (doUpdate && nlinkChangeNum != 0) {
+            // every name of an inode has a row of its own, the name going away takes its row with it and the caller
+            // updates the count of the other names
+            if (nlinkChangeNum < 0) {
                 CatalogTupleDelete(workerInodeRel, &heapTuple->t_self);
                 CommandCounterIncrement();
             } else {
@@ -2116,16 +2559,25 @@ static bool SearchAndUpdateInodeTableInfo(const char *workerInodeRelationName,
         needCatalogTupleUpdate = true;
     }
 
+    // hard links of a file are rows of their own sharing st_ino, attributes of the file change in all of them
+    uint64_t linkedInodeId = 0;
     if (doUpdate && needCatalogTupleUpdate) {
-        HeapTuple updatedTuple = heap_modify_tuple(heapTuple, tupleDesc, updateDatumArray, isNullArray, doUpdateArray);
-        CatalogTupleUpdate(workerInodeRel, &updatedTuple->t_self, updatedTuple);
-        CommandCounterIncrement();
+        if (DatumGetUInt64(heap_getattr(heapTuple, Anum_pg_dfs_file_st_nlink, tupleDesc, &isNull)) > 1) {
+            linkedInodeId = DatumGetUInt64(heap_getattr(heapTuple, Anum_pg_dfs_file_st_ino, tupleDesc, &isNull));
+        } else {
+            HeapTuple updatedTuple =
+                heap_modify_tuple(heapTuple, tupleDesc, updateDatumArray, isNullArray, doUpdateArray);
+            CatalogTupleUpdate(workerInodeRel, &updatedTuple->t_self, updatedTuple);
+            CommandCounterIncrement();
+        }
     }
 
     systable_endscan(scanDescriptor);
     if (!workerInodeRelation) {
         table_close(workerInodeRel, doUpdate ? RowExclusiveLock : AccessShareLock);
     }
+    if (linkedInodeId != 0)
+        UpdateRowsOfInode(linkedInodeId, updateDatumArray, isNullArray, doUpdateArray);
     return true;
 }
 
@@ -2187,4 +2639,185 @@ static bool InsertIntoInodeTable(Relation relation,
     heap_freetuple(heapTuple);
     CommandCounterIncrement();
     return true;
-}
\ No newline at end of file
+}
+
+static CuckooErrorCode
+ResolvePathOnLocalWorker(const char *path, uint64_t *parentId_partId, char **fileName, int *shardId)
+{
+    uint64_t parentId = 0;
+    Relation directoryRel = table_open(DirectoryRelationId(), AccessShareLock);
+    CuckooErrorCode errorCode = PathParseTreeInsert(NULL,
+                                                    directoryRel,
+                                                    path,
+                                                    PATH_PARSE_FLAG_ACQUIRE_SHARED_LOCK_IF_TARGET_IS_DIRECTORY,
+                                                    &parentId,
+                                                    fileName,
+                                                    NULL);
+    table_close(directoryRel, AccessShareLock);
+    if (errorCode != SUCCESS)
+        return errorCode;
+
+    uint16_t partId = HashPartId(*fileName);
+    *parentId_partId = CombineParentIdWithPartId(parentId, partId);
+    int workerId;
+    SearchShardInfoByShardValue(*parentId_partId, shardId, &workerId);
+    if (workerId != GetLocalServerId())
+        return WRONG_WORKER;
+    return SUCCESS;
+}
+
+static bool FileExistsInInodeTable(int shardId, uint64_t parentId_partId, const char *fileName)
+{
+    StringInfo inodeShardName = GetInodeShardName(shardId);
+    StringInfo inodeIndexShardName = GetInodeIndexShardName(shardId);
+    return SearchAndUpdateInodeTableInfo(inodeShardName->data,
+                                         NULL,
+                                         inodeIndexShardName->data,
+                                         InvalidOid,
+                                         parentId_partId,
+                                         fileName,
+                                         false,
+                                         NULL,
+                                         NULL,
+                                         NULL,
+                                         NULL,
+                                         NULL,
+                                         0,
+                                         NULL,
+                                         NULL,
+                                         NULL,
+                                         NULL,
+                                         NULL,
+                                         NULL,
+                                         NULL,
+                                         NULL,
+                                         NULL,
+                                         NULL);
+}
+
+/*
+ * Scan xattrs of a file through (parentid_partid, name, xKey) index, all keys are returned if key is NULL
+ */
+static SysScanDesc
+BeginXattrScan(Relation xattrRel, int shardId, uint64_t parentId_partId, const char *fileName, const char *key)
+{
+    SetUpScanCaches();
+    ScanKeyData scanKey[3];
+    int scanKeyCount = key ? 3 : 2;
+    scanKey[0] = XattrTableScanKey[XATTR_TABLE_PARENT_ID_PART_ID_EQ];
+    scanKey[0].sk_argument = UInt64GetDatum(parentId_partId);
+    scanKey[1] = XattrTableScanKey[XATTR_TABLE_NAME_EQ];
+    scanKey[1].sk_argument = CStringGetTextDatum(fileName);
+    if (key) {
+        scanKey[2] = XattrTableScanKey[XATTR_TABLE_XKEY_EQ];
+        scanKey[2].sk_argument = CStringGetTextDatum(key);
+    }
+
+    StringInfo xattrIndexShardName = GetXattrIndexShardName(shardId);
+    return systable_beginscan(xattrRel,
+                              GetRelationOidByName_CUCKOO(xattrIndexShardName->data),
+                              true,
+                              GetTransactionSnapshot(),
+                              scanKeyCount,
+                              scanKey);
+}
+
+/*
+ * Move xattrs of a file to its new name on this worker, or drop them if dstName is NULL
+ */
+static void MoveXattrOfFile(int shardId,
+                            uint64_t parentId_partId,
+                            const char *fileName,
+                            int dstShardId,
+                            uint64_t dstParentIdPartId,
+                            const char *dstName)
+{
+    StringInfo xattrShardName = GetXattrShardName(shardId);
+    Relation xattrRel = table_open(GetRelationOidByName_CUCKOO(xattrShardName->data), RowExclusiveLock);
+    Relation dstXattrRel = NULL;
+    if (dstName != NULL) {
+        StringInfo dstXattrShardName = GetXattrShardName(dstShardId);
+        dstXattrRel = table_open(GetRelationOidByName_CUCKOO(dstXattrShardName->data), RowExclusiveLock);
+    }
+
+    TupleDesc tupleDesc = RelationGetDescr(xattrRel);
+    SysScanDesc scanDescriptor = BeginXattrScan(xattrRel, shardId, parentId_partId, fileName, NULL);
+    HeapTuple heapTuple;
+    while (HeapTupleIsValid(heapTuple = systable_getnext(scanDescriptor))) {
+        if (dstXattrRel != NULL) {
+            Datum values[Natts_cuckoo_xattr_table];
+            bool isNulls[Natts_cuckoo_xattr_table];
+            heap_deform_tuple(heapTuple, tupleDesc, values, isNulls);
+            values[Anum_cuckoo_xattr_table_parentid_partid - 1] = UInt64GetDatum(dstParentIdPartId);
+            values[Anum_cuckoo_xattr_table_name - 1] = CStringGetTextDatum(dstName);
+            HeapTuple newTuple = heap_form_tuple(RelationGetDescr(dstXattrRel), values, isNulls);
+            CatalogTupleInsert(dstXattrRel, newTuple);
+            heap_freetuple(newTuple);
+        }
+        CatalogTupleDelete(xattrRel, &heapTuple->t_self);
+    }
+    systable_endscan(scanDescriptor);
+    CommandCounterIncrement();
+
+    if (dstXattrRel != NULL)
+        table_close(dstXattrRel, RowExclusiveLock);
+    table_close(xattrRel, RowExclusiveLock);
+}
+
+/*
+ * Set nlink of every row sharing st_ino on this worker
+ */
+static void UpdateNlinkOfInode(uint64_t inodeId, uint64_t nlink)
+{
+    Datum updateDatumArray[Natts_pg_dfs_inode_table];
+    bool isNullArray[Natts_pg_dfs_inode_table];
+    bool doUpdateArray[Natts_pg_dfs_inode_table];
+    memset(doUpdateArray, false, sizeof(doUpdateArray));
+    updateDatumArray[Anum_pg_dfs_file_st_nlink - 1] = UInt64GetDatum(nlink);
+    isNullArray[Anum_pg_dfs_file_st_nlink - 1] = false;
+    doUpdateArray[Anum_pg_dfs_file_st_nlink - 1] = true;
+    UpdateRowsOfInode(inodeId, updateDatumArray, isNullArray, doUpdateArray);
+}
+
+/*
+ * Update the columns set in doUpdateArray in every row of inodeId on this worker, one row per name of the inode. They
+ * are found through the st_ino index of each local shard since the names of a hard linked inode may be in any of them.
+ */
+static void UpdateRowsOfInode(uint64_t inodeId, Datum *updateDatumArray, bool *isNullArray, bool *doUpdateArray)
+{
+    SetUpScanCaches();
+    ScanKeyData scanKey = InodeTableScanKey[INODE_TABLE_ST_INO_EQ];
+    scanKey.sk_argument = UInt64GetDatum(inodeId);
+
+    List *shardTableData = GetShardTableData();
+    for (int i = 0; i < list_length(shardTableData); ++i) {
+        int32_t workerId = ((FormData_cuckoo_shard_table *)list_nth(shardTableData, i))->server_id;
+        int32_t shardId = ((FormData_cuckoo_shard_table *)list_nth(shardTableData, i))->range_point;
+        if (workerId != GetLocalServerId())
+            continue;
+
+        StringInfo inodeShardName = GetInodeShardName(shardId);
+        StringInfo inodeInoIndexShardName = GetInodeInoIndexShardName(shardId);
+        Relation workerInodeRel = table_open(GetRelationOidByName_CUCKOO(inodeShardName->data), RowExclusiveLock);
+        TupleDesc tupleDesc = RelationGetDescr(workerInodeRel);
+        SysScanDesc scanDescriptor = systable_beginscan(workerInodeRel,
+                                                        GetRelationOidByName_CUCKOO(inodeInoIndexShardName->data),
+                                                        true,
+                                                        GetTransactionSnapshot(),
+                                                        1,
+                                                        &scanKey);
+        HeapTuple heapTuple;
+        bool updated = false;
+        while (HeapTupleIsValid(heapTuple = systable_getnext(scanDescriptor))) {
+            HeapTuple updatedTuple =
+                heap_modify_tuple(heapTuple, tupleDesc, updateDatumArray, isNullArray, doUpdateArray);
+            CatalogTupleUpdate(workerInodeRel, &updatedTuple->t_self, updatedTuple);
+            heap_freetuple(updatedTuple);
+            updated = true;
+        }
+        systable_endscan(scanDescriptor);
+        if (updated)
+            CommandCounterIncrement();
+        table_close(workerInodeRel, RowExclusiveLock);
+    }
+}
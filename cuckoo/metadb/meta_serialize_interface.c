@@ -20,7 +20,8 @@ static SerializedData MetaProcess(CuckooSupportMetaService metaService, int coun
 {
     if (count != 1 && !(metaService == MKDIR || metaService == MKDIR_SUB_MKDIR || metaService == MKDIR_SUB_CREATE ||
                         metaService == CREATE || metaService == STAT || metaService == OPEN || metaService == CLOSE ||
-                        metaService == UNLINK))
+                        metaService == UNLINK || metaService == SETXATTR || metaService == GETXATTR ||
+                        metaService == LISTXATTR || metaService == REMOVEXATTR))
         CUCKOO_ELOG_ERROR_EXTENDED(ARGUMENT_ERROR, "metaService %d doesn't support batch operation.", metaService);
 
     SerializedData param;
@@ -94,6 +95,27 @@ static SerializedData MetaProcess(CuckooSupportMetaService metaService, int coun
     case CHMOD:
         CuckooChmodHandle(infoArray[0]);
         break;
+    case SETXATTR:
+        CuckooSetXattrHandle(infoArray, count);
+        break;
+    case GETXATTR:
+        CuckooGetXattrHandle(infoArray, count);
+        break;
+    case LISTXATTR:
+        CuckooListXattrHandle(infoArray, count);
+        break;
+    case REMOVEXATTR:
+        CuckooRemoveXattrHandle(infoArray, count);
+        break;
+    case SYMLINK:
+        CuckooSymlinkHandle(infoArray[0]);
+        break;
+    case READLINK:
+        CuckooReadlinkHandle(infoArray[0]);
+        break;
+    case LINK:
+        CuckooLinkHandle(infoArray[0]);
+        break;
     default:
         CUCKOO_ELOG_ERROR_EXTENDED(ARGUMENT_ERROR, "unexpected metaService: %d", metaService);
     }
@@ -120,6 +142,13 @@ Datum cuckoo_meta_call_by_serialized_shmem_internal(PG_FUNCTION_ARGS)
         CUCKOO_ELOG_ERROR(ARGUMENT_ERROR, "paramShmemShift is invalid.");
     char *paramBuffer = CUCKOO_SHMEM_ALLOCATOR_GET_POINTER(allocator, paramShmemShift);
 
+    // only the first call on a param block finds its header, later segments of the same request
+    // run in the same transaction and keep the context until the transaction ends
+    if (CUCKOO_SHMEM_ALLOCATOR_GET_SIGNATURE(paramBuffer) == signature)
+        CuckooTraceSetContext(CUCKOO_SHMEM_ALLOCATOR_GET_TRACE(paramBuffer));
+    CuckooTraceSpan span;
+    CuckooTraceBegin(&span, "meta_process");
+
     SerializedData response = MetaProcess(metaService, count, paramBuffer);
 
     uint64_t responseShmemShift = CuckooShmemAllocatorMalloc(allocator, response.size);
@@ -129,6 +158,7 @@ Datum cuckoo_meta_call_by_serialized_shmem_internal(PG_FUNCTION_ARGS)
     CUCKOO_SHMEM_ALLOCATOR_SET_SIGNATURE(responseBuffer, signature);
     memcpy(responseBuffer, response.buffer, response.size);
 
+    CuckooTraceEnd(&span);
     PG_RETURN_INT64(responseShmemShift);
 }
 
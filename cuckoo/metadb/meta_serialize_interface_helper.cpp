@@ -53,6 +53,20 @@ CuckooSupportMetaService MetaServiceTypeDecode(int32_t type)
         return CuckooSupportMetaService::CHOWN;
     case cuckoo::meta_proto::MetaServiceType::CHMOD:
         return CuckooSupportMetaService::CHMOD;
+    case cuckoo::meta_proto::MetaServiceType::SETXATTR:
+        return CuckooSupportMetaService::SETXATTR;
+    case cuckoo::meta_proto::MetaServiceType::GETXATTR:
+        return CuckooSupportMetaService::GETXATTR;
+    case cuckoo::meta_proto::MetaServiceType::LISTXATTR:
+        return CuckooSupportMetaService::LISTXATTR;
+    case cuckoo::meta_proto::MetaServiceType::REMOVEXATTR:
+        return CuckooSupportMetaService::REMOVEXATTR;
+    case cuckoo::meta_proto::MetaServiceType::SYMLINK:
+        return CuckooSupportMetaService::SYMLINK;
+    case cuckoo::meta_proto::MetaServiceType::READLINK:
+        return CuckooSupportMetaService::READLINK;
+    case cuckoo::meta_proto::MetaServiceType::LINK:
+        return CuckooSupportMetaService::LINK;
     default:
         return CuckooSupportMetaService::NOT_SUPPORTED;
     }
@@ -99,6 +113,20 @@ int32_t MetaServiceTypeEncode(CuckooSupportMetaService metaService)
         return cuckoo::meta_proto::MetaServiceType::CHOWN;
     case CuckooSupportMetaService::CHMOD:
         return cuckoo::meta_proto::MetaServiceType::CHMOD;
+    case CuckooSupportMetaService::SETXATTR:
+        return cuckoo::meta_proto::MetaServiceType::SETXATTR;
+    case CuckooSupportMetaService::GETXATTR:
+        return cuckoo::meta_proto::MetaServiceType::GETXATTR;
+    case CuckooSupportMetaService::LISTXATTR:
+        return cuckoo::meta_proto::MetaServiceType::LISTXATTR;
+    case CuckooSupportMetaService::REMOVEXATTR:
+        return cuckoo::meta_proto::MetaServiceType::REMOVEXATTR;
+    case CuckooSupportMetaService::SYMLINK:
+        return cuckoo::meta_proto::MetaServiceType::SYMLINK;
+    case CuckooSupportMetaService::READLINK:
+        return cuckoo::meta_proto::MetaServiceType::READLINK;
+    case CuckooSupportMetaService::LINK:
+        return cuckoo::meta_proto::MetaServiceType::LINK;
     default:
         return -1;
     }
@@ -297,6 +325,75 @@ bool SerializedDataMetaParamDecode(CuckooSupportMetaService metaService,
             info->st_mode = chmodParam->st_mode();
             break;
         }
+        case CuckooSupportMetaService::SETXATTR: {
+            if (metaParam->param_type() != cuckoo::meta_fbs::AnyMetaParam::AnyMetaParam_SetXattrParam) {
+                printf("[debug] serialized param is corrupt: %s:%d\n", __FILE__, __LINE__);
+                return false;
+            }
+            auto setXattrParam = metaParam->param_as_SetXattrParam();
+            if (setXattrParam->key() == NULL) {
+                printf("[debug] serialized param is corrupt: %s:%d\n", __FILE__, __LINE__);
+                return false;
+            }
+            info->path = setXattrParam->path()->c_str();
+            info->xattrKey = setXattrParam->key()->c_str();
+            info->xattrValue = setXattrParam->value() ? (const char *)setXattrParam->value()->data() : "";
+            info->xattrValueSize = setXattrParam->value() ? setXattrParam->value()->size() : 0;
+            info->xattrFlags = setXattrParam->flags();
+            break;
+        }
+        case CuckooSupportMetaService::GETXATTR: {
+            if (metaParam->param_type() != cuckoo::meta_fbs::AnyMetaParam::AnyMetaParam_GetXattrParam ||
+                metaParam->param_as_GetXattrParam()->key() == NULL) {
+                printf("[debug] serialized param is corrupt: %s:%d\n", __FILE__, __LINE__);
+                return false;
+            }
+            auto getXattrParam = metaParam->param_as_GetXattrParam();
+            info->path = getXattrParam->path()->c_str();
+            info->xattrKey = getXattrParam->key()->c_str();
+            break;
+        }
+        case CuckooSupportMetaService::REMOVEXATTR: {
+            if (metaParam->param_type() != cuckoo::meta_fbs::AnyMetaParam::AnyMetaParam_RemoveXattrParam ||
+                metaParam->param_as_RemoveXattrParam()->key() == NULL) {
+                printf("[debug] serialized param is corrupt: %s:%d\n", __FILE__, __LINE__);
+                return false;
+            }
+            auto removeXattrParam = metaParam->param_as_RemoveXattrParam();
+            info->path = removeXattrParam->path()->c_str();
+            info->xattrKey = removeXattrParam->key()->c_str();
+            break;
+        }
+        case CuckooSupportMetaService::LISTXATTR:
+        case CuckooSupportMetaService::READLINK: {
+            if (metaParam->param_type() != cuckoo::meta_fbs::AnyMetaParam::AnyMetaParam_PathOnlyParam) {
+                printf("[debug] serialized param is corrupt: %s:%d\n", __FILE__, __LINE__);
+                return false;
+            }
+            info->path = metaParam->param_as_PathOnlyParam()->path()->c_str();
+            break;
+        }
+        case CuckooSupportMetaService::SYMLINK: {
+            if (metaParam->param_type() != cuckoo::meta_fbs::AnyMetaParam::AnyMetaParam_SymlinkParam ||
+                metaParam->param_as_SymlinkParam()->target() == NULL) {
+                printf("[debug] serialized param is corrupt: %s:%d\n", __FILE__, __LINE__);
+                return false;
+            }
+            auto symlinkParam = metaParam->param_as_SymlinkParam();
+            info->linkTarget = symlinkParam->target()->c_str();
+            info->path = symlinkParam->path()->c_str();
+            break;
+        }
+        case CuckooSupportMetaService::LINK: {
+            if (metaParam->param_type() != cuckoo::meta_fbs::AnyMetaParam::AnyMetaParam_LinkParam) {
+                printf("[debug] serialized param is corrupt: %s:%d\n", __FILE__, __LINE__);
+                return false;
+            }
+            auto linkParam = metaParam->param_as_LinkParam();
+            info->path = linkParam->src()->c_str();
+            info->dstPath = linkParam->dst()->c_str();
+            break;
+        }
         default:
             printf("[debug] serialized param is corrupt: %s:%d\n", __FILE__, __LINE__);
             return false;
@@ -507,7 +604,11 @@ static bool SerializedDataMetaResponseEncode(CuckooSupportMetaService metaServic
             case CuckooSupportMetaService::RENAME_SUB_CREATE:
             case CuckooSupportMetaService::UTIMENS:
             case CuckooSupportMetaService::CHOWN:
-            case CuckooSupportMetaService::CHMOD: {
+            case CuckooSupportMetaService::CHMOD:
+            case CuckooSupportMetaService::SETXATTR:
+            case CuckooSupportMetaService::REMOVEXATTR:
+            case CuckooSupportMetaService::SYMLINK:
+            case CuckooSupportMetaService::LINK: {
                 // error code only response
                 metaResponse = cuckoo::meta_fbs::CreateMetaResponse(builder, info->errorCode);
                 break;
@@ -579,8 +680,11 @@ static bool SerializedDataMetaResponseEncode(CuckooSupportMetaService metaServic
                 break;
             }
             case CuckooSupportMetaService::UNLINK: {
-                auto unlinkResponse =
-                    cuckoo::meta_fbs::CreateUnlinkResponse(builder, info->inodeId, info->st_size, info->node_id);
+                auto unlinkResponse = cuckoo::meta_fbs::CreateUnlinkResponse(builder,
+                                                                             info->inodeId,
+                                                                             info->st_size,
+                                                                             info->node_id,
+                                                                             info->st_nlink);
                 metaResponse = cuckoo::meta_fbs::CreateMetaResponse(builder,
                                                                     info->errorCode,
                                                                     cuckoo::meta_fbs::AnyMetaResponse_UnlinkResponse,
@@ -612,6 +716,34 @@ static bool SerializedDataMetaResponseEncode(CuckooSupportMetaService metaServic
                                                                     openDirResponse.Union());
                 break;
             }
+            case CuckooSupportMetaService::GETXATTR: {
+                auto value = builder.CreateVector((const uint8_t *)info->xattrValue, info->xattrValueSize);
+                auto getXattrResponse = cuckoo::meta_fbs::CreateGetXattrResponse(builder, value);
+                metaResponse = cuckoo::meta_fbs::CreateMetaResponse(builder,
+                                                                    info->errorCode,
+                                                                    cuckoo::meta_fbs::AnyMetaResponse_GetXattrResponse,
+                                                                    getXattrResponse.Union());
+                break;
+            }
+            case CuckooSupportMetaService::LISTXATTR: {
+                std::vector<flatbuffers::Offset<flatbuffers::String>> keyList;
+                for (int j = 0; j < info->xattrKeyCount; ++j)
+                    keyList.push_back(builder.CreateString(info->xattrKeyList[j]));
+                auto listXattrResponse = cuckoo::meta_fbs::CreateListXattrResponseDirect(builder, &keyList);
+                metaResponse = cuckoo::meta_fbs::CreateMetaResponse(builder,
+                                                                    info->errorCode,
+                                                                    cuckoo::meta_fbs::AnyMetaResponse_ListXattrResponse,
+                                                                    listXattrResponse.Union());
+                break;
+            }
+            case CuckooSupportMetaService::READLINK: {
+                auto readlinkResponse = cuckoo::meta_fbs::CreateReadlinkResponseDirect(builder, info->linkTarget);
+                metaResponse = cuckoo::meta_fbs::CreateMetaResponse(builder,
+                                                                    info->errorCode,
+                                                                    cuckoo::meta_fbs::AnyMetaResponse_ReadlinkResponse,
+                                                                    readlinkResponse.Union());
+                break;
+            }
             case CuckooSupportMetaService::RENAME_SUB_RENAME_LOCALLY: {
                 if (info->parentId_partId != 0 && info->dstParentIdPartId == 0) {
                     auto renameSubRenameLocallyResponse =
@@ -14,7 +14,7 @@ void ConstructCreateXattrTableCommand(StringInfo command, const char *name)
                      "CREATE TABLE cuckoo.%s(parentid_partid bigint,"
                      "name text,"
                      "xKey text,"
-                     "xValue text);"
+                     "xValue bytea);"
                      "CREATE UNIQUE INDEX %s_index ON cuckoo.%s USING btree(parentid_partid, name, xKey);"
                      "ALTER TABLE cuckoo.%s SET SCHEMA pg_catalog;"
                      "GRANT SELECT ON pg_catalog.%s TO public;"
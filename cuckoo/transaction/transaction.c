@@ -20,6 +20,7 @@
 #include "distributed_backend/remote_comm.h"
 #include "distributed_backend/remote_comm_cuckoo.h"
 #include "metadb/foreign_server.h"
+#include "remote_connection_utils/cuckoo_trace.h"
 #include "transaction/transaction_cleanup.h"
 #include "utils/error_log.h"
 #include "utils/path_parse.h"
@@ -33,6 +34,13 @@ static void CuckooTransactionCallback(XactEvent event, void *args);
 char PreparedTransactionGid[MAX_TRANSACTION_GID_LENGTH + 1];
 char RemoteTransactionGid[MAX_TRANSACTION_GID_LENGTH + 1];
 
+// the trace of a request ends with its transaction, also when an error skipped the end of its spans
+static void ClearTraceContext()
+{
+    CuckooTraceContext none = {0, 0};
+    CuckooTraceSetContext(none);
+}
+
 static void ClearRemoteTransactionGid()
 {
     if (RemoteTransactionGid[0] != '\0') {
@@ -143,17 +151,24 @@ static void CuckooTransactionCallback(XactEvent event, void *args)
 {
     switch (event) {
     case XACT_EVENT_PRE_COMMIT: {
+        CuckooTraceSpan span;
+        CuckooTraceBegin(&span, "remote_prepare");
         CuckooRemoteCommandPrepare();
+        CuckooTraceEnd(&span);
         break;
     }
     case XACT_EVENT_COMMIT: {
+        CuckooTraceSpan span;
+        CuckooTraceBegin(&span, "remote_commit");
         CuckooRemoteCommandCommit();
+        CuckooTraceEnd(&span);
 
         TransactionLevelPathParseReset();
         CommitForDirPathHash();
         RWLockReleaseAll(false);
         ClearRemoteTransactionGid();
         ClearRemoteConnectionCommand();
+        ClearTraceContext();
         break;
     }
     case XACT_EVENT_ABORT: {
@@ -168,6 +183,7 @@ static void CuckooTransactionCallback(XactEvent event, void *args)
         ClearRemoteConnectionCommand();
         if (cuckooExplicitTransactionState == CUCKOO_EXPLICIT_TRANSACTION_BEGIN)
             CuckooExplicitTransactionRollback();
+        ClearTraceContext();
 
         CuckooQuitAbortProgress();
         break;
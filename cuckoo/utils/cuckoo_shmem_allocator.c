@@ -6,26 +6,79 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include <inttypes.h>
 
+/*
+ * Blocks of 16KB to 1MB are carved out of 1MB pages, the state of every 16KB block of a page is one bit
+ * of the page bitmap. A freed block first goes to the lock free stack of its size class and is handed
+ * out again from there in O(1). Only when the stack of a class is empty the pages are scanned, using
+ * the page summaries to skip full pages 64 at a time. The stacks are bounded, so most memory stays
+ * in the bitmaps where buddies merge again, and they are drained back into the bitmaps when a scan
+ * finds nothing.
+ */
+
+#define SUMMARY_BITS                64
+#define FREE_LIST_INDEX_MASK        0xFFFFFFFFULL
+#define FREE_LIST_TAG_ONE           (FREE_LIST_INDEX_MASK + 1)
+// each size class caches at most this share of the pages in its free list
+#define FREE_LIST_SHARE_SHIFT       4
+
+static inline uint64_t ControlSize(uint32_t pageCount)
+{
+    uint64_t summaryWordCount = (pageCount + SUMMARY_BITS - 1) / SUMMARY_BITS;
+    uint64_t indexSize = sizeof(atomic_uint_fast64_t) * summaryWordCount * 2 +
+                         sizeof(atomic_uint_least32_t) * pageCount * CUCKOO_SHMEM_ALLOCATOR_STATE_BIT_COUNT;
+    // keep the allocatable space aligned to the pad size
+    indexSize = (indexSize + CUCKOO_SHMEM_ALLOCATOR_PAD_SIZE - 1) / CUCKOO_SHMEM_ALLOCATOR_PAD_SIZE *
+                CUCKOO_SHMEM_ALLOCATOR_PAD_SIZE;
+    return sizeof(PaddedAtomic64) * (1 + CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT * 3) +
+           sizeof(CuckooShmemAllocatorCounters) + indexSize + sizeof(PaddedAtomic64) * (uint64_t)pageCount;
+}
+
 int CuckooShmemAllocatorInit(CuckooShmemAllocator *allocator, char *shmem, uint64_t size)
 {
-    uint32_t pageCount = (size - sizeof(PaddedAtomic64) * (1 + CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT)) /
-                         (sizeof(PaddedAtomic64) + CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE);
+    uint64_t fixedSize = ControlSize(0);
+    if (size <= fixedSize)
+        return -1;
+    uint32_t pageCount = (size - fixedSize) / (sizeof(PaddedAtomic64) + CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE);
+    while (pageCount > 0 && ControlSize(pageCount) + (uint64_t)pageCount * CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE > size)
+        --pageCount;
     if (pageCount == 0)
         return -1;
 
     allocator->shmem = shmem;
     allocator->size = size;
     allocator->pageCount = pageCount;
+    allocator->summaryWordCount = (pageCount + SUMMARY_BITS - 1) / SUMMARY_BITS;
 
     allocator->signatureCounter = (PaddedAtomic64 *)shmem;
     allocator->freeListHint = allocator->signatureCounter + 1;
-    allocator->pageCntlArray = allocator->freeListHint + CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT;
+    allocator->freeListHead = allocator->freeListHint + CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT;
+    allocator->freeListLength = allocator->freeListHead + CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT;
+    allocator->counters =
+        (CuckooShmemAllocatorCounters *)(allocator->freeListLength + CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT);
+    allocator->nonFullPageSummary = (atomic_uint_fast64_t *)(allocator->counters + 1);
+    allocator->emptyPageSummary = allocator->nonFullPageSummary + allocator->summaryWordCount;
+    allocator->freeListNext = (atomic_uint_least32_t *)(allocator->emptyPageSummary + allocator->summaryWordCount);
+    allocator->pageCntlArray =
+        (PaddedAtomic64 *)(shmem + ControlSize(pageCount) - sizeof(PaddedAtomic64) * (uint64_t)pageCount);
     allocator->allocatableSpaceBase = (char *)(allocator->pageCntlArray + pageCount);
     return 0;
 }
 
+void CuckooShmemAllocatorReset(CuckooShmemAllocator *allocator)
+{
+    memset(allocator->shmem, 0, allocator->allocatableSpaceBase - allocator->shmem);
+    for (uint32_t word = 0; word < allocator->summaryWordCount; ++word) {
+        uint32_t pagesInWord = allocator->pageCount - word * SUMMARY_BITS;
+        uint64_t bits = pagesInWord >= SUMMARY_BITS ? ~(uint64_t)0 : (((uint64_t)1 << pagesInWord) - 1);
+        atomic_store_explicit(&allocator->nonFullPageSummary[word], bits, memory_order_relaxed);
+        atomic_store_explicit(&allocator->emptyPageSummary[word], bits, memory_order_relaxed);
+    }
+}
+
 int64_t CuckooShmemAllocatorGetUniqueSignature(CuckooShmemAllocator *allocator)
 {
     return (int64_t)atomic_fetch_add_explicit(&allocator->signatureCounter->data, 1, memory_order_relaxed) + 1;
@@ -42,6 +95,13 @@ static inline uint64_t GetNextPowerOfTwo(uint64_t num)
     return ((uint64_t)1 << (64 - __builtin_clzll(num - 1)));
 }
 
+static inline uint64_t NowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
 static uint64_t LevelBlockMask[CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT] = {0x0000000000000001,
                                                                           0x0000000100000001,
                                                                           0x0001000100010001,
@@ -57,6 +117,195 @@ static uint64_t LevelBlockOccupyBitMap[CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT] =
                                                                                   0x0000000000000003,
                                                                                   0x0000000000000001};
 
+// one bit per block of the level at the position of its first 16KB block, set if any part is used
+static inline uint64_t LevelBitmap(uint64_t bitmap, int level)
+{
+    int shift = 1;
+    for (int j = CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT - 1; j > level; --j) {
+        bitmap = ((bitmap >> shift) | bitmap) & LevelBlockMask[j - 1];
+        shift <<= 1;
+    }
+    return bitmap;
+}
+
+static inline void SummarySet(atomic_uint_fast64_t *summary, uint64_t pageNo)
+{
+    atomic_fetch_or_explicit(&summary[pageNo / SUMMARY_BITS], (uint64_t)1 << (pageNo % SUMMARY_BITS),
+                             memory_order_seq_cst);
+}
+
+// clears the bit of a page, then sets it again if a concurrent free made the claim wrong in between
+static inline void SummaryClear(CuckooShmemAllocator *allocator, uint64_t pageNo, bool empty)
+{
+    atomic_uint_fast64_t *summary = empty ? allocator->emptyPageSummary : allocator->nonFullPageSummary;
+    atomic_fetch_and_explicit(&summary[pageNo / SUMMARY_BITS], ~((uint64_t)1 << (pageNo % SUMMARY_BITS)),
+                              memory_order_seq_cst);
+    uint64_t bitmap = atomic_load_explicit(&allocator->pageCntlArray[pageNo].data, memory_order_seq_cst);
+    if (empty ? bitmap == 0 : bitmap != ~(uint64_t)0)
+        SummarySet(summary, pageNo);
+}
+
+static inline void StatsMax(PaddedAtomic64 *counter, uint64_t value)
+{
+    uint64_t current = atomic_load_explicit(&counter->data, memory_order_relaxed);
+    while (value > current &&
+           !atomic_compare_exchange_weak_explicit(&counter->data, &current, value, memory_order_relaxed,
+                                                  memory_order_relaxed))
+        ;
+}
+
+static void FreeListPush(CuckooShmemAllocator *allocator, int level, uint64_t blockShift)
+{
+    uint64_t blockNo = blockShift / CUCKOO_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE;
+    uint64_t head = atomic_load_explicit(&allocator->freeListHead[level].data, memory_order_relaxed);
+    uint64_t desired;
+    do {
+        atomic_store_explicit(&allocator->freeListNext[blockNo], head & FREE_LIST_INDEX_MASK, memory_order_relaxed);
+        desired = ((head & ~FREE_LIST_INDEX_MASK) + FREE_LIST_TAG_ONE) | (blockNo + 1);
+    } while (!atomic_compare_exchange_weak_explicit(&allocator->freeListHead[level].data, &head, desired,
+                                                    memory_order_release, memory_order_relaxed));
+}
+
+// returns the shift of the block, or UINT64_MAX if the list is empty
+static uint64_t FreeListPop(CuckooShmemAllocator *allocator, int level)
+{
+    uint64_t head = atomic_load_explicit(&allocator->freeListHead[level].data, memory_order_acquire);
+    while (true) {
+        uint64_t index = head & FREE_LIST_INDEX_MASK;
+        if (index == 0)
+            return UINT64_MAX;
+        // the block may be popped and pushed again meanwhile, the tag then fails the exchange below
+        uint64_t next = atomic_load_explicit(&allocator->freeListNext[index - 1], memory_order_relaxed);
+        uint64_t desired = ((head & ~FREE_LIST_INDEX_MASK) + FREE_LIST_TAG_ONE) | next;
+        if (atomic_compare_exchange_weak_explicit(&allocator->freeListHead[level].data, &head, desired,
+                                                  memory_order_acquire, memory_order_acquire)) {
+            atomic_fetch_sub_explicit(&allocator->freeListLength[level].data, 1, memory_order_relaxed);
+            return (index - 1) * CUCKOO_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE;
+        }
+    }
+}
+
+static inline uint64_t FreeListLimit(CuckooShmemAllocator *allocator, int level)
+{
+    uint64_t blocksPerPage = (uint64_t)1 << level;
+    uint64_t limit = ((uint64_t)allocator->pageCount * blocksPerPage) >> FREE_LIST_SHARE_SHIFT;
+    return limit > 0 ? limit : 1;
+}
+
+// clears the bits of a block in its page bitmap
+static void ReleaseBlock(CuckooShmemAllocator *allocator, int level, uint64_t blockShift)
+{
+    uint64_t pageNo = blockShift / CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE;
+    uint32_t blockNo = blockShift / CUCKOO_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE - pageNo * CUCKOO_SHMEM_ALLOCATOR_STATE_BIT_COUNT;
+    uint64_t occupyBitmap = LevelBlockOccupyBitMap[level] << blockNo;
+    uint64_t before =
+        atomic_fetch_and_explicit(&allocator->pageCntlArray[pageNo].data, ~occupyBitmap, memory_order_seq_cst);
+    SummarySet(allocator->nonFullPageSummary, pageNo);
+    if ((before & ~occupyBitmap) == 0)
+        SummarySet(allocator->emptyPageSummary, pageNo);
+
+    // Renew freeListHint, Maybe this block will be fetch by others immediately before we change
+    // freelistHine, but that doesn't matter
+    uint64_t freeHint = atomic_load_explicit(&allocator->freeListHint[level].data, memory_order_relaxed);
+    while (true) {
+        if (freeHint <= pageNo) // do nothing as unnecessary
+            break;
+        if (atomic_compare_exchange_weak_explicit(&allocator->freeListHint[level].data,
+                                                  &freeHint,
+                                                  pageNo,
+                                                  memory_order_relaxed,
+                                                  memory_order_relaxed))
+            break;
+    }
+}
+
+// tries to take a block of the level from one page, returns its shift or UINT64_MAX
+static uint64_t AllocateInPage(CuckooShmemAllocator *allocator, int level, uint64_t requiredSize, uint64_t pageNo)
+{
+    uint64_t expected = atomic_load_explicit(&allocator->pageCntlArray[pageNo].data, memory_order_relaxed);
+    while (true) {
+        uint64_t desired;
+        uint64_t allocatedShift;
+        if (level == 0) {
+            if (expected != 0) { // some blocks of this page is used
+                SummaryClear(allocator, pageNo, true);
+                return UINT64_MAX;
+            }
+            desired = ~(uint64_t)0;
+            allocatedShift = CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE * pageNo;
+        } else {
+            if (expected == ~(uint64_t)0) {
+                SummaryClear(allocator, pageNo, false);
+                return UINT64_MAX;
+            }
+            uint64_t bitmap = LevelBitmap(expected, level);
+            if (bitmap == LevelBlockMask[level]) // all of the blocks in this level is used
+                return UINT64_MAX;
+            int firstEmptyBlockInLevel = __builtin_ctzll(~bitmap & LevelBlockMask[level]);
+            allocatedShift = CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE * pageNo +
+                             CUCKOO_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE * firstEmptyBlockInLevel;
+            desired = expected | (LevelBlockOccupyBitMap[level] << firstEmptyBlockInLevel);
+        }
+
+        if (atomic_compare_exchange_strong_explicit(&allocator->pageCntlArray[pageNo].data,
+                                                    &expected,
+                                                    desired,
+                                                    memory_order_seq_cst,
+                                                    memory_order_relaxed)) {
+            if (expected == 0)
+                SummaryClear(allocator, pageNo, true);
+            if (desired == ~(uint64_t)0)
+                SummaryClear(allocator, pageNo, false);
+            // the hint is only where scans start, a stale value costs a few probes
+            bool pageIsFull = allocatedShift + requiredSize == CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE * (pageNo + 1);
+            atomic_store_explicit(&allocator->freeListHint[level].data,
+                                  pageIsFull ? pageNo + 1 : pageNo,
+                                  memory_order_relaxed);
+            return allocatedShift;
+        }
+    }
+}
+
+// scans the pages the summary marks as candidates, from the hint to the end and then from the start
+static uint64_t ScanPages(CuckooShmemAllocator *allocator, int level, uint64_t requiredSize, uint64_t *scannedPages)
+{
+    atomic_uint_fast64_t *summary = level == 0 ? allocator->emptyPageSummary : allocator->nonFullPageSummary;
+    uint64_t start = atomic_load_explicit(&allocator->freeListHint[level].data, memory_order_relaxed);
+    if (start >= allocator->pageCount)
+        start = 0;
+
+    for (int scan = 0; scan < 2; scan++) {
+        uint64_t firstPage = scan == 0 ? start : 0;
+        uint64_t endPage = scan == 0 ? allocator->pageCount : start;
+        for (uint64_t word = firstPage / SUMMARY_BITS; word * SUMMARY_BITS < endPage; ++word) {
+            uint64_t candidates = atomic_load_explicit(&summary[word], memory_order_relaxed);
+            if (word == firstPage / SUMMARY_BITS)
+                candidates &= ~(uint64_t)0 << (firstPage % SUMMARY_BITS);
+            while (candidates != 0) {
+                uint64_t pageNo = word * SUMMARY_BITS + __builtin_ctzll(candidates);
+                if (pageNo >= endPage)
+                    break;
+                ++*scannedPages;
+                uint64_t allocatedShift = AllocateInPage(allocator, level, requiredSize, pageNo);
+                if (allocatedShift != UINT64_MAX)
+                    return allocatedShift;
+                candidates &= candidates - 1;
+            }
+        }
+    }
+    return UINT64_MAX;
+}
+
+// returns the blocks of all free lists to the bitmaps so they can merge
+static void DrainFreeLists(CuckooShmemAllocator *allocator)
+{
+    for (int level = 0; level < CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT; ++level) {
+        uint64_t blockShift;
+        while ((blockShift = FreeListPop(allocator, level)) != UINT64_MAX)
+            ReleaseBlock(allocator, level, blockShift);
+    }
+}
+
 uint64_t CuckooShmemAllocatorMalloc(CuckooShmemAllocator *allocator, uint64_t size)
 {
     if (size > CUCKOO_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE - sizeof(MemoryHdr))
@@ -66,6 +315,7 @@ uint64_t CuckooShmemAllocatorMalloc(CuckooShmemAllocator *allocator, uint64_t si
         return 0; // valid shift of allocated buffer cannot be zero, since there must be a memory head before it
     }
 
+    uint64_t startNs = NowNs();
     uint64_t requiredSize = size + sizeof(MemoryHdr);
     if (requiredSize < CUCKOO_SHMEM_ALLOCATOR_MIN_SUPPORT_ALLOC_SIZE)
         requiredSize = CUCKOO_SHMEM_ALLOCATOR_MIN_SUPPORT_ALLOC_SIZE;
@@ -74,110 +324,40 @@ uint64_t CuckooShmemAllocatorMalloc(CuckooShmemAllocator *allocator, uint64_t si
 
     int level = __builtin_ctzll(CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE) - __builtin_ctzll(requiredSize);
 
-    for (int scan = 0; scan < 2; scan++) {
-        uint64_t start;
-        if (scan == 0) {
-            // first scan: scan from freeListHint
-            start = atomic_load_explicit(&allocator->freeListHint[level].data, memory_order_relaxed);
-        } else {
-            // second scan: scan from begin
-            start = 0;
+    CuckooShmemAllocatorCounters *counters = allocator->counters;
+    uint64_t scannedPages = 0;
+    uint64_t allocatedShift = FreeListPop(allocator, level);
+    if (allocatedShift != UINT64_MAX) {
+        atomic_fetch_add_explicit(&counters->freeListHits.data, 1, memory_order_relaxed);
+    } else {
+        allocatedShift = ScanPages(allocator, level, requiredSize, &scannedPages);
+        if (allocatedShift == UINT64_MAX) {
+            DrainFreeLists(allocator);
+            allocatedShift = ScanPages(allocator, level, requiredSize, &scannedPages);
         }
+        atomic_fetch_add_explicit(&counters->scannedPages.data, scannedPages, memory_order_relaxed);
+    }
+    if (allocatedShift == UINT64_MAX) {
+        atomic_fetch_add_explicit(&counters->failCount.data, 1, memory_order_relaxed);
+        printf("CuckooShmemAllocatorMalloc: Cannot find a segment.");
+        fflush(stdout);
+        return 0;
+    }
 
-        for (uint32_t pageNo = start; pageNo < allocator->pageCount; ++pageNo) {
-            uint64_t bitmap = atomic_load_explicit(&allocator->pageCntlArray[pageNo].data, memory_order_relaxed);
-
-            uint64_t allocatedShift = -1;
-            bool succeed = false;
-            bool pageIsFull = false;
-            while (true) {
-                uint64_t expected;
-                uint64_t desired;
-                if (level == 0) {
-                    if (bitmap != 0) // some blocks of this page is used
-                        break;
-                    expected = 0;
-                    desired = ~(uint64_t)0;
-                    allocatedShift = CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE * pageNo;
-                } else {
-                    expected = bitmap;
-
-                    // Shift several time to get the bitmap of corresponding level
-                    int shift = 1;
-                    for (int j = CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT - 1; j > level; --j) {
-                        bitmap = ((bitmap >> shift) | bitmap) & LevelBlockMask[j - 1];
-                        shift <<= 1;
-                    }
-
-                    if (bitmap == LevelBlockMask[level]) // all of the blocks in this level is used
-                        break;
-
-                    int firstEmptyBlockInLevel = __builtin_ctzll(~bitmap & LevelBlockMask[level]);
-                    allocatedShift = CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE * pageNo +
-                                     CUCKOO_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE * firstEmptyBlockInLevel;
-                    if (allocatedShift + requiredSize == CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE)
-                        pageIsFull = true;
-                    desired = expected | (LevelBlockOccupyBitMap[level] << firstEmptyBlockInLevel);
-                }
-
-                if (atomic_compare_exchange_strong_explicit(&allocator->pageCntlArray[pageNo].data,
-                                                            &expected,
-                                                            desired,
-                                                            memory_order_relaxed,
-                                                            memory_order_relaxed)) {
-                    succeed = true;
-
-                    if (scan == 0) {
-                        if (pageIsFull || pageNo != start) {
-                            // Renew freelistHint if it is not changed, If freellstuint is changed by others,
-                            // we don't try to change it, since the process changed freelistHint may have freed
-                            // a block, as a result the freelistHint is pointing to a free block as expected.
-                            atomic_compare_exchange_strong_explicit(&allocator->freeListHint[level].data,
-                                                                    &start,
-                                                                    pageIsFull ? pageNo + 1 : pageNo,
-                                                                    memory_order_relaxed,
-                                                                    memory_order_relaxed);
-                        }
-                    } else {
-                        if (!pageIsFull) {
-                            uint64_t freeHint =
-                                atomic_load_explicit(&allocator->freeListHint[level].data, memory_order_relaxed);
-                            while (true) {
-                                if (freeHint <= pageNo) // do nothing as unnecessary
-                                    break;
-                                if (atomic_compare_exchange_weak_explicit(&allocator->freeListHint[level].data,
-                                                                          &freeHint,
-                                                                          pageNo,
-                                                                          memory_order_relaxed,
-                                                                          memory_order_relaxed))
-                                    break;
-                            }
-                        }
-                    }
-
-                    break;
-                }
-                bitmap = expected;
-            }
+    MemoryHdr *hdr = (MemoryHdr *)CUCKOO_SHMEM_ALLOCATOR_GET_POINTER(allocator, allocatedShift);
+    hdr->size = size;
+    hdr->capacity = requiredSize;
+    hdr->signature = 0;
+    hdr->trace.traceId = 0;
+    hdr->trace.spanId = 0;
 
-            if (succeed) {
-                if (allocatedShift == -1)
-                {
-                    printf("unexpected situation in CuckooShmemAllocatorMalloc.");
-                    fflush(stdout);
-                    return 0;
-                }
-                MemoryHdr *hdr = (MemoryHdr *)CUCKOO_SHMEM_ALLOCATOR_GET_POINTER(allocator, allocatedShift);
-                hdr->size = size;
-                hdr->capacity = requiredSize;
-                hdr->signature = 0;
-                return allocatedShift + sizeof(MemoryHdr);
-            }
-        }
-    }
-    printf("CuckooShmemAllocatorMalloc: Cannot find a segment.");
-    fflush(stdout);
-    return 0;
+    uint64_t elapsedNs = NowNs() - startNs;
+    atomic_fetch_add_explicit(&counters->allocCount.data, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->allocNs.data, elapsedNs, memory_order_relaxed);
+    StatsMax(&counters->allocMaxNs, elapsedNs);
+    atomic_fetch_add_explicit(&counters->requestedBytes.data, size, memory_order_relaxed);
+    atomic_fetch_add_explicit(&counters->usedBytes.data, requiredSize, memory_order_relaxed);
+    return allocatedShift + sizeof(MemoryHdr);
 }
 
 void CuckooShmemAllocatorFree(CuckooShmemAllocator *allocator, uint64_t shift)
@@ -192,22 +372,53 @@ void CuckooShmemAllocatorFree(CuckooShmemAllocator *allocator, uint64_t shift)
     if (capacity != (CUCKOO_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE >> level))
         return;
 
-    uint64_t pageNo = shift / CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE;
-    uint32_t blockNo = shift / CUCKOO_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE - pageNo * CUCKOO_SHMEM_ALLOCATOR_STATE_BIT_COUNT;
-    uint64_t occupyBitmap = LevelBlockOccupyBitMap[level] << blockNo;
-    atomic_fetch_and_explicit(&allocator->pageCntlArray[pageNo].data, ~occupyBitmap, memory_order_relaxed);
+    CuckooShmemAllocatorCounters *counters = allocator->counters;
+    atomic_fetch_add_explicit(&counters->freeCount.data, 1, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&counters->requestedBytes.data, hdr->size, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&counters->usedBytes.data, capacity, memory_order_relaxed);
 
-    // Renew freeListHint, Maybe this block will be fetch by others immediately before we change
-    // freelistHine, but that doesn't matter
-    uint64_t freeHint = atomic_load_explicit(&allocator->freeListHint[level].data, memory_order_relaxed);
-    while (true) {
-        if (freeHint <= pageNo) // do nothing as unnecessary
-            break;
-        if (atomic_compare_exchange_weak_explicit(&allocator->freeListHint[level].data,
-                                                  &freeHint,
-                                                  pageNo,
-                                                  memory_order_relaxed,
-                                                  memory_order_relaxed))
+    uint64_t length = atomic_fetch_add_explicit(&allocator->freeListLength[level].data, 1, memory_order_relaxed);
+    if (length < FreeListLimit(allocator, level)) {
+        FreeListPush(allocator, level, shift);
+        return;
+    }
+    atomic_fetch_sub_explicit(&allocator->freeListLength[level].data, 1, memory_order_relaxed);
+    ReleaseBlock(allocator, level, shift);
+}
+
+void CuckooShmemAllocatorGetStats(CuckooShmemAllocator *allocator, CuckooShmemAllocatorStats *stats)
+{
+    CuckooShmemAllocatorCounters *counters = allocator->counters;
+    memset(stats, 0, sizeof(*stats));
+    stats->totalBytes = (uint64_t)allocator->pageCount * CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE;
+    stats->usedBytes = atomic_load_explicit(&counters->usedBytes.data, memory_order_relaxed);
+    stats->requestedBytes = atomic_load_explicit(&counters->requestedBytes.data, memory_order_relaxed);
+    for (int level = 0; level < CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT; ++level) {
+        stats->cachedBytes += atomic_load_explicit(&allocator->freeListLength[level].data, memory_order_relaxed) *
+                              (CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE >> level);
+    }
+    uint64_t taken = stats->usedBytes + stats->cachedBytes;
+    stats->freeBytes = stats->totalBytes > taken ? stats->totalBytes - taken : 0;
+    stats->allocCount = atomic_load_explicit(&counters->allocCount.data, memory_order_relaxed);
+    stats->freeCount = atomic_load_explicit(&counters->freeCount.data, memory_order_relaxed);
+    stats->freeListHits = atomic_load_explicit(&counters->freeListHits.data, memory_order_relaxed);
+    stats->scannedPages = atomic_load_explicit(&counters->scannedPages.data, memory_order_relaxed);
+    stats->failCount = atomic_load_explicit(&counters->failCount.data, memory_order_relaxed);
+    stats->allocNs = atomic_load_explicit(&counters->allocNs.data, memory_order_relaxed);
+    stats->allocMaxNs = atomic_load_explicit(&counters->allocMaxNs.data, memory_order_relaxed);
+
+    for (uint32_t pageNo = 0; pageNo < allocator->pageCount; ++pageNo) {
+        uint64_t bitmap = atomic_load_explicit(&allocator->pageCntlArray[pageNo].data, memory_order_relaxed);
+        for (int level = 0; level < CUCKOO_SHMEM_ALLOCATOR_FREE_LIST_COUNT; ++level) {
+            uint64_t blockSize = CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE >> level;
+            if (blockSize <= stats->largestFreeBlock)
+                break;
+            if (LevelBitmap(bitmap, level) != LevelBlockMask[level]) {
+                stats->largestFreeBlock = blockSize;
+                break;
+            }
+        }
+        if (stats->largestFreeBlock == CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE)
             break;
     }
 }
@@ -0,0 +1,6 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#define CUCKOO_REMOTE_CONNECTION_DEF_CUCKOO_TRACE_IMPLEMENT
+#include "remote_connection_utils/cuckoo_trace.h"
\ No newline at end of file
@@ -156,6 +156,12 @@ static void InitializeInodeTableScanCache(void)
     InodeTableScanKey[INODE_TABLE_NAME_EQ].sk_subtype = TEXTOID;
     InodeTableScanKey[INODE_TABLE_NAME_EQ].sk_collation = DEFAULT_COLLATION_OID;
     InodeTableScanKey[INODE_TABLE_NAME_EQ].sk_attno = Anum_pg_dfs_file_name;
+
+    fmgr_info_cxt(F_INT8EQ, &InodeTableScanKey[INODE_TABLE_ST_INO_EQ].sk_func, ScanCacheMemoryContext);
+    InodeTableScanKey[INODE_TABLE_ST_INO_EQ].sk_strategy = BTEqualStrategyNumber;
+    InodeTableScanKey[INODE_TABLE_ST_INO_EQ].sk_subtype = INT8OID;
+    InodeTableScanKey[INODE_TABLE_ST_INO_EQ].sk_collation = DEFAULT_COLLATION_OID;
+    InodeTableScanKey[INODE_TABLE_ST_INO_EQ].sk_attno = Anum_pg_dfs_file_st_ino;
 }
 
 ScanKeyData InodeTableIndexParentIdPartIdNameScanKey[LAST_CUCKOO_INODE_TABLE_INDEX_PARENT_ID_PART_ID_NAME_SCANKEY_TYPE];
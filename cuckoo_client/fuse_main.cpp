@@ -8,10 +8,14 @@
 #include <securec.h>
 #include <string.h>
 #include <unistd.h>
+#include <algorithm>
 #include <atomic>
 #include <csignal>
+#include <format>
 #include <print>
+#include <string>
 #include <thread>
+#include <vector>
 
 #include <fuse/fuse.h>
 #include <gflags/gflags.h>
@@ -20,8 +24,12 @@
 #include "conf/cuckoo_property_key.h"
 #include "cuckoo_code.h"
 #include "cuckoo_meta.h"
+#include "cuckoo_preload.h"
 #include "error_code.h"
 #include "init/cuckoo_init.h"
+#include "kernel_cache.h"
+#include "log/logging.h"
+#include "remote_connection_utils/cuckoo_trace.h"
 #include "stats/cuckoo_stats.h"
 
 static struct options
@@ -62,7 +70,11 @@ int DoGetAttr(const char *path, struct stat *stbuf)
     }
 
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_getattr", true);
     int ret = CuckooGetStat(path, stbuf);
+    if (ret == 0) {
+        KernelCacheValidator::GetInstance().CheckAttr(path, stbuf);
+    }
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
 
@@ -73,6 +85,7 @@ int DoMkDir(const char *path, mode_t /*mode*/)
     }
     CuckooStats::GetInstance().stats[META_MKDIR].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_mkdir", true);
     int ret = CuckooMkdir(path);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
@@ -84,6 +97,7 @@ int DoOpen(const char *path, struct fuse_file_info *fi)
     }
     CuckooStats::GetInstance().stats[META_OPEN].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_open", true);
     int oflags = fi->flags;
     uint64_t fd = -1;
     struct stat st;
@@ -93,6 +107,13 @@ int DoOpen(const char *path, struct fuse_file_info *fi)
     }
     int ret = CuckooOpen(path, oflags, fd, &st);
     fi->fh = fd;
+    if (ret == 0) {
+        if ((oflags & O_ACCMODE) == O_RDONLY) {
+            fi->keep_cache = KernelCacheValidator::GetInstance().KeepCache(path, &st);
+        } else {
+            KernelCacheValidator::GetInstance().Invalidate(path);
+        }
+    }
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
 
@@ -116,6 +137,13 @@ int DoOpenAtomic(const char *path, struct stat *stbuf, mode_t /*mode*/, struct f
     }
 
     fi->fh = fd;
+    if (ret == SUCCESS) {
+        if ((oflags & O_ACCMODE) == O_RDONLY) {
+            fi->keep_cache = KernelCacheValidator::GetInstance().KeepCache(path, stbuf);
+        } else {
+            KernelCacheValidator::GetInstance().Invalidate(path);
+        }
+    }
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
 
@@ -126,6 +154,7 @@ int DoOpenDir(const char *path, struct fuse_file_info *fi)
     }
     CuckooStats::GetInstance().stats[META_OPENDIR].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_opendir", true);
     auto *ti = (struct CuckooFuseInfo *)fi;
     int ret = CuckooOpenDir(path, ti);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
@@ -138,6 +167,7 @@ int DoReadDir(const char *path, void *buf, fuse_fill_dir_t filler, off_t offset,
     }
     CuckooStats::GetInstance().stats[META_READDIR].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_readdir", true);
     auto *ti = (struct CuckooFuseInfo *)fi;
     int ret = 0;
 
@@ -152,6 +182,7 @@ int DoCreate(const char *path, mode_t /*mode*/, struct fuse_file_info *fi)
     }
     CuckooStats::GetInstance().stats[META_CREATE].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_create", true);
     uint64_t fd = 0;
     int oflags = fi->flags;
     struct stat st;
@@ -161,6 +192,7 @@ int DoCreate(const char *path, mode_t /*mode*/, struct fuse_file_info *fi)
     }
     int ret = CuckooCreate(path, fd, oflags, &st);
     fi->fh = fd;
+    KernelCacheValidator::GetInstance().Invalidate(path);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
 
@@ -171,6 +203,7 @@ int DoAccess(const char *path, int /*mask*/)
     }
     CuckooStats::GetInstance().stats[META_ACCESS].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_access", true);
     return 0;
 }
 
@@ -181,8 +214,13 @@ int DoRelease(const char *path, struct fuse_file_info *fi)
     }
     CuckooStats::GetInstance().stats[META_RELEASE].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_release", true);
     uint64_t fd = fi->fh;
     int ret = CuckooClose(path, fd);
+    /* file may have changed, pages must not be kept on next open */
+    if ((fi->flags & O_ACCMODE) != O_RDONLY) {
+        KernelCacheValidator::GetInstance().Invalidate(path);
+    }
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
 
@@ -193,6 +231,7 @@ int DoReleaseDir(const char *path, struct fuse_file_info *fi)
     }
     CuckooStats::GetInstance().stats[META_RELEASEDIR].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_releasedir", true);
     uint64_t fd = fi->fh;
     int ret = CuckooCloseDir(fd);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
@@ -205,8 +244,10 @@ int DoUnlink(const char *path)
     }
     CuckooStats::GetInstance().stats[META_UNLINK].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_unlink", true);
     int ret;
     ret = CuckooUnlink(path);
+    KernelCacheValidator::GetInstance().Invalidate(path);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
 
@@ -217,6 +258,7 @@ int DoRmDir(const char *path)
     }
     CuckooStats::GetInstance().stats[META_RMDIR].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_rmdir", true);
     int ret;
     ret = CuckooRmDir(path);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
@@ -235,6 +277,7 @@ int DoWrite(const char *path, const char *buffer, size_t size, off_t offset, str
     }
     CuckooStats::GetInstance().stats[FUSE_WRITE_OPS].fetch_add(1);
     StatFuseTimer t(FUSE_WRITE_LAT);
+    CuckooTraceScope trace("fuse_write", true);
     uint ret;
     int64_t fd = fi->fh;
     ret = CuckooWrite(fd, path, buffer, size, offset);
@@ -252,21 +295,297 @@ int DoRead(const char *path, char *buffer, size_t size, off_t offset, struct fus
     }
     CuckooStats::GetInstance().stats[FUSE_READ_OPS].fetch_add(1);
     StatFuseTimer t(FUSE_READ_LAT);
+    CuckooTraceScope trace("fuse_read", true);
     uint64_t fd = fi->fh;
     int retSize = CuckooRead(path, fd, buffer, size, offset);
     CuckooStats::GetInstance().stats[FUSE_READ] += retSize >= 0 ? retSize : 0;
     return retSize;
 }
 
-int DoSetXAttr(const char *path, const char * /*key*/, const char *value, size_t /*size*/, int /*offset*/)
+/*
+ * Locally cached data is returned as fd buffer, so fuse can splice it from the cache file to kernel
+ */
+int DoReadBuf(const char *path, struct fuse_bufvec **bufp, size_t size, off_t offset, struct fuse_file_info *fi)
+{
+    if (path == nullptr || bufp == nullptr || strlen(path) == 0) {
+        return -EINVAL;
+    }
+    CuckooStats::GetInstance().stats[FUSE_READ_OPS].fetch_add(1);
+    StatFuseTimer t(FUSE_READ_LAT);
+    CuckooTraceScope trace("fuse_read_buf", true);
+    uint64_t fd = fi->fh;
+    int localFd = -1;
+    size_t readSize = 0;
+    int ret = CuckooReadFd(path, fd, size, offset, localFd, readSize);
+    if (ret != 0) {
+        return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    }
+
+    /* freed by fuse after reply */
+    auto *src = static_cast<struct fuse_bufvec *>(malloc(sizeof(struct fuse_bufvec)));
+    if (src == nullptr) {
+        return -ENOMEM;
+    }
+    *src = FUSE_BUFVEC_INIT(size);
+
+    if (localFd >= 0) {
+        src->buf[0].flags = static_cast<enum fuse_buf_flags>(FUSE_BUF_IS_FD | FUSE_BUF_FD_SEEK);
+        src->buf[0].fd = localFd;
+        src->buf[0].pos = offset;
+        src->buf[0].size = readSize;
+        CuckooStats::GetInstance().stats[FUSE_READ] += readSize;
+        *bufp = src;
+        return 0;
+    }
+
+    /* small file, remote file or direct io, read into memory */
+    char *buffer = static_cast<char *>(malloc(size));
+    if (buffer == nullptr) {
+        free(src);
+        return -ENOMEM;
+    }
+    int retSize = CuckooRead(path, fd, buffer, size, offset);
+    if (retSize < 0) {
+        free(buffer);
+        free(src);
+        return retSize;
+    }
+    src->buf[0].mem = buffer;
+    src->buf[0].size = retSize;
+    CuckooStats::GetInstance().stats[FUSE_READ] += retSize;
+    *bufp = src;
+    return 0;
+}
+
+/*
+ * Memory buffer from fuse is pushed to write stream directly, fd buffer is copied out first
+ */
+int DoWriteBuf(const char *path, struct fuse_bufvec *buf, off_t offset, struct fuse_file_info *fi)
+{
+    if (path == nullptr || buf == nullptr || strlen(path) == 0) {
+        return -EINVAL;
+    }
+    CuckooStats::GetInstance().stats[FUSE_WRITE_OPS].fetch_add(1);
+    StatFuseTimer t(FUSE_WRITE_LAT);
+    CuckooTraceScope trace("fuse_write_buf", true);
+    int64_t fd = fi->fh;
+    size_t size = fuse_buf_size(buf);
+    const char *buffer = nullptr;
+
+    thread_local std::vector<char> copyBuffer;
+    if (buf->count == 1 && buf->idx == 0 && buf->off == 0 && (buf->buf[0].flags & FUSE_BUF_IS_FD) == 0) {
+        buffer = static_cast<const char *>(buf->buf[0].mem);
+    } else {
+        if (copyBuffer.size() < size) {
+            copyBuffer.resize(size);
+        }
+        struct fuse_bufvec dst = FUSE_BUFVEC_INIT(size);
+        dst.buf[0].mem = copyBuffer.data();
+        ssize_t copied = fuse_buf_copy(&dst, buf, static_cast<enum fuse_buf_copy_flags>(0));
+        if (copied < 0) {
+            return copied;
+        }
+        size = copied;
+        buffer = copyBuffer.data();
+    }
+
+    int ret = CuckooWrite(fd, path, buffer, size, offset);
+    if (ret != 0) {
+        return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    }
+    CuckooStats::GetInstance().stats[FUSE_WRITE] += size;
+    return size;
+}
+
+/*
+ * kernel asks for security.capability before every write to drop file capabilities,
+ * capabilities are not supported so answer it locally instead of a metadata round trip
+ */
+static bool IsCapabilityXAttr(const char *key) { return strcmp(key, "security.capability") == 0; }
+
+/*
+ * setting user.cuckoo.access_trace on the mount root to a file name starts a new access trace there and closes
+ * the running one, removing it stops tracing. So one trace can be cut per job without a remount.
+ */
+#define ACCESS_TRACE_XATTR "user.cuckoo.access_trace"
+
+static bool IsAccessTraceXAttr(const char *path, const char *key)
+{
+    return strcmp(path, "/") == 0 && strcmp(key, ACCESS_TRACE_XATTR) == 0;
+}
+
+/* the trace is written by this process, only its owner and root may point it somewhere */
+static bool MayControlAccessTrace()
+{
+    struct fuse_context *context = fuse_get_context();
+    return context->uid == 0 || context->uid == getuid();
+}
+
+int DoSetXAttr(const char *path, const char *key, const char *value, size_t size, int flags)
+{
+    if (path == nullptr || key == nullptr || strlen(path) == 0 || (value == nullptr && size != 0)) {
+        return -EINVAL;
+    }
+    StatFuseTimer t;
+    CuckooTraceScope trace("fuse_setxattr", true);
+    if (IsCapabilityXAttr(key)) {
+        return -EOPNOTSUPP;
+    }
+    if (IsAccessTraceXAttr(path, key)) {
+        if (!MayControlAccessTrace()) {
+            return -EPERM;
+        }
+        std::string traceFile(value == nullptr ? "" : value, size);
+        if (traceFile.empty() || traceFile[0] != '/') {
+            return -EINVAL;
+        }
+        return CuckooStartAccessTrace(traceFile);
+    }
+    int ret = CuckooSetXattr(path, key, value, size, flags);
+    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+}
+
+int DoGetXAttr(const char *path, const char *key, char *value, size_t size)
 {
-    if (path == nullptr || value == nullptr || strlen(path) == 0) {
+    if (path == nullptr || key == nullptr || strlen(path) == 0) {
         return -EINVAL;
     }
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_getxattr", true);
+    if (IsCapabilityXAttr(key)) {
+        return -ENODATA;
+    }
+    std::string xattrValue;
+    int ret = CuckooGetXattr(path, key, xattrValue);
+    if (ret != 0) {
+        return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    }
+    if (size == 0) {
+        return xattrValue.size();
+    }
+    if (value == nullptr || size < xattrValue.size()) {
+        return -ERANGE;
+    }
+    if (!xattrValue.empty()) {
+        errno_t err = memcpy_s(value, size, xattrValue.data(), xattrValue.size());
+        if (err != EOK) {
+            CUCKOO_LOG(LOG_ERROR) << "Secure func failed: " << err;
+            return -EIO;
+        }
+    }
+    return xattrValue.size();
+}
+
+int DoListXAttr(const char *path, char *list, size_t size)
+{
+    if (path == nullptr || strlen(path) == 0) {
+        return -EINVAL;
+    }
+    StatFuseTimer t;
+    CuckooTraceScope trace("fuse_listxattr", true);
+    std::vector<std::string> keys;
+    int ret = CuckooListXattr(path, keys);
+    if (ret != 0) {
+        return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    }
+    /* keys are returned as a sequence of NUL terminated strings */
+    size_t totalSize = 0;
+    for (auto &key : keys) {
+        totalSize += key.size() + 1;
+    }
+    if (size == 0) {
+        return totalSize;
+    }
+    if (list == nullptr || size < totalSize) {
+        return -ERANGE;
+    }
+    char *pos = list;
+    for (auto &key : keys) {
+        errno_t err = memcpy_s(pos, size - (pos - list), key.c_str(), key.size() + 1);
+        if (err != EOK) {
+            CUCKOO_LOG(LOG_ERROR) << "Secure func failed: " << err;
+            return -EIO;
+        }
+        pos += key.size() + 1;
+    }
+    return totalSize;
+}
+
+int DoRemoveXAttr(const char *path, const char *key)
+{
+    if (path == nullptr || key == nullptr || strlen(path) == 0) {
+        return -EINVAL;
+    }
+    StatFuseTimer t;
+    CuckooTraceScope trace("fuse_removexattr", true);
+    if (IsCapabilityXAttr(key)) {
+        return -ENODATA;
+    }
+    if (IsAccessTraceXAttr(path, key)) {
+        if (!MayControlAccessTrace()) {
+            return -EPERM;
+        }
+        CuckooStopAccessTrace();
+        return 0;
+    }
+    int ret = CuckooRemoveXattr(path, key);
+    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+}
+
+int DoReadlink(const char *path, char *buffer, size_t size)
+{
+    if (path == nullptr || buffer == nullptr || strlen(path) == 0 || size == 0) {
+        return -EINVAL;
+    }
+    StatFuseTimer t;
+    CuckooTraceScope trace("fuse_readlink", true);
+    std::string target;
+    int ret = CuckooReadlink(path, target);
+    if (ret != 0) {
+        return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+    }
+    /* fuse expects a NUL terminated string, truncated if the buffer is too small */
+    size_t copySize = std::min(target.size(), size - 1);
+    if (copySize > 0) {
+        errno_t err = memcpy_s(buffer, size, target.data(), copySize);
+        if (err != EOK) {
+            CUCKOO_LOG(LOG_ERROR) << "Secure func failed: " << err;
+            return -EIO;
+        }
+    }
+    buffer[copySize] = '\0';
     return 0;
 }
 
+int DoSymlink(const char *target, const char *path)
+{
+    if (target == nullptr || path == nullptr || strlen(target) == 0 || strlen(path) == 0) {
+        return -EINVAL;
+    }
+    StatFuseTimer t;
+    CuckooTraceScope trace("fuse_symlink", true);
+    int ret = CuckooSymlink(target, path);
+    KernelCacheValidator::GetInstance().Invalidate(path);
+    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+}
+
+int DoLink(const char *srcPath, const char *dstPath)
+{
+    if (srcPath == nullptr || dstPath == nullptr || strlen(srcPath) == 0 || strlen(dstPath) == 0) {
+        return -EINVAL;
+    }
+    StatFuseTimer t;
+    CuckooTraceScope trace("fuse_link", true);
+    /* objects are keyed by path in persist mode, two names can not share one object */
+    if (g_persist) {
+        return -EOPNOTSUPP;
+    }
+    int ret = CuckooLink(srcPath, dstPath);
+    KernelCacheValidator::GetInstance().Invalidate(srcPath);
+    KernelCacheValidator::GetInstance().Invalidate(dstPath);
+    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+}
+
 int DoTruncate(const char *path, off_t size)
 {
     if (path == nullptr || strlen(path) == 0) {
@@ -274,7 +593,9 @@ int DoTruncate(const char *path, off_t size)
     }
     CuckooStats::GetInstance().stats[META_TRUNCATE].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_truncate", true);
     int ret = CuckooTruncate(std::string(path), size);
+    KernelCacheValidator::GetInstance().Invalidate(path);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
 
@@ -285,7 +606,9 @@ int DoFtruncate(const char *path, off_t size, struct fuse_file_info * /*fi*/)
     }
     CuckooStats::GetInstance().stats[META_TRUNCATE].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_ftruncate", true);
     int ret = CuckooTruncate(std::string(path), size);
+    KernelCacheValidator::GetInstance().Invalidate(path);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
 
@@ -296,6 +619,7 @@ int DoFlush(const char *path, struct fuse_file_info *fi)
     }
     CuckooStats::GetInstance().stats[META_FLUSH].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_flush", true);
     int64_t fd = fi->fh;
     int ret = CuckooClose(path, fd, true);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
@@ -308,12 +632,15 @@ int DoRename(const char *srcPath, const char *dstPath)
     }
     CuckooStats::GetInstance().stats[META_RENAME].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_rename", true);
     int ret = 0;
     if (g_persist) {
         ret = CuckooRenamePersist(srcPath, dstPath);
     } else {
         ret = CuckooRename(srcPath, dstPath);
     }
+    KernelCacheValidator::GetInstance().Invalidate(srcPath);
+    KernelCacheValidator::GetInstance().Invalidate(dstPath);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
 
@@ -324,17 +651,48 @@ int DoFsync(const char *path, int datasync, struct fuse_file_info *fi)
     }
     CuckooStats::GetInstance().stats[META_FSYNC].fetch_add(1);
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_fsync", true);
     uint64_t fd = fi->fh;
     int ret = CuckooFsync(path, fd, datasync);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
 
+/* a waiting lock gives up once the caller is signalled */
+static bool LockInterrupted() { return fuse_interrupted() != 0; }
+
+int DoLock(const char *path, struct fuse_file_info *fi, int cmd, struct flock *lock)
+{
+    if (path == nullptr || lock == nullptr || strlen(path) == 0) {
+        return -EINVAL;
+    }
+    CuckooStats::GetInstance().stats[META_LOCK].fetch_add(1);
+    StatFuseTimer t;
+    CuckooTraceScope trace("fuse_lock", true);
+    uint64_t fd = fi->fh;
+    int ret = CuckooLock(path, fd, cmd, lock, fi->lock_owner, LockInterrupted);
+    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+}
+
+int DoFlock(const char *path, struct fuse_file_info *fi, int op)
+{
+    if (path == nullptr || strlen(path) == 0) {
+        return -EINVAL;
+    }
+    CuckooStats::GetInstance().stats[META_LOCK].fetch_add(1);
+    StatFuseTimer t;
+    CuckooTraceScope trace("fuse_flock", true);
+    uint64_t fd = fi->fh;
+    int ret = CuckooFlock(path, fd, op, fi->lock_owner, LockInterrupted);
+    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+}
+
 int DoStatfs(const char *path, struct statvfs *vfsBuf)
 {
     if (path == nullptr || vfsBuf == nullptr || strlen(path) == 0) {
         return -EINVAL;
     }
     StatFuseTimer t;
+    CuckooTraceScope trace("fuse_statfs", true);
     int ret = CuckooStatFS(vfsBuf);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
@@ -344,12 +702,14 @@ int DoUtimens(const char *path, const struct timespec tv[2])
     if (path == nullptr || strlen(path) == 0) {
         return -EINVAL;
     }
+    CuckooTraceScope trace("fuse_utimens", true);
     int ret = 0;
     if (!tv || tv[0].tv_nsec == UTIME_NOW) {
         ret = CuckooUtimens(path);
     } else {
         ret = CuckooUtimens(path, tv[0].tv_sec, tv[1].tv_sec);
     }
+    KernelCacheValidator::GetInstance().Invalidate(path);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
 
@@ -358,6 +718,7 @@ int DoChmod(const char *path, mode_t mode)
     if (path == nullptr || strlen(path) == 0) {
         return -EINVAL;
     }
+    CuckooTraceScope trace("fuse_chmod", true);
     int ret = CuckooChmod(path, mode);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
@@ -367,21 +728,22 @@ int DoChown(const char *path, uid_t uid, gid_t gid)
     if (path == nullptr || strlen(path) == 0) {
         return -EINVAL;
     }
+    CuckooTraceScope trace("fuse_chown", true);
     int ret = CuckooChown(path, uid, gid);
     return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
 }
 
 static struct fuse_operations cuckooOperations = {
     .getattr = DoGetAttr,
-    .readlink = nullptr,
+    .readlink = DoReadlink,
     .getdir = nullptr,
     .mknod = nullptr,
     .mkdir = DoMkDir,
     .unlink = DoUnlink,
     .rmdir = DoRmDir,
-    .symlink = nullptr,
+    .symlink = DoSymlink,
     .rename = DoRename,
-    .link = nullptr,
+    .link = DoLink,
     .chmod = DoChmod,
     .chown = DoChown,
     .truncate = DoTruncate,
@@ -394,9 +756,9 @@ static struct fuse_operations cuckooOperations = {
     .release = DoRelease,
     .fsync = DoFsync,
     .setxattr = DoSetXAttr,
-    .getxattr = nullptr,
-    .listxattr = nullptr,
-    .removexattr = nullptr,
+    .getxattr = DoGetXAttr,
+    .listxattr = DoListXAttr,
+    .removexattr = DoRemoveXAttr,
     .opendir = DoOpenDir,
     .readdir = DoReadDir,
     .releasedir = DoReleaseDir,
@@ -408,7 +770,7 @@ static struct fuse_operations cuckooOperations = {
     .create = DoCreate,
     .ftruncate = DoFtruncate,
     .fgetattr = nullptr,
-    .lock = nullptr,
+    .lock = DoLock,
     .utimens = DoUtimens,
     .bmap = nullptr,
     .flag_nullpath_ok = 1,
@@ -417,9 +779,9 @@ static struct fuse_operations cuckooOperations = {
     .flag_reserved = 0,
     .ioctl = nullptr,
     .poll = nullptr,
-    .write_buf = nullptr,
-    .read_buf = nullptr,
-    .flock = nullptr,
+    .write_buf = DoWriteBuf,
+    .read_buf = DoReadBuf,
+    .flock = DoFlock,
     .fallocate = nullptr,
 #ifdef WITH_FUSE_OPT
 #if WITH_FUSE_OPT
@@ -467,6 +829,13 @@ int main(int argc, char *argv[])
     std::string serverIp = config->GetString(CuckooPropertyKey::CUCKOO_SERVER_IP);
     std::string serverPort = config->GetString(CuckooPropertyKey::CUCKOO_SERVER_PORT);
     g_persist = config->GetBool(CuckooPropertyKey::CUCKOO_PERSIST);
+    KernelCacheValidator::GetInstance().SetReadMostly(config->GetBool(CuckooPropertyKey::CUCKOO_READ_MOSTLY));
+    CuckooTraceSetProcessName("cuckoo_client");
+    CuckooTraceSetSampleRate(config->GetDouble(CuckooPropertyKey::CUCKOO_TRACE_SAMPLE_RATE));
+    std::string cacheOpts = std::format("-oattr_timeout={},entry_timeout={},negative_timeout={}",
+                                        config->GetDouble(CuckooPropertyKey::CUCKOO_ATTR_TIMEOUT),
+                                        config->GetDouble(CuckooPropertyKey::CUCKOO_ENTRY_TIMEOUT),
+                                        config->GetDouble(CuckooPropertyKey::CUCKOO_NEGATIVE_TIMEOUT));
 
 #ifdef ZK_INIT
     const char *zkEndPoint = std::getenv("zk_endpoint");
@@ -487,11 +856,21 @@ int main(int argc, char *argv[])
         return ret;
     }
     server.SetReadyFlag();
+    std::string accessTrace = config->GetString(CuckooPropertyKey::CUCKOO_ACCESS_TRACE);
+    if (!accessTrace.empty()) {
+        ret = CuckooStartAccessTrace(accessTrace);
+        if (ret != 0) {
+            std::println(stderr, "Start access trace {} failed: {}", accessTrace, strerror(-ret));
+        }
+    }
 
     if (fuse_opt_parse(&args, &options, option_spec, nullptr) == -1) {
         std::println(stderr, "args parse error! Invalid options or arguments");
         return 1;
     }
+    /* let fuse splice the fd buffers returned by read_buf into /dev/fuse */
+    fuse_opt_add_arg(&args, "-osplice_write");
+    fuse_opt_add_arg(&args, cacheOpts.c_str());
     std::println("{}", ret);
     ret = fuse_main(args.argc, args.argv, &cuckooOperations, nullptr);
     fuse_opt_free_args(&args);
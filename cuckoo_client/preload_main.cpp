@@ -0,0 +1,127 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+/*
+ * Loads a tree into the cache disks of the cluster ahead of a job, e.g. before the first epoch of a training
+ * run. The files are loaded by the nodes they are placed on, see CuckooPreload. With -trace the files of an
+ * access trace recorded by a former run are loaded in the order that run read them, see CuckooReplayTrace.
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <format>
+#include <mutex>
+#include <print>
+#include <string>
+#include <thread>
+
+#include <gflags/gflags.h>
+
+#include "brpc/brpc_server.h"
+#include "conf/cuckoo_property_key.h"
+#include "cuckoo_code.h"
+#include "cuckoo_meta.h"
+#include "cuckoo_preload.h"
+#include "init/cuckoo_init.h"
+
+DEFINE_string(path, "/", "file or directory to preload, relative to the mount point");
+DEFINE_string(trace, "", "access trace to replay instead of -path");
+DEFINE_uint32(concurrency, 16, "files loading at once over all nodes");
+DEFINE_uint64(bandwidth_mb, 0, "MiB per second loaded over all nodes, 0 is unlimited");
+DEFINE_uint32(ttl, 0, "seconds the files stay pinned in the cache, 0 leaves them to eviction");
+DEFINE_string(rpc_endpoint, "0.0.0.0:56040", "endpoint of rpc server");
+
+static std::string Bytes(double bytes)
+{
+    const char *units[] = {"B", "KiB", "MiB", "GiB", "TiB"};
+    size_t unit = 0;
+    while (bytes >= 1024 && unit + 1 < std::size(units)) {
+        bytes /= 1024;
+        ++unit;
+    }
+    return std::format("{:.1f} {}", bytes, units[unit]);
+}
+
+static void PrintProgress(const CuckooPreloadProgress &progress)
+{
+    double rate = progress.elapsedSec > 0 ? progress.doneBytes / progress.elapsedSec : 0;
+    std::string eta = progress.etaSec < 0 ? "-" : std::format("{:.0f}s", progress.etaSec);
+    std::println("files {}/{} failed {} bytes {}/{} {}/s elapsed {:.0f}s eta {}",
+                 progress.doneFiles,
+                 progress.totalFiles,
+                 progress.failedFiles,
+                 Bytes(progress.doneBytes),
+                 Bytes(progress.totalBytes),
+                 Bytes(rate),
+                 progress.elapsedSec,
+                 eta);
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::SetUsageMessage("preload a tree into the cache, CONFIG_FILE must point to the client config");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+    /* the client serves its own store node, start it the same way the fuse client does */
+    cuckoo::brpc_io::RemoteIOServer &server = cuckoo::brpc_io::RemoteIOServer::GetInstance();
+    server.endPoint = FLAGS_rpc_endpoint;
+    std::thread brpcServerThread(&cuckoo::brpc_io::RemoteIOServer::Run, &server);
+    {
+        std::unique_lock<std::mutex> lk(server.mutexStart);
+        server.cvStart.wait(lk, [&server]() { return server.isStarted; });
+    }
+    auto stopServer = [&server, &brpcServerThread]() {
+        server.Stop();
+        if (brpcServerThread.joinable()) {
+            brpcServerThread.join();
+        }
+    };
+
+    int ret = GetInit().Init();
+    if (ret != CUCKOO_SUCCESS) {
+        std::println(stderr, "Cuckoo init failed");
+        stopServer();
+        return ret;
+    }
+#ifdef ZK_INIT
+    const char *zkEndPoint = std::getenv("zk_endpoint");
+    if (zkEndPoint == nullptr) {
+        std::println(stderr, "Fetch zk endpoint failed!");
+        stopServer();
+        return -1;
+    }
+    ret = CuckooInitWithZK(zkEndPoint);
+#else
+    auto &config = GetInit().GetCuckooConfig();
+    std::string serverIp = config->GetString(CuckooPropertyKey::CUCKOO_SERVER_IP);
+    std::string serverPort = config->GetString(CuckooPropertyKey::CUCKOO_SERVER_PORT);
+    ret = CuckooInit(serverIp, std::stoi(serverPort));
+#endif
+    if (ret != CUCKOO_SUCCESS) {
+        std::println(stderr, "Cuckoo cluster init failed");
+        stopServer();
+        return ret;
+    }
+    server.SetReadyFlag();
+
+    CuckooPreloadOptions options;
+    options.concurrency = FLAGS_concurrency;
+    options.bandwidth = FLAGS_bandwidth_mb * 1024 * 1024;
+    options.ttlSec = FLAGS_ttl;
+    std::println("preload {} concurrency {} bandwidth {} ttl {}s",
+                 FLAGS_trace.empty() ? FLAGS_path : "trace " + FLAGS_trace,
+                 options.concurrency,
+                 options.bandwidth == 0 ? "unlimited" : Bytes(options.bandwidth) + "/s",
+                 options.ttlSec);
+    if (FLAGS_trace.empty()) {
+        ret = CuckooPreload(FLAGS_path, options, PrintProgress);
+    } else {
+        ret = CuckooReplayTrace(FLAGS_trace, options, PrintProgress);
+    }
+    if (ret != 0) {
+        std::println(stderr, "preload finished with errors, first error: {}", ret);
+    }
+    stopServer();
+    return ret == 0 ? 0 : 1;
+}
@@ -10,6 +10,8 @@
 
 #include "cuckoo_meta_param_generated.h"
 #include "log/logging.h"
+#include "remote_connection_utils/cuckoo_trace.h"
+#include "stats/cuckoo_stats.h"
 
 #ifdef S_BLKSIZE
 #define ST_NBLOCKSIZE S_BLKSIZE
@@ -48,21 +50,30 @@ inline cuckoo::meta_fbs::AnyMetaParam ToFlatBuffersType(cuckoo::meta_proto::Meta
         return cuckoo::meta_fbs::AnyMetaParam_ChownParam;
     case cuckoo::meta_proto::CHMOD:
         return cuckoo::meta_fbs::AnyMetaParam_ChmodParam;
+    case cuckoo::meta_proto::SETXATTR:
+        return cuckoo::meta_fbs::AnyMetaParam_SetXattrParam;
+    case cuckoo::meta_proto::GETXATTR:
+        return cuckoo::meta_fbs::AnyMetaParam_GetXattrParam;
+    case cuckoo::meta_proto::REMOVEXATTR:
+        return cuckoo::meta_fbs::AnyMetaParam_RemoveXattrParam;
+    case cuckoo::meta_proto::LISTXATTR:
+    case cuckoo::meta_proto::READLINK:
+        return cuckoo::meta_fbs::AnyMetaParam_PathOnlyParam;
+    case cuckoo::meta_proto::SYMLINK:
+        return cuckoo::meta_fbs::AnyMetaParam_SymlinkParam;
+    case cuckoo::meta_proto::LINK:
+        return cuckoo::meta_fbs::AnyMetaParam_LinkParam;
     default:
         throw std::runtime_error("Unknown service type");
     }
 }
 
-template <typename ParamBuilder, typename ResponseHandler, typename ResultType>
-CuckooErrorCode Connection::ProcessRequest(cuckoo::meta_proto::MetaServiceType proto_type,
-                                           const ParamBuilder &paramBuilder,
-                                           ResponseHandler responseHandler,
-                                           ConnectionCache *cache,
-                                           ResultType *result)
+template <typename ParamBuilder>
+static void PrepareRequest(cuckoo::meta_proto::MetaServiceType proto_type,
+                           const ParamBuilder &paramBuilder,
+                           ConnectionCache *cache,
+                           cuckoo::meta_proto::MetaRequest &request)
 {
-    if (!cache)
-        cache = &ThreadLocalConnectionCache;
-
     // 1. Prepare param
     SerializedDataClear(&cache->serializedDataBuffer);
     cache->flatBufferBuilder.Clear();
@@ -76,22 +87,19 @@ CuckooErrorCode Connection::ProcessRequest(cuckoo::meta_proto::MetaServiceType p
     memcpy(p, cache->flatBufferBuilder.GetBufferPointer(), cache->flatBufferBuilder.GetSize());
 
     // 2. Construct request
-    cuckoo::meta_proto::MetaRequest request;
     request.add_type(proto_type);
     if (proto_type == cuckoo::meta_proto::MKDIR || proto_type == cuckoo::meta_proto::CREATE ||
         proto_type == cuckoo::meta_proto::STAT || proto_type == cuckoo::meta_proto::OPEN ||
-        proto_type == cuckoo::meta_proto::CLOSE || proto_type == cuckoo::meta_proto::UNLINK) {
+        proto_type == cuckoo::meta_proto::CLOSE || proto_type == cuckoo::meta_proto::UNLINK ||
+        proto_type == cuckoo::meta_proto::SETXATTR || proto_type == cuckoo::meta_proto::GETXATTR ||
+        proto_type == cuckoo::meta_proto::LISTXATTR || proto_type == cuckoo::meta_proto::REMOVEXATTR) {
         request.set_allow_batch_with_others(ALLOW_BATCH_WITH_OTHERS);
     }
-    brpc::Controller cntl;
-    cntl.set_timeout_ms(10000);
-    cntl.request_attachment().append_user_data(cache->serializedDataBuffer.buffer,
-                                               cache->serializedDataBuffer.size,
-                                               BrpcDummyDeleter);
+}
 
-    // 3. Send request
-    cuckoo::meta_proto::Empty dummyResponse;
-    stub.MetaCall(&cntl, &request, &dummyResponse, nullptr);
+template <typename ResponseHandler, typename ResultType>
+CuckooErrorCode Connection::ParseResponse(brpc::Controller &cntl, ResponseHandler &responseHandler, ResultType *result)
+{
     if (cntl.Failed()) {
         CUCKOO_LOG(LOG_ERROR) << std::format("{}: Send request failed, error code = {}, error text = {}",
                                              __func__,
@@ -145,6 +153,79 @@ CuckooErrorCode Connection::ProcessRequest(cuckoo::meta_proto::MetaServiceType p
     return responseHandler(metaResponse, result);
 }
 
+template <typename ParamBuilder, typename ResponseHandler, typename ResultType>
+CuckooErrorCode Connection::ProcessRequest(cuckoo::meta_proto::MetaServiceType proto_type,
+                                           const ParamBuilder &paramBuilder,
+                                           ResponseHandler responseHandler,
+                                           ConnectionCache *cache,
+                                           ResultType *result)
+{
+    if (!cache)
+        cache = &ThreadLocalConnectionCache;
+
+    cuckoo::meta_proto::MetaRequest request;
+    PrepareRequest(proto_type, paramBuilder, cache, request);
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(10000);
+    cntl.request_attachment().append_user_data(cache->serializedDataBuffer.buffer,
+                                               cache->serializedDataBuffer.size,
+                                               BrpcDummyDeleter);
+
+    // 3. Send request
+    cuckoo::meta_proto::Empty dummyResponse;
+    CuckooStats::GetInstance().stats[META_OPS].fetch_add(1);
+    {
+        StatFuseTimer t(META_LAT);
+        CuckooTraceScope trace("meta_rpc");
+        CuckooTraceInject(request, trace.Context());
+        stub.MetaCall(&cntl, &request, &dummyResponse, nullptr);
+    }
+
+    return ParseResponse(cntl, responseHandler, result);
+}
+
+/* a meta rpc in flight, brpc runs it once the response is in */
+class MetaCallClosure : public google::protobuf::Closure {
+  public:
+    brpc::Controller cntl;
+    cuckoo::meta_proto::MetaRequest request;
+    cuckoo::meta_proto::Empty response;
+    std::function<CuckooErrorCode(brpc::Controller &)> parse;
+    Connection::MetaCallback done;
+    /* records the latency when the call is deleted */
+    StatFuseTimer timer{META_LAT};
+
+    void Run() override
+    {
+        std::unique_ptr<MetaCallClosure> self(this);
+        CuckooErrorCode errorCode = parse(cntl);
+        done(errorCode);
+    }
+};
+
+template <typename ParamBuilder, typename ResponseHandler>
+void Connection::ProcessRequestAsync(cuckoo::meta_proto::MetaServiceType proto_type,
+                                     const ParamBuilder &paramBuilder,
+                                     ResponseHandler responseHandler,
+                                     MetaCallback done)
+{
+    ConnectionCache *cache = &ThreadLocalConnectionCache;
+    auto *call = new MetaCallClosure;
+    PrepareRequest(proto_type, paramBuilder, cache, call->request);
+    call->cntl.set_timeout_ms(10000);
+    /* the thread local buffer is reused by the next request of this thread before this one is sent */
+    call->cntl.request_attachment().append(cache->serializedDataBuffer.buffer, cache->serializedDataBuffer.size);
+    call->parse = [responseHandler](brpc::Controller &cntl) mutable {
+        return ParseResponse(cntl, responseHandler, static_cast<void *>(nullptr));
+    };
+    call->done = std::move(done);
+
+    CuckooStats::GetInstance().stats[META_OPS].fetch_add(1);
+    CuckooTraceScope trace("meta_rpc_async");
+    CuckooTraceInject(call->request, trace.Context());
+    stub.MetaCall(&call->cntl, &call->request, &call->response, call);
+}
+
 static timespec ConvertTimestampFromPGToUnix(uint64_t t)
 {
     // seconds from 1970-01-01 to 2000-01-01
@@ -223,6 +304,72 @@ Connection::Create(const char *path, uint64_t &inodeId, int32_t &nodeId, struct
     return ProcessRequest(cuckoo::meta_proto::CREATE, paramBuilder, responseHandler, cache);
 }
 
+static CuckooErrorCode HandleStatResponse(const cuckoo::meta_fbs::MetaResponse *metaResponse, struct stat *stbuf)
+{
+    if (metaResponse->response_type() != cuckoo::meta_fbs::AnyMetaResponse_StatResponse) {
+        return PROGRAM_ERROR;
+    }
+
+    auto statResponse = metaResponse->response_as_StatResponse();
+    if (stbuf) {
+        stbuf->st_ino = statResponse->st_ino();
+        stbuf->st_dev = statResponse->st_dev();
+        stbuf->st_mode = statResponse->st_mode();
+        stbuf->st_nlink = statResponse->st_nlink();
+        stbuf->st_uid = statResponse->st_uid();
+        stbuf->st_gid = statResponse->st_gid();
+        stbuf->st_rdev = statResponse->st_rdev();
+        stbuf->st_size = statResponse->st_size();
+        stbuf->st_blksize = ST_BLKSIZE;
+        stbuf->st_blocks = (stbuf->st_size + ST_BLKSIZE - 1) / ST_BLKSIZE * (ST_BLKSIZE / ST_NBLOCKSIZE);
+        stbuf->st_atim = ConvertTimestampFromPGToUnix(statResponse->st_atim());
+        stbuf->st_mtim = ConvertTimestampFromPGToUnix(statResponse->st_mtim());
+        stbuf->st_ctim = ConvertTimestampFromPGToUnix(statResponse->st_ctim());
+    }
+    return (CuckooErrorCode)metaResponse->error_code();
+}
+
+static CuckooErrorCode HandleOpenResponse(const cuckoo::meta_fbs::MetaResponse *metaResponse,
+                                          uint64_t &inodeId,
+                                          int64_t &size,
+                                          int32_t &nodeId,
+                                          struct stat *stbuf)
+{
+    if (metaResponse->response_type() != cuckoo::meta_fbs::AnyMetaResponse_OpenResponse) {
+        return PROGRAM_ERROR;
+    }
+
+    auto openResponse = metaResponse->response_as_OpenResponse();
+    inodeId = openResponse->st_ino();
+    size = openResponse->st_size();
+    nodeId = openResponse->node_id();
+
+    if (stbuf) {
+        stbuf->st_ino = openResponse->st_ino();
+        stbuf->st_dev = openResponse->st_dev();
+        stbuf->st_mode = openResponse->st_mode();
+        stbuf->st_nlink = openResponse->st_nlink();
+        stbuf->st_uid = openResponse->st_uid();
+        stbuf->st_gid = openResponse->st_gid();
+        stbuf->st_rdev = openResponse->st_rdev();
+        stbuf->st_size = openResponse->st_size();
+        stbuf->st_blksize = ST_BLKSIZE;
+        stbuf->st_blocks = (stbuf->st_size + ST_BLKSIZE - 1) / ST_BLKSIZE * (ST_BLKSIZE / ST_NBLOCKSIZE);
+        stbuf->st_atim = ConvertTimestampFromPGToUnix(openResponse->st_atim());
+        stbuf->st_mtim = ConvertTimestampFromPGToUnix(openResponse->st_mtim());
+        stbuf->st_ctim = ConvertTimestampFromPGToUnix(openResponse->st_ctim());
+    }
+
+    return (CuckooErrorCode)metaResponse->error_code();
+}
+
+static CuckooErrorCode HandleCloseResponse(const cuckoo::meta_fbs::MetaResponse *metaResponse)
+{
+    return metaResponse->error_code() < LAST_CUCKOO_ERROR_CODE
+               ? static_cast<CuckooErrorCode>(metaResponse->error_code())
+               : PROGRAM_ERROR;
+}
+
 CuckooErrorCode Connection::Stat(const char *path, struct stat *stbuf, ConnectionCache *cache)
 {
     auto paramBuilder = [path](flatbuffers::FlatBufferBuilder &builder) {
@@ -230,32 +377,25 @@ CuckooErrorCode Connection::Stat(const char *path, struct stat *stbuf, Connectio
     };
 
     auto responseHandler = [stbuf](const cuckoo::meta_fbs::MetaResponse *metaResponse, void *) {
-        if (metaResponse->response_type() != cuckoo::meta_fbs::AnyMetaResponse_StatResponse) {
-            return PROGRAM_ERROR;
-        }
-
-        auto statResponse = metaResponse->response_as_StatResponse();
-        if (stbuf) {
-            stbuf->st_ino = statResponse->st_ino();
-            stbuf->st_dev = statResponse->st_dev();
-            stbuf->st_mode = statResponse->st_mode();
-            stbuf->st_nlink = statResponse->st_nlink();
-            stbuf->st_uid = statResponse->st_uid();
-            stbuf->st_gid = statResponse->st_gid();
-            stbuf->st_rdev = statResponse->st_rdev();
-            stbuf->st_size = statResponse->st_size();
-            stbuf->st_blksize = ST_BLKSIZE;
-            stbuf->st_blocks = (stbuf->st_size + ST_BLKSIZE - 1) / ST_BLKSIZE * (ST_BLKSIZE / ST_NBLOCKSIZE);
-            stbuf->st_atim = ConvertTimestampFromPGToUnix(statResponse->st_atim());
-            stbuf->st_mtim = ConvertTimestampFromPGToUnix(statResponse->st_mtim());
-            stbuf->st_ctim = ConvertTimestampFromPGToUnix(statResponse->st_ctim());
-        }
-        return (CuckooErrorCode)metaResponse->error_code();
+        return HandleStatResponse(metaResponse, stbuf);
     };
 
     return ProcessRequest(cuckoo::meta_proto::STAT, paramBuilder, responseHandler, cache);
 }
 
+void Connection::StatAsync(const char *path, struct stat *stbuf, MetaCallback done)
+{
+    auto paramBuilder = [path](flatbuffers::FlatBufferBuilder &builder) {
+        return cuckoo::meta_fbs::CreatePathOnlyParamDirect(builder, path);
+    };
+
+    auto responseHandler = [stbuf](const cuckoo::meta_fbs::MetaResponse *metaResponse, void *) {
+        return HandleStatResponse(metaResponse, stbuf);
+    };
+
+    ProcessRequestAsync(cuckoo::meta_proto::STAT, paramBuilder, responseHandler, std::move(done));
+}
+
 CuckooErrorCode Connection::Open(const char *path,
                                  uint64_t &inodeId,
                                  int64_t &size,
@@ -269,35 +409,29 @@ CuckooErrorCode Connection::Open(const char *path,
 
     auto responseHandler = [&inodeId, &size, &nodeId, stbuf](const cuckoo::meta_fbs::MetaResponse *metaResponse,
                                                              void *) {
-        if (metaResponse->response_type() != cuckoo::meta_fbs::AnyMetaResponse_OpenResponse) {
-            return PROGRAM_ERROR;
-        }
+        return HandleOpenResponse(metaResponse, inodeId, size, nodeId, stbuf);
+    };
 
-        auto openResponse = metaResponse->response_as_OpenResponse();
-        inodeId = openResponse->st_ino();
-        size = openResponse->st_size();
-        nodeId = openResponse->node_id();
+    return ProcessRequest(cuckoo::meta_proto::OPEN, paramBuilder, responseHandler, cache);
+}
 
-        if (stbuf) {
-            stbuf->st_ino = openResponse->st_ino();
-            stbuf->st_dev = openResponse->st_dev();
-            stbuf->st_mode = openResponse->st_mode();
-            stbuf->st_nlink = openResponse->st_nlink();
-            stbuf->st_uid = openResponse->st_uid();
-            stbuf->st_gid = openResponse->st_gid();
-            stbuf->st_rdev = openResponse->st_rdev();
-            stbuf->st_size = openResponse->st_size();
-            stbuf->st_blksize = ST_BLKSIZE;
-            stbuf->st_blocks = (stbuf->st_size + ST_BLKSIZE - 1) / ST_BLKSIZE * (ST_BLKSIZE / ST_NBLOCKSIZE);
-            stbuf->st_atim = ConvertTimestampFromPGToUnix(openResponse->st_atim());
-            stbuf->st_mtim = ConvertTimestampFromPGToUnix(openResponse->st_mtim());
-            stbuf->st_ctim = ConvertTimestampFromPGToUnix(openResponse->st_ctim());
-        }
+void Connection::OpenAsync(const char *path,
+                           uint64_t *inodeId,
+                           int64_t *size,
+                           int32_t *nodeId,
+                           struct stat *stbuf,
+                           MetaCallback done)
+{
+    auto paramBuilder = [path](flatbuffers::FlatBufferBuilder &builder) {
+        return cuckoo::meta_fbs::CreatePathOnlyParamDirect(builder, path);
+    };
 
-        return (CuckooErrorCode)metaResponse->error_code();
+    auto responseHandler = [inodeId, size, nodeId, stbuf](const cuckoo::meta_fbs::MetaResponse *metaResponse,
+                                                          void *) {
+        return HandleOpenResponse(metaResponse, *inodeId, *size, *nodeId, stbuf);
     };
 
-    return ProcessRequest(cuckoo::meta_proto::OPEN, paramBuilder, responseHandler, cache);
+    ProcessRequestAsync(cuckoo::meta_proto::OPEN, paramBuilder, responseHandler, std::move(done));
 }
 
 CuckooErrorCode
@@ -308,22 +442,38 @@ Connection::Close(const char *path, int64_t size, uint64_t mtime, int32_t nodeId
     };
 
     auto responseHandler = [](const cuckoo::meta_fbs::MetaResponse *metaResponse, void *) {
-        return metaResponse->error_code() < LAST_CUCKOO_ERROR_CODE
-                   ? static_cast<CuckooErrorCode>(metaResponse->error_code())
-                   : PROGRAM_ERROR;
+        return HandleCloseResponse(metaResponse);
     };
 
     return ProcessRequest(cuckoo::meta_proto::CLOSE, paramBuilder, responseHandler, cache);
 }
 
-CuckooErrorCode
-Connection::Unlink(const char *path, uint64_t &inodeId, int64_t &size, int32_t &nodeId, ConnectionCache *cache)
+void Connection::CloseAsync(const char *path, int64_t size, uint64_t mtime, int32_t nodeId, MetaCallback done)
+{
+    auto paramBuilder = [path, size, mtime, nodeId](flatbuffers::FlatBufferBuilder &builder) {
+        return cuckoo::meta_fbs::CreateCloseParamDirect(builder, path, size, mtime, nodeId);
+    };
+
+    auto responseHandler = [](const cuckoo::meta_fbs::MetaResponse *metaResponse, void *) {
+        return HandleCloseResponse(metaResponse);
+    };
+
+    ProcessRequestAsync(cuckoo::meta_proto::CLOSE, paramBuilder, responseHandler, std::move(done));
+}
+
+CuckooErrorCode Connection::Unlink(const char *path,
+                                   uint64_t &inodeId,
+                                   int64_t &size,
+                                   int32_t &nodeId,
+                                   uint64_t *nlink,
+                                   ConnectionCache *cache)
 {
     auto paramBuilder = [path](flatbuffers::FlatBufferBuilder &builder) {
         return cuckoo::meta_fbs::CreatePathOnlyParamDirect(builder, path);
     };
 
-    auto responseHandler = [&inodeId, &size, &nodeId](const cuckoo::meta_fbs::MetaResponse *metaResponse, void *) {
+    auto responseHandler = [&inodeId, &size, &nodeId, nlink](const cuckoo::meta_fbs::MetaResponse *metaResponse,
+                                                             void *) {
         if (metaResponse->response_type() != cuckoo::meta_fbs::AnyMetaResponse_UnlinkResponse) {
             return PROGRAM_ERROR;
         }
@@ -332,6 +482,9 @@ Connection::Unlink(const char *path, uint64_t &inodeId, int64_t &size, int32_t &
         inodeId = unlinkResponse->st_ino();
         size = unlinkResponse->st_size();
         nodeId = unlinkResponse->node_id();
+        if (nlink) {
+            *nlink = unlinkResponse->st_nlink();
+        }
 
         return static_cast<CuckooErrorCode>(metaResponse->error_code());
     };
@@ -455,3 +608,137 @@ CuckooErrorCode Connection::Chmod(const char *path, uint32_t mode, ConnectionCac
 
     return ProcessRequest(cuckoo::meta_proto::CHMOD, paramBuilder, responseHandler, cache);
 }
+
+CuckooErrorCode Connection::SetXattr(const char *path,
+                                     const char *key,
+                                     const char *value,
+                                     size_t size,
+                                     int flags,
+                                     ConnectionCache *cache)
+{
+    auto paramBuilder = [path, key, value, size, flags](flatbuffers::FlatBufferBuilder &builder) {
+        auto valueVector = builder.CreateVector(reinterpret_cast<const uint8_t *>(value), size);
+        return cuckoo::meta_fbs::CreateSetXattrParam(builder,
+                                                     builder.CreateString(path),
+                                                     builder.CreateString(key),
+                                                     valueVector,
+                                                     flags);
+    };
+
+    auto responseHandler = [](const cuckoo::meta_fbs::MetaResponse *metaResponse, void *) {
+        return metaResponse->error_code() < LAST_CUCKOO_ERROR_CODE
+                   ? static_cast<CuckooErrorCode>(metaResponse->error_code())
+                   : PROGRAM_ERROR;
+    };
+
+    return ProcessRequest(cuckoo::meta_proto::SETXATTR, paramBuilder, responseHandler, cache);
+}
+
+CuckooErrorCode Connection::GetXattr(const char *path, const char *key, std::string &value, ConnectionCache *cache)
+{
+    auto paramBuilder = [path, key](flatbuffers::FlatBufferBuilder &builder) {
+        return cuckoo::meta_fbs::CreateGetXattrParamDirect(builder, path, key);
+    };
+
+    auto responseHandler = [&value](const cuckoo::meta_fbs::MetaResponse *metaResponse, void *) {
+        if (metaResponse->response_type() != cuckoo::meta_fbs::AnyMetaResponse_GetXattrResponse) {
+            return PROGRAM_ERROR;
+        }
+        auto getXattrResponse = metaResponse->response_as_GetXattrResponse();
+        if (getXattrResponse->value()) {
+            value.assign(reinterpret_cast<const char *>(getXattrResponse->value()->data()),
+                         getXattrResponse->value()->size());
+        } else {
+            value.clear();
+        }
+        return SUCCESS;
+    };
+
+    return ProcessRequest(cuckoo::meta_proto::GETXATTR, paramBuilder, responseHandler, cache);
+}
+
+CuckooErrorCode Connection::ListXattr(const char *path, std::vector<std::string> &keys, ConnectionCache *cache)
+{
+    auto paramBuilder = [path](flatbuffers::FlatBufferBuilder &builder) {
+        return cuckoo::meta_fbs::CreatePathOnlyParamDirect(builder, path);
+    };
+
+    auto responseHandler = [&keys](const cuckoo::meta_fbs::MetaResponse *metaResponse, void *) {
+        if (metaResponse->response_type() != cuckoo::meta_fbs::AnyMetaResponse_ListXattrResponse) {
+            return PROGRAM_ERROR;
+        }
+        keys.clear();
+        auto listXattrResponse = metaResponse->response_as_ListXattrResponse();
+        if (listXattrResponse->keys()) {
+            for (auto key : *listXattrResponse->keys()) {
+                keys.emplace_back(key->str());
+            }
+        }
+        return SUCCESS;
+    };
+
+    return ProcessRequest(cuckoo::meta_proto::LISTXATTR, paramBuilder, responseHandler, cache);
+}
+
+CuckooErrorCode Connection::RemoveXattr(const char *path, const char *key, ConnectionCache *cache)
+{
+    auto paramBuilder = [path, key](flatbuffers::FlatBufferBuilder &builder) {
+        return cuckoo::meta_fbs::CreateRemoveXattrParamDirect(builder, path, key);
+    };
+
+    auto responseHandler = [](const cuckoo::meta_fbs::MetaResponse *metaResponse, void *) {
+        return metaResponse->error_code() < LAST_CUCKOO_ERROR_CODE
+                   ? static_cast<CuckooErrorCode>(metaResponse->error_code())
+                   : PROGRAM_ERROR;
+    };
+
+    return ProcessRequest(cuckoo::meta_proto::REMOVEXATTR, paramBuilder, responseHandler, cache);
+}
+
+CuckooErrorCode Connection::Symlink(const char *target, const char *path, ConnectionCache *cache)
+{
+    auto paramBuilder = [target, path](flatbuffers::FlatBufferBuilder &builder) {
+        return cuckoo::meta_fbs::CreateSymlinkParamDirect(builder, target, path);
+    };
+
+    auto responseHandler = [](const cuckoo::meta_fbs::MetaResponse *metaResponse, void *) {
+        return metaResponse->error_code() < LAST_CUCKOO_ERROR_CODE
+                   ? static_cast<CuckooErrorCode>(metaResponse->error_code())
+                   : PROGRAM_ERROR;
+    };
+
+    return ProcessRequest(cuckoo::meta_proto::SYMLINK, paramBuilder, responseHandler, cache);
+}
+
+CuckooErrorCode Connection::Readlink(const char *path, std::string &target, ConnectionCache *cache)
+{
+    auto paramBuilder = [path](flatbuffers::FlatBufferBuilder &builder) {
+        return cuckoo::meta_fbs::CreatePathOnlyParamDirect(builder, path);
+    };
+
+    auto responseHandler = [&target](const cuckoo::meta_fbs::MetaResponse *metaResponse, void *) {
+        if (metaResponse->response_type() != cuckoo::meta_fbs::AnyMetaResponse_ReadlinkResponse) {
+            return PROGRAM_ERROR;
+        }
+        auto readlinkResponse = metaResponse->response_as_ReadlinkResponse();
+        target = readlinkResponse->target() ? readlinkResponse->target()->str() : "";
+        return SUCCESS;
+    };
+
+    return ProcessRequest(cuckoo::meta_proto::READLINK, paramBuilder, responseHandler, cache);
+}
+
+CuckooErrorCode Connection::Link(const char *src, const char *dst, ConnectionCache *cache)
+{
+    auto paramBuilder = [src, dst](flatbuffers::FlatBufferBuilder &builder) {
+        return cuckoo::meta_fbs::CreateLinkParamDirect(builder, src, dst);
+    };
+
+    auto responseHandler = [](const cuckoo::meta_fbs::MetaResponse *metaResponse, void *) {
+        return metaResponse->error_code() < LAST_CUCKOO_ERROR_CODE
+                   ? static_cast<CuckooErrorCode>(metaResponse->error_code())
+                   : PROGRAM_ERROR;
+    };
+
+    return ProcessRequest(cuckoo::meta_proto::LINK, paramBuilder, responseHandler, cache);
+}
\ No newline at end of file
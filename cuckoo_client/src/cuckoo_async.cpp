@@ -0,0 +1,359 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "cuckoo_async.h"
+
+#include <cerrno>
+#include <memory>
+#include <vector>
+
+#include <unistd.h>
+
+#include "buffer/dir_open_instance.h"
+#include "conf/cuckoo_property_key.h"
+#include "connection.h"
+#include "cuckoo_meta.h"
+#include "error_code.h"
+#include "init/cuckoo_init.h"
+#include "inner_cuckoo_meta.h"
+#include "log/logging.h"
+#include "router.h"
+
+/* set on io threads of the window */
+static thread_local bool t_onIoThread = false;
+
+CuckooAsyncWindow::CuckooAsyncWindow()
+{
+    auto &config = GetInit().GetCuckooConfig();
+    maxInflight = config ? config->GetUint32(CuckooPropertyKey::CUCKOO_ASYNC_MAX_INFLIGHT) : 0;
+    if (maxInflight == 0) {
+        maxInflight = DEFAULT_MAX_INFLIGHT;
+    }
+    uint32_t ioThreadNum = config ? config->GetUint32(CuckooPropertyKey::CUCKOO_ASYNC_IO_THREADS) : 0;
+    if (ioThreadNum == 0) {
+        ioThreadNum = DEFAULT_IO_THREAD_NUM;
+    }
+    ioPool = ThreadPool::CreateThreadPool(ioThreadNum, IO_QUEUE_SIZE, "cuckoo_async");
+    if (ioPool->Start() != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "start io threads for async ops failed";
+    }
+}
+
+void CuckooAsyncWindow::SetMaxInflight(uint32_t num)
+{
+    std::lock_guard<bthread::Mutex> lock(mutex);
+    maxInflight = num == 0 ? DEFAULT_MAX_INFLIGHT : num;
+    cv.notify_all();
+}
+
+uint32_t CuckooAsyncWindow::GetInflight()
+{
+    std::lock_guard<bthread::Mutex> lock(mutex);
+    return inflight;
+}
+
+CuckooAsyncCallback CuckooAsyncWindow::Acquire(CuckooAsyncCallback done)
+{
+    {
+        std::unique_lock<bthread::Mutex> lock(mutex);
+        /* a callback submitting from an io thread is not held back, it would hold the thread the window waits for */
+        while (!t_onIoThread && inflight >= maxInflight) {
+            cv.wait(lock);
+        }
+        ++inflight;
+    }
+    /* give the slot back first, so that done can submit the next op without waiting on itself */
+    return [this, done = std::move(done)](int ret) {
+        Release();
+        if (done) {
+            done(ret);
+        }
+    };
+}
+
+void CuckooAsyncWindow::Release()
+{
+    std::lock_guard<bthread::Mutex> lock(mutex);
+    --inflight;
+    cv.notify_all();
+}
+
+void CuckooAsyncWindow::Drain()
+{
+    std::unique_lock<bthread::Mutex> lock(mutex);
+    while (inflight != 0) {
+        cv.wait(lock);
+    }
+}
+
+void CuckooAsyncWindow::Run(std::function<void()> task)
+{
+    ioPool->Submit(ThreadTask{"cuckoo_async", [task = std::move(task)]() {
+                                  t_onIoThread = true;
+                                  task();
+                              }});
+}
+
+void CuckooAsyncWindow::Start(uint64_t fd, FdTask task)
+{
+    Run([this, fd, task = std::move(task)]() mutable {
+        /* fd is let go once the op completes, for close that is after its rpc has returned */
+        task.op([this, fd, complete = std::move(task.complete)](int ret) {
+            complete(ret);
+            Finish(fd);
+        });
+    });
+}
+
+void CuckooAsyncWindow::Finish(uint64_t fd)
+{
+    std::vector<FdTask> ready;
+    {
+        std::lock_guard<std::mutex> lock(fdMutex);
+        auto it = fdQueues.find(fd);
+        FdQueue &queue = it->second;
+        --queue.running;
+        queue.exclusive = false;
+        /* the shared ops at the head start together, an exclusive one only once nothing else runs */
+        while (!queue.waiting.empty()) {
+            bool exclusive = queue.waiting.front().exclusive;
+            if (queue.exclusive || (exclusive && queue.running > 0)) {
+                break;
+            }
+            ++queue.running;
+            queue.exclusive = exclusive;
+            ready.push_back(std::move(queue.waiting.front()));
+            queue.waiting.pop_front();
+        }
+        if (queue.running == 0) {
+            fdQueues.erase(it);
+        }
+    }
+    for (FdTask &task : ready) {
+        Start(fd, std::move(task));
+    }
+}
+
+int CuckooAsyncWindow::Submit(uint64_t fd,
+                              bool exclusive,
+                              std::function<void(CuckooAsyncCallback)> op,
+                              CuckooAsyncCallback done)
+{
+    FdTask task{exclusive, std::move(op), Acquire(std::move(done))};
+    {
+        std::lock_guard<std::mutex> lock(fdMutex);
+        FdQueue &queue = fdQueues[fd];
+        /* nothing jumps an op waiting before it, so a write is not starved by a stream of reads */
+        if (!queue.waiting.empty() || queue.exclusive || (exclusive && queue.running > 0)) {
+            queue.waiting.push_back(std::move(task));
+            return 0;
+        }
+        ++queue.running;
+        queue.exclusive = exclusive;
+    }
+    Start(fd, std::move(task));
+    return 0;
+}
+
+/* the synchronous calls report errors of the cluster as positive CuckooErrorCode, the async ones as -errno */
+static int ToErrno(int ret)
+{
+    return ret > 0 ? -ErrorCodeToErrno(ret) : ret;
+}
+
+int CuckooOpenAsync(const std::string &path, int oflags, uint64_t *fd, struct stat *stbuf, CuckooAsyncCallback done)
+{
+    if (fd == nullptr) {
+        return -EINVAL;
+    }
+    std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
+    if (!conn) {
+        CUCKOO_LOG(LOG_ERROR) << "route error";
+        return ToErrno(PROGRAM_ERROR);
+    }
+
+    struct OpenReply
+    {
+        uint64_t inodeId = 0;
+        int64_t size = 0;
+        int32_t nodeId = 0;
+    };
+    auto reply = std::make_shared<OpenReply>();
+    CuckooAsyncCallback complete = CuckooAsyncWindow::GetInstance().Acquire(std::move(done));
+    conn->OpenAsync(path.c_str(),
+                    &reply->inodeId,
+                    &reply->size,
+                    &reply->nodeId,
+                    stbuf,
+                    [path, oflags, fd, stbuf, reply, complete](CuckooErrorCode errorCode) {
+#ifdef ZK_INIT
+                        if (errorCode == SERVER_FAULT) {
+                            /* the meta server fails over, retried the synchronous way */
+                            CuckooAsyncWindow::GetInstance().Run(
+                                [=]() { complete(ToErrno(CuckooOpen(path, oflags, *fd, stbuf))); });
+                            return;
+                        }
+#endif
+                        if (errorCode != SUCCESS) {
+                            complete(ToErrno(errorCode));
+                            return;
+                        }
+                        /* waiting for a free open instance and reading a small file whole block */
+                        CuckooAsyncWindow::GetInstance().Run([=]() {
+                            complete(ToErrno(
+                                CuckooAttachOpen(path, oflags, *fd, reply->inodeId, reply->size, reply->nodeId)));
+                        });
+                    });
+    return 0;
+}
+
+int CuckooReadAsync(const std::string &path,
+                    uint64_t fd,
+                    char *buffer,
+                    size_t size,
+                    off_t offset,
+                    CuckooAsyncCallback done)
+{
+    if (buffer == nullptr) {
+        return -EINVAL;
+    }
+    return CuckooAsyncWindow::GetInstance().Submit(
+        fd,
+        false,
+        [path, fd, buffer, size, offset](CuckooAsyncCallback complete) {
+            /* a read of an unknown fd returns a positive code, which could not be told from a size */
+            if (CuckooFd::GetInstance()->GetOpenInstanceByFd(fd) == nullptr) {
+                complete(-EBADF);
+                return;
+            }
+            complete(ToErrno(CuckooRead(path, fd, buffer, size, offset)));
+        },
+        std::move(done));
+}
+
+int CuckooWriteAsync(uint64_t fd,
+                     const std::string &path,
+                     const char *buffer,
+                     size_t size,
+                     off_t offset,
+                     CuckooAsyncCallback done)
+{
+    if (buffer == nullptr) {
+        return -EINVAL;
+    }
+    return CuckooAsyncWindow::GetInstance().Submit(
+        fd,
+        true,
+        [fd, path, buffer, size, offset](CuckooAsyncCallback complete) {
+            complete(ToErrno(CuckooWrite(fd, path, buffer, size, offset)));
+        },
+        std::move(done));
+}
+
+int CuckooGetStatAsync(const std::string &path, struct stat *stbuf, CuckooAsyncCallback done)
+{
+    if (stbuf == nullptr) {
+        return -EINVAL;
+    }
+    std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
+    if (!conn) {
+        CUCKOO_LOG(LOG_ERROR) << "route error";
+        return ToErrno(PROGRAM_ERROR);
+    }
+
+    CuckooAsyncCallback complete = CuckooAsyncWindow::GetInstance().Acquire(std::move(done));
+    conn->StatAsync(path.c_str(), stbuf, [path, stbuf, complete](CuckooErrorCode errorCode) {
+#ifdef ZK_INIT
+        if (errorCode == SERVER_FAULT) {
+            CuckooAsyncWindow::GetInstance().Run([=]() { complete(ToErrno(CuckooGetStat(path, stbuf))); });
+            return;
+        }
+#endif
+        complete(ToErrno(errorCode));
+    });
+    return 0;
+}
+
+int CuckooCloseAsync(const std::string &path, uint64_t fd, CuckooAsyncCallback done)
+{
+    return CuckooAsyncWindow::GetInstance().Submit(
+        fd,
+        true,
+        [path, fd](CuckooAsyncCallback complete) {
+            bool needMeta = false;
+            int64_t size = 0;
+            int32_t nodeId = 0;
+            int ret = CuckooCloseData(fd, false, -1, needMeta, size, nodeId);
+            if (!needMeta) {
+                complete(ToErrno(ret));
+                return;
+            }
+            std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
+            if (!conn) {
+                CUCKOO_LOG(LOG_ERROR) << "route error";
+                complete(ToErrno(PROGRAM_ERROR));
+                return;
+            }
+            conn->CloseAsync(
+                path.c_str(), size, 0, nodeId, [path, fd, size, nodeId, conn, complete](CuckooErrorCode errorCode) {
+#ifdef ZK_INIT
+                    if (errorCode == SERVER_FAULT) {
+                        CuckooAsyncWindow::GetInstance().Run([=]() {
+                            std::shared_ptr<Connection> retryConn = conn;
+                            CuckooErrorCode retryCode = errorCode;
+                            for (int cnt = 0; cnt < RETRY_CNT && retryCode == SERVER_FAULT; ++cnt) {
+                                sleep(SLEEPTIME);
+                                retryConn = router->TryToUpdateWorkerConn(retryConn);
+                                retryCode = retryConn->Close(path.c_str(), size, 0, nodeId);
+                            }
+                            CuckooCloseRelease(fd, false, size);
+                            complete(ToErrno(retryCode));
+                        });
+                        return;
+                    }
+#endif
+                    CuckooCloseRelease(fd, false, size);
+                    complete(ToErrno(errorCode));
+                });
+        },
+        std::move(done));
+}
+
+/* wrap a callback based call into a future, a failed submit is reported through the future as well */
+template <typename Call>
+static std::future<int> ToFuture(Call call)
+{
+    auto promise = std::make_shared<std::promise<int>>();
+    std::future<int> future = promise->get_future();
+    int ret = call([promise](int opRet) { promise->set_value(opRet); });
+    if (ret != 0) {
+        promise->set_value(ret);
+    }
+    return future;
+}
+
+std::future<int> CuckooOpenAsync(const std::string &path, int oflags, uint64_t *fd, struct stat *stbuf)
+{
+    return ToFuture([&](CuckooAsyncCallback done) { return CuckooOpenAsync(path, oflags, fd, stbuf, done); });
+}
+
+std::future<int> CuckooReadAsync(const std::string &path, uint64_t fd, char *buffer, size_t size, off_t offset)
+{
+    return ToFuture([&](CuckooAsyncCallback done) { return CuckooReadAsync(path, fd, buffer, size, offset, done); });
+}
+
+std::future<int> CuckooWriteAsync(uint64_t fd, const std::string &path, const char *buffer, size_t size, off_t offset)
+{
+    return ToFuture([&](CuckooAsyncCallback done) { return CuckooWriteAsync(fd, path, buffer, size, offset, done); });
+}
+
+std::future<int> CuckooGetStatAsync(const std::string &path, struct stat *stbuf)
+{
+    return ToFuture([&](CuckooAsyncCallback done) { return CuckooGetStatAsync(path, stbuf, done); });
+}
+
+std::future<int> CuckooCloseAsync(const std::string &path, uint64_t fd)
+{
+    return ToFuture([&](CuckooAsyncCallback done) { return CuckooCloseAsync(path, fd, done); });
+}
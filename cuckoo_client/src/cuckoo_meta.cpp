@@ -5,6 +5,7 @@
 #include "cuckoo_meta.h"
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
@@ -12,6 +13,7 @@
 #include <mutex>
 #include <unordered_map>
 
+#include <sys/file.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 
@@ -20,6 +22,7 @@
 #include "cuckoo_store/cuckoo_store.h"
 #include "inner_cuckoo_meta.h"
 #include "router.h"
+#include "util/access_trace.h"
 #include "utils.h"
 
 constexpr int FILE_NUMBER_PER_EPOCH = 1048576;
@@ -27,6 +30,19 @@ constexpr int FILE_NUMBER_PER_WORKER = 4096;
 
 std::shared_ptr<Router> router;
 
+static void RecordAccess(OpenInstance *openInstance, off_t offset, size_t size)
+{
+    AccessTraceRecorder &recorder = AccessTraceRecorder::GetInstance();
+    if (recorder.Started()) {
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        recorder.Record(openInstance->inodeId,
+                        openInstance->path,
+                        offset,
+                        size,
+                        std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+    }
+}
+
 int CuckooInit(std::string &coordinatorIp, int coordinatorPort)
 {
     int ret = CuckooStore::GetInstance()->GetInitStatus();
@@ -146,11 +162,6 @@ int CuckooOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *s
         return PROGRAM_ERROR;
     }
 
-    std::shared_ptr<OpenInstance> openInstance = CuckooFd::GetInstance()->WaitGetNewOpenInstance();
-    if (openInstance == nullptr) {
-        CUCKOO_LOG(LOG_ERROR) << "new openInstance failed";
-        return -ENOMEM;
-    }
     uint64_t inodeId = 0;
     int64_t size = 0;
     int32_t nodeId = 0;
@@ -164,6 +175,19 @@ int CuckooOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *s
         errorCode = conn->Open(path.c_str(), inodeId, size, nodeId, stbuf);
     }
 #endif
+    if (errorCode != SUCCESS) {
+        return errorCode;
+    }
+    return CuckooAttachOpen(path, oflags, fd, inodeId, size, nodeId);
+}
+
+int CuckooAttachOpen(const std::string &path, int oflags, uint64_t &fd, uint64_t inodeId, int64_t size, int32_t nodeId)
+{
+    std::shared_ptr<OpenInstance> openInstance = CuckooFd::GetInstance()->WaitGetNewOpenInstance();
+    if (openInstance == nullptr) {
+        CUCKOO_LOG(LOG_ERROR) << "new openInstance failed";
+        return -ENOMEM;
+    }
     openInstance->inodeId = inodeId;
     openInstance->originalSize = size;
     openInstance->currentSize = size;
@@ -171,47 +195,72 @@ int CuckooOpen(const std::string &path, int oflags, uint64_t &fd, struct stat *s
     openInstance->path = path;
     openInstance->oflags = oflags;
 
-    /******************* Fetch open meta finish ************************/
-
     /* allocate fd and handle the small file read */
-    if (errorCode == SUCCESS) {
-        if (openInstance->originalSize > 0 && openInstance->originalSize < READ_BIGFILE_SIZE &&
-            (openInstance->oflags & O_ACCMODE) == O_RDONLY) {
-            // For small files: read all when open
-            std::shared_ptr<char> buffer;
-            if (openInstance->oflags & __O_DIRECT) {
-                int alignedNum = openInstance->originalSize / 512 + int(openInstance->originalSize % 512 != 0);
-                buffer = std::shared_ptr<char>((char *)aligned_alloc(512, 512 * alignedNum), free);
-            } else {
-                buffer = std::shared_ptr<char>((char *)malloc(openInstance->originalSize), free);
-            }
-            if (buffer == nullptr) {
-                CUCKOO_LOG(LOG_ERROR) << "In CuckooOpen() malloc failed";
-                CuckooFd::GetInstance()->ReleaseOpenInstance();
-                return -ENOMEM;
-            }
-            openInstance->readBuffer = buffer;
-            openInstance->readBufferSize = openInstance->originalSize;
-            int ret = InnerCuckooReadSmallFiles(openInstance.get());
-            if (ret < 0) {
-                CuckooFd::GetInstance()->ReleaseOpenInstance();
-                return ret;
-            }
+    if (openInstance->originalSize > 0 && openInstance->originalSize < READ_BIGFILE_SIZE &&
+        (openInstance->oflags & O_ACCMODE) == O_RDONLY) {
+        // For small files: read all when open
+        std::shared_ptr<char> buffer;
+        if (openInstance->oflags & __O_DIRECT) {
+            int alignedNum = openInstance->originalSize / 512 + int(openInstance->originalSize % 512 != 0);
+            buffer = std::shared_ptr<char>((char *)aligned_alloc(512, 512 * alignedNum), free);
+        } else {
+            buffer = std::shared_ptr<char>((char *)malloc(openInstance->originalSize), free);
+        }
+        if (buffer == nullptr) {
+            CUCKOO_LOG(LOG_ERROR) << "In CuckooOpen() malloc failed";
+            return -ENOMEM;
+        }
+        openInstance->SetReadBuffer(buffer, static_cast<int>(openInstance->originalSize));
+        int ret = InnerCuckooReadSmallFiles(openInstance.get());
+        if (ret < 0) {
+            return ret;
         }
-        fd = CuckooFd::GetInstance()->AttachFd(path, openInstance);
     }
-    return errorCode;
+    fd = CuckooFd::GetInstance()->AttachFd(path, openInstance);
+    return SUCCESS;
 }
 
 int CuckooClose(const std::string &path, uint64_t fd, bool isFlush, int datasync)
 {
+    bool needMeta = false;
+    int64_t size = 0;
+    int32_t nodeId = 0;
+    int ret = CuckooCloseData(fd, isFlush, datasync, needMeta, size, nodeId);
+    if (!needMeta) {
+        return ret;
+    }
+
+    std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
+    if (!conn) {
+        CUCKOO_LOG(LOG_ERROR) << "route error";
+        return PROGRAM_ERROR;
+    }
+
+    int errorCode = conn->Close(path.c_str(), size, 0, nodeId);
+#ifdef ZK_INIT
+    int cnt = 0;
+    while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+        ++cnt;
+        sleep(SLEEPTIME);
+        conn = router->TryToUpdateWorkerConn(conn);
+        errorCode = conn->Close(path.c_str(), size, 0, nodeId);
+    }
+#endif
+    CuckooCloseRelease(fd, isFlush, size);
+    return errorCode;
+}
+
+int CuckooCloseData(uint64_t fd, bool isFlush, int datasync, bool &needMeta, int64_t &size, int32_t &nodeId)
+{
+    needMeta = false;
     OpenInstance *openInstance = CuckooFd::GetInstance()->GetOpenInstanceByFd(fd).get();
     if (openInstance == nullptr) {
         CUCKOO_LOG(LOG_ERROR) << "In CuckooClose(): fd not found for openInstance";
         return NOT_FOUND_FD;
     }
 
-    size_t size = openInstance->currentSize;
+    size = openInstance->currentSize;
+    nodeId = openInstance->nodeId;
     // only read small files does not open file
     if (openInstance->isOpened) {
         int innerRet = InnerCuckooTmpClose(openInstance, isFlush, datasync >= 0); // here may fail, mark in writeFail
@@ -234,28 +283,20 @@ int CuckooClose(const std::string &path, uint64_t fd, bool isFlush, int datasync
         }
         return SUCCESS;
     }
+    needMeta = true;
+    return SUCCESS;
+}
 
-    std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
-    if (!conn) {
-        CUCKOO_LOG(LOG_ERROR) << "route error";
-        return PROGRAM_ERROR;
-    }
-
-    int errorCode = conn->Close(path.c_str(), size, 0, openInstance->nodeId);
-#ifdef ZK_INIT
-    int cnt = 0;
-    while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
-        ++cnt;
-        sleep(SLEEPTIME);
-        conn = router->TryToUpdateWorkerConn(conn);
-        errorCode = conn->Close(path.c_str(), size, 0, openInstance->nodeId);
+void CuckooCloseRelease(uint64_t fd, bool isFlush, int64_t size)
+{
+    OpenInstance *openInstance = CuckooFd::GetInstance()->GetOpenInstanceByFd(fd).get();
+    if (openInstance == nullptr) {
+        return;
     }
-#endif
     openInstance->originalSize = size;
     if (!isFlush) {
         CuckooFd::GetInstance()->DeleteOpenInstance(fd);
     }
-    return errorCode;
 }
 
 int CuckooUnlink(const std::string &path)
@@ -269,18 +310,20 @@ int CuckooUnlink(const std::string &path)
     uint64_t inodeId = 0;
     int64_t size = 0;
     int32_t nodeId = 0;
-    int errorCode = conn->Unlink(path.c_str(), inodeId, size, nodeId);
+    uint64_t nlink = 0;
+    int errorCode = conn->Unlink(path.c_str(), inodeId, size, nodeId, &nlink);
 #ifdef ZK_INIT
     int cnt = 0;
     while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
         ++cnt;
         sleep(SLEEPTIME);
         conn = router->TryToUpdateWorkerConn(conn);
-        errorCode = conn->Unlink(path.c_str(), inodeId, size, nodeId);
+        errorCode = conn->Unlink(path.c_str(), inodeId, size, nodeId, &nlink);
     }
 #endif
     int ret = 0;
-    if (errorCode == SUCCESS) {
+    // data is shared by all hard links, keep it until the last name is gone
+    if (errorCode == SUCCESS && nlink == 0) {
         // delete data
         ret = InnerCuckooUnlink(inodeId, nodeId, path);
         if (ret != 0) {
@@ -429,6 +472,7 @@ int CuckooCloseDir(uint64_t fd)
 
 int CuckooDestroy()
 {
+    AccessTraceRecorder::GetInstance().Stop();
     CuckooStore::GetInstance()->DeleteInstance();
 
     return 0;
@@ -479,6 +523,26 @@ int CuckooRead(const std::string & /*path*/, uint64_t fd, char *buffer, size_t s
     int ret = InnerCuckooRead(openInstance.get(), buffer, size, offset);
     if (ret < 0) {
         openInstance->readFail = true;
+    } else {
+        RecordAccess(openInstance.get(), offset, ret);
+    }
+    return ret;
+}
+
+int CuckooReadFd(const std::string & /*path*/, uint64_t fd, size_t size, off_t offset, int &localFd, size_t &readSize)
+{
+    std::shared_ptr<OpenInstance> openInstance = CuckooFd::GetInstance()->GetOpenInstanceByFd(fd);
+    if (openInstance == nullptr) {
+        CUCKOO_LOG(LOG_ERROR) << "In CuckooReadFd(): fd not found for openInstance";
+        return NOT_FOUND_FD;
+    }
+
+    int ret = InnerCuckooGetLocalReadFd(openInstance.get(), size, offset, localFd, readSize);
+    if (ret < 0) {
+        openInstance->readFail = true;
+    } else if (ret == 0 && localFd >= 0) {
+        /* read through the fd by the caller, else through CuckooRead which records it */
+        RecordAccess(openInstance.get(), offset, readSize);
     }
     return ret;
 }
@@ -557,6 +621,81 @@ int CuckooFsync(const std::string &path, uint64_t fd, int datasync)
     return CuckooClose(path, fd, true, datasync == 0 ? 0 : 1);
 }
 
+/* locks of an owner are dropped through any fd of the file, so look at all instances of the inode */
+static bool InodeFileLocked(uint64_t inodeId)
+{
+    for (auto &openInstance : CuckooFd::GetInstance()->GetInodetoOpenInstanceSet(inodeId)) {
+        if (openInstance->fileLocked.load()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+int CuckooLock(const std::string & /*path*/,
+               uint64_t fd,
+               int cmd,
+               struct flock *lock,
+               uint64_t owner,
+               const std::function<bool()> &interrupted)
+{
+    std::shared_ptr<OpenInstance> openInstance = CuckooFd::GetInstance()->GetOpenInstanceByFd(fd);
+    if (openInstance == nullptr) {
+        CUCKOO_LOG(LOG_ERROR) << "In CuckooLock(): fd not found for openInstance";
+        return NOT_FOUND_FD;
+    }
+    if (cmd != F_GETLK && cmd != F_SETLK && cmd != F_SETLKW) {
+        return -EINVAL;
+    }
+    if (cmd != F_GETLK && lock->l_type == F_UNLCK && !InodeFileLocked(openInstance->inodeId)) {
+        /* fuse unlocks on every flush, skip the round trip if nothing could be locked */
+        return 0;
+    }
+    int ret = InnerCuckooLockFile(openInstance->inodeId, cmd, lock, owner, RangeLockType::POSIX, interrupted);
+    if (ret == 0 && cmd != F_GETLK && lock->l_type != F_UNLCK) {
+        openInstance->fileLocked = true;
+    }
+    return ret;
+}
+
+int CuckooFlock(const std::string & /*path*/,
+                uint64_t fd,
+                int op,
+                uint64_t owner,
+                const std::function<bool()> &interrupted)
+{
+    std::shared_ptr<OpenInstance> openInstance = CuckooFd::GetInstance()->GetOpenInstanceByFd(fd);
+    if (openInstance == nullptr) {
+        CUCKOO_LOG(LOG_ERROR) << "In CuckooFlock(): fd not found for openInstance";
+        return NOT_FOUND_FD;
+    }
+    /* a flock is a lock on the whole file */
+    struct flock lock = {};
+    lock.l_whence = SEEK_SET;
+    switch (op & ~LOCK_NB) {
+    case LOCK_SH:
+        lock.l_type = F_RDLCK;
+        break;
+    case LOCK_EX:
+        lock.l_type = F_WRLCK;
+        break;
+    case LOCK_UN:
+        lock.l_type = F_UNLCK;
+        break;
+    default:
+        return -EINVAL;
+    }
+    if (lock.l_type == F_UNLCK && !InodeFileLocked(openInstance->inodeId)) {
+        return 0;
+    }
+    int cmd = (op & LOCK_NB) != 0 ? F_SETLK : F_SETLKW;
+    int ret = InnerCuckooLockFile(openInstance->inodeId, cmd, &lock, owner, RangeLockType::FLOCK, interrupted);
+    if (ret == 0 && lock.l_type != F_UNLCK) {
+        openInstance->fileLocked = true;
+    }
+    return ret;
+}
+
 int CuckooStatFS(struct statvfs *vfsbuf)
 {
     int ret = InnerCuckooStatFS(vfsbuf);
@@ -626,6 +765,155 @@ int CuckooChmod(const std::string &path, mode_t mode)
     return errorCode;
 }
 
+int CuckooSetXattr(const std::string &path, const std::string &key, const char *value, size_t size, int flags)
+{
+    std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
+    if (!conn) {
+        CUCKOO_LOG(LOG_ERROR) << "route error";
+        return PROGRAM_ERROR;
+    }
+
+    int errorCode = conn->SetXattr(path.c_str(), key.c_str(), value, size, flags);
+#ifdef ZK_INIT
+    int cnt = 0;
+    while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+        ++cnt;
+        sleep(SLEEPTIME);
+        conn = router->TryToUpdateWorkerConn(conn);
+        errorCode = conn->SetXattr(path.c_str(), key.c_str(), value, size, flags);
+    }
+#endif
+    return errorCode;
+}
+
+int CuckooGetXattr(const std::string &path, const std::string &key, std::string &value)
+{
+    std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
+    if (!conn) {
+        CUCKOO_LOG(LOG_ERROR) << "route error";
+        return PROGRAM_ERROR;
+    }
+
+    int errorCode = conn->GetXattr(path.c_str(), key.c_str(), value);
+#ifdef ZK_INIT
+    int cnt = 0;
+    while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+        ++cnt;
+        sleep(SLEEPTIME);
+        conn = router->TryToUpdateWorkerConn(conn);
+        errorCode = conn->GetXattr(path.c_str(), key.c_str(), value);
+    }
+#endif
+    return errorCode;
+}
+
+int CuckooListXattr(const std::string &path, std::vector<std::string> &keys)
+{
+    std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
+    if (!conn) {
+        CUCKOO_LOG(LOG_ERROR) << "route error";
+        return PROGRAM_ERROR;
+    }
+
+    int errorCode = conn->ListXattr(path.c_str(), keys);
+#ifdef ZK_INIT
+    int cnt = 0;
+    while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+        ++cnt;
+        sleep(SLEEPTIME);
+        conn = router->TryToUpdateWorkerConn(conn);
+        errorCode = conn->ListXattr(path.c_str(), keys);
+    }
+#endif
+    return errorCode;
+}
+
+int CuckooRemoveXattr(const std::string &path, const std::string &key)
+{
+    std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
+    if (!conn) {
+        CUCKOO_LOG(LOG_ERROR) << "route error";
+        return PROGRAM_ERROR;
+    }
+
+    int errorCode = conn->RemoveXattr(path.c_str(), key.c_str());
+#ifdef ZK_INIT
+    int cnt = 0;
+    while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+        ++cnt;
+        sleep(SLEEPTIME);
+        conn = router->TryToUpdateWorkerConn(conn);
+        errorCode = conn->RemoveXattr(path.c_str(), key.c_str());
+    }
+#endif
+    return errorCode;
+}
+
+/* symlink is stored as an inode on the worker owning the link path */
+int CuckooSymlink(const std::string &target, const std::string &path)
+{
+    std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
+    if (!conn) {
+        CUCKOO_LOG(LOG_ERROR) << "route error";
+        return PROGRAM_ERROR;
+    }
+
+    int errorCode = conn->Symlink(target.c_str(), path.c_str());
+#ifdef ZK_INIT
+    int cnt = 0;
+    while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+        ++cnt;
+        sleep(SLEEPTIME);
+        conn = router->TryToUpdateWorkerConn(conn);
+        errorCode = conn->Symlink(target.c_str(), path.c_str());
+    }
+#endif
+    return errorCode;
+}
+
+int CuckooReadlink(const std::string &path, std::string &target)
+{
+    std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(path);
+    if (!conn) {
+        CUCKOO_LOG(LOG_ERROR) << "route error";
+        return PROGRAM_ERROR;
+    }
+
+    int errorCode = conn->Readlink(path.c_str(), target);
+#ifdef ZK_INIT
+    int cnt = 0;
+    while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+        ++cnt;
+        sleep(SLEEPTIME);
+        conn = router->TryToUpdateWorkerConn(conn);
+        errorCode = conn->Readlink(path.c_str(), target);
+    }
+#endif
+    return errorCode;
+}
+
+/* both names must be owned by the same worker, otherwise EXDEV is returned */
+int CuckooLink(const std::string &src, const std::string &dst)
+{
+    std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(src);
+    if (!conn) {
+        CUCKOO_LOG(LOG_ERROR) << "route error";
+        return PROGRAM_ERROR;
+    }
+
+    int errorCode = conn->Link(src.c_str(), dst.c_str());
+#ifdef ZK_INIT
+    int cnt = 0;
+    while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+        ++cnt;
+        sleep(SLEEPTIME);
+        conn = router->TryToUpdateWorkerConn(conn);
+        errorCode = conn->Link(src.c_str(), dst.c_str());
+    }
+#endif
+    return errorCode;
+}
+
 // User shouldn't cmake concurrent truncate and open
 int CuckooTruncate(const std::string &path, off_t size)
 {
@@ -0,0 +1,358 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "cuckoo_preload.h"
+
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "cuckoo_meta.h"
+#include "cuckoo_store/cuckoo_store.h"
+#include "log/logging.h"
+#include "util/access_trace.h"
+#include "util/preload.h"
+
+struct PreloadFileInfo
+{
+    std::string path;
+    uint64_t inodeId = 0;
+    int64_t size = 0;
+    int32_t nodeId = -1;
+    bool found = false;
+};
+
+struct PreloadDirEntries
+{
+    /* all entries passed to the filler, . and .. included, as the offset to go on from */
+    uint64_t seen = 0;
+    std::vector<std::pair<std::string, bool>> children;
+};
+
+class PreloadJob : public AccessTraceBackend {
+  public:
+    PreloadJob(const CuckooPreloadOptions &options, const CuckooPreloadCallback &progress)
+        : options(options),
+          progress(progress),
+          bucket(options.bandwidth),
+          start(std::chrono::steady_clock::now())
+    {
+    }
+
+    int Run(const std::string &path);
+    /* preload the files of a recorded trace in the order the job read them first */
+    int RunTrace(const std::string &traceFile);
+    int Warm(const AccessTraceRecord &record) override;
+
+  private:
+    /* fn with the progress reported while it runs and once after */
+    int WithProgress(const std::function<int()> &fn);
+    int PreloadTree(const std::string &path);
+    int ReplayTrace(const std::string &traceFile);
+    int Walk(const std::string &path);
+    int ListDir(const std::string &dir, PreloadDirEntries &entries);
+    int Lookup(PreloadFileInfo &file);
+    int Preload(PreloadFileInfo &file);
+    /* fn(i) for i in [0, num), on up to options.concurrency threads */
+    void ForEach(size_t num, const std::function<void(size_t)> &fn);
+    void Report(std::stop_token stoken);
+    CuckooPreloadProgress Snapshot();
+    void SetError(int ret);
+
+    const CuckooPreloadOptions &options;
+    const CuckooPreloadCallback &progress;
+    TokenBucket bucket;
+    std::chrono::steady_clock::time_point start;
+    std::vector<PreloadFileInfo> files;
+    std::atomic<uint64_t> totalFiles = 0;
+    std::atomic<uint64_t> totalBytes = 0;
+    std::atomic<uint64_t> doneFiles = 0;
+    std::atomic<uint64_t> doneBytes = 0;
+    std::atomic<uint64_t> failedFiles = 0;
+    /* the rate for the eta counts from when the loads start, 0 before */
+    std::atomic<int64_t> loadStartMs = 0;
+    std::atomic<int> firstError = 0;
+};
+
+static uint64_t NowMs()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+}
+
+static int CollectEntry(void *buf, const char *name, const struct stat *stbuf, off_t /*offset*/)
+{
+    auto *entries = static_cast<PreloadDirEntries *>(buf);
+    ++entries->seen;
+    /* . and .. come without a stat */
+    if (stbuf != nullptr && (S_ISDIR(stbuf->st_mode) || S_ISREG(stbuf->st_mode))) {
+        entries->children.emplace_back(name, S_ISDIR(stbuf->st_mode));
+    }
+    return 0;
+}
+
+void PreloadJob::SetError(int ret)
+{
+    int expected = 0;
+    firstError.compare_exchange_strong(expected, ret);
+}
+
+int PreloadJob::ListDir(const std::string &dir, PreloadDirEntries &entries)
+{
+    CuckooFuseInfo fi;
+    memset(&fi, 0, sizeof(fi));
+    int ret = CuckooOpenDir(dir, &fi);
+    if (ret != 0) {
+        return ret;
+    }
+    uint64_t seen = 0;
+    do {
+        seen = entries.seen;
+        ret = CuckooReadDir(dir, &entries, CollectEntry, static_cast<off_t>(entries.seen), &fi);
+    } while (ret == 0 && entries.seen != seen);
+    int closeRet = CuckooCloseDir(fi.fh);
+    return ret != 0 ? ret : closeRet;
+}
+
+int PreloadJob::Walk(const std::string &path)
+{
+    struct stat st;
+    int ret = CuckooGetStat(path, &st);
+    if (ret != 0) {
+        return ret;
+    }
+    if (S_ISREG(st.st_mode)) {
+        files.push_back(PreloadFileInfo{.path = path});
+        ++totalFiles;
+        return 0;
+    }
+    if (!S_ISDIR(st.st_mode)) {
+        return -EINVAL;
+    }
+
+    std::vector<std::string> dirs{path};
+    while (!dirs.empty()) {
+        std::string dir = std::move(dirs.back());
+        dirs.pop_back();
+        PreloadDirEntries entries;
+        ret = ListDir(dir, entries);
+        if (ret != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "CuckooPreload(): List " << dir << " failed: " << ret;
+            SetError(ret);
+            continue;
+        }
+        std::string prefix = dir.ends_with('/') ? dir : dir + "/";
+        for (auto &[name, isDir] : entries.children) {
+            if (isDir) {
+                dirs.push_back(prefix + name);
+            } else {
+                files.push_back(PreloadFileInfo{.path = prefix + name});
+                ++totalFiles;
+            }
+        }
+    }
+    return 0;
+}
+
+int PreloadJob::Lookup(PreloadFileInfo &file)
+{
+    std::shared_ptr<Connection> conn = router->GetWorkerConnByPath(file.path);
+    if (!conn) {
+        CUCKOO_LOG(LOG_ERROR) << "route error";
+        return PROGRAM_ERROR;
+    }
+    struct stat stbuf;
+    int errorCode = conn->Open(file.path.c_str(), file.inodeId, file.size, file.nodeId, &stbuf);
+#ifdef ZK_INIT
+    int cnt = 0;
+    while (cnt < RETRY_CNT && errorCode == SERVER_FAULT) {
+        ++cnt;
+        sleep(SLEEPTIME);
+        conn = router->TryToUpdateWorkerConn(conn);
+        errorCode = conn->Open(file.path.c_str(), file.inodeId, file.size, file.nodeId, &stbuf);
+    }
+#endif
+    return errorCode;
+}
+
+int PreloadJob::Preload(PreloadFileInfo &file)
+{
+    uint64_t wait = 0;
+    while ((wait = bucket.Take(file.size, NowMs())) > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+    }
+    /* routed by the same placement an open of the file uses */
+    return CuckooStore::GetInstance()->PreloadFile(file.inodeId, file.nodeId, file.path, file.size, options.ttlSec);
+}
+
+void PreloadJob::ForEach(size_t num, const std::function<void(size_t)> &fn)
+{
+    std::atomic<size_t> next = 0;
+    size_t threadNum = std::min<size_t>(std::max<uint32_t>(options.concurrency, 1), num);
+    std::vector<std::jthread> threads;
+    for (size_t t = 0; t < threadNum; ++t) {
+        threads.emplace_back([&next, num, &fn]() {
+            for (size_t i = next++; i < num; i = next++) {
+                fn(i);
+            }
+        });
+    }
+}
+
+CuckooPreloadProgress PreloadJob::Snapshot()
+{
+    CuckooPreloadProgress snapshot;
+    snapshot.totalFiles = totalFiles;
+    snapshot.totalBytes = totalBytes;
+    snapshot.doneFiles = doneFiles;
+    snapshot.doneBytes = doneBytes;
+    snapshot.failedFiles = failedFiles;
+    snapshot.elapsedSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    int64_t loadMs = loadStartMs == 0 ? 0 : static_cast<int64_t>(NowMs()) - loadStartMs;
+    if (snapshot.doneFiles + snapshot.failedFiles >= snapshot.totalFiles && loadStartMs != 0) {
+        snapshot.etaSec = 0;
+    } else if (loadMs > 0 && snapshot.doneBytes > 0) {
+        double rate = static_cast<double>(snapshot.doneBytes) * 1000 / loadMs;
+        snapshot.etaSec = static_cast<double>(snapshot.totalBytes - snapshot.doneBytes) / rate;
+    }
+    return snapshot;
+}
+
+void PreloadJob::Report(std::stop_token stoken)
+{
+    std::mutex sleepMutex;
+    std::condition_variable_any sleepCv;
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    while (!stoken.stop_requested()) {
+        sleepCv.wait_for(lock, stoken, std::chrono::milliseconds(PRELOAD_PROGRESS_INTERVAL_MS), []() { return false; });
+        if (!stoken.stop_requested()) {
+            progress(Snapshot());
+        }
+    }
+}
+
+int PreloadJob::WithProgress(const std::function<int()> &fn)
+{
+    std::jthread reporter;
+    if (progress) {
+        reporter = std::jthread([this](std::stop_token stoken) { Report(stoken); });
+    }
+    int ret = fn();
+    if (reporter.joinable()) {
+        reporter.request_stop();
+        reporter.join();
+        progress(Snapshot());
+    }
+    return ret != 0 ? ret : firstError.load();
+}
+
+int PreloadJob::PreloadTree(const std::string &path)
+{
+    int ret = Walk(path);
+    if (ret != 0) {
+        return ret;
+    }
+    /* look all files up first, so that the eta knows the bytes to load */
+    ForEach(files.size(), [this](size_t i) {
+        int lookupRet = Lookup(files[i]);
+        if (lookupRet != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "CuckooPreload(): Lookup " << files[i].path << " failed: " << lookupRet;
+            SetError(lookupRet);
+            ++failedFiles;
+            return;
+        }
+        files[i].found = true;
+        totalBytes += files[i].size;
+    });
+    loadStartMs = NowMs();
+    ForEach(files.size(), [this](size_t i) {
+        if (!files[i].found) {
+            return;
+        }
+        int loadRet = Preload(files[i]);
+        if (loadRet != 0) {
+            SetError(loadRet);
+            ++failedFiles;
+            return;
+        }
+        ++doneFiles;
+        doneBytes += files[i].size;
+    });
+    return 0;
+}
+
+int PreloadJob::Warm(const AccessTraceRecord &record)
+{
+    /* looked up by path, the file may have been written again since the trace */
+    PreloadFileInfo file{.path = record.path};
+    int ret = Lookup(file);
+    if (ret == 0) {
+        ret = Preload(file);
+    } else {
+        CUCKOO_LOG(LOG_ERROR) << "CuckooReplayTrace(): Lookup " << file.path << " failed: " << ret;
+    }
+    if (ret != 0) {
+        ++failedFiles;
+        return ret;
+    }
+    ++doneFiles;
+    doneBytes += record.length;
+    return 0;
+}
+
+int PreloadJob::ReplayTrace(const std::string &traceFile)
+{
+    std::vector<AccessTraceRecord> records;
+    int ret = LoadAccessTrace(traceFile, records);
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "CuckooReplayTrace(): Load " << traceFile << " failed: " << strerror(-ret);
+        return ret;
+    }
+    std::vector<AccessTraceRecord> plan = PlanAccessTraceWarmup(records);
+    for (const AccessTraceRecord &record : plan) {
+        ++totalFiles;
+        totalBytes += record.length;
+    }
+    loadStartMs = NowMs();
+    return ReplayAccessTrace(plan, *this, options.concurrency);
+}
+
+int PreloadJob::Run(const std::string &path)
+{
+    return WithProgress([this, &path]() { return PreloadTree(path); });
+}
+
+int PreloadJob::RunTrace(const std::string &traceFile)
+{
+    return WithProgress([this, &traceFile]() { return ReplayTrace(traceFile); });
+}
+
+int CuckooPreload(const std::string &path, const CuckooPreloadOptions &options, const CuckooPreloadCallback &progress)
+{
+    PreloadJob job(options, progress);
+    return job.Run(path);
+}
+
+int CuckooReplayTrace(const std::string &traceFile,
+                      const CuckooPreloadOptions &options,
+                      const CuckooPreloadCallback &progress)
+{
+    PreloadJob job(options, progress);
+    return job.RunTrace(traceFile);
+}
+
+int CuckooStartAccessTrace(const std::string &traceFile)
+{
+    return AccessTraceRecorder::GetInstance().Start(traceFile);
+}
+
+void CuckooStopAccessTrace() { AccessTraceRecorder::GetInstance().Stop(); }
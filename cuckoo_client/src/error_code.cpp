@@ -64,7 +64,7 @@ int ErrorCodeToErrno(int errorCode)
         ret = EEXIST;
         break;
     case XKEY_NOT_EXISTS:
-        ret = ENOENT;
+        ret = ENODATA;
         break;
     // case LINK_EXISTS:
     //     ret = EISCONN;
@@ -96,6 +96,9 @@ int ErrorCodeToErrno(int errorCode)
     case PATH_NOT_EXISTS:
         ret = ENOENT;
         break;
+    case CROSS_WORKER_LINK:
+        ret = EXDEV;
+        break;
     default:
         ret = EIO;
         break;
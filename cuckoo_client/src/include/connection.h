@@ -4,9 +4,11 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <sys/stat.h>
 
@@ -60,6 +62,10 @@ class ConnectionCache {
 static thread_local ConnectionCache ThreadLocalConnectionCache;
 
 class Connection {
+  public:
+    /* called with the result of an async request, in a bthread of brpc */
+    using MetaCallback = std::function<void(CuckooErrorCode)>;
+
   private:
     brpc::Channel channel;
     cuckoo::meta_proto::MetaService_Stub stub;
@@ -69,6 +75,14 @@ class Connection {
                                    ResponseHandler responseHandler,
                                    ConnectionCache *cache = nullptr,
                                    ResultType *result = nullptr);
+    /* responseHandler runs before done, outputs it fills must stay valid until then */
+    template <typename ParamBuilder, typename ResponseHandler>
+    void ProcessRequestAsync(cuckoo::meta_proto::MetaServiceType type,
+                             const ParamBuilder &paramBuilder,
+                             ResponseHandler responseHandler,
+                             MetaCallback done);
+    template <typename ResponseHandler, typename ResultType>
+    static CuckooErrorCode ParseResponse(brpc::Controller &cntl, ResponseHandler &responseHandler, ResultType *result);
 
   public:
     ServerIdentifier server;
@@ -111,8 +125,21 @@ class Connection {
                          ConnectionCache *cache = nullptr);
     CuckooErrorCode
     Close(const char *path, int64_t size, uint64_t mtime, int32_t nodeId, ConnectionCache *cache = nullptr);
-    CuckooErrorCode
-    Unlink(const char *path, uint64_t &inodeId, int64_t &size, int32_t &nodeId, ConnectionCache *cache = nullptr);
+    /* Stat, Open and Close through brpc done closures, the caller is not blocked */
+    void StatAsync(const char *path, struct stat *stbuf, MetaCallback done);
+    void OpenAsync(const char *path,
+                   uint64_t *inodeId,
+                   int64_t *size,
+                   int32_t *nodeId,
+                   struct stat *stbuf,
+                   MetaCallback done);
+    void CloseAsync(const char *path, int64_t size, uint64_t mtime, int32_t nodeId, MetaCallback done);
+    CuckooErrorCode Unlink(const char *path,
+                           uint64_t &inodeId,
+                           int64_t &size,
+                           int32_t &nodeId,
+                           uint64_t *nlink = nullptr,
+                           ConnectionCache *cache = nullptr);
 
     struct ReadDirResponse
     {
@@ -136,4 +163,16 @@ class Connection {
     CuckooErrorCode UtimeNs(const char *path, int64_t atime = -1, int64_t mtime = -1, ConnectionCache *cache = nullptr);
     CuckooErrorCode Chown(const char *path, uint32_t uid, uint32_t gid, ConnectionCache *cache = nullptr);
     CuckooErrorCode Chmod(const char *path, uint32_t mode, ConnectionCache *cache = nullptr);
+    CuckooErrorCode SetXattr(const char *path,
+                             const char *key,
+                             const char *value,
+                             size_t size,
+                             int flags,
+                             ConnectionCache *cache = nullptr);
+    CuckooErrorCode GetXattr(const char *path, const char *key, std::string &value, ConnectionCache *cache = nullptr);
+    CuckooErrorCode ListXattr(const char *path, std::vector<std::string> &keys, ConnectionCache *cache = nullptr);
+    CuckooErrorCode RemoveXattr(const char *path, const char *key, ConnectionCache *cache = nullptr);
+    CuckooErrorCode Symlink(const char *target, const char *path, ConnectionCache *cache = nullptr);
+    CuckooErrorCode Readlink(const char *path, std::string &target, ConnectionCache *cache = nullptr);
+    CuckooErrorCode Link(const char *src, const char *dst, ConnectionCache *cache = nullptr);
 };
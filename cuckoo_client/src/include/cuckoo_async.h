@@ -0,0 +1,130 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+#include <bthread/condition_variable.h>
+#include <bthread/mutex.h>
+
+#include "thread_pool/thread_pool.h"
+
+/*
+ * Completion based variants of the libFS calls in cuckoo_meta.h.
+ * Metadata rpcs are sent with brpc done closures and complete in a bthread of brpc. Data of an fd goes
+ * through the cache and its streams, which block on disk IO and per file locks, so it runs on io threads
+ * of the window instead of bthread workers. Reads of an fd may run side by side, a write or close of it
+ * waits for the ops submitted before it and holds back the ones after it until it completes.
+ * Errors are -errno, both as the return value of a call and as ret passed to the callback, on success ret is
+ * what the synchronous call returns. A call returns 0 if the op is started and done is called only then.
+ * Buffers and output pointers must stay valid until completion.
+ */
+using CuckooAsyncCallback = std::function<void(int ret)>;
+
+/* bounds the number of async ops in flight, submit blocks when the window is full */
+class CuckooAsyncWindow {
+  public:
+    static CuckooAsyncWindow &GetInstance()
+    {
+        static CuckooAsyncWindow instance;
+        return instance;
+    }
+
+    void SetMaxInflight(uint32_t num);
+    uint32_t GetInflight();
+
+    /* take a slot for an op, the returned callback gives it back before calling done */
+    CuckooAsyncCallback Acquire(CuckooAsyncCallback done);
+    /*
+     * run op on an io thread, op calls complete once finished. An exclusive op starts after the ops submitted
+     * before it on fd have completed and the ops after it start after its completion, a shared op only waits
+     * for exclusive ones.
+     */
+    int Submit(uint64_t fd,
+               bool exclusive,
+               std::function<void(CuckooAsyncCallback complete)> op,
+               CuckooAsyncCallback done);
+    /* run task on an io thread, outside the window and the order of any fd */
+    void Run(std::function<void()> task);
+    /* wait until all submitted ops are finished, their callbacks may still be running */
+    void Drain();
+
+  private:
+    CuckooAsyncWindow();
+
+    struct FdTask
+    {
+        bool exclusive;
+        std::function<void(CuckooAsyncCallback)> op;
+        CuckooAsyncCallback complete;
+    };
+
+    /* the ops of an fd started and not completed yet, and the ones waiting behind them */
+    struct FdQueue
+    {
+        uint32_t running = 0;
+        bool exclusive = false;
+        std::deque<FdTask> waiting;
+    };
+
+    void Release();
+    void Start(uint64_t fd, FdTask task);
+    /* an op of fd has completed, start the waiting ops it held back */
+    void Finish(uint64_t fd);
+
+    static constexpr uint32_t DEFAULT_MAX_INFLIGHT = 256;
+    static constexpr uint32_t DEFAULT_IO_THREAD_NUM = 16;
+    static constexpr uint64_t IO_QUEUE_SIZE = 65536;
+
+    bthread::Mutex mutex;
+    bthread::ConditionVariable cv;
+    uint32_t maxInflight;
+    uint32_t inflight = 0;
+
+    /* fds with an op running */
+    std::mutex fdMutex;
+    std::unordered_map<uint64_t, FdQueue> fdQueues;
+    std::unique_ptr<ThreadPool> ioPool;
+};
+
+int CuckooOpenAsync(const std::string &path, int oflags, uint64_t *fd, struct stat *stbuf, CuckooAsyncCallback done);
+
+int CuckooReadAsync(const std::string &path,
+                    uint64_t fd,
+                    char *buffer,
+                    size_t size,
+                    off_t offset,
+                    CuckooAsyncCallback done);
+
+int CuckooWriteAsync(uint64_t fd,
+                     const std::string &path,
+                     const char *buffer,
+                     size_t size,
+                     off_t offset,
+                     CuckooAsyncCallback done);
+
+int CuckooGetStatAsync(const std::string &path, struct stat *stbuf, CuckooAsyncCallback done);
+
+/* flush and release fd, after the ops submitted before it on fd, the ops after it see fd closed */
+int CuckooCloseAsync(const std::string &path, uint64_t fd, CuckooAsyncCallback done);
+
+std::future<int> CuckooOpenAsync(const std::string &path, int oflags, uint64_t *fd, struct stat *stbuf);
+
+std::future<int> CuckooReadAsync(const std::string &path, uint64_t fd, char *buffer, size_t size, off_t offset);
+
+std::future<int> CuckooWriteAsync(uint64_t fd, const std::string &path, const char *buffer, size_t size, off_t offset);
+
+std::future<int> CuckooGetStatAsync(const std::string &path, struct stat *stbuf);
+
+std::future<int> CuckooCloseAsync(const std::string &path, uint64_t fd);
@@ -4,8 +4,12 @@
 
 #pragma once
 
+#include <fcntl.h>
 #include <stdint.h>
+#include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "router.h"
 
@@ -68,10 +72,31 @@ int CuckooWrite(uint64_t fd, const std::string &path, const char *buffer, size_t
 
 int CuckooRead(const std::string &path, uint64_t fd, char *buffer, size_t size, off_t offset);
 
+/* localFd is set to the local cache file if [offset, offset + readSize) can be read from it directly, else -1 */
+int CuckooReadFd(const std::string &path, uint64_t fd, size_t size, off_t offset, int &localFd, size_t &readSize);
+
 int CuckooRename(const std::string &srcName, const std::string &dstName);
 
 int CuckooFsync(const std::string &path, uint64_t fd, int datasync);
 
+/*
+ * fcntl(F_GETLK/F_SETLK/F_SETLKW) byte range lock of owner, shared by all clients of the file. A waiting lock
+ * returns -EDEADLK if it would deadlock, or -EINTR once interrupted returns true
+ */
+int CuckooLock(const std::string &path,
+               uint64_t fd,
+               int cmd,
+               struct flock *lock,
+               uint64_t owner,
+               const std::function<bool()> &interrupted = nullptr);
+
+/* flock(op) of owner, independent of the fcntl locks */
+int CuckooFlock(const std::string &path,
+                uint64_t fd,
+                int op,
+                uint64_t owner,
+                const std::function<bool()> &interrupted = nullptr);
+
 int CuckooStatFS(struct statvfs *vfsbuf);
 
 int CuckooDeleteCache(const std::string &path);
@@ -82,6 +107,20 @@ int CuckooChown(const std::string &path, uid_t uid, gid_t gid);
 
 int CuckooChmod(const std::string &path, mode_t mode);
 
+int CuckooSetXattr(const std::string &path, const std::string &key, const char *value, size_t size, int flags);
+
+int CuckooGetXattr(const std::string &path, const std::string &key, std::string &value);
+
+int CuckooListXattr(const std::string &path, std::vector<std::string> &keys);
+
+int CuckooRemoveXattr(const std::string &path, const std::string &key);
+
+int CuckooSymlink(const std::string &target, const std::string &path);
+
+int CuckooReadlink(const std::string &path, std::string &target);
+
+int CuckooLink(const std::string &src, const std::string &dst);
+
 int CuckooTruncate(const std::string &path, off_t size);
 
 int CuckooRenamePersist(const std::string &srcName, const std::string &dstName);
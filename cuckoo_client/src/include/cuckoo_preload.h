@@ -0,0 +1,64 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <functional>
+#include <string>
+
+/*
+ * Warms the cache disks with a tree before a job reads it. The files under path are looked up, and each
+ * is loaded from storage by the node it is placed on, the same node a later open reads it from. Loads run
+ * in parallel over all nodes within the limits of CuckooPreloadOptions.
+ */
+struct CuckooPreloadOptions
+{
+    /* files loading at once over all nodes */
+    uint32_t concurrency = 16;
+    /* bytes per second loaded over all nodes, 0 is unlimited */
+    uint64_t bandwidth = 0;
+    /* seconds the files stay pinned in the cache, 0 leaves them to eviction */
+    uint32_t ttlSec = 0;
+};
+
+/* in a replay of a trace the bytes are those the job read, not the sizes of the files */
+struct CuckooPreloadProgress
+{
+    /* grow while the tree is listed and looked up */
+    uint64_t totalFiles = 0;
+    uint64_t totalBytes = 0;
+    uint64_t doneFiles = 0;
+    uint64_t doneBytes = 0;
+    uint64_t failedFiles = 0;
+    double elapsedSec = 0;
+    /* seconds left at the rate so far, negative until known */
+    double etaSec = -1;
+};
+
+using CuckooPreloadCallback = std::function<void(const CuckooPreloadProgress &progress)>;
+
+#define PRELOAD_PROGRESS_INTERVAL_MS 1000
+
+/*
+ * preload the file or tree at path, progress is called every PRELOAD_PROGRESS_INTERVAL_MS and once at the
+ * end. Files failing do not stop the others, the first error is returned.
+ */
+int CuckooPreload(const std::string &path,
+                  const CuckooPreloadOptions &options,
+                  const CuckooPreloadCallback &progress = nullptr);
+
+/*
+ * record the reads of this process to traceFile until CuckooStopAccessTrace, for a replay before the job
+ * runs again. A sequential pass over a file is recorded once. A trace running already is closed first, the
+ * FUSE client does this when user.cuckoo.access_trace is set on its mount root.
+ */
+int CuckooStartAccessTrace(const std::string &traceFile);
+
+void CuckooStopAccessTrace();
+
+/* preload the files of a trace in the order the recorded job first read them, the same way as CuckooPreload */
+int CuckooReplayTrace(const std::string &traceFile,
+                      const CuckooPreloadOptions &options,
+                      const CuckooPreloadCallback &progress = nullptr);
@@ -9,6 +9,7 @@
 #include <sys/time.h>
 
 #include "buffer/open_instance.h"
+#include "util/file_lock.h"
 
 struct BatchCreatePrams
 {
@@ -24,6 +25,7 @@ int InnerCuckooUnlink(uint64_t inodeId, int nodeId, std::string path);
 int InnerCuckooWrite(OpenInstance *openInstance, const char *buffer, size_t size, off_t offset);
 int InnerCuckooTmpClose(OpenInstance *openInstance, bool isFlush, bool isSync);
 int InnerCuckooRead(OpenInstance *openInstance, char *buffer, size_t size, off_t offset);
+int InnerCuckooGetLocalReadFd(OpenInstance *openInstance, size_t size, off_t offset, int &localFd, size_t &readSize);
 int InnerCuckooAsyncCopy(uint64_t inodeId, int &backupNodeId);
 
 int InnerCuckooReadSmallFiles(OpenInstance *openInstance);
@@ -32,3 +34,17 @@ int InnerCuckooCopydata(const std::string &srcName, const std::string &dstName);
 int InnerCuckooDeleteDataAfterRename(const std::string &objectName);
 int InnerCuckooTruncateOpenInstance(OpenInstance *openInstance, off_t size);
 int InnerCuckooTruncateFile(OpenInstance *openInstance, off_t size);
+/* CuckooOpen once the meta server answered: make the open instance and its fd */
+int CuckooAttachOpen(const std::string &path, int oflags, uint64_t &fd, uint64_t inodeId, int64_t size, int32_t nodeId);
+/*
+ * CuckooClose up to the meta server: flush the data of fd. If the size is to be sent, needMeta is set and fd is
+ * released by CuckooCloseRelease after that, else fd is released already unless isFlush.
+ */
+int CuckooCloseData(uint64_t fd, bool isFlush, int datasync, bool &needMeta, int64_t &size, int32_t &nodeId);
+void CuckooCloseRelease(uint64_t fd, bool isFlush, int64_t size);
+int InnerCuckooLockFile(uint64_t inodeId,
+                        int cmd,
+                        struct flock *lock,
+                        uint64_t owner,
+                        RangeLockType type,
+                        const std::function<bool()> &interrupted = nullptr);
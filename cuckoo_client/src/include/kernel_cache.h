@@ -0,0 +1,63 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <sys/stat.h>
+
+/*
+ * Decides whether kernel page cache of a file can be kept on open.
+ * In read-mostly mode files are treated as immutable after close, so pages cached by the
+ * kernel stay valid as long as inode, mtime and size seen on open are unchanged.
+ */
+class KernelCacheValidator {
+  public:
+    static KernelCacheValidator &GetInstance()
+    {
+        static KernelCacheValidator instance;
+        return instance;
+    }
+
+    void SetReadMostly(bool enable) { readMostly.store(enable); }
+    bool IsReadMostly() { return readMostly.load(); }
+
+    /* record attr seen on open, return true if kernel cache is still valid */
+    bool KeepCache(const std::string &path, const struct stat *stbuf);
+    /* drop the record if attr fetched by getattr differs */
+    void CheckAttr(const std::string &path, const struct stat *stbuf);
+    /* called when this client changes or removes the file */
+    void Invalidate(const std::string &path);
+
+  private:
+    static constexpr size_t SHARD_NUM = 64;
+
+    struct CachedAttr
+    {
+        uint64_t inodeId;
+        int64_t mtimeSec;
+        int64_t mtimeNsec;
+        int64_t size;
+
+        bool operator==(const CachedAttr &other) const = default;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<std::string, CachedAttr> attrs;
+    };
+
+    Shard &GetShard(const std::string &path) { return shards[std::hash<std::string>{}(path) % SHARD_NUM]; }
+    static CachedAttr ToCachedAttr(const struct stat *stbuf);
+
+    std::atomic<bool> readMostly{false};
+    std::array<Shard, SHARD_NUM> shards;
+};
@@ -21,6 +21,11 @@ int InnerCuckooRead(OpenInstance *openInstance, char *buffer, size_t size, off_t
     return CuckooStore::GetInstance()->ReadFile(openInstance, buffer, size, offset);
 }
 
+int InnerCuckooGetLocalReadFd(OpenInstance *openInstance, size_t size, off_t offset, int &localFd, size_t &readSize)
+{
+    return CuckooStore::GetInstance()->GetLocalReadFd(openInstance, size, offset, localFd, readSize);
+}
+
 int InnerCuckooReadSmallFiles(OpenInstance *openInstance)
 {
     return CuckooStore::GetInstance()->ReadSmallFiles(openInstance);
@@ -52,6 +57,16 @@ int InnerCuckooTruncateFile(OpenInstance *openInstance, off_t size)
     return CuckooStore::GetInstance()->TruncateFile(openInstance, size);
 }
 
+int InnerCuckooLockFile(uint64_t inodeId,
+                        int cmd,
+                        struct flock *lock,
+                        uint64_t owner,
+                        RangeLockType type,
+                        const std::function<bool()> &interrupted)
+{
+    return CuckooStore::GetInstance()->LockFile(inodeId, cmd, lock, owner, type, interrupted);
+}
+
 int InnerCuckooUnlink(uint64_t inodeId, int nodeId, std::string path)
 {
     return CuckooStore::GetInstance()->DeleteFiles(inodeId, nodeId, path);
@@ -0,0 +1,57 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "kernel_cache.h"
+
+KernelCacheValidator::CachedAttr KernelCacheValidator::ToCachedAttr(const struct stat *stbuf)
+{
+    return CachedAttr{static_cast<uint64_t>(stbuf->st_ino),
+                      static_cast<int64_t>(stbuf->st_mtim.tv_sec),
+                      static_cast<int64_t>(stbuf->st_mtim.tv_nsec),
+                      static_cast<int64_t>(stbuf->st_size)};
+}
+
+bool KernelCacheValidator::KeepCache(const std::string &path, const struct stat *stbuf)
+{
+    if (!readMostly.load() || stbuf == nullptr) {
+        return false;
+    }
+    CachedAttr attr = ToCachedAttr(stbuf);
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.attrs.find(path);
+    if (it == shard.attrs.end()) {
+        shard.attrs.emplace(path, attr);
+        return false;
+    }
+    if (it->second == attr) {
+        return true;
+    }
+    it->second = attr;
+    return false;
+}
+
+void KernelCacheValidator::CheckAttr(const std::string &path, const struct stat *stbuf)
+{
+    if (!readMostly.load() || stbuf == nullptr) {
+        return;
+    }
+    CachedAttr attr = ToCachedAttr(stbuf);
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.attrs.find(path);
+    if (it != shard.attrs.end() && !(it->second == attr)) {
+        shard.attrs.erase(it);
+    }
+}
+
+void KernelCacheValidator::Invalidate(const std::string &path)
+{
+    if (!readMostly.load()) {
+        return;
+    }
+    Shard &shard = GetShard(path);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.attrs.erase(path);
+}
@@ -5,6 +5,7 @@
 #include "brpc/brpc_server.h"
 
 #include <fcntl.h>
+#include <stdlib.h>
 #include <unistd.h>
 
 #include <brpc/server.h>
@@ -17,18 +18,39 @@
 #include "connection/node.h"
 #include "cuckoo_store/cuckoo_store.h"
 #include "log/logging.h"
+#include "remote_connection_utils/cuckoo_trace.h"
+#include "stats/cuckoo_metrics.h"
+#include "util/checksum.h"
+#include "util/crc32c.h"
 #include "util/utils.h"
 
 namespace cuckoo::brpc_io
 {
 constexpr size_t ALIGNMENT = 512;
 
+static uint32_t IOBufCrc32c(const butil::IOBuf &buf)
+{
+    uint32_t crc = 0;
+    for (size_t i = 0; i < buf.backing_block_num(); ++i) {
+        butil::StringPiece block = buf.backing_block(i);
+        crc = Crc32c(crc, block.data(), block.size());
+    }
+    return crc;
+}
+
+/*
+ * Handlers continue the trace of the client through the thread context, so spans below them, e.g. an
+ * OBS download, become children. A handler that blocks on bthread primitives may resume on another
+ * worker, its child spans are then attributed loosely, the handler span itself is always right.
+ */
+
 void RemoteIOServiceImpl::OpenFile(google::protobuf::RpcController * /*cntl_base*/,
                                    const OpenRequest *request,
                                    OpenReply *response,
                                    google::protobuf::Closure *done)
 {
     brpc::ClosureGuard doneGuard(done);
+    CuckooTraceScope trace("store_open", CuckooTraceExtract(*request));
 
     uint64_t inodeId = request->inode_id();
     uint64_t size = request->size();
@@ -56,7 +78,14 @@ void RemoteIOServiceImpl::OpenFile(google::protobuf::RpcController * /*cntl_base
     openInstance->isRemoteCall = true;
     openInstance->nodeFail = nodeFail;
 
-    int ret = CuckooStore::GetInstance()->OpenFile(openInstance.get());
+    int ret = 0;
+    if (request->replica()) {
+        ret = CuckooStore::GetInstance()->OpenReplica(openInstance.get(),
+                                                      request->primary_node_id(),
+                                                      request->replica_version());
+    } else {
+        ret = CuckooStore::GetInstance()->OpenFile(openInstance.get());
+    }
     if (ret != 0) {
         response->set_error_code(ret);
         response->set_physical_fd(0);
@@ -65,6 +94,14 @@ void RemoteIOServiceImpl::OpenFile(google::protobuf::RpcController * /*cntl_base
         uint64_t fd = CuckooFd::GetInstance()->AttachFd(path, openInstance);
         response->set_error_code(0);
         response->set_physical_fd(fd);
+        if ((oflags & O_ACCMODE) == O_RDONLY && !request->replica()) {
+            /* readers of a hot file spread over its replicas */
+            HotFileReplicas replicas = CuckooStore::GetInstance()->GetHotFileReplicas(inodeId);
+            response->set_replica_version(replicas.version);
+            for (int nodeId : replicas.nodeIds) {
+                response->add_replica_node_ids(nodeId);
+            }
+        }
         openInstance->isOpened = true;
         CUCKOO_LOG(LOG_INFO) << "OpenFile rpc request return with cuckooFd = " << fd;
     }
@@ -76,6 +113,7 @@ void RemoteIOServiceImpl::CloseFile(google::protobuf::RpcController *cntl_base,
                                     google::protobuf::Closure *done)
 {
     brpc::ClosureGuard doneGuard(done);
+    CuckooTraceScope trace("store_close", CuckooTraceExtract(*request));
     auto *cntl = static_cast<brpc::Controller *>(cntl_base);
 
     uint64_t fd = request->physical_fd();
@@ -116,7 +154,7 @@ void RemoteIOServiceImpl::CloseFile(google::protobuf::RpcController *cntl_base,
     }
     if (!flush) {
         openInstance->isClosed = true;
-        CuckooFd::GetInstance()->DeleteOpenInstance(fd, false);
+        CuckooFd::GetInstance()->DeleteOpenInstance(fd);
     }
 
     response->set_error_code(ret);
@@ -128,6 +166,7 @@ void RemoteIOServiceImpl::ReadFile(google::protobuf::RpcController *cntl_base,
                                    google::protobuf::Closure *done)
 {
     brpc::ClosureGuard doneGuard(done);
+    CuckooTraceScope trace("store_read", CuckooTraceExtract(*request));
     auto *cntl = static_cast<brpc::Controller *>(cntl_base);
 
     uint64_t fd = request->physical_fd();
@@ -177,6 +216,9 @@ void RemoteIOServiceImpl::ReadFile(google::protobuf::RpcController *cntl_base,
     }
 
     response->set_error_code(0);
+    if (ChecksumTable::GetInstance().Started()) {
+        response->set_data_crc(Crc32c(0, buffer, retSize));
+    }
     cntl->response_attachment().append_user_data(buffer, retSize, [](void *buf) { free(buf); });
 }
 
@@ -186,6 +228,7 @@ void RemoteIOServiceImpl::ReadSmallFile(google::protobuf::RpcController *cntl_ba
                                         google::protobuf::Closure *done)
 {
     brpc::ClosureGuard doneGuard(done);
+    CuckooTraceScope trace("store_read_small_file", CuckooTraceExtract(*request));
     auto *cntl = static_cast<brpc::Controller *>(cntl_base);
 
     uint64_t inodeId = request->inode_id();
@@ -232,6 +275,9 @@ void RemoteIOServiceImpl::ReadSmallFile(google::protobuf::RpcController *cntl_ba
     }
 
     response->set_error_code(0);
+    if (ChecksumTable::GetInstance().Started()) {
+        response->set_data_crc(Crc32c(0, buffer, readSize));
+    }
     std::function<void(void *)> deleter =
         needAlign ? static_cast<std::function<void(void *)>>([](void *buf) { free(buf); })
                   : static_cast<std::function<void(void *)>>(
@@ -245,6 +291,7 @@ void RemoteIOServiceImpl::WriteFile(google::protobuf::RpcController *cntl_base,
                                     google::protobuf::Closure *done)
 {
     brpc::ClosureGuard doneGuard(done);
+    CuckooTraceScope trace("store_write", CuckooTraceExtract(*request));
     auto *cntl = static_cast<brpc::Controller *>(cntl_base);
 
     uint64_t fd = request->physical_fd();
@@ -266,6 +313,13 @@ void RemoteIOServiceImpl::WriteFile(google::protobuf::RpcController *cntl_base,
         return;
     }
 
+    if (request->has_data_crc() && IOBufCrc32c(buffer) != request->data_crc()) {
+        CUCKOO_LOG(LOG_ERROR) << "WriteFile(): data for fd " << fd << " damaged on the way, checksum mismatch";
+        ChecksumTable::GetInstance().AddMismatch();
+        response->set_error_code(-EBADMSG);
+        return;
+    }
+
     openInstance->writeCnt++;
     int ret = CuckooStore::GetInstance()->WriteLocalFileForBrpc(openInstance.get(), buffer, offset);
     if (ret < 0) {
@@ -283,6 +337,7 @@ void RemoteIOServiceImpl::DeleteFile(google::protobuf::RpcController * /*cntl_ba
                                      google::protobuf::Closure *done)
 {
     brpc::ClosureGuard doneGuard(done);
+    CuckooTraceScope trace("store_delete", CuckooTraceExtract(*request));
 
     uint64_t inodeId = request->inode_id();
     int nodeId = request->node_id();
@@ -327,6 +382,7 @@ void RemoteIOServiceImpl::TruncateOpenInstance(google::protobuf::RpcController *
                                                google::protobuf::Closure *done)
 {
     brpc::ClosureGuard doneGuard(done);
+    CuckooTraceScope trace("store_truncate_open_instance", CuckooTraceExtract(*request));
 
     uint64_t fd = request->physical_fd();
     off_t size = request->size();
@@ -355,6 +411,7 @@ void RemoteIOServiceImpl::TruncateFile(google::protobuf::RpcController * /*cntl_
                                        google::protobuf::Closure *done)
 {
     brpc::ClosureGuard doneGuard(done);
+    CuckooTraceScope trace("store_truncate_file", CuckooTraceExtract(*request));
 
     uint64_t fd = request->physical_fd();
     off_t size = request->size();
@@ -378,6 +435,90 @@ void RemoteIOServiceImpl::TruncateFile(google::protobuf::RpcController * /*cntl_
     response->set_error_code(ret);
 }
 
+void RemoteIOServiceImpl::LockFile(google::protobuf::RpcController * /*cntl_base*/,
+                                   const LockFileRequest *request,
+                                   LockFileReply *response,
+                                   google::protobuf::Closure *done)
+{
+    brpc::ClosureGuard doneGuard(done);
+    CuckooTraceScope trace("store_lock_file", CuckooTraceExtract(*request));
+
+    struct flock lockInfo = {};
+    lockInfo.l_type = static_cast<short>(request->type());
+    lockInfo.l_whence = SEEK_SET;
+    lockInfo.l_start = static_cast<off_t>(request->start());
+    lockInfo.l_len = static_cast<off_t>(request->len());
+    lockInfo.l_pid = request->pid();
+    /* never park an rpc worker on a lock, the caller polls for F_SETLKW */
+    int cmd = request->cmd() == F_SETLKW ? F_SETLK : request->cmd();
+    RangeLockType type = request->flock() ? RangeLockType::FLOCK : RangeLockType::POSIX;
+
+    int ret = CuckooStore::GetInstance()->LockLocalFile(request->inode_id(),
+                                                        cmd,
+                                                        &lockInfo,
+                                                        request->owner(),
+                                                        request->owner_node_id(),
+                                                        type);
+    response->set_error_code(ret);
+    if (ret == 0 && cmd == F_GETLK) {
+        response->set_type(lockInfo.l_type);
+        response->set_start(lockInfo.l_start);
+        response->set_len(lockInfo.l_len);
+        response->set_pid(lockInfo.l_pid);
+    }
+}
+
+void RemoteIOServiceImpl::DropReplica(google::protobuf::RpcController * /*cntl_base*/,
+                                      const DropReplicaRequest *request,
+                                      ErrorCodeOnlyReply *response,
+                                      google::protobuf::Closure *done)
+{
+    brpc::ClosureGuard doneGuard(done);
+    CuckooTraceScope trace("store_drop_replica", CuckooTraceExtract(*request));
+
+    int ret = CuckooStore::GetInstance()->DropReplicaForBrpc(request->inode_id(), request->version());
+    response->set_error_code(ret);
+}
+
+void RemoteIOServiceImpl::ReplicateFile(google::protobuf::RpcController *cntl_base,
+                                        const ReplicateFileRequest *request,
+                                        ErrorCodeOnlyReply *response,
+                                        google::protobuf::Closure *done)
+{
+    brpc::ClosureGuard doneGuard(done);
+    CuckooTraceScope trace("store_replicate_file", CuckooTraceExtract(*request));
+    auto *cntl = static_cast<brpc::Controller *>(cntl_base);
+
+    int ret = 0;
+    if (request->drop()) {
+        ret = CuckooStore::GetInstance()->DropBackupForBrpc(request->inode_id(), request->primary_node_id());
+    } else {
+        ret = CuckooStore::GetInstance()->ReplicateFileForBrpc(request->inode_id(),
+                                                               request->primary_node_id(),
+                                                               cntl->request_attachment(),
+                                                               request->offset(),
+                                                               request->file_size(),
+                                                               request->reset(),
+                                                               request->last());
+    }
+    response->set_error_code(ret);
+}
+
+void RemoteIOServiceImpl::PreloadFile(google::protobuf::RpcController * /*cntl_base*/,
+                                      const PreloadFileRequest *request,
+                                      ErrorCodeOnlyReply *response,
+                                      google::protobuf::Closure *done)
+{
+    brpc::ClosureGuard doneGuard(done);
+    CuckooTraceScope trace("store_preload_file", CuckooTraceExtract(*request));
+
+    int ret = CuckooStore::GetInstance()->PreloadLocalFile(request->inode_id(),
+                                                           request->path(),
+                                                           request->size(),
+                                                           request->ttl_sec());
+    response->set_error_code(ret);
+}
+
 void RemoteIOServiceImpl::CheckConnection(google::protobuf::RpcController * /*cntl_base*/,
                                           const CheckConnectionRequest * /*request*/,
                                           ErrorCodeOnlyReply *response,
@@ -387,6 +528,33 @@ void RemoteIOServiceImpl::CheckConnection(google::protobuf::RpcController * /*cn
     response->set_error_code(0);
 }
 
+void MetricsServiceImpl::Metrics(google::protobuf::RpcController *cntl_base,
+                                 const MetricsRequest * /*request*/,
+                                 MetricsReply * /*response*/,
+                                 google::protobuf::Closure *done)
+{
+    brpc::ClosureGuard doneGuard(done);
+    auto *cntl = static_cast<brpc::Controller *>(cntl_base);
+    cntl->http_response().set_content_type("text/plain; version=0.0.4");
+    cntl->response_attachment().append(CuckooMetrics::GetInstance().Render());
+}
+
+void TraceServiceImpl::Trace(google::protobuf::RpcController *cntl_base,
+                             const TraceRequest * /*request*/,
+                             TraceReply * /*response*/,
+                             google::protobuf::Closure *done)
+{
+    brpc::ClosureGuard doneGuard(done);
+    auto *cntl = static_cast<brpc::Controller *>(cntl_base);
+    cntl->http_response().set_content_type("application/json");
+    size_t size = 0;
+    char *dump = CuckooTraceDumpToMemory(&size);
+    if (dump != nullptr) {
+        cntl->response_attachment().append(dump, size);
+        free(dump);
+    }
+}
+
 int RemoteIOServer::Run()
 {
     cuckoo::brpc_io::RemoteIOServiceImpl remoteIOServiceImpl;
@@ -394,6 +562,16 @@ int RemoteIOServer::Run()
         CUCKOO_LOG(LOG_ERROR) << "Fail to add service";
         return -1;
     }
+    cuckoo::brpc_io::MetricsServiceImpl metricsServiceImpl;
+    if (server.AddService(&metricsServiceImpl, brpc::SERVER_DOESNT_OWN_SERVICE, "/metrics => Metrics") != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "Fail to add metrics service";
+        return -1;
+    }
+    cuckoo::brpc_io::TraceServiceImpl traceServiceImpl;
+    if (server.AddService(&traceServiceImpl, brpc::SERVER_DOESNT_OWN_SERVICE, "/trace => Trace") != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "Fail to add trace service";
+        return -1;
+    }
 
     butil::EndPoint point;
     butil::str2endpoint(endPoint.c_str(), &point);
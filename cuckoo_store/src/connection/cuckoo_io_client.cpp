@@ -5,6 +5,9 @@
 #include "connection/cuckoo_io_client.h"
 
 #include "log/logging.h"
+#include "remote_connection_utils/cuckoo_trace.h"
+#include "util/checksum.h"
+#include "util/crc32c.h"
 
 static int BrpcErrorCodeToFuseErrno(int brpcErrorCode)
 {
@@ -34,7 +37,8 @@ int CuckooIOClient::OpenFile(uint64_t inodeId,
                              uint64_t &physicalFd,
                              uint64_t originalSize,
                              const std::string &path,
-                             bool nodeFail)
+                             bool nodeFail,
+                             HotFileReplicas *replicas)
 {
     cuckoo::brpc_io::OpenRequest request;
     request.set_inode_id(inodeId);
@@ -42,10 +46,36 @@ int CuckooIOClient::OpenFile(uint64_t inodeId,
     request.set_path(path);
     request.set_size(originalSize);
     request.set_node_fail(nodeFail);
+    return Open(request, physicalFd, replicas);
+}
+
+/* return 0: OK; return negative: remote IO error, return positive: network error */
+int CuckooIOClient::OpenReplicaFile(uint64_t inodeId,
+                                    uint64_t &physicalFd,
+                                    uint64_t originalSize,
+                                    const std::string &path,
+                                    int primaryNodeId,
+                                    uint64_t version)
+{
+    cuckoo::brpc_io::OpenRequest request;
+    request.set_inode_id(inodeId);
+    request.set_oflags(O_RDONLY);
+    request.set_path(path);
+    request.set_size(originalSize);
+    request.set_replica(true);
+    request.set_primary_node_id(primaryNodeId);
+    request.set_replica_version(version);
+    return Open(request, physicalFd, nullptr);
+}
+
+int CuckooIOClient::Open(cuckoo::brpc_io::OpenRequest &request, uint64_t &physicalFd, HotFileReplicas *replicas)
+{
     cuckoo::brpc_io::OpenReply response;
     brpc::Controller cntl;
     cntl.set_timeout_ms(10000);
 
+    CuckooTraceScope trace("open_rpc");
+    CuckooTraceInject(request, trace.Context());
     stub->OpenFile(&cntl, &request, &response, nullptr);
     if (cntl.Failed()) {
         CUCKOO_LOG(LOG_ERROR) << "Open file by brpc failed " << cntl.ErrorText() << "error code: " << cntl.ErrorCode();
@@ -58,6 +88,10 @@ int CuckooIOClient::OpenFile(uint64_t inodeId,
     }
 
     physicalFd = response.physical_fd();
+    if (replicas != nullptr) {
+        replicas->version = response.replica_version();
+        replicas->nodeIds.assign(response.replica_node_ids().begin(), response.replica_node_ids().end());
+    }
     CUCKOO_LOG(LOG_INFO) << "Open file successfully! you have opened cuckooFd: " << physicalFd;
     return 0;
 }
@@ -82,6 +116,8 @@ int CuckooIOClient::CloseFile(uint64_t physicalFd,
     auto dummyDeleter = [](void *) -> void {};
     cntl.request_attachment().append_user_data((void *)buf, size, dummyDeleter);
 
+    CuckooTraceScope trace("close_rpc");
+    CuckooTraceInject(request, trace.Context());
     stub->CloseFile(&cntl, &request, &response, nullptr);
     if (cntl.Failed()) {
         CUCKOO_LOG(LOG_ERROR) << "Close file by brpc failed " << cntl.ErrorText() << "error code: " << cntl.ErrorCode();
@@ -112,10 +148,21 @@ int CuckooIOClient::ReadFile(uint64_t /*inodeId*/,
     request.set_offset(offset);
     request.set_read_size(bufferSize);
     request.set_path(path);
+    int ret = -EBADMSG;
+    for (int i = 0; i < CHECKSUM_RPC_ATTEMPTS && ret == -EBADMSG; ++i) {
+        ret = Read(request, readBuffer, bufferSize);
+    }
+    return ret == -EBADMSG ? -EIO : ret;
+}
+
+int CuckooIOClient::Read(cuckoo::brpc_io::ReadRequest &request, char *readBuffer, int bufferSize)
+{
     cuckoo::brpc_io::ErrorCodeOnlyReply response;
     brpc::Controller cntl;
     cntl.set_timeout_ms(10000);
 
+    CuckooTraceScope trace("read_rpc");
+    CuckooTraceInject(request, trace.Context());
     stub->ReadFile(&cntl, &request, &response, nullptr);
     if (cntl.Failed()) {
         CUCKOO_LOG(LOG_ERROR) << "Read file by brpc failed " << cntl.ErrorText() << "error code: " << cntl.ErrorCode();
@@ -134,6 +181,11 @@ int CuckooIOClient::ReadFile(uint64_t /*inodeId*/,
     }
 
     cntl.response_attachment().cutn(readBuffer, retLen);
+    if (response.has_data_crc() && Crc32c(0, readBuffer, retLen) != response.data_crc()) {
+        CUCKOO_LOG(LOG_ERROR) << "CuckooIOClient::ReadFile(): data damaged on the way, checksum mismatch";
+        ChecksumTable::GetInstance().AddMismatch();
+        return -EBADMSG;
+    }
     CUCKOO_LOG(LOG_INFO) << "In CuckooIOClient::ReadFile(): read file successfully! you have read: " << retLen
                          << " bytes";
     return retLen;
@@ -153,10 +205,21 @@ ssize_t CuckooIOClient::ReadSmallFile(uint64_t inodeId,
     request.set_path(path);
     request.set_oflags(oflags);
     request.set_node_fail(nodeFail);
+    ssize_t ret = -EBADMSG;
+    for (int i = 0; i < CHECKSUM_RPC_ATTEMPTS && ret == -EBADMSG; ++i) {
+        ret = ReadSmall(request, readBuffer, size);
+    }
+    return ret == -EBADMSG ? -EIO : ret;
+}
+
+ssize_t CuckooIOClient::ReadSmall(cuckoo::brpc_io::ReadSmallFileRequest &request, char *readBuffer, ssize_t size)
+{
     cuckoo::brpc_io::ErrorCodeOnlyReply response;
     brpc::Controller cntl;
     cntl.set_timeout_ms(10000);
 
+    CuckooTraceScope trace("read_small_file_rpc");
+    CuckooTraceInject(request, trace.Context());
     stub->ReadSmallFile(&cntl, &request, &response, nullptr);
     if (cntl.Failed()) {
         CUCKOO_LOG(LOG_ERROR) << "Read small file by brpc failed " << cntl.ErrorText()
@@ -176,24 +239,19 @@ ssize_t CuckooIOClient::ReadSmallFile(uint64_t inodeId,
     }
 
     cntl.response_attachment().cutn(readBuffer, retLen);
+    if (response.has_data_crc() && Crc32c(0, readBuffer, retLen) != response.data_crc()) {
+        CUCKOO_LOG(LOG_ERROR) << "CuckooIOClient::ReadSmallFile(): data damaged on the way, checksum mismatch";
+        ChecksumTable::GetInstance().AddMismatch();
+        return -EBADMSG;
+    }
     CUCKOO_LOG(LOG_INFO) << "In CuckooIOClient::ReadSmallFile(): read file successfully! you have read: " << size
                          << " bytes";
     return 0;
 }
 
 // return 0: OK, return negative: error of both network and IO
-int CuckooIOClient::WriteFile(uint64_t physicalFd, const char *writeBuffer, uint64_t size, off_t offset)
+static int CheckWriteReply(brpc::Controller &cntl, const cuckoo::brpc_io::WriteReply &response, uint64_t size)
 {
-    cuckoo::brpc_io::WriteRequest request;
-    request.set_physical_fd(physicalFd);
-    request.set_offset(offset);
-    cuckoo::brpc_io::WriteReply response;
-    brpc::Controller cntl;
-    cntl.set_timeout_ms(10000);
-    auto dummyDeleter = [](void *) -> void {};
-    cntl.request_attachment().append_user_data((void *)writeBuffer, size, dummyDeleter);
-
-    stub->WriteFile(&cntl, &request, &response, nullptr);
     if (cntl.Failed()) {
         CUCKOO_LOG(LOG_ERROR) << "WriteFile by brpc failed " << cntl.ErrorText() << "error code: " << cntl.ErrorCode();
         return -BrpcErrorCodeToFuseErrno(cntl.ErrorCode());
@@ -215,6 +273,100 @@ int CuckooIOClient::WriteFile(uint64_t physicalFd, const char *writeBuffer, uint
     return 0;
 }
 
+/* the receiving node checks the data against the crc and answers -EBADMSG if it was damaged on the way */
+static void SetWriteCrc(cuckoo::brpc_io::WriteRequest &request, const char *writeBuffer, uint64_t size)
+{
+    if (ChecksumTable::GetInstance().Started()) {
+        request.set_data_crc(Crc32c(0, writeBuffer, size));
+    }
+}
+
+int CuckooIOClient::WriteFile(uint64_t physicalFd, const char *writeBuffer, uint64_t size, off_t offset)
+{
+    cuckoo::brpc_io::WriteRequest request;
+    request.set_physical_fd(physicalFd);
+    request.set_offset(offset);
+    SetWriteCrc(request, writeBuffer, size);
+    int ret = -EBADMSG;
+    for (int i = 0; i < CHECKSUM_RPC_ATTEMPTS && ret == -EBADMSG; ++i) {
+        cuckoo::brpc_io::WriteReply response;
+        brpc::Controller cntl;
+        cntl.set_timeout_ms(10000);
+        auto dummyDeleter = [](void *) -> void {};
+        cntl.request_attachment().append_user_data((void *)writeBuffer, size, dummyDeleter);
+
+        CuckooTraceScope trace("write_rpc");
+        CuckooTraceInject(request, trace.Context());
+        stub->WriteFile(&cntl, &request, &response, nullptr);
+        ret = CheckWriteReply(cntl, response, size);
+    }
+    return ret == -EBADMSG ? -EIO : ret;
+}
+
+/* a WriteFile rpc in flight, deletes itself once answered */
+class WriteFileCall : public google::protobuf::Closure {
+  public:
+    WriteFileCall(cuckoo::brpc_io::RemoteIOService_Stub *stub,
+                  const char *writeBuffer,
+                  uint64_t size,
+                  std::function<void(int)> done)
+        : stub(stub),
+          writeBuffer(writeBuffer),
+          size(size),
+          done(std::move(done))
+    {
+    }
+    void Send()
+    {
+        cntl.set_timeout_ms(10000);
+        auto dummyDeleter = [](void *) -> void {};
+        cntl.request_attachment().append_user_data((void *)writeBuffer, size, dummyDeleter);
+
+        CuckooTraceScope trace("write_rpc_async");
+        CuckooTraceInject(request, trace.Context());
+        stub->WriteFile(&cntl, &request, &response, this);
+    }
+    void Run() override
+    {
+        int ret = CheckWriteReply(cntl, response, size);
+        if (ret == -EBADMSG && ++attempts < CHECKSUM_RPC_ATTEMPTS) {
+            /* damaged on the way, the buffer is still ours to send again */
+            cntl.Reset();
+            response.Clear();
+            Send();
+            return;
+        }
+        std::function<void(int)> callback = std::move(done);
+        /* the attachment still points to the buffer, drop it before the buffer is released */
+        delete this;
+        callback(ret == -EBADMSG ? -EIO : ret);
+    }
+
+    cuckoo::brpc_io::WriteRequest request;
+
+  private:
+    brpc::Controller cntl;
+    cuckoo::brpc_io::WriteReply response;
+    cuckoo::brpc_io::RemoteIOService_Stub *stub;
+    const char *writeBuffer;
+    uint64_t size;
+    int attempts = 0;
+    std::function<void(int)> done;
+};
+
+void CuckooIOClient::WriteFileAsync(uint64_t physicalFd,
+                                    const char *writeBuffer,
+                                    uint64_t size,
+                                    off_t offset,
+                                    std::function<void(int)> done)
+{
+    WriteFileCall *call = new WriteFileCall(stub.get(), writeBuffer, size, std::move(done));
+    call->request.set_physical_fd(physicalFd);
+    call->request.set_offset(offset);
+    SetWriteCrc(call->request, writeBuffer, size);
+    call->Send();
+}
+
 // return 0: OK, return negative: error of both network and IO
 int CuckooIOClient::DeleteFile(uint64_t inodeId, int nodeId, std::string &path)
 {
@@ -226,6 +378,8 @@ int CuckooIOClient::DeleteFile(uint64_t inodeId, int nodeId, std::string &path)
     brpc::Controller cntl;
     cntl.set_timeout_ms(10000);
 
+    CuckooTraceScope trace("delete_rpc");
+    CuckooTraceInject(request, trace.Context());
     stub->DeleteFile(&cntl, &request, &response, nullptr);
     if (cntl.Failed()) {
         CUCKOO_LOG(LOG_ERROR) << "Delete file by brpc failed " << cntl.ErrorText()
@@ -281,6 +435,8 @@ int CuckooIOClient::TruncateOpenInstance(uint64_t physicalFd, off_t size)
     brpc::Controller cntl;
     cntl.set_timeout_ms(10000);
 
+    CuckooTraceScope trace("truncate_open_instance_rpc");
+    CuckooTraceInject(request, trace.Context());
     stub->TruncateOpenInstance(&cntl, &request, &response, nullptr);
     if (cntl.Failed()) {
         CUCKOO_LOG(LOG_ERROR) << "TruncateOpenInstance by brpc failed " << cntl.ErrorText()
@@ -307,6 +463,8 @@ int CuckooIOClient::TruncateFile(uint64_t physicalFd, off_t size)
     brpc::Controller cntl;
     cntl.set_timeout_ms(10000);
 
+    CuckooTraceScope trace("truncate_file_rpc");
+    CuckooTraceInject(request, trace.Context());
     stub->TruncateFile(&cntl, &request, &response, nullptr);
     if (cntl.Failed()) {
         CUCKOO_LOG(LOG_ERROR) << "TruncateFile by brpc failed " << cntl.ErrorText()
@@ -323,6 +481,49 @@ int CuckooIOClient::TruncateFile(uint64_t physicalFd, off_t size)
     return 0;
 }
 
+// return 0: OK, return negative: error of both network and lock, F_GETLK fills lockInfo with the conflict
+int CuckooIOClient::LockFile(uint64_t inodeId,
+                             int cmd,
+                             struct flock *lockInfo,
+                             uint64_t owner,
+                             int ownerNodeId,
+                             RangeLockType type)
+{
+    cuckoo::brpc_io::LockFileRequest request;
+    request.set_inode_id(inodeId);
+    request.set_cmd(cmd);
+    request.set_type(lockInfo->l_type);
+    request.set_start(lockInfo->l_start);
+    request.set_len(lockInfo->l_len);
+    request.set_pid(lockInfo->l_pid);
+    request.set_owner(owner);
+    request.set_owner_node_id(ownerNodeId);
+    request.set_flock(type == RangeLockType::FLOCK);
+    cuckoo::brpc_io::LockFileReply response;
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(10000);
+
+    CuckooTraceScope trace("lock_file_rpc");
+    CuckooTraceInject(request, trace.Context());
+    stub->LockFile(&cntl, &request, &response, nullptr);
+    if (cntl.Failed()) {
+        CUCKOO_LOG(LOG_ERROR) << "LockFile by brpc failed " << cntl.ErrorText() << "error code: " << cntl.ErrorCode();
+        return -BrpcErrorCodeToFuseErrno(cntl.ErrorCode());
+    }
+
+    if (response.error_code() != 0) {
+        return response.error_code();
+    }
+    if (cmd == F_GETLK) {
+        lockInfo->l_type = static_cast<short>(response.type());
+        lockInfo->l_whence = SEEK_SET;
+        lockInfo->l_start = static_cast<off_t>(response.start());
+        lockInfo->l_len = static_cast<off_t>(response.len());
+        lockInfo->l_pid = response.pid();
+    }
+    return 0;
+}
+
 int CuckooIOClient::CheckConnection()
 {
     cuckoo::brpc_io::CheckConnectionRequest request;
@@ -343,3 +544,111 @@ int CuckooIOClient::CheckConnection()
     }
     return 0;
 }
+
+// return 0: OK, return negative: error of both network and IO
+int CuckooIOClient::DropReplica(uint64_t inodeId, uint64_t version)
+{
+    cuckoo::brpc_io::DropReplicaRequest request;
+    request.set_inode_id(inodeId);
+    request.set_version(version);
+    cuckoo::brpc_io::ErrorCodeOnlyReply response;
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(10000);
+
+    CuckooTraceScope trace("drop_replica_rpc");
+    CuckooTraceInject(request, trace.Context());
+    stub->DropReplica(&cntl, &request, &response, nullptr);
+    if (cntl.Failed()) {
+        CUCKOO_LOG(LOG_ERROR) << "DropReplica by brpc failed " << cntl.ErrorText()
+                              << "error code: " << cntl.ErrorCode();
+        return -BrpcErrorCodeToFuseErrno(cntl.ErrorCode());
+    }
+
+    if (response.error_code() != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "CuckooIOClient::DropReplica failed: " << strerror(-response.error_code());
+        return response.error_code();
+    }
+    return 0;
+}
+
+// return 0: OK, return -ESTALE: the backup has no copy to change, ship the whole file
+int CuckooIOClient::ReplicateFile(uint64_t inodeId,
+                                  int primaryNodeId,
+                                  const char *buf,
+                                  size_t size,
+                                  off_t offset,
+                                  uint64_t fileSize,
+                                  bool reset,
+                                  bool last)
+{
+    cuckoo::brpc_io::ReplicateFileRequest request;
+    request.set_inode_id(inodeId);
+    request.set_primary_node_id(primaryNodeId);
+    request.set_offset(offset);
+    request.set_file_size(fileSize);
+    request.set_reset(reset);
+    request.set_last(last);
+    return Replicate(request, buf, size);
+}
+
+int CuckooIOClient::DropBackup(uint64_t inodeId, int primaryNodeId)
+{
+    cuckoo::brpc_io::ReplicateFileRequest request;
+    request.set_inode_id(inodeId);
+    request.set_primary_node_id(primaryNodeId);
+    request.set_drop(true);
+    return Replicate(request, nullptr, 0);
+}
+
+int CuckooIOClient::Replicate(cuckoo::brpc_io::ReplicateFileRequest &request, const char *buf, size_t size)
+{
+    cuckoo::brpc_io::ErrorCodeOnlyReply response;
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(10000);
+    auto dummyDeleter = [](void *) -> void {};
+    if (size > 0) {
+        cntl.request_attachment().append_user_data((void *)buf, size, dummyDeleter);
+    }
+
+    CuckooTraceScope trace("replicate_file_rpc");
+    CuckooTraceInject(request, trace.Context());
+    stub->ReplicateFile(&cntl, &request, &response, nullptr);
+    if (cntl.Failed()) {
+        CUCKOO_LOG(LOG_ERROR) << "ReplicateFile by brpc failed " << cntl.ErrorText()
+                              << "error code: " << cntl.ErrorCode();
+        return -BrpcErrorCodeToFuseErrno(cntl.ErrorCode());
+    }
+
+    if (response.error_code() != 0 && response.error_code() != -ESTALE) {
+        CUCKOO_LOG(LOG_ERROR) << "CuckooIOClient::ReplicateFile failed: " << strerror(-response.error_code());
+    }
+    return response.error_code();
+}
+
+// return 0: OK, return negative: error of both network and IO
+int CuckooIOClient::PreloadFile(uint64_t inodeId, const std::string &path, uint64_t size, uint32_t ttlSec)
+{
+    cuckoo::brpc_io::PreloadFileRequest request;
+    request.set_inode_id(inodeId);
+    request.set_path(path);
+    request.set_size(size);
+    request.set_ttl_sec(ttlSec);
+    cuckoo::brpc_io::ErrorCodeOnlyReply response;
+    brpc::Controller cntl;
+    cntl.set_timeout_ms(PRELOAD_RPC_TIMEOUT_MS);
+
+    CuckooTraceScope trace("preload_file_rpc");
+    CuckooTraceInject(request, trace.Context());
+    stub->PreloadFile(&cntl, &request, &response, nullptr);
+    if (cntl.Failed()) {
+        CUCKOO_LOG(LOG_ERROR) << "PreloadFile by brpc failed " << cntl.ErrorText()
+                              << "error code: " << cntl.ErrorCode();
+        return -BrpcErrorCodeToFuseErrno(cntl.ErrorCode());
+    }
+
+    if (response.error_code() != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "CuckooIOClient::PreloadFile failed: " << strerror(-response.error_code());
+        return response.error_code();
+    }
+    return 0;
+}
@@ -4,6 +4,7 @@
 
 #include "connection/node.h"
 
+#include <algorithm>
 #include <chrono>
 #include <print>
 #include <ranges>
@@ -64,6 +65,11 @@ int StoreNode::UpdateNodeConfig()
         std::shared_ptr<CuckooIOClient> connection(CreateIOConnection(newNodeKv.second));
         nodeMap.emplace(newNodeKv.first, std::make_pair(newNodeKv.second, connection));
     }
+    auto handler = nodeGoneHandler;
+    nodeLock.unlock();
+    if (!toDel.empty() && handler) {
+        handler(toDel);
+    }
 #endif
     return ret;
 }
@@ -242,6 +248,51 @@ int StoreNode::GetNextNode(int nodeId, uint64_t inodeId)
     return nodeId;
 }
 
+std::vector<int> StoreNode::GetReplicaNodes(int primaryNodeId, int num)
+{
+    std::shared_lock<std::shared_mutex> lock(nodeMutex);
+    std::vector<int> replicaNodeIds;
+    auto it = nodeMap.find(primaryNodeId);
+    if (it == nodeMap.end()) {
+        return replicaNodeIds;
+    }
+    int otherNum = std::min(num, static_cast<int>(nodeMap.size()) - 1);
+    for (int i = 0; i < otherNum; ++i) {
+        it = std::next(it);
+        if (it == nodeMap.end()) {
+            it = nodeMap.begin();
+        }
+        replicaNodeIds.push_back(it->first);
+    }
+    return replicaNodeIds;
+}
+
+int StoreNode::GetBackupNode(int primaryNodeId, uint64_t inodeId)
+{
+    std::shared_lock<std::shared_mutex> lock(nodeMutex);
+    int otherNum = nodeMap.size() - (nodeMap.contains(primaryNodeId) ? 1 : 0);
+    if (otherNum <= 0) {
+        return -1;
+    }
+    /* where AllocNode puts the file once the primary is deleted, skipping it keeps the order of the others */
+    int index = hash64(inodeId) % otherNum;
+    for (auto &kv : nodeMap) {
+        if (kv.first == primaryNodeId) {
+            continue;
+        }
+        if (index-- == 0) {
+            return kv.first;
+        }
+    }
+    return -1;
+}
+
+void StoreNode::SetNodeGoneHandler(std::function<void(const std::vector<int> &)> handler)
+{
+    std::unique_lock<std::shared_mutex> lock(nodeMutex);
+    nodeGoneHandler = std::move(handler);
+}
+
 void StoreNode::DeleteNode(int nodeId)
 {
     std::unique_lock<std::shared_mutex> lock(nodeMutex);
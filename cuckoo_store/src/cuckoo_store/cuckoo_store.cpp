@@ -4,13 +4,21 @@
 
 #include "cuckoo_store/cuckoo_store.h"
 
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+#include "buffer/dir_open_instance.h"
 #include "conf/cuckoo_property_key.h"
 #include "connection/node.h"
 #include "cuckoo_code.h"
 #include "disk_cache/disk_cache.h"
 #include "init/cuckoo_init.h"
+#include "stats/cuckoo_metrics.h"
 #include "stats/cuckoo_stats.h"
+#include "storage/local_storage.h"
 #include "storage/obs_storage.h"
+#include "util/checksum.h"
 
 void CuckooStore::SetCuckooStoreParam(std::string &newNodeConfig) { nodeConfig = newNodeConfig; }
 
@@ -22,6 +30,7 @@ CuckooStore *CuckooStore::GetInstance()
 
 void CuckooStore::DeleteInstance()
 {
+    UnregisterMetrics();
     StoreNode::DeleteInstance();
     if (storage) {
         storage->DeleteInstance();
@@ -59,7 +68,11 @@ int CuckooStore::InitStore()
 
     dataPath = rootPath;
     if (persistToStorage) {
-        storage = OBSStorage::GetInstance();
+        if (config->GetString(CuckooPropertyKey::CUCKOO_STORAGE_TYPE) == "local") {
+            storage = LocalStorage::GetInstance();
+        } else {
+            storage = OBSStorage::GetInstance();
+        }
 
         ret = storage->Init();
         if (ret != CUCKOO_SUCCESS) {
@@ -71,17 +84,65 @@ int CuckooStore::InitStore()
     READ_BIGFILE_SIZE = bigFileReadSize;
     SetRootPath(rootPath);
     SetTotalDirectory(totalDirectory);
+    if (config->GetBool(CuckooPropertyKey::CUCKOO_CHECKSUM)) {
+        ChecksumTable::GetInstance().Start(GetFilePath);
+    }
     ret = DiskCache::GetInstance().Start(rootPath, totalDirectory, 1.0 - storageThreshold, 1.1 - storageThreshold);
     if (ret != 0) {
         CUCKOO_LOG(LOG_ERROR) << "DiskCache start failed";
         return 1;
     }
-    MemPool().GetInstance().init(CUCKOO_BLOCK_SIZE, preBlockNum);
+    MemPool::GetInstance().init(CUCKOO_BLOCK_SIZE, preBlockNum);
+    bool memPoolNuma = config->GetBool(CuckooPropertyKey::CUCKOO_MEMPOOL_NUMA);
+    MemPool::GetInstance().SetNumaAware(memPoolNuma);
+    FixMemory::writeMemPool.SetNumaAware(memPoolNuma);
+    uint64_t openFileMemoryMb = config->GetUint32(CuckooPropertyKey::CUCKOO_OPEN_FILE_MEMORY_MB);
+    if (openFileMemoryMb > 0) {
+        CuckooFd::GetInstance()->SetOpenInstanceMemoryBudget(openFileMemoryMb * 1024 * 1024);
+    }
+    uint64_t writeMergeMemoryMb = config->GetUint32(CuckooPropertyKey::CUCKOO_WRITE_MERGE_MEMORY_MB);
+    if (writeMergeMemoryMb > 0) {
+        WriteStream::SetMergeMemoryLimit(writeMergeMemoryMb * 1024 * 1024);
+    }
+    uint32_t writeInflightNum = config->GetUint32(CuckooPropertyKey::CUCKOO_WRITE_INFLIGHT_NUM);
+    if (writeInflightNum > 0) {
+        WriteStream::SetInflightLimit(writeInflightNum);
+    }
+    uint64_t hotFileReadRate = config->GetUint32(CuckooPropertyKey::CUCKOO_HOT_FILE_READ_RATE);
+    hotFileReplicaNum = config->GetUint32(CuckooPropertyKey::CUCKOO_HOT_FILE_REPLICAS);
+    if (hotFileReplicaNum > 0) {
+        hotFiles.SetThreshold(hotFileReadRate * HOT_FILE_WINDOW_MS / 1000);
+    }
+    std::string compression = config->GetString(CuckooPropertyKey::CUCKOO_COMPRESSION);
+    if (compressRules.Parse(compression) != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "Invalid cuckoo_compression or codec not built in: " << compression;
+        return 1;
+    }
+    compressIdleSec = config->GetUint32(CuckooPropertyKey::CUCKOO_COMPRESSION_IDLE_SEC);
+    std::string storageCompression = config->GetString(CuckooPropertyKey::CUCKOO_STORAGE_COMPRESSION);
+    if (storageCompressRules.Parse(storageCompression) != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "Invalid cuckoo_storage_compression or codec not built in: " << storageCompression;
+        return 1;
+    }
+    std::string replication = config->GetString(CuckooPropertyKey::CUCKOO_REPLICATION_MODE);
+    if (replication == "sync") {
+        replicationMode = ReplicationMode::SYNC;
+    } else if (replication == "async") {
+        replicationMode = ReplicationMode::ASYNC;
+    }
     storeThreadPool = ThreadPool::CreateThreadPool(threadNum, 100000, "store thread pool");
     if (storeThreadPool == nullptr || storeThreadPool->Start() != 0) {
         CUCKOO_LOG(LOG_ERROR) << "Cuckoo threadpool init failed";
         return 1;
     }
+    if (replicationMode != ReplicationMode::NONE) {
+        reReplicateThread = std::jthread([this](std::stop_token stoken) { ReReplicate(stoken); });
+        StoreNode::GetInstance()->SetNodeGoneHandler([this](const std::vector<int> &nodeIds) { OnNodesGone(nodeIds); });
+    }
+    preloadThread = std::jthread([this](std::stop_token stoken) { SweepPreloadPins(stoken); });
+    if (!compressRules.Empty()) {
+        compressThread = std::jthread([this](std::stop_token stoken) { SweepColdFiles(stoken); });
+    }
 #ifdef ZK_INIT
     ret = StoreNode::GetInstance()->SetNodeConfig(rootPath);
     if (ret != 0) {
@@ -96,10 +157,125 @@ int CuckooStore::InitStore()
     if (ifStat) {
         statsThread = std::jthread([mountPath](std::stop_token stoken) { PrintStats(mountPath, stoken); });
     }
+    RegisterMetrics();
 
     return 0;
 }
 
+void CuckooStore::RegisterMetrics()
+{
+    CuckooMetrics &metrics = CuckooMetrics::GetInstance();
+    DiskCache &diskCache = DiskCache::GetInstance();
+    metrics.RegisterGauge("cuckoo_disk_cache_used_bytes", "Bytes cached on local disk.", [&diskCache]() {
+        return static_cast<double>(diskCache.GetUsedCap());
+    });
+    metrics.RegisterGauge("cuckoo_disk_cache_capacity_bytes", "Capacity of the local disk cache.", [&diskCache]() {
+        return static_cast<double>(diskCache.GetTotalCap());
+    });
+    metrics.RegisterGauge("cuckoo_disk_cache_items", "Files cached on local disk.", [&diskCache]() {
+        return static_cast<double>(diskCache.GetItemNum());
+    });
+    metrics.RegisterCounter("cuckoo_disk_cache_hits_total", "Disk cache lookups that hit.", [&diskCache]() {
+        return static_cast<double>(diskCache.GetHitNum());
+    });
+    metrics.RegisterCounter("cuckoo_disk_cache_misses_total", "Disk cache lookups that missed.", [&diskCache]() {
+        return static_cast<double>(diskCache.GetMissNum());
+    });
+    metrics.RegisterGauge("cuckoo_disk_cache_hit_ratio", "Disk cache hit ratio since start.", [&diskCache]() {
+        double hit = diskCache.GetHitNum();
+        double total = hit + diskCache.GetMissNum();
+        return total == 0 ? 0.0 : hit / total;
+    });
+
+    metrics.RegisterCounter("cuckoo_checksum_mismatches_total", "Data read or sent not matching its crc.", []() {
+        return static_cast<double>(ChecksumTable::GetInstance().GetMismatchNum());
+    });
+    metrics.RegisterCounter("cuckoo_compressed_files_total", "Cold cache files compressed.", [this]() {
+        return static_cast<double>(frozenFiles.GetFrozenNum());
+    });
+    metrics.RegisterCounter("cuckoo_compression_saved_bytes_total", "Disk bytes saved by compression.", [this]() {
+        return static_cast<double>(frozenFiles.GetSavedBytes());
+    });
+
+    metrics.RegisterGauge("cuckoo_open_instances", "Open instances in use.", []() {
+        return static_cast<double>(CuckooFd::GetInstance()->GetOpenInstanceNum());
+    });
+    metrics.RegisterGauge("cuckoo_open_instances_pooled", "Closed open instances kept for reuse.", []() {
+        return static_cast<double>(CuckooFd::GetInstance()->GetIdleOpenInstanceNum());
+    });
+    metrics.RegisterGauge("cuckoo_open_instances_memory_bytes", "Memory held by open instances.", []() {
+        return static_cast<double>(CuckooFd::GetInstance()->GetOpenInstanceMemory());
+    });
+    metrics.RegisterGauge("cuckoo_open_instances_memory_budget_bytes", "Memory open instances may hold.", []() {
+        return static_cast<double>(CuckooFd::GetInstance()->GetOpenInstanceMemoryBudget());
+    });
+    metrics.RegisterGauge("cuckoo_write_stream_merged_bytes", "Out of order writes held for merging.", []() {
+        return static_cast<double>(WriteStream::GetMergedMemory());
+    });
+    metrics.RegisterGauge("cuckoo_hot_files", "Files of this node read often enough to be replicated.", [this]() {
+        return static_cast<double>(hotFiles.GetHotNum());
+    });
+    metrics.RegisterGauge("cuckoo_hot_file_replica_copies", "Copies of hot files of other nodes.", [this]() {
+        return static_cast<double>(replicaCopies.Size());
+    });
+    metrics.RegisterGauge("cuckoo_backup_copies", "Backup copies of files of other nodes.", [this]() {
+        return static_cast<double>(backupCopies.Size());
+    });
+    metrics.RegisterGauge("cuckoo_rereplication_queue_depth", "Files waiting for a new backup.", [this]() {
+        std::lock_guard<std::mutex> lock(reReplicateMutex);
+        return static_cast<double>(reReplicateQueue.size());
+    });
+    metrics.RegisterGauge("cuckoo_preload_pinned_files", "Preloaded files pinned until their ttl.", [this]() {
+        return static_cast<double>(preloadPins.Size());
+    });
+
+    ThreadPool *pool = storeThreadPool.get();
+    metrics.RegisterGauge(
+        "cuckoo_store_thread_pool_queue_depth",
+        "Tasks queued in the store thread pool.",
+        [pool]() { return static_cast<double>(pool->GetQueueDepth(TaskPriority::FOREGROUND)); },
+        "priority=\"foreground\"");
+    metrics.RegisterGauge(
+        "cuckoo_store_thread_pool_queue_depth",
+        "Tasks queued in the store thread pool.",
+        [pool]() { return static_cast<double>(pool->GetQueueDepth(TaskPriority::BACKGROUND)); },
+        "priority=\"background\"");
+    metrics.RegisterCounter("cuckoo_store_thread_pool_steals_total", "Tasks stolen by idle workers.", [pool]() {
+        return static_cast<double>(pool->GetStealCount());
+    });
+}
+
+void CuckooStore::UnregisterMetrics()
+{
+    /* getters capture the store, its thread pool and copies, none may outlive them */
+    static const char *const names[] = {
+        "cuckoo_disk_cache_used_bytes",
+        "cuckoo_disk_cache_capacity_bytes",
+        "cuckoo_disk_cache_items",
+        "cuckoo_disk_cache_hits_total",
+        "cuckoo_disk_cache_misses_total",
+        "cuckoo_disk_cache_hit_ratio",
+        "cuckoo_checksum_mismatches_total",
+        "cuckoo_compressed_files_total",
+        "cuckoo_compression_saved_bytes_total",
+        "cuckoo_open_instances",
+        "cuckoo_open_instances_pooled",
+        "cuckoo_open_instances_memory_bytes",
+        "cuckoo_open_instances_memory_budget_bytes",
+        "cuckoo_write_stream_merged_bytes",
+        "cuckoo_hot_files",
+        "cuckoo_hot_file_replica_copies",
+        "cuckoo_backup_copies",
+        "cuckoo_rereplication_queue_depth",
+        "cuckoo_preload_pinned_files",
+        "cuckoo_store_thread_pool_queue_depth",
+        "cuckoo_store_thread_pool_steals_total",
+    };
+    for (const char *name : names) {
+        CuckooMetrics::GetInstance().Unregister(name);
+    }
+}
+
 std::string GetParentPath(const std::string &path, int level)
 {
     // path start with '/'
@@ -164,36 +340,91 @@ int CuckooStore::PathToNodeId(std::string &path)
     return StoreNode::GetInstance()->AllocNode(myHash(parentPath));
 }
 
-void CuckooStore::AllocNodeId(OpenInstance *openInstance)
+int CuckooStore::OwnerNodeId(uint64_t inodeId, int nodeId, std::string &path)
 {
-    if (openInstance->nodeId == -1) {
-        if (toLocal && DiskCache::GetInstance().HasFreeSpace()) {
-            openInstance->nodeId = StoreNode::GetInstance()->GetNodeId();
-            return;
-        }
-        if (isInference) {
-            openInstance->nodeId = PathToNodeId(openInstance->path);
-        } else {
-            openInstance->nodeId = StoreNode::GetInstance()->AllocNode(openInstance->inodeId);
-        }
+    if (nodeId != -1) {
+        return nodeId;
+    }
+    if (toLocal && DiskCache::GetInstance().HasFreeSpace()) {
+        return StoreNode::GetInstance()->GetNodeId();
+    }
+    if (isInference) {
+        return PathToNodeId(path);
     }
+    return StoreNode::GetInstance()->AllocNode(inodeId);
+}
+
+void CuckooStore::AllocNodeId(OpenInstance *openInstance)
+{
+    openInstance->nodeId = OwnerNodeId(openInstance->inodeId, openInstance->nodeId, openInstance->path);
 }
 bool CuckooStore::ConnectionError(int err) { return err > 0; }
 
 bool CuckooStore::IoError(int err) { return err < 0; }
 
+void CuckooStore::SealChecksums(uint64_t inodeId)
+{
+    int ret = ChecksumTable::GetInstance().Seal(inodeId);
+    /* -EAGAIN if written meanwhile, the writer seals it on its flush */
+    if (ret != 0 && ret != -EAGAIN) {
+        CUCKOO_LOG(LOG_WARNING) << "Checksums of " << GetFilePath(inodeId) << " not saved: " << strerror(-ret);
+    }
+}
+
+void CuckooStore::SealChecksumsAsync(uint64_t inodeId)
+{
+    if (!ChecksumTable::GetInstance().QueueSeal(inodeId)) {
+        return;
+    }
+    ThreadTask task;
+    task.priority = TaskPriority::BACKGROUND;
+    task.task = [this, inodeId]() {
+        ChecksumTable::GetInstance().TakeSeal(inodeId);
+        /* pinned, so that the file is not evicted while its sidecar is written */
+        if (DiskCache::GetInstance().Find(inodeId, true)) {
+            SealChecksums(inodeId);
+            DiskCache::GetInstance().Unpin(inodeId);
+        }
+    };
+    storeThreadPool->Submit(task);
+}
+
+bool CuckooStore::RefetchDamaged(uint64_t inodeId)
+{
+    if (!persistToStorage) {
+        return false;
+    }
+    bool frozenDamaged = frozenFiles.TakeDamaged(inodeId);
+    return ChecksumTable::GetInstance().Corrupt(inodeId) || frozenDamaged;
+}
+
 /*---------------------- write ----------------------*/
 
+/* raise size to newSize unless a concurrent write raised it further, true if raised */
+static bool GrowSize(std::atomic<uint64_t> &size, uint64_t newSize)
+{
+    uint64_t current = size.load();
+    while (current < newSize) {
+        if (size.compare_exchange_weak(current, newSize)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 // WriteLocalFileForBrpc can only be called from brpc server
 int CuckooStore::WriteLocalFileForBrpc(OpenInstance *openInstance, butil::IOBuf &buf, off_t offset)
 {
     size_t writeSize = buf.size();
+    size_t totalSize = writeSize;
+    off_t startOffset = offset;
+    /* writes of one file arrive concurrently and out of order, only the part past the end needs space */
     uint64_t currentSize = openInstance->currentSize.load();
-    uint64_t newSize = std::max(openInstance->currentSize.load(), offset + writeSize);
-    uint64_t sizeToAdd = newSize - currentSize;
+    uint64_t newSize = offset + writeSize;
+    uint64_t sizeToAdd = newSize > currentSize ? newSize - currentSize : 0;
     bool isDirect = openInstance->oflags & __O_DIRECT;
 
-    if (!DiskCache::GetInstance().PreAllocSpace(sizeToAdd)) {
+    if (sizeToAdd > 0 && !DiskCache::GetInstance().PreAllocSpace(sizeToAdd)) {
         CUCKOO_LOG(LOG_ERROR) << "WriteLocalFileForBrpc(): Can not pre-allocate enough space!";
         return -ENOSPC;
     }
@@ -202,8 +433,7 @@ int CuckooStore::WriteLocalFileForBrpc(OpenInstance *openInstance, butil::IOBuf
             ssize_t nwrite = buf.pcut_into_file_descriptor(openInstance->physicalFd, offset, writeSize);
             if (nwrite < 0 || nwrite > (ssize_t)writeSize) {
                 offset += nwrite > 0 ? nwrite : 0;
-                if ((uint64_t)offset > currentSize) {
-                    openInstance->currentSize = offset;
+                if (GrowSize(openInstance->currentSize, offset)) {
                     if (!DiskCache::GetInstance().Update(openInstance->inodeId, offset)) {
                         CUCKOO_LOG(LOG_ERROR) << "WriteLocalFileForBrpc(): DiskCache Update failed!";
                         DiskCache::GetInstance().FreePreAllocSpace(sizeToAdd);
@@ -243,13 +473,16 @@ int CuckooStore::WriteLocalFileForBrpc(OpenInstance *openInstance, butil::IOBuf
         CuckooStats::GetInstance().stats[BLOCKCACHE_WRITE] += retSize;
     }
 
-    openInstance->currentSize = newSize;
-    if (!DiskCache::GetInstance().Update(openInstance->inodeId, newSize)) {
+    if (GrowSize(openInstance->currentSize, newSize) &&
+        !DiskCache::GetInstance().Update(openInstance->inodeId, newSize)) {
         CUCKOO_LOG(LOG_ERROR) << "WriteLocalFileForBrpc(): DiskCache Update failed!";
         DiskCache::GetInstance().FreePreAllocSpace(sizeToAdd);
         return -ENOENT;
     }
     DiskCache::GetInstance().FreePreAllocSpace(sizeToAdd);
+    if (replicationMode != ReplicationMode::NONE) {
+        replicationLog.MarkDirty(openInstance->inodeId, startOffset, totalSize);
+    }
     return 0;
 }
 
@@ -283,10 +516,13 @@ int CuckooStore::WriteFile(OpenInstance *openInstance, const char *buf, size_t s
         openInstance->writeFail = true;
         return ret;
     }
+    if (replicationMode != ReplicationMode::NONE && StoreNode::GetInstance()->IsLocal(openInstance->nodeId)) {
+        replicationLog.MarkDirty(openInstance->inodeId, offset, size);
+    }
 
     if (size != 0) {
         std::unique_lock<std::shared_mutex> sizeLock(openInstance->fileMutex);
-        openInstance->currentSize = std::max(openInstance->currentSize.load(), size + offset);
+        GrowSize(openInstance->currentSize, size + offset);
     }
 
     return 0;
@@ -304,7 +540,7 @@ int CuckooStore::ReadFile(OpenInstance *openInstance, char *buf, size_t size, of
     CuckooReadBuffer cuckooBuf{buf, size};
 
     /* first persist the current write stream to let data to be read */
-    if (openInstance->writeStream.GetSize() > 0) {
+    if (openInstance->writeStream.Pending()) {
         /* write will wait for local cache to be loaded from obs, so safe to call persist */
         CUCKOO_LOG(LOG_INFO) << "In ReadFile(): Persisting the written";
         ret = openInstance->writeStream.Complete(openInstance->currentSize.load(), true, false);
@@ -367,6 +603,67 @@ int CuckooStore::ReadFile(OpenInstance *openInstance, char *buf, size_t size, of
     return 0;
 }
 
+/*
+ * Called by fuse read_buf, returns the local cache fd so data can be spliced to kernel.
+ * localFd is -1 if data is not in a local cache file or has blocks not checked yet, caller should fall back to ReadFile
+ */
+int CuckooStore::GetLocalReadFd(OpenInstance *openInstance, size_t size, off_t offset, int &localFd, size_t &readSize)
+{
+    int ret = 0;
+    localFd = -1;
+    readSize = 0;
+
+    /* small files are served from read buffer, direct io needs aligned buffer */
+    if ((openInstance->originalSize < READ_BIGFILE_SIZE && (openInstance->oflags & O_ACCMODE) == O_RDONLY) ||
+        (openInstance->oflags & __O_DIRECT) != 0) {
+        return 0;
+    }
+
+    /* first persist the current write stream to let data to be read */
+    if (openInstance->writeStream.Pending()) {
+        ret = openInstance->writeStream.Complete(openInstance->currentSize.load(), true, false);
+        if (ret != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "In GetLocalReadFd(): persist written before read failed";
+            return ret;
+        }
+    }
+
+    if (!openInstance->isOpened.load()) {
+        std::unique_lock<std::shared_mutex> openLock(openInstance->fileMutex);
+        ret = OpenFile(openInstance);
+        if (ret != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "In GetLocalReadFd(): OpenFile() failed";
+            return ret;
+        }
+        openInstance->isOpened = true;
+    }
+
+    if (!StoreNode::GetInstance()->IsLocal(openInstance->nodeId) || openInstance->physicalFd == UINT64_MAX ||
+        fileLock.TestLocked(openInstance->inodeId, LockMode::X) || offset >= (ssize_t)openInstance->currentSize) {
+        return 0;
+    }
+    /* a compressed file has no plain data to splice, ReadFile decompresses it */
+    if (frozenFiles.Find(static_cast<int>(openInstance->physicalFd)) != nullptr) {
+        return 0;
+    }
+
+    /* local file is read by pread or splice, read stream is useless */
+    if (!openInstance->preReadStarted.exchange(true)) {
+        StopPreReadThreaded(openInstance);
+    }
+
+    /* the data goes to the kernel unseen, blocks not checked yet are read once by ReadFile, which checks them */
+    uint64_t spliceSize = std::min(size, openInstance->currentSize - offset);
+    if (!ChecksumTable::GetInstance().Verified(openInstance->inodeId, static_cast<int>(openInstance->physicalFd),
+                                               offset, spliceSize)) {
+        return 0;
+    }
+    localFd = static_cast<int>(openInstance->physicalFd);
+    readSize = spliceSize;
+    CuckooStats::GetInstance().stats[BLOCKCACHE_READ] += readSize;
+    return 0;
+}
+
 /*
  * Called by ReadFile to start fill readStream
  */
@@ -374,10 +671,10 @@ bool CuckooStore::StartPreReadThreaded(OpenInstance *openInstance)
 {
     int fileBlocks = (openInstance->currentSize + CUCKOO_BLOCK_SIZE - 1) / CUCKOO_BLOCK_SIZE;
 
-    if (!openInstance->readStream.Init(openInstance, fileBlocks, CUCKOO_BLOCK_SIZE)) {
+    if (!openInstance->readStream->Init(openInstance, fileBlocks, CUCKOO_BLOCK_SIZE)) {
         return false;
     }
-    openInstance->readStream.StartPushThreaded();
+    openInstance->readStream->StartPushThreaded();
     return true;
 }
 
@@ -389,7 +686,9 @@ void CuckooStore::StopPreReadThreaded(OpenInstance *openInstance)
     /* stop only once */
     openInstance->preReadStopped.store(true);
     openInstance->directReadFile.store(true);
-    openInstance->readStream.StopPushThreaded();
+    if (openInstance->readStream.Constructed()) {
+        openInstance->readStream->StopPushThreaded();
+    }
 }
 
 /*
@@ -450,13 +749,19 @@ int CuckooStore::RandomRead(CuckooReadBuffer buf, OpenInstance *openInstance, of
 int CuckooStore::SequenceRead(CuckooReadBuffer buf, OpenInstance *openInstance, off_t /*offset*/)
 {
     // read file from read stream
-    int retSize = openInstance->readStream.WaitPop(buf.ptr, buf.size);
+    int retSize = openInstance->readStream->WaitPop(buf.ptr, buf.size);
     if (retSize > 0) {
         openInstance->serialReadEnd += retSize;
     }
     return retSize;
 }
 
+static uint64_t NowMs()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return std::chrono::duration_cast<std::chrono::milliseconds>(now).count();
+}
+
 /*
  * Read from local cache file, remote cache file, or obs
  * local file read, if failed read obs
@@ -470,47 +775,83 @@ ssize_t CuckooStore::ReadFileLR(char *readBuffer, off_t offset, OpenInstance *op
     }
     int retSize = -1;
     ssize_t checkReadLength = std::min(readBufferSize, openInstance->currentSize - offset);
+    int nodeId = -1;
+    uint64_t physicalFd = UINT64_MAX;
+    {
+        /* a failover to the backup moves both */
+        std::shared_lock<std::shared_mutex> nodeLock(openInstance->nodeMutex);
+        nodeId = openInstance->nodeId;
+        physicalFd = openInstance->physicalFd;
+    }
 
-    if (StoreNode::GetInstance()->IsLocal(openInstance->nodeId)) {
-        if (openInstance->physicalFd != UINT64_MAX && !fileLock.TestLocked(openInstance->inodeId, LockMode::X)) {
+    if (StoreNode::GetInstance()->IsLocal(nodeId)) {
+        if (physicalFd != UINT64_MAX && !fileLock.TestLocked(openInstance->inodeId, LockMode::X)) {
             /* not locked, read cache file */
+            StatLatencyTimer t(HIST_BLOCKCACHE_READ);
             CuckooStats::GetInstance().stats[BLOCKCACHE_READ] += checkReadLength;
-            retSize = pread(openInstance->physicalFd, readBuffer, readBufferSize, offset);
-            if (retSize != checkReadLength) {
+            /* of a compressed file only the blocks read are decompressed, checked by their own crcs */
+            std::shared_ptr<const CompressedIndex> index = frozenFiles.Find(static_cast<int>(physicalFd));
+            if (index != nullptr) {
+                retSize = ReadCompressed(physicalFd, *index, readBuffer, offset, checkReadLength);
+            } else {
+                retSize = pread(physicalFd, readBuffer, readBufferSize, offset);
+            }
+            if (index != nullptr && retSize < 0) {
+                CUCKOO_LOG(LOG_ERROR) << "In ReadFileLR(): compressed cache file of " << openInstance->path
+                                      << " is damaged at offset " << offset;
+                ChecksumTable::GetInstance().AddMismatch();
+                frozenFiles.SetDamaged(openInstance->inodeId);
+            } else if (index == nullptr && retSize != checkReadLength) {
                 int err = errno;
                 if (err == EAGAIN) {
-                    retSize = pread(openInstance->physicalFd, readBuffer, checkReadLength, offset);
+                    retSize = pread(physicalFd, readBuffer, checkReadLength, offset);
                     if (retSize != checkReadLength) {
                         err = errno;
-                        CUCKOO_LOG(LOG_ERROR) << "In ReadFileLR(): pread fd = " << openInstance->physicalFd
+                        CUCKOO_LOG(LOG_ERROR) << "In ReadFileLR(): pread fd = " << physicalFd
                                               << " failed : " << strerror(err);
                         retSize = -err;
                     }
                 } else {
                     CUCKOO_LOG(LOG_ERROR)
-                        << "In ReadFileLR(): pread fd = " << openInstance->physicalFd << " failed : " << strerror(err);
+                        << "In ReadFileLR(): pread fd = " << physicalFd << " failed : " << strerror(err);
                     retSize = -err;
                 }
             }
+            /* damaged data is read from storage like a failed read, the file is loaded again on a later open */
+            ChecksumTable &checksums = ChecksumTable::GetInstance();
+            if (index == nullptr && retSize > 0 &&
+                checksums.Verify(openInstance->inodeId, physicalFd, readBuffer, offset, retSize) != 0) {
+                CUCKOO_LOG(LOG_ERROR) << "In ReadFileLR(): cache file of " << openInstance->path
+                                      << " is damaged at offset " << offset;
+                retSize = -EIO;
+            }
+            /* copies of other nodes are not replicated further */
+            if (retSize >= 0 && hotFiles.GetThreshold() > 0 && !replicaCopies.Contains(openInstance->inodeId) &&
+                hotFiles.RecordRead(openInstance->inodeId, NowMs())) {
+                ReplicateHotFile(openInstance->inodeId);
+            }
         }
     } else {
         /* if read file rpc failed, no need to call rpc again */
         if (!openInstance->remoteFailed) {
-            std::shared_ptr<CuckooIOClient> cuckooIOClient =
-                StoreNode::GetInstance()->GetRpcConnection(openInstance->nodeId);
+            std::shared_ptr<CuckooIOClient> cuckooIOClient = StoreNode::GetInstance()->GetRpcConnection(nodeId);
             retSize = -EHOSTUNREACH;
             if (cuckooIOClient != nullptr) {
                 retSize = cuckooIOClient->ReadFile(openInstance->inodeId,
                                                    openInstance->oflags,
                                                    readBuffer,
-                                                   openInstance->physicalFd,
+                                                   physicalFd,
                                                    readBufferSize,
                                                    offset,
                                                    openInstance->path);
             }
             if (retSize != checkReadLength) {
                 CUCKOO_LOG(LOG_ERROR) << "In ReadFileLR(): read remote failed: " << strerror(-retSize) << ", for node "
-                                      << openInstance->nodeId;
+                                      << nodeId;
+                if (retSize < 0 && FailoverToBackup(openInstance, nodeId)) {
+                    /* read again from the backup */
+                    return ReadFileLR(readBuffer, offset, openInstance, readBufferSize);
+                }
                 openInstance->remoteFailed = true;
             }
         }
@@ -518,7 +859,7 @@ ssize_t CuckooStore::ReadFileLR(char *readBuffer, off_t offset, OpenInstance *op
     /* Read cache file failed and called by fuse not rpc -> read obs */
     if (retSize < 0 && !openInstance->isRemoteCall && persistToStorage) {
         CUCKOO_LOG(LOG_DEBUG) << "ReadFile from obs : " << openInstance->path;
-        retSize = storage->ReadObject(openInstance->path.substr(1), offset, readBufferSize, -1, readBuffer);
+        retSize = ReadStorage(openInstance->path, offset, readBufferSize, -1, readBuffer);
         if (retSize < 0) {
             CUCKOO_LOG(LOG_ERROR) << "In ReadFileLR(): obs ReadObject() failed";
             retSize = -EIO;
@@ -552,17 +893,29 @@ int CuckooStore::OpenFile(OpenInstance *openInstance)
         } else {
             /* file resides on local node */
             std::string fileName = GetFilePath(openInstance->inodeId);
-            if (openInstance->nodeFail) {
+            if ((openInstance->nodeFail && !KeepOnFailover(openInstance->inodeId)) ||
+                RefetchDamaged(openInstance->inodeId)) {
                 DiskCache::GetInstance().DeleteOldCacheWithNoPin(openInstance->inodeId);
             }
             if (DiskCache::GetInstance().Find(openInstance->inodeId, true)) {
-                /* Cache Hits: read file from cache */
-                int localFd = open(fileName.c_str(), openInstance->oflags, 0755);
+                /* Cache Hits: read file from cache, a compressed one is written plain */
+                if ((openInstance->oflags & O_ACCMODE) != O_RDONLY) {
+                    ret = ThawCacheFile(openInstance->inodeId);
+                    if (ret != 0) {
+                        DiskCache::GetInstance().Unpin(openInstance->inodeId);
+                        return ret;
+                    }
+                }
+                std::shared_ptr<const CompressedIndex> index;
+                int localFd = OpenCacheFile(openInstance->inodeId, openInstance->oflags, index);
                 if (localFd < 0) {
-                    err = errno;
                     DiskCache::GetInstance().Unpin(openInstance->inodeId);
-                    CUCKOO_LOG(LOG_ERROR) << "OpenFile(): open local file " << fileName << " failed: " << strerror(err);
-                    return -err;
+                    CUCKOO_LOG(LOG_ERROR) << "OpenFile(): open local file " << fileName
+                                          << " failed: " << strerror(-localFd);
+                    return localFd;
+                }
+                if (index != nullptr) {
+                    frozenFiles.Open(localFd, std::move(index));
                 }
                 openInstance->physicalFd = static_cast<uint64_t>(localFd);
                 CUCKOO_LOG(LOG_INFO) << "OpenFile(): Opened existed local file " << fileName
@@ -620,6 +973,13 @@ int CuckooStore::OpenFile(OpenInstance *openInstance)
                     }
                 }
             }
+            if ((openInstance->oflags & O_ACCMODE) != O_RDONLY) {
+                /* copies on other nodes go stale, none are handed out until the writer closes */
+                DropReplicas(openInstance->inodeId, hotFiles.BeginWrite(openInstance->inodeId));
+            }
+            if (!compressRules.Empty()) {
+                frozenFiles.Mark(openInstance->inodeId, compressRules.Match(openInstance->path));
+            }
         }
         openInstance->writeStream.SetInodeId(openInstance->inodeId);
         openInstance->writeStream.SetDirect(openInstance->oflags & __O_DIRECT);
@@ -676,9 +1036,9 @@ int CuckooStore::DownLoadFromStorage(OpenInstance *openInstance, bool isSync, bo
     auto loadObs = [=, this]() {
         int size = 0;
         if (toBuffer) {
-            size = storage->ReadObject(path.substr(1), 0, bufSize, fd, readBuffer.get());
+            size = ReadStorage(path, 0, bufSize, fd, readBuffer.get());
         } else {
-            size = storage->ReadObject(path.substr(1), 0, 0, fd, nullptr);
+            size = ReadStorage(path, 0, 0, fd, nullptr);
         }
 
         close(fd);
@@ -689,6 +1049,7 @@ int CuckooStore::DownLoadFromStorage(OpenInstance *openInstance, bool isSync, bo
             }
             size = -EIO;
         } else {
+            SealChecksums(inodeId);
             DiskCache::GetInstance().InsertAndUpdate(inodeId, fileSize, isSync);
         }
         DiskCache::GetInstance().FreePreAllocSpace(fileSize);
@@ -712,6 +1073,8 @@ int CuckooStore::OpenFileFromRemote(OpenInstance *openInstance, bool largeFile)
     ssize_t ret = EHOSTUNREACH;
     int nodeCnt = StoreNode::GetInstance()->GetNumberofAllNodes();
     std::shared_ptr<CuckooIOClient> cuckooIOClient = nullptr;
+    HotFileReplicas replicas;
+    bool readOnly = (openInstance->oflags & O_ACCMODE) == O_RDONLY;
 
     /* Loop on connection error, switch node after that */
     for (int i = 0; i < nodeCnt && ConnectionError(ret); i++) {
@@ -723,7 +1086,8 @@ int CuckooStore::OpenFileFromRemote(OpenInstance *openInstance, bool largeFile)
                                                openInstance->physicalFd,
                                                openInstance->originalSize,
                                                openInstance->path,
-                                               openInstance->nodeFail);
+                                               openInstance->nodeFail,
+                                               readOnly ? &replicas : nullptr);
             } else {
                 ret = cuckooIOClient->ReadSmallFile(openInstance->inodeId,
                                                     openInstance->originalSize,
@@ -761,6 +1125,9 @@ int CuckooStore::OpenFileFromRemote(OpenInstance *openInstance, bool largeFile)
             CUCKOO_LOG(LOG_ERROR) << "OpenFileFromRemote(): open remote file " << openInstance->path
                                   << " failed: " << strerror(-ret) << ", for node " << openInstance->nodeId;
         } else {
+            if (largeFile && !replicas.nodeIds.empty()) {
+                SpreadToReplica(openInstance, cuckooIOClient, replicas);
+            }
             openInstance->writeStream.SetClient(cuckooIOClient);
         }
         return ret > 0 ? -ret : ret;
@@ -769,11 +1136,7 @@ int CuckooStore::OpenFileFromRemote(OpenInstance *openInstance, bool largeFile)
     /* Any error for small file, read obs itself */
     if (persistToStorage) {
         CUCKOO_LOG(LOG_WARNING) << "OpenFileFromRemote(): small read remote failed, read obs instead";
-        ret = storage->ReadObject(openInstance->path.substr(1),
-                                  0,
-                                  openInstance->readBufferSize,
-                                  -1,
-                                  openInstance->readBuffer.get());
+        ret = ReadStorage(openInstance->path, 0, openInstance->readBufferSize, -1, openInstance->readBuffer.get());
         if (ret < 0) {
             CUCKOO_LOG(LOG_ERROR) << "OpenFileFromRemote(): obs ReadObject() " << openInstance->path << " failed";
             return -EIO;
@@ -824,7 +1187,9 @@ int CuckooStore::CloseTmpFiles(OpenInstance *openInstance, bool isFlush, bool is
     /* stop the possible preRead thread */
     if (!isFlush && !openInstance->isRemoteCall) {
         StopPreReadThreaded(openInstance);
-        openInstance->readStream.WaitPushEnded();
+        if (openInstance->readStream.Constructed()) {
+            openInstance->readStream->WaitPushEnded();
+        }
     }
 
     /* first persist the writeStream, then rpc call remote to flush or close */
@@ -842,13 +1207,19 @@ int CuckooStore::CloseTmpFiles(OpenInstance *openInstance, bool isFlush, bool is
     if (StoreNode::GetInstance()->IsLocal(openInstance->nodeId)) {
         /* close file */
         if (!isFlush) {
+            frozenFiles.Close(static_cast<int>(openInstance->physicalFd));
             close(openInstance->physicalFd);
             DiskCache::GetInstance().Unpin(openInstance->inodeId);
+            if ((openInstance->oflags & O_ACCMODE) != O_RDONLY) {
+                hotFiles.EndWrite(openInstance->inodeId);
+            }
             return ret;
         }
         /* flush file */
-        /* update diskcache file size, do not pin */
-        DiskCache::GetInstance().InsertAndUpdate(openInstance->inodeId, openInstance->currentSize, false);
+        /* update diskcache file size, do not pin, a compressed file keeps the size it takes on disk */
+        if (frozenFiles.Find(static_cast<int>(openInstance->physicalFd)) == nullptr) {
+            DiskCache::GetInstance().InsertAndUpdate(openInstance->inodeId, openInstance->currentSize, false);
+        }
         if (openInstance->writeCnt > 0 && !openInstance->writeFail) {
             if (isSync) {
                 fsync(openInstance->physicalFd);
@@ -860,6 +1231,13 @@ int CuckooStore::CloseTmpFiles(OpenInstance *openInstance, bool isFlush, bool is
                 openInstance->writeFail = (ret != 0);
             }
         }
+        /* what was flushed is what later reads are checked against, the close does not wait for the whole file */
+        if (openInstance->writeCnt > 0 && !openInstance->writeFail) {
+            SealChecksumsAsync(openInstance->inodeId);
+        }
+        if (replicationMode != ReplicationMode::NONE && !openInstance->writeFail) {
+            BackupFile(openInstance->inodeId);
+        }
     }
     return ret;
 }
@@ -870,7 +1248,11 @@ int CuckooStore::FlushToStorage(std::string path, uint64_t inodeId)
     std::string object = path.substr(1);
     std::string localFile = GetFilePath(inodeId);
 
-    ret = storage->PutFile(object, localFile);
+    /* objects that do not shrink or can not be put compressed are put plain */
+    CompressCodec codec = storageCompressRules.Match(path);
+    if (codec == CompressCodec::NONE || FlushCompressed(object, inodeId, codec) != 0) {
+        ret = storage->PutFile(object, localFile, "");
+    }
     if (ret == 0) {
         CUCKOO_LOG(LOG_INFO) << "Flush file " << object << " to obs succeeded!";
     } else {
@@ -879,6 +1261,123 @@ int CuckooStore::FlushToStorage(std::string path, uint64_t inodeId)
     return ret == 0 ? ret : -EIO;
 }
 
+int CuckooStore::FlushCompressed(const std::string &object, uint64_t inodeId, CompressCodec codec)
+{
+    std::string localFile = GetFilePath(inodeId);
+    int fd = open(localFile.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return -errno;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        return -err;
+    }
+    uint64_t rawSize = st.st_size;
+    if (!DiskCache::GetInstance().PreAllocSpace(rawSize)) {
+        close(fd);
+        return -ENOSPC;
+    }
+    /* flushes of one file through two fds each compress a copy of their own */
+    std::string tmpName = localFile + "." + std::to_string(gettid()) + COMPRESS_TMP_SUFFIX;
+    uint64_t compressedSize = 0;
+    int ret = CompressFile(fd, tmpName, codec, compressedSize);
+    close(fd);
+    if (ret == 0 && compressedSize * 100 > rawSize * COMPRESS_MAX_RATIO_PERCENT) {
+        ret = -ECANCELED;
+    }
+    if (ret == 0) {
+        ret = storage->PutFile(object, tmpName, CompressCodecName(codec));
+    }
+    unlink(tmpName.c_str());
+    DiskCache::GetInstance().FreePreAllocSpace(rawSize);
+    if (ret == 0) {
+        CUCKOO_LOG(LOG_INFO) << "Flush file " << object << " compressed from " << rawSize << " to " << compressedSize
+                             << " bytes";
+    }
+    return ret;
+}
+
+ssize_t CuckooStore::ReadStorage(const std::string &path, uint64_t offset, uint64_t size, int fd, char *buf)
+{
+    std::string object = path.substr(1);
+    /* nothing is flushed compressed unless configured, the object is not asked about before it is read */
+    if (storageCompressRules.Empty()) {
+        return storage->ReadObject(object, offset, size, fd, buf);
+    }
+    uint64_t objectSize = 0;
+    std::string codec;
+    if (storage->HeadObject(object, objectSize, codec) != 0) {
+        return -1;
+    }
+    if (codec.empty()) {
+        return storage->ReadObject(object, offset, size, fd, buf);
+    }
+    return ReadCompressedObject(object, objectSize, offset, size, fd, buf);
+}
+
+ssize_t CuckooStore::ReadCompressedObject(const std::string &object,
+                                          uint64_t objectSize,
+                                          uint64_t offset,
+                                          uint64_t size,
+                                          int fd,
+                                          char *buf)
+{
+    /* the index is at the end, one read of the tail mostly gets it whole */
+    CompressedIndex index;
+    uint64_t tailSize = std::min<uint64_t>(objectSize, STORAGE_COMPRESS_TAIL_SIZE);
+    std::vector<char> stored(tailSize);
+    int ret = -EIO;
+    for (int attempt = 0; attempt < 2 && ret != 0; ++attempt) {
+        stored.resize(tailSize);
+        if (storage->ReadObject(object, objectSize - tailSize, tailSize, -1, stored.data()) !=
+            static_cast<ssize_t>(tailSize)) {
+            return -1;
+        }
+        ret = ParseCompressedTail(stored.data(), tailSize, objectSize, index, tailSize);
+        if (ret != -ERANGE) {
+            break;
+        }
+    }
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "ReadCompressedObject(): " << object << " is damaged or of a codec not built in";
+        return -1;
+    }
+    if (offset >= index.rawSize) {
+        return 0;
+    }
+    /* size 0 reads to the end of the object, the data lands at the start of buf and of fd */
+    uint64_t end = size == 0 ? index.rawSize : std::min<uint64_t>(index.rawSize, offset + size);
+    std::vector<char> plain(buf == nullptr ? STORAGE_COMPRESS_BATCH_SIZE : 0);
+    for (uint64_t pos = offset; pos < end;) {
+        uint64_t batchEnd = std::min<uint64_t>(end, pos / COMPRESS_BLOCK_SIZE * COMPRESS_BLOCK_SIZE +
+                                                        STORAGE_COMPRESS_BATCH_SIZE);
+        uint64_t storedOffset = 0;
+        uint64_t storedSize = 0;
+        StoredRange(index, pos, batchEnd - pos, storedOffset, storedSize);
+        stored.resize(storedSize);
+        if (storage->ReadObject(object, storedOffset, storedSize, -1, stored.data()) !=
+            static_cast<ssize_t>(storedSize)) {
+            return -1;
+        }
+        char *dst = buf != nullptr ? buf + (pos - offset) : plain.data();
+        ssize_t readSize = DecompressRange(index, stored.data(), storedOffset, dst, pos, batchEnd - pos);
+        if (readSize <= 0) {
+            CUCKOO_LOG(LOG_ERROR) << "ReadCompressedObject(): a block of " << object << " is damaged";
+            return -1;
+        }
+        if (fd != -1) {
+            CuckooStats::GetInstance().stats[BLOCKCACHE_WRITE] += readSize;
+            if (pwrite(fd, dst, readSize, pos - offset) != readSize) {
+                return -1;
+            }
+        }
+        pos += readSize;
+    }
+    return static_cast<ssize_t>(end - offset);
+}
+
 /*---------------------- small file open ----------------------*/
 
 /*
@@ -907,12 +1406,13 @@ int CuckooStore::ReadSmallFiles(OpenInstance *openInstance)
     /* File resides on local node */
     std::string fileName = GetFilePath(inodeId);
 
-    if (openInstance->nodeFail) {
+    if ((openInstance->nodeFail && !KeepOnFailover(inodeId)) || RefetchDamaged(inodeId)) {
         DiskCache::GetInstance().DeleteOldCacheWithNoPin(inodeId);
     }
     /* Check if in disk cache. True then pin the file */
     if (DiskCache::GetInstance().Find(inodeId, true)) {
         /* Cache Hit: read whole file to read buffer */
+        StatLatencyTimer t(HIST_BLOCKCACHE_READ);
         int localFd = open(fileName.c_str(), O_RDONLY);
         if (localFd < 0) {
             int err = errno;
@@ -938,9 +1438,19 @@ int CuckooStore::ReadSmallFiles(OpenInstance *openInstance)
             DiskCache::GetInstance().Unpin(inodeId);
             return -err;
         }
+        ret = ChecksumTable::GetInstance().Verify(inodeId, localFd, readBuffer, 0, bufSize);
         close(localFd);
         /* unpin the file after close */
         DiskCache::GetInstance().Unpin(inodeId);
+        if (ret != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "ReadSmallFiles(): cache file of " << path << " is damaged";
+            if (!persistToStorage) {
+                return ret;
+            }
+            /* damaged data is read from storage instead, the file is loaded again on a later open */
+            ret = ReadStorage(path, 0, bufSize, -1, readBuffer);
+            return ret < 0 ? -EIO : 0;
+        }
     } else {
         /* Cache Miss: load file from obs */
         if (!persistToStorage) {
@@ -969,7 +1479,7 @@ int CuckooStore::ReadSmallFiles(OpenInstance *openInstance)
 
         /* Call is from fuse user. Sync read obs to buffer and Async write to local file */
         /* Sync read obs to read buffer */
-        ret = storage->ReadObject(path.substr(1), 0, bufSize, -1, readBuffer);
+        ret = ReadStorage(path, 0, bufSize, -1, readBuffer);
         if (ret < 0) {
             CUCKOO_LOG(LOG_ERROR) << "Obs read failed";
             return -EIO;
@@ -1014,9 +1524,10 @@ int CuckooStore::WriteToFileAsync(uint64_t inodeId, std::string &fileName, std::
         return -err;
     }
 
-    /* Async write the file to local file */
+    /* Async write the file to local file, cache fill should not delay reads waiting in the pool */
     ThreadTask task;
-    task.task = [fd, buf, bufSize, inodeId, lockerPtr]() {
+    task.priority = TaskPriority::BACKGROUND;
+    task.task = [this, fd, buf, bufSize, inodeId, lockerPtr]() {
         CuckooStats::GetInstance().stats[BLOCKCACHE_WRITE] += bufSize;
         int retSize = pwrite(fd, buf.get(), bufSize, 0);
         int err = errno;
@@ -1024,6 +1535,7 @@ int CuckooStore::WriteToFileAsync(uint64_t inodeId, std::string &fileName, std::
         if (retSize < 0) {
             CUCKOO_LOG(LOG_ERROR) << "WriteToFileAsync(): pwrite failed : " << strerror(err);
         } else {
+            SealChecksums(inodeId);
             DiskCache::GetInstance().InsertAndUpdate(inodeId, bufSize, false);
         }
         DiskCache::GetInstance().FreePreAllocSpace(bufSize);
@@ -1049,12 +1561,13 @@ int CuckooStore::ReadSmallFilesForBrpc(uint64_t inodeId,
     /* File resides on local node */
     std::string fileName = GetFilePath(inodeId);
     /* Check if in disk cache. True then pin the file */
-    if (nodeFail) {
+    if ((nodeFail && !KeepOnFailover(inodeId)) || RefetchDamaged(inodeId)) {
         DiskCache::GetInstance().DeleteOldCacheWithNoPin(inodeId);
     }
 
     if (DiskCache::GetInstance().Find(inodeId, true)) {
         /* Cache Hit: read whole file to read buffer */
+        StatLatencyTimer t(HIST_BLOCKCACHE_READ);
         int localFd = open(fileName.c_str(), O_RDONLY);
         if (localFd < 0) {
             int err = errno;
@@ -1081,9 +1594,14 @@ int CuckooStore::ReadSmallFilesForBrpc(uint64_t inodeId,
             DiskCache::GetInstance().Unpin(inodeId);
             return -err;
         }
+        /* the caller reads damaged data from storage itself */
+        ret = ChecksumTable::GetInstance().Verify(inodeId, localFd, buf, 0, size);
         close(localFd);
         /* unpin the file after close */
         DiskCache::GetInstance().Unpin(inodeId);
+        if (ret != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "ReadSmallFilesForBrpc(): cache file of " << path << " is damaged";
+        }
     } else {
         /* Cache Miss: load file from obs */
         if (!persistToStorage) {
@@ -1158,9 +1676,9 @@ int CuckooStore::DownLoadFromStorageForBrpc(uint64_t inodeId,
     auto loadObs = [=, this]() {
         int size = 0;
         if (toBuffer) {
-            size = storage->ReadObject(path.substr(1), 0, bufSize, fd, buf);
+            size = ReadStorage(path, 0, bufSize, fd, buf);
         } else {
-            size = storage->ReadObject(path.substr(1), 0, 0, fd, nullptr);
+            size = ReadStorage(path, 0, 0, fd, nullptr);
         }
 
         close(fd);
@@ -1171,6 +1689,7 @@ int CuckooStore::DownLoadFromStorageForBrpc(uint64_t inodeId,
             }
             size = -EIO;
         } else {
+            SealChecksums(inodeId);
             DiskCache::GetInstance().InsertAndUpdate(inodeId, bufSize, isSync);
         }
         DiskCache::GetInstance().FreePreAllocSpace(bufSize);
@@ -1192,6 +1711,10 @@ int CuckooStore::DeleteFiles(uint64_t inodeId, int nodeId, std::string path)
 {
     int ret = 0;
     if (nodeId == -1 || StoreNode::GetInstance()->IsLocal(nodeId)) {
+        DropReplicas(inodeId, hotFiles.Invalidate(inodeId));
+        DropBackup(inodeId);
+        preloadPins.Release(inodeId);
+        frozenFiles.Forget(inodeId);
         if (DiskCache::GetInstance().Find(inodeId, false)) {
             ret = DiskCache::GetInstance().Delete(inodeId);
             if (ret != 0) {
@@ -1342,6 +1865,12 @@ int CuckooStore::TruncateFile(OpenInstance *openInstance, off_t size)
             CUCKOO_LOG(LOG_ERROR) << "Truncate file " << fileName << " failed : " << strerror(err);
             return -err;
         }
+        DropReplicas(openInstance->inodeId, hotFiles.Invalidate(openInstance->inodeId));
+        SealChecksums(openInstance->inodeId);
+        if (replicationMode != ReplicationMode::NONE) {
+            replicationLog.MarkDirty(openInstance->inodeId, size, 0);
+            BackupFile(openInstance->inodeId);
+        }
     } else {
         /* remote file to truncate */
         std::shared_ptr<CuckooIOClient> cuckooIOClient =
@@ -1366,7 +1895,7 @@ int CuckooStore::TruncateOpenInstance(OpenInstance *openInstance, off_t size)
     int ret = 0;
 
     // persist the current write stream to let currentSize updated
-    if (openInstance->writeStream.GetSize() > 0) {
+    if (openInstance->writeStream.Pending()) {
         // write will wait for local cache to be loaded from obs, so safe to call complete
         CUCKOO_LOG(LOG_INFO) << "In TruncateOpenInstance(): Persisting the written";
         ret = openInstance->writeStream.Complete(openInstance->currentSize.load(), true, false);
@@ -1396,3 +1925,794 @@ int CuckooStore::TruncateOpenInstance(OpenInstance *openInstance, off_t size)
     openInstance->originalSize = size;
     return 0;
 }
+
+/*---------------------- lock ----------------------*/
+
+/* locks of an inode are kept by the node its inode id hashes to, wherever its data is cached */
+int CuckooStore::LockFile(uint64_t inodeId,
+                          int cmd,
+                          struct flock *lockInfo,
+                          uint64_t owner,
+                          RangeLockType type,
+                          const std::function<bool()> &interrupted)
+{
+    int ownerNodeId = StoreNode::GetInstance()->GetNodeId();
+    int lockNodeId = StoreNode::GetInstance()->AllocNode(inodeId);
+    if (StoreNode::GetInstance()->IsLocal(lockNodeId)) {
+        return LockLocalFile(inodeId, cmd, lockInfo, owner, ownerNodeId, type, interrupted);
+    }
+
+    std::shared_ptr<CuckooIOClient> cuckooIOClient = StoreNode::GetInstance()->GetRpcConnection(lockNodeId);
+    if (cuckooIOClient == nullptr) {
+        return -EHOSTUNREACH;
+    }
+    if (cmd != F_SETLKW) {
+        return cuckooIOClient->LockFile(inodeId, cmd, lockInfo, owner, ownerNodeId, type);
+    }
+    /* the lock node never waits in an rpc, poll with backoff instead */
+    int backoffMs = 1;
+    int ret = 0;
+    while ((ret = cuckooIOClient->LockFile(inodeId, F_SETLK, lockInfo, owner, ownerNodeId, type)) == -EAGAIN) {
+        if (interrupted != nullptr && interrupted()) {
+            return -EINTR;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(backoffMs));
+        backoffMs = std::min(backoffMs * 2, LOCK_POLL_MAX_INTERVAL_MS);
+    }
+    return ret;
+}
+
+int CuckooStore::LockLocalFile(uint64_t inodeId,
+                               int cmd,
+                               struct flock *lockInfo,
+                               uint64_t owner,
+                               int ownerNodeId,
+                               RangeLockType type,
+                               const std::function<bool()> &interrupted)
+{
+    /* fuse hands over absolute ranges, l_len 0 for up to the end of file */
+    if (lockInfo->l_start < 0 || lockInfo->l_len < 0) {
+        return -EINVAL;
+    }
+    RangeLock rangeLock;
+    rangeLock.start = static_cast<uint64_t>(lockInfo->l_start);
+    rangeLock.end = lockInfo->l_len == 0 ? RANGE_LOCK_EOF : rangeLock.start + static_cast<uint64_t>(lockInfo->l_len);
+    rangeLock.mode = lockInfo->l_type == F_WRLCK ? LockMode::X : LockMode::S;
+    rangeLock.owner = owner;
+    rangeLock.nodeId = ownerNodeId;
+    rangeLock.pid = lockInfo->l_pid;
+
+    if (cmd == F_GETLK) {
+        RangeLock conflict;
+        if (!fileLock.GetRangeLockConflict(inodeId, rangeLock, conflict, type)) {
+            lockInfo->l_type = F_UNLCK;
+            return 0;
+        }
+        lockInfo->l_type = conflict.mode == LockMode::X ? F_WRLCK : F_RDLCK;
+        lockInfo->l_whence = SEEK_SET;
+        lockInfo->l_start = static_cast<off_t>(conflict.start);
+        lockInfo->l_len = conflict.end == RANGE_LOCK_EOF ? 0 : static_cast<off_t>(conflict.end - conflict.start);
+        lockInfo->l_pid = conflict.pid;
+        return 0;
+    }
+    if (lockInfo->l_type == F_UNLCK) {
+        fileLock.ReleaseRangeLock(inodeId, rangeLock, type);
+        return 0;
+    }
+    return fileLock.SetRangeLock(inodeId, rangeLock, cmd == F_SETLKW, type, interrupted);
+}
+
+/*---------------------- replica ----------------------*/
+
+/*
+ * A file read often on its node gets copies on the nodes following it. Readers on other nodes learn
+ * the copies from the open reply and spread over them, a copy is pulled from the primary on the first
+ * open of it. Every hot period has a new version, so a copy left from an earlier one is never read.
+ */
+HotFileReplicas CuckooStore::GetHotFileReplicas(uint64_t inodeId) { return hotFiles.GetReplicas(inodeId); }
+
+void CuckooStore::ReplicateHotFile(uint64_t inodeId)
+{
+    int nodeId = StoreNode::GetInstance()->GetNodeId();
+    std::vector<int> replicaNodeIds = StoreNode::GetInstance()->GetReplicaNodes(nodeId, hotFileReplicaNum);
+    if (replicaNodeIds.empty()) {
+        return;
+    }
+    uint64_t version = hotFiles.SetReplicas(inodeId, replicaNodeIds);
+    if (version != 0) {
+        CUCKOO_LOG(LOG_INFO) << "ReplicateHotFile(): inode " << inodeId << " is hot, " << replicaNodeIds.size()
+                             << " replicas of version " << version;
+    }
+}
+
+void CuckooStore::DropReplicas(uint64_t inodeId, const HotFileReplicas &replicas)
+{
+    /* only frees space, a stale copy is never handed out again */
+    uint64_t version = replicas.version;
+    for (int nodeId : replicas.nodeIds) {
+        auto dropReplica = [inodeId, version, nodeId]() {
+            std::shared_ptr<CuckooIOClient> cuckooIOClient = StoreNode::GetInstance()->GetRpcConnection(nodeId);
+            if (cuckooIOClient != nullptr) {
+                cuckooIOClient->DropReplica(inodeId, version);
+            }
+        };
+        storeThreadPool->Submit({.taskName = "", .task = dropReplica, .priority = TaskPriority::BACKGROUND});
+    }
+}
+
+int CuckooStore::DropReplicaForBrpc(uint64_t inodeId, uint64_t version)
+{
+    FileLocker locker(&replicaLock, inodeId, LockMode::X, true);
+    /* the same file may be a backup copy too, which stays */
+    if (replicaCopies.Drop(inodeId, version) && !KeepOnFailover(inodeId)) {
+        /* a copy still pinned by readers is evicted as usual later */
+        DiskCache::GetInstance().DeleteOldCacheWithNoPin(inodeId);
+    }
+    return 0;
+}
+
+/* leaves the copy pinned in disk cache */
+int CuckooStore::FillReplica(OpenInstance *openInstance, int primaryNodeId, uint64_t version)
+{
+    uint64_t inodeId = openInstance->inodeId;
+    FileLocker locker(&replicaLock, inodeId, LockMode::X, true);
+    if (replicaCopies.Has(inodeId, version) && DiskCache::GetInstance().Find(inodeId, true)) {
+        return 0;
+    }
+
+    std::shared_ptr<CuckooIOClient> cuckooIOClient = StoreNode::GetInstance()->GetRpcConnection(primaryNodeId);
+    if (cuckooIOClient == nullptr) {
+        return -EHOSTUNREACH;
+    }
+    uint64_t size = openInstance->originalSize;
+    uint64_t primaryFd = 0;
+    int ret = cuckooIOClient->OpenFile(inodeId, O_RDONLY, primaryFd, size, openInstance->path, false);
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "FillReplica(): open " << openInstance->path << " on node " << primaryNodeId
+                              << " failed: " << strerror(std::abs(ret));
+        return ret > 0 ? -ret : ret;
+    }
+    if (!DiskCache::GetInstance().PreAllocSpace(size)) {
+        CUCKOO_LOG(LOG_ERROR) << "FillReplica(): Can not pre-allocate enough space!";
+        cuckooIOClient->CloseFile(primaryFd, false, false, nullptr, 0, 0);
+        return -ENOSPC;
+    }
+
+    /* pulled aside and renamed over, readers of an older copy keep theirs. not under a cache directory, so
+     * a copy left half pulled is never scanned into disk cache */
+    std::string tmpName = dataPath + "/" + std::to_string(inodeId) + "-replica";
+    int fd = open(tmpName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0755);
+    if (fd < 0) {
+        ret = -errno;
+        CUCKOO_LOG(LOG_ERROR) << "FillReplica(): create " << tmpName << " failed: " << strerror(-ret);
+    } else {
+        auto buf = std::make_unique<char[]>(CUCKOO_BLOCK_SIZE);
+        for (uint64_t offset = 0; offset < size;) {
+            int readSize = std::min<uint64_t>(CUCKOO_BLOCK_SIZE, size - offset);
+            readSize =
+                cuckooIOClient->ReadFile(inodeId, O_RDONLY, buf.get(), primaryFd, readSize, offset, openInstance->path);
+            if (readSize <= 0) {
+                ret = readSize < 0 ? readSize : -EIO;
+                break;
+            }
+            if (pwrite(fd, buf.get(), readSize, offset) != readSize) {
+                ret = -EIO;
+                break;
+            }
+            offset += readSize;
+        }
+        close(fd);
+    }
+    cuckooIOClient->CloseFile(primaryFd, false, false, nullptr, 0, 0);
+
+    std::string fileName = GetFilePath(inodeId);
+    if (ret == 0 && rename(tmpName.c_str(), fileName.c_str()) != 0) {
+        ret = -errno;
+    }
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "FillReplica(): pull " << openInstance->path << " from node " << primaryNodeId
+                              << " failed: " << strerror(-ret);
+        std::remove(tmpName.c_str());
+        DiskCache::GetInstance().FreePreAllocSpace(size);
+        return ret;
+    }
+    SealChecksums(inodeId);
+    /* an older copy is in disk cache already, only its size is updated */
+    DiskCache::GetInstance().InsertAndUpdate(inodeId, size, false);
+    DiskCache::GetInstance().FreePreAllocSpace(size);
+    if (!DiskCache::GetInstance().Find(inodeId, true)) {
+        return -ENOENT;
+    }
+    replicaCopies.Set(inodeId, version);
+    return 0;
+}
+
+int CuckooStore::OpenReplica(OpenInstance *openInstance, int primaryNodeId, uint64_t version)
+{
+    int ret = FillReplica(openInstance, primaryNodeId, version);
+    if (ret != 0) {
+        return ret;
+    }
+    std::string fileName = GetFilePath(openInstance->inodeId);
+    int localFd = open(fileName.c_str(), O_RDONLY | (openInstance->oflags & __O_DIRECT));
+    if (localFd < 0) {
+        int err = errno;
+        DiskCache::GetInstance().Unpin(openInstance->inodeId);
+        CUCKOO_LOG(LOG_ERROR) << "OpenReplica(): open local file " << fileName << " failed: " << strerror(err);
+        return -err;
+    }
+    openInstance->physicalFd = static_cast<uint64_t>(localFd);
+    openInstance->writeStream.SetInodeId(openInstance->inodeId);
+    openInstance->writeStream.SetDirect(openInstance->oflags & __O_DIRECT);
+    return openInstance->writeStream.SetFd(openInstance->physicalFd);
+}
+
+int CuckooStore::ReplicaNodeFor(uint64_t inodeId, int primaryNodeId, const std::vector<int> &replicaNodeIds)
+{
+    /* a node holding a copy reads its own, others spread over the primary and the copies by node */
+    int localNodeId = StoreNode::GetInstance()->GetNodeId();
+    if (std::ranges::find(replicaNodeIds, localNodeId) != replicaNodeIds.end()) {
+        return localNodeId;
+    }
+    uint64_t hash = (inodeId ^ static_cast<uint64_t>(localNodeId) << 32) * 0x9E3779B97F4A7C15ULL;
+    size_t index = (hash >> 32) % (replicaNodeIds.size() + 1);
+    return index < replicaNodeIds.size() ? replicaNodeIds[index] : primaryNodeId;
+}
+
+void CuckooStore::SpreadToReplica(OpenInstance *openInstance,
+                                  std::shared_ptr<CuckooIOClient> &cuckooIOClient,
+                                  const HotFileReplicas &replicas)
+{
+    int localNodeId = StoreNode::GetInstance()->GetNodeId();
+    int primaryNodeId = openInstance->nodeId;
+    int replicaNodeId = ReplicaNodeFor(openInstance->inodeId, primaryNodeId, replicas.nodeIds);
+    if (replicaNodeId == primaryNodeId) {
+        return;
+    }
+
+    uint64_t primaryFd = openInstance->physicalFd;
+    std::shared_ptr<CuckooIOClient> replicaClient = nullptr;
+    int ret = 0;
+    if (replicaNodeId == localNodeId) {
+        ret = OpenReplica(openInstance, primaryNodeId, replicas.version);
+    } else {
+        replicaClient = StoreNode::GetInstance()->GetRpcConnection(replicaNodeId);
+        ret = replicaClient == nullptr ? -EHOSTUNREACH
+                                       : replicaClient->OpenReplicaFile(openInstance->inodeId,
+                                                                        openInstance->physicalFd,
+                                                                        openInstance->originalSize,
+                                                                        openInstance->path,
+                                                                        primaryNodeId,
+                                                                        replicas.version);
+    }
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_WARNING) << "SpreadToReplica(): replica of " << openInstance->path << " on node "
+                                << replicaNodeId << " unavailable, read from node " << primaryNodeId;
+        openInstance->physicalFd = primaryFd;
+        return;
+    }
+    openInstance->nodeId = replicaNodeId;
+    cuckooIOClient->CloseFile(primaryFd, false, false, nullptr, 0, 0);
+    cuckooIOClient = replicaClient;
+}
+
+/*---------------------- backup ----------------------*/
+
+bool CuckooStore::KeepOnFailover(uint64_t inodeId)
+{
+    return replicationMode != ReplicationMode::NONE && backupCopies.Current(inodeId);
+}
+
+void CuckooStore::BackupFile(uint64_t inodeId)
+{
+    if (!replicationLog.Pending(inodeId)) {
+        return;
+    }
+    if (replicationMode == ReplicationMode::SYNC) {
+        /* a failure is only logged, the file is still flushed */
+        SyncBackup(inodeId);
+        return;
+    }
+    auto syncBackup = [this, inodeId]() { SyncBackup(inodeId); };
+    storeThreadPool->Submit({.taskName = "", .task = syncBackup, .priority = TaskPriority::BACKGROUND});
+}
+
+int CuckooStore::SyncBackup(uint64_t inodeId)
+{
+    int localNodeId = StoreNode::GetInstance()->GetNodeId();
+    int backupNodeId = StoreNode::GetInstance()->GetBackupNode(localNodeId, inodeId);
+    if (backupNodeId < 0) {
+        /* a single node has nowhere to back up to */
+        return 0;
+    }
+    FileLocker locker(&backupLock, inodeId, LockMode::X, true);
+    std::optional<BackupWork> work = replicationLog.Take(inodeId, backupNodeId);
+    if (!work) {
+        return 0;
+    }
+    int ret = ShipToBackup(inodeId, backupNodeId, *work);
+    if (ret == -ESTALE && !work->full) {
+        /* the backup lost its copy, evicted or restarted */
+        ret = ShipToBackup(inodeId, backupNodeId, BackupWork{.full = true});
+    }
+    if (ret == -ENOENT) {
+        /* deleted or evicted since, nothing to back up */
+        replicationLog.Forget(inodeId);
+        return 0;
+    }
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_WARNING) << "SyncBackup(): back up inode " << inodeId << " on node " << backupNodeId
+                                << " failed: " << strerror(-ret);
+        replicationLog.Fail(inodeId);
+        return ret;
+    }
+    replicationLog.Done(inodeId, backupNodeId);
+    return 0;
+}
+
+int CuckooStore::ShipToBackup(uint64_t inodeId, int backupNodeId, const BackupWork &work)
+{
+    std::shared_ptr<CuckooIOClient> cuckooIOClient = StoreNode::GetInstance()->GetRpcConnection(backupNodeId);
+    if (cuckooIOClient == nullptr) {
+        return -EHOSTUNREACH;
+    }
+    std::shared_ptr<const CompressedIndex> index;
+    int fd = OpenCacheFile(inodeId, O_RDONLY, index);
+    if (fd < 0) {
+        return fd;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        return -err;
+    }
+    /* a compressed file is shipped plain */
+    uint64_t fileSize = index != nullptr ? index->rawSize : st.st_size;
+    std::vector<std::pair<uint64_t, uint64_t>> ranges = work.ranges;
+    if (work.full) {
+        ranges = {{0, fileSize}};
+    }
+
+    int localNodeId = StoreNode::GetInstance()->GetNodeId();
+    auto buf = std::make_unique<char[]>(CUCKOO_BLOCK_SIZE);
+    bool reset = work.full;
+    int ret = 0;
+    for (auto [start, end] : ranges) {
+        end = std::min(end, fileSize);
+        for (uint64_t offset = start; ret == 0 && offset < end;) {
+            size_t size = std::min<uint64_t>(CUCKOO_BLOCK_SIZE, end - offset);
+            ssize_t readSize = index != nullptr ? ReadCompressed(fd, *index, buf.get(), offset, size)
+                                                : pread(fd, buf.get(), size, offset);
+            if (readSize <= 0) {
+                ret = readSize == 0 ? -EIO : (index != nullptr ? static_cast<int>(readSize) : -errno);
+                break;
+            }
+            ret = cuckooIOClient->ReplicateFile(inodeId,
+                                                localNodeId,
+                                                buf.get(),
+                                                readSize,
+                                                offset,
+                                                fileSize,
+                                                reset,
+                                                false);
+            reset = false;
+            offset += readSize;
+        }
+        if (ret != 0) {
+            break;
+        }
+    }
+    close(fd);
+    if (ret == 0) {
+        /* sets the size, and completes a whole copy */
+        ret = cuckooIOClient->ReplicateFile(inodeId, localNodeId, nullptr, 0, 0, fileSize, reset, true);
+    }
+    return ret;
+}
+
+void CuckooStore::DropBackup(uint64_t inodeId)
+{
+    if (replicationMode == ReplicationMode::NONE) {
+        return;
+    }
+    replicationLog.Forget(inodeId);
+    backupCopies.Erase(inodeId);
+    int localNodeId = StoreNode::GetInstance()->GetNodeId();
+    int backupNodeId = StoreNode::GetInstance()->GetBackupNode(localNodeId, inodeId);
+    if (backupNodeId < 0) {
+        return;
+    }
+    auto dropBackup = [this, inodeId, localNodeId, backupNodeId]() {
+        /* after a sync already running, which may recreate the copy */
+        FileLocker locker(&backupLock, inodeId, LockMode::X, true);
+        std::shared_ptr<CuckooIOClient> cuckooIOClient = StoreNode::GetInstance()->GetRpcConnection(backupNodeId);
+        if (cuckooIOClient != nullptr) {
+            cuckooIOClient->DropBackup(inodeId, localNodeId);
+        }
+    };
+    storeThreadPool->Submit({.taskName = "", .task = dropBackup, .priority = TaskPriority::BACKGROUND});
+}
+
+int CuckooStore::ReplicateFileForBrpc(uint64_t inodeId,
+                                      int primaryNodeId,
+                                      butil::IOBuf &buf,
+                                      off_t offset,
+                                      uint64_t fileSize,
+                                      bool reset,
+                                      bool last)
+{
+    FileLocker locker(&replicaLock, inodeId, LockMode::X, true);
+    std::string fileName = GetFilePath(inodeId);
+    if (reset) {
+        backupCopies.BeginFill(inodeId, primaryNodeId);
+    } else if (access(fileName.c_str(), F_OK) != 0 || !backupCopies.BeginChange(inodeId, primaryNodeId)) {
+        /* no copy to change, the primary ships the whole file */
+        return -ESTALE;
+    }
+    int fd = open(fileName.c_str(), O_WRONLY | O_CREAT | (reset ? O_TRUNC : 0), 0755);
+    if (fd < 0) {
+        int err = errno;
+        CUCKOO_LOG(LOG_ERROR) << "ReplicateFileForBrpc(): open backup " << fileName << " failed: " << strerror(err);
+        backupCopies.Erase(inodeId);
+        return -err;
+    }
+    int ret = 0;
+    size_t writeSize = buf.size();
+    while (writeSize > 0) {
+        ssize_t nwrite = buf.pcut_into_file_descriptor(fd, offset, writeSize);
+        if (nwrite <= 0) {
+            ret = nwrite < 0 ? -errno : -EIO;
+            break;
+        }
+        writeSize -= nwrite;
+        offset += nwrite;
+    }
+    if (ret == 0 && last && ftruncate(fd, fileSize) != 0) {
+        ret = -errno;
+    }
+    struct stat st;
+    if (ret == 0 && fstat(fd, &st) != 0) {
+        ret = -errno;
+    }
+    close(fd);
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "ReplicateFileForBrpc(): write backup " << fileName << " failed: " << strerror(-ret);
+        backupCopies.Erase(inodeId);
+        return ret;
+    }
+    /* a copy in disk cache already only gets its size updated */
+    DiskCache::GetInstance().InsertAndUpdate(inodeId, st.st_size, false);
+    if (last) {
+        SealChecksums(inodeId);
+        backupCopies.Complete(inodeId, primaryNodeId);
+    }
+    return 0;
+}
+
+int CuckooStore::DropBackupForBrpc(uint64_t inodeId, int primaryNodeId)
+{
+    FileLocker locker(&replicaLock, inodeId, LockMode::X, true);
+    /* a promoted copy is served by this node now */
+    if (backupCopies.Accepts(inodeId, primaryNodeId)) {
+        backupCopies.Erase(inodeId);
+        DiskCache::GetInstance().DeleteOldCacheWithNoPin(inodeId);
+    }
+    return 0;
+}
+
+bool CuckooStore::FailoverToBackup(OpenInstance *openInstance, int failedNodeId)
+{
+    /* writers keep their data in the primary until flushed, only reads move */
+    if (replicationMode == ReplicationMode::NONE || openInstance->isRemoteCall ||
+        (openInstance->oflags & O_ACCMODE) != O_RDONLY) {
+        return false;
+    }
+    std::unique_lock<std::shared_mutex> nodeLock(openInstance->nodeMutex);
+    if (openInstance->nodeId != failedNodeId) {
+        return true;
+    }
+    if (openInstance->nodeFail) {
+        /* moved once already, and failed again */
+        return false;
+    }
+    uint64_t inodeId = openInstance->inodeId;
+    int backupNodeId = StoreNode::GetInstance()->GetBackupNode(failedNodeId, inodeId);
+    if (backupNodeId < 0) {
+        return false;
+    }
+
+    uint64_t physicalFd = UINT64_MAX;
+    std::shared_ptr<CuckooIOClient> cuckooIOClient = nullptr;
+    int ret = -ENOENT;
+    if (StoreNode::GetInstance()->IsLocal(backupNodeId)) {
+        if (KeepOnFailover(inodeId) && DiskCache::GetInstance().Find(inodeId, true)) {
+            std::string fileName = GetFilePath(inodeId);
+            int localFd = open(fileName.c_str(), O_RDONLY);
+            if (localFd < 0) {
+                ret = -errno;
+                DiskCache::GetInstance().Unpin(inodeId);
+            } else {
+                physicalFd = static_cast<uint64_t>(localFd);
+                ret = 0;
+            }
+        }
+    } else {
+        cuckooIOClient = StoreNode::GetInstance()->GetRpcConnection(backupNodeId);
+        ret = cuckooIOClient == nullptr ? -EHOSTUNREACH
+                                        : cuckooIOClient->OpenFile(inodeId,
+                                                                   O_RDONLY,
+                                                                   physicalFd,
+                                                                   openInstance->originalSize,
+                                                                   openInstance->path,
+                                                                   true);
+    }
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "FailoverToBackup(): " << openInstance->path << " unavailable on backup node "
+                              << backupNodeId << ": " << strerror(std::abs(ret));
+        return false;
+    }
+    CUCKOO_LOG(LOG_WARNING) << "FailoverToBackup(): node " << failedNodeId << " failed, read " << openInstance->path
+                            << " from node " << backupNodeId;
+    openInstance->nodeId = backupNodeId;
+    openInstance->physicalFd = physicalFd;
+    openInstance->nodeFail = true;
+    openInstance->writeStream.Rebind(physicalFd, cuckooIOClient);
+    return true;
+}
+
+void CuckooStore::OnNodesGone(const std::vector<int> &nodeIds)
+{
+    std::vector<uint64_t> inodeIds;
+    for (int nodeId : nodeIds) {
+        /* this node serves what the gone node was primary of, and backs it up in turn */
+        for (uint64_t inodeId : backupCopies.Promote(nodeId)) {
+            replicationLog.MarkFull(inodeId);
+            inodeIds.push_back(inodeId);
+        }
+    }
+    /* the backups on the gone nodes, and those moved as the nodes left the ring */
+    int localNodeId = StoreNode::GetInstance()->GetNodeId();
+    auto backupOf = [localNodeId](uint64_t inodeId) {
+        return StoreNode::GetInstance()->GetBackupNode(localNodeId, inodeId);
+    };
+    for (uint64_t inodeId : replicationLog.TakeMoved(backupOf)) {
+        inodeIds.push_back(inodeId);
+    }
+    CUCKOO_LOG(LOG_WARNING) << "OnNodesGone(): " << nodeIds.size() << " nodes gone, " << inodeIds.size()
+                            << " files to back up again";
+
+    std::lock_guard<std::mutex> lock(reReplicateMutex);
+    reReplicateQueue.insert(reReplicateQueue.end(), inodeIds.begin(), inodeIds.end());
+    reReplicateCv.notify_one();
+}
+
+void CuckooStore::ReReplicate(std::stop_token stoken)
+{
+    while (!stoken.stop_requested()) {
+        uint64_t inodeId = 0;
+        {
+            std::unique_lock<std::mutex> lock(reReplicateMutex);
+            if (!reReplicateCv.wait(lock, stoken, [this]() { return !reReplicateQueue.empty(); })) {
+                return;
+            }
+            inodeId = reReplicateQueue.front();
+            reReplicateQueue.pop_front();
+        }
+        SyncBackup(inodeId);
+    }
+}
+
+/* -------------- preload ------------------- */
+
+int CuckooStore::PreloadFile(uint64_t inodeId, int nodeId, std::string &path, uint64_t size, uint32_t ttlSec)
+{
+    nodeId = OwnerNodeId(inodeId, nodeId, path);
+    if (StoreNode::GetInstance()->IsLocal(nodeId)) {
+        return PreloadLocalFile(inodeId, path, size, ttlSec);
+    }
+    std::shared_ptr<CuckooIOClient> cuckooIOClient = StoreNode::GetInstance()->GetRpcConnection(nodeId);
+    if (cuckooIOClient == nullptr) {
+        return -EHOSTUNREACH;
+    }
+    return cuckooIOClient->PreloadFile(inodeId, path, size, ttlSec);
+}
+
+int CuckooStore::PreloadLocalFile(uint64_t inodeId, const std::string &path, uint64_t size, uint32_t ttlSec)
+{
+    /* either way the file is left pinned once */
+    if (!persistToStorage) {
+        if (!DiskCache::GetInstance().Find(inodeId, true)) {
+            return -ENOENT;
+        }
+    } else {
+        int ret = DownLoadFromStorageForBrpc(inodeId, path, nullptr, size, true, false);
+        if (ret != 0) {
+            CUCKOO_LOG(LOG_ERROR) << "PreloadLocalFile(): Loading " << path << " failed: " << strerror(-ret);
+            return ret;
+        }
+    }
+    if (!compressRules.Empty()) {
+        frozenFiles.Mark(inodeId, compressRules.Match(path));
+    }
+    /* a file preloaded before keeps its pin with a later deadline */
+    if (ttlSec == 0 || !preloadPins.Pin(inodeId, NowMs() + ttlSec * 1000ULL)) {
+        DiskCache::GetInstance().Unpin(inodeId);
+    }
+    return 0;
+}
+
+void CuckooStore::SweepPreloadPins(std::stop_token stoken)
+{
+    std::mutex sleepMutex;
+    std::condition_variable_any sleepCv;
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    while (!stoken.stop_requested()) {
+        sleepCv.wait_for(lock, stoken, std::chrono::milliseconds(PRELOAD_SWEEP_INTERVAL_MS), []() { return false; });
+        for (uint64_t inodeId : preloadPins.TakeExpired(NowMs())) {
+            DiskCache::GetInstance().Unpin(inodeId);
+        }
+    }
+}
+
+/*---------------------- compression ----------------------*/
+
+int CuckooStore::OpenCacheFile(uint64_t inodeId, int oflags, std::shared_ptr<const CompressedIndex> &index)
+{
+    std::string fileName = GetFilePath(inodeId);
+    /* compressed or decompressed between the two opens, it is at the other name now */
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        int fd = open(fileName.c_str(), oflags, 0755);
+        if (fd >= 0 || errno != ENOENT || (oflags & O_ACCMODE) != O_RDONLY) {
+            return fd >= 0 ? fd : -errno;
+        }
+        fd = open((fileName + COMPRESS_SUFFIX).c_str(), O_RDONLY);
+        if (fd < 0 && errno == ENOENT) {
+            continue;
+        }
+        if (fd < 0) {
+            return -errno;
+        }
+        auto loaded = std::make_shared<CompressedIndex>();
+        int ret = LoadCompressedIndex(fd, *loaded);
+        if (ret != 0) {
+            close(fd);
+            CUCKOO_LOG(LOG_ERROR) << "OpenCacheFile(): compressed cache file of inode " << inodeId << " is damaged";
+            frozenFiles.SetDamaged(inodeId);
+            return -EIO;
+        }
+        index = std::move(loaded);
+        return fd;
+    }
+    return -ENOENT;
+}
+
+int CuckooStore::ThawCacheFile(uint64_t inodeId)
+{
+    FileLocker locker(&thawLock, inodeId, LockMode::X, true);
+    std::string fileName = GetFilePath(inodeId);
+    if (access(fileName.c_str(), F_OK) == 0) {
+        return 0;
+    }
+    std::string frozenName = fileName + COMPRESS_SUFFIX;
+    int fd = open(frozenName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        /* neither is there, the open after tells */
+        return errno == ENOENT ? 0 : -errno;
+    }
+    CompressedIndex index;
+    int ret = LoadCompressedIndex(fd, index);
+    std::string tmpName = fileName + COMPRESS_TMP_SUFFIX;
+    bool allocated = ret == 0 && DiskCache::GetInstance().PreAllocSpace(index.rawSize);
+    if (ret == 0 && !allocated) {
+        ret = -ENOSPC;
+    }
+    if (ret == 0) {
+        ret = DecompressFile(fd, index, tmpName);
+    }
+    close(fd);
+    if (ret == 0 && rename(tmpName.c_str(), fileName.c_str()) != 0) {
+        ret = -errno;
+        unlink(tmpName.c_str());
+    }
+    if (ret != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "ThawCacheFile(): decompress " << frozenName << " failed: " << strerror(-ret);
+        if (ret == -EBADMSG || ret == -EIO) {
+            frozenFiles.SetDamaged(inodeId);
+            ret = -EIO;
+        }
+    } else {
+        unlink(frozenName.c_str());
+        DiskCache::GetInstance().InsertAndUpdate(inodeId, index.rawSize, false);
+        SealChecksums(inodeId);
+    }
+    if (allocated) {
+        DiskCache::GetInstance().FreePreAllocSpace(index.rawSize);
+    }
+    return ret;
+}
+
+int CuckooStore::FreezeCacheFile(uint64_t inodeId, CompressCodec codec)
+{
+    std::string fileName = GetFilePath(inodeId);
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return -errno;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        return -err;
+    }
+    /* small files are read whole from the plain file when opened */
+    uint64_t rawSize = st.st_size;
+    if (rawSize < std::max<uint64_t>(READ_BIGFILE_SIZE, COMPRESS_BLOCK_SIZE)) {
+        close(fd);
+        return -ECANCELED;
+    }
+    std::string tmpName = fileName + COMPRESS_TMP_SUFFIX;
+    uint64_t compressedSize = 0;
+    int ret = CompressFile(fd, tmpName, codec, compressedSize);
+    close(fd);
+    if (ret != 0) {
+        return ret;
+    }
+    if (compressedSize * 100 > rawSize * COMPRESS_MAX_RATIO_PERCENT) {
+        unlink(tmpName.c_str());
+        return -ECANCELED;
+    }
+    /* an open pins the file first, so none sees it half swapped, and a write before changed its mtime */
+    std::string frozenName = fileName + COMPRESS_SUFFIX;
+    bool replaced = DiskCache::GetInstance().Replace(inodeId, compressedSize, [&]() {
+        struct stat now;
+        if (stat(fileName.c_str(), &now) != 0 || now.st_ino != st.st_ino || now.st_size != st.st_size ||
+            now.st_mtim.tv_sec != st.st_mtim.tv_sec || now.st_mtim.tv_nsec != st.st_mtim.tv_nsec) {
+            return false;
+        }
+        return rename(tmpName.c_str(), frozenName.c_str()) == 0 && unlink(fileName.c_str()) == 0;
+    });
+    if (!replaced) {
+        unlink(tmpName.c_str());
+        return -EBUSY;
+    }
+    /* the blocks carry their own crcs */
+    ChecksumTable::GetInstance().Remove(inodeId);
+    frozenFiles.AddFrozen(rawSize, compressedSize);
+    CUCKOO_LOG(LOG_INFO) << "FreezeCacheFile(): compressed " << fileName << " from " << rawSize << " to "
+                         << compressedSize << " bytes";
+    return 0;
+}
+
+void CuckooStore::SweepColdFiles(std::stop_token stoken)
+{
+    std::mutex sleepMutex;
+    std::condition_variable_any sleepCv;
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    while (!stoken.stop_requested()) {
+        sleepCv.wait_for(lock, stoken, std::chrono::milliseconds(COMPRESS_SWEEP_INTERVAL_MS), []() { return false; });
+        for (auto [inodeId, codec] : frozenFiles.Candidates()) {
+            if (stoken.stop_requested()) {
+                break;
+            }
+            /* copies of files of other nodes are written in place by their primaries, they stay plain */
+            int ret = -ECANCELED;
+            if (!replicaCopies.Contains(inodeId) && !backupCopies.Contains(inodeId)) {
+                ret = DiskCache::GetInstance().Idle(inodeId, compressIdleSec);
+            }
+            if (ret == 0) {
+                ret = FreezeCacheFile(inodeId, codec);
+            }
+            if (ret == -EBUSY || ret == -EAGAIN) {
+                /* in use, tried again once cold */
+                continue;
+            }
+            if (ret != 0 && ret != -ECANCELED && ret != -ENOENT) {
+                CUCKOO_LOG(LOG_WARNING) << "SweepColdFiles(): compress cache file of inode " << inodeId
+                                        << " failed: " << strerror(-ret);
+            }
+            /* compressed, not worth it or gone */
+            frozenFiles.Forget(inodeId);
+        }
+    }
+}
@@ -15,11 +15,26 @@
 #include <sys/time.h>
 
 #include "log/logging.h"
+#include "util/block_compress.h"
+#include "util/checksum.h"
 #include "util/utils.h"
 
 std::vector<CacheItem> DiskCache::initCacheVector;
 std::mutex DiskCache::initCacheMutex;
 
+/* remove the cache file of key, plain or compressed, 0 if one of them was there */
+static int RemoveCacheFile(uint64_t key)
+{
+    std::string fileName = GetFilePath(key);
+    int ret = remove(fileName.c_str());
+    int err = errno;
+    if (remove((fileName + COMPRESS_SUFFIX).c_str()) == 0) {
+        return 0;
+    }
+    errno = err;
+    return ret;
+}
+
 DiskCache::DiskCache(float ratio) { freeRatio = ratio; }
 
 DiskCache::~DiskCache()
@@ -99,6 +114,15 @@ int DiskCache::Walk(std::string dirPath)
         if (strcmp(f->d_name, ".") == 0 || strcmp(f->d_name, "..") == 0) {
             continue;
         }
+        /* the checksums of a cache file, not a file of its own */
+        if (strstr(f->d_name, CHECKSUM_SUFFIX) != nullptr) {
+            continue;
+        }
+        /* a compressed or decompressed copy left half written */
+        if (strstr(f->d_name, COMPRESS_TMP_SUFFIX) != nullptr) {
+            unlink((dirPath + "/" + f->d_name).c_str());
+            continue;
+        }
         struct stat st;
         errno_t err = memset_s(&st, sizeof(st), 0, sizeof(st));
         if (err != 0) {
@@ -200,8 +224,9 @@ void DiskCache::CleanupForEvict(uint64_t preAllocSize)
         uint64_t key = it->inode;
         uint64_t size = it->size;
         std::string fileName = GetFilePath(key);
-        int ret = remove(fileName.c_str());
+        int ret = RemoveCacheFile(key);
         if (ret == 0) {
+            ChecksumTable::GetInstance().Remove(key);
             freedCap += size;
             freedInode++;
             it = cacheItems.erase(it);
@@ -255,8 +280,9 @@ void DiskCache::Cleanup()
         uint64_t key = it->inode;
         uint64_t size = it->size;
         std::string fileName = GetFilePath(key);
-        int ret = remove(fileName.c_str());
+        int ret = RemoveCacheFile(key);
         if (ret == 0) {
+            ChecksumTable::GetInstance().Remove(key);
             freedCap += size;
             freedInode++;
             it = cacheItems.erase(it);
@@ -280,7 +306,10 @@ int DiskCache::Delete(uint64_t key)
 {
     if (stop) {
         std::string fileName = GetFilePath(key);
-        int ret = remove(fileName.c_str());
+        int ret = RemoveCacheFile(key);
+        if (ret == 0) {
+            ChecksumTable::GetInstance().Remove(key);
+        }
         return ret;
     }
     std::lock_guard<std::mutex> lock(mutex);
@@ -289,12 +318,13 @@ int DiskCache::Delete(uint64_t key)
         auto elem = inodeToCacheIter[key];
         uint64_t size = elem->size;
         std::string fileName = GetFilePath(key);
-        ret = remove(fileName.c_str());
+        ret = RemoveCacheFile(key);
         if (ret != 0) {
             int err = errno;
             CUCKOO_LOG(LOG_ERROR) << "Delete file: " << fileName << " failed: " << strerror(err);
             return -err;
         }
+        ChecksumTable::GetInstance().Remove(key);
         cacheItems.erase(elem);
         inodeToCacheIter.erase(key);
         usedCap -= size;
@@ -338,11 +368,55 @@ bool DiskCache::Find(uint64_t key, bool needPin)
         if (needPin) {
             Pin(key);
         }
+        hitNum.fetch_add(1, std::memory_order_relaxed);
         return true;
     }
+    missNum.fetch_add(1, std::memory_order_relaxed);
     return false;
 }
 
+int DiskCache::Idle(uint64_t key, uint64_t idleSec)
+{
+    if (stop) {
+        return -EBUSY;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = inodeToCacheIter.find(key);
+    if (it == inodeToCacheIter.end()) {
+        return -ENOENT;
+    }
+    uint64_t now = static_cast<uint64_t>(time(nullptr));
+    return it->second->refs == 0 && it->second->atime + idleSec <= now ? 0 : -EBUSY;
+}
+
+bool DiskCache::Replace(uint64_t key, uint64_t size, const std::function<bool()> &swap)
+{
+    if (stop) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = inodeToCacheIter.find(key);
+    if (it == inodeToCacheIter.end() || it->second->refs > 0 || !swap()) {
+        return false;
+    }
+    usedCap += static_cast<int64_t>(size - it->second->size);
+    freeCap -= static_cast<int64_t>(size - it->second->size);
+    it->second->size = size;
+    return true;
+}
+
+uint64_t DiskCache::GetUsedCap()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return usedCap;
+}
+
+uint64_t DiskCache::GetItemNum()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return inodeToCacheIter.size();
+}
+
 void DiskCache::DeleteOldCacheWithNoPin(uint64_t key)
 {
     std::lock_guard<std::mutex> lock(mutex);
@@ -352,12 +426,13 @@ void DiskCache::DeleteOldCacheWithNoPin(uint64_t key)
             auto elem = inodeToCacheIter[key];
             uint64_t size = elem->size;
             std::string fileName = GetFilePath(key);
-            ret = remove(fileName.c_str());
+            ret = RemoveCacheFile(key);
             if (ret != 0) {
                 int err = errno;
                 CUCKOO_LOG(LOG_ERROR) << "DeleteOldCacheWithNoPin file: " << fileName << " failed: " << strerror(err);
                 return;
             }
+            ChecksumTable::GetInstance().Remove(key);
             cacheItems.erase(elem);
             inodeToCacheIter.erase(key);
             usedCap -= size;
@@ -65,12 +65,56 @@ class RemoteIOServiceImpl : public RemoteIOService {
                       ErrorCodeOnlyReply *response,
                       google::protobuf::Closure *done) override;
 
+    void LockFile(google::protobuf::RpcController *cntl_base,
+                  const LockFileRequest *request,
+                  LockFileReply *response,
+                  google::protobuf::Closure *done) override;
+
+    void DropReplica(google::protobuf::RpcController *cntl_base,
+                     const DropReplicaRequest *request,
+                     ErrorCodeOnlyReply *response,
+                     google::protobuf::Closure *done) override;
+
+    void ReplicateFile(google::protobuf::RpcController *cntl_base,
+                       const ReplicateFileRequest *request,
+                       ErrorCodeOnlyReply *response,
+                       google::protobuf::Closure *done) override;
+
+    void PreloadFile(google::protobuf::RpcController *cntl_base,
+                     const PreloadFileRequest *request,
+                     ErrorCodeOnlyReply *response,
+                     google::protobuf::Closure *done) override;
+
     void CheckConnection(google::protobuf::RpcController *cntl_base,
                          const CheckConnectionRequest *request,
                          ErrorCodeOnlyReply *response,
                          google::protobuf::Closure *done) override;
 };
 
+/* renders CuckooMetrics in Prometheus text format over http, mapped to /metrics */
+class MetricsServiceImpl : public MetricsService {
+  public:
+    MetricsServiceImpl() = default;
+    ~MetricsServiceImpl() override = default;
+
+    void Metrics(google::protobuf::RpcController *cntl_base,
+                 const MetricsRequest *request,
+                 MetricsReply *response,
+                 google::protobuf::Closure *done) override;
+};
+
+/* dumps the spans of sampled requests as Chrome trace json over http, mapped to /trace */
+class TraceServiceImpl : public TraceService {
+  public:
+    TraceServiceImpl() = default;
+    ~TraceServiceImpl() override = default;
+
+    void Trace(google::protobuf::RpcController *cntl_base,
+               const TraceRequest *request,
+               TraceReply *response,
+               google::protobuf::Closure *done) override;
+};
+
 class RemoteIOServer {
   public:
     bool isStarted;
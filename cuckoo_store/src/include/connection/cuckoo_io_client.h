@@ -4,15 +4,24 @@
 
 #pragma once
 
+#include <fcntl.h>
 #include <securec.h>
+#include <functional>
 #include <memory>
 #include <string>
 
 #include <brpc/channel.h>
 
 #include "brpc_io.pb.h"
+#include "util/file_lock.h"
+#include "util/hot_file.h"
 #include "util/utils.h"
 
+/* a preload waits for the whole file to come from storage */
+#define PRELOAD_RPC_TIMEOUT_MS 600000
+/* data found damaged on the way between nodes is sent once more */
+#define CHECKSUM_RPC_ATTEMPTS 2
+
 class CuckooIOClient {
   public:
     CuckooIOClient()
@@ -39,17 +48,52 @@ class CuckooIOClient {
                  uint64_t &physicalFd,
                  uint64_t originalSize,
                  const std::string &path,
-                 bool nodeFail);
+                 bool nodeFail,
+                 HotFileReplicas *replicas = nullptr);
+    /* open the copy on this node of a hot file of primaryNodeId, pulled from it unless of version */
+    int OpenReplicaFile(uint64_t inodeId,
+                        uint64_t &physicalFd,
+                        uint64_t originalSize,
+                        const std::string &path,
+                        int primaryNodeId,
+                        uint64_t version);
     int WriteFile(uint64_t physicalFd, const char *writeBuffer, uint64_t size, off_t offset);
+    /* returns at once and calls done with what WriteFile would return, writeBuffer must live until then */
+    void WriteFileAsync(uint64_t physicalFd,
+                        const char *writeBuffer,
+                        uint64_t size,
+                        off_t offset,
+                        std::function<void(int)> done);
     ssize_t
     ReadSmallFile(uint64_t inodeId, ssize_t size, std::string &path, char *readBuffer, int oflags, bool nodeFail);
     int DeleteFile(uint64_t inodeId, int nodeId, std::string &path);
     int StatFS(std::string &path, struct StatFSBuf *fsBuf);
     int TruncateOpenInstance(uint64_t physicalFd, off_t size);
     int TruncateFile(uint64_t physicalFd, off_t size);
+    int
+    LockFile(uint64_t inodeId, int cmd, struct flock *lockInfo, uint64_t owner, int ownerNodeId, RangeLockType type);
     int CheckConnection();
+    int DropReplica(uint64_t inodeId, uint64_t version);
+    /* ship [offset, offset + size) of the file to its backup, reset starts a whole copy, last sets the size */
+    int ReplicateFile(uint64_t inodeId,
+                      int primaryNodeId,
+                      const char *buf,
+                      size_t size,
+                      off_t offset,
+                      uint64_t fileSize,
+                      bool reset,
+                      bool last);
+    int DropBackup(uint64_t inodeId, int primaryNodeId);
+    /* load the file into the cache of the node, pinned for ttlSec if not 0 */
+    int PreloadFile(uint64_t inodeId, const std::string &path, uint64_t size, uint32_t ttlSec);
 
   private:
+    /* -EBADMSG if the data does not match the crc sent along */
+    int Read(cuckoo::brpc_io::ReadRequest &request, char *readBuffer, int bufferSize);
+    ssize_t ReadSmall(cuckoo::brpc_io::ReadSmallFileRequest &request, char *readBuffer, ssize_t size);
+    int Open(cuckoo::brpc_io::OpenRequest &request, uint64_t &physicalFd, HotFileReplicas *replicas);
+    int Replicate(cuckoo::brpc_io::ReplicateFileRequest &request, const char *buf, size_t size);
+
     std::shared_ptr<brpc::Channel> channel;
     std::unique_ptr<cuckoo::brpc_io::RemoteIOService_Stub> stub;
 };
@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <shared_mutex>
 #include <unordered_map>
@@ -17,6 +18,7 @@ class StoreNode {
     int initStatus = 0;
     int nodeId;
     std::unordered_map<int, std::pair<std::string, std::shared_ptr<CuckooIOClient>>> nodeMap;
+    std::function<void(const std::vector<int> &)> nodeGoneHandler;
 
   public:
     void SetNodeConfig(int initNodeId, std::string &clusterView);
@@ -36,6 +38,12 @@ class StoreNode {
     int GetNumberofAllNodes();
     int AllocNode(uint64_t inodeId);
     int GetNextNode(int nodeId, uint64_t inodeId);
+    /* up to num other nodes following primaryNodeId, where copies of its hot files go */
+    std::vector<int> GetReplicaNodes(int primaryNodeId, int num);
+    /* the node the file of primaryNodeId is backed up on, which AllocNode picks once the primary is gone */
+    int GetBackupNode(int primaryNodeId, uint64_t inodeId);
+    /* called with the nodes zookeeper stops listing */
+    void SetNodeGoneHandler(std::function<void(const std::vector<int> &)> handler);
     void DeleteNode(int nodeId);
     std::vector<int> GetAllNodeId();
     int UpdateNodeConfig();
@@ -7,7 +7,10 @@
 #include <fcntl.h>
 #include <securec.h>
 #include <atomic>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -20,7 +23,17 @@
 #include "buffer/open_instance.h"
 #include "storage/storage.h"
 #include "thread_pool/thread_pool.h"
+#include "util/block_compress.h"
 #include "util/file_lock.h"
+#include "util/hot_file.h"
+#include "util/preload.h"
+#include "util/replication.h"
+
+#define LOCK_POLL_MAX_INTERVAL_MS 100
+/* the tail of a compressed object read first, it holds the index of up to 256 MiB of data */
+#define STORAGE_COMPRESS_TAIL_SIZE (64 * 1024)
+/* the data of a compressed object read from storage at once */
+#define STORAGE_COMPRESS_BATCH_SIZE (4 * 1024 * 1024)
 
 class CuckooStore {
   public:
@@ -31,6 +44,7 @@ class CuckooStore {
     /*-----------------read-----------------*/
     int ReadFile(OpenInstance *openInstance, char *buffer, size_t size, off_t offset);
     ssize_t ReadFileLR(char *readBuffer, off_t offset, OpenInstance *openInstance, size_t readBufferSize);
+    int GetLocalReadFd(OpenInstance *openInstance, size_t size, off_t offset, int &localFd, size_t &readSize);
     int ReadSmallFiles(OpenInstance *openInstance);
     int
     ReadSmallFilesForBrpc(uint64_t inodeId, const std::string &path, char *buf, size_t size, int oflags, bool nodeFail);
@@ -54,6 +68,51 @@ class CuckooStore {
     int TruncateOpenInstance(OpenInstance *openInstance, off_t size);
     int TruncateFileForBrpc(uint64_t inodeId, off_t size);
 
+    /*-----------------lock-----------------*/
+    /*
+     * fcntl(cmd) on the node keeping the locks of inodeId, F_GETLK fills lockInfo with the conflict or F_UNLCK.
+     * F_SETLKW gives up with -EINTR once interrupted returns true
+     */
+    int LockFile(uint64_t inodeId,
+                 int cmd,
+                 struct flock *lockInfo,
+                 uint64_t owner,
+                 RangeLockType type,
+                 const std::function<bool()> &interrupted = nullptr);
+    /* the same on this node for an owner from ownerNodeId */
+    int LockLocalFile(uint64_t inodeId,
+                      int cmd,
+                      struct flock *lockInfo,
+                      uint64_t owner,
+                      int ownerNodeId,
+                      RangeLockType type,
+                      const std::function<bool()> &interrupted = nullptr);
+
+    /*-----------------replica-----------------*/
+    /* open the copy on this node of a hot file of primaryNodeId, pulled from it unless of version */
+    int OpenReplica(OpenInstance *openInstance, int primaryNodeId, uint64_t version);
+    HotFileReplicas GetHotFileReplicas(uint64_t inodeId);
+    int DropReplicaForBrpc(uint64_t inodeId, uint64_t version);
+    /* the node a read only open on this node of a hot file is sent to, primaryNodeId to stay there */
+    int ReplicaNodeFor(uint64_t inodeId, int primaryNodeId, const std::vector<int> &replicaNodeIds);
+
+    /*-----------------backup-----------------*/
+    /* write what the primary shipped to the backup copy on this node, -ESTALE if it needs a whole copy first */
+    int ReplicateFileForBrpc(uint64_t inodeId,
+                             int primaryNodeId,
+                             butil::IOBuf &buf,
+                             off_t offset,
+                             uint64_t fileSize,
+                             bool reset,
+                             bool last);
+    int DropBackupForBrpc(uint64_t inodeId, int primaryNodeId);
+
+    /*-----------------preload-----------------*/
+    /* load a file from storage into the cache of the node owning it, pinned there for ttlSec if not 0 */
+    int PreloadFile(uint64_t inodeId, int nodeId, std::string &path, uint64_t size, uint32_t ttlSec);
+    /* the same for a file owned by this node */
+    int PreloadLocalFile(uint64_t inodeId, const std::string &path, uint64_t size, uint32_t ttlSec);
+
     /*-----------------util-----------------*/
     int GetInitStatus();
     int InitStore();
@@ -70,11 +129,59 @@ class CuckooStore {
     /*-----------------func-----------------*/
     int OpenFileFromRemote(OpenInstance *openInstance, bool largeFile);
 
+    /*-----------------replica-----------------*/
+    int FillReplica(OpenInstance *openInstance, int primaryNodeId, uint64_t version);
+    void ReplicateHotFile(uint64_t inodeId);
+    void DropReplicas(uint64_t inodeId, const HotFileReplicas &replicas);
+    /* move a read only open of a hot file from its primary to one of the replicas, stay on failure */
+    void SpreadToReplica(OpenInstance *openInstance,
+                         std::shared_ptr<CuckooIOClient> &cuckooIOClient,
+                         const HotFileReplicas &replicas);
+
+    /*-----------------backup-----------------*/
+    /* ship the changes of a file this node is primary of to its backup */
+    int SyncBackup(uint64_t inodeId);
+    int ShipToBackup(uint64_t inodeId, int backupNodeId, const BackupWork &work);
+    /* after a flush, ship the changes at once or in the background by replicationMode */
+    void BackupFile(uint64_t inodeId);
+    void DropBackup(uint64_t inodeId);
+    /* move a read only open off a failed node to the backup, true if moved here or by another reader */
+    bool FailoverToBackup(OpenInstance *openInstance, int failedNodeId);
+    /* true if the cached copy was kept current by its primary, so it survives a failover */
+    bool KeepOnFailover(uint64_t inodeId);
+    void OnNodesGone(const std::vector<int> &nodeIds);
+    /* gives the files of gone nodes new backups, one at a time */
+    void ReReplicate(std::stop_token stoken);
+
+    /*-----------------preload-----------------*/
+    /* unpins the preloaded files whose ttl passed */
+    void SweepPreloadPins(std::stop_token stoken);
+
+    /*-----------------compression-----------------*/
+    /* open the cache file of inodeId, plain or compressed to read only, index is set if compressed */
+    int OpenCacheFile(uint64_t inodeId, int oflags, std::shared_ptr<const CompressedIndex> &index);
+    /* decompress the cache file of inodeId back in place before it is written, the caller holds a pin */
+    int ThawCacheFile(uint64_t inodeId);
+    /* compress the cache file of inodeId if it is unpinned, -EBUSY if it was used meanwhile */
+    int FreezeCacheFile(uint64_t inodeId, CompressCodec codec);
+    /* compresses the cache files under the configured prefixes once they are cold */
+    void SweepColdFiles(std::stop_token stoken);
+
     /*-----------------util-----------------*/
     int PathToNodeId(std::string &path);
+    /* the node a file is placed on, nodeId if it has one already */
+    int OwnerNodeId(uint64_t inodeId, int nodeId, std::string &path);
     void AllocNodeId(OpenInstance *openInstance);
     bool ConnectionError(int err);
     bool IoError(int err);
+    /* keep checksums of a cache file just completed, reads of a file without them are not checked */
+    void SealChecksums(uint64_t inodeId);
+    /* the same in the background, changes of the file until it runs are sealed together */
+    void SealChecksumsAsync(uint64_t inodeId);
+    /* true if the cache file was found damaged, it is dropped to be loaded from storage again */
+    bool RefetchDamaged(uint64_t inodeId);
+    void RegisterMetrics();
+    void UnregisterMetrics();
 
     /*-----------------storage-----------------*/
     int DownLoadFromStorage(OpenInstance *openInstance, bool isSync, bool toBuffer = false);
@@ -86,6 +193,16 @@ class CuckooStore {
                                    bool isSync,
                                    bool toBuffer);
     int FlushToStorage(std::string path, uint64_t inodeId);
+    /* put the cache file of inodeId compressed by codec, not 0 if it is to be put plain instead */
+    int FlushCompressed(const std::string &object, uint64_t inodeId, CompressCodec codec);
+    /* read the object of path as storage->ReadObject does, objects flushed compressed are decompressed */
+    ssize_t ReadStorage(const std::string &path, uint64_t offset, uint64_t size, int fd, char *buf);
+    ssize_t ReadCompressedObject(const std::string &object,
+                                 uint64_t objectSize,
+                                 uint64_t offset,
+                                 uint64_t size,
+                                 int fd,
+                                 char *buf);
     int StatFsStorage(struct statvfs *vfsbuf);
 
   private:
@@ -98,12 +215,36 @@ class CuckooStore {
     bool isInference = true;
     bool toLocal = false;
     FileLock fileLock;
+    HotFileTracker hotFiles;
+    ReplicaCopies replicaCopies;
+    /* serializes filling and dropping copies of hot files and backups, reads of the copies do not take it */
+    FileLock replicaLock;
+    int hotFileReplicaNum = 0;
+    ReplicationMode replicationMode = ReplicationMode::NONE;
+    ReplicationLog replicationLog;
+    BackupCopies backupCopies;
+    /* serializes shipping the changes of a file to its backup */
+    FileLock backupLock;
     std::unordered_map<std::string, std::atomic<uint64_t>> nodeHash;
     std::mutex mutex;
     std::string dataPath;
     std::unique_ptr<ThreadPool> storeThreadPool;
-    Storage *storage;
+    Storage *storage = nullptr;
     std::jthread statsThread;
+    std::mutex reReplicateMutex;
+    std::condition_variable_any reReplicateCv;
+    std::deque<uint64_t> reReplicateQueue;
+    std::jthread reReplicateThread;
+    PreloadPins preloadPins;
+    std::jthread preloadThread;
+    CompressRules compressRules;
+    /* the codec objects under each prefix are flushed with */
+    CompressRules storageCompressRules;
+    FrozenFiles frozenFiles;
+    uint64_t compressIdleSec = 0;
+    /* serializes decompressing a cache file */
+    FileLock thawLock;
+    std::jthread compressThread;
 };
 
 std::string GetParentPath(const std::string &path, int level = -1);
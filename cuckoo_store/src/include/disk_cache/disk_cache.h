@@ -7,6 +7,7 @@
 #include <dirent.h>
 #include <securec.h>
 #include <atomic>
+#include <functional>
 #include <list>
 #include <mutex>
 #include <string>
@@ -53,6 +54,15 @@ class DiskCache {
     bool PreAllocSpace(uint64_t size);
     void FreePreAllocSpace(uint64_t size);
     bool HasFreeSpace();
+    /* 0 if key is unpinned and not used for idleSec, -EBUSY if it is, -ENOENT if it is not cached */
+    int Idle(uint64_t key, uint64_t idleSec);
+    /* swap the file of unpinned key for one of size, false if key is pinned or swap fails */
+    bool Replace(uint64_t key, uint64_t size, const std::function<bool()> &swap);
+    uint64_t GetTotalCap() { return totalCap; }
+    uint64_t GetUsedCap();
+    uint64_t GetItemNum();
+    uint64_t GetHitNum() { return hitNum.load(std::memory_order_relaxed); }
+    uint64_t GetMissNum() { return missNum.load(std::memory_order_relaxed); }
 
   private:
     uint64_t totalCap{0};
@@ -81,6 +91,8 @@ class DiskCache {
     int totalDirNum{101};
 
     std::atomic<uint64_t> reservedCap{0};
+    std::atomic<uint64_t> hitNum{0};
+    std::atomic<uint64_t> missNum{0};
     std::mutex allocMutex;
 
     static std::mutex initCacheMutex;
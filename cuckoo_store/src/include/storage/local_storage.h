@@ -0,0 +1,42 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <string>
+
+#include "storage.h"
+
+/*
+ * Stand-in for OBS that keeps every object as a file under a local directory, selected with
+ * cuckoo_storage_type "local". Meant for benchmarks and tests without an object store.
+ */
+class LocalStorage : public Storage {
+  private:
+    std::atomic<bool> isInit{false};
+    std::string rootPath;
+    LocalStorage() = default;
+
+    std::string ObjectPath(const std::string &objectKey) { return rootPath + "/" + objectKey; }
+    /* objects are written to a temporary file and renamed, so readers never see a partial object */
+    int CreateTmpObject(const std::string &objectKey, std::string &tmpPath);
+    int PublishObject(const std::string &objectKey, const std::string &tmpPath, int fd, bool ok);
+
+  public:
+    ~LocalStorage() noexcept override = default;
+
+    static LocalStorage *GetInstance();
+    void DeleteInstance() override;
+    int Init() override;
+
+    ssize_t ReadObject(const std::string &objectKey, uint64_t offset, uint64_t size, int fd, char *destBuffer) override;
+    int PutFile(const std::string &objectKey, const std::string &filePath, const std::string &codec) override;
+    int HeadObject(const std::string &objectKey, uint64_t &size, std::string &codec) override;
+    ssize_t
+    PutBuffer(const std::string &objectKey, const char *buf, const uint64_t size, const uint64_t offset) override;
+    int DeleteObject(const std::string &objectKey) override;
+    int CopyObject(const std::string &fromPath, const std::string &toPath) override;
+    int StatFs(struct statvfs *vfsbuf) override;
+};
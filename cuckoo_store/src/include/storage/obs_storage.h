@@ -37,7 +37,10 @@ class OBSStorage : public Storage {
     bool IsNeedRetry(obs_status status);
     void DoRetry(obs_status status, int &retry);
     obs_status ObsUploadFile(const std::string &objectKey, const std::string &filePath, uint64_t contentLen);
-    obs_status ObsPutObject(const std::string &objectKey, const std::string &filePath, uint64_t contentLen);
+    obs_status ObsPutObject(const std::string &objectKey,
+                            const std::string &filePath,
+                            uint64_t contentLen,
+                            const std::string &codec);
     int HeadBucket();
     int GetStorageInfo(size_t &objNum, size_t &cap);
     int GetQuota(uint64_t &quota);
@@ -53,7 +56,8 @@ class OBSStorage : public Storage {
     int Init() override;
 
     ssize_t ReadObject(const std::string &objectKey, uint64_t offset, uint64_t size, int fd, char *destBuffer) override;
-    int PutFile(const std::string &objectKey, const std::string &filePath) override;
+    int PutFile(const std::string &objectKey, const std::string &filePath, const std::string &codec) override;
+    int HeadObject(const std::string &objectKey, uint64_t &size, std::string &codec) override;
     ssize_t
     PutBuffer(const std::string &objectKey, const char *buf, const uint64_t size, const uint64_t offset) override;
     int DeleteObject(const std::string &objectKey) override;
@@ -10,6 +10,10 @@
 #include <sys/stat.h>
 #include <sys/statvfs.h>
 
+/* object metadata naming the codec an object was flushed compressed with, objects without it are plain */
+#define OBJECT_CODEC_META "cuckoo-codec"
+#define OBJECT_CODEC_VALUE_MAX 16
+
 class Storage {
   public:
     virtual ~Storage() = default;
@@ -17,7 +21,10 @@ class Storage {
     virtual int Init() = 0;
     virtual ssize_t
     ReadObject(const std::string &objectKey, uint64_t offset, uint64_t size, int fd, char *destBuffer) = 0;
-    virtual int PutFile(const std::string &objectKey, const std::string &filePath) = 0;
+    /* codec is recorded as OBJECT_CODEC_META unless empty, -ENOTSUP if it can not be recorded for this file */
+    virtual int PutFile(const std::string &objectKey, const std::string &filePath, const std::string &codec) = 0;
+    /* size and OBJECT_CODEC_META of an object, codec is empty for a plain object */
+    virtual int HeadObject(const std::string &objectKey, uint64_t &size, std::string &codec) = 0;
     virtual ssize_t
     PutBuffer(const std::string &objectKey, const char *buf, const uint64_t size, const uint64_t offset) = 0;
     virtual int DeleteObject(const std::string &objectKey) = 0;
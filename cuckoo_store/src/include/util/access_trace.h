@@ -0,0 +1,100 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#define ACCESS_TRACE_HEADER "cuckoo-access-trace 1"
+/* reads of more files than this going on at once are written out early */
+#define ACCESS_TRACE_MAX_RUNS 4096
+/* a run not extended for this long is written out, and the file is flushed as often */
+#define ACCESS_TRACE_FLUSH_US 1000000
+
+/* a read of [offset, offset + length) of a file at timeUs since the trace started */
+struct AccessTraceRecord
+{
+    uint64_t timeUs = 0;
+    uint64_t inodeId = 0;
+    uint64_t offset = 0;
+    uint64_t length = 0;
+    std::string path;
+};
+
+/*
+ * Records the reads of a job to a trace file, one line per record. A read going on where the last one of
+ * the same file ended extends that record, so a sequential pass over a file is a single record. A background
+ * thread writes out the runs that have ended and flushes the file, so a running trace can be read.
+ */
+class AccessTraceRecorder {
+  public:
+    static AccessTraceRecorder &GetInstance()
+    {
+        static AccessTraceRecorder instance;
+        return instance;
+    }
+
+    ~AccessTraceRecorder();
+
+    /* start a new trace in fileName, closing the running one, 0 or a negative errno */
+    int Start(const std::string &fileName);
+    /* write the records out and close the trace */
+    void Stop();
+    bool Started() { return started; }
+    void Record(uint64_t inodeId, const std::string &path, uint64_t offset, uint64_t length, uint64_t nowUs);
+    /* write out the runs not extended since ACCESS_TRACE_FLUSH_US before nowUs and flush the file */
+    void Flush(uint64_t nowUs);
+
+  private:
+    /* a record still growing, lastUs is the time of its last read */
+    struct TraceRun
+    {
+        AccessTraceRecord record;
+        uint64_t lastUs = 0;
+    };
+
+    /* stop the flusher, then write the records out and close the trace */
+    void Close();
+    void Write(const AccessTraceRecord &record);
+    void WriteRuns();
+    void FlushLoop(std::stop_token stopToken);
+
+    std::atomic<bool> started = false;
+    std::mutex mutex;
+    FILE *out = nullptr;
+    uint64_t startUs = 0;
+    bool startSet = false;
+    std::unordered_map<uint64_t, TraceRun> inodeIdToRunMap;
+    /* serializes Start and Stop, which join the flusher and so cannot hold mutex */
+    std::mutex controlMutex;
+    std::condition_variable_any flusherCv;
+    std::jthread flusher;
+};
+
+/* the records of a trace file by time, 0 or a negative errno */
+int LoadAccessTrace(const std::string &fileName, std::vector<AccessTraceRecord> &records);
+
+/*
+ * One record per file in the order the files were first read, spanning all reads of the file. The cache
+ * holds whole files, so this is the order to warm it in.
+ */
+std::vector<AccessTraceRecord> PlanAccessTraceWarmup(const std::vector<AccessTraceRecord> &records);
+
+class AccessTraceBackend {
+  public:
+    virtual ~AccessTraceBackend() = default;
+    /* bring the file of record into the cache, 0 or an error */
+    virtual int Warm(const AccessTraceRecord &record) = 0;
+};
+
+/* warms the files of a plan in order, up to window at once, and returns the first error */
+int ReplayAccessTrace(const std::vector<AccessTraceRecord> &plan, AccessTraceBackend &backend, uint32_t window);
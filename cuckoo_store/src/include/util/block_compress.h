@@ -0,0 +1,141 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <sys/types.h>
+
+/* blocks are compressed one by one, a read decompresses only the blocks it covers */
+#define COMPRESS_BLOCK_SIZE (64 * 1024)
+/* a compressed cache file is next to where the plain one was, DiskCache counts it for the same inode */
+#define COMPRESS_SUFFIX ".cz"
+/* a compressed or decompressed copy being written, DiskCache skips it when scanning */
+#define COMPRESS_TMP_SUFFIX ".cz.tmp"
+/* files not shrinking to this percent of their size are left as they are */
+#define COMPRESS_MAX_RATIO_PERCENT 90
+#define COMPRESS_ZSTD_LEVEL 3
+#define COMPRESS_SHARD_NUM 64
+/* how often the cache files to compress are checked for being cold */
+#define COMPRESS_SWEEP_INTERVAL_MS 10000
+
+enum class CompressCodec : uint8_t { NONE = 0, LZ4 = 1, ZSTD = 2 };
+
+/* a block as stored, of COMPRESS_BLOCK_SIZE bytes or less for the last, kept as is if it did not shrink */
+struct CompressedBlock
+{
+    uint64_t offset = 0;
+    uint32_t size = 0;
+    /* crc32c of the data before compression */
+    uint32_t crc = 0;
+};
+
+/* where the blocks of a compressed file are, read from the end of the file */
+struct CompressedIndex
+{
+    CompressCodec codec = CompressCodec::NONE;
+    uint64_t rawSize = 0;
+    std::vector<CompressedBlock> blocks;
+};
+
+/* true if the store was built with the library of codec */
+bool CompressCodecAvailable(CompressCodec codec);
+/* the name of codec in cuckoo_compression rules */
+const char *CompressCodecName(CompressCodec codec);
+/*
+ * write the file open at fd compressed by codec to dstName, synced, with its size in compressedSize.
+ * -EAGAIN if the file was written meanwhile.
+ */
+int CompressFile(int fd, const std::string &dstName, CompressCodec codec, uint64_t &compressedSize);
+/* the index of the compressed file open at fd, -EBADMSG if it is damaged */
+int LoadCompressedIndex(int fd, CompressedIndex &index);
+/*
+ * the index of a compressed file of fileSize from the last tailSize bytes of it, -EBADMSG if it is damaged.
+ * -ERANGE if the index is longer than the tail, neededSize is then the tail that holds it.
+ */
+int ParseCompressedTail(const char *tail, uint64_t tailSize, uint64_t fileSize, CompressedIndex &index,
+                        uint64_t &neededSize);
+/* read [offset, offset + size) of the data compressed in the file open at fd, -EIO if a block is damaged */
+ssize_t ReadCompressed(int fd, const CompressedIndex &index, char *buf, uint64_t offset, size_t size);
+/* the bytes of a compressed file that hold the blocks of [offset, offset + size) of its data */
+void StoredRange(const CompressedIndex &index, uint64_t offset, uint64_t size, uint64_t &storedOffset,
+                 uint64_t &storedSize);
+/*
+ * decompress [offset, offset + size) of the data of a compressed file to buf from stored, the bytes of the file
+ * from storedOffset on as StoredRange gives them. -EIO if a block is damaged.
+ */
+ssize_t DecompressRange(const CompressedIndex &index, const char *stored, uint64_t storedOffset, char *buf,
+                        uint64_t offset, size_t size);
+/* write the data compressed in the file open at fd to dstName, synced */
+int DecompressFile(int fd, const CompressedIndex &index, const std::string &dstName);
+
+/* the codec compressing the files under each directory prefix, the longest prefix a path is under wins */
+class CompressRules {
+  public:
+    /*
+     * "prefix:codec" pairs split by commas, as "/datasets:lz4,/logs:zstd", -EINVAL if malformed or naming a
+     * codec not built in
+     */
+    int Parse(const std::string &spec);
+    CompressCodec Match(const std::string &path) const;
+    bool Empty() const { return rules.empty(); }
+
+  private:
+    std::vector<std::pair<std::string, CompressCodec>> rules;
+};
+
+/*
+ * The cache files to compress once cold, and the compressed ones open for reading. Reads look the fd up
+ * before each read, so a plain fd costs a load while no compressed file is open.
+ */
+class FrozenFiles {
+  public:
+    /* the file of inodeId is to be compressed by codec once cold */
+    void Mark(uint64_t inodeId, CompressCodec codec);
+    void Forget(uint64_t inodeId);
+    std::vector<std::pair<uint64_t, CompressCodec>> Candidates();
+
+    /* fd is open on a compressed cache file with index */
+    void Open(int fd, std::shared_ptr<const CompressedIndex> index);
+    /* the index of the compressed file open at fd, nullptr if fd is open on a plain file */
+    std::shared_ptr<const CompressedIndex> Find(int fd);
+    void Close(int fd);
+
+    /* a read of the compressed file of inodeId was damaged, it is to be loaded again */
+    void SetDamaged(uint64_t inodeId);
+    /* true once after SetDamaged */
+    bool TakeDamaged(uint64_t inodeId);
+
+    /* count a file compressed from rawSize to compressedSize */
+    void AddFrozen(uint64_t rawSize, uint64_t compressedSize);
+    uint64_t GetFrozenNum() { return frozenNum; }
+    uint64_t GetSavedBytes() { return savedBytes; }
+
+  private:
+    struct alignas(64) Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<int, std::shared_ptr<const CompressedIndex>> fdToIndexMap;
+    };
+
+    Shard &ShardOf(int fd);
+
+    std::mutex candidateMutex;
+    std::unordered_map<uint64_t, CompressCodec> inodeIdToCodecMap;
+    std::unordered_set<uint64_t> damaged;
+    std::atomic<size_t> damagedNum = 0;
+    std::atomic<size_t> openNum = 0;
+    Shard shards[COMPRESS_SHARD_NUM];
+    std::atomic<uint64_t> frozenNum = 0;
+    std::atomic<uint64_t> savedBytes = 0;
+};
@@ -0,0 +1,119 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+/* a crc32c is kept per block of the cache files */
+#define CHECKSUM_BLOCK_SIZE (64 * 1024)
+/* the checksums of a cache file are in a sidecar next to it, DiskCache skips it when scanning */
+#define CHECKSUM_SUFFIX ".crc"
+#define CHECKSUM_SHARD_NUM 64
+
+/*
+ * The checksums of a cache file as it was when they were computed. A write changes the mtime, so
+ * checksums not matching the file anymore are told apart from data gone bad on the disk.
+ */
+struct FileChecksums
+{
+    uint64_t ino = 0;
+    uint64_t size = 0;
+    int64_t mtimeNs = 0;
+    /* the last block may be short */
+    std::vector<uint32_t> crcs;
+};
+
+/* the checksums of the file open at fd, -EAGAIN if it was written meanwhile */
+int ComputeChecksums(int fd, FileChecksums &sums);
+/* write the sidecar of fileName, 0 or a negative errno */
+int SaveChecksums(const std::string &fileName, const FileChecksums &sums);
+/* read the sidecar of fileName, -ENOENT if there is none or -EBADMSG if it is damaged */
+int LoadChecksums(const std::string &fileName, FileChecksums &sums);
+
+/*
+ * The checksums of the cache files in use, loaded from their sidecars on the first read. Full blocks are
+ * checked against the data read on every read, blocks only partly read are read whole and checked once.
+ * The table is not checked against the file on every read, a mismatch with checksums older than the file
+ * is told apart from bad data only then.
+ */
+class ChecksumTable {
+  public:
+    static ChecksumTable &GetInstance()
+    {
+        static ChecksumTable instance;
+        return instance;
+    }
+
+    /* keep checksums of the cache files at cacheFilePath(inodeId) from now on */
+    void Start(std::function<std::string(uint64_t)> cacheFilePath);
+    bool Started() { return started; }
+    /* compute and save the checksums of the cache file of inodeId once it is complete */
+    int Seal(uint64_t inodeId);
+    /* true if no seal of inodeId is queued yet, the caller queues one to run off its own path */
+    bool QueueSeal(uint64_t inodeId);
+    /* the queued seal of inodeId starts, a later change queues another one */
+    void TakeSeal(uint64_t inodeId);
+    /*
+     * check buf, read from [offset, offset + size) of the cache file of inodeId open at fd. 0 if it
+     * matches or there are no checksums of the file as it is now, -EIO if not.
+     */
+    int Verify(uint64_t inodeId, int fd, const char *buf, uint64_t offset, uint64_t size);
+    /* the same for [offset, offset + size) of the file itself */
+    int VerifyRange(uint64_t inodeId, int fd, uint64_t offset, uint64_t size);
+    /*
+     * true if all blocks of [offset, offset + size) of the file open at fd are checked already or the file has
+     * no checksums, only such ranges are handed out by fd unseen
+     */
+    bool Verified(uint64_t inodeId, int fd, uint64_t offset, uint64_t size);
+    /* true if a read of the cache file of inodeId did not match, it is to be loaded again */
+    bool Corrupt(uint64_t inodeId);
+    /* the cache file of inodeId is removed */
+    void Remove(uint64_t inodeId);
+    /* count a mismatch found on the way between nodes */
+    void AddMismatch() { ++mismatchNum; }
+    uint64_t GetMismatchNum() { return mismatchNum; }
+    size_t Size();
+
+  private:
+    struct Entry
+    {
+        explicit Entry(FileChecksums checksums, bool valid);
+
+        const FileChecksums sums;
+        /* false if sums only record the file, which has no checksums as it is now */
+        const bool valid;
+        std::unique_ptr<std::atomic<bool>[]> verified;
+        std::atomic<bool> corrupt = false;
+    };
+
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, std::shared_ptr<Entry>> inodeIdToEntryMap;
+        std::unordered_set<uint64_t> sealQueued;
+    };
+
+    Shard &ShardOf(uint64_t inodeId);
+    std::shared_ptr<Entry> Lookup(uint64_t inodeId);
+    /* the entry of inodeId, loaded from the sidecar of the file open at fd if there is none */
+    std::shared_ptr<Entry> Current(uint64_t inodeId, int fd);
+    /* buf is nullptr to check the file itself */
+    int Check(uint64_t inodeId, int fd, const char *buf, uint64_t offset, uint64_t size);
+    /* -EIO if the file is still as the checksums of entry were computed, else they are just old */
+    int Mismatch(int fd, Entry &entry);
+
+    std::atomic<bool> started = false;
+    std::function<std::string(uint64_t)> cacheFilePath;
+    Shard shards[CHECKSUM_SHARD_NUM];
+    std::atomic<uint64_t> mismatchNum = 0;
+};
@@ -0,0 +1,17 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+ * crc32c (Castagnoli) of size bytes at data going on from crc, 0 for the first bytes. Runs on the crc
+ * instructions of SSE4.2 or ARMv8 where the cpu has them, else on a table.
+ */
+uint32_t Crc32c(uint32_t crc, const void *data, size_t size);
+
+/* true if Crc32c runs on the crc instructions */
+bool Crc32cHardware();
@@ -5,21 +5,62 @@
 #pragma once
 
 #include <condition_variable>
-#include <memory>
-#include <shared_mutex>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
 #include <unordered_map>
+#include <utility>
 
-#define FILE_BUCKET 100
+#include "util/interval_tree.h"
+
+#define FILE_LOCK_SHARD_NUM 64
+#define RANGE_LOCK_EOF UINT64_MAX
+#define RANGE_LOCK_INTERRUPT_CHECK_MS 10
 
 enum class LockMode { X = -1, S = 1 };
 
+/* fcntl and flock locks do not conflict with each other */
+enum class RangeLockType { POSIX = 0, FLOCK = 1, END };
+
+/*
+ * a byte range [start, end) held by an owner, end RANGE_LOCK_EOF for up to the end of file.
+ * owners are the lock owners of fuse, which are unique only within the node they come from
+ */
+struct RangeLock
+{
+    uint64_t start = 0;
+    uint64_t end = RANGE_LOCK_EOF;
+    LockMode mode = LockMode::S;
+    uint64_t owner = 0;
+    int32_t nodeId = 0;
+    int32_t pid = 0;
+};
+
+struct RangeLockHolder
+{
+    LockMode mode;
+    uint64_t owner;
+    int32_t nodeId;
+    int32_t pid;
+
+    bool SameOwner(const RangeLock &rangeLock) const { return owner == rangeLock.owner && nodeId == rangeLock.nodeId; }
+};
+
 struct FileLockState
 {
-    std::shared_ptr<std::condition_variable_any> cv;
-    int lockCount;      // >0: S锁数量; <0: X锁; =0: 无锁
-    int waitingThreads; // 等待此锁的线程数
+    std::condition_variable cv;
+    int lockCount = 0;      // >0: S锁数量; <0: X锁; =0: 无锁
+    int waitingThreads = 0; // 等待此锁或字节范围锁的线程数
+    IntervalTree<RangeLockHolder> ranges[static_cast<int>(RangeLockType::END)];
 };
 
+/*
+ * Whole file locks taken by the store itself, and byte range locks taken by applications through fcntl and
+ * flock. Inodes are spread over shards by hash, each shard with its own mutex, and the range locks of an
+ * inode live in an interval tree, so locks of different files and disjoint ranges of one file do not wait
+ * for each other.
+ */
 class FileLock {
   public:
     void ReleaseFileLock(uint64_t inodeId, LockMode m);
@@ -28,10 +69,48 @@ class FileLock {
     void WaitGetFileLock(uint64_t inodeId, LockMode m);
     bool TestLocked(uint64_t inodeId, LockMode m = LockMode::S);
 
+    /*
+     * lock [start, end) for the owner, replacing what the owner held there like fcntl(F_SETLK) does.
+     * return 0, or -EAGAIN if a range of another owner conflicts and wait is false. a waiting posix lock
+     * returns -EDEADLK if the owner it waits for waits for this owner, through any number of owners and
+     * inodes, and -EINTR once interrupted returns true
+     */
+    int SetRangeLock(uint64_t inodeId,
+                     const RangeLock &rangeLock,
+                     bool wait,
+                     RangeLockType type = RangeLockType::POSIX,
+                     const std::function<bool()> &interrupted = nullptr);
+    /* unlock what the owner of rangeLock holds in [start, end), splitting ranges partly inside */
+    void ReleaseRangeLock(uint64_t inodeId, const RangeLock &rangeLock, RangeLockType type = RangeLockType::POSIX);
+    /* the first range of another owner conflicting with rangeLock as fcntl(F_GETLK) reports, false if none */
+    bool GetRangeLockConflict(uint64_t inodeId,
+                              const RangeLock &rangeLock,
+                              RangeLock &conflict,
+                              RangeLockType type = RangeLockType::POSIX);
+
   private:
+    struct alignas(64) FileLockShard
+    {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, FileLockState> inodeIdTofileLockStateMap;
+    };
+
     bool innerGetFileLock(uint64_t inodeId, LockMode m, bool wait = true);
-    std::unordered_map<uint64_t, FileLockState> inodeIdTofileLockStateMap;
-    std::shared_mutex mutex;
+    FileLockShard &ShardOf(uint64_t inodeId);
+    static void EraseIfUnused(FileLockShard &shard, uint64_t inodeId, FileLockState &state);
+    static bool
+    FindRangeConflict(IntervalTree<RangeLockHolder> &ranges, const RangeLock &rangeLock, RangeLock *conflict);
+    static void ReplaceOwnerRange(IntervalTree<RangeLockHolder> &ranges, const RangeLock &rangeLock, bool unlock);
+    /* record that the owner of rangeLock waits for the owner of conflict, false if that closes a cycle */
+    bool BlockOn(const RangeLock &rangeLock, const RangeLock &conflict);
+    void Unblock(const RangeLock &rangeLock);
+
+    using LockOwner = std::pair<uint64_t, int32_t>;
+
+    FileLockShard shards[FILE_LOCK_SHARD_NUM];
+    /* owner of each waiting posix lock to the owner it waits for, across all inodes */
+    std::mutex blockedMutex;
+    std::map<LockOwner, LockOwner> blockedOn;
 };
 
 class FileLocker {
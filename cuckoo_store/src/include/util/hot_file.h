@@ -0,0 +1,93 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#define HOT_FILE_SHARD_NUM 64
+#define HOT_FILE_WINDOW_MS 1000
+/* a file read less than threshold / HOT_FILE_COOL_DIVISOR in a window turns cold */
+#define HOT_FILE_COOL_DIVISOR 4
+/* states of files not read for this many windows are swept */
+#define HOT_FILE_IDLE_WINDOWS 60
+#define HOT_FILE_SWEEP_SIZE 1024
+
+/* the nodes holding copies of a hot file, copies of another version are stale */
+struct HotFileReplicas
+{
+    uint64_t version = 0;
+    std::vector<int> nodeIds;
+};
+
+/*
+ * Read rates of the files this node keeps, counted per fixed window. A file read at least threshold
+ * times in a window becomes hot and gets replicas, each hot period under a new version, until it cools
+ * down or is opened for write. No replicas are handed out while a writer has the file open.
+ */
+class HotFileTracker {
+  public:
+    HotFileTracker();
+
+    /* reads per window to become hot, 0 disables */
+    void SetThreshold(uint64_t readsPerWindow) { threshold = readsPerWindow; }
+    uint64_t GetThreshold() { return threshold.load(); }
+    /* count a read, true if the file just became hot and needs replicas */
+    bool RecordRead(uint64_t inodeId, uint64_t nowMs);
+    /* publish the replicas of a hot file, return the version, 0 if the file is no longer hot */
+    uint64_t SetReplicas(uint64_t inodeId, const std::vector<int> &nodeIds);
+    /* the replicas of the file, version 0 and none if not hot */
+    HotFileReplicas GetReplicas(uint64_t inodeId);
+    /* the file changes, forget and return its replicas */
+    HotFileReplicas Invalidate(uint64_t inodeId);
+    /* a writer opens the file, invalidate and hold off replicas until EndWrite */
+    HotFileReplicas BeginWrite(uint64_t inodeId);
+    void EndWrite(uint64_t inodeId);
+    size_t GetHotNum() { return hotNum.load(); }
+
+  private:
+    struct HotFileState
+    {
+        uint64_t windowStart = 0;
+        uint64_t lastRead = 0;
+        uint64_t reads = 0;
+        int writers = 0;
+        bool hot = false;
+        HotFileReplicas replicas;
+    };
+    struct alignas(64) HotFileShard
+    {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, HotFileState> inodeIdToStateMap;
+        size_t sweepSize = HOT_FILE_SWEEP_SIZE;
+    };
+
+    HotFileShard &ShardOf(uint64_t inodeId);
+    HotFileReplicas Cool(HotFileState &state);
+    void Sweep(HotFileShard &shard, uint64_t nowMs);
+
+    std::atomic<uint64_t> threshold = 0;
+    std::atomic<uint64_t> nextVersion;
+    std::atomic<size_t> hotNum = 0;
+    HotFileShard shards[HOT_FILE_SHARD_NUM];
+};
+
+/* the versions of the hot files of other nodes copied to this node */
+class ReplicaCopies {
+  public:
+    bool Has(uint64_t inodeId, uint64_t version);
+    bool Contains(uint64_t inodeId);
+    void Set(uint64_t inodeId, uint64_t version);
+    /* forget the copy if not newer than version, true if forgotten */
+    bool Drop(uint64_t inodeId, uint64_t version);
+    size_t Size();
+
+  private:
+    std::mutex mutex;
+    std::unordered_map<uint64_t, uint64_t> inodeIdToVersionMap;
+};
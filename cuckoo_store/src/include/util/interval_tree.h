@@ -0,0 +1,172 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/*
+ * Half open intervals [start, end) with a value each, overlaps allowed.
+ *
+ * A treap ordered by start, every node also keeps the largest end of its subtree, so subtrees ending
+ * before a query are skipped and an overlap query costs O(log n + overlaps).
+ */
+template <typename T>
+class IntervalTree {
+  public:
+    struct Interval
+    {
+        uint64_t start;
+        uint64_t end;
+        T value;
+    };
+
+    void Insert(uint64_t start, uint64_t end, const T &value)
+    {
+        auto node = std::make_unique<Node>(Interval{start, end, value}, ++seq, NextPriority());
+        auto [left, right] = Split(std::move(root), node->Key());
+        root = Merge(Merge(std::move(left), std::move(node)), std::move(right));
+        ++size;
+    }
+
+    /* fn(const Interval &) on every interval overlapping [start, end) in start order, stops when fn returns false */
+    template <typename Fn>
+    void ForEachOverlap(uint64_t start, uint64_t end, Fn &&fn) const
+    {
+        auto visit = [&fn](const Node &node) { return fn(node.interval); };
+        Visit(root.get(), start, end, visit);
+    }
+
+    /* removes the intervals overlapping [start, end) that pred(const Interval &) accepts, and returns them */
+    template <typename Pred>
+    std::vector<Interval> Extract(uint64_t start, uint64_t end, Pred &&pred)
+    {
+        std::vector<std::pair<uint64_t, uint64_t>> keys;
+        std::vector<Interval> extracted;
+        auto visit = [&](const Node &node) {
+            if (pred(node.interval)) {
+                keys.push_back(node.Key());
+                extracted.push_back(node.interval);
+            }
+            return true;
+        };
+        Visit(root.get(), start, end, visit);
+        for (auto &key : keys) {
+            auto [left, rest] = Split(std::move(root), key);
+            auto [mid, right] = Split(std::move(rest), {key.first, key.second + 1});
+            root = Merge(std::move(left), std::move(right));
+        }
+        size -= keys.size();
+        return extracted;
+    }
+
+    size_t Size() const { return size; }
+    bool Empty() const { return size == 0; }
+
+  private:
+    struct Node
+    {
+        Node(const Interval &interval, uint64_t seq, uint32_t priority)
+            : interval(interval),
+              seq(seq),
+              priority(priority),
+              maxEnd(interval.end)
+        {
+        }
+        /* seq tells apart intervals of the same start */
+        std::pair<uint64_t, uint64_t> Key() const { return {interval.start, seq}; }
+
+        Interval interval;
+        uint64_t seq;
+        uint32_t priority;
+        uint64_t maxEnd;
+        std::unique_ptr<Node> left;
+        std::unique_ptr<Node> right;
+    };
+    using NodePtr = std::unique_ptr<Node>;
+
+    static void Update(Node *node)
+    {
+        node->maxEnd = node->interval.end;
+        if (node->left != nullptr && node->left->maxEnd > node->maxEnd) {
+            node->maxEnd = node->left->maxEnd;
+        }
+        if (node->right != nullptr && node->right->maxEnd > node->maxEnd) {
+            node->maxEnd = node->right->maxEnd;
+        }
+    }
+
+    /* nodes with keys less than key go left */
+    static std::pair<NodePtr, NodePtr> Split(NodePtr node, std::pair<uint64_t, uint64_t> key)
+    {
+        if (node == nullptr) {
+            return {nullptr, nullptr};
+        }
+        if (node->Key() < key) {
+            auto [left, right] = Split(std::move(node->right), key);
+            node->right = std::move(left);
+            Update(node.get());
+            return {std::move(node), std::move(right)};
+        }
+        auto [left, right] = Split(std::move(node->left), key);
+        node->left = std::move(right);
+        Update(node.get());
+        return {std::move(left), std::move(node)};
+    }
+
+    /* every key of left is less than every key of right */
+    static NodePtr Merge(NodePtr left, NodePtr right)
+    {
+        if (left == nullptr) {
+            return right;
+        }
+        if (right == nullptr) {
+            return left;
+        }
+        if (left->priority > right->priority) {
+            left->right = Merge(std::move(left->right), std::move(right));
+            Update(left.get());
+            return left;
+        }
+        right->left = Merge(std::move(left), std::move(right->left));
+        Update(right.get());
+        return right;
+    }
+
+    template <typename Fn>
+    static bool Visit(const Node *node, uint64_t start, uint64_t end, Fn &fn)
+    {
+        if (node == nullptr || node->maxEnd <= start) {
+            return true;
+        }
+        if (!Visit(node->left.get(), start, end, fn)) {
+            return false;
+        }
+        if (node->interval.start >= end) {
+            /* the right subtree starts even later */
+            return true;
+        }
+        if (node->interval.end > start && !fn(*node)) {
+            return false;
+        }
+        return Visit(node->right.get(), start, end, fn);
+    }
+
+    uint32_t NextPriority()
+    {
+        /* xorshift, the tree is only balanced in expectation anyway */
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        return static_cast<uint32_t>(rng >> 32);
+    }
+
+    NodePtr root;
+    size_t size = 0;
+    uint64_t seq = 0;
+    uint64_t rng = 0x2545F4914F6CDD1DULL;
+};
@@ -0,0 +1,51 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/* how often the files pinned by a preload are checked for their ttl */
+#define PRELOAD_SWEEP_INTERVAL_MS 1000
+
+/*
+ * The files preloaded into the cache with a ttl. Each holds a single pin in DiskCache until its deadline,
+ * preloading it again only pushes the deadline out.
+ */
+class PreloadPins {
+  public:
+    /* true if the file was not pinned by a preload yet, else the caller drops its own pin */
+    bool Pin(uint64_t inodeId, uint64_t deadlineMs);
+    /* the files whose deadline passed, to unpin, they are not tracked anymore */
+    std::vector<uint64_t> TakeExpired(uint64_t nowMs);
+    /* the file is deleted, true if it was tracked */
+    bool Release(uint64_t inodeId);
+    size_t Size();
+
+  private:
+    std::mutex mutex;
+    std::multimap<uint64_t, uint64_t> deadlineToInodeIdMap;
+    std::unordered_map<uint64_t, std::multimap<uint64_t, uint64_t>::iterator> inodeIdToDeadlineMap;
+};
+
+/* limits the bytes taken to ratePerSec on average with bursts of a second, 0 is unlimited */
+class TokenBucket {
+  public:
+    explicit TokenBucket(uint64_t ratePerSec);
+    /*
+     * take size at nowMs, 0 if taken, else the ms to wait before trying again. A take larger than the
+     * bucket is let through when the bucket is not in debt, and the takes after wait until it is paid.
+     */
+    uint64_t Take(uint64_t size, uint64_t nowMs);
+
+  private:
+    std::mutex mutex;
+    uint64_t rate;
+    int64_t tokens;
+    uint64_t lastMs = 0;
+};
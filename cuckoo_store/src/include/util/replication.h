@@ -0,0 +1,108 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#define REPLICATION_SHARD_NUM 64
+/* a file changed in more ranges than this is shipped whole */
+#define REPLICATION_MAX_RANGES 1024
+
+enum class ReplicationMode { NONE = 0, ASYNC = 1, SYNC = 2 };
+
+/* what the backup of a file misses, the whole file if full */
+struct BackupWork
+{
+    bool full = false;
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+};
+
+/*
+ * The changes of the files this node is primary of, not yet shipped to their backups. A file whose backup
+ * is another node than the one last shipped to, or whose last shipping failed, is shipped whole.
+ */
+class ReplicationLog {
+  public:
+    /* [offset, offset + size) of the file changed, size 0 for a resize */
+    void MarkDirty(uint64_t inodeId, uint64_t offset, uint64_t size);
+    /* ship the whole file on the next sync */
+    void MarkFull(uint64_t inodeId);
+    /* true if the file has changes to ship */
+    bool Pending(uint64_t inodeId);
+    /* take the changes to ship to backupNodeId, nullopt if it is up to date */
+    std::optional<BackupWork> Take(uint64_t inodeId, int backupNodeId);
+    /* the backup took the changes */
+    void Done(uint64_t inodeId, int backupNodeId);
+    /* the backup missed the changes, ship the whole file next time */
+    void Fail(uint64_t inodeId);
+    /* the file is deleted */
+    void Forget(uint64_t inodeId);
+    /* the files whose backup moved from where they were shipped to, each marked to ship whole to backupOf */
+    std::vector<uint64_t> TakeMoved(const std::function<int(uint64_t)> &backupOf);
+    size_t Size();
+
+  private:
+    struct ReplicationState
+    {
+        int backupNodeId = -1;
+        bool dirty = false;
+        bool full = false;
+        /* start to end of the changed ranges, merged */
+        std::map<uint64_t, uint64_t> ranges;
+    };
+    struct alignas(64) ReplicationShard
+    {
+        std::mutex mutex;
+        std::unordered_map<uint64_t, ReplicationState> inodeIdToStateMap;
+    };
+
+    ReplicationShard &ShardOf(uint64_t inodeId);
+    static void SetFull(ReplicationState &state);
+
+    ReplicationShard shards[REPLICATION_SHARD_NUM];
+};
+
+/*
+ * The copies this node keeps as the backup of files of other nodes. A copy is filled whole from its primary
+ * first, and takes changes from the same primary after. A copy is filling from the first chunk of any ship
+ * until its last one, so a copy left half changed by a primary gone mid-ship is dropped, not promoted. When
+ * the primary is gone this node serves the file, so its complete copies are promoted to primary copies.
+ */
+class BackupCopies {
+  public:
+    /* a whole copy from the primary starts */
+    void BeginFill(uint64_t inodeId, int primaryNodeId);
+    /* a chunk of changes from the primary arrives, false if they do not apply to the copy */
+    bool BeginChange(uint64_t inodeId, int primaryNodeId);
+    /* true if changes from the primary apply to the copy */
+    bool Accepts(uint64_t inodeId, int primaryNodeId);
+    /* the last chunk of a ship arrived */
+    void Complete(uint64_t inodeId, int primaryNodeId);
+    /* true if the copy holds what the primary last shipped, or was promoted */
+    bool Current(uint64_t inodeId);
+    bool Contains(uint64_t inodeId);
+    /* the primary is gone, promote its complete copies and return them */
+    std::vector<uint64_t> Promote(int primaryNodeId);
+    void Erase(uint64_t inodeId);
+    size_t Size();
+
+  private:
+    enum class CopyState { FILLING, COMPLETE, PROMOTED };
+    struct BackupCopy
+    {
+        int primaryNodeId;
+        CopyState state;
+    };
+
+    std::mutex mutex;
+    std::unordered_map<uint64_t, BackupCopy> inodeIdToCopyMap;
+};
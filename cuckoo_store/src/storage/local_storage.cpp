@@ -0,0 +1,254 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "storage/local_storage.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+#include <algorithm>
+#include <filesystem>
+#include <memory>
+
+#include "conf/cuckoo_property_key.h"
+#include "init/cuckoo_init.h"
+#include "log/logging.h"
+#include "remote_connection_utils/cuckoo_trace.h"
+#include "stats/cuckoo_stats.h"
+#include "stats/latency_histogram.h"
+
+constexpr uint64_t LOCAL_STORAGE_IO_SIZE = 1024 * 1024;
+/* object metadata is kept as an xattr of the object file */
+constexpr const char *LOCAL_STORAGE_CODEC_XATTR = "user." OBJECT_CODEC_META;
+
+LocalStorage *LocalStorage::GetInstance()
+{
+    static LocalStorage m_singleton;
+    return &m_singleton;
+}
+
+int LocalStorage::Init()
+{
+    if (!isInit.load()) {
+        rootPath = GetInit().GetCuckooConfig()->GetString(CuckooPropertyKey::CUCKOO_LOCAL_STORAGE_PATH);
+        if (rootPath.empty()) {
+            CUCKOO_LOG(LOG_ERROR) << "cuckoo_local_storage_path is not set";
+            return -1;
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(rootPath, ec);
+        if (ec) {
+            CUCKOO_LOG(LOG_ERROR) << "Create local storage " << rootPath << " failed: " << ec.message();
+            return -1;
+        }
+        isInit.store(true);
+        CUCKOO_LOG(LOG_INFO) << "successfully init local storage, root path is " << rootPath;
+    }
+    return 0;
+}
+
+void LocalStorage::DeleteInstance() { isInit.store(false); }
+
+ssize_t LocalStorage::ReadObject(const std::string &objectKey, uint64_t offset, uint64_t size, int fd, char *destBuffer)
+{
+    StatLatencyTimer t(HIST_OBJ_GET);
+    CuckooTraceScope trace("local_get");
+    int objectFd = open(ObjectPath(objectKey).c_str(), O_RDONLY);
+    if (objectFd < 0) {
+        CUCKOO_LOG(LOG_ERROR) << "ReadObject() " << objectKey << " failed: " << strerror(errno);
+        return -1;
+    }
+    struct stat st;
+    if (fstat(objectFd, &st) != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "ReadObject() " << objectKey << " stat failed: " << strerror(errno);
+        close(objectFd);
+        return -1;
+    }
+    /* size 0 reads to the end of the object, same as obs */
+    uint64_t end = static_cast<uint64_t>(st.st_size);
+    if (size != 0) {
+        end = std::min(end, offset + size);
+    }
+
+    std::unique_ptr<char[]> bounce;
+    if (destBuffer == nullptr) {
+        bounce = std::make_unique<char[]>(LOCAL_STORAGE_IO_SIZE);
+    }
+    /* data lands at the start of destBuffer and of fd, as with the obs callbacks */
+    uint64_t done = 0;
+    while (offset + done < end) {
+        uint64_t toRead = std::min(LOCAL_STORAGE_IO_SIZE, end - offset - done);
+        char *chunk = destBuffer != nullptr ? destBuffer + done : bounce.get();
+        ssize_t readSize = pread(objectFd, chunk, toRead, offset + done);
+        if (readSize <= 0) {
+            CUCKOO_LOG(LOG_ERROR) << "ReadObject() " << objectKey << " read failed: " << strerror(errno);
+            close(objectFd);
+            return -1;
+        }
+        if (destBuffer != nullptr) {
+            CuckooStats::GetInstance().stats[OBJ_GET] += readSize;
+        }
+        if (fd != -1) {
+            CuckooStats::GetInstance().stats[BLOCKCACHE_WRITE] += readSize;
+            if (pwrite(fd, chunk, readSize, done) != readSize) {
+                CUCKOO_LOG(LOG_ERROR) << "ReadObject() " << objectKey << " cache write failed: " << strerror(errno);
+                close(objectFd);
+                return -1;
+            }
+        }
+        done += readSize;
+    }
+    close(objectFd);
+    return static_cast<ssize_t>(done);
+}
+
+int LocalStorage::CreateTmpObject(const std::string &objectKey, std::string &tmpPath)
+{
+    std::string objectPath = ObjectPath(objectKey);
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(objectPath).parent_path(), ec);
+    tmpPath = objectPath + ".XXXXXX";
+    int fd = mkstemp(tmpPath.data());
+    if (fd < 0) {
+        CUCKOO_LOG(LOG_ERROR) << "Create object " << objectKey << " failed: " << strerror(errno);
+    }
+    return fd;
+}
+
+int LocalStorage::PublishObject(const std::string &objectKey, const std::string &tmpPath, int fd, bool ok)
+{
+    close(fd);
+    if (ok && rename(tmpPath.c_str(), ObjectPath(objectKey).c_str()) == 0) {
+        return 0;
+    }
+    CUCKOO_LOG(LOG_ERROR) << "Write object " << objectKey << " failed: " << strerror(errno);
+    unlink(tmpPath.c_str());
+    return -1;
+}
+
+int LocalStorage::PutFile(const std::string &objectKey, const std::string &filePath, const std::string &codec)
+{
+    StatLatencyTimer t(HIST_OBJ_PUT);
+    CuckooTraceScope trace("local_put");
+    int srcFd = open(filePath.c_str(), O_RDONLY);
+    if (srcFd < 0) {
+        CUCKOO_LOG(LOG_ERROR) << "PutFile() open " << filePath << " failed: " << strerror(errno);
+        return -1;
+    }
+    std::string tmpPath;
+    int fd = CreateTmpObject(objectKey, tmpPath);
+    if (fd < 0) {
+        close(srcFd);
+        return -1;
+    }
+    /* copied in the kernel, the content never passes through user space */
+    ssize_t copySize = 0;
+    uint64_t done = 0;
+    while ((copySize = copy_file_range(srcFd, nullptr, fd, nullptr, LOCAL_STORAGE_IO_SIZE, 0)) > 0) {
+        done += copySize;
+    }
+    close(srcFd);
+    CuckooStats::GetInstance().stats[OBJ_PUT] += done;
+    bool ok = copySize == 0;
+    if (ok && !codec.empty() && fsetxattr(fd, LOCAL_STORAGE_CODEC_XATTR, codec.data(), codec.size(), 0) != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "PutFile() " << objectKey << " codec not recorded: " << strerror(errno);
+        ok = false;
+    }
+    return PublishObject(objectKey, tmpPath, fd, ok);
+}
+
+ssize_t LocalStorage::PutBuffer(const std::string &objectKey,
+                                const char *buf,
+                                const uint64_t size,
+                                const uint64_t offset)
+{
+    StatLatencyTimer t(HIST_OBJ_PUT);
+    CuckooTraceScope trace("local_put");
+    uint64_t contentLen = buf != nullptr ? size : 0;
+    std::string tmpPath;
+    int fd = CreateTmpObject(objectKey, tmpPath);
+    if (fd < 0) {
+        return -1;
+    }
+    uint64_t done = 0;
+    while (done < contentLen) {
+        ssize_t writeSize = write(fd, buf + offset + done, contentLen - done);
+        if (writeSize < 0) {
+            break;
+        }
+        done += writeSize;
+    }
+    CuckooStats::GetInstance().stats[OBJ_PUT] += done;
+    if (PublishObject(objectKey, tmpPath, fd, done == contentLen) != 0) {
+        return -1;
+    }
+    return static_cast<ssize_t>(contentLen);
+}
+
+int LocalStorage::HeadObject(const std::string &objectKey, uint64_t &size, std::string &codec)
+{
+    std::string objectPath = ObjectPath(objectKey);
+    struct stat st;
+    if (stat(objectPath.c_str(), &st) != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "HeadObject() " << objectKey << " failed: " << strerror(errno);
+        return -1;
+    }
+    size = st.st_size;
+    char value[OBJECT_CODEC_VALUE_MAX];
+    ssize_t valueSize = getxattr(objectPath.c_str(), LOCAL_STORAGE_CODEC_XATTR, value, sizeof(value));
+    if (valueSize < 0 && errno != ENODATA && errno != ENOTSUP) {
+        CUCKOO_LOG(LOG_ERROR) << "HeadObject() " << objectKey << " metadata failed: " << strerror(errno);
+        return -1;
+    }
+    codec.assign(value, valueSize > 0 ? valueSize : 0);
+    return 0;
+}
+
+int LocalStorage::DeleteObject(const std::string &objectKey)
+{
+    if (unlink(ObjectPath(objectKey).c_str()) != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "delete object " << objectKey << " failed: " << strerror(errno);
+        return -1;
+    }
+    CUCKOO_LOG(LOG_INFO) << "delete object " << objectKey << " successfully";
+    return 0;
+}
+
+int LocalStorage::CopyObject(const std::string &fromPath, const std::string &toPath)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(ObjectPath(toPath)).parent_path(), ec);
+    std::filesystem::copy_file(ObjectPath(fromPath),
+                               ObjectPath(toPath),
+                               std::filesystem::copy_options::overwrite_existing,
+                               ec);
+    if (ec) {
+        CUCKOO_LOG(LOG_ERROR) << "CopyObject " << fromPath << " to " << toPath << " failed: " << ec.message();
+        return -1;
+    }
+    /* metadata goes with the copy as obs copies it, an overwritten object keeps none of its own */
+    std::string dstPath = ObjectPath(toPath);
+    char value[OBJECT_CODEC_VALUE_MAX];
+    ssize_t valueSize = getxattr(ObjectPath(fromPath).c_str(), LOCAL_STORAGE_CODEC_XATTR, value, sizeof(value));
+    int ret = valueSize > 0 ? setxattr(dstPath.c_str(), LOCAL_STORAGE_CODEC_XATTR, value, valueSize, 0)
+                            : removexattr(dstPath.c_str(), LOCAL_STORAGE_CODEC_XATTR);
+    if (ret != 0 && (valueSize > 0 || (errno != ENODATA && errno != ENOTSUP))) {
+        CUCKOO_LOG(LOG_ERROR) << "CopyObject " << fromPath << " to " << toPath
+                              << " metadata not copied: " << strerror(errno);
+        return -1;
+    }
+    return 0;
+}
+
+int LocalStorage::StatFs(struct statvfs *vfsbuf)
+{
+    if (statvfs(rootPath.c_str(), vfsbuf) != 0) {
+        return -EIO;
+    }
+    return 0;
+}
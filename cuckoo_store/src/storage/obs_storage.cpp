@@ -7,10 +7,12 @@
 #include <fcntl.h>
 #include <math.h>
 #include <securec.h>
+#include <strings.h>
 #include <time.h>
 #include <unistd.h>
 
 #include "log/logging.h"
+#include "remote_connection_utils/cuckoo_trace.h"
 #include "stats/cuckoo_stats.h"
 
 struct NormalBackType
@@ -36,6 +38,13 @@ struct PutBufCallbackType
     const obs_error_details *error = nullptr;
 };
 
+struct HeadObjectCallbackType
+{
+    uint64_t size = 0;
+    std::string codec;
+    obs_status retStatus = OBS_STATUS_OK;
+};
+
 struct GetObjectCallbackType
 {
     int fd = 0;
@@ -181,6 +190,29 @@ obs_status NormalPropertiesCallback(const obs_response_properties *properties, v
     return OBS_STATUS_OK;
 }
 
+obs_status HeadObjectPropertiesCallback(const obs_response_properties *properties, void *callbackData)
+{
+    if (properties == nullptr || callbackData == nullptr) {
+        return OBS_STATUS_ErrorUnknown;
+    }
+    auto *data = static_cast<HeadObjectCallbackType *>(callbackData);
+    data->size = properties->content_length;
+    for (int i = 0; i < properties->meta_data_count; i++) {
+        const obs_name_value &meta = properties->meta_data[i];
+        if (meta.name != nullptr && meta.value != nullptr && strcasecmp(meta.name, OBJECT_CODEC_META) == 0) {
+            data->codec = meta.value;
+        }
+    }
+    return OBS_STATUS_OK;
+}
+
+void HeadObjectCompleteCallback(obs_status status, const obs_error_details * /*error*/, void *callbackData)
+{
+    if (callbackData) {
+        static_cast<HeadObjectCallbackType *>(callbackData)->retStatus = status;
+    }
+}
+
 void PutFileCompleteCallback(obs_status status, const obs_error_details *error, void *callbackData)
 {
     if (callbackData) {
@@ -287,6 +319,8 @@ obs_status GetObjectDataCallback(int bufferSize, const char *buffer, void *callb
 
 ssize_t OBSStorage::ReadObject(const std::string &objectKey, uint64_t offset, uint64_t size, int fd, char *destBuffer)
 {
+    StatLatencyTimer t(HIST_OBJ_GET);
+    CuckooTraceScope trace("obs_get");
     obs_options option;
     InitObsOptions(option);
 
@@ -346,19 +380,27 @@ uint64_t OpenFileGetLength(const std::string &localFile)
     return statbuf.st_size;
 }
 
-int OBSStorage::PutFile(const std::string &objectKey, const std::string &filePath)
+int OBSStorage::PutFile(const std::string &objectKey, const std::string &filePath, const std::string &codec)
 {
+    StatLatencyTimer t(HIST_OBJ_PUT);
+    CuckooTraceScope trace("obs_put");
     uint64_t contentLen = OpenFileGetLength(filePath);
     obs_status retStatus = OBS_STATUS_BUTT;
     if (contentLen < UPLOAD_SLICE_SIZE) {
-        retStatus = ObsPutObject(objectKey, filePath, contentLen);
-    } else {
+        retStatus = ObsPutObject(objectKey, filePath, contentLen, codec);
+    } else if (codec.empty()) {
         retStatus = ObsUploadFile(objectKey, filePath, contentLen);
+    } else {
+        /* the resumable upload sets no metadata */
+        return -ENOTSUP;
     }
     return static_cast<int>(retStatus);
 }
 
-obs_status OBSStorage::ObsPutObject(const std::string &objectKey, const std::string &filePath, uint64_t contentLen)
+obs_status OBSStorage::ObsPutObject(const std::string &objectKey,
+                                    const std::string &filePath,
+                                    uint64_t contentLen,
+                                    const std::string &codec)
 {
     // Initialize option
     obs_options option;
@@ -367,6 +409,11 @@ obs_status OBSStorage::ObsPutObject(const std::string &objectKey, const std::str
     // Initialize upload object properties
     obs_put_properties putProperties;
     init_put_properties(&putProperties);
+    obs_name_value codecMeta = {const_cast<char *>(OBJECT_CODEC_META), const_cast<char *>(codec.c_str())};
+    if (!codec.empty()) {
+        putProperties.meta_data_count = 1;
+        putProperties.meta_data = &codecMeta;
+    }
 
     // Initialize the structure that stores the uploaded data
     PutFileCallbackType data;
@@ -404,6 +451,8 @@ obs_status OBSStorage::ObsPutObject(const std::string &objectKey, const std::str
 
 ssize_t OBSStorage::PutBuffer(const std::string &objectKey, const char *buf, const uint64_t size, const uint64_t offset)
 {
+    StatLatencyTimer t(HIST_OBJ_PUT);
+    CuckooTraceScope trace("obs_put");
     // Initialize option
     obs_options option;
     InitObsOptions(option);
@@ -517,6 +566,36 @@ obs_status OBSStorage::ObsUploadFile(const std::string &objectKey, const std::st
     return retStatus;
 }
 
+int OBSStorage::HeadObject(const std::string &objectKey, uint64_t &size, std::string &codec)
+{
+    obs_options option;
+    InitObsOptions(option);
+
+    obs_object_info objectInfo;
+    errno_t err = memset_s(&objectInfo, sizeof(obs_object_info), 0, sizeof(obs_object_info));
+    if (err != 0) {
+        CUCKOO_LOG(LOG_ERROR) << "Secure func failed: " << err;
+        return -1;
+    }
+    objectInfo.key = const_cast<char *>(objectKey.c_str());
+    obs_response_handler responseHandler = {&HeadObjectPropertiesCallback, &HeadObjectCompleteCallback};
+    HeadObjectCallbackType data;
+    data.retStatus = OBS_STATUS_BUTT;
+    int retryCount = RETRY_NUM;
+    while (retryCount > 0) {
+        data.codec.clear();
+        get_object_metadata(&option, &objectInfo, nullptr, &responseHandler, &data);
+        DoRetry(data.retStatus, retryCount);
+    }
+    if (OBS_STATUS_OK != data.retStatus) {
+        CUCKOO_LOG(LOG_ERROR) << "HeadObject " << objectKey << " failed: " << obs_get_status_name(data.retStatus);
+        return -1;
+    }
+    size = data.size;
+    codec = std::move(data.codec);
+    return 0;
+}
+
 int OBSStorage::DeleteObject(const std::string &objectKey)
 {
     // Initialize option
@@ -0,0 +1,218 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "util/access_trace.h"
+
+#include <cerrno>
+#include <cinttypes>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+AccessTraceRecorder::~AccessTraceRecorder() { Stop(); }
+
+int AccessTraceRecorder::Start(const std::string &fileName)
+{
+    std::lock_guard<std::mutex> controlLock(controlMutex);
+    Close();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        out = fopen(fileName.c_str(), "w");
+        if (out == nullptr) {
+            return -errno;
+        }
+        fprintf(out, "%s\n", ACCESS_TRACE_HEADER);
+        startSet = false;
+        started = true;
+    }
+    flusher = std::jthread([this](std::stop_token stopToken) { FlushLoop(stopToken); });
+    return 0;
+}
+
+void AccessTraceRecorder::Stop()
+{
+    std::lock_guard<std::mutex> controlLock(controlMutex);
+    Close();
+}
+
+void AccessTraceRecorder::Close()
+{
+    if (flusher.joinable()) {
+        flusher.request_stop();
+        flusher.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    started = false;
+    if (out == nullptr) {
+        return;
+    }
+    WriteRuns();
+    fclose(out);
+    out = nullptr;
+}
+
+void AccessTraceRecorder::FlushLoop(std::stop_token stopToken)
+{
+    std::mutex waitMutex;
+    std::unique_lock<std::mutex> waitLock(waitMutex);
+    while (true) {
+        flusherCv.wait_for(waitLock, stopToken, std::chrono::microseconds(ACCESS_TRACE_FLUSH_US), [] { return false; });
+        if (stopToken.stop_requested()) {
+            return;
+        }
+        /* the clock the reads are recorded with */
+        auto now = std::chrono::steady_clock::now().time_since_epoch();
+        Flush(std::chrono::duration_cast<std::chrono::microseconds>(now).count());
+    }
+}
+
+void AccessTraceRecorder::Flush(uint64_t nowUs)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (out == nullptr) {
+        return;
+    }
+    for (auto it = inodeIdToRunMap.begin(); it != inodeIdToRunMap.end();) {
+        if (it->second.lastUs + ACCESS_TRACE_FLUSH_US > nowUs) {
+            ++it;
+            continue;
+        }
+        Write(it->second.record);
+        it = inodeIdToRunMap.erase(it);
+    }
+    fflush(out);
+}
+
+void AccessTraceRecorder::Write(const AccessTraceRecord &record)
+{
+    fprintf(out,
+            "%" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64 " %s\n",
+            record.timeUs,
+            record.inodeId,
+            record.offset,
+            record.length,
+            record.path.c_str());
+}
+
+void AccessTraceRecorder::WriteRuns()
+{
+    for (auto &[inodeId, run] : inodeIdToRunMap) {
+        Write(run.record);
+    }
+    inodeIdToRunMap.clear();
+}
+
+void AccessTraceRecorder::Record(uint64_t inodeId,
+                                 const std::string &path,
+                                 uint64_t offset,
+                                 uint64_t length,
+                                 uint64_t nowUs)
+{
+    if (!started || length == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (out == nullptr) {
+        return;
+    }
+    if (!startSet) {
+        startUs = nowUs;
+        startSet = true;
+    }
+    auto it = inodeIdToRunMap.find(inodeId);
+    if (it != inodeIdToRunMap.end()) {
+        AccessTraceRecord &run = it->second.record;
+        if (run.offset + run.length == offset) {
+            run.length += length;
+            it->second.lastUs = nowUs;
+            return;
+        }
+        Write(run);
+        inodeIdToRunMap.erase(it);
+    }
+    if (inodeIdToRunMap.size() >= ACCESS_TRACE_MAX_RUNS) {
+        WriteRuns();
+    }
+    AccessTraceRecord record{nowUs - startUs, inodeId, offset, length, path};
+    inodeIdToRunMap.emplace(inodeId, TraceRun{std::move(record), nowUs});
+}
+
+int LoadAccessTrace(const std::string &fileName, std::vector<AccessTraceRecord> &records)
+{
+    std::ifstream in(fileName);
+    if (!in) {
+        return -ENOENT;
+    }
+    std::string line;
+    if (!std::getline(in, line) || line != ACCESS_TRACE_HEADER) {
+        return -EINVAL;
+    }
+    while (std::getline(in, line)) {
+        AccessTraceRecord record;
+        int pathStart = 0;
+        int fields = sscanf(line.c_str(),
+                            "%" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64 " %n",
+                            &record.timeUs,
+                            &record.inodeId,
+                            &record.offset,
+                            &record.length,
+                            &pathStart);
+        if (fields != 4 || pathStart == 0) {
+            return -EINVAL;
+        }
+        record.path = line.substr(pathStart);
+        records.push_back(std::move(record));
+    }
+    /* runs are written when they end, not in the order they started */
+    std::stable_sort(records.begin(), records.end(), [](const AccessTraceRecord &a, const AccessTraceRecord &b) {
+        return a.timeUs < b.timeUs;
+    });
+    return 0;
+}
+
+std::vector<AccessTraceRecord> PlanAccessTraceWarmup(const std::vector<AccessTraceRecord> &records)
+{
+    std::vector<AccessTraceRecord> plan;
+    std::unordered_map<uint64_t, size_t> inodeIdToIndexMap;
+    for (const AccessTraceRecord &record : records) {
+        auto [it, first] = inodeIdToIndexMap.emplace(record.inodeId, plan.size());
+        if (first) {
+            plan.push_back(record);
+            continue;
+        }
+        AccessTraceRecord &file = plan[it->second];
+        uint64_t end = std::max(file.offset + file.length, record.offset + record.length);
+        file.offset = std::min(file.offset, record.offset);
+        file.length = end - file.offset;
+    }
+    return plan;
+}
+
+int ReplayAccessTrace(const std::vector<AccessTraceRecord> &plan, AccessTraceBackend &backend, uint32_t window)
+{
+    std::atomic<size_t> next = 0;
+    std::atomic<int> firstError = 0;
+    auto warm = [&]() {
+        for (size_t i = next++; i < plan.size(); i = next++) {
+            int ret = backend.Warm(plan[i]);
+            int expected = 0;
+            if (ret != 0) {
+                firstError.compare_exchange_strong(expected, ret);
+            }
+        }
+    };
+    size_t threadNum = std::min<size_t>(std::max<uint32_t>(window, 1), plan.size());
+    if (threadNum <= 1) {
+        /* in order on the caller */
+        warm();
+        return firstError;
+    }
+    std::vector<std::jthread> threads;
+    for (size_t t = 0; t < threadNum; ++t) {
+        threads.emplace_back(warm);
+    }
+    threads.clear();
+    return firstError;
+}
@@ -0,0 +1,611 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "util/block_compress.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#include <sys/stat.h>
+#ifdef CUCKOO_HAVE_LZ4
+#include <lz4.h>
+#endif
+#ifdef CUCKOO_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "util/crc32c.h"
+
+#define COMPRESS_MAGIC 0x5a434b43U
+/* blocks read or written at once when a whole file is compressed or decompressed */
+#define COMPRESS_BATCH_BLOCKS 16
+
+/* a compressed file is the blocks, their index and this trailer */
+struct CompressTrailer
+{
+    uint64_t rawSize;
+    uint64_t blockNum;
+    uint32_t blockSize;
+    uint32_t magic;
+    uint8_t codec;
+    uint8_t reserved[3];
+    /* crc32c of the index and the trailer before it */
+    uint32_t crc;
+};
+
+static_assert(sizeof(CompressedBlock) == 16, "CompressedBlock is stored as is");
+static_assert(sizeof(CompressTrailer) == 32, "CompressTrailer is stored as is");
+
+static uint64_t BlockNum(uint64_t size) { return (size + COMPRESS_BLOCK_SIZE - 1) / COMPRESS_BLOCK_SIZE; }
+
+static size_t BlockLength(const CompressedIndex &index, uint64_t block)
+{
+    return std::min<uint64_t>(COMPRESS_BLOCK_SIZE, index.rawSize - block * COMPRESS_BLOCK_SIZE);
+}
+
+static bool SameFile(const struct stat &a, const struct stat &b)
+{
+    return a.st_ino == b.st_ino && a.st_size == b.st_size && a.st_mtim.tv_sec == b.st_mtim.tv_sec &&
+           a.st_mtim.tv_nsec == b.st_mtim.tv_nsec;
+}
+
+static int WriteAll(int fd, const char *data, size_t size)
+{
+    while (size > 0) {
+        ssize_t writeSize = write(fd, data, size);
+        if (writeSize < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        data += writeSize;
+        size -= writeSize;
+    }
+    return 0;
+}
+
+static int ReadAll(int fd, char *data, size_t size, uint64_t offset)
+{
+    while (size > 0) {
+        ssize_t readSize = pread(fd, data, size, offset);
+        if (readSize < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        if (readSize == 0) {
+            return -EIO;
+        }
+        data += readSize;
+        size -= readSize;
+        offset += readSize;
+    }
+    return 0;
+}
+
+#ifdef CUCKOO_HAVE_ZSTD
+static ZSTD_CCtx *ZstdCompressContext()
+{
+    thread_local std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> context(ZSTD_createCCtx(), ZSTD_freeCCtx);
+    return context.get();
+}
+
+static ZSTD_DCtx *ZstdDecompressContext()
+{
+    thread_local std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> context(ZSTD_createDCtx(), ZSTD_freeDCtx);
+    return context.get();
+}
+#endif
+
+bool CompressCodecAvailable(CompressCodec codec)
+{
+    switch (codec) {
+#ifdef CUCKOO_HAVE_LZ4
+    case CompressCodec::LZ4:
+        return true;
+#endif
+#ifdef CUCKOO_HAVE_ZSTD
+    case CompressCodec::ZSTD:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+const char *CompressCodecName(CompressCodec codec)
+{
+    switch (codec) {
+    case CompressCodec::LZ4:
+        return "lz4";
+    case CompressCodec::ZSTD:
+        return "zstd";
+    default:
+        return "none";
+    }
+}
+
+/* blocks never grow past this, a block stored as is takes COMPRESS_BLOCK_SIZE */
+static size_t CompressBound(CompressCodec codec)
+{
+#ifdef CUCKOO_HAVE_LZ4
+    if (codec == CompressCodec::LZ4) {
+        return LZ4_compressBound(COMPRESS_BLOCK_SIZE);
+    }
+#endif
+#ifdef CUCKOO_HAVE_ZSTD
+    if (codec == CompressCodec::ZSTD) {
+        return ZSTD_compressBound(COMPRESS_BLOCK_SIZE);
+    }
+#endif
+    return COMPRESS_BLOCK_SIZE;
+}
+
+/* the size compressed into dst, 0 if it failed */
+static size_t CompressBlock(CompressCodec codec, const char *src, size_t srcSize, char *dst, size_t dstCapacity)
+{
+#ifdef CUCKOO_HAVE_LZ4
+    if (codec == CompressCodec::LZ4) {
+        int size = LZ4_compress_default(src, dst, static_cast<int>(srcSize), static_cast<int>(dstCapacity));
+        return size > 0 ? size : 0;
+    }
+#endif
+#ifdef CUCKOO_HAVE_ZSTD
+    if (codec == CompressCodec::ZSTD) {
+        ZSTD_CCtx *context = ZstdCompressContext();
+        if (context == nullptr) {
+            return 0;
+        }
+        size_t size = ZSTD_compressCCtx(context, dst, dstCapacity, src, srcSize, COMPRESS_ZSTD_LEVEL);
+        return ZSTD_isError(size) ? 0 : size;
+    }
+#endif
+    return 0;
+}
+
+/* true if src decompressed to exactly dstSize bytes */
+static bool DecompressBlock(CompressCodec codec, const char *src, size_t srcSize, char *dst, size_t dstSize)
+{
+#ifdef CUCKOO_HAVE_LZ4
+    if (codec == CompressCodec::LZ4) {
+        int size = LZ4_decompress_safe(src, dst, static_cast<int>(srcSize), static_cast<int>(dstSize));
+        return size == static_cast<int>(dstSize);
+    }
+#endif
+#ifdef CUCKOO_HAVE_ZSTD
+    if (codec == CompressCodec::ZSTD) {
+        ZSTD_DCtx *context = ZstdDecompressContext();
+        if (context == nullptr) {
+            return false;
+        }
+        size_t size = ZSTD_decompressDCtx(context, dst, dstSize, src, srcSize);
+        return !ZSTD_isError(size) && size == dstSize;
+    }
+#endif
+    return false;
+}
+
+static int CompressTo(int fd, int dstFd, CompressCodec codec, const struct stat &st, uint64_t &compressedSize)
+{
+    uint64_t rawSize = st.st_size;
+    auto in = std::make_unique<char[]>(COMPRESS_BATCH_BLOCKS * COMPRESS_BLOCK_SIZE);
+    size_t bound = CompressBound(codec);
+    auto out = std::make_unique<char[]>(bound);
+    std::vector<CompressedBlock> blocks;
+    blocks.reserve(BlockNum(rawSize));
+    uint64_t written = 0;
+    for (uint64_t offset = 0; offset < rawSize;) {
+        size_t batchSize = std::min<uint64_t>(COMPRESS_BATCH_BLOCKS * COMPRESS_BLOCK_SIZE, rawSize - offset);
+        int ret = ReadAll(fd, in.get(), batchSize, offset);
+        if (ret != 0) {
+            /* truncated while read */
+            return ret == -EIO ? -EAGAIN : ret;
+        }
+        for (size_t pos = 0; pos < batchSize; pos += COMPRESS_BLOCK_SIZE) {
+            size_t blockSize = std::min<size_t>(COMPRESS_BLOCK_SIZE, batchSize - pos);
+            const char *data = in.get() + pos;
+            CompressedBlock block{.offset = written, .size = 0, .crc = Crc32c(0, data, blockSize)};
+            size_t size = CompressBlock(codec, data, blockSize, out.get(), bound);
+            if (size > 0 && size < blockSize) {
+                data = out.get();
+            } else {
+                size = blockSize;
+            }
+            ret = WriteAll(dstFd, data, size);
+            if (ret != 0) {
+                return ret;
+            }
+            block.size = size;
+            blocks.push_back(block);
+            written += size;
+        }
+        offset += batchSize;
+    }
+    struct stat after;
+    if (fstat(fd, &after) != 0) {
+        return -errno;
+    }
+    if (!SameFile(st, after)) {
+        return -EAGAIN;
+    }
+
+    CompressTrailer trailer;
+    memset(&trailer, 0, sizeof(trailer));
+    trailer.rawSize = rawSize;
+    trailer.blockNum = blocks.size();
+    trailer.blockSize = COMPRESS_BLOCK_SIZE;
+    trailer.magic = COMPRESS_MAGIC;
+    trailer.codec = static_cast<uint8_t>(codec);
+    size_t indexSize = blocks.size() * sizeof(CompressedBlock);
+    uint32_t crc = Crc32c(0, blocks.data(), indexSize);
+    trailer.crc = Crc32c(crc, &trailer, offsetof(CompressTrailer, crc));
+    int ret = WriteAll(dstFd, reinterpret_cast<const char *>(blocks.data()), indexSize);
+    if (ret == 0) {
+        ret = WriteAll(dstFd, reinterpret_cast<const char *>(&trailer), sizeof(trailer));
+    }
+    /* the plain file is dropped once this is in place, it has to survive a crash by then */
+    if (ret == 0 && fdatasync(dstFd) != 0) {
+        ret = -errno;
+    }
+    compressedSize = written + indexSize + sizeof(trailer);
+    return ret;
+}
+
+int CompressFile(int fd, const std::string &dstName, CompressCodec codec, uint64_t &compressedSize)
+{
+    if (!CompressCodecAvailable(codec)) {
+        return -EINVAL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return -errno;
+    }
+    int dstFd = open(dstName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0755);
+    if (dstFd < 0) {
+        return -errno;
+    }
+    int ret = CompressTo(fd, dstFd, codec, st, compressedSize);
+    close(dstFd);
+    if (ret != 0) {
+        unlink(dstName.c_str());
+    }
+    return ret;
+}
+
+int ParseCompressedTail(const char *tail, uint64_t tailSize, uint64_t fileSize, CompressedIndex &index,
+                        uint64_t &neededSize)
+{
+    CompressTrailer trailer;
+    if (fileSize < sizeof(trailer) || tailSize < sizeof(trailer) || tailSize > fileSize) {
+        return -EBADMSG;
+    }
+    memcpy(&trailer, tail + tailSize - sizeof(trailer), sizeof(trailer));
+    uint64_t indexSize = trailer.blockNum * sizeof(CompressedBlock);
+    if (trailer.magic != COMPRESS_MAGIC || trailer.blockSize != COMPRESS_BLOCK_SIZE ||
+        !CompressCodecAvailable(static_cast<CompressCodec>(trailer.codec)) ||
+        trailer.blockNum != BlockNum(trailer.rawSize) || indexSize > fileSize - sizeof(trailer)) {
+        return -EBADMSG;
+    }
+    neededSize = indexSize + sizeof(trailer);
+    if (tailSize < neededSize) {
+        return -ERANGE;
+    }
+    uint64_t indexOffset = fileSize - neededSize;
+    std::vector<CompressedBlock> blocks(trailer.blockNum);
+    memcpy(blocks.data(), tail + tailSize - neededSize, indexSize);
+    uint32_t crc = Crc32c(0, blocks.data(), indexSize);
+    if (Crc32c(crc, &trailer, offsetof(CompressTrailer, crc)) != trailer.crc) {
+        return -EBADMSG;
+    }
+    index.codec = static_cast<CompressCodec>(trailer.codec);
+    index.rawSize = trailer.rawSize;
+    index.blocks = std::move(blocks);
+    for (uint64_t block = 0; block < index.blocks.size(); ++block) {
+        const CompressedBlock &stored = index.blocks[block];
+        if (stored.size == 0 || stored.size > BlockLength(index, block) || stored.offset > indexOffset ||
+            stored.size > indexOffset - stored.offset) {
+            return -EBADMSG;
+        }
+    }
+    return 0;
+}
+
+int LoadCompressedIndex(int fd, CompressedIndex &index)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return -errno;
+    }
+    uint64_t fileSize = st.st_size;
+    /* the trailer first, it says how long the index before it is */
+    uint64_t tailSize = std::min<uint64_t>(fileSize, sizeof(CompressTrailer));
+    std::vector<char> tail(tailSize);
+    if (ReadAll(fd, tail.data(), tailSize, fileSize - tailSize) != 0) {
+        return -EBADMSG;
+    }
+    int ret = ParseCompressedTail(tail.data(), tailSize, fileSize, index, tailSize);
+    if (ret != -ERANGE) {
+        return ret;
+    }
+    tail.resize(tailSize);
+    if (ReadAll(fd, tail.data(), tailSize, fileSize - tailSize) != 0) {
+        return -EBADMSG;
+    }
+    return ParseCompressedTail(tail.data(), tailSize, fileSize, index, tailSize);
+}
+
+/* the block of blockLength bytes stored at src into dst, which may be src for a block stored as is */
+static bool DecodeBlock(const CompressedIndex &index, uint64_t block, const char *src, char *dst)
+{
+    const CompressedBlock &location = index.blocks[block];
+    size_t blockLength = BlockLength(index, block);
+    if (location.size == blockLength) {
+        if (dst != src) {
+            memcpy(dst, src, blockLength);
+        }
+    } else if (!DecompressBlock(index.codec, src, location.size, dst, blockLength)) {
+        return false;
+    }
+    return Crc32c(0, dst, blockLength) == location.crc;
+}
+
+ssize_t ReadCompressed(int fd, const CompressedIndex &index, char *buf, uint64_t offset, size_t size)
+{
+    if (offset >= index.rawSize) {
+        return 0;
+    }
+    uint64_t end = offset + std::min<uint64_t>(size, index.rawSize - offset);
+    thread_local std::vector<char> stored;
+    thread_local std::vector<char> decompressed;
+    for (uint64_t pos = offset; pos < end;) {
+        uint64_t block = pos / COMPRESS_BLOCK_SIZE;
+        uint64_t blockStart = block * COMPRESS_BLOCK_SIZE;
+        size_t blockLength = BlockLength(index, block);
+        const CompressedBlock &location = index.blocks[block];
+        /* a block read whole goes straight to buf, else through a block of its own */
+        bool whole = pos == blockStart && end >= blockStart + blockLength;
+        char *dst = buf + (pos - offset);
+        if (!whole) {
+            decompressed.resize(COMPRESS_BLOCK_SIZE);
+            dst = decompressed.data();
+        }
+        char *src = dst;
+        if (location.size != blockLength) {
+            stored.resize(CompressBound(index.codec));
+            src = stored.data();
+        }
+        if (ReadAll(fd, src, location.size, location.offset) != 0 ||
+            !DecodeBlock(index, block, src, dst)) {
+            return -EIO;
+        }
+        uint64_t copyEnd = std::min<uint64_t>(end, blockStart + blockLength);
+        if (!whole) {
+            memcpy(buf + (pos - offset), dst + (pos - blockStart), copyEnd - pos);
+        }
+        pos = copyEnd;
+    }
+    return static_cast<ssize_t>(end - offset);
+}
+
+void StoredRange(const CompressedIndex &index, uint64_t offset, uint64_t size, uint64_t &storedOffset,
+                 uint64_t &storedSize)
+{
+    storedOffset = 0;
+    storedSize = 0;
+    if (offset >= index.rawSize || size == 0) {
+        return;
+    }
+    uint64_t end = offset + std::min<uint64_t>(size, index.rawSize - offset);
+    const CompressedBlock &first = index.blocks[offset / COMPRESS_BLOCK_SIZE];
+    const CompressedBlock &last = index.blocks[(end - 1) / COMPRESS_BLOCK_SIZE];
+    storedOffset = first.offset;
+    storedSize = last.offset + last.size - first.offset;
+}
+
+ssize_t DecompressRange(const CompressedIndex &index, const char *stored, uint64_t storedOffset, char *buf,
+                        uint64_t offset, size_t size)
+{
+    if (offset >= index.rawSize) {
+        return 0;
+    }
+    uint64_t end = offset + std::min<uint64_t>(size, index.rawSize - offset);
+    thread_local std::vector<char> decompressed;
+    for (uint64_t pos = offset; pos < end;) {
+        uint64_t block = pos / COMPRESS_BLOCK_SIZE;
+        uint64_t blockStart = block * COMPRESS_BLOCK_SIZE;
+        size_t blockLength = BlockLength(index, block);
+        bool whole = pos == blockStart && end >= blockStart + blockLength;
+        char *dst = buf + (pos - offset);
+        if (!whole) {
+            decompressed.resize(COMPRESS_BLOCK_SIZE);
+            dst = decompressed.data();
+        }
+        if (index.blocks[block].offset < storedOffset ||
+            !DecodeBlock(index, block, stored + (index.blocks[block].offset - storedOffset), dst)) {
+            return -EIO;
+        }
+        uint64_t copyEnd = std::min<uint64_t>(end, blockStart + blockLength);
+        if (!whole) {
+            memcpy(buf + (pos - offset), dst + (pos - blockStart), copyEnd - pos);
+        }
+        pos = copyEnd;
+    }
+    return static_cast<ssize_t>(end - offset);
+}
+
+int DecompressFile(int fd, const CompressedIndex &index, const std::string &dstName)
+{
+    int dstFd = open(dstName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0755);
+    if (dstFd < 0) {
+        return -errno;
+    }
+    auto buf = std::make_unique<char[]>(COMPRESS_BATCH_BLOCKS * COMPRESS_BLOCK_SIZE);
+    int ret = 0;
+    for (uint64_t offset = 0; ret == 0 && offset < index.rawSize;) {
+        ssize_t readSize = ReadCompressed(fd, index, buf.get(), offset, COMPRESS_BATCH_BLOCKS * COMPRESS_BLOCK_SIZE);
+        if (readSize <= 0) {
+            ret = readSize < 0 ? static_cast<int>(readSize) : -EIO;
+            break;
+        }
+        ret = WriteAll(dstFd, buf.get(), readSize);
+        offset += readSize;
+    }
+    if (ret == 0 && fdatasync(dstFd) != 0) {
+        ret = -errno;
+    }
+    close(dstFd);
+    if (ret != 0) {
+        unlink(dstName.c_str());
+    }
+    return ret;
+}
+
+static bool ParseCodec(const std::string &name, CompressCodec &codec)
+{
+    if (name == "lz4") {
+        codec = CompressCodec::LZ4;
+    } else if (name == "zstd") {
+        codec = CompressCodec::ZSTD;
+    } else if (name == "none") {
+        codec = CompressCodec::NONE;
+        return true;
+    } else {
+        return false;
+    }
+    /* a codec the store was built without is refused, not silently left plain */
+    return CompressCodecAvailable(codec);
+}
+
+int CompressRules::Parse(const std::string &spec)
+{
+    std::vector<std::pair<std::string, CompressCodec>> parsed;
+    for (size_t begin = 0; begin < spec.size();) {
+        size_t end = std::min(spec.find(',', begin), spec.size());
+        std::string rule = spec.substr(begin, end - begin);
+        begin = end + 1;
+        if (rule.empty()) {
+            continue;
+        }
+        size_t colon = rule.rfind(':');
+        CompressCodec codec = CompressCodec::NONE;
+        if (colon == std::string::npos || rule[0] != '/' || !ParseCodec(rule.substr(colon + 1), codec)) {
+            return -EINVAL;
+        }
+        std::string prefix = rule.substr(0, colon);
+        while (prefix.size() > 1 && prefix.back() == '/') {
+            prefix.pop_back();
+        }
+        parsed.emplace_back(std::move(prefix), codec);
+    }
+    rules = std::move(parsed);
+    return 0;
+}
+
+CompressCodec CompressRules::Match(const std::string &path) const
+{
+    size_t longest = 0;
+    CompressCodec codec = CompressCodec::NONE;
+    for (const auto &[prefix, ruleCodec] : rules) {
+        bool under = prefix == "/" || (path.starts_with(prefix) &&
+                                       (path.size() == prefix.size() || path[prefix.size()] == '/'));
+        if (under && prefix.size() >= longest) {
+            longest = prefix.size();
+            codec = ruleCodec;
+        }
+    }
+    return codec;
+}
+
+void FrozenFiles::Mark(uint64_t inodeId, CompressCodec codec)
+{
+    std::lock_guard<std::mutex> lock(candidateMutex);
+    if (codec == CompressCodec::NONE) {
+        inodeIdToCodecMap.erase(inodeId);
+    } else {
+        inodeIdToCodecMap[inodeId] = codec;
+    }
+}
+
+void FrozenFiles::Forget(uint64_t inodeId)
+{
+    std::lock_guard<std::mutex> lock(candidateMutex);
+    inodeIdToCodecMap.erase(inodeId);
+}
+
+std::vector<std::pair<uint64_t, CompressCodec>> FrozenFiles::Candidates()
+{
+    std::lock_guard<std::mutex> lock(candidateMutex);
+    return {inodeIdToCodecMap.begin(), inodeIdToCodecMap.end()};
+}
+
+FrozenFiles::Shard &FrozenFiles::ShardOf(int fd)
+{
+    uint64_t hash = static_cast<uint64_t>(fd) * 0x9E3779B97F4A7C15ULL;
+    return shards[(hash >> 32) % COMPRESS_SHARD_NUM];
+}
+
+void FrozenFiles::Open(int fd, std::shared_ptr<const CompressedIndex> index)
+{
+    Shard &shard = ShardOf(fd);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.fdToIndexMap.insert_or_assign(fd, std::move(index)).second) {
+        ++openNum;
+    }
+}
+
+std::shared_ptr<const CompressedIndex> FrozenFiles::Find(int fd)
+{
+    if (openNum.load(std::memory_order_relaxed) == 0) {
+        return nullptr;
+    }
+    Shard &shard = ShardOf(fd);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.fdToIndexMap.find(fd);
+    return it == shard.fdToIndexMap.end() ? nullptr : it->second;
+}
+
+void FrozenFiles::Close(int fd)
+{
+    if (openNum.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    Shard &shard = ShardOf(fd);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.fdToIndexMap.erase(fd) > 0) {
+        --openNum;
+    }
+}
+
+void FrozenFiles::SetDamaged(uint64_t inodeId)
+{
+    std::lock_guard<std::mutex> lock(candidateMutex);
+    if (damaged.insert(inodeId).second) {
+        ++damagedNum;
+    }
+}
+
+bool FrozenFiles::TakeDamaged(uint64_t inodeId)
+{
+    if (damagedNum.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(candidateMutex);
+    if (damaged.erase(inodeId) == 0) {
+        return false;
+    }
+    --damagedNum;
+    return true;
+}
+
+void FrozenFiles::AddFrozen(uint64_t rawSize, uint64_t compressedSize)
+{
+    ++frozenNum;
+    savedBytes += rawSize - compressedSize;
+}
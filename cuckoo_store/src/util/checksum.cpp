@@ -0,0 +1,379 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "util/checksum.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/stat.h>
+
+#include "util/crc32c.h"
+
+#define CHECKSUM_MAGIC 0x53434b43U
+/* blocks read at once to compute the checksums of a file */
+#define CHECKSUM_COMPUTE_BLOCKS 16
+/* blocks are read aligned, so that the same fd works for files opened with O_DIRECT */
+#define CHECKSUM_READ_ALIGN 4096
+
+/* a sidecar is the header, the crcs of the blocks and the crc32c of both */
+struct ChecksumFileHeader
+{
+    uint32_t magic;
+    uint32_t blockSize;
+    uint64_t ino;
+    uint64_t size;
+    int64_t mtimeNs;
+};
+
+static uint64_t BlockNum(uint64_t size) { return (size + CHECKSUM_BLOCK_SIZE - 1) / CHECKSUM_BLOCK_SIZE; }
+
+static int StatOf(int fd, FileChecksums &sums)
+{
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        return -errno;
+    }
+    sums.ino = st.st_ino;
+    sums.size = st.st_size;
+    sums.mtimeNs = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return 0;
+}
+
+static bool SameFile(const FileChecksums &a, const FileChecksums &b)
+{
+    return a.ino == b.ino && a.size == b.size && a.mtimeNs == b.mtimeNs;
+}
+
+static std::string SidecarPath(const std::string &fileName) { return fileName + CHECKSUM_SUFFIX; }
+
+static std::unique_ptr<char, decltype(&free)> AllocBlocks(size_t blocks)
+{
+    return {static_cast<char *>(aligned_alloc(CHECKSUM_READ_ALIGN, blocks * CHECKSUM_BLOCK_SIZE)), free};
+}
+
+int ComputeChecksums(int fd, FileChecksums &sums)
+{
+    int ret = StatOf(fd, sums);
+    if (ret != 0) {
+        return ret;
+    }
+    auto buf = AllocBlocks(CHECKSUM_COMPUTE_BLOCKS);
+    if (buf == nullptr) {
+        return -ENOMEM;
+    }
+    sums.crcs.clear();
+    sums.crcs.reserve(BlockNum(sums.size));
+    for (uint64_t offset = 0; offset < sums.size;) {
+        ssize_t readSize = pread(fd, buf.get(), CHECKSUM_COMPUTE_BLOCKS * CHECKSUM_BLOCK_SIZE, offset);
+        if (readSize < 0) {
+            return -errno;
+        }
+        if (readSize == 0) {
+            return -EAGAIN;
+        }
+        uint64_t end = std::min<uint64_t>(offset + readSize, sums.size);
+        for (uint64_t pos = offset; pos < end; pos += CHECKSUM_BLOCK_SIZE) {
+            size_t blockSize = std::min<uint64_t>(CHECKSUM_BLOCK_SIZE, sums.size - pos);
+            if (pos + blockSize > end) {
+                /* a short read ends in the middle of a block, read it again */
+                end = pos;
+                break;
+            }
+            sums.crcs.push_back(Crc32c(0, buf.get() + (pos - offset), blockSize));
+        }
+        if (end == offset) {
+            /* truncated while read */
+            return -EAGAIN;
+        }
+        offset = end;
+    }
+    FileChecksums after;
+    ret = StatOf(fd, after);
+    if (ret != 0) {
+        return ret;
+    }
+    return SameFile(sums, after) ? 0 : -EAGAIN;
+}
+
+int SaveChecksums(const std::string &fileName, const FileChecksums &sums)
+{
+    ChecksumFileHeader header{.magic = CHECKSUM_MAGIC,
+                              .blockSize = CHECKSUM_BLOCK_SIZE,
+                              .ino = sums.ino,
+                              .size = sums.size,
+                              .mtimeNs = sums.mtimeNs};
+    size_t crcSize = sums.crcs.size() * sizeof(uint32_t);
+    std::string data(sizeof(header) + crcSize + sizeof(uint32_t), '\0');
+    memcpy(data.data(), &header, sizeof(header));
+    memcpy(data.data() + sizeof(header), sums.crcs.data(), crcSize);
+    uint32_t crc = Crc32c(0, data.data(), sizeof(header) + crcSize);
+    memcpy(data.data() + sizeof(header) + crcSize, &crc, sizeof(crc));
+
+    /* written aside and renamed over, a reader never sees half a sidecar */
+    std::string sidecar = SidecarPath(fileName);
+    std::string tmpName = sidecar + ".tmp";
+    int fd = open(tmpName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -errno;
+    }
+    ssize_t writeSize = write(fd, data.data(), data.size());
+    int ret = writeSize == static_cast<ssize_t>(data.size()) ? 0 : (writeSize < 0 ? -errno : -EIO);
+    close(fd);
+    if (ret == 0 && rename(tmpName.c_str(), sidecar.c_str()) != 0) {
+        ret = -errno;
+    }
+    if (ret != 0) {
+        unlink(tmpName.c_str());
+    }
+    return ret;
+}
+
+int LoadChecksums(const std::string &fileName, FileChecksums &sums)
+{
+    int fd = open(SidecarPath(fileName).c_str(), O_RDONLY);
+    if (fd < 0) {
+        return -errno;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        return -err;
+    }
+    std::string data(st.st_size, '\0');
+    ssize_t readSize = pread(fd, data.data(), data.size(), 0);
+    close(fd);
+    if (readSize != static_cast<ssize_t>(data.size()) || data.size() < sizeof(ChecksumFileHeader) + sizeof(uint32_t)) {
+        return -EBADMSG;
+    }
+    ChecksumFileHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+    size_t crcSize = BlockNum(header.size) * sizeof(uint32_t);
+    if (header.magic != CHECKSUM_MAGIC || header.blockSize != CHECKSUM_BLOCK_SIZE ||
+        data.size() != sizeof(header) + crcSize + sizeof(uint32_t)) {
+        return -EBADMSG;
+    }
+    uint32_t crc = 0;
+    memcpy(&crc, data.data() + sizeof(header) + crcSize, sizeof(crc));
+    if (crc != Crc32c(0, data.data(), sizeof(header) + crcSize)) {
+        return -EBADMSG;
+    }
+    sums.ino = header.ino;
+    sums.size = header.size;
+    sums.mtimeNs = header.mtimeNs;
+    sums.crcs.resize(crcSize / sizeof(uint32_t));
+    memcpy(sums.crcs.data(), data.data() + sizeof(header), crcSize);
+    return 0;
+}
+
+ChecksumTable::Entry::Entry(FileChecksums checksums, bool valid)
+    : sums(std::move(checksums)),
+      valid(valid),
+      verified(std::make_unique<std::atomic<bool>[]>(valid ? sums.crcs.size() : 0))
+{
+}
+
+void ChecksumTable::Start(std::function<std::string(uint64_t)> path)
+{
+    cacheFilePath = std::move(path);
+    started = true;
+}
+
+ChecksumTable::Shard &ChecksumTable::ShardOf(uint64_t inodeId)
+{
+    uint64_t hash = inodeId * 0x9E3779B97F4A7C15ULL;
+    return shards[(hash >> 32) % CHECKSUM_SHARD_NUM];
+}
+
+int ChecksumTable::Seal(uint64_t inodeId)
+{
+    if (!started) {
+        return 0;
+    }
+    std::string fileName = cacheFilePath(inodeId);
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return -errno;
+    }
+    FileChecksums sums;
+    int ret = ComputeChecksums(fd, sums);
+    close(fd);
+    if (ret == 0) {
+        ret = SaveChecksums(fileName, sums);
+    }
+    if (ret != 0) {
+        return ret;
+    }
+    auto entry = std::make_shared<Entry>(std::move(sums), true);
+    Shard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.inodeIdToEntryMap[inodeId] = entry;
+    return 0;
+}
+
+bool ChecksumTable::QueueSeal(uint64_t inodeId)
+{
+    if (!started) {
+        return false;
+    }
+    Shard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.sealQueued.insert(inodeId).second;
+}
+
+void ChecksumTable::TakeSeal(uint64_t inodeId)
+{
+    Shard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.sealQueued.erase(inodeId);
+}
+
+std::shared_ptr<ChecksumTable::Entry> ChecksumTable::Lookup(uint64_t inodeId)
+{
+    Shard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.inodeIdToEntryMap.find(inodeId);
+    return it == shard.inodeIdToEntryMap.end() ? nullptr : it->second;
+}
+
+std::shared_ptr<ChecksumTable::Entry> ChecksumTable::Current(uint64_t inodeId, int fd)
+{
+    /* a seal replaces the entry whenever the file is complete again, the file is not looked at on every read */
+    std::shared_ptr<Entry> entry = Lookup(inodeId);
+    if (entry != nullptr) {
+        return entry;
+    }
+    FileChecksums now;
+    if (StatOf(fd, now) != 0) {
+        return nullptr;
+    }
+    /* a sidecar of another content of the file is of no use, the file is remembered as unchecked */
+    FileChecksums sums;
+    bool valid = LoadChecksums(cacheFilePath(inodeId), sums) == 0 && SameFile(sums, now);
+    entry = std::make_shared<Entry>(valid ? std::move(sums) : std::move(now), valid);
+    /* a seal meanwhile is newer */
+    Shard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.inodeIdToEntryMap.emplace(inodeId, entry).first->second;
+}
+
+int ChecksumTable::Mismatch(int fd, Entry &entry)
+{
+    /* written while read, the checksums are just old */
+    FileChecksums now;
+    if (StatOf(fd, now) != 0 || !SameFile(entry.sums, now)) {
+        return 0;
+    }
+    entry.corrupt = true;
+    ++mismatchNum;
+    return -EIO;
+}
+
+int ChecksumTable::Check(uint64_t inodeId, int fd, const char *buf, uint64_t offset, uint64_t size)
+{
+    if (!started || size == 0) {
+        return 0;
+    }
+    std::shared_ptr<Entry> entry = Current(inodeId, fd);
+    if (entry == nullptr || !entry->valid) {
+        return 0;
+    }
+    const FileChecksums &sums = entry->sums;
+    uint64_t end = std::min(offset + size, sums.size);
+    std::unique_ptr<char, decltype(&free)> blockBuf(nullptr, free);
+    for (uint64_t block = offset / CHECKSUM_BLOCK_SIZE; block * CHECKSUM_BLOCK_SIZE < end; ++block) {
+        uint64_t blockStart = block * CHECKSUM_BLOCK_SIZE;
+        uint64_t blockSize = std::min<uint64_t>(CHECKSUM_BLOCK_SIZE, sums.size - blockStart);
+        uint32_t crc = 0;
+        if (buf != nullptr && blockStart >= offset && blockStart + blockSize <= end) {
+            crc = Crc32c(0, buf + (blockStart - offset), blockSize);
+        } else if (entry->verified[block]) {
+            continue;
+        } else {
+            if (blockBuf == nullptr) {
+                blockBuf = AllocBlocks(1);
+                if (blockBuf == nullptr) {
+                    return -ENOMEM;
+                }
+            }
+            ssize_t readSize = pread(fd, blockBuf.get(), CHECKSUM_BLOCK_SIZE, blockStart);
+            if (readSize < 0) {
+                return -errno;
+            }
+            if (static_cast<uint64_t>(readSize) < blockSize) {
+                /* truncated while read */
+                return Mismatch(fd, *entry);
+            }
+            crc = Crc32c(0, blockBuf.get(), blockSize);
+        }
+        if (crc != sums.crcs[block]) {
+            return Mismatch(fd, *entry);
+        }
+        entry->verified[block] = true;
+    }
+    return 0;
+}
+
+int ChecksumTable::Verify(uint64_t inodeId, int fd, const char *buf, uint64_t offset, uint64_t size)
+{
+    return Check(inodeId, fd, buf, offset, size);
+}
+
+int ChecksumTable::VerifyRange(uint64_t inodeId, int fd, uint64_t offset, uint64_t size)
+{
+    return Check(inodeId, fd, nullptr, offset, size);
+}
+
+bool ChecksumTable::Verified(uint64_t inodeId, int fd, uint64_t offset, uint64_t size)
+{
+    if (!started || size == 0) {
+        return true;
+    }
+    std::shared_ptr<Entry> entry = Current(inodeId, fd);
+    if (entry == nullptr || !entry->valid) {
+        return true;
+    }
+    uint64_t end = std::min(offset + size, entry->sums.size);
+    for (uint64_t block = offset / CHECKSUM_BLOCK_SIZE; block * CHECKSUM_BLOCK_SIZE < end; ++block) {
+        if (!entry->verified[block]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ChecksumTable::Corrupt(uint64_t inodeId)
+{
+    std::shared_ptr<Entry> entry = Lookup(inodeId);
+    return entry != nullptr && entry->corrupt;
+}
+
+void ChecksumTable::Remove(uint64_t inodeId)
+{
+    if (!started) {
+        return;
+    }
+    {
+        Shard &shard = ShardOf(inodeId);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.inodeIdToEntryMap.erase(inodeId);
+        shard.sealQueued.erase(inodeId);
+    }
+    unlink(SidecarPath(cacheFilePath(inodeId)).c_str());
+}
+
+size_t ChecksumTable::Size()
+{
+    size_t size = 0;
+    for (Shard &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size += shard.inodeIdToEntryMap.size();
+    }
+    return size;
+}
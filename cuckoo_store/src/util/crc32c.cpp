@@ -0,0 +1,221 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "util/crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#endif
+
+#define CRC32C_POLY 0x82f63b78U
+/* the instructions take 3 cycles but start one a cycle, so three stripes of this many bytes run at once */
+#define CRC32C_LONG 8192
+#define CRC32C_SHORT 256
+
+using Crc32cFunc = uint32_t (*)(uint32_t crc, const uint8_t *next, size_t size);
+
+/* a crc32c operator per byte of the crc, see Crc32cShift */
+using Crc32cShiftTable = uint32_t[4][256];
+
+struct Crc32cTables
+{
+    uint32_t bytes[256];
+    /* append CRC32C_LONG or CRC32C_SHORT zero bytes to a crc */
+    Crc32cShiftTable longShift;
+    Crc32cShiftTable shortShift;
+};
+
+static uint32_t Gf2MatrixTimes(const uint32_t *mat, uint32_t vec)
+{
+    uint32_t sum = 0;
+    while (vec != 0) {
+        if ((vec & 1) != 0) {
+            sum ^= *mat;
+        }
+        vec >>= 1;
+        ++mat;
+    }
+    return sum;
+}
+
+static void Gf2MatrixSquare(uint32_t *square, const uint32_t *mat)
+{
+    for (int n = 0; n < 32; ++n) {
+        square[n] = Gf2MatrixTimes(mat, mat[n]);
+    }
+}
+
+/* the operator appending len zero bytes to a crc, len a power of two */
+static void Crc32cZerosOp(uint32_t *even, size_t len)
+{
+    uint32_t odd[32];
+    /* one zero bit */
+    odd[0] = CRC32C_POLY;
+    uint32_t row = 1;
+    for (int n = 1; n < 32; ++n) {
+        odd[n] = row;
+        row <<= 1;
+    }
+    /* two, then four zero bits */
+    Gf2MatrixSquare(even, odd);
+    Gf2MatrixSquare(odd, even);
+    /* a byte in even first, each square doubles it */
+    do {
+        Gf2MatrixSquare(even, odd);
+        len >>= 1;
+        if (len == 0) {
+            return;
+        }
+        Gf2MatrixSquare(odd, even);
+        len >>= 1;
+    } while (len != 0);
+    memcpy(even, odd, sizeof(odd));
+}
+
+static void Crc32cZeros(Crc32cShiftTable &zeros, size_t len)
+{
+    uint32_t op[32];
+    Crc32cZerosOp(op, len);
+    for (uint32_t n = 0; n < 256; ++n) {
+        zeros[0][n] = Gf2MatrixTimes(op, n);
+        zeros[1][n] = Gf2MatrixTimes(op, n << 8);
+        zeros[2][n] = Gf2MatrixTimes(op, n << 16);
+        zeros[3][n] = Gf2MatrixTimes(op, n << 24);
+    }
+}
+
+static const Crc32cTables &GetTables()
+{
+    static const Crc32cTables *tables = []() {
+        auto *built = new Crc32cTables;
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t crc = n;
+            for (int k = 0; k < 8; ++k) {
+                crc = (crc & 1) != 0 ? (crc >> 1) ^ CRC32C_POLY : crc >> 1;
+            }
+            built->bytes[n] = crc;
+        }
+        Crc32cZeros(built->longShift, CRC32C_LONG);
+        Crc32cZeros(built->shortShift, CRC32C_SHORT);
+        return built;
+    }();
+    return *tables;
+}
+
+static uint32_t Crc32cShift(const Crc32cShiftTable &zeros, uint32_t crc)
+{
+    return zeros[0][crc & 0xff] ^ zeros[1][(crc >> 8) & 0xff] ^ zeros[2][(crc >> 16) & 0xff] ^ zeros[3][crc >> 24];
+}
+
+static uint32_t Crc32cSoftware(uint32_t crc, const uint8_t *next, size_t size)
+{
+    const uint32_t *bytes = GetTables().bytes;
+    while (size > 0) {
+        crc = bytes[(crc ^ *next++) & 0xff] ^ (crc >> 8);
+        --size;
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+#define CRC32C_TARGET __attribute__((target("sse4.2")))
+#define CRC32C_U8(crc, value) _mm_crc32_u8(crc, value)
+#define CRC32C_U64(crc, value) static_cast<uint32_t>(_mm_crc32_u64(crc, value))
+#elif defined(__aarch64__)
+#define CRC32C_TARGET __attribute__((target("+crc")))
+#define CRC32C_U8(crc, value) __crc32cb(crc, value)
+#define CRC32C_U64(crc, value) __crc32cd(crc, value)
+#endif
+
+#ifdef CRC32C_TARGET
+static inline uint64_t LoadWord(const uint8_t *next)
+{
+    uint64_t word;
+    memcpy(&word, next, sizeof(word));
+    return word;
+}
+
+/* three stripes at once, their crcs are combined by shifting over the stripes after them */
+CRC32C_TARGET static uint32_t Crc32cHardwareImpl(uint32_t crc, const uint8_t *next, size_t size)
+{
+    const Crc32cTables &tables = GetTables();
+    uint64_t crc0 = crc;
+    while (size > 0 && (reinterpret_cast<uintptr_t>(next) & 7) != 0) {
+        crc0 = CRC32C_U8(static_cast<uint32_t>(crc0), *next++);
+        --size;
+    }
+    while (size >= CRC32C_LONG * 3) {
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+        const uint8_t *end = next + CRC32C_LONG;
+        do {
+            crc0 = CRC32C_U64(static_cast<uint32_t>(crc0), LoadWord(next));
+            crc1 = CRC32C_U64(static_cast<uint32_t>(crc1), LoadWord(next + CRC32C_LONG));
+            crc2 = CRC32C_U64(static_cast<uint32_t>(crc2), LoadWord(next + CRC32C_LONG * 2));
+            next += 8;
+        } while (next < end);
+        crc0 = Crc32cShift(tables.longShift, static_cast<uint32_t>(crc0)) ^ crc1;
+        crc0 = Crc32cShift(tables.longShift, static_cast<uint32_t>(crc0)) ^ crc2;
+        next += CRC32C_LONG * 2;
+        size -= CRC32C_LONG * 3;
+    }
+    while (size >= CRC32C_SHORT * 3) {
+        uint64_t crc1 = 0;
+        uint64_t crc2 = 0;
+        const uint8_t *end = next + CRC32C_SHORT;
+        do {
+            crc0 = CRC32C_U64(static_cast<uint32_t>(crc0), LoadWord(next));
+            crc1 = CRC32C_U64(static_cast<uint32_t>(crc1), LoadWord(next + CRC32C_SHORT));
+            crc2 = CRC32C_U64(static_cast<uint32_t>(crc2), LoadWord(next + CRC32C_SHORT * 2));
+            next += 8;
+        } while (next < end);
+        crc0 = Crc32cShift(tables.shortShift, static_cast<uint32_t>(crc0)) ^ crc1;
+        crc0 = Crc32cShift(tables.shortShift, static_cast<uint32_t>(crc0)) ^ crc2;
+        next += CRC32C_SHORT * 2;
+        size -= CRC32C_SHORT * 3;
+    }
+    while (size >= 8) {
+        crc0 = CRC32C_U64(static_cast<uint32_t>(crc0), LoadWord(next));
+        next += 8;
+        size -= 8;
+    }
+    while (size > 0) {
+        crc0 = CRC32C_U8(static_cast<uint32_t>(crc0), *next++);
+        --size;
+    }
+    return static_cast<uint32_t>(crc0);
+}
+#endif
+
+static Crc32cFunc SelectCrc32c()
+{
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("sse4.2")) {
+        return Crc32cHardwareImpl;
+    }
+#elif defined(__aarch64__)
+    if ((getauxval(AT_HWCAP) & HWCAP_CRC32) != 0) {
+        return Crc32cHardwareImpl;
+    }
+#endif
+    return Crc32cSoftware;
+}
+
+static Crc32cFunc GetCrc32cFunc()
+{
+    static const Crc32cFunc func = SelectCrc32c();
+    return func;
+}
+
+uint32_t Crc32c(uint32_t crc, const void *data, size_t size)
+{
+    return ~GetCrc32cFunc()(~crc, static_cast<const uint8_t *>(data), size);
+}
+
+bool Crc32cHardware() { return GetCrc32cFunc() != Crc32cSoftware; }
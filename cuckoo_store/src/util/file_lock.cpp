@@ -4,33 +4,57 @@
 
 #include "util/file_lock.h"
 
-#include "log/logging.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+
+FileLock::FileLockShard &FileLock::ShardOf(uint64_t inodeId)
+{
+    /* inode ids are sequential, spread neighbours over the shards */
+    uint64_t hash = inodeId * 0x9E3779B97F4A7C15ULL;
+    return shards[(hash >> 32) % FILE_LOCK_SHARD_NUM];
+}
+
+void FileLock::EraseIfUnused(FileLockShard &shard, uint64_t inodeId, FileLockState &state)
+{
+    if (state.lockCount != 0 || state.waitingThreads != 0) {
+        return;
+    }
+    for (auto &ranges : state.ranges) {
+        if (!ranges.Empty()) {
+            return;
+        }
+    }
+    shard.inodeIdTofileLockStateMap.erase(inodeId);
+}
 
 void FileLock::ReleaseFileLock(uint64_t inodeId, LockMode m)
 {
-    std::unique_lock<std::shared_mutex> lock(mutex);
-    if (inodeIdTofileLockStateMap.find(inodeId) == inodeIdTofileLockStateMap.end()) {
+    FileLockShard &shard = ShardOf(inodeId);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    auto it = shard.inodeIdTofileLockStateMap.find(inodeId);
+    if (it == shard.inodeIdTofileLockStateMap.end()) {
         return;
     }
     /* file is locked, exists in map */
-    std::shared_ptr<std::condition_variable_any> cv = inodeIdTofileLockStateMap[inodeId].cv;
+    FileLockState &state = it->second;
     bool toNotify = false;
     if (m == LockMode::S) {
-        if (--inodeIdTofileLockStateMap[inodeId].lockCount == 0) {
+        if (--state.lockCount == 0) {
             toNotify = true;
         }
     } else {
-        if (++inodeIdTofileLockStateMap[inodeId].lockCount == 0) {
+        if (++state.lockCount == 0) {
             toNotify = true;
         }
     }
     if (toNotify) {
-        if (inodeIdTofileLockStateMap[inodeId].waitingThreads == 0) {
+        if (state.waitingThreads == 0) {
             /* no one is currently waiting for this lock, able to erase */
-            inodeIdTofileLockStateMap.erase(inodeId);
+            EraseIfUnused(shard, inodeId, state);
         } else {
             /* wake up all waiting for this lock, may be slocks */
-            cv->notify_all();
+            state.cv.notify_all();
         }
     }
 }
@@ -43,42 +67,27 @@ void FileLock::WaitGetFileLock(uint64_t inodeId, LockMode m) { innerGetFileLock(
 
 bool FileLock::innerGetFileLock(uint64_t inodeId, LockMode m, bool wait)
 {
-    std::unique_lock<std::shared_mutex> lock(mutex);
-
-    /* do not insert */
-    int lockCnt = 0;
-    if (inodeIdTofileLockStateMap.count(inodeId) != 0) {
-        lockCnt = inodeIdTofileLockStateMap[inodeId].lockCount;
-    }
+    FileLockShard &shard = ShardOf(inodeId);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    /* the state stays in map while someone waits on it */
+    FileLockState &state = shard.inodeIdTofileLockStateMap[inodeId];
 
-    if (lockCnt == 0) {
+    if (state.lockCount == 0) {
         /* not locked */
-        if (inodeIdTofileLockStateMap[inodeId].waitingThreads == 0) {
-            /* no one is waiting, create cv */
-            inodeIdTofileLockStateMap[inodeId].cv = std::make_shared<std::condition_variable_any>();
-        }
-        inodeIdTofileLockStateMap[inodeId].lockCount = static_cast<int>(m);
-    } else if (lockCnt > 0 && m == LockMode::S) {
-        /* slocked, do not create new cv */
-        inodeIdTofileLockStateMap[inodeId].lockCount++;
+        state.lockCount = static_cast<int>(m);
+    } else if (state.lockCount > 0 && m == LockMode::S) {
+        /* slocked */
+        state.lockCount++;
     } else if (wait) {
         /* xlocked, slocked before xlock, same cv for this inode */
-        std::shared_ptr<std::condition_variable_any> cv = inodeIdTofileLockStateMap[inodeId].cv;
-        if (cv == nullptr) {
-            CUCKOO_LOG(LOG_ERROR) << "innerGetFileLock(): cv == nullptr for inode Id " << inodeId;
-            return false;
-        }
-        /* increment lockWait */
-        ++inodeIdTofileLockStateMap[inodeId].waitingThreads;
+        ++state.waitingThreads;
         if (m == LockMode::X) {
-            cv->wait(lock, [this, inodeId]() { return inodeIdTofileLockStateMap[inodeId].lockCount == 0; });
+            state.cv.wait(lock, [&state]() { return state.lockCount == 0; });
         } else {
-            cv->wait(lock, [this, inodeId]() { return inodeIdTofileLockStateMap[inodeId].lockCount >= 0; });
+            state.cv.wait(lock, [&state]() { return state.lockCount >= 0; });
         }
-        /* decrement lockWait */
-        --inodeIdTofileLockStateMap[inodeId].waitingThreads;
-        /* change lockCnt */
-        inodeIdTofileLockStateMap[inodeId].lockCount += static_cast<int>(m);
+        --state.waitingThreads;
+        state.lockCount += static_cast<int>(m);
     } else {
         /* try get lock failed */
         return false;
@@ -88,13 +97,184 @@ bool FileLock::innerGetFileLock(uint64_t inodeId, LockMode m, bool wait)
 
 bool FileLock::TestLocked(uint64_t inodeId, LockMode m)
 {
-    std::shared_lock<std::shared_mutex> lock(mutex);
+    FileLockShard &shard = ShardOf(inodeId);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    auto it = shard.inodeIdTofileLockStateMap.find(inodeId);
+    if (it == shard.inodeIdTofileLockStateMap.end()) {
+        return false;
+    }
     if (m == LockMode::X) {
-        /* no any lock, and no one waiting */
-        return inodeIdTofileLockStateMap.count(inodeId) != 0;
+        /* any lock, or someone waiting */
+        return it->second.lockCount != 0 || it->second.waitingThreads != 0;
+    }
+    /* xLocked */
+    return it->second.lockCount < 0;
+}
+
+/* -------------- byte range locks ------------------- */
+
+bool FileLock::FindRangeConflict(IntervalTree<RangeLockHolder> &ranges, const RangeLock &rangeLock, RangeLock *conflict)
+{
+    bool found = false;
+    ranges.ForEachOverlap(rangeLock.start, rangeLock.end, [&](const auto &interval) {
+        const RangeLockHolder &holder = interval.value;
+        if (holder.SameOwner(rangeLock) || (holder.mode == LockMode::S && rangeLock.mode == LockMode::S)) {
+            return true;
+        }
+        found = true;
+        if (conflict != nullptr) {
+            *conflict = RangeLock{interval.start, interval.end, holder.mode, holder.owner, holder.nodeId, holder.pid};
+        }
+        return false;
+    });
+    return found;
+}
+
+/* drop what the owner holds in [start, end), then lock it in the mode of rangeLock unless to unlock */
+void FileLock::ReplaceOwnerRange(IntervalTree<RangeLockHolder> &ranges, const RangeLock &rangeLock, bool unlock)
+{
+    uint64_t start = rangeLock.start;
+    uint64_t end = rangeLock.end;
+    /* also take the adjacent ranges, so ranges of the same mode merge */
+    uint64_t adjacentStart = start > 0 ? start - 1 : 0;
+    uint64_t adjacentEnd = end < RANGE_LOCK_EOF ? end + 1 : end;
+    auto owned = ranges.Extract(adjacentStart, adjacentEnd, [&rangeLock](const auto &interval) {
+        return interval.value.SameOwner(rangeLock);
+    });
+
+    uint64_t newStart = start;
+    uint64_t newEnd = end;
+    for (auto &interval : owned) {
+        if (!unlock && interval.value.mode == rangeLock.mode) {
+            newStart = std::min(newStart, interval.start);
+            newEnd = std::max(newEnd, interval.end);
+            continue;
+        }
+        /* keep the parts outside [start, end) */
+        if (interval.start < start) {
+            ranges.Insert(interval.start, std::min(interval.end, start), interval.value);
+        }
+        if (interval.end > end) {
+            ranges.Insert(std::max(interval.start, end), interval.end, interval.value);
+        }
+    }
+    if (!unlock) {
+        ranges.Insert(newStart, newEnd, RangeLockHolder{rangeLock.mode, rangeLock.owner, rangeLock.nodeId, rangeLock.pid});
+    }
+}
+
+bool FileLock::BlockOn(const RangeLock &rangeLock, const RangeLock &conflict)
+{
+    LockOwner waiter{rangeLock.owner, rangeLock.nodeId};
+    std::lock_guard<std::mutex> lock(blockedMutex);
+    /* follow the owners the holder waits for, each owner waits for one lock at a time */
+    LockOwner holder{conflict.owner, conflict.nodeId};
+    for (size_t hops = 0; hops <= blockedOn.size(); ++hops) {
+        if (holder == waiter) {
+            return false;
+        }
+        auto it = blockedOn.find(holder);
+        if (it == blockedOn.end()) {
+            break;
+        }
+        holder = it->second;
+    }
+    blockedOn[waiter] = LockOwner{conflict.owner, conflict.nodeId};
+    return true;
+}
+
+void FileLock::Unblock(const RangeLock &rangeLock)
+{
+    std::lock_guard<std::mutex> lock(blockedMutex);
+    blockedOn.erase(LockOwner{rangeLock.owner, rangeLock.nodeId});
+}
+
+int FileLock::SetRangeLock(uint64_t inodeId,
+                           const RangeLock &rangeLock,
+                           bool wait,
+                           RangeLockType type,
+                           const std::function<bool()> &interrupted)
+{
+    if (rangeLock.start >= rangeLock.end) {
+        return -EINVAL;
+    }
+    FileLockShard &shard = ShardOf(inodeId);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    FileLockState &state = shard.inodeIdTofileLockStateMap[inodeId];
+    auto &ranges = state.ranges[static_cast<int>(type)];
+
+    RangeLock conflict;
+    if (FindRangeConflict(ranges, rangeLock, &conflict)) {
+        if (!wait) {
+            EraseIfUnused(shard, inodeId, state);
+            return -EAGAIN;
+        }
+        /* deadlocks are reported for fcntl locks only, as the kernel does */
+        bool detect = type == RangeLockType::POSIX;
+        int ret = 0;
+        ++state.waitingThreads;
+        do {
+            /* the conflicting owner may change between wakeups */
+            if (detect && !BlockOn(rangeLock, conflict)) {
+                ret = -EDEADLK;
+                break;
+            }
+            if (interrupted == nullptr) {
+                state.cv.wait(lock);
+            } else if (state.cv.wait_for(lock, std::chrono::milliseconds(RANGE_LOCK_INTERRUPT_CHECK_MS)) ==
+                           std::cv_status::timeout &&
+                       interrupted()) {
+                ret = -EINTR;
+                break;
+            }
+        } while (FindRangeConflict(ranges, rangeLock, &conflict));
+        if (detect) {
+            Unblock(rangeLock);
+        }
+        --state.waitingThreads;
+        if (ret != 0) {
+            EraseIfUnused(shard, inodeId, state);
+            return ret;
+        }
+    }
+
+    ReplaceOwnerRange(ranges, rangeLock, false);
+    if (state.waitingThreads != 0) {
+        /* a downgrade from X to S may let others in */
+        state.cv.notify_all();
+    }
+    return 0;
+}
+
+void FileLock::ReleaseRangeLock(uint64_t inodeId, const RangeLock &rangeLock, RangeLockType type)
+{
+    FileLockShard &shard = ShardOf(inodeId);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    auto it = shard.inodeIdTofileLockStateMap.find(inodeId);
+    if (it == shard.inodeIdTofileLockStateMap.end() || rangeLock.start >= rangeLock.end) {
+        return;
+    }
+    FileLockState &state = it->second;
+    ReplaceOwnerRange(state.ranges[static_cast<int>(type)], rangeLock, true);
+    if (state.waitingThreads != 0) {
+        state.cv.notify_all();
+    } else {
+        EraseIfUnused(shard, inodeId, state);
+    }
+}
+
+bool FileLock::GetRangeLockConflict(uint64_t inodeId,
+                                    const RangeLock &rangeLock,
+                                    RangeLock &conflict,
+                                    RangeLockType type)
+{
+    FileLockShard &shard = ShardOf(inodeId);
+    std::unique_lock<std::mutex> lock(shard.mutex);
+    auto it = shard.inodeIdTofileLockStateMap.find(inodeId);
+    if (it == shard.inodeIdTofileLockStateMap.end()) {
+        return false;
     }
-    /* no any lock, or xLocked */
-    return inodeIdTofileLockStateMap.count(inodeId) != 0 && inodeIdTofileLockStateMap[inodeId].lockCount < 0;
+    return FindRangeConflict(it->second.ranges[static_cast<int>(type)], rangeLock, &conflict);
 }
 
 /* -------------- locker class ------------------- */
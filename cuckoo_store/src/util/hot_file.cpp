@@ -0,0 +1,170 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "util/hot_file.h"
+
+#include <algorithm>
+#include <chrono>
+
+HotFileTracker::HotFileTracker()
+{
+    /* versions keep growing across restarts, so copies made before never look current */
+    auto now = std::chrono::system_clock::now().time_since_epoch();
+    nextVersion = std::chrono::duration_cast<std::chrono::microseconds>(now).count();
+}
+
+HotFileTracker::HotFileShard &HotFileTracker::ShardOf(uint64_t inodeId)
+{
+    uint64_t hash = inodeId * 0x9E3779B97F4A7C15ULL;
+    return shards[(hash >> 32) % HOT_FILE_SHARD_NUM];
+}
+
+HotFileReplicas HotFileTracker::Cool(HotFileState &state)
+{
+    HotFileReplicas replicas;
+    if (state.hot) {
+        state.hot = false;
+        --hotNum;
+        replicas = std::move(state.replicas);
+        state.replicas = HotFileReplicas();
+    }
+    return replicas;
+}
+
+void HotFileTracker::Sweep(HotFileShard &shard, uint64_t nowMs)
+{
+    auto &states = shard.inodeIdToStateMap;
+    for (auto it = states.begin(); it != states.end();) {
+        HotFileState &state = it->second;
+        if (state.writers == 0 && nowMs - state.lastRead >= HOT_FILE_IDLE_WINDOWS * HOT_FILE_WINDOW_MS) {
+            Cool(state);
+            it = states.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    /* do not sweep on every read when most files are busy */
+    shard.sweepSize = std::max<size_t>(HOT_FILE_SWEEP_SIZE, states.size() * 2);
+}
+
+bool HotFileTracker::RecordRead(uint64_t inodeId, uint64_t nowMs)
+{
+    uint64_t limit = threshold.load();
+    if (limit == 0) {
+        return false;
+    }
+    HotFileShard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (shard.inodeIdToStateMap.size() >= shard.sweepSize) {
+        Sweep(shard, nowMs);
+    }
+    HotFileState &state = shard.inodeIdToStateMap[inodeId];
+    if (nowMs - state.windowStart >= HOT_FILE_WINDOW_MS) {
+        /* a window passed since the last one started, with few reads, or none for a whole window */
+        bool quiet = state.reads < limit / HOT_FILE_COOL_DIVISOR || nowMs - state.windowStart >= 2 * HOT_FILE_WINDOW_MS;
+        if (quiet) {
+            Cool(state);
+        }
+        state.windowStart = nowMs;
+        state.reads = 0;
+    }
+    state.lastRead = nowMs;
+    if (++state.reads >= limit && !state.hot && state.writers == 0) {
+        state.hot = true;
+        ++hotNum;
+        return true;
+    }
+    return false;
+}
+
+uint64_t HotFileTracker::SetReplicas(uint64_t inodeId, const std::vector<int> &nodeIds)
+{
+    HotFileShard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.inodeIdToStateMap.find(inodeId);
+    if (it == shard.inodeIdToStateMap.end() || !it->second.hot) {
+        return 0;
+    }
+    it->second.replicas = HotFileReplicas{nextVersion++, nodeIds};
+    return it->second.replicas.version;
+}
+
+HotFileReplicas HotFileTracker::GetReplicas(uint64_t inodeId)
+{
+    HotFileShard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.inodeIdToStateMap.find(inodeId);
+    if (it == shard.inodeIdToStateMap.end() || !it->second.hot) {
+        return HotFileReplicas();
+    }
+    return it->second.replicas;
+}
+
+HotFileReplicas HotFileTracker::Invalidate(uint64_t inodeId)
+{
+    HotFileShard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.inodeIdToStateMap.find(inodeId);
+    if (it == shard.inodeIdToStateMap.end()) {
+        return HotFileReplicas();
+    }
+    return Cool(it->second);
+}
+
+HotFileReplicas HotFileTracker::BeginWrite(uint64_t inodeId)
+{
+    HotFileShard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    HotFileState &state = shard.inodeIdToStateMap[inodeId];
+    ++state.writers;
+    return Cool(state);
+}
+
+void HotFileTracker::EndWrite(uint64_t inodeId)
+{
+    HotFileShard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.inodeIdToStateMap.find(inodeId);
+    if (it != shard.inodeIdToStateMap.end() && it->second.writers > 0) {
+        --it->second.writers;
+    }
+}
+
+/* -------------- replica copies ------------------- */
+
+bool ReplicaCopies::Has(uint64_t inodeId, uint64_t version)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = inodeIdToVersionMap.find(inodeId);
+    return it != inodeIdToVersionMap.end() && it->second == version;
+}
+
+bool ReplicaCopies::Contains(uint64_t inodeId)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return inodeIdToVersionMap.count(inodeId) != 0;
+}
+
+void ReplicaCopies::Set(uint64_t inodeId, uint64_t version)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    inodeIdToVersionMap[inodeId] = version;
+}
+
+bool ReplicaCopies::Drop(uint64_t inodeId, uint64_t version)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = inodeIdToVersionMap.find(inodeId);
+    if (it == inodeIdToVersionMap.end() || it->second > version) {
+        return false;
+    }
+    inodeIdToVersionMap.erase(it);
+    return true;
+}
+
+size_t ReplicaCopies::Size()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return inodeIdToVersionMap.size();
+}
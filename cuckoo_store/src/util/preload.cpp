@@ -0,0 +1,88 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "util/preload.h"
+
+#include <algorithm>
+
+bool PreloadPins::Pin(uint64_t inodeId, uint64_t deadlineMs)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = inodeIdToDeadlineMap.find(inodeId);
+    if (it == inodeIdToDeadlineMap.end()) {
+        inodeIdToDeadlineMap.emplace(inodeId, deadlineToInodeIdMap.emplace(deadlineMs, inodeId));
+        return true;
+    }
+    if (it->second->first < deadlineMs) {
+        deadlineToInodeIdMap.erase(it->second);
+        it->second = deadlineToInodeIdMap.emplace(deadlineMs, inodeId);
+    }
+    return false;
+}
+
+std::vector<uint64_t> PreloadPins::TakeExpired(uint64_t nowMs)
+{
+    std::vector<uint64_t> inodeIds;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto end = deadlineToInodeIdMap.upper_bound(nowMs);
+    for (auto it = deadlineToInodeIdMap.begin(); it != end; ++it) {
+        inodeIds.push_back(it->second);
+        inodeIdToDeadlineMap.erase(it->second);
+    }
+    deadlineToInodeIdMap.erase(deadlineToInodeIdMap.begin(), end);
+    return inodeIds;
+}
+
+bool PreloadPins::Release(uint64_t inodeId)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = inodeIdToDeadlineMap.find(inodeId);
+    if (it == inodeIdToDeadlineMap.end()) {
+        return false;
+    }
+    deadlineToInodeIdMap.erase(it->second);
+    inodeIdToDeadlineMap.erase(it);
+    return true;
+}
+
+size_t PreloadPins::Size()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return inodeIdToDeadlineMap.size();
+}
+
+/* -------------- token bucket ------------------- */
+
+TokenBucket::TokenBucket(uint64_t ratePerSec)
+    : rate(ratePerSec),
+      tokens(static_cast<int64_t>(ratePerSec))
+{
+}
+
+uint64_t TokenBucket::Take(uint64_t size, uint64_t nowMs)
+{
+    if (rate == 0) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (lastMs == 0) {
+        lastMs = nowMs;
+    }
+    if (nowMs > lastMs) {
+        /* no more than the time to fill the bucket counts, so the product below can not overflow */
+        uint64_t fillMs = (static_cast<uint64_t>(static_cast<int64_t>(rate) - tokens) * 1000 + rate - 1) / rate;
+        uint64_t refill = std::min(nowMs - lastMs, fillMs) * rate / 1000;
+        tokens = std::min<int64_t>(tokens + static_cast<int64_t>(refill), static_cast<int64_t>(rate));
+        /* keep the fraction of a token not refilled yet for the next take */
+        lastMs += refill * 1000 / rate;
+        if (tokens == static_cast<int64_t>(rate)) {
+            lastMs = nowMs;
+        }
+    }
+    if (tokens < 0) {
+        return (static_cast<uint64_t>(-tokens) * 1000 + rate - 1) / rate;
+    }
+    tokens -= static_cast<int64_t>(size);
+    return 0;
+}
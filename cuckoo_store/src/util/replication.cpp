@@ -0,0 +1,225 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#include "util/replication.h"
+
+#include <algorithm>
+#include <iterator>
+
+ReplicationLog::ReplicationShard &ReplicationLog::ShardOf(uint64_t inodeId)
+{
+    uint64_t hash = inodeId * 0x9E3779B97F4A7C15ULL;
+    return shards[(hash >> 32) % REPLICATION_SHARD_NUM];
+}
+
+void ReplicationLog::SetFull(ReplicationState &state)
+{
+    state.full = true;
+    state.dirty = true;
+    state.ranges.clear();
+}
+
+void ReplicationLog::MarkDirty(uint64_t inodeId, uint64_t offset, uint64_t size)
+{
+    ReplicationShard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ReplicationState &state = shard.inodeIdToStateMap[inodeId];
+    state.dirty = true;
+    if (state.full || size == 0) {
+        /* a resize ships with the size sent at the end of every sync */
+        return;
+    }
+    uint64_t start = offset;
+    uint64_t end = offset + size;
+    auto it = state.ranges.upper_bound(start);
+    if (it != state.ranges.begin() && std::prev(it)->second >= start) {
+        --it;
+        start = it->first;
+    }
+    /* merge the ranges overlapping or touching [start, end) */
+    while (it != state.ranges.end() && it->first <= end) {
+        end = std::max(end, it->second);
+        it = state.ranges.erase(it);
+    }
+    state.ranges.emplace(start, end);
+    if (state.ranges.size() > REPLICATION_MAX_RANGES) {
+        SetFull(state);
+    }
+}
+
+void ReplicationLog::MarkFull(uint64_t inodeId)
+{
+    ReplicationShard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    SetFull(shard.inodeIdToStateMap[inodeId]);
+}
+
+bool ReplicationLog::Pending(uint64_t inodeId)
+{
+    ReplicationShard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.inodeIdToStateMap.find(inodeId);
+    return it != shard.inodeIdToStateMap.end() && it->second.dirty;
+}
+
+std::optional<BackupWork> ReplicationLog::Take(uint64_t inodeId, int backupNodeId)
+{
+    ReplicationShard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.inodeIdToStateMap.find(inodeId);
+    if (it == shard.inodeIdToStateMap.end()) {
+        /* not written since this node started */
+        return std::nullopt;
+    }
+    ReplicationState &state = it->second;
+    BackupWork work;
+    work.full = state.full || state.backupNodeId != backupNodeId;
+    if (!work.full && !state.dirty) {
+        return std::nullopt;
+    }
+    if (!work.full) {
+        work.ranges.assign(state.ranges.begin(), state.ranges.end());
+    }
+    /* changes from now on go to the next sync */
+    state.ranges.clear();
+    state.dirty = false;
+    state.full = false;
+    return work;
+}
+
+void ReplicationLog::Done(uint64_t inodeId, int backupNodeId)
+{
+    ReplicationShard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.inodeIdToStateMap.find(inodeId);
+    if (it != shard.inodeIdToStateMap.end()) {
+        it->second.backupNodeId = backupNodeId;
+    }
+}
+
+void ReplicationLog::Fail(uint64_t inodeId)
+{
+    ReplicationShard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.inodeIdToStateMap.find(inodeId);
+    if (it != shard.inodeIdToStateMap.end()) {
+        SetFull(it->second);
+    }
+}
+
+void ReplicationLog::Forget(uint64_t inodeId)
+{
+    ReplicationShard &shard = ShardOf(inodeId);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.inodeIdToStateMap.erase(inodeId);
+}
+
+std::vector<uint64_t> ReplicationLog::TakeMoved(const std::function<int(uint64_t)> &backupOf)
+{
+    std::vector<uint64_t> inodeIds;
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (auto &[inodeId, state] : shard.inodeIdToStateMap) {
+            if (state.backupNodeId != backupOf(inodeId)) {
+                SetFull(state);
+                inodeIds.push_back(inodeId);
+            }
+        }
+    }
+    return inodeIds;
+}
+
+size_t ReplicationLog::Size()
+{
+    size_t size = 0;
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size += shard.inodeIdToStateMap.size();
+    }
+    return size;
+}
+
+/* -------------- backup copies ------------------- */
+
+void BackupCopies::BeginFill(uint64_t inodeId, int primaryNodeId)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    inodeIdToCopyMap[inodeId] = BackupCopy{primaryNodeId, CopyState::FILLING};
+}
+
+bool BackupCopies::BeginChange(uint64_t inodeId, int primaryNodeId)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = inodeIdToCopyMap.find(inodeId);
+    if (it == inodeIdToCopyMap.end() || it->second.primaryNodeId != primaryNodeId ||
+        it->second.state == CopyState::PROMOTED) {
+        return false;
+    }
+    it->second.state = CopyState::FILLING;
+    return true;
+}
+
+bool BackupCopies::Accepts(uint64_t inodeId, int primaryNodeId)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = inodeIdToCopyMap.find(inodeId);
+    return it != inodeIdToCopyMap.end() && it->second.primaryNodeId == primaryNodeId &&
+           it->second.state != CopyState::PROMOTED;
+}
+
+void BackupCopies::Complete(uint64_t inodeId, int primaryNodeId)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = inodeIdToCopyMap.find(inodeId);
+    if (it != inodeIdToCopyMap.end() && it->second.primaryNodeId == primaryNodeId &&
+        it->second.state == CopyState::FILLING) {
+        it->second.state = CopyState::COMPLETE;
+    }
+}
+
+bool BackupCopies::Current(uint64_t inodeId)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = inodeIdToCopyMap.find(inodeId);
+    return it != inodeIdToCopyMap.end() && it->second.state != CopyState::FILLING;
+}
+
+bool BackupCopies::Contains(uint64_t inodeId)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return inodeIdToCopyMap.contains(inodeId);
+}
+
+std::vector<uint64_t> BackupCopies::Promote(int primaryNodeId)
+{
+    std::vector<uint64_t> inodeIds;
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = inodeIdToCopyMap.begin(); it != inodeIdToCopyMap.end();) {
+        if (it->second.primaryNodeId != primaryNodeId) {
+            ++it;
+        } else if (it->second.state == CopyState::COMPLETE) {
+            it->second.state = CopyState::PROMOTED;
+            inodeIds.push_back(it->first);
+            ++it;
+        } else if (it->second.state == CopyState::FILLING) {
+            /* a half filled copy is of no use */
+            it = inodeIdToCopyMap.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    return inodeIds;
+}
+
+void BackupCopies::Erase(uint64_t inodeId)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    inodeIdToCopyMap.erase(inodeId);
+}
+
+size_t BackupCopies::Size()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return inodeIdToCopyMap.size();
+}
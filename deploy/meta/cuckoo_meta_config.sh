@@ -2,7 +2,7 @@
 localIp='127.0.0.1'
 cnIp='127.0.0.1'
 workerIpList=('127.0.0.1')
-workerNumList=(1)
+workerNumList=(${CUCKOO_WORKER_NUM:-1})
 
 workspace=$HOME
 cnPathPrefix=$workspace/metadata/coordinator
@@ -0,0 +1,439 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+#ifndef CUCKOO_REMOTE_CONNECTION_DEF_CUCKOO_TRACE_H
+#define CUCKOO_REMOTE_CONNECTION_DEF_CUCKOO_TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sampled request tracing shared by client, store and metadata server.
+ *
+ * A request is sampled once at its root (the fuse handler), the trace context then travels with it
+ * in MetaRequest, the brpc_io requests and the param block header in the connection pool shmem.
+ * Every process records finished spans of sampled requests into a ring, which is dumped as
+ * Chrome trace json (chrome://tracing, ui.perfetto.dev). Timestamps are wall clock so the dumps
+ * of several processes can be merged into one timeline.
+ *
+ * A request that is not sampled carries an all zero context, beginning a span for it only
+ * checks the trace id of the context.
+ *
+ * The current context is bthread local, so it follows a request handled in a bthread when the bthread
+ * moves between workers, and plain threads get a slot of their own the same way.
+ */
+
+#define CUCKOO_TRACE_NAME_LEN               32
+#define CUCKOO_TRACE_DEFAULT_CAPACITY       16384
+
+typedef struct CuckooTraceContext
+{
+    uint64_t traceId;   // 0 if the request is not sampled
+    uint64_t spanId;    // span the next span is a child of
+} CuckooTraceContext;
+
+typedef struct CuckooTraceSpan
+{
+    CuckooTraceContext context;     // context of this span, pass it on to children
+    CuckooTraceContext saved;       // current context of the thread before this span
+    uint64_t parentSpanId;
+    int64_t startNs;
+    const char* name;
+} CuckooTraceSpan;
+
+typedef struct CuckooTraceEvent
+{
+    uint64_t seq;       // index of the event + 1 once written, 0 while it is being written
+    uint64_t traceId;
+    uint64_t spanId;
+    uint64_t parentSpanId;
+    int64_t startNs;
+    int64_t durationNs;
+    int32_t pid;
+    int32_t tid;
+    char name[CUCKOO_TRACE_NAME_LEN];
+} CuckooTraceEvent;
+
+typedef struct CuckooTraceRing
+{
+    uint64_t next;
+    uint64_t capacity;
+    CuckooTraceEvent events[];
+} CuckooTraceRing;
+
+static inline bool CuckooTraceSampled(CuckooTraceContext context) { return context.traceId != 0; }
+
+/* fraction of root spans that start a trace, 0 disables tracing */
+void CuckooTraceSetSampleRate(double rate);
+double CuckooTraceGetSampleRate(void);
+/* name of the process in the dump */
+void CuckooTraceSetProcessName(const char* name);
+
+size_t CuckooTraceRingSize(uint64_t capacity);
+void CuckooTraceRingInit(CuckooTraceRing* ring, uint64_t capacity);
+/* record into ring instead of the process local one, e.g. a ring in shmem shared by processes */
+void CuckooTraceAttachRing(CuckooTraceRing* ring);
+
+int64_t CuckooTraceNowNs(void);
+
+/* context of the span running on this bthread or thread */
+CuckooTraceContext CuckooTraceGetContext(void);
+void CuckooTraceSetContext(CuckooTraceContext context);
+
+/* starts a new trace with the sample rate */
+void CuckooTraceBeginRoot(CuckooTraceSpan* span, const char* name);
+/* child of the current context of the thread */
+void CuckooTraceBegin(CuckooTraceSpan* span, const char* name);
+/* child of a context received from another process */
+void CuckooTraceBeginWithParent(CuckooTraceSpan* span, const char* name, CuckooTraceContext parent);
+/* records the span and restores the context the thread had when it began */
+void CuckooTraceEnd(CuckooTraceSpan* span);
+/* records a span measured by the caller, e.g. the time a request waited in a queue */
+void CuckooTraceRecord(CuckooTraceContext parent, const char* name, int64_t startNs, int64_t endNs);
+
+/* writes the recorded spans as Chrome trace json, returns the number of spans written */
+int CuckooTraceDump(FILE* file);
+/* same as CuckooTraceDump into a malloc'ed buffer, the caller frees it */
+char* CuckooTraceDumpToMemory(size_t* size);
+
+#ifdef CUCKOO_REMOTE_CONNECTION_DEF_CUCKOO_TRACE_IMPLEMENT
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include <bthread/bthread.h>
+
+static uint64_t CuckooTraceSampleThreshold = 0;
+static bool CuckooTraceSampleAll = false;
+static double CuckooTraceSampleRate = 0;
+static char CuckooTraceProcessName[CUCKOO_TRACE_NAME_LEN] = "cuckoo";
+static CuckooTraceRing* CuckooTraceCurrentRing = NULL;
+
+static pthread_once_t CuckooTraceContextKeyOnce = PTHREAD_ONCE_INIT;
+static bthread_key_t CuckooTraceContextKey;
+static bool CuckooTraceContextKeyValid = false;
+
+// random state and tid belong to the worker thread, not to the bthread running on it
+static __thread uint64_t CuckooTraceRandomState = 0;
+static __thread int32_t CuckooTraceThreadId = 0;
+
+void CuckooTraceSetSampleRate(double rate)
+{
+    if (rate <= 0)
+        rate = 0;
+    if (rate >= 1)
+        rate = 1;
+    CuckooTraceSampleRate = rate;
+    CuckooTraceSampleAll = rate >= 1;
+    // 2^64 does not fit, rate 1 is handled by CuckooTraceSampleAll
+    CuckooTraceSampleThreshold = CuckooTraceSampleAll ? UINT64_MAX : (uint64_t)(rate * 18446744073709551615.0);
+}
+
+double CuckooTraceGetSampleRate(void) { return CuckooTraceSampleRate; }
+
+void CuckooTraceSetProcessName(const char* name)
+{
+    strncpy(CuckooTraceProcessName, name, CUCKOO_TRACE_NAME_LEN - 1);
+    CuckooTraceProcessName[CUCKOO_TRACE_NAME_LEN - 1] = '\0';
+}
+
+size_t CuckooTraceRingSize(uint64_t capacity)
+{
+    return sizeof(CuckooTraceRing) + capacity * sizeof(CuckooTraceEvent);
+}
+
+void CuckooTraceRingInit(CuckooTraceRing* ring, uint64_t capacity)
+{
+    memset(ring, 0, CuckooTraceRingSize(capacity));
+    ring->capacity = capacity;
+}
+
+void CuckooTraceAttachRing(CuckooTraceRing* ring)
+{
+    __atomic_store_n(&CuckooTraceCurrentRing, ring, __ATOMIC_RELEASE);
+}
+
+static CuckooTraceRing* CuckooTraceGetRing(void)
+{
+    CuckooTraceRing* ring = __atomic_load_n(&CuckooTraceCurrentRing, __ATOMIC_ACQUIRE);
+    if (ring)
+        return ring;
+    CuckooTraceRing* local = (CuckooTraceRing*)malloc(CuckooTraceRingSize(CUCKOO_TRACE_DEFAULT_CAPACITY));
+    if (!local)
+        return NULL;
+    CuckooTraceRingInit(local, CUCKOO_TRACE_DEFAULT_CAPACITY);
+    if (!__atomic_compare_exchange_n(&CuckooTraceCurrentRing, &ring, local, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+    {
+        free(local);
+        return ring;
+    }
+    return local;
+}
+
+int64_t CuckooTraceNowNs(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+// xorshift64*, seeded per thread, never returns 0
+static uint64_t CuckooTraceRandom(void)
+{
+    uint64_t x = CuckooTraceRandomState;
+    if (x == 0)
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        x = ((uint64_t)ts.tv_nsec << 32) ^ (uint64_t)ts.tv_sec ^ ((uint64_t)getpid() << 16) ^
+            (uint64_t)(uintptr_t)&CuckooTraceRandomState;
+        if (x == 0)
+            x = 0x9E3779B97F4A7C15ULL;
+    }
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    CuckooTraceRandomState = x;
+    uint64_t value = x * 0x2545F4914F6CDD1DULL;
+    return value ? value : 1;
+}
+
+static void CuckooTraceCreateContextKey(void)
+{
+    CuckooTraceContextKeyValid = bthread_key_create(&CuckooTraceContextKey, free) == 0;
+}
+
+// slot of the calling bthread, allocated on first use only if create is set
+static CuckooTraceContext* CuckooTraceLocalContext(bool create)
+{
+    pthread_once(&CuckooTraceContextKeyOnce, CuckooTraceCreateContextKey);
+    if (!CuckooTraceContextKeyValid)
+        return NULL;
+    CuckooTraceContext* context = (CuckooTraceContext*)bthread_getspecific(CuckooTraceContextKey);
+    if (context || !create)
+        return context;
+    context = (CuckooTraceContext*)calloc(1, sizeof(CuckooTraceContext));
+    if (context && bthread_setspecific(CuckooTraceContextKey, context) != 0)
+    {
+        free(context);
+        return NULL;
+    }
+    return context;
+}
+
+CuckooTraceContext CuckooTraceGetContext(void)
+{
+    CuckooTraceContext* local = CuckooTraceLocalContext(false);
+    if (!local)
+    {
+        CuckooTraceContext none = {0, 0};
+        return none;
+    }
+    return *local;
+}
+
+void CuckooTraceSetContext(CuckooTraceContext context)
+{
+    // a missing slot already reads as not sampled
+    CuckooTraceContext* local = CuckooTraceLocalContext(CuckooTraceSampled(context));
+    if (local)
+        *local = context;
+}
+
+static void CuckooTraceStart(CuckooTraceSpan* span, const char* name, CuckooTraceContext parent)
+{
+    span->saved = CuckooTraceGetContext();
+    if (!CuckooTraceSampled(parent))
+    {
+        // an unsampled request must not inherit a sampled context left on the thread
+        span->context = parent;
+        CuckooTraceSetContext(parent);
+        return;
+    }
+    span->name = name;
+    span->parentSpanId = parent.spanId;
+    span->context.traceId = parent.traceId;
+    span->context.spanId = CuckooTraceRandom();
+    span->startNs = CuckooTraceNowNs();
+    CuckooTraceSetContext(span->context);
+}
+
+void CuckooTraceBeginRoot(CuckooTraceSpan* span, const char* name)
+{
+    CuckooTraceContext parent = {0, 0};
+    if (CuckooTraceSampleThreshold != 0 && (CuckooTraceSampleAll || CuckooTraceRandom() < CuckooTraceSampleThreshold))
+        parent.traceId = CuckooTraceRandom();
+    CuckooTraceStart(span, name, parent);
+}
+
+void CuckooTraceBegin(CuckooTraceSpan* span, const char* name)
+{
+    CuckooTraceStart(span, name, CuckooTraceGetContext());
+}
+
+void CuckooTraceBeginWithParent(CuckooTraceSpan* span, const char* name, CuckooTraceContext parent)
+{
+    CuckooTraceStart(span, name, parent);
+}
+
+static void CuckooTraceWrite(uint64_t traceId, uint64_t spanId, uint64_t parentSpanId, const char* name,
+                             int64_t startNs, int64_t endNs)
+{
+    CuckooTraceRing* ring = CuckooTraceGetRing();
+    if (!ring)
+        return;
+    if (CuckooTraceThreadId == 0)
+        CuckooTraceThreadId = (int32_t)syscall(SYS_gettid);
+
+    uint64_t index = __atomic_fetch_add(&ring->next, 1, __ATOMIC_RELAXED);
+    CuckooTraceEvent* event = &ring->events[index % ring->capacity];
+    __atomic_store_n(&event->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    event->traceId = traceId;
+    event->spanId = spanId;
+    event->parentSpanId = parentSpanId;
+    event->startNs = startNs;
+    event->durationNs = endNs - startNs;
+    event->pid = (int32_t)getpid();
+    event->tid = CuckooTraceThreadId;
+    strncpy(event->name, name, CUCKOO_TRACE_NAME_LEN - 1);
+    event->name[CUCKOO_TRACE_NAME_LEN - 1] = '\0';
+    __atomic_store_n(&event->seq, index + 1, __ATOMIC_RELEASE);
+}
+
+void CuckooTraceEnd(CuckooTraceSpan* span)
+{
+    CuckooTraceSetContext(span->saved);
+    if (!CuckooTraceSampled(span->context))
+        return;
+    CuckooTraceWrite(span->context.traceId, span->context.spanId, span->parentSpanId, span->name, span->startNs,
+                     CuckooTraceNowNs());
+}
+
+void CuckooTraceRecord(CuckooTraceContext parent, const char* name, int64_t startNs, int64_t endNs)
+{
+    if (!CuckooTraceSampled(parent))
+        return;
+    CuckooTraceWrite(parent.traceId, CuckooTraceRandom(), parent.spanId, name, startNs, endNs);
+}
+
+int CuckooTraceDump(FILE* file)
+{
+    CuckooTraceRing* ring = CuckooTraceGetRing();
+    fprintf(file, "{\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%d,\"args\":{\"name\":\"%s\"}}",
+            (int)getpid(), CuckooTraceProcessName);
+    if (!ring)
+    {
+        fprintf(file, "\n]}\n");
+        return 0;
+    }
+
+    uint64_t end = __atomic_load_n(&ring->next, __ATOMIC_ACQUIRE);
+    uint64_t begin = end > ring->capacity ? end - ring->capacity : 0;
+    int count = 0;
+    for (uint64_t i = begin; i < end; ++i)
+    {
+        CuckooTraceEvent* slot = &ring->events[i % ring->capacity];
+        uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq != i + 1)
+            continue;   // still being written or already overwritten
+        CuckooTraceEvent event = *slot;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq)
+            continue;
+        event.name[CUCKOO_TRACE_NAME_LEN - 1] = '\0';
+
+        // microseconds with ns precision, as chrome expects
+        fprintf(file,
+                ",\n{\"name\":\"%s\",\"cat\":\"cuckoo\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,"
+                "\"ts\":%lld.%03lld,\"dur\":%lld.%03lld,"
+                "\"args\":{\"trace_id\":\"%016llx\",\"span_id\":\"%016llx\",\"parent_id\":\"%016llx\"}}",
+                event.name, (int)event.pid, (int)event.tid,
+                (long long)(event.startNs / 1000), (long long)(event.startNs % 1000),
+                (long long)(event.durationNs / 1000), (long long)(event.durationNs % 1000),
+                (unsigned long long)event.traceId, (unsigned long long)event.spanId,
+                (unsigned long long)event.parentSpanId);
+        ++count;
+    }
+    fprintf(file, "\n]}\n");
+    return count;
+}
+
+char* CuckooTraceDumpToMemory(size_t* size)
+{
+    char* buffer = NULL;
+    FILE* file = open_memstream(&buffer, size);
+    if (!file)
+        return NULL;
+    CuckooTraceDump(file);
+    fclose(file);
+    return buffer;
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+
+/* scoped span for C++ callers */
+class CuckooTraceScope
+{
+public:
+    /* root starts a new trace with the sample rate, otherwise the span is a child of the thread context */
+    explicit CuckooTraceScope(const char* name, bool root = false)
+    {
+        if (root)
+            CuckooTraceBeginRoot(&span, name);
+        else
+            CuckooTraceBegin(&span, name);
+    }
+    CuckooTraceScope(const char* name, CuckooTraceContext parent) { CuckooTraceBeginWithParent(&span, name, parent); }
+    ~CuckooTraceScope() { CuckooTraceEnd(&span); }
+    CuckooTraceScope(const CuckooTraceScope&) = delete;
+    CuckooTraceScope& operator=(const CuckooTraceScope&) = delete;
+
+    const CuckooTraceContext& Context() const { return span.context; }
+
+private:
+    CuckooTraceSpan span;
+};
+
+/* copies a sampled context into the trace field of a protobuf request */
+template <typename Request>
+inline void CuckooTraceInject(Request& request, const CuckooTraceContext& context)
+{
+    if (!CuckooTraceSampled(context))
+        return;
+    auto* trace = request.mutable_trace();
+    trace->set_trace_id(context.traceId);
+    trace->set_span_id(context.spanId);
+    trace->set_sampled(true);
+}
+
+template <typename Request>
+inline CuckooTraceContext CuckooTraceExtract(const Request& request)
+{
+    CuckooTraceContext context = {0, 0};
+    if (request.has_trace() && request.trace().sampled())
+    {
+        context.traceId = request.trace().trace_id();
+        context.spanId = request.trace().span_id();
+    }
+    return context;
+}
+#endif
+
+#endif
@@ -37,6 +37,7 @@
     CUCKOO_ERROR_CODE(GET_ALL_WORKER_CONN_FAILED) \
     CUCKOO_ERROR_CODE(IO_ERROR)                   \
     CUCKOO_ERROR_CODE(READDIR_RENEW_CONN)         \
+    CUCKOO_ERROR_CODE(CROSS_WORKER_LINK)          \
     CUCKOO_ERROR_CODE(LAST_CUCKOO_ERROR_CODE)
 
 #undef CUCKOO_ERROR_CODE
@@ -0,0 +1,627 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+/*
+ * fio like data path benchmark linking CuckooStore directly, no metadata server is needed.
+ *
+ * Every thread works on its own large file and its own set of small files and calls CuckooStore the
+ * way the client does on open, read, write and close. With -remote the files live on a second
+ * store node forked as a child process, so every call goes through RemoteIOServiceImpl over
+ * loopback. OBS is replaced by the local storage stand-in under -dir.
+ */
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <print>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gflags/gflags.h>
+#include <json/json.h>
+
+#include "brpc/brpc_server.h"
+#include "buffer/open_instance.h"
+#include "conf/cuckoo_property_key.h"
+#include "cuckoo_store/cuckoo_store.h"
+#include "disk_cache/disk_cache.h"
+#include "init/cuckoo_init.h"
+#include "stats/latency_histogram.h"
+#include "util/utils.h"
+
+DEFINE_string(rw, "write,read,randread,randwrite,smallwrite,smallread", "comma separated jobs, run in order");
+DEFINE_int32(numjobs, 4, "number of threads, each works on its own files");
+DEFINE_uint64(bs, 128 * 1024, "size of a single read or write call");
+DEFINE_uint64(size, 64 * 1024 * 1024, "size of the large file of each thread");
+DEFINE_int32(nrfiles, 256, "number of small files of each thread");
+DEFINE_uint64(small_size, 64 * 1024, "size of a small file");
+DEFINE_bool(remote, false, "put the files on a second store node in a child process, reached over loopback");
+DEFINE_bool(persist, true, "persist files to the local storage stand-in on close");
+DEFINE_bool(evict, false, "drop the cache files before every read job so reads load from storage, local only");
+DEFINE_string(dir, "/tmp/cuckoo_fio", "directory for the node caches, the storage stand-in and the configs");
+DEFINE_int32(port, 56100, "rpc port of node 0, node 1 listens on port + 1");
+DEFINE_string(csv, "", "append the results to this csv file");
+DEFINE_string(label, "", "label of the run in the csv file, e.g. the commit");
+
+using Snapshot = LatencyHistograms::Snapshot;
+
+constexpr uint64_t INODE_BASE = 1000000;
+constexpr int LOCAL_NODE = 0;
+constexpr int REMOTE_NODE = 1;
+
+struct FileState
+{
+    uint64_t inodeId = 0;
+    std::string path;
+    uint64_t size = 0;
+    bool exists = false;
+};
+
+struct Worker
+{
+    uint64_t ops = 0;
+    uint64_t errors = 0;
+    uint64_t bytes = 0;
+    Snapshot hist{};
+    FileState large;
+    std::vector<FileState> small;
+    std::mt19937_64 rng;
+    std::vector<char> buf;
+};
+
+struct JobResult
+{
+    std::string name;
+    uint64_t ops = 0;
+    uint64_t errors = 0;
+    uint64_t bytes = 0;
+    double seconds = 0;
+    Snapshot hist{};
+};
+
+class FioTest {
+  public:
+    FioTest();
+
+    bool RunJob(const std::string &job, JobResult &result);
+    /* removes the files of all threads from the node and the storage */
+    void Cleanup();
+
+  private:
+    using JobFunc = void (FioTest::*)(Worker &worker);
+
+    /* func returns the bytes transferred or a negative error */
+    template <typename Func>
+    void Timed(Worker &worker, Func &&func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        ssize_t ret = func();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        ++worker.ops;
+        ++worker.hist[LatencyHistograms::BucketIndex(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())];
+        if (ret < 0) {
+            if (worker.errors++ == 0) {
+                std::println(stderr, "first error of thread: {}", ret);
+            }
+        } else {
+            worker.bytes += ret;
+        }
+    }
+
+    std::shared_ptr<OpenInstance> NewOpenInstance(const FileState &file, int oflags);
+    static int OpenForRead(OpenInstance *openInstance);
+    static int Close(OpenInstance *openInstance);
+    static ssize_t Write(OpenInstance *openInstance, const char *buf, size_t size, off_t offset);
+    void Evict();
+
+    void WriteLarge(Worker &worker, bool random);
+    void ReadLarge(Worker &worker, bool random);
+    void SeqWrite(Worker &worker) { WriteLarge(worker, false); }
+    void RandWrite(Worker &worker) { WriteLarge(worker, true); }
+    void SeqRead(Worker &worker) { ReadLarge(worker, false); }
+    void RandRead(Worker &worker) { ReadLarge(worker, true); }
+    void SmallWrite(Worker &worker);
+    void SmallRead(Worker &worker);
+
+    std::vector<Worker> workers;
+    int targetNode;
+};
+
+FioTest::FioTest()
+    : workers(FLAGS_numjobs),
+      targetNode(FLAGS_remote ? REMOTE_NODE : LOCAL_NODE)
+{
+    for (int t = 0; t < FLAGS_numjobs; ++t) {
+        Worker &worker = workers[t];
+        uint64_t inodeBase = INODE_BASE * (t + 1);
+        worker.large.inodeId = inodeBase;
+        worker.large.path = std::format("/cuckoo_fio/t{}/large", t);
+        worker.small.resize(FLAGS_nrfiles);
+        for (int i = 0; i < FLAGS_nrfiles; ++i) {
+            worker.small[i].inodeId = inodeBase + i + 1;
+            worker.small[i].path = std::format("/cuckoo_fio/t{}/small{}", t, i);
+        }
+        worker.rng.seed(t);
+        worker.buf.resize(std::max(FLAGS_bs, FLAGS_small_size));
+        for (size_t i = 0; i < worker.buf.size(); ++i) {
+            worker.buf[i] = static_cast<char>(worker.rng());
+        }
+    }
+}
+
+std::shared_ptr<OpenInstance> FioTest::NewOpenInstance(const FileState &file, int oflags)
+{
+    auto openInstance = std::make_shared<OpenInstance>();
+    openInstance->inodeId = file.inodeId;
+    openInstance->nodeId = targetNode;
+    openInstance->path = file.path;
+    openInstance->oflags = oflags;
+    openInstance->originalSize = file.exists ? file.size : 0;
+    openInstance->currentSize = openInstance->originalSize;
+    return openInstance;
+}
+
+/* same as CuckooOpen, a small file opened read only is read whole on open */
+int FioTest::OpenForRead(OpenInstance *openInstance)
+{
+    if (openInstance->originalSize == 0 || openInstance->originalSize >= READ_BIGFILE_SIZE) {
+        return 0;
+    }
+    openInstance->readBuffer = std::shared_ptr<char>((char *)malloc(openInstance->originalSize), free);
+    openInstance->readBufferSize = openInstance->originalSize;
+    int ret = CuckooStore::GetInstance()->ReadSmallFiles(openInstance);
+    return ret < 0 ? ret : 0;
+}
+
+int FioTest::Close(OpenInstance *openInstance)
+{
+    /* only a small file that was read never opens the physical file */
+    if (!openInstance->isOpened) {
+        return 0;
+    }
+    return CuckooStore::GetInstance()->CloseTmpFiles(openInstance, false, false);
+}
+
+ssize_t FioTest::Write(OpenInstance *openInstance, const char *buf, size_t size, off_t offset)
+{
+    int ret = CuckooStore::GetInstance()->WriteFile(openInstance, buf, size, offset);
+    return ret == 0 ? static_cast<ssize_t>(size) : -std::abs(ret);
+}
+
+void FioTest::WriteLarge(Worker &worker, bool random)
+{
+    FileState &file = worker.large;
+    auto openInstance = NewOpenInstance(file, O_WRONLY | O_CREAT);
+    uint64_t blocks = FLAGS_size / FLAGS_bs;
+    for (uint64_t i = 0; i < blocks; ++i) {
+        uint64_t block = random ? worker.rng() % blocks : i;
+        Timed(worker, [&] { return Write(openInstance.get(), worker.buf.data(), FLAGS_bs, block * FLAGS_bs); });
+    }
+    if (Close(openInstance.get()) != 0) {
+        ++worker.errors;
+    }
+    file.exists = true;
+    file.size = std::max(file.size, openInstance->currentSize.load());
+}
+
+void FioTest::ReadLarge(Worker &worker, bool random)
+{
+    FileState &file = worker.large;
+    if (!file.exists) {
+        std::println(stderr, "nothing to read, run a write job first");
+        ++worker.errors;
+        return;
+    }
+    auto openInstance = NewOpenInstance(file, O_RDONLY);
+    if (OpenForRead(openInstance.get()) != 0) {
+        ++worker.errors;
+        return;
+    }
+    uint64_t blocks = file.size / FLAGS_bs;
+    for (uint64_t i = 0; i < blocks; ++i) {
+        uint64_t block = random ? worker.rng() % blocks : i;
+        Timed(worker, [&] {
+            return static_cast<ssize_t>(CuckooStore::GetInstance()->ReadFile(openInstance.get(),
+                                                                             worker.buf.data(),
+                                                                             FLAGS_bs,
+                                                                             block * FLAGS_bs));
+        });
+    }
+    if (Close(openInstance.get()) != 0) {
+        ++worker.errors;
+    }
+}
+
+void FioTest::SmallWrite(Worker &worker)
+{
+    /* one op is create, write and close of a whole file */
+    for (auto &file : worker.small) {
+        Timed(worker, [&]() -> ssize_t {
+            auto openInstance = NewOpenInstance(file, O_WRONLY | O_CREAT);
+            for (uint64_t offset = 0; offset < FLAGS_small_size; offset += FLAGS_bs) {
+                ssize_t ret = Write(openInstance.get(),
+                                    worker.buf.data(),
+                                    std::min(FLAGS_bs, FLAGS_small_size - offset),
+                                    offset);
+                if (ret < 0) {
+                    Close(openInstance.get());
+                    return ret;
+                }
+            }
+            int ret = Close(openInstance.get());
+            if (ret != 0) {
+                return -std::abs(ret);
+            }
+            file.exists = true;
+            file.size = FLAGS_small_size;
+            return FLAGS_small_size;
+        });
+    }
+}
+
+void FioTest::SmallRead(Worker &worker)
+{
+    /* one op is open, read and close of a whole file */
+    for (auto &file : worker.small) {
+        if (!file.exists) {
+            ++worker.errors;
+            continue;
+        }
+        Timed(worker, [&]() -> ssize_t {
+            auto openInstance = NewOpenInstance(file, O_RDONLY);
+            int ret = OpenForRead(openInstance.get());
+            if (ret != 0) {
+                return ret;
+            }
+            ssize_t total = 0;
+            while (static_cast<uint64_t>(total) < file.size) {
+                int readSize = CuckooStore::GetInstance()->ReadFile(openInstance.get(),
+                                                                    worker.buf.data(),
+                                                                    std::min(FLAGS_bs, file.size - total),
+                                                                    total);
+                if (readSize <= 0) {
+                    Close(openInstance.get());
+                    return readSize < 0 ? readSize : -EIO;
+                }
+                total += readSize;
+            }
+            ret = Close(openInstance.get());
+            return ret != 0 ? -std::abs(ret) : total;
+        });
+    }
+}
+
+void FioTest::Evict()
+{
+    if (targetNode != LOCAL_NODE) {
+        return;
+    }
+    for (auto &worker : workers) {
+        DiskCache::GetInstance().Delete(worker.large.inodeId);
+        for (auto &file : worker.small) {
+            DiskCache::GetInstance().Delete(file.inodeId);
+        }
+    }
+}
+
+bool FioTest::RunJob(const std::string &job, JobResult &result)
+{
+    static const std::vector<std::pair<std::string, JobFunc>> jobFuncs = {
+        {"write", &FioTest::SeqWrite},
+        {"randwrite", &FioTest::RandWrite},
+        {"read", &FioTest::SeqRead},
+        {"randread", &FioTest::RandRead},
+        {"smallwrite", &FioTest::SmallWrite},
+        {"smallread", &FioTest::SmallRead},
+    };
+    auto it = std::find_if(jobFuncs.begin(), jobFuncs.end(), [&job](auto &entry) { return entry.first == job; });
+    if (it == jobFuncs.end()) {
+        std::println(stderr, "unknown job {}", job);
+        return false;
+    }
+    if (FLAGS_evict && job.find("read") != std::string::npos) {
+        Evict();
+    }
+
+    for (auto &worker : workers) {
+        worker.ops = 0;
+        worker.errors = 0;
+        worker.bytes = 0;
+        worker.hist.fill(0);
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (auto &worker : workers) {
+        threads.emplace_back([this, &worker, func = it->second]() { (this->*func)(worker); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    result.name = job;
+    result.hist.fill(0);
+    for (auto &worker : workers) {
+        result.ops += worker.ops;
+        result.errors += worker.errors;
+        result.bytes += worker.bytes;
+        for (uint32_t i = 0; i < LatencyHistograms::BUCKET_NUM; ++i) {
+            result.hist[i] += worker.hist[i];
+        }
+    }
+    return true;
+}
+
+void FioTest::Cleanup()
+{
+    for (auto &worker : workers) {
+        if (worker.large.exists) {
+            CuckooStore::GetInstance()->DeleteFiles(worker.large.inodeId, targetNode, worker.large.path);
+        }
+        for (auto &file : worker.small) {
+            if (file.exists) {
+                CuckooStore::GetInstance()->DeleteFiles(file.inodeId, targetNode, file.path);
+            }
+        }
+    }
+}
+
+static std::vector<std::string> SplitJobs(const std::string &jobs)
+{
+    std::vector<std::string> result;
+    std::stringstream stream(jobs);
+    std::string job;
+    while (std::getline(stream, job, ',')) {
+        if (!job.empty()) {
+            result.push_back(job);
+        }
+    }
+    return result;
+}
+
+static void Report(const JobResult &result)
+{
+    Snapshot last{};
+    LatencyPercentiles p = LatencyHistograms::Percentiles(result.hist, last);
+    double mbPerSec = result.seconds > 0 ? result.bytes / result.seconds / (1024 * 1024) : 0;
+    double iops = result.seconds > 0 ? result.ops / result.seconds : 0;
+    std::println("{:<10} {:>10} {:>8} {:>10.1f} {:>10.0f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}",
+                 result.name,
+                 result.ops,
+                 result.errors,
+                 mbPerSec,
+                 iops,
+                 p.p50 / 1000.0,
+                 p.p90 / 1000.0,
+                 p.p99 / 1000.0,
+                 p.p999 / 1000.0,
+                 p.max / 1000.0);
+    if (FLAGS_csv.empty()) {
+        return;
+    }
+    bool newFile = !std::filesystem::exists(FLAGS_csv) || std::filesystem::file_size(FLAGS_csv) == 0;
+    std::ofstream csv(FLAGS_csv, std::ios::app);
+    if (newFile) {
+        csv << "label,numjobs,bs,size,nrfiles,small_size,remote,persist,evict,job,ops,errors,seconds,mb_per_sec,"
+               "iops,p50_us,p90_us,p99_us,p999_us,max_us\n";
+    }
+    csv << std::format("{},{},{},{},{},{},{},{},{},{},{},{},{:.3f},{:.1f},{:.0f},{:.1f},{:.1f},{:.1f},{:.1f},{:.1f}\n",
+                       FLAGS_label,
+                       FLAGS_numjobs,
+                       FLAGS_bs,
+                       FLAGS_size,
+                       FLAGS_nrfiles,
+                       FLAGS_small_size,
+                       FLAGS_remote ? 1 : 0,
+                       FLAGS_persist ? 1 : 0,
+                       FLAGS_evict ? 1 : 0,
+                       result.name,
+                       result.ops,
+                       result.errors,
+                       result.seconds,
+                       mbPerSec,
+                       iops,
+                       p.p50 / 1000.0,
+                       p.p90 / 1000.0,
+                       p.p99 / 1000.0,
+                       p.p999 / 1000.0,
+                       p.max / 1000.0);
+}
+
+static std::string NodeEndpoint(int nodeId) { return std::format("127.0.0.1:{}", FLAGS_port + nodeId); }
+
+/* derives the config of a node from the config in CONFIG_FILE and creates its cache directories */
+static std::string WriteNodeConfig(int nodeId)
+{
+    const char *baseFile = std::getenv("CONFIG_FILE");
+    Json::Value root;
+    std::ifstream in(baseFile != nullptr ? baseFile : "");
+    Json::CharReaderBuilder reader;
+    std::string errs;
+    if (!in || !Json::parseFromStream(reader, in, &root, &errs)) {
+        std::println(stderr, "CONFIG_FILE must point to a valid config, {}", errs);
+        return "";
+    }
+
+    std::string cacheRoot = std::format("{}/node{}", FLAGS_dir, nodeId);
+    Json::Value &main = root["main"];
+    main["cuckoo_cache_root"] = cacheRoot;
+    main["cuckoo_node_id"] = nodeId;
+    main["cuckoo_cluster_view"] = Json::Value(Json::arrayValue);
+    main["cuckoo_cluster_view"].append(NodeEndpoint(LOCAL_NODE));
+    main["cuckoo_cluster_view"].append(NodeEndpoint(REMOTE_NODE));
+    main["cuckoo_persist"] = FLAGS_persist;
+    main["cuckoo_storage_type"] = "local";
+    main["cuckoo_local_storage_path"] = FLAGS_dir + "/storage";
+    main["cuckoo_log_dir"] = FLAGS_dir;
+    main["cuckoo_stat"] = false;
+
+    std::filesystem::remove_all(cacheRoot);
+    for (uint32_t i = 0; i < main["cuckoo_dir_num"].asUInt(); ++i) {
+        std::filesystem::create_directories(std::format("{}/{}", cacheRoot, i));
+    }
+    std::string configFile = std::format("{}/node{}.json", FLAGS_dir, nodeId);
+    std::ofstream out(configFile);
+    out << Json::writeString(Json::StreamWriterBuilder(), root);
+    return configFile;
+}
+
+/* brings up the store node of this process the same way the client does */
+static int StartNode(const std::string &configFile, int nodeId, std::thread &serverThread)
+{
+    setenv("CONFIG_FILE", configFile.c_str(), 1);
+    int ret = GetInit().Init();
+    if (ret != 0) {
+        std::println(stderr, "Cuckoo init failed");
+        return ret;
+    }
+    cuckoo::brpc_io::RemoteIOServer &server = cuckoo::brpc_io::RemoteIOServer::GetInstance();
+    server.endPoint = NodeEndpoint(nodeId);
+    serverThread = std::thread(&cuckoo::brpc_io::RemoteIOServer::Run, &server);
+    {
+        std::unique_lock<std::mutex> lk(server.mutexStart);
+        server.cvStart.wait(lk, [&server]() { return server.isStarted; });
+    }
+    server.SetReadyFlag();
+    ret = CuckooStore::GetInstance()->GetInitStatus();
+    if (ret != 0) {
+        std::println(stderr, "store init failed, check the log in {}", FLAGS_dir);
+    }
+    return ret;
+}
+
+static void StopNode(std::thread &serverThread)
+{
+    cuckoo::brpc_io::RemoteIOServer::GetInstance().Stop();
+    if (serverThread.joinable()) {
+        serverThread.join();
+    }
+}
+
+/* body of the child process serving node 1, runs until the parent closes stopFd */
+static int RunRemoteNode(const std::string &configFile, int readyFd, int stopFd)
+{
+    std::thread serverThread;
+    int ret = StartNode(configFile, REMOTE_NODE, serverThread);
+    if (ret == 0) {
+        char ready = 1;
+        ret = write(readyFd, &ready, 1) == 1 ? 0 : -1;
+    }
+    close(readyFd);
+    if (ret == 0) {
+        char ignored;
+        while (read(stopFd, &ignored, 1) > 0) {
+        }
+    }
+    StopNode(serverThread);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::SetUsageMessage("fio like CuckooStore benchmark, CONFIG_FILE must point to a base config");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    std::vector<std::string> jobs = SplitJobs(FLAGS_rw);
+    if (FLAGS_numjobs <= 0 || FLAGS_bs == 0 || FLAGS_size < FLAGS_bs || FLAGS_nrfiles < 0 || jobs.empty()) {
+        std::println(stderr, "invalid arguments");
+        return 1;
+    }
+    std::filesystem::create_directories(FLAGS_dir);
+    std::string localConfig = WriteNodeConfig(LOCAL_NODE);
+    std::string remoteConfig = WriteNodeConfig(REMOTE_NODE);
+    if (localConfig.empty() || remoteConfig.empty()) {
+        return 1;
+    }
+
+    /* fork before anything starts threads, the child becomes node 1 */
+    pid_t child = -1;
+    int stopPipe[2] = {-1, -1};
+    if (FLAGS_remote) {
+        int readyPipe[2];
+        if (pipe(readyPipe) != 0 || pipe(stopPipe) != 0) {
+            std::println(stderr, "pipe failed");
+            return 1;
+        }
+        child = fork();
+        if (child < 0) {
+            std::println(stderr, "fork failed");
+            return 1;
+        }
+        if (child == 0) {
+            close(readyPipe[0]);
+            close(stopPipe[1]);
+            _exit(RunRemoteNode(remoteConfig, readyPipe[1], stopPipe[0]) == 0 ? 0 : 1);
+        }
+        close(readyPipe[1]);
+        close(stopPipe[0]);
+        char ready = 0;
+        bool remoteReady = read(readyPipe[0], &ready, 1) == 1;
+        close(readyPipe[0]);
+        if (!remoteReady) {
+            std::println(stderr, "remote node failed to start");
+            waitpid(child, nullptr, 0);
+            return 1;
+        }
+    }
+
+    std::thread serverThread;
+    int ret = StartNode(localConfig, LOCAL_NODE, serverThread);
+    if (ret == 0) {
+        std::println("numjobs {} bs {} size {} nrfiles {} small_size {} remote {} persist {} evict {}",
+                     FLAGS_numjobs,
+                     FLAGS_bs,
+                     FLAGS_size,
+                     FLAGS_nrfiles,
+                     FLAGS_small_size,
+                     FLAGS_remote,
+                     FLAGS_persist,
+                     FLAGS_evict);
+        std::println("{:<10} {:>10} {:>8} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10} {:>10}",
+                     "job",
+                     "ops",
+                     "errors",
+                     "MB/s",
+                     "IOPS",
+                     "p50(us)",
+                     "p90(us)",
+                     "p99(us)",
+                     "p99.9(us)",
+                     "max(us)");
+        FioTest test;
+        uint64_t totalErrors = 0;
+        for (auto &job : jobs) {
+            JobResult result;
+            if (!test.RunJob(job, result)) {
+                ret = 1;
+                break;
+            }
+            totalErrors += result.errors;
+            Report(result);
+        }
+        test.Cleanup();
+        if (ret == 0 && totalErrors != 0) {
+            ret = 1;
+        }
+    }
+    StopNode(serverThread);
+
+    if (child > 0) {
+        close(stopPipe[1]);
+        waitpid(child, nullptr, 0);
+    }
+    std::filesystem::remove_all(FLAGS_dir + "/storage");
+    return ret;
+}
@@ -0,0 +1,488 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+/*
+ * mdtest style metadata benchmark driving the libFS API of cuckoo_meta.h against a running cluster.
+ *
+ * Every thread works on its own tree root/t<thread>/d<dir>/f<thread>.<file>, or with -shared_dir
+ * all threads put their files into the same directories root/d<dir>. The phases run one after
+ * another over the whole tree, each reports ops/s and latency percentiles of the single calls.
+ */
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <print>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gflags/gflags.h>
+
+#include "brpc/brpc_server.h"
+#include "conf/cuckoo_property_key.h"
+#include "cuckoo_code.h"
+#include "cuckoo_meta.h"
+#include "init/cuckoo_init.h"
+#include "stats/latency_histogram.h"
+
+DEFINE_int32(threads, 8, "number of client threads");
+DEFINE_int32(dirs, 4, "directories per thread, or in total with -shared_dir");
+DEFINE_int32(files, 1000, "files per directory and thread");
+DEFINE_bool(shared_dir, false, "all threads create their files in the same directories");
+DEFINE_string(root, "/mdtest", "directory the tree is created under, must not exist");
+DEFINE_string(phases,
+              "mkdir,create,stat,open,close,readdir,rename,unlink,rmdir",
+              "comma separated phases, run in order");
+DEFINE_int32(iterations, 1, "number of times the phases are run");
+DEFINE_string(csv, "", "append the results to this csv file");
+DEFINE_string(label, "", "label of the run in the csv file, e.g. the commit");
+DEFINE_string(server_ip, "", "coordinator ip, taken from the config if empty");
+DEFINE_int32(server_port, 0, "coordinator port, taken from the config if 0");
+DEFINE_string(rpc_endpoint, "0.0.0.0:56039", "endpoint of rpc server");
+
+using Snapshot = LatencyHistograms::Snapshot;
+
+struct PhaseResult
+{
+    std::string name;
+    uint64_t ops = 0;
+    uint64_t errors = 0;
+    double seconds = 0;
+    Snapshot hist{};
+};
+
+/* what a thread records during a phase */
+struct WorkerStat
+{
+    uint64_t ops = 0;
+    uint64_t errors = 0;
+    Snapshot hist{};
+    /* open fds between the open and the close phase */
+    std::vector<uint64_t> fds;
+};
+
+class MdTest {
+  public:
+    MdTest()
+        : workers(FLAGS_threads)
+    {
+    }
+
+    bool RunPhase(const std::string &phase, PhaseResult &result);
+    /* closes fds left open and removes whatever the phases did not */
+    void Cleanup();
+
+  private:
+    using PhaseFunc = void (MdTest::*)(int thread, WorkerStat &stat);
+
+    std::string ThreadBase(int thread)
+    {
+        return FLAGS_shared_dir ? FLAGS_root : std::format("{}/t{}", FLAGS_root, thread);
+    }
+    std::string DirPath(int thread, int dir) { return std::format("{}/d{}", ThreadBase(thread), dir); }
+    std::string FilePath(int thread, int dir, int file)
+    {
+        return std::format("{}/f{}.{}{}", DirPath(thread, dir), thread, file, renamed ? ".r" : "");
+    }
+    /* dirs a thread creates and removes, with -shared_dir they are split among the threads */
+    bool OwnsDir(int thread, int dir) { return !FLAGS_shared_dir || dir % FLAGS_threads == thread; }
+
+    template <typename Func>
+    void Timed(WorkerStat &stat, Func &&func)
+    {
+        auto start = std::chrono::steady_clock::now();
+        int ret = func();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        ++stat.ops;
+        ++stat.hist[LatencyHistograms::BucketIndex(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count())];
+        if (ret != 0) {
+            if (stat.errors++ == 0) {
+                std::println(stderr, "first error of thread: {}", ret);
+            }
+        }
+    }
+
+    void Mkdir(int thread, WorkerStat &stat);
+    void Create(int thread, WorkerStat &stat);
+    void Stat(int thread, WorkerStat &stat);
+    void Open(int thread, WorkerStat &stat);
+    void Close(int thread, WorkerStat &stat);
+    void ReadDir(int thread, WorkerStat &stat);
+    void Rename(int thread, WorkerStat &stat);
+    void Unlink(int thread, WorkerStat &stat);
+    void Rmdir(int thread, WorkerStat &stat);
+
+    std::vector<WorkerStat> workers;
+    bool renamed = false;
+    bool created = false;
+    bool hasDirs = false;
+};
+
+void MdTest::Mkdir(int thread, WorkerStat &stat)
+{
+    if (!FLAGS_shared_dir) {
+        Timed(stat, [&] { return CuckooMkdir(ThreadBase(thread)); });
+    }
+    for (int d = 0; d < FLAGS_dirs; ++d) {
+        if (OwnsDir(thread, d)) {
+            Timed(stat, [&] { return CuckooMkdir(DirPath(thread, d)); });
+        }
+    }
+}
+
+void MdTest::Create(int thread, WorkerStat &stat)
+{
+    struct stat st;
+    for (int d = 0; d < FLAGS_dirs; ++d) {
+        for (int f = 0; f < FLAGS_files; ++f) {
+            std::string path = FilePath(thread, d, f);
+            /* like mdtest a create includes the close of the new file */
+            Timed(stat, [&] {
+                uint64_t fd = 0;
+                int ret = CuckooCreate(path, fd, O_CREAT | O_WRONLY, &st);
+                return ret != 0 ? ret : CuckooClose(path, fd);
+            });
+        }
+    }
+}
+
+void MdTest::Stat(int thread, WorkerStat &stat)
+{
+    struct stat st;
+    for (int d = 0; d < FLAGS_dirs; ++d) {
+        for (int f = 0; f < FLAGS_files; ++f) {
+            Timed(stat, [&] { return CuckooGetStat(FilePath(thread, d, f), &st); });
+        }
+    }
+}
+
+void MdTest::Open(int thread, WorkerStat &stat)
+{
+    struct stat st;
+    for (int d = 0; d < FLAGS_dirs; ++d) {
+        for (int f = 0; f < FLAGS_files; ++f) {
+            Timed(stat, [&] {
+                uint64_t fd = 0;
+                int ret = CuckooOpen(FilePath(thread, d, f), O_RDONLY, fd, &st);
+                if (ret == 0) {
+                    stat.fds.push_back(fd);
+                }
+                return ret;
+            });
+        }
+    }
+}
+
+void MdTest::Close(int thread, WorkerStat &stat)
+{
+    /* fds were pushed in file order by the open phase */
+    size_t next = 0;
+    for (int d = 0; d < FLAGS_dirs && next < stat.fds.size(); ++d) {
+        for (int f = 0; f < FLAGS_files && next < stat.fds.size(); ++f) {
+            uint64_t fd = stat.fds[next++];
+            Timed(stat, [&] { return CuckooClose(FilePath(thread, d, f), fd); });
+        }
+    }
+    stat.fds.clear();
+}
+
+static int CountEntry(void *buf, const char * /*name*/, const struct stat * /*stbuf*/, off_t /*offset*/)
+{
+    ++*static_cast<uint64_t *>(buf);
+    return 0;
+}
+
+void MdTest::ReadDir(int thread, WorkerStat &stat)
+{
+    for (int d = 0; d < FLAGS_dirs; ++d) {
+        std::string path = DirPath(thread, d);
+        /* one op is the listing of a whole directory, the same way fuse pages through it */
+        Timed(stat, [&] {
+            CuckooFuseInfo fi;
+            memset(&fi, 0, sizeof(fi));
+            int ret = CuckooOpenDir(path, &fi);
+            if (ret != 0) {
+                return ret;
+            }
+            uint64_t entries = 0;
+            uint64_t seen = 0;
+            do {
+                seen = entries;
+                ret = CuckooReadDir(path, &entries, CountEntry, static_cast<off_t>(entries), &fi);
+            } while (ret == 0 && entries != seen);
+            int closeRet = CuckooCloseDir(fi.fh);
+            return ret != 0 ? ret : closeRet;
+        });
+    }
+}
+
+void MdTest::Rename(int thread, WorkerStat &stat)
+{
+    for (int d = 0; d < FLAGS_dirs; ++d) {
+        for (int f = 0; f < FLAGS_files; ++f) {
+            std::string src = FilePath(thread, d, f);
+            Timed(stat, [&] { return CuckooRename(src, src + ".r"); });
+        }
+    }
+}
+
+void MdTest::Unlink(int thread, WorkerStat &stat)
+{
+    for (int d = 0; d < FLAGS_dirs; ++d) {
+        for (int f = 0; f < FLAGS_files; ++f) {
+            Timed(stat, [&] { return CuckooUnlink(FilePath(thread, d, f)); });
+        }
+    }
+}
+
+void MdTest::Rmdir(int thread, WorkerStat &stat)
+{
+    for (int d = 0; d < FLAGS_dirs; ++d) {
+        if (OwnsDir(thread, d)) {
+            Timed(stat, [&] { return CuckooRmDir(DirPath(thread, d)); });
+        }
+    }
+    if (!FLAGS_shared_dir) {
+        Timed(stat, [&] { return CuckooRmDir(ThreadBase(thread)); });
+    }
+}
+
+bool MdTest::RunPhase(const std::string &phase, PhaseResult &result)
+{
+    static const std::vector<std::pair<std::string, PhaseFunc>> phaseFuncs = {
+        {"mkdir", &MdTest::Mkdir},
+        {"create", &MdTest::Create},
+        {"stat", &MdTest::Stat},
+        {"open", &MdTest::Open},
+        {"close", &MdTest::Close},
+        {"readdir", &MdTest::ReadDir},
+        {"rename", &MdTest::Rename},
+        {"unlink", &MdTest::Unlink},
+        {"rmdir", &MdTest::Rmdir},
+    };
+    auto it =
+        std::find_if(phaseFuncs.begin(), phaseFuncs.end(), [&phase](auto &entry) { return entry.first == phase; });
+    if (it == phaseFuncs.end()) {
+        std::println(stderr, "unknown phase {}", phase);
+        return false;
+    }
+
+    for (auto &worker : workers) {
+        worker.ops = 0;
+        worker.errors = 0;
+        worker.hist.fill(0);
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < FLAGS_threads; ++t) {
+        threads.emplace_back([this, t, func = it->second]() { (this->*func)(t, workers[t]); });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    result.name = phase;
+    result.hist.fill(0);
+    for (auto &worker : workers) {
+        result.ops += worker.ops;
+        result.errors += worker.errors;
+        for (uint32_t i = 0; i < LatencyHistograms::BUCKET_NUM; ++i) {
+            result.hist[i] += worker.hist[i];
+        }
+    }
+
+    if (phase == "mkdir") {
+        hasDirs = true;
+    } else if (phase == "create") {
+        created = true;
+    } else if (phase == "rename") {
+        renamed = true;
+    } else if (phase == "unlink") {
+        created = false;
+    } else if (phase == "rmdir") {
+        hasDirs = false;
+    }
+    return true;
+}
+
+void MdTest::Cleanup()
+{
+    WorkerStat ignored;
+    for (int t = 0; t < FLAGS_threads; ++t) {
+        Close(t, workers[t]);
+        if (created) {
+            Unlink(t, ignored);
+        }
+    }
+    if (hasDirs) {
+        for (int t = 0; t < FLAGS_threads; ++t) {
+            Rmdir(t, ignored);
+        }
+    }
+    renamed = false;
+    created = false;
+    hasDirs = false;
+}
+
+static std::vector<std::string> SplitPhases(const std::string &phases)
+{
+    std::vector<std::string> result;
+    std::stringstream stream(phases);
+    std::string phase;
+    while (std::getline(stream, phase, ',')) {
+        if (!phase.empty()) {
+            result.push_back(phase);
+        }
+    }
+    return result;
+}
+
+static void Report(int iteration, const PhaseResult &result)
+{
+    Snapshot last{};
+    LatencyPercentiles p = LatencyHistograms::Percentiles(result.hist, last);
+    double opsPerSec = result.seconds > 0 ? result.ops / result.seconds : 0;
+    std::println("{:<8} {:>10} {:>8} {:>12.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f} {:>10.1f}",
+                 result.name,
+                 result.ops,
+                 result.errors,
+                 opsPerSec,
+                 p.p50 / 1000.0,
+                 p.p90 / 1000.0,
+                 p.p99 / 1000.0,
+                 p.p999 / 1000.0,
+                 p.max / 1000.0);
+    if (FLAGS_csv.empty()) {
+        return;
+    }
+    bool newFile = !std::filesystem::exists(FLAGS_csv) || std::filesystem::file_size(FLAGS_csv) == 0;
+    std::ofstream csv(FLAGS_csv, std::ios::app);
+    if (newFile) {
+        csv << "label,iteration,threads,dirs,files,shared_dir,phase,ops,errors,seconds,ops_per_sec,"
+               "p50_us,p90_us,p99_us,p999_us,max_us\n";
+    }
+    csv << std::format("{},{},{},{},{},{},{},{},{},{:.3f},{:.1f},{:.1f},{:.1f},{:.1f},{:.1f},{:.1f}\n",
+                       FLAGS_label,
+                       iteration,
+                       FLAGS_threads,
+                       FLAGS_dirs,
+                       FLAGS_files,
+                       FLAGS_shared_dir ? 1 : 0,
+                       result.name,
+                       result.ops,
+                       result.errors,
+                       result.seconds,
+                       opsPerSec,
+                       p.p50 / 1000.0,
+                       p.p90 / 1000.0,
+                       p.p99 / 1000.0,
+                       p.p999 / 1000.0,
+                       p.max / 1000.0);
+}
+
+int main(int argc, char *argv[])
+{
+    gflags::SetUsageMessage("mdtest style metadata benchmark, CONFIG_FILE must point to the client config");
+    gflags::ParseCommandLineFlags(&argc, &argv, true);
+    std::vector<std::string> phases = SplitPhases(FLAGS_phases);
+    if (FLAGS_threads <= 0 || FLAGS_dirs <= 0 || FLAGS_files < 0 || phases.empty()) {
+        std::println(stderr, "invalid arguments");
+        return 1;
+    }
+
+    /* the client serves its own store node, start it the same way the fuse client does */
+    cuckoo::brpc_io::RemoteIOServer &server = cuckoo::brpc_io::RemoteIOServer::GetInstance();
+    server.endPoint = FLAGS_rpc_endpoint;
+    std::thread brpcServerThread(&cuckoo::brpc_io::RemoteIOServer::Run, &server);
+    {
+        std::unique_lock<std::mutex> lk(server.mutexStart);
+        server.cvStart.wait(lk, [&server]() { return server.isStarted; });
+    }
+    auto stopServer = [&server, &brpcServerThread]() {
+        server.Stop();
+        if (brpcServerThread.joinable()) {
+            brpcServerThread.join();
+        }
+    };
+
+    int ret = GetInit().Init();
+    if (ret != CUCKOO_SUCCESS) {
+        std::println(stderr, "Cuckoo init failed");
+        stopServer();
+        return ret;
+    }
+    auto &config = GetInit().GetCuckooConfig();
+    std::string serverIp =
+        FLAGS_server_ip.empty() ? config->GetString(CuckooPropertyKey::CUCKOO_SERVER_IP) : FLAGS_server_ip;
+    int serverPort = FLAGS_server_port;
+    if (serverPort == 0) {
+        serverPort = std::stoi(config->GetString(CuckooPropertyKey::CUCKOO_SERVER_PORT));
+    }
+    ret = CuckooInit(serverIp, serverPort);
+    if (ret != CUCKOO_SUCCESS) {
+        std::println(stderr, "Cuckoo cluster init failed");
+        stopServer();
+        return ret;
+    }
+    server.SetReadyFlag();
+
+    std::println("threads {} dirs {} files {} shared_dir {} coordinator {}:{}",
+                 FLAGS_threads,
+                 FLAGS_dirs,
+                 FLAGS_files,
+                 FLAGS_shared_dir,
+                 serverIp,
+                 serverPort);
+    uint64_t totalErrors = 0;
+    MdTest test;
+    for (int iteration = 0; iteration < FLAGS_iterations; ++iteration) {
+        ret = CuckooMkdir(FLAGS_root);
+        if (ret != 0) {
+            std::println(stderr, "mkdir {} failed: {}", FLAGS_root, ret);
+            break;
+        }
+        std::println("iteration {}", iteration);
+        std::println("{:<8} {:>10} {:>8} {:>12} {:>10} {:>10} {:>10} {:>10} {:>10}",
+                     "phase",
+                     "ops",
+                     "errors",
+                     "ops/s",
+                     "p50(us)",
+                     "p90(us)",
+                     "p99(us)",
+                     "p99.9(us)",
+                     "max(us)");
+        for (auto &phase : phases) {
+            PhaseResult result;
+            if (!test.RunPhase(phase, result)) {
+                ret = 1;
+                break;
+            }
+            totalErrors += result.errors;
+            Report(iteration, result);
+        }
+        test.Cleanup();
+        CuckooRmDir(FLAGS_root);
+        if (ret != 0) {
+            break;
+        }
+    }
+
+    CuckooDestroy();
+    stopServer();
+    if (ret == 0 && totalErrors != 0) {
+        ret = 1;
+    }
+    return ret;
+}
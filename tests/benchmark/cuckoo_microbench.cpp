@@ -0,0 +1,547 @@
+/* Copyright (c) 2025 Huawei Technologies Co., Ltd.
+ * SPDX-License-Identifier: MulanPSL-2.0
+ */
+
+/*
+ * Microbenchmarks of the allocators and buffers on the data and metadata hot paths:
+ *   MemPool                  per thread magazines over shared depots, behind the read streams
+ *   FixMemory::writeMemPool  the pool behind every WriteStream serial buffer
+ *   CuckooShmemAllocator     bitmap buddy allocator of the connection pool shmem
+ *   ExpandableMemory         doubling buffer of out of order writes
+ *   SerializedData           segment framing of flatbuffer params and replies
+ *   CuckooFd                 fd to open instance tables looked up by every rpc and io
+ *   CuckooLog                CUCKOO_LOG as seen by the logging thread, written inline or by the flusher
+ *   ChecksumTable            crc32c of cache file blocks, checked on reads and sealed after writes
+ *
+ * Multi thread variants run with 1 to 16 threads, compare items_per_second across thread counts
+ * to spot contention. Filter with --benchmark_filter, e.g. --benchmark_filter=Shmem.
+ */
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "buffer/dir_open_instance.h"
+#include "buffer/mem_pool.h"
+#include "cuckoo_meta_param_generated.h"
+#include "log/logging.h"
+#include "remote_connection_utils/serialized_data.h"
+#include "util/checksum.h"
+#include "util/crc32c.h"
+#include "utils/cuckoo_shmem_allocator.h"
+#include "write_stream/stream_assembler.h"
+
+constexpr int MAX_THREADS = 16;
+
+/* ==================== MemPool ==================== */
+
+constexpr size_t MEMPOOL_BLOCK_SIZE = 4096;
+constexpr size_t MEMPOOL_CAPACITY = 4096;
+
+static MemPool &BenchMemPool()
+{
+    static MemPool pool(MEMPOOL_BLOCK_SIZE, MEMPOOL_CAPACITY);
+    return pool;
+}
+
+/* every thread allocates a batch of blocks and frees it again, arg is the batch size */
+static void BM_MemPoolAllocFree(benchmark::State &state)
+{
+    MemPool &pool = BenchMemPool();
+    std::vector<void *> blocks(state.range(0));
+    for (auto _ : state) {
+        for (auto &block : blocks) {
+            block = pool.alloc();
+        }
+        benchmark::DoNotOptimize(blocks.data());
+        for (auto block : blocks) {
+            pool.free(block);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MemPoolAllocFree)->Arg(1)->Arg(16)->Arg(128)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+
+static void BM_MemPoolBulkAlloc(benchmark::State &state)
+{
+    MemPool &pool = BenchMemPool();
+    for (auto _ : state) {
+        std::vector<void *> blocks = pool.calloc(state.range(0));
+        for (auto block : blocks) {
+            pool.free(block);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MemPoolBulkAlloc)->Arg(16)->Arg(128)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+
+/* ==================== FixMemory ==================== */
+
+/* fills a serial buffer of a write stream with appends of the arg size, as sequential writes do */
+static void BM_FixMemoryFill(benchmark::State &state)
+{
+    std::vector<char> chunk(state.range(0), 'x');
+    size_t appends = CUCKOO_STORE_STREAM_MAX_SIZE / chunk.size();
+    for (auto _ : state) {
+        FixMemory buf;
+        for (size_t i = 0; i < appends; ++i) {
+            if (!buf.Append(chunk.data(), chunk.size())) {
+                state.SkipWithError("FixMemory append failed");
+                break;
+            }
+        }
+        benchmark::DoNotOptimize(buf.c_str());
+    }
+    state.SetBytesProcessed(state.iterations() * appends * chunk.size());
+}
+BENCHMARK(BM_FixMemoryFill)->Arg(4096)->Arg(128 * 1024)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+
+/* ==================== CuckooShmemAllocator ==================== */
+
+constexpr uint64_t SHMEM_PAGE_COUNT = 256;
+
+static CuckooShmemAllocator *BenchShmemAllocator()
+{
+    static CuckooShmemAllocator allocator;
+    static std::once_flag initFlag;
+    std::call_once(initFlag, []() {
+        /* one page more leaves room for the control structures */
+        uint64_t size = (SHMEM_PAGE_COUNT + 1) * (sizeof(PaddedAtomic64) + CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE);
+        char *shmem = (char *)aligned_alloc(CUCKOO_SHMEM_ALLOCATOR_PAD_SIZE, size);
+        CuckooShmemAllocatorInit(&allocator, shmem, size);
+        CuckooShmemAllocatorReset(&allocator);
+    });
+    return &allocator;
+}
+
+static uint64_t ShmemCapacity(CuckooShmemAllocator *allocator, uint64_t shift)
+{
+    return ((MemoryHdr *)(CUCKOO_SHMEM_ALLOCATOR_GET_POINTER(allocator, shift) - sizeof(MemoryHdr)))->capacity;
+}
+
+/* malloc and free of a single size, arg is the requested size */
+static void BM_ShmemMallocFree(benchmark::State &state)
+{
+    CuckooShmemAllocator *allocator = BenchShmemAllocator();
+    uint64_t failed = 0;
+    for (auto _ : state) {
+        uint64_t shift = CuckooShmemAllocatorMalloc(allocator, state.range(0));
+        if (shift == 0) {
+            ++failed;
+            continue;
+        }
+        CuckooShmemAllocatorFree(allocator, shift);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.counters["failed"] = benchmark::Counter(failed, benchmark::Counter::kAvgThreads);
+}
+BENCHMARK(BM_ShmemMallocFree)
+    ->Arg(128)
+    ->Arg(4096)
+    ->Arg(64 * 1024)
+    ->Arg(512 * 1024)
+    ->ThreadRange(1, MAX_THREADS)
+    ->UseRealTime();
+
+/*
+ * Every thread keeps a window of live blocks of mixed sizes, mostly small params with some batched
+ * ones, and replaces the oldest one per iteration. The window fills the pages partly, so allocations
+ * have to scan past busy pages. utilization is requested bytes over occupied bytes of the live
+ * blocks, failed counts allocations that found no segment. Arg is the window size per thread.
+ */
+static void BM_ShmemMixedSizes(benchmark::State &state)
+{
+    CuckooShmemAllocator *allocator = BenchShmemAllocator();
+    std::mt19937_64 rng(state.thread_index());
+    auto nextSize = [&rng]() -> uint64_t {
+        uint64_t dice = rng() % 100;
+        if (dice < 80) {
+            return 64 + rng() % 4096;
+        }
+        if (dice < 98) {
+            return 4096 + rng() % (60 * 1024);
+        }
+        return 64 * 1024 + rng() % (448 * 1024);
+    };
+    std::vector<std::pair<uint64_t, uint64_t>> window(state.range(0), {0, 0});
+    size_t next = 0;
+    uint64_t failed = 0;
+    uint64_t requested = 0;
+    uint64_t occupied = 0;
+    for (auto _ : state) {
+        auto &[shift, size] = window[next];
+        if (shift != 0) {
+            requested -= size;
+            occupied -= ShmemCapacity(allocator, shift);
+            CuckooShmemAllocatorFree(allocator, shift);
+        }
+        size = nextSize();
+        shift = CuckooShmemAllocatorMalloc(allocator, size);
+        if (shift != 0) {
+            requested += size;
+            occupied += ShmemCapacity(allocator, shift);
+        } else {
+            ++failed;
+        }
+        next = (next + 1) % window.size();
+    }
+    state.counters["utilization"] =
+        benchmark::Counter(occupied != 0 ? (double)requested / occupied : 0, benchmark::Counter::kAvgThreads);
+    state.counters["live_MB"] = (double)occupied / (1024 * 1024);
+    state.counters["failed"] = failed;
+    for (auto &[shift, size] : window) {
+        if (shift != 0) {
+            CuckooShmemAllocatorFree(allocator, shift);
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ShmemMixedSizes)->Arg(64)->Arg(512)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+
+/* ==================== ExpandableMemory ==================== */
+
+/* grows a buffer from empty to 1MB with appends of the arg size */
+static void BM_ExpandableMemoryAppend(benchmark::State &state)
+{
+    constexpr size_t TOTAL_SIZE = 1024 * 1024;
+    std::vector<char> chunk(state.range(0), 'x');
+    for (auto _ : state) {
+        ExpandableMemory buf;
+        for (size_t done = 0; done < TOTAL_SIZE; done += chunk.size()) {
+            buf.Append(chunk.data(), chunk.size());
+        }
+        benchmark::DoNotOptimize(buf.Get().get());
+    }
+    state.SetBytesProcessed(state.iterations() * TOTAL_SIZE);
+}
+BENCHMARK(BM_ExpandableMemoryAppend)->Arg(512)->Arg(4096)->Arg(128 * 1024);
+
+/* ==================== SerializedData ==================== */
+
+static flatbuffers::Offset<cuckoo::meta_fbs::MetaParam> BuildPathOnly(flatbuffers::FlatBufferBuilder &builder,
+                                                                     uint64_t i)
+{
+    std::string path = "/dataset/train/shard_" + std::to_string(i % 64) + "/sample_" + std::to_string(i);
+    auto param = cuckoo::meta_fbs::CreatePathOnlyParamDirect(builder, path.c_str());
+    return cuckoo::meta_fbs::CreateMetaParam(builder, cuckoo::meta_fbs::AnyMetaParam_PathOnlyParam, param.Union());
+}
+
+static flatbuffers::Offset<cuckoo::meta_fbs::MetaParam> BuildMkdirSubCreate(flatbuffers::FlatBufferBuilder &builder,
+                                                                           uint64_t i)
+{
+    std::string name = "sample_" + std::to_string(i);
+    auto param = cuckoo::meta_fbs::CreateMkdirSubCreateParamDirect(builder, i, name.c_str(), i, 040755, i, 0);
+    return cuckoo::meta_fbs::CreateMetaParam(builder,
+                                             cuckoo::meta_fbs::AnyMetaParam_MkdirSubCreateParam,
+                                             param.Union());
+}
+
+static flatbuffers::Offset<cuckoo::meta_fbs::MetaParam> BuildRenameSubCreate(flatbuffers::FlatBufferBuilder &builder,
+                                                                            uint64_t i)
+{
+    std::string name = "sample_" + std::to_string(i);
+    auto param = cuckoo::meta_fbs::CreateRenameSubCreateParamDirect(builder,
+                                                                    i,
+                                                                    name.c_str(),
+                                                                    i,
+                                                                    0,
+                                                                    0100644,
+                                                                    1,
+                                                                    0,
+                                                                    0,
+                                                                    0,
+                                                                    i,
+                                                                    4096,
+                                                                    i / 512,
+                                                                    i,
+                                                                    i,
+                                                                    i,
+                                                                    0);
+    return cuckoo::meta_fbs::CreateMetaParam(builder,
+                                             cuckoo::meta_fbs::AnyMetaParam_RenameSubCreateParam,
+                                             param.Union());
+}
+
+/*
+ * Serializes a batch of params the way Connection::ProcessRequest does, flatbuffer then one
+ * SerializedData segment each, into a reused buffer. Arg is the batch size.
+ */
+template <auto BuildParam>
+static void BM_SerializeParams(benchmark::State &state)
+{
+    flatbuffers::FlatBufferBuilder builder;
+    SerializedData data;
+    SerializedDataInit(&data, NULL, 0, 0, NULL);
+    uint64_t bytes = 0;
+    uint64_t i = 0;
+    for (auto _ : state) {
+        SerializedDataClear(&data);
+        for (int64_t j = 0; j < state.range(0); ++j) {
+            builder.Clear();
+            builder.Finish(BuildParam(builder, i++));
+            char *p = SerializedDataApplyForSegment(&data, builder.GetSize());
+            memcpy(p, builder.GetBufferPointer(), builder.GetSize());
+        }
+        bytes += data.size;
+        benchmark::DoNotOptimize(data.buffer);
+    }
+    SerializedDataDestroy(&data);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_SerializeParams<BuildPathOnly>)->Name("BM_SerializeParams/PathOnly")->Arg(1)->Arg(64);
+BENCHMARK(BM_SerializeParams<BuildMkdirSubCreate>)->Name("BM_SerializeParams/MkdirSubCreate")->Arg(1)->Arg(64);
+BENCHMARK(BM_SerializeParams<BuildRenameSubCreate>)->Name("BM_SerializeParams/RenameSubCreate")->Arg(1)->Arg(64);
+
+/* splits a batch back into items and appends them to a fresh reply, as the connection pool does */
+static void BM_SerializedDataSplitAppend(benchmark::State &state)
+{
+    flatbuffers::FlatBufferBuilder builder;
+    SerializedData batch;
+    SerializedDataInit(&batch, NULL, 0, 0, NULL);
+    for (int64_t j = 0; j < state.range(0); ++j) {
+        builder.Clear();
+        builder.Finish(BuildMkdirSubCreate(builder, j));
+        char *p = SerializedDataApplyForSegment(&batch, builder.GetSize());
+        memcpy(p, builder.GetBufferPointer(), builder.GetSize());
+    }
+    for (auto _ : state) {
+        SerializedData reply;
+        SerializedDataInit(&reply, NULL, 0, 0, NULL);
+        sd_size_t start = 0;
+        for (int64_t j = 0; j < state.range(0); ++j) {
+            sd_size_t itemSize = SerializedDataNextSeveralItemSize(&batch, start, 1);
+            SerializedData item;
+            SerializedDataInit(&item, batch.buffer + start, itemSize, itemSize, NULL);
+            SerializedDataAppend(&reply, &item);
+            start += itemSize;
+        }
+        benchmark::DoNotOptimize(reply.buffer);
+        SerializedDataDestroy(&reply);
+    }
+    SerializedDataDestroy(&batch);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_SerializedDataSplitAppend)->Arg(1)->Arg(64);
+
+/* ==================== CuckooFd ==================== */
+
+constexpr int BENCH_FD_NUM = 4096;
+
+/* files kept open for all lookup benchmarks */
+static const std::vector<uint64_t> &BenchFds()
+{
+    static std::vector<uint64_t> fds = []() {
+        std::vector<uint64_t> attached;
+        for (int i = 0; i < BENCH_FD_NUM; ++i) {
+            attached.push_back(CuckooFd::GetInstance()->AttachFd(i, O_RDONLY, nullptr, 0, "/bench_fd"));
+        }
+        return attached;
+    }();
+    return fds;
+}
+
+/* lookups of random open fds, items_per_second should grow with the threads */
+static void BM_CuckooFdLookup(benchmark::State &state)
+{
+    const std::vector<uint64_t> &fds = BenchFds();
+    std::mt19937_64 rng(state.thread_index());
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(CuckooFd::GetInstance()->GetOpenInstanceByFd(fds[rng() % fds.size()]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CuckooFdLookup)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+
+/* the first thread opens and closes files while the others look up, lookups must not stall behind it */
+static void BM_CuckooFdLookupDuringOpenClose(benchmark::State &state)
+{
+    const std::vector<uint64_t> &fds = BenchFds();
+    CuckooFd *cuckooFd = CuckooFd::GetInstance();
+    std::mt19937_64 rng(state.thread_index());
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            uint64_t fd = cuckooFd->AttachFd(BENCH_FD_NUM + rng() % BENCH_FD_NUM, O_RDONLY, nullptr, 0, "/bench_fd");
+            cuckooFd->DeleteOpenInstance(fd);
+        } else {
+            benchmark::DoNotOptimize(cuckooFd->GetOpenInstanceByFd(fds[rng() % fds.size()]));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CuckooFdLookupDuringOpenClose)->ThreadRange(2, MAX_THREADS)->UseRealTime();
+
+/* every thread opens and closes files, changes of different stripes run in parallel */
+static void BM_CuckooFdOpenClose(benchmark::State &state)
+{
+    CuckooFd *cuckooFd = CuckooFd::GetInstance();
+    uint64_t inodeId = BENCH_FD_NUM * (state.thread_index() + 2);
+    for (auto _ : state) {
+        uint64_t fd = cuckooFd->AttachFd(inodeId++, O_RDONLY, nullptr, 0, "/bench_fd");
+        cuckooFd->DeleteOpenInstance(fd);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CuckooFdOpenClose)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+
+/* ==================== CuckooLog ==================== */
+
+static uint64_t g_droppedBefore = 0;
+
+static void DiscardLog(CuckooLogLevel /*level*/, const char * /*file*/, int /*line*/, const char * /*content*/) {}
+
+/* arg 0 formats and writes on the calling thread, arg 1 on the flusher thread */
+static void LogSetup(const benchmark::State &state)
+{
+    CuckooLog::SetCuckooLogLevel(LOG_INFO);
+    CuckooLog::SetExternalLogger(DiscardLog);
+    CuckooLog::SetAsync(state.range(0) != 0);
+    g_droppedBefore = AsyncLogger::GetInstance().GetDroppedNum();
+}
+
+static void LogTeardown(const benchmark::State & /*state*/) { CuckooLog::SetAsync(false); }
+
+static void BM_CuckooLog(benchmark::State &state)
+{
+    int64_t i = 0;
+    for (auto _ : state) {
+        CUCKOO_LOG(LOG_INFO) << "Receive ReadFile rpc request, fd = " << i << ", offset = " << i * 4096L
+                             << ", size = " << 131072;
+        ++i;
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        /* messages lost on full rings, the cost is only comparable while this stays low */
+        state.counters["dropped"] = AsyncLogger::GetInstance().GetDroppedNum() - g_droppedBefore;
+    }
+}
+BENCHMARK(BM_CuckooLog)
+    ->Arg(0)
+    ->Arg(1)
+    ->ThreadRange(1, MAX_THREADS)
+    ->Setup(LogSetup)
+    ->Teardown(LogTeardown)
+    ->UseRealTime();
+
+/* ==================== ChecksumTable ==================== */
+
+constexpr uint64_t CHECKSUM_FILE_SIZE = 64 * 1024 * 1024;
+
+static std::string ChecksumBenchPath(uint64_t inodeId) { return "/tmp/cuckoo_microbench_" + std::to_string(inodeId); }
+
+static std::vector<char> WriteChecksumBenchFile(uint64_t inodeId, uint64_t size)
+{
+    std::vector<char> data(size);
+    std::mt19937_64 rng(inodeId);
+    for (char &c : data) {
+        c = static_cast<char>(rng());
+    }
+    int fd = open(ChecksumBenchPath(inodeId).c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || pwrite(fd, data.data(), data.size(), 0) != static_cast<ssize_t>(data.size())) {
+        std::abort();
+    }
+    close(fd);
+    return data;
+}
+
+static ChecksumTable &BenchChecksumTable()
+{
+    static ChecksumTable table;
+    static std::once_flag started;
+    std::call_once(started, []() { table.Start(ChecksumBenchPath); });
+    return table;
+}
+
+/* arg is the size of the data */
+static void BM_Crc32c(benchmark::State &state)
+{
+    std::vector<char> data(state.range(0), 'c');
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(Crc32c(0, data.data(), data.size()));
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Crc32c)->Arg(4096)->Arg(CHECKSUM_BLOCK_SIZE);
+
+/* checksums of a whole file of the arg size in MB after it is written, the work kept off the close path */
+static void BM_ChecksumSeal(benchmark::State &state)
+{
+    ChecksumTable &table = BenchChecksumTable();
+    uint64_t inodeId = 1000 + state.range(0);
+    WriteChecksumBenchFile(inodeId, state.range(0) * 1024 * 1024);
+    for (auto _ : state) {
+        if (table.Seal(inodeId) != 0) {
+            state.SkipWithError("seal failed");
+            break;
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * state.range(0) * 1024 * 1024);
+    table.Remove(inodeId);
+    unlink(ChecksumBenchPath(inodeId).c_str());
+}
+BENCHMARK(BM_ChecksumSeal)->Arg(1)->Arg(64)->Unit(benchmark::kMillisecond);
+
+/*
+ * checks of random reads of the arg size of a sealed file, as pread reads do. Reads within a block are
+ * table lookups once the block is checked, whole blocks are a crc each.
+ */
+static void BM_ChecksumVerify(benchmark::State &state)
+{
+    ChecksumTable &table = BenchChecksumTable();
+    constexpr uint64_t inodeId = 1;
+    static std::vector<char> data = []() {
+        std::vector<char> written = WriteChecksumBenchFile(inodeId, CHECKSUM_FILE_SIZE);
+        BenchChecksumTable().Seal(inodeId);
+        return written;
+    }();
+    int fd = open(ChecksumBenchPath(inodeId).c_str(), O_RDONLY);
+    uint64_t size = state.range(0);
+    std::mt19937_64 rng(state.thread_index());
+    for (auto _ : state) {
+        uint64_t offset = rng() % (CHECKSUM_FILE_SIZE / size) * size;
+        benchmark::DoNotOptimize(table.Verify(inodeId, fd, data.data() + offset, offset, size));
+    }
+    close(fd);
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * size);
+}
+BENCHMARK(BM_ChecksumVerify)->Arg(4096)->Arg(CHECKSUM_BLOCK_SIZE)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+
+/* what a splice read of checked blocks pays before the fd is handed out */
+static void BM_ChecksumVerified(benchmark::State &state)
+{
+    ChecksumTable &table = BenchChecksumTable();
+    constexpr uint64_t inodeId = 2;
+    static bool checked = []() {
+        WriteChecksumBenchFile(inodeId, CHECKSUM_FILE_SIZE);
+        ChecksumTable &sealed = BenchChecksumTable();
+        int fd = open(ChecksumBenchPath(inodeId).c_str(), O_RDONLY);
+        bool ok = sealed.Seal(inodeId) == 0 && sealed.VerifyRange(inodeId, fd, 0, CHECKSUM_FILE_SIZE) == 0;
+        close(fd);
+        return ok;
+    }();
+    if (!checked) {
+        state.SkipWithError("seal failed");
+        return;
+    }
+    int fd = open(ChecksumBenchPath(inodeId).c_str(), O_RDONLY);
+    std::mt19937_64 rng(state.thread_index());
+    for (auto _ : state) {
+        uint64_t offset = rng() % (CHECKSUM_FILE_SIZE / CHECKSUM_BLOCK_SIZE) * CHECKSUM_BLOCK_SIZE;
+        benchmark::DoNotOptimize(table.Verified(inodeId, fd, offset, 128 * 1024));
+    }
+    close(fd);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ChecksumVerified)->ThreadRange(1, MAX_THREADS)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,91 @@
+#!/bin/bash
+# Runs cuckoo_mdtest against a local cluster for a list of thread counts and appends the results to
+# a csv file labelled with the current commit, so that runs of different commits can be compared.
+set -euo pipefail
+
+DIR=$(dirname $(readlink -f "${BASH_SOURCE[0]}"))
+ROOT_PATH=$DIR/../..
+BUILD_DIR="${BUILD_DIR:-$ROOT_PATH/build}"
+export CONFIG_FILE="${CONFIG_FILE:-$ROOT_PATH/config/config.json}"
+
+WORKER_NUM=1
+THREAD_LIST="1 4 16"
+DIR_NUM=4
+FILE_NUM=1000
+CSV=$BUILD_DIR/mdtest.csv
+DEPLOY=true
+EXTRA_ARGS=()
+
+usage() {
+    echo "Usage: $0 [options] [-- cuckoo_mdtest flags]"
+    echo ""
+    echo "Options:"
+    echo "  -w NUM        number of local metadata workers besides the coordinator (default $WORKER_NUM)"
+    echo "  -t LIST       thread counts to run, e.g. \"1 4 16\" (default \"$THREAD_LIST\")"
+    echo "  -d NUM        directories per thread (default $DIR_NUM)"
+    echo "  -n NUM        files per directory and thread (default $FILE_NUM)"
+    echo "  -o FILE       csv file the results are appended to (default $CSV)"
+    echo "  --no-deploy   use the cluster that is already running"
+    echo "  -h, --help    show this help message"
+}
+
+while [[ $# -gt 0 ]]; do
+    case "$1" in
+    -w)
+        WORKER_NUM=$2
+        shift
+        ;;
+    -t)
+        THREAD_LIST=$2
+        shift
+        ;;
+    -d)
+        DIR_NUM=$2
+        shift
+        ;;
+    -n)
+        FILE_NUM=$2
+        shift
+        ;;
+    -o)
+        CSV=$2
+        shift
+        ;;
+    --no-deploy)
+        DEPLOY=false
+        ;;
+    -h | --help)
+        usage
+        exit 0
+        ;;
+    --)
+        shift
+        EXTRA_ARGS=("$@")
+        break
+        ;;
+    *)
+        echo "Unknown option: $1"
+        usage
+        exit 1
+        ;;
+    esac
+    shift
+done
+
+LABEL=$(git -C $ROOT_PATH rev-parse --short HEAD 2>/dev/null || echo unknown)
+if ! git -C $ROOT_PATH diff --quiet HEAD 2>/dev/null; then
+    LABEL=$LABEL-dirty
+fi
+
+if [[ "$DEPLOY" == "true" ]]; then
+    export CUCKOO_WORKER_NUM=$WORKER_NUM
+    $ROOT_PATH/deploy/meta/cuckoo_meta_start.sh
+    trap '$ROOT_PATH/deploy/meta/cuckoo_meta_stop.sh' EXIT
+fi
+
+for threads in $THREAD_LIST; do
+    echo "========= cuckoo_mdtest $LABEL, $WORKER_NUM workers, $threads threads ========="
+    $BUILD_DIR/tests/benchmark/cuckoo_mdtest -threads=$threads -dirs=$DIR_NUM -files=$FILE_NUM \
+        -csv=$CSV -label=$LABEL "${EXTRA_ARGS[@]}"
+done
+echo "results appended to $CSV"
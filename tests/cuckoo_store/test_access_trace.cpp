@@ -0,0 +1,232 @@
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "util/access_trace.h"
+
+/* stands in for the nodes, keeps the files warmed in the order asked for */
+class MockBackend : public AccessTraceBackend {
+  public:
+    int Warm(const AccessTraceRecord &record) override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        warmed.push_back(record.path);
+        bytes += record.length;
+        return record.path == failPath ? -EIO : 0;
+    }
+
+    std::mutex mutex;
+    std::vector<std::string> warmed;
+    uint64_t bytes = 0;
+    std::string failPath;
+};
+
+class AccessTraceUT : public testing::Test {
+  protected:
+    void SetUp() override { fileName = "/tmp/cuckoo_access_trace_ut." + std::to_string(getpid()); }
+    void TearDown() override { std::remove(fileName.c_str()); }
+
+    /* an epoch reading file i of size (i + 1) * CHUNK in chunks, file 2 read at random once */
+    void RecordEpoch(AccessTraceRecorder &recorder, uint64_t &nowUs)
+    {
+        for (uint64_t i = 0; i < FILE_NUM; ++i) {
+            for (uint64_t offset = 0; offset < (i + 1) * CHUNK; offset += CHUNK) {
+                recorder.Record(INODE_BASE + i, Path(i), offset, CHUNK, nowUs++);
+            }
+        }
+        recorder.Record(INODE_BASE + 2, Path(2), CHUNK, CHUNK, nowUs++);
+    }
+
+    static std::string Path(uint64_t i) { return "/data/train/part " + std::to_string(i); }
+
+    static constexpr uint64_t FILE_NUM = 8;
+    static constexpr uint64_t CHUNK = 4096;
+    static constexpr uint64_t INODE_BASE = 1000;
+    std::string fileName;
+};
+
+TEST_F(AccessTraceUT, SequentialReadsCoalesced)
+{
+    AccessTraceRecorder recorder;
+    ASSERT_EQ(recorder.Start(fileName), 0);
+    uint64_t nowUs = 5000;
+    RecordEpoch(recorder, nowUs);
+    /* not recording once stopped */
+    recorder.Stop();
+    recorder.Record(INODE_BASE + 100, Path(100), 0, CHUNK, nowUs++);
+
+    std::vector<AccessTraceRecord> records;
+    ASSERT_EQ(LoadAccessTrace(fileName, records), 0);
+    /* a record per file, file 2 read again at random */
+    ASSERT_EQ(records.size(), FILE_NUM + 1);
+    EXPECT_EQ(records[0].timeUs, 0U);
+    for (uint64_t i = 0; i < FILE_NUM; ++i) {
+        EXPECT_EQ(records[i].inodeId, INODE_BASE + i);
+        EXPECT_EQ(records[i].path, Path(i));
+        EXPECT_EQ(records[i].offset, 0U);
+        EXPECT_EQ(records[i].length, (i + 1) * CHUNK);
+    }
+    EXPECT_EQ(records[FILE_NUM].inodeId, INODE_BASE + 2);
+    EXPECT_EQ(records[FILE_NUM].offset, CHUNK);
+}
+
+TEST_F(AccessTraceUT, ReplayInRecordedOrder)
+{
+    AccessTraceRecorder recorder;
+    ASSERT_EQ(recorder.Start(fileName), 0);
+    uint64_t nowUs = 0;
+    /* two epochs of the same job, reading the files in another order than their inodes */
+    for (int epoch = 0; epoch < 2; ++epoch) {
+        for (uint64_t i : {5, 1, 7, 0, 3, 6, 2, 4}) {
+            recorder.Record(INODE_BASE + i, Path(i), 0, CHUNK, nowUs++);
+            recorder.Record(INODE_BASE + i, Path(i), CHUNK, CHUNK, nowUs++);
+        }
+    }
+    recorder.Stop();
+
+    std::vector<AccessTraceRecord> records;
+    ASSERT_EQ(LoadAccessTrace(fileName, records), 0);
+    std::vector<AccessTraceRecord> plan = PlanAccessTraceWarmup(records);
+    ASSERT_EQ(plan.size(), FILE_NUM);
+
+    MockBackend backend;
+    EXPECT_EQ(ReplayAccessTrace(plan, backend, 1), 0);
+    std::vector<std::string> expected;
+    for (uint64_t i : {5, 1, 7, 0, 3, 6, 2, 4}) {
+        expected.push_back(Path(i));
+    }
+    EXPECT_EQ(backend.warmed, expected);
+    EXPECT_EQ(backend.bytes, FILE_NUM * 2 * CHUNK);
+
+    /* the same files once each with a window of loads */
+    MockBackend parallel;
+    EXPECT_EQ(ReplayAccessTrace(plan, parallel, 4), 0);
+    std::sort(parallel.warmed.begin(), parallel.warmed.end());
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(parallel.warmed, expected);
+}
+
+TEST_F(AccessTraceUT, ReplayGoesOnAfterFailure)
+{
+    AccessTraceRecorder recorder;
+    ASSERT_EQ(recorder.Start(fileName), 0);
+    uint64_t nowUs = 0;
+    RecordEpoch(recorder, nowUs);
+    recorder.Stop();
+
+    std::vector<AccessTraceRecord> records;
+    ASSERT_EQ(LoadAccessTrace(fileName, records), 0);
+    std::vector<AccessTraceRecord> plan = PlanAccessTraceWarmup(records);
+    ASSERT_EQ(plan.size(), FILE_NUM);
+    /* the random read of file 2 is within the span of its first pass */
+    EXPECT_EQ(plan[2].offset, 0U);
+    EXPECT_EQ(plan[2].length, 3 * CHUNK);
+
+    MockBackend backend;
+    backend.failPath = Path(3);
+    EXPECT_EQ(ReplayAccessTrace(plan, backend, 1), -EIO);
+    EXPECT_EQ(backend.warmed.size(), FILE_NUM);
+}
+
+TEST_F(AccessTraceUT, ManyFilesAtOnce)
+{
+    AccessTraceRecorder recorder;
+    ASSERT_EQ(recorder.Start(fileName), 0);
+    uint64_t nowUs = 0;
+    /* more files read interleaved than runs kept, each is written out early and continued later */
+    constexpr uint64_t FILES = ACCESS_TRACE_MAX_RUNS + 10;
+    for (uint64_t pass = 0; pass < 2; ++pass) {
+        for (uint64_t i = 0; i < FILES; ++i) {
+            recorder.Record(i, Path(i), pass * CHUNK, CHUNK, nowUs++);
+        }
+    }
+    recorder.Stop();
+
+    std::vector<AccessTraceRecord> records;
+    ASSERT_EQ(LoadAccessTrace(fileName, records), 0);
+    std::vector<AccessTraceRecord> plan = PlanAccessTraceWarmup(records);
+    ASSERT_EQ(plan.size(), FILES);
+    for (uint64_t i = 0; i < FILES; ++i) {
+        EXPECT_EQ(plan[i].inodeId, i);
+        EXPECT_EQ(plan[i].length, 2 * CHUNK);
+    }
+}
+
+TEST_F(AccessTraceUT, EndedRunsFlushedWhileRunning)
+{
+    AccessTraceRecorder recorder;
+    ASSERT_EQ(recorder.Start(fileName), 0);
+    uint64_t nowUs = 0;
+    recorder.Record(INODE_BASE, Path(0), 0, CHUNK, nowUs);
+    recorder.Record(INODE_BASE, Path(0), CHUNK, CHUNK, nowUs + 10);
+    nowUs += ACCESS_TRACE_FLUSH_US;
+    recorder.Record(INODE_BASE + 1, Path(1), 0, CHUNK, nowUs);
+    /* file 0 has not been read for a flush interval, file 1 is still going */
+    recorder.Flush(nowUs + 10);
+
+    std::vector<AccessTraceRecord> records;
+    ASSERT_EQ(LoadAccessTrace(fileName, records), 0);
+    ASSERT_EQ(records.size(), 1U);
+    EXPECT_EQ(records[0].inodeId, INODE_BASE);
+    EXPECT_EQ(records[0].length, 2 * CHUNK);
+
+    recorder.Record(INODE_BASE + 1, Path(1), CHUNK, CHUNK, nowUs + 20);
+    recorder.Stop();
+    records.clear();
+    ASSERT_EQ(LoadAccessTrace(fileName, records), 0);
+    ASSERT_EQ(records.size(), 2U);
+    EXPECT_EQ(records[1].inodeId, INODE_BASE + 1);
+    EXPECT_EQ(records[1].length, 2 * CHUNK);
+}
+
+TEST_F(AccessTraceUT, RotateCutsOneTracePerJob)
+{
+    std::string nextFileName = fileName + ".next";
+    AccessTraceRecorder recorder;
+    ASSERT_EQ(recorder.Start(fileName), 0);
+    uint64_t nowUs = 100;
+    recorder.Record(INODE_BASE, Path(0), 0, CHUNK, nowUs++);
+    /* a new trace closes the running one, its times start over */
+    ASSERT_EQ(recorder.Start(nextFileName), 0);
+    EXPECT_TRUE(recorder.Started());
+    recorder.Record(INODE_BASE + 1, Path(1), 0, CHUNK, nowUs++);
+    recorder.Stop();
+    EXPECT_FALSE(recorder.Started());
+
+    std::vector<AccessTraceRecord> records;
+    ASSERT_EQ(LoadAccessTrace(fileName, records), 0);
+    ASSERT_EQ(records.size(), 1U);
+    EXPECT_EQ(records[0].inodeId, INODE_BASE);
+    std::vector<AccessTraceRecord> nextRecords;
+    ASSERT_EQ(LoadAccessTrace(nextFileName, nextRecords), 0);
+    ASSERT_EQ(nextRecords.size(), 1U);
+    EXPECT_EQ(nextRecords[0].inodeId, INODE_BASE + 1);
+    EXPECT_EQ(nextRecords[0].timeUs, 0U);
+    std::remove(nextFileName.c_str());
+
+    /* a trace that cannot be opened leaves recording off */
+    EXPECT_EQ(recorder.Start("/nonexistent/dir/trace"), -ENOENT);
+    EXPECT_FALSE(recorder.Started());
+}
+
+TEST_F(AccessTraceUT, BadTraceRejected)
+{
+    std::vector<AccessTraceRecord> records;
+    EXPECT_EQ(LoadAccessTrace(fileName, records), -ENOENT);
+    std::ofstream(fileName) << "not a trace\n";
+    EXPECT_EQ(LoadAccessTrace(fileName, records), -EINVAL);
+    std::ofstream(fileName) << ACCESS_TRACE_HEADER << "\n1 2 3\n";
+    EXPECT_EQ(LoadAccessTrace(fileName, records), -EINVAL);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "log/logging.h"
+
+static std::mutex g_mutex;
+static std::vector<std::string> g_messages;
+
+static void Capture(CuckooLogLevel /*level*/, const char * /*file*/, int /*line*/, const char *content)
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    g_messages.emplace_back(content);
+}
+
+static void TakeMessages(std::vector<std::string> &messages)
+{
+    std::lock_guard<std::mutex> lock(g_mutex);
+    messages.swap(g_messages);
+    g_messages.clear();
+}
+
+TEST(AsyncLogUT, DeliverInOrderPerThread)
+{
+    CuckooLog::SetExternalLogger(Capture);
+    CuckooLog::SetAsync(true);
+    constexpr int threadNum = 4;
+    constexpr int logNum = 500;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadNum; ++t) {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < logNum; ++i) {
+                CUCKOO_LOG(LOG_INFO) << t << " " << i;
+                /* stay below the ring capacity so that nothing is dropped */
+                if (i % 100 == 99) {
+                    AsyncLogger::GetInstance().Flush();
+                }
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    /* rings of exited threads are still drained */
+    AsyncLogger::GetInstance().Flush();
+    CuckooLog::SetAsync(false);
+
+    std::vector<std::string> messages;
+    TakeMessages(messages);
+    ASSERT_EQ(messages.size(), static_cast<size_t>(threadNum * logNum));
+    std::vector<int> next(threadNum, 0);
+    for (auto &message : messages) {
+        int t = 0;
+        int i = 0;
+        ASSERT_EQ(std::sscanf(message.c_str(), "[CUCKOO] %d %d", &t, &i), 2) << message;
+        ASSERT_EQ(i, next[t]) << message;
+        ++next[t];
+    }
+}
+
+TEST(AsyncLogUT, DeferredFormatMatchesStream)
+{
+    CuckooLog::SetExternalLogger(Capture);
+    CuckooLog::SetAsync(true);
+    std::string str = "str";
+    auto log = [&](auto &&out) {
+        out << "a" << 'b' << str << std::string_view("sv") << -42 << UINT64_MAX << static_cast<short>(-7) << 1.5
+            << 3.14159265358979 << 1e-20 << true << " " << std::hex << 255 << std::dec << 255 << std::setw(6)
+            << "pad" << 2.5f << std::setprecision(3) << 3.14159 << " " << &str << static_cast<int8_t>('x')
+            << static_cast<uint8_t>('y') << std::setw(3) << static_cast<int8_t>('z');
+    };
+    log(CUCKOO_LOG(LOG_INFO));
+    AsyncLogger::GetInstance().Flush();
+    CuckooLog::SetAsync(false);
+
+    std::ostringstream expected;
+    expected << "[CUCKOO] ";
+    log(expected);
+    std::vector<std::string> messages;
+    TakeMessages(messages);
+    ASSERT_EQ(messages.size(), 1U);
+    EXPECT_EQ(messages[0], expected.str());
+}
+
+TEST(AsyncLogUT, NestedLogWhileFormatting)
+{
+    CuckooLog::SetExternalLogger(Capture);
+    CuckooLog::SetAsync(true);
+    auto inner = []() {
+        CUCKOO_LOG(LOG_INFO) << "inner";
+        return "outer";
+    };
+    CUCKOO_LOG(LOG_INFO) << inner();
+    AsyncLogger::GetInstance().Flush();
+    CuckooLog::SetAsync(false);
+
+    std::vector<std::string> messages;
+    TakeMessages(messages);
+    ASSERT_EQ(messages.size(), 2U);
+    EXPECT_EQ(messages[0], "[CUCKOO] inner");
+    EXPECT_EQ(messages[1], "[CUCKOO] outer");
+}
+
+TEST(AsyncLogUT, RateLimitPerCallsite)
+{
+    CuckooLog::SetExternalLogger(Capture);
+    /* a token per 100ms, a burst takes the 10 tokens the bucket starts with */
+    CuckooLog::SetRateLimit(10);
+    auto logBurst = [](int num) {
+        for (int i = 0; i < num; ++i) {
+            CUCKOO_LOG(LOG_WARNING) << "burst";
+        }
+    };
+    logBurst(100);
+    CUCKOO_LOG(LOG_WARNING) << "other callsite";
+
+    /* at least one token is back, a late wakeup may bring more */
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    logBurst(5);
+    CuckooLog::SetRateLimit(0);
+
+    std::vector<std::string> messages;
+    TakeMessages(messages);
+    ASSERT_GE(messages.size(), 12U);
+    ASSERT_LE(messages.size(), 16U);
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_EQ(messages[i], "[CUCKOO] burst");
+    }
+    EXPECT_EQ(messages[10], "[CUCKOO] other callsite");
+    EXPECT_EQ(messages[11], "[CUCKOO] burst [90 similar messages suppressed]");
+    for (size_t i = 12; i < messages.size(); ++i) {
+        EXPECT_EQ(messages[i], "[CUCKOO] burst");
+    }
+}
+
+TEST(AsyncLogUT, RateLimitSparesErrors)
+{
+    CuckooLog::SetExternalLogger(Capture);
+    CuckooLog::SetRateLimit(1);
+    for (int i = 0; i < 50; ++i) {
+        CUCKOO_LOG(LOG_ERROR) << "error " << i;
+    }
+    CuckooLog::SetRateLimit(0);
+
+    std::vector<std::string> messages;
+    TakeMessages(messages);
+    ASSERT_EQ(messages.size(), 50U);
+    for (int i = 0; i < 50; ++i) {
+        EXPECT_EQ(messages[i], "[CUCKOO] error " + std::to_string(i));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
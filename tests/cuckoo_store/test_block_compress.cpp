@@ -0,0 +1,267 @@
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "util/block_compress.h"
+
+/* text like data, compressing a few times over */
+static std::vector<char> TextData(size_t size)
+{
+    static const char *words[] = {"cuckoo ", "store ", "block ", "cache ", "object ", "inode ", "\n"};
+    std::mt19937 gen(size);
+    std::vector<char> data;
+    data.reserve(size + 16);
+    while (data.size() < size) {
+        const char *word = words[gen() % 7];
+        data.insert(data.end(), word, word + strlen(word));
+    }
+    data.resize(size);
+    return data;
+}
+
+static std::vector<char> RandomData(size_t size)
+{
+    std::mt19937 gen(size);
+    std::vector<char> data(size);
+    for (char &c : data) {
+        c = static_cast<char>(gen());
+    }
+    return data;
+}
+
+class BlockCompressUT : public testing::TestWithParam<CompressCodec> {
+  protected:
+    void SetUp() override
+    {
+        if (!CompressCodecAvailable(GetParam())) {
+            GTEST_SKIP() << "codec not built in";
+        }
+        char dirTemplate[] = "/tmp/block_compress_ut_XXXXXX";
+        ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+        dir = dirTemplate;
+    }
+
+    void TearDown() override
+    {
+        if (dir.empty()) {
+            return;
+        }
+        for (const char *name : {"/plain", "/frozen", "/thawed"}) {
+            unlink((dir + name).c_str());
+        }
+        rmdir(dir.c_str());
+    }
+
+    int Create(const std::string &name, const std::vector<char> &data)
+    {
+        int fd = open((dir + name).c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        EXPECT_GE(fd, 0);
+        EXPECT_EQ(pwrite(fd, data.data(), data.size(), 0), static_cast<ssize_t>(data.size()));
+        return fd;
+    }
+
+    /* compress data to frozen, open with its index loaded */
+    int Freeze(const std::vector<char> &data, CompressedIndex &index, uint64_t &compressedSize)
+    {
+        int fd = Create("/plain", data);
+        EXPECT_EQ(CompressFile(fd, dir + "/frozen", GetParam(), compressedSize), 0);
+        close(fd);
+        fd = open((dir + "/frozen").c_str(), O_RDWR);
+        EXPECT_GE(fd, 0);
+        EXPECT_EQ(LoadCompressedIndex(fd, index), 0);
+        return fd;
+    }
+
+    std::string dir;
+};
+
+TEST_P(BlockCompressUT, RandomAccess)
+{
+    std::vector<char> data = TextData(COMPRESS_BLOCK_SIZE * 5 + 1234);
+    CompressedIndex index;
+    uint64_t compressedSize = 0;
+    int fd = Freeze(data, index, compressedSize);
+    EXPECT_LT(compressedSize, data.size() / 2);
+    EXPECT_EQ(index.codec, GetParam());
+    EXPECT_EQ(index.rawSize, data.size());
+    ASSERT_EQ(index.blocks.size(), 6U);
+
+    /* whole blocks, parts of one block, ranges over block ends, the short last block and past the end */
+    std::vector<std::pair<uint64_t, size_t>> ranges = {{0, data.size()},
+                                                       {COMPRESS_BLOCK_SIZE, COMPRESS_BLOCK_SIZE},
+                                                       {100, 10},
+                                                       {COMPRESS_BLOCK_SIZE - 5, 10},
+                                                       {COMPRESS_BLOCK_SIZE * 2 + 7, COMPRESS_BLOCK_SIZE * 2},
+                                                       {data.size() - 10, 100},
+                                                       {data.size(), 10}};
+    for (auto [offset, size] : ranges) {
+        std::vector<char> buf(size);
+        ssize_t expected = std::min<uint64_t>(size, data.size() - offset);
+        ASSERT_EQ(ReadCompressed(fd, index, buf.data(), offset, size), expected);
+        EXPECT_EQ(memcmp(buf.data(), data.data() + offset, expected), 0) << offset;
+    }
+
+    ASSERT_EQ(DecompressFile(fd, index, dir + "/thawed"), 0);
+    close(fd);
+    fd = open((dir + "/thawed").c_str(), O_RDONLY);
+    std::vector<char> thawed(data.size() + 1);
+    EXPECT_EQ(pread(fd, thawed.data(), thawed.size(), 0), static_cast<ssize_t>(data.size()));
+    thawed.resize(data.size());
+    EXPECT_EQ(thawed, data);
+    close(fd);
+}
+
+TEST_P(BlockCompressUT, IncompressibleBlocksKept)
+{
+    /* random data does not shrink and is stored as is, the text after it is compressed */
+    std::vector<char> data = RandomData(COMPRESS_BLOCK_SIZE * 2);
+    std::vector<char> text = TextData(COMPRESS_BLOCK_SIZE);
+    data.insert(data.end(), text.begin(), text.end());
+    CompressedIndex index;
+    uint64_t compressedSize = 0;
+    int fd = Freeze(data, index, compressedSize);
+    ASSERT_EQ(index.blocks.size(), 3U);
+    EXPECT_EQ(index.blocks[0].size, static_cast<uint32_t>(COMPRESS_BLOCK_SIZE));
+    EXPECT_LT(index.blocks[2].size, static_cast<uint32_t>(COMPRESS_BLOCK_SIZE / 2));
+    std::vector<char> buf(data.size());
+    ASSERT_EQ(ReadCompressed(fd, index, buf.data(), 0, buf.size()), static_cast<ssize_t>(data.size()));
+    EXPECT_EQ(buf, data);
+    close(fd);
+}
+
+TEST_P(BlockCompressUT, DamageFound)
+{
+    std::vector<char> data = TextData(COMPRESS_BLOCK_SIZE * 3);
+    CompressedIndex index;
+    uint64_t compressedSize = 0;
+    int fd = Freeze(data, index, compressedSize);
+    /* a flipped byte in the second block, the others still read */
+    char c = 0;
+    off_t damaged = index.blocks[1].offset + index.blocks[1].size / 2;
+    ASSERT_EQ(pread(fd, &c, 1, damaged), 1);
+    c ^= 0x10;
+    ASSERT_EQ(pwrite(fd, &c, 1, damaged), 1);
+    std::vector<char> buf(COMPRESS_BLOCK_SIZE);
+    EXPECT_EQ(ReadCompressed(fd, index, buf.data(), COMPRESS_BLOCK_SIZE + 10, 10), -EIO);
+    EXPECT_EQ(ReadCompressed(fd, index, buf.data(), 0, COMPRESS_BLOCK_SIZE), COMPRESS_BLOCK_SIZE);
+    EXPECT_EQ(ReadCompressed(fd, index, buf.data(), COMPRESS_BLOCK_SIZE * 2, 10), 10);
+
+    /* a damaged index is not trusted */
+    ASSERT_EQ(pwrite(fd, "x", 1, compressedSize - 40), 1);
+    CompressedIndex loaded;
+    EXPECT_EQ(LoadCompressedIndex(fd, loaded), -EBADMSG);
+    close(fd);
+}
+
+TEST_P(BlockCompressUT, RangesFromMemory)
+{
+    /* as a compressed object is read, its tail first and then the bytes holding the blocks read */
+    std::vector<char> data = TextData(COMPRESS_BLOCK_SIZE * 4 + 99);
+    CompressedIndex loaded;
+    uint64_t compressedSize = 0;
+    int fd = Freeze(data, loaded, compressedSize);
+    std::vector<char> object(compressedSize);
+    ASSERT_EQ(pread(fd, object.data(), object.size(), 0), static_cast<ssize_t>(compressedSize));
+    close(fd);
+
+    CompressedIndex index;
+    uint64_t neededSize = 0;
+    ASSERT_EQ(ParseCompressedTail(object.data() + compressedSize - 32, 32, compressedSize, index, neededSize), -ERANGE);
+    ASSERT_GT(neededSize, 32U);
+    const char *tail = object.data() + compressedSize - neededSize;
+    ASSERT_EQ(ParseCompressedTail(tail, neededSize, compressedSize, index, neededSize), 0);
+    EXPECT_EQ(index.rawSize, loaded.rawSize);
+    EXPECT_EQ(index.blocks.size(), loaded.blocks.size());
+
+    std::vector<std::pair<uint64_t, size_t>> ranges = {{0, data.size()},
+                                                       {COMPRESS_BLOCK_SIZE - 5, 10},
+                                                       {COMPRESS_BLOCK_SIZE * 3 + 1, COMPRESS_BLOCK_SIZE},
+                                                       {data.size() - 1, 1}};
+    for (auto [offset, size] : ranges) {
+        uint64_t storedOffset = 0;
+        uint64_t storedSize = 0;
+        StoredRange(index, offset, size, storedOffset, storedSize);
+        ASSERT_LE(storedOffset + storedSize, compressedSize);
+        std::vector<char> buf(size);
+        ASSERT_EQ(DecompressRange(index, object.data() + storedOffset, storedOffset, buf.data(), offset, size),
+                  static_cast<ssize_t>(size));
+        EXPECT_EQ(memcmp(buf.data(), data.data() + offset, size), 0) << offset;
+    }
+
+    object[index.blocks[2].offset + 3] ^= 0x10;
+    std::vector<char> buf(data.size());
+    EXPECT_EQ(DecompressRange(index, object.data(), 0, buf.data(), 0, data.size()), -EIO);
+    EXPECT_EQ(DecompressRange(index, object.data(), 0, buf.data(), 0, COMPRESS_BLOCK_SIZE * 2),
+              COMPRESS_BLOCK_SIZE * 2);
+}
+
+INSTANTIATE_TEST_SUITE_P(Codecs, BlockCompressUT, testing::Values(CompressCodec::LZ4, CompressCodec::ZSTD));
+
+TEST(CompressRulesUT, LongestPrefixWins)
+{
+    if (!CompressCodecAvailable(CompressCodec::LZ4) || !CompressCodecAvailable(CompressCodec::ZSTD)) {
+        GTEST_SKIP() << "codecs not built in";
+    }
+    CompressRules rules;
+    ASSERT_EQ(rules.Parse("/datasets:lz4,/datasets/raw/:none,/logs:zstd"), 0);
+    EXPECT_EQ(rules.Match("/datasets/a.txt"), CompressCodec::LZ4);
+    EXPECT_EQ(rules.Match("/datasets"), CompressCodec::LZ4);
+    EXPECT_EQ(rules.Match("/datasets/raw/b.bin"), CompressCodec::NONE);
+    EXPECT_EQ(rules.Match("/datasets2/a.txt"), CompressCodec::NONE);
+    EXPECT_EQ(rules.Match("/logs/x/y.log"), CompressCodec::ZSTD);
+    EXPECT_EQ(rules.Match("/other"), CompressCodec::NONE);
+
+    ASSERT_EQ(rules.Parse("/:zstd"), 0);
+    EXPECT_EQ(rules.Match("/anything"), CompressCodec::ZSTD);
+
+    EXPECT_EQ(rules.Parse("datasets:lz4"), -EINVAL);
+    EXPECT_EQ(rules.Parse("/datasets:gzip"), -EINVAL);
+    EXPECT_EQ(rules.Parse("/datasets"), -EINVAL);
+    ASSERT_EQ(rules.Parse(""), 0);
+    EXPECT_TRUE(rules.Empty());
+}
+
+TEST(CompressRulesUT, CodecsNotBuiltInRefused)
+{
+    CompressRules rules;
+    EXPECT_EQ(rules.Parse("/a:lz4"), CompressCodecAvailable(CompressCodec::LZ4) ? 0 : -EINVAL);
+    EXPECT_EQ(rules.Parse("/a:zstd"), CompressCodecAvailable(CompressCodec::ZSTD) ? 0 : -EINVAL);
+    EXPECT_EQ(rules.Parse("/a:none"), 0);
+    EXPECT_FALSE(CompressCodecAvailable(CompressCodec::NONE));
+    EXPECT_STREQ(CompressCodecName(CompressCodec::ZSTD), "zstd");
+}
+
+TEST(FrozenFilesUT, OpenFindClose)
+{
+    FrozenFiles frozen;
+    EXPECT_EQ(frozen.Find(3), nullptr);
+    auto index = std::make_shared<CompressedIndex>();
+    frozen.Open(3, index);
+    EXPECT_EQ(frozen.Find(3), index);
+    EXPECT_EQ(frozen.Find(4), nullptr);
+    frozen.Close(3);
+    EXPECT_EQ(frozen.Find(3), nullptr);
+
+    frozen.Mark(1, CompressCodec::LZ4);
+    frozen.Mark(2, CompressCodec::ZSTD);
+    frozen.Mark(2, CompressCodec::NONE);
+    ASSERT_EQ(frozen.Candidates().size(), 1U);
+    frozen.Forget(1);
+    EXPECT_TRUE(frozen.Candidates().empty());
+
+    frozen.SetDamaged(5);
+    EXPECT_TRUE(frozen.TakeDamaged(5));
+    EXPECT_FALSE(frozen.TakeDamaged(5));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
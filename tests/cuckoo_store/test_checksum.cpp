@@ -0,0 +1,246 @@
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "util/checksum.h"
+#include "util/crc32c.h"
+
+static uint32_t Crc32cBitwise(const std::vector<char> &data, size_t begin, size_t end)
+{
+    uint32_t crc = 0xffffffff;
+    for (size_t i = begin; i < end; ++i) {
+        crc ^= static_cast<uint8_t>(data[i]);
+        for (int k = 0; k < 8; ++k) {
+            crc = (crc & 1) != 0 ? (crc >> 1) ^ 0x82f63b78 : crc >> 1;
+        }
+    }
+    return ~crc;
+}
+
+static std::vector<char> RandomData(size_t size)
+{
+    std::mt19937 gen(size);
+    std::vector<char> data(size);
+    for (char &c : data) {
+        c = static_cast<char>(gen());
+    }
+    return data;
+}
+
+TEST(Crc32cUT, KnownValues)
+{
+    EXPECT_EQ(Crc32c(0, "", 0), 0U);
+    EXPECT_EQ(Crc32c(0, "123456789", 9), 0xE3069283U);
+    std::vector<char> zeros(32, 0);
+    EXPECT_EQ(Crc32c(0, zeros.data(), zeros.size()), 0x8A9136AAU);
+    std::vector<char> ones(32, static_cast<char>(0xff));
+    EXPECT_EQ(Crc32c(0, ones.data(), ones.size()), 0x62A8AB43U);
+}
+
+TEST(Crc32cUT, StripesAndChaining)
+{
+    /* long enough for both stripe sizes, from unaligned starts */
+    std::vector<char> data = RandomData(3 * 8192 * 2 + 3 * 256 + 77);
+    for (size_t begin : {0, 1, 3, 7}) {
+        for (size_t end : {begin, begin + 5, begin + 3 * 256, begin + 3 * 8192 + 13, data.size()}) {
+            EXPECT_EQ(Crc32c(0, data.data() + begin, end - begin), Crc32cBitwise(data, begin, end));
+        }
+    }
+    uint32_t crc = Crc32c(0, data.data(), 1000);
+    crc = Crc32c(crc, data.data() + 1000, data.size() - 1000);
+    EXPECT_EQ(crc, Crc32c(0, data.data(), data.size()));
+}
+
+class ChecksumUT : public testing::Test {
+  protected:
+    void SetUp() override
+    {
+        char dirTemplate[] = "/tmp/checksum_ut_XXXXXX";
+        ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+        dir = dirTemplate;
+        table.Start([this](uint64_t inodeId) { return dir + "/" + std::to_string(inodeId) + "-large"; });
+    }
+
+    void TearDown() override
+    {
+        for (uint64_t inodeId : {1, 2}) {
+            table.Remove(inodeId);
+            unlink(FileName(inodeId).c_str());
+        }
+        rmdir(dir.c_str());
+    }
+
+    std::string FileName(uint64_t inodeId) { return dir + "/" + std::to_string(inodeId) + "-large"; }
+
+    int Create(uint64_t inodeId, const std::vector<char> &data)
+    {
+        int fd = open(FileName(inodeId).c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        EXPECT_GE(fd, 0);
+        EXPECT_EQ(pwrite(fd, data.data(), data.size(), 0), static_cast<ssize_t>(data.size()));
+        return fd;
+    }
+
+    /* flip a byte the way a bad disk does, without touching the mtime */
+    void Damage(int fd, off_t offset)
+    {
+        struct stat st;
+        ASSERT_EQ(fstat(fd, &st), 0);
+        char c = 0;
+        ASSERT_EQ(pread(fd, &c, 1, offset), 1);
+        c ^= 0x10;
+        ASSERT_EQ(pwrite(fd, &c, 1, offset), 1);
+        struct timespec times[2] = {st.st_atim, st.st_mtim};
+        ASSERT_EQ(futimens(fd, times), 0);
+    }
+
+    std::string dir;
+    ChecksumTable table;
+};
+
+TEST_F(ChecksumUT, SidecarRoundTrip)
+{
+    std::vector<char> data = RandomData(CHECKSUM_BLOCK_SIZE * 2 + 100);
+    int fd = Create(1, data);
+    FileChecksums sums;
+    ASSERT_EQ(ComputeChecksums(fd, sums), 0);
+    close(fd);
+    ASSERT_EQ(sums.crcs.size(), 3U);
+    EXPECT_EQ(sums.crcs[2], Crc32c(0, data.data() + CHECKSUM_BLOCK_SIZE * 2, 100));
+
+    ASSERT_EQ(SaveChecksums(FileName(1), sums), 0);
+    FileChecksums loaded;
+    ASSERT_EQ(LoadChecksums(FileName(1), loaded), 0);
+    EXPECT_EQ(loaded.crcs, sums.crcs);
+    EXPECT_EQ(loaded.size, sums.size);
+    EXPECT_EQ(loaded.mtimeNs, sums.mtimeNs);
+
+    /* a damaged sidecar is not trusted */
+    int sidecar = open((FileName(1) + CHECKSUM_SUFFIX).c_str(), O_WRONLY);
+    ASSERT_GE(sidecar, 0);
+    ASSERT_EQ(pwrite(sidecar, "x", 1, 30), 1);
+    close(sidecar);
+    EXPECT_EQ(LoadChecksums(FileName(1), loaded), -EBADMSG);
+    EXPECT_EQ(LoadChecksums(FileName(2), loaded), -ENOENT);
+}
+
+TEST_F(ChecksumUT, ReadsVerified)
+{
+    std::vector<char> data = RandomData(CHECKSUM_BLOCK_SIZE * 3 + 10);
+    int fd = Create(1, data);
+    ASSERT_EQ(table.Seal(1), 0);
+    /* whole blocks, partial blocks and the short last block */
+    EXPECT_EQ(table.Verify(1, fd, data.data(), 0, data.size()), 0);
+    EXPECT_EQ(table.Verify(1, fd, data.data() + 100, 100, CHECKSUM_BLOCK_SIZE), 0);
+    EXPECT_EQ(table.Verify(1, fd, data.data() + CHECKSUM_BLOCK_SIZE * 3, CHECKSUM_BLOCK_SIZE * 3, 10), 0);
+    EXPECT_EQ(table.VerifyRange(1, fd, 0, data.size()), 0);
+
+    /* bad data in a whole block read is caught on every read */
+    Damage(fd, CHECKSUM_BLOCK_SIZE + 5);
+    std::vector<char> read(data.size());
+    ASSERT_EQ(pread(fd, read.data(), read.size(), 0), static_cast<ssize_t>(read.size()));
+    EXPECT_EQ(table.Verify(1, fd, read.data(), 0, read.size()), -EIO);
+    EXPECT_TRUE(table.Corrupt(1));
+    EXPECT_EQ(table.GetMismatchNum(), 1U);
+    close(fd);
+}
+
+TEST_F(ChecksumUT, PartialBlocksReadWhole)
+{
+    std::vector<char> data = RandomData(CHECKSUM_BLOCK_SIZE * 2);
+    int fd = Create(1, data);
+    ASSERT_EQ(table.Seal(1), 0);
+    Damage(fd, CHECKSUM_BLOCK_SIZE + 1000);
+    /* the bad byte is not in the range read, the block is still read whole and found bad */
+    EXPECT_EQ(table.Verify(1, fd, data.data() + CHECKSUM_BLOCK_SIZE, CHECKSUM_BLOCK_SIZE, 10), -EIO);
+    EXPECT_EQ(table.VerifyRange(1, fd, CHECKSUM_BLOCK_SIZE * 2 - 1, 1), -EIO);
+    EXPECT_EQ(table.VerifyRange(1, fd, 0, 1), 0);
+    close(fd);
+}
+
+TEST_F(ChecksumUT, SplicedRangesVerifiedFirst)
+{
+    std::vector<char> data = RandomData(CHECKSUM_BLOCK_SIZE * 4);
+    int fd = Create(1, data);
+    EXPECT_TRUE(table.Verified(1, fd, 0, CHECKSUM_BLOCK_SIZE * 4));
+    ASSERT_EQ(table.Seal(1), 0);
+    /* blocks are spliced only once a read has checked them */
+    EXPECT_FALSE(table.Verified(1, fd, 0, CHECKSUM_BLOCK_SIZE * 2));
+    EXPECT_EQ(table.Verify(1, fd, data.data() + 10, 10, CHECKSUM_BLOCK_SIZE), 0);
+    EXPECT_TRUE(table.Verified(1, fd, 0, CHECKSUM_BLOCK_SIZE * 2));
+    EXPECT_FALSE(table.Verified(1, fd, CHECKSUM_BLOCK_SIZE, CHECKSUM_BLOCK_SIZE * 2));
+
+    /* a damaged block is never marked checked */
+    Damage(fd, CHECKSUM_BLOCK_SIZE * 3 + 7);
+    EXPECT_EQ(table.VerifyRange(1, fd, CHECKSUM_BLOCK_SIZE * 2, CHECKSUM_BLOCK_SIZE * 2), -EIO);
+    EXPECT_TRUE(table.Verified(1, fd, CHECKSUM_BLOCK_SIZE * 2, CHECKSUM_BLOCK_SIZE));
+    EXPECT_FALSE(table.Verified(1, fd, CHECKSUM_BLOCK_SIZE * 3, 1));
+    close(fd);
+}
+
+TEST_F(ChecksumUT, SealsQueuedOnce)
+{
+    std::vector<char> data = RandomData(CHECKSUM_BLOCK_SIZE);
+    int fd = Create(1, data);
+    EXPECT_TRUE(table.QueueSeal(1));
+    EXPECT_FALSE(table.QueueSeal(1));
+    EXPECT_TRUE(table.QueueSeal(2));
+    /* a close after the seal started queues the next one */
+    table.TakeSeal(1);
+    EXPECT_TRUE(table.QueueSeal(1));
+    table.TakeSeal(1);
+    ASSERT_EQ(table.Seal(1), 0);
+    EXPECT_EQ(table.Verify(1, fd, data.data(), 0, data.size()), 0);
+    /* a removed file has no seal queued */
+    table.Remove(2);
+    EXPECT_TRUE(table.QueueSeal(2));
+    close(fd);
+}
+
+TEST_F(ChecksumUT, WrittenFileNotReported)
+{
+    std::vector<char> data = RandomData(CHECKSUM_BLOCK_SIZE);
+    int fd = Create(1, data);
+    ASSERT_EQ(table.Seal(1), 0);
+    /* written later, the checksums are old and the file is unchecked until sealed again */
+    usleep(10000);
+    data[7] ^= 1;
+    ASSERT_EQ(pwrite(fd, data.data(), data.size(), 0), static_cast<ssize_t>(data.size()));
+    EXPECT_EQ(table.Verify(1, fd, data.data(), 0, data.size()), 0);
+    EXPECT_FALSE(table.Corrupt(1));
+    ASSERT_EQ(table.Seal(1), 0);
+    data[7] ^= 1;
+    EXPECT_EQ(table.Verify(1, fd, data.data(), 0, data.size()), -EIO);
+    close(fd);
+}
+
+TEST_F(ChecksumUT, LoadedFromSidecar)
+{
+    std::vector<char> data = RandomData(CHECKSUM_BLOCK_SIZE + 1);
+    int fd = Create(2, data);
+    ASSERT_EQ(table.Seal(2), 0);
+    /* a new table, as after a restart */
+    ChecksumTable restarted;
+    restarted.Start([this](uint64_t inodeId) { return FileName(inodeId); });
+    EXPECT_EQ(restarted.Verify(2, fd, data.data(), 0, data.size()), 0);
+    data[0] ^= 1;
+    EXPECT_EQ(restarted.Verify(2, fd, data.data(), 0, data.size()), -EIO);
+    EXPECT_EQ(restarted.Size(), 1U);
+
+    restarted.Remove(2);
+    EXPECT_EQ(access((FileName(2) + CHECKSUM_SUFFIX).c_str(), F_OK), -1);
+    EXPECT_EQ(restarted.Verify(2, fd, data.data(), 0, data.size()), 0);
+    close(fd);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
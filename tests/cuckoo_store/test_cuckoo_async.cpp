@@ -0,0 +1,306 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "brpc/brpc_server.h"
+#include "conf/cuckoo_property_key.h"
+#include "cuckoo_async.h"
+#include "cuckoo_meta.h"
+#include "init/cuckoo_init.h"
+#include "remote_connection_utils/error_code_def.h"
+
+/* the async libFS api against the cluster of the test config */
+class CuckooAsyncUT : public testing::Test {
+  public:
+    static void SetUpTestSuite()
+    {
+        int ret = GetInit().Init();
+        if (ret != 0) {
+            exit(1);
+        }
+        auto config = GetInit().GetCuckooConfig();
+        cuckoo::brpc_io::RemoteIOServer &server = cuckoo::brpc_io::RemoteIOServer::GetInstance();
+        std::string clusterView = config->GetArray(CuckooPropertyKey::CUCKOO_CLUSTER_VIEW);
+        std::vector<std::string> views;
+        std::stringstream ss(clusterView);
+        while (ss.good()) {
+            std::string substr;
+            getline(ss, substr, ',');
+            views.push_back(substr);
+        }
+        server.endPoint = views[config->GetUint32(CuckooPropertyKey::CUCKOO_NODE_ID)];
+        std::thread brpcServerThread(&cuckoo::brpc_io::RemoteIOServer::Run, &server);
+        {
+            std::unique_lock<std::mutex> lk(server.mutexStart);
+            server.cvStart.wait(lk, [&server]() { return server.isStarted; });
+        }
+        brpcServerThread.detach();
+
+        std::string serverIp = config->GetString(CuckooPropertyKey::CUCKOO_SERVER_IP);
+        int serverPort = std::stoi(config->GetString(CuckooPropertyKey::CUCKOO_SERVER_PORT));
+        ret = CuckooInit(serverIp, serverPort);
+        if (ret != SUCCESS) {
+            exit(1);
+        }
+        server.SetReadyFlag();
+        CuckooMkdir(root);
+    }
+
+    static void TearDownTestSuite()
+    {
+        CuckooRmDir(root);
+        cuckoo::brpc_io::RemoteIOServer::GetInstance().Stop();
+    }
+
+    static inline const std::string root = "/async_ut";
+};
+
+TEST_F(CuckooAsyncUT, WindowBoundsInflight)
+{
+    CuckooAsyncWindow &window = CuckooAsyncWindow::GetInstance();
+    window.SetMaxInflight(2);
+    std::atomic<int> running = 0;
+    std::atomic<int> maxRunning = 0;
+    std::atomic<int> doneNum = 0;
+    for (uint64_t fd = 0; fd < 32; ++fd) {
+        int ret = window.Submit(
+            fd,
+            true,
+            [&](CuckooAsyncCallback complete) {
+                int now = ++running;
+                int seen = maxRunning.load();
+                while (now > seen && !maxRunning.compare_exchange_weak(seen, now)) {
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                --running;
+                complete(0);
+            },
+            [&](int) { ++doneNum; });
+        ASSERT_EQ(ret, 0);
+    }
+    window.Drain();
+    EXPECT_EQ(window.GetInflight(), 0U);
+    EXPECT_LE(maxRunning.load(), 2);
+    window.SetMaxInflight(0);
+    while (doneNum.load() < 32) {
+        std::this_thread::yield();
+    }
+}
+
+TEST_F(CuckooAsyncUT, OrderPerFd)
+{
+    /* exclusive ops of one fd run one by one in submit order */
+    CuckooAsyncWindow &window = CuckooAsyncWindow::GetInstance();
+    std::mutex mutex;
+    std::vector<int> order;
+    std::atomic<int> running = 0;
+    std::atomic<bool> overlapped = false;
+    const int opNum = 64;
+    std::vector<std::future<int>> futures;
+    for (int i = 0; i < opNum; ++i) {
+        auto promise = std::make_shared<std::promise<int>>();
+        futures.push_back(promise->get_future());
+        window.Submit(
+            1,
+            true,
+            [&, i](CuckooAsyncCallback complete) {
+                if (++running > 1) {
+                    overlapped = true;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    order.push_back(i);
+                }
+                --running;
+                complete(i);
+            },
+            [promise](int ret) { promise->set_value(ret); });
+    }
+    for (int i = 0; i < opNum; ++i) {
+        EXPECT_EQ(futures[i].get(), i);
+    }
+    EXPECT_FALSE(overlapped.load());
+    std::vector<int> expected(opNum);
+    for (int i = 0; i < opNum; ++i) {
+        expected[i] = i;
+    }
+    EXPECT_EQ(order, expected);
+}
+
+TEST_F(CuckooAsyncUT, SharedOpsOverlap)
+{
+    /* shared ops of one fd run together, an exclusive op waits for them and holds back the ones after it */
+    CuckooAsyncWindow &window = CuckooAsyncWindow::GetInstance();
+    std::mutex mutex;
+    std::vector<std::string> order;
+    std::atomic<int> running = 0;
+    std::atomic<int> maxShared = 0;
+    std::atomic<bool> overlapped = false;
+    auto shared = [&](std::string name) {
+        return [&, name](CuckooAsyncCallback complete) {
+            int now = ++running;
+            int seen = maxShared.load();
+            while (now > seen && !maxShared.compare_exchange_weak(seen, now)) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(name);
+            }
+            --running;
+            complete(0);
+        };
+    };
+    auto exclusive = [&](std::string name) {
+        return [&, name](CuckooAsyncCallback complete) {
+            if (++running > 1) {
+                overlapped = true;
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                order.push_back(name);
+            }
+            --running;
+            complete(0);
+        };
+    };
+    std::vector<std::future<int>> futures;
+    auto submit = [&](bool isExclusive, std::function<void(CuckooAsyncCallback)> op) {
+        auto promise = std::make_shared<std::promise<int>>();
+        futures.push_back(promise->get_future());
+        window.Submit(2, isExclusive, std::move(op), [promise](int ret) { promise->set_value(ret); });
+    };
+    submit(false, shared("r0"));
+    submit(false, shared("r1"));
+    submit(false, shared("r2"));
+    submit(true, exclusive("w"));
+    submit(false, shared("r3"));
+    submit(false, shared("r4"));
+    submit(true, exclusive("c"));
+    for (auto &future : futures) {
+        EXPECT_EQ(future.get(), 0);
+    }
+    window.Drain();
+    EXPECT_GE(maxShared.load(), 2);
+    EXPECT_FALSE(overlapped.load());
+    ASSERT_EQ(order.size(), 7U);
+    std::vector<std::string> head(order.begin(), order.begin() + 3);
+    std::sort(head.begin(), head.end());
+    EXPECT_EQ(head, (std::vector<std::string>{"r0", "r1", "r2"}));
+    EXPECT_EQ(order[3], "w");
+    std::vector<std::string> tail(order.begin() + 4, order.begin() + 6);
+    std::sort(tail.begin(), tail.end());
+    EXPECT_EQ(tail, (std::vector<std::string>{"r3", "r4"}));
+    EXPECT_EQ(order[6], "c");
+}
+
+TEST_F(CuckooAsyncUT, WriteReadClose)
+{
+    std::string path = root + "/write_read_close";
+    uint64_t fd = 0;
+    struct stat st;
+    ASSERT_EQ(CuckooCreate(path, fd, O_CREAT | O_WRONLY, &st), SUCCESS);
+
+    /* writes are submitted back to back, they reach the file in order */
+    const int blockNum = 64;
+    const size_t blockSize = 4096;
+    std::vector<std::string> blocks;
+    for (int i = 0; i < blockNum; ++i) {
+        blocks.emplace_back(blockSize, static_cast<char>('a' + i % 26));
+    }
+    std::mutex mutex;
+    std::vector<int> doneOrder;
+    std::vector<std::future<int>> writes;
+    for (int i = 0; i < blockNum; ++i) {
+        auto promise = std::make_shared<std::promise<int>>();
+        writes.push_back(promise->get_future());
+        int ret = CuckooWriteAsync(fd, path, blocks[i].data(), blockSize, i * blockSize, [&, i, promise](int opRet) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                doneOrder.push_back(i);
+            }
+            promise->set_value(opRet);
+        });
+        ASSERT_EQ(ret, 0);
+    }
+    /* close is queued behind the writes of fd */
+    std::future<int> close = CuckooCloseAsync(path, fd);
+    for (auto &write : writes) {
+        EXPECT_EQ(write.get(), 0);
+    }
+    EXPECT_EQ(close.get(), 0);
+    EXPECT_TRUE(std::is_sorted(doneOrder.begin(), doneOrder.end()));
+
+    struct stat statBuf;
+    ASSERT_EQ(CuckooGetStatAsync(path, &statBuf).get(), 0);
+    EXPECT_EQ(statBuf.st_size, static_cast<off_t>(blockNum * blockSize));
+
+    uint64_t readFd = 0;
+    ASSERT_EQ(CuckooOpenAsync(path, O_RDONLY, &readFd, &st).get(), 0);
+    std::string data(blockNum * blockSize, '\0');
+    /* reads of fd overlap, the close behind them runs once all have returned */
+    std::vector<std::future<int>> reads;
+    for (int i = 0; i < blockNum; ++i) {
+        reads.push_back(CuckooReadAsync(path, readFd, data.data() + i * blockSize, blockSize, i * blockSize));
+    }
+    std::future<int> readClose = CuckooCloseAsync(path, readFd);
+    std::future<int> afterClose = CuckooReadAsync(path, readFd, data.data(), blockSize, 0);
+    for (auto &read : reads) {
+        EXPECT_EQ(read.get(), static_cast<int>(blockSize));
+    }
+    EXPECT_EQ(readClose.get(), 0);
+    EXPECT_EQ(afterClose.get(), -EBADF);
+    for (int i = 0; i < blockNum; ++i) {
+        EXPECT_EQ(data.substr(i * blockSize, blockSize), blocks[i]);
+    }
+
+    /* close releases fd once */
+    EXPECT_EQ(CuckooCloseAsync(path, readFd).get(), -EBADF);
+    EXPECT_EQ(CuckooRead(path, readFd, data.data(), blockSize, 0), NOT_FOUND_FD);
+
+    CuckooAsyncWindow::GetInstance().Drain();
+    EXPECT_EQ(CuckooAsyncWindow::GetInstance().GetInflight(), 0U);
+    EXPECT_EQ(CuckooUnlink(path), SUCCESS);
+}
+
+TEST_F(CuckooAsyncUT, ErrorPropagation)
+{
+    std::string missing = root + "/missing";
+    struct stat st;
+    uint64_t fd = 0;
+    char buf[16];
+    /* errors of the cluster come back as -errno like the rest */
+    EXPECT_EQ(CuckooGetStatAsync(missing, &st).get(), -ENOENT);
+    EXPECT_EQ(CuckooOpenAsync(missing, O_RDONLY, &fd, &st).get(), -ENOENT);
+    EXPECT_EQ(CuckooReadAsync(missing, UINT64_MAX - 1, buf, sizeof(buf), 0).get(), -EBADF);
+    EXPECT_EQ(CuckooWriteAsync(UINT64_MAX - 1, missing, buf, sizeof(buf), 0).get(), -EBADF);
+    EXPECT_EQ(CuckooCloseAsync(missing, UINT64_MAX - 1).get(), -EBADF);
+
+    /* bad arguments fail the call, the callback is not called */
+    bool called = false;
+    EXPECT_EQ(CuckooReadAsync(missing, 0, nullptr, sizeof(buf), 0, [&](int) { called = true; }), -EINVAL);
+    EXPECT_EQ(CuckooWriteAsync(0, missing, nullptr, sizeof(buf), 0, [&](int) { called = true; }), -EINVAL);
+    EXPECT_EQ(CuckooGetStatAsync(missing, nullptr, [&](int) { called = true; }), -EINVAL);
+    EXPECT_EQ(CuckooOpenAsync(missing, O_RDONLY, nullptr, &st, [&](int) { called = true; }), -EINVAL);
+    CuckooAsyncWindow::GetInstance().Drain();
+    EXPECT_FALSE(called);
+    EXPECT_EQ(CuckooAsyncWindow::GetInstance().GetInflight(), 0U);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
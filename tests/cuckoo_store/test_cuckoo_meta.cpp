@@ -0,0 +1,280 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "brpc/brpc_server.h"
+#include "conf/cuckoo_property_key.h"
+#include "cuckoo_meta.h"
+#include "init/cuckoo_init.h"
+#include "remote_connection_utils/error_code_def.h"
+
+/* xattr, symlink and hard link metadata services against the cluster of the test config */
+class CuckooMetaUT : public testing::Test {
+  public:
+    static void SetUpTestSuite()
+    {
+        int ret = GetInit().Init();
+        if (ret != 0) {
+            exit(1);
+        }
+        auto config = GetInit().GetCuckooConfig();
+        cuckoo::brpc_io::RemoteIOServer &server = cuckoo::brpc_io::RemoteIOServer::GetInstance();
+        std::string clusterView = config->GetArray(CuckooPropertyKey::CUCKOO_CLUSTER_VIEW);
+        std::vector<std::string> views;
+        std::stringstream ss(clusterView);
+        while (ss.good()) {
+            std::string substr;
+            getline(ss, substr, ',');
+            views.push_back(substr);
+        }
+        server.endPoint = views[config->GetUint32(CuckooPropertyKey::CUCKOO_NODE_ID)];
+        std::thread brpcServerThread(&cuckoo::brpc_io::RemoteIOServer::Run, &server);
+        {
+            std::unique_lock<std::mutex> lk(server.mutexStart);
+            server.cvStart.wait(lk, [&server]() { return server.isStarted; });
+        }
+        brpcServerThread.detach();
+
+        std::string serverIp = config->GetString(CuckooPropertyKey::CUCKOO_SERVER_IP);
+        int serverPort = std::stoi(config->GetString(CuckooPropertyKey::CUCKOO_SERVER_PORT));
+        ret = CuckooInit(serverIp, serverPort);
+        if (ret != SUCCESS) {
+            exit(1);
+        }
+        server.SetReadyFlag();
+        CuckooMkdir(root);
+    }
+
+    static void TearDownTestSuite()
+    {
+        CuckooRmDir(root);
+        cuckoo::brpc_io::RemoteIOServer::GetInstance().Stop();
+    }
+
+    static void Create(const std::string &path)
+    {
+        uint64_t fd = 0;
+        struct stat st;
+        ASSERT_EQ(CuckooCreate(path, fd, O_CREAT | O_WRONLY, &st), SUCCESS);
+        ASSERT_EQ(CuckooClose(path, fd), SUCCESS);
+    }
+
+    static inline const std::string root = "/meta_ut";
+};
+
+TEST_F(CuckooMetaUT, Xattr)
+{
+    std::string path = root + "/xattr";
+    Create(path);
+
+    /* values are binary, embedded zeros survive */
+    std::string value("a\0b\xff", 4);
+    EXPECT_EQ(CuckooSetXattr(path, "user.bin", value.data(), value.size(), 0), SUCCESS);
+    EXPECT_EQ(CuckooSetXattr(path, "user.text", "abc", 3, 0), SUCCESS);
+    std::string got;
+    EXPECT_EQ(CuckooGetXattr(path, "user.bin", got), SUCCESS);
+    EXPECT_EQ(got, value);
+
+    /* create only adds, replace only overwrites */
+    EXPECT_EQ(CuckooSetXattr(path, "user.text", "x", 1, XATTR_CREATE), XKEY_EXISTS);
+    EXPECT_EQ(CuckooSetXattr(path, "user.none", "x", 1, XATTR_REPLACE), XKEY_NOT_EXISTS);
+    EXPECT_EQ(CuckooSetXattr(path, "user.text", "defg", 4, XATTR_REPLACE), SUCCESS);
+    EXPECT_EQ(CuckooGetXattr(path, "user.text", got), SUCCESS);
+    EXPECT_EQ(got, "defg");
+
+    std::vector<std::string> keys;
+    EXPECT_EQ(CuckooListXattr(path, keys), SUCCESS);
+    std::sort(keys.begin(), keys.end());
+    EXPECT_EQ(keys, (std::vector<std::string>{"user.bin", "user.text"}));
+
+    EXPECT_EQ(CuckooRemoveXattr(path, "user.bin"), SUCCESS);
+    EXPECT_EQ(CuckooRemoveXattr(path, "user.bin"), XKEY_NOT_EXISTS);
+    EXPECT_EQ(CuckooGetXattr(path, "user.bin", got), XKEY_NOT_EXISTS);
+    EXPECT_EQ(CuckooGetXattr(root + "/none", "user.bin", got), FILE_NOT_EXISTS);
+
+    /* xattrs go with the file */
+    EXPECT_EQ(CuckooUnlink(path), SUCCESS);
+    Create(path);
+    EXPECT_EQ(CuckooGetXattr(path, "user.text", got), XKEY_NOT_EXISTS);
+    EXPECT_EQ(CuckooUnlink(path), SUCCESS);
+}
+
+TEST_F(CuckooMetaUT, XattrBatched)
+{
+    /* concurrent requests are batched by the meta server, a failing one must not fail the others */
+    std::string path = root + "/xattr_batched";
+    Create(path);
+    const int threadNum = 16;
+    std::vector<std::thread> threads;
+    std::vector<int> setRets(threadNum, -1);
+    std::vector<int> missRets(threadNum, -1);
+    for (int i = 0; i < threadNum; ++i) {
+        threads.emplace_back([&, i]() {
+            std::string key = "user.k" + std::to_string(i);
+            setRets[i] = CuckooSetXattr(path, key, key.data(), key.size(), XATTR_CREATE);
+            std::string got;
+            missRets[i] = CuckooGetXattr(path, "user.none", got);
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    for (int i = 0; i < threadNum; ++i) {
+        EXPECT_EQ(setRets[i], SUCCESS);
+        EXPECT_EQ(missRets[i], XKEY_NOT_EXISTS);
+        std::string key = "user.k" + std::to_string(i);
+        std::string got;
+        EXPECT_EQ(CuckooGetXattr(path, key, got), SUCCESS);
+        EXPECT_EQ(got, key);
+    }
+    EXPECT_EQ(CuckooUnlink(path), SUCCESS);
+}
+
+TEST_F(CuckooMetaUT, SymlinkReadlink)
+{
+    std::string path = root + "/symlink";
+    std::string target = "../some/where/file";
+    ASSERT_EQ(CuckooSymlink(target, path), SUCCESS);
+    EXPECT_EQ(CuckooSymlink(target, path), FILE_EXISTS);
+
+    std::string got;
+    EXPECT_EQ(CuckooReadlink(path, got), SUCCESS);
+    EXPECT_EQ(got, target);
+    struct stat st;
+    ASSERT_EQ(CuckooGetStat(path, &st), SUCCESS);
+    EXPECT_TRUE(S_ISLNK(st.st_mode));
+    EXPECT_EQ(st.st_size, static_cast<off_t>(target.size()));
+
+    /* a regular file is not a link */
+    std::string file = root + "/not_symlink";
+    Create(file);
+    EXPECT_EQ(CuckooReadlink(file, got), ARGUMENT_ERROR);
+
+    EXPECT_EQ(CuckooUnlink(path), SUCCESS);
+    EXPECT_EQ(CuckooReadlink(path, got), FILE_NOT_EXISTS);
+    EXPECT_EQ(CuckooUnlink(file), SUCCESS);
+}
+
+TEST_F(CuckooMetaUT, LinkNlink)
+{
+    std::string src = root + "/link_src";
+    std::string dst = root + "/link_dst";
+    Create(src);
+    int ret = CuckooLink(src, dst);
+    if (ret == CROSS_WORKER_LINK) {
+        CuckooUnlink(src);
+        GTEST_SKIP() << "names are owned by different workers";
+    }
+    ASSERT_EQ(ret, SUCCESS);
+    EXPECT_EQ(CuckooLink(src, dst), FILE_EXISTS);
+
+    struct stat srcSt;
+    struct stat dstSt;
+    ASSERT_EQ(CuckooGetStat(src, &srcSt), SUCCESS);
+    ASSERT_EQ(CuckooGetStat(dst, &dstSt), SUCCESS);
+    EXPECT_EQ(srcSt.st_ino, dstSt.st_ino);
+    EXPECT_EQ(srcSt.st_nlink, 2U);
+    EXPECT_EQ(dstSt.st_nlink, 2U);
+
+    /* removing one name leaves the other with the inode */
+    ino_t ino = srcSt.st_ino;
+    EXPECT_EQ(CuckooUnlink(src), SUCCESS);
+    EXPECT_EQ(CuckooGetStat(src, &srcSt), FILE_NOT_EXISTS);
+    ASSERT_EQ(CuckooGetStat(dst, &dstSt), SUCCESS);
+    EXPECT_EQ(dstSt.st_nlink, 1U);
+    EXPECT_EQ(dstSt.st_ino, ino);
+    EXPECT_EQ(CuckooUnlink(dst), SUCCESS);
+}
+
+TEST_F(CuckooMetaUT, LinkSharesAttributes)
+{
+    std::string src = root + "/shared_src";
+    std::string dst = root + "/shared_dst";
+    Create(src);
+    int ret = CuckooLink(src, dst);
+    if (ret == CROSS_WORKER_LINK) {
+        CuckooUnlink(src);
+        GTEST_SKIP() << "names are owned by different workers";
+    }
+    ASSERT_EQ(ret, SUCCESS);
+
+    /* written through one name, seen through the other */
+    std::string data(256 * 1024, 'x');
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<char>('a' + i % 26);
+    }
+    uint64_t fd = 0;
+    struct stat st;
+    ASSERT_EQ(CuckooOpen(src, O_WRONLY, fd, &st), SUCCESS);
+    ASSERT_EQ(CuckooWrite(fd, src, data.data(), data.size(), 0), SUCCESS);
+    ASSERT_EQ(CuckooClose(src, fd), SUCCESS);
+    ASSERT_EQ(CuckooGetStat(dst, &st), SUCCESS);
+    EXPECT_EQ(st.st_size, static_cast<off_t>(data.size()));
+    ASSERT_EQ(CuckooOpen(dst, O_RDONLY, fd, &st), SUCCESS);
+    EXPECT_EQ(st.st_size, static_cast<off_t>(data.size()));
+    std::string got(data.size(), '\0');
+    EXPECT_EQ(CuckooRead(dst, fd, got.data(), got.size(), 0), static_cast<int>(got.size()));
+    EXPECT_EQ(got, data);
+    EXPECT_EQ(CuckooClose(dst, fd), SUCCESS);
+
+    EXPECT_EQ(CuckooChmod(dst, 0600), SUCCESS);
+    ASSERT_EQ(CuckooGetStat(src, &st), SUCCESS);
+    EXPECT_EQ(st.st_mode & 0777, 0600U);
+    EXPECT_EQ(CuckooTruncate(dst, 1000), SUCCESS);
+    ASSERT_EQ(CuckooGetStat(src, &st), SUCCESS);
+    EXPECT_EQ(st.st_size, 1000);
+
+    /* the last name keeps the attributes */
+    EXPECT_EQ(CuckooUnlink(src), SUCCESS);
+    ASSERT_EQ(CuckooGetStat(dst, &st), SUCCESS);
+    EXPECT_EQ(st.st_nlink, 1U);
+    EXPECT_EQ(st.st_size, 1000);
+    EXPECT_EQ(CuckooUnlink(dst), SUCCESS);
+}
+
+TEST_F(CuckooMetaUT, LockInterrupted)
+{
+    /* the lock node is polled when it is another node, waited on in place otherwise */
+    std::string path = root + "/lock_interrupted";
+    uint64_t fd = 0;
+    struct stat st;
+    ASSERT_EQ(CuckooCreate(path, fd, O_CREAT | O_RDWR, &st), SUCCESS);
+    struct flock lock = {};
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    ASSERT_EQ(CuckooLock(path, fd, F_SETLK, &lock, 1), 0);
+
+    std::atomic<bool> signalled = false;
+    auto waiting = std::async(std::launch::async, [&]() {
+        struct flock wait = {};
+        wait.l_type = F_RDLCK;
+        wait.l_whence = SEEK_SET;
+        return CuckooLock(path, fd, F_SETLKW, &wait, 2, [&signalled]() { return signalled.load(); });
+    });
+    EXPECT_EQ(waiting.wait_for(std::chrono::milliseconds(200)), std::future_status::timeout);
+    signalled = true;
+    ASSERT_EQ(waiting.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(waiting.get(), -EINTR);
+
+    lock.l_type = F_UNLCK;
+    EXPECT_EQ(CuckooLock(path, fd, F_SETLK, &lock, 1), 0);
+    EXPECT_EQ(CuckooClose(path, fd), SUCCESS);
+    EXPECT_EQ(CuckooUnlink(path), SUCCESS);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,76 @@
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "stats/cuckoo_metrics.h"
+#include "stats/cuckoo_stats.h"
+
+TEST(CuckooMetricsUT, StatsCounters)
+{
+    CuckooStats::GetInstance().stats[FUSE_READ] += 4096;
+    std::string text = CuckooMetrics::GetInstance().Render();
+    EXPECT_NE(text.find("# TYPE cuckoo_fuse_read_bytes_total counter\n"), std::string::npos);
+    EXPECT_NE(text.find("\ncuckoo_fuse_read_bytes_total 4096\n"), std::string::npos);
+}
+
+TEST(CuckooMetricsUT, RegisteredGauge)
+{
+    CuckooMetrics &metrics = CuckooMetrics::GetInstance();
+    metrics.RegisterGauge("ut_queue_depth", "Queue depth.", []() { return 3.0; }, "priority=\"foreground\"");
+    metrics.RegisterGauge("ut_queue_depth", "Queue depth.", []() { return 5.0; }, "priority=\"background\"");
+    metrics.RegisterCounter("ut_steals_total", "Steals.", []() { return 7.0; });
+    std::string text = metrics.Render();
+    EXPECT_NE(text.find("# HELP ut_queue_depth Queue depth.\n# TYPE ut_queue_depth gauge\n"), std::string::npos);
+    EXPECT_NE(text.find("ut_queue_depth{priority=\"foreground\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("ut_queue_depth{priority=\"background\"} 5\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE ut_steals_total counter\nut_steals_total 7\n"), std::string::npos);
+
+    metrics.Unregister("ut_queue_depth");
+    metrics.Unregister("ut_steals_total");
+    text = metrics.Render();
+    EXPECT_EQ(text.find("ut_queue_depth"), std::string::npos);
+    EXPECT_EQ(text.find("ut_steals_total"), std::string::npos);
+}
+
+TEST(CuckooMetricsUT, RegisterTwice)
+{
+    /* a module started again registers the same samples, each is still exported once */
+    CuckooMetrics &metrics = CuckooMetrics::GetInstance();
+    metrics.RegisterGauge("ut_items", "Items.", []() { return 1.0; }, "kind=\"a\"");
+    metrics.RegisterGauge("ut_items", "Items.", []() { return 2.0; }, "kind=\"b\"");
+    metrics.RegisterGauge("ut_items", "Items.", []() { return 3.0; }, "kind=\"a\"");
+    metrics.RegisterCounter("ut_runs_total", "Runs.", []() { return 1.0; });
+    metrics.RegisterCounter("ut_runs_total", "Runs.", []() { return 4.0; });
+    std::string text = metrics.Render();
+    EXPECT_EQ(text.find("# TYPE ut_items gauge\n"), text.rfind("# TYPE ut_items gauge\n"));
+    EXPECT_EQ(text.find("ut_items{kind=\"a\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("ut_items{kind=\"a\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("ut_items{kind=\"b\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("# TYPE ut_runs_total counter\nut_runs_total 4\n"), std::string::npos);
+    EXPECT_EQ(text.find("ut_runs_total 1\n"), std::string::npos);
+
+    metrics.Unregister("ut_items");
+    metrics.Unregister("ut_runs_total");
+}
+
+TEST(CuckooMetricsUT, Histogram)
+{
+    /* 1500ns lands in the 2^11 bucket, 3ms in the 2^22 one */
+    LatencyHistograms::GetInstance().Record(HIST_OBJ_GET, 1500);
+    LatencyHistograms::GetInstance().Record(HIST_OBJ_GET, 3000000);
+    std::string text = CuckooMetrics::GetInstance().Render();
+    const std::string name = "cuckoo_obs_get_latency_seconds";
+    EXPECT_NE(text.find("# TYPE " + name + " histogram\n"), std::string::npos);
+    EXPECT_NE(text.find(name + "_bucket{le=\"1.024e-06\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find(name + "_bucket{le=\"2.048e-06\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find(name + "_bucket{le=\"0.004194304\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find(name + "_bucket{le=\"+Inf\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find(name + "_sum 0.0030015\n"), std::string::npos);
+    EXPECT_NE(text.find(name + "_count 2\n"), std::string::npos);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,5 +1,11 @@
 #include "test_cuckoo_store.h"
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <brpc/channel.h>
+
 #include "connection/node.h"
 
 std::shared_ptr<CuckooConfig> CuckooStoreUT::config = GetInit().GetCuckooConfig();
@@ -330,11 +336,35 @@ TEST_F(CuckooStoreUT, WriteRemoteRandom)
     ret = CuckooStore::GetInstance()->WriteFile(openInstance.get(), buf, size, 0);
     EXPECT_EQ(ret, 0);
     bufferedSize = openInstance->writeStream.GetSize();
-    EXPECT_EQ(bufferedSize, size);
+    EXPECT_EQ(bufferedSize, size * 2);
     EXPECT_EQ(openInstance->currentSize.load(), size * 2);
     free(buf);
 }
 
+TEST_F(CuckooStoreUT, WriteRemoteInterleaved)
+{
+    NewOpenInstance(2000, StoreNode::GetInstance()->GetNodeId() + 1, "/WriteRemote", O_WRONLY);
+
+    size_t size = CUCKOO_STORE_STREAM_MAX_SIZE / 4;
+    char *buf = (char *)malloc(size);
+    strcpy(buf, "abc");
+
+    /* 0 and 1 buffered in order, 2 and 3 merged out of order */
+    for (size_t chunk : {0, 2, 3, 1}) {
+        int ret = CuckooStore::GetInstance()->WriteFile(openInstance.get(), buf, size, chunk * size);
+        EXPECT_EQ(ret, 0);
+    }
+    EXPECT_EQ(openInstance->writeStream.GetSize(), size * 4);
+    /* 2 to 5 merged into one extent large enough to persist */
+    for (size_t chunk : {4, 5}) {
+        int ret = CuckooStore::GetInstance()->WriteFile(openInstance.get(), buf, size, chunk * size);
+        EXPECT_EQ(ret, 0);
+    }
+    EXPECT_EQ(openInstance->writeStream.GetSize(), size * 2);
+    EXPECT_EQ(openInstance->currentSize.load(), size * 6);
+    free(buf);
+}
+
 TEST_F(CuckooStoreUT, WriteRemoteSeqToRandom)
 {
     NewOpenInstance(2000, StoreNode::GetInstance()->GetNodeId() + 1, "/WriteRemote", O_WRONLY);
@@ -357,6 +387,45 @@ TEST_F(CuckooStoreUT, WriteRemoteSeqToRandom)
     free(buf);
 }
 
+TEST_F(CuckooStoreUT, WriteBrpcConcurrentOutOfOrder)
+{
+    NewOpenInstance(3000, StoreNode::GetInstance()->GetNodeId(), "/WriteBrpcConcurrent", O_RDWR | O_CREAT);
+    openInstance->isRemoteCall = true;
+    ASSERT_EQ(CuckooStore::GetInstance()->OpenFile(openInstance.get()), 0);
+
+    /* chunks of one file arrive on several rpc threads, the last ones first */
+    const int chunkNum = 64;
+    const size_t chunkSize = 4096;
+    std::vector<std::thread> writers;
+    std::atomic<int> failed = 0;
+    for (int t = 0; t < 8; ++t) {
+        writers.emplace_back([&, t]() {
+            for (int i = chunkNum - 1 - t; i >= 0; i -= 8) {
+                butil::IOBuf buf;
+                std::string chunk(chunkSize, static_cast<char>('a' + i % 26));
+                buf.append(chunk);
+                int ret = CuckooStore::GetInstance()->WriteLocalFileForBrpc(openInstance.get(), buf, i * chunkSize);
+                failed += ret != 0;
+            }
+        });
+    }
+    for (auto &writer : writers) {
+        writer.join();
+    }
+    EXPECT_EQ(failed.load(), 0);
+    EXPECT_EQ(openInstance->currentSize.load(), chunkNum * chunkSize);
+    struct stat st;
+    ASSERT_EQ(fstat(static_cast<int>(openInstance->physicalFd), &st), 0);
+    EXPECT_EQ(static_cast<size_t>(st.st_size), chunkNum * chunkSize);
+    std::string data(chunkSize, '\0');
+    for (int i = 0; i < chunkNum; ++i) {
+        ASSERT_EQ(pread(static_cast<int>(openInstance->physicalFd), data.data(), chunkSize, i * chunkSize),
+                  static_cast<ssize_t>(chunkSize));
+        EXPECT_EQ(data, std::string(chunkSize, static_cast<char>('a' + i % 26)));
+    }
+    EXPECT_EQ(CuckooStore::GetInstance()->CloseTmpFiles(openInstance.get(), true, false), 0);
+}
+
 /* ------------------------------------------- read local -------------------------------------------*/
 
 TEST_F(CuckooStoreUT, ReadLocalSeqSmall)
@@ -875,6 +944,113 @@ TEST_F(CuckooStoreUT, WriteReadWriteRemote)
     EXPECT_EQ(ret, 0);
 }
 
+TEST_F(CuckooStoreUT, WriteReadRemotePipelined)
+{
+    NewOpenInstance(20001, StoreNode::GetInstance()->GetNodeId() + 1, "/ReadRemoteLarge", O_RDWR);
+    openInstance->originalSize = size;
+    openInstance->currentSize = size;
+
+    memset(readBuf, 0, readSize);
+
+    /* many writes in flight at once */
+    for (size_t offset = 0; offset < size; offset += CUCKOO_STORE_STREAM_MAX_SIZE) {
+        size_t chunk = std::min(size - offset, (size_t)CUCKOO_STORE_STREAM_MAX_SIZE);
+        int ret = CuckooStore::GetInstance()->WriteFile(openInstance.get(), writeBuf + offset, chunk, offset);
+        EXPECT_EQ(ret, 0);
+    }
+    /* read waits for them to land */
+    int ret = CuckooStore::GetInstance()->ReadFile(openInstance.get(), readBuf, readSize, 0);
+    EXPECT_EQ(ret, readSize);
+    EXPECT_EQ(0, memcmp(writeBuf, readBuf, readSize));
+    EXPECT_FALSE(openInstance->writeStream.Pending());
+    ret = CuckooStore::GetInstance()->ReadFile(openInstance.get(), readBuf, readSize, readSize);
+    EXPECT_EQ(ret, readSize);
+    EXPECT_EQ(0, memcmp(writeBuf + readSize, readBuf, readSize));
+}
+
+TEST_F(CuckooStoreUT, ReadRemoteHotFile)
+{
+    int primaryNodeId = StoreNode::GetInstance()->GetNodeId() + 1;
+    int replicaNum = config->GetUint32(CuckooPropertyKey::CUCKOO_HOT_FILE_REPLICAS);
+    std::vector<int> replicaNodeIds = StoreNode::GetInstance()->GetReplicaNodes(primaryNodeId, replicaNum);
+    if (replicaNodeIds.empty()) {
+        GTEST_SKIP() << "hot files have no replicas in this cluster";
+    }
+    /* a file readers of this node are sent to a copy of */
+    uint64_t inodeId = 20002;
+    while (CuckooStore::GetInstance()->ReplicaNodeFor(inodeId, primaryNodeId, replicaNodeIds) == primaryNodeId) {
+        ++inodeId;
+    }
+    int replicaNodeId = CuckooStore::GetInstance()->ReplicaNodeFor(inodeId, primaryNodeId, replicaNodeIds);
+
+    NewOpenInstance(inodeId, primaryNodeId, "/ReadRemoteHot", O_WRONLY | O_CREAT);
+    int ret = CuckooStore::GetInstance()->WriteFile(openInstance.get(), writeBuf, size, 0);
+    EXPECT_EQ(ret, 0);
+    ret = CuckooStore::GetInstance()->CloseTmpFiles(openInstance.get(), false, true);
+    EXPECT_EQ(ret, 0);
+
+    auto openRead = [&]() {
+        NewOpenInstance(inodeId, primaryNodeId, "/ReadRemoteHot", O_RDONLY);
+        openInstance->originalSize = size;
+        openInstance->currentSize = size;
+        return CuckooStore::GetInstance()->OpenFile(openInstance.get());
+    };
+    /* reads over the rate make the file hot on its node */
+    auto makeHot = [&]() {
+        ASSERT_EQ(openRead(), 0);
+        uint64_t hotReads = config->GetUint32(CuckooPropertyKey::CUCKOO_HOT_FILE_READ_RATE) + 1;
+        for (uint64_t i = 0; i < hotReads; ++i) {
+            ssize_t readLen = CuckooStore::GetInstance()->ReadFileLR(readBuf, 0, openInstance.get(), 4096);
+            EXPECT_EQ(readLen, 4096);
+        }
+        EXPECT_EQ(CuckooStore::GetInstance()->CloseTmpFiles(openInstance.get(), false, true), 0);
+    };
+    makeHot();
+
+    /* a later reader is sent to the copy, which reads the same */
+    ASSERT_EQ(openRead(), 0);
+    EXPECT_EQ(openInstance->nodeId, replicaNodeId);
+    EXPECT_NE(openInstance->nodeId, primaryNodeId);
+    memset(readBuf, 0, readSize);
+    ssize_t readLen = CuckooStore::GetInstance()->ReadFileLR(readBuf, 0, openInstance.get(), readSize);
+    EXPECT_EQ(readLen, (ssize_t)readSize);
+    EXPECT_EQ(0, memcmp(writeBuf, readBuf, readSize));
+    readLen = CuckooStore::GetInstance()->ReadFileLR(readBuf, readSize, openInstance.get(), readSize);
+    EXPECT_EQ(readLen, (ssize_t)readSize);
+    EXPECT_EQ(0, memcmp(writeBuf + readSize, readBuf, readSize));
+    ret = CuckooStore::GetInstance()->CloseTmpFiles(openInstance.get(), false, true);
+    EXPECT_EQ(ret, 0);
+
+    /* a write makes the copies stale, readers after it go back to the primary and see the new data */
+    std::vector<char> newData(writeBuf, writeBuf + readSize);
+    newData[0] = 'x';
+    NewOpenInstance(inodeId, primaryNodeId, "/ReadRemoteHot", O_WRONLY);
+    openInstance->originalSize = size;
+    openInstance->currentSize = size;
+    ret = CuckooStore::GetInstance()->WriteFile(openInstance.get(), newData.data(), readSize, 0);
+    EXPECT_EQ(ret, 0);
+    ret = CuckooStore::GetInstance()->CloseTmpFiles(openInstance.get(), false, true);
+    EXPECT_EQ(ret, 0);
+
+    ASSERT_EQ(openRead(), 0);
+    EXPECT_EQ(openInstance->nodeId, primaryNodeId);
+    readLen = CuckooStore::GetInstance()->ReadFileLR(readBuf, 0, openInstance.get(), readSize);
+    EXPECT_EQ(readLen, (ssize_t)readSize);
+    EXPECT_EQ(0, memcmp(newData.data(), readBuf, readSize));
+    ret = CuckooStore::GetInstance()->CloseTmpFiles(openInstance.get(), false, true);
+    EXPECT_EQ(ret, 0);
+
+    /* hot again under a new version, the copy is pulled again instead of the stale one being read */
+    makeHot();
+    ASSERT_EQ(openRead(), 0);
+    EXPECT_EQ(openInstance->nodeId, replicaNodeId);
+    readLen = CuckooStore::GetInstance()->ReadFileLR(readBuf, 0, openInstance.get(), readSize);
+    EXPECT_EQ(readLen, (ssize_t)readSize);
+    EXPECT_EQ(0, memcmp(newData.data(), readBuf, readSize));
+    ret = CuckooStore::GetInstance()->CloseTmpFiles(openInstance.get(), false, true);
+    EXPECT_EQ(ret, 0);
+}
+
 /* ------------------------------------------- close local -------------------------------------------*/
 
 TEST_F(CuckooStoreUT, FlushLocal)
@@ -1203,6 +1379,40 @@ TEST_F(CuckooStoreUT, WriteTruncateOpenInstanceRemote)
     EXPECT_EQ(openInstance->currentSize, 1000);
 }
 
+/* ------------------------------------------- metrics -------------------------------------------*/
+
+static size_t CountOf(const std::string &text, const std::string &pattern)
+{
+    size_t count = 0;
+    for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+TEST_F(CuckooStoreUT, MetricsEndpoint)
+{
+    brpc::Channel channel;
+    brpc::ChannelOptions options;
+    options.protocol = brpc::PROTOCOL_HTTP;
+    ASSERT_EQ(channel.Init(cuckoo::brpc_io::RemoteIOServer::GetInstance().endPoint.c_str(), &options), 0);
+
+    brpc::Controller cntl;
+    cntl.http_request().uri() = "/metrics";
+    channel.CallMethod(nullptr, &cntl, nullptr, nullptr, nullptr);
+    ASSERT_FALSE(cntl.Failed()) << cntl.ErrorText();
+    EXPECT_EQ(cntl.http_response().status_code(), 200);
+    EXPECT_EQ(cntl.http_response().content_type(), "text/plain; version=0.0.4");
+
+    std::string text = cntl.response_attachment().to_string();
+    EXPECT_EQ(CountOf(text, "# TYPE cuckoo_disk_cache_used_bytes gauge\n"), 1U);
+    EXPECT_EQ(CountOf(text, "\ncuckoo_disk_cache_used_bytes "), 1U);
+    EXPECT_EQ(CountOf(text, "\ncuckoo_store_thread_pool_queue_depth{priority=\"foreground\"} "), 1U);
+    EXPECT_EQ(CountOf(text, "\ncuckoo_store_thread_pool_queue_depth{priority=\"background\"} "), 1U);
+    EXPECT_EQ(CountOf(text, "# TYPE cuckoo_fuse_read_bytes_total counter\n"), 1U);
+    EXPECT_EQ(CountOf(text, "# TYPE cuckoo_meta_rpc_latency_seconds histogram\n"), 1U);
+}
+
 int main(int argc, char **argv)
 {
     testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "remote_connection_utils/cuckoo_trace.h"
+
+/* every test records into a ring of its own */
+static std::unique_ptr<char[]> AttachNewRing(uint64_t capacity)
+{
+    auto memory = std::make_unique<char[]>(CuckooTraceRingSize(capacity));
+    auto *ring = reinterpret_cast<CuckooTraceRing *>(memory.get());
+    CuckooTraceRingInit(ring, capacity);
+    CuckooTraceAttachRing(ring);
+    return memory;
+}
+
+static std::string Dump(int &count)
+{
+    char *buf = nullptr;
+    size_t size = 0;
+    FILE *file = open_memstream(&buf, &size);
+    count = CuckooTraceDump(file);
+    fclose(file);
+    std::string text(buf, size);
+    free(buf);
+    return text;
+}
+
+static std::string Hex(uint64_t value)
+{
+    char buf[17];
+    std::snprintf(buf, sizeof(buf), "%016llx", static_cast<unsigned long long>(value));
+    return buf;
+}
+
+TEST(CuckooTraceUT, NotSampledRecordsNothing)
+{
+    auto ring = AttachNewRing(64);
+    CuckooTraceSetSampleRate(0);
+    {
+        CuckooTraceScope root("fuse_open", true);
+        EXPECT_FALSE(CuckooTraceSampled(root.Context()));
+        CuckooTraceScope child("meta_rpc");
+        EXPECT_FALSE(CuckooTraceSampled(child.Context()));
+    }
+    int count = -1;
+    std::string text = Dump(count);
+    EXPECT_EQ(count, 0);
+    EXPECT_NE(text.find("\"ph\":\"M\""), std::string::npos);
+}
+
+TEST(CuckooTraceUT, ChildSpansShareTrace)
+{
+    auto ring = AttachNewRing(64);
+    CuckooTraceSetSampleRate(1);
+    CuckooTraceContext rootContext;
+    CuckooTraceContext childContext;
+    {
+        CuckooTraceScope root("fuse_open", true);
+        rootContext = root.Context();
+        CuckooTraceScope child("meta_rpc");
+        childContext = child.Context();
+        EXPECT_EQ(CuckooTraceGetContext().spanId, childContext.spanId);
+    }
+    /* the thread context is restored once the root ends */
+    EXPECT_FALSE(CuckooTraceSampled(CuckooTraceGetContext()));
+    ASSERT_TRUE(CuckooTraceSampled(rootContext));
+    EXPECT_EQ(childContext.traceId, rootContext.traceId);
+
+    /* a span received from another process */
+    int64_t now = CuckooTraceNowNs();
+    CuckooTraceRecord(childContext, "pool_queue", now - 1500, now);
+    CuckooTraceSetSampleRate(0);
+
+    int count = 0;
+    std::string text = Dump(count);
+    EXPECT_EQ(count, 3);
+    EXPECT_NE(text.find("{\"name\":\"meta_rpc\",\"cat\":\"cuckoo\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(text.find("\"span_id\":\"" + Hex(childContext.spanId) + "\",\"parent_id\":\"" +
+                        Hex(rootContext.spanId) + "\""),
+              std::string::npos);
+    EXPECT_NE(text.find("\"dur\":1.500,\"args\":{\"trace_id\":\"" + Hex(rootContext.traceId) + "\""),
+              std::string::npos);
+    EXPECT_NE(text.find("\"parent_id\":\"" + Hex(childContext.spanId) + "\""), std::string::npos);
+    EXPECT_EQ(text.substr(text.size() - 4), "\n]}\n");
+}
+
+TEST(CuckooTraceUT, UnsampledRootHidesStaleContext)
+{
+    auto ring = AttachNewRing(64);
+    CuckooTraceSetSampleRate(0);
+    /* left on the thread by a request that did not end its spans */
+    CuckooTraceContext stale = {0x1234, 0x5678};
+    CuckooTraceSetContext(stale);
+    {
+        CuckooTraceScope root("fuse_read", true);
+        EXPECT_FALSE(CuckooTraceSampled(CuckooTraceGetContext()));
+        CuckooTraceScope child("meta_rpc");
+        EXPECT_FALSE(CuckooTraceSampled(child.Context()));
+    }
+    EXPECT_EQ(CuckooTraceGetContext().traceId, stale.traceId);
+    CuckooTraceSetContext(CuckooTraceContext{0, 0});
+    EXPECT_FALSE(CuckooTraceSampled(CuckooTraceGetContext()));
+    int count = -1;
+    Dump(count);
+    EXPECT_EQ(count, 0);
+}
+
+TEST(CuckooTraceUT, RingKeepsLatestSpans)
+{
+    auto ring = AttachNewRing(16);
+    CuckooTraceSetSampleRate(1);
+    for (int i = 0; i < 100; ++i) {
+        CuckooTraceScope root("fuse_getattr", true);
+    }
+    CuckooTraceSetSampleRate(0);
+    int count = 0;
+    Dump(count);
+    EXPECT_EQ(count, 16);
+}
+
+TEST(CuckooTraceUT, SampleRate)
+{
+    auto ring = AttachNewRing(4096);
+    CuckooTraceSetSampleRate(0.01);
+    constexpr int requestNum = 100000;
+    int sampled = 0;
+    for (int i = 0; i < requestNum; ++i) {
+        CuckooTraceScope root("fuse_getattr", true);
+        sampled += CuckooTraceSampled(root.Context());
+    }
+    CuckooTraceSetSampleRate(0);
+    EXPECT_GT(sampled, requestNum / 100 * 7 / 10);
+    EXPECT_LT(sampled, requestNum / 100 * 13 / 10);
+}
+
+TEST(CuckooTraceUT, ConcurrentWriters)
+{
+    auto ring = AttachNewRing(1 << 16);
+    CuckooTraceSetSampleRate(1);
+    constexpr int threadNum = 4;
+    constexpr int spanNum = 1000;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadNum; ++t) {
+        threads.emplace_back([]() {
+            for (int i = 0; i < spanNum; ++i) {
+                CuckooTraceScope root("fuse_read", true);
+                CuckooTraceScope child("store_read");
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+    CuckooTraceSetSampleRate(0);
+    int count = 0;
+    Dump(count);
+    EXPECT_EQ(count, threadNum * spanNum * 2);
+}
+
+/* cost of a root span and a child span on requests that are not sampled */
+TEST(CuckooTraceUT, UnsampledCost)
+{
+    auto ring = AttachNewRing(1 << 16);
+    constexpr int requestNum = 1000000;
+    for (double rate : {0.0, 0.01}) {
+        CuckooTraceSetSampleRate(rate);
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < requestNum; ++i) {
+            CuckooTraceScope root("fuse_getattr", true);
+            CuckooTraceScope child("meta_rpc");
+        }
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        std::printf("trace ns/request at sample rate %.2f: %.1f\n",
+                    rate,
+                    std::chrono::duration<double, std::nano>(elapsed).count() / requestNum);
+    }
+    CuckooTraceSetSampleRate(0);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -1,5 +1,6 @@
 #include "test_file_lock.h"
 
+#include <atomic>
 #include <future>
 
 FileLock FileLockUT::flk;
@@ -50,6 +51,152 @@ TEST_F(FileLockUT, TestLocked)
     flk.ReleaseFileLock(id, LockMode::X);
 }
 
+TEST_F(FileLockUT, RangeLockConflict)
+{
+    RangeLock first{0, 100, LockMode::X, 1};
+    RangeLock second{100, 200, LockMode::X, 2};
+    EXPECT_EQ(flk.SetRangeLock(id, first, false), 0);
+    /* disjoint ranges of one file */
+    EXPECT_EQ(flk.SetRangeLock(id, second, false), 0);
+    EXPECT_FALSE(flk.TestLocked(id, LockMode::X));
+
+    RangeLock overlap{50, 150, LockMode::S, 3, 0, 33};
+    RangeLock conflict;
+    EXPECT_EQ(flk.SetRangeLock(id, overlap, false), -EAGAIN);
+    ASSERT_TRUE(flk.GetRangeLockConflict(id, overlap, conflict));
+    EXPECT_EQ(conflict.owner, 1U);
+    EXPECT_EQ(conflict.start, 0U);
+    EXPECT_EQ(conflict.end, 100U);
+    /* the same lock owner from another node is another owner */
+    EXPECT_EQ(flk.SetRangeLock(id, RangeLock{0, 100, LockMode::X, 1, 1}, false), -EAGAIN);
+
+    flk.ReleaseRangeLock(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 1});
+    flk.ReleaseRangeLock(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 2});
+    EXPECT_EQ(flk.SetRangeLock(id, overlap, false), 0);
+    /* shared with another reader, not with a writer */
+    EXPECT_EQ(flk.SetRangeLock(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 4}, false), 0);
+    EXPECT_EQ(flk.SetRangeLock(id, RangeLock{149, 150, LockMode::X, 5}, false), -EAGAIN);
+    flk.ReleaseRangeLock(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 3});
+    flk.ReleaseRangeLock(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 4});
+    EXPECT_FALSE(flk.GetRangeLockConflict(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::X, 5}, conflict));
+}
+
+TEST_F(FileLockUT, RangeLockSplitAndMerge)
+{
+    RangeLock conflict;
+    EXPECT_EQ(flk.SetRangeLock(id, RangeLock{0, 100, LockMode::X, 1}, false), 0);
+    /* unlocking the middle leaves two ranges */
+    flk.ReleaseRangeLock(id, RangeLock{40, 60, LockMode::S, 1});
+    EXPECT_EQ(flk.SetRangeLock(id, RangeLock{40, 60, LockMode::X, 2}, false), 0);
+    EXPECT_EQ(flk.SetRangeLock(id, RangeLock{39, 40, LockMode::X, 2}, false), -EAGAIN);
+    EXPECT_EQ(flk.SetRangeLock(id, RangeLock{60, 61, LockMode::X, 2}, false), -EAGAIN);
+    flk.ReleaseRangeLock(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 2});
+
+    /* downgrading a part to S lets readers in there only */
+    EXPECT_EQ(flk.SetRangeLock(id, RangeLock{10, 20, LockMode::S, 1}, false), 0);
+    EXPECT_EQ(flk.SetRangeLock(id, RangeLock{10, 20, LockMode::S, 2}, false), 0);
+    EXPECT_EQ(flk.SetRangeLock(id, RangeLock{5, 15, LockMode::S, 3}, false), -EAGAIN);
+    flk.ReleaseRangeLock(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 2});
+
+    /* relocking everything as X merges the pieces back */
+    EXPECT_EQ(flk.SetRangeLock(id, RangeLock{0, 100, LockMode::X, 1}, false), 0);
+    flk.ReleaseRangeLock(id, RangeLock{0, 50, LockMode::S, 1});
+    ASSERT_TRUE(flk.GetRangeLockConflict(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 2}, conflict));
+    EXPECT_EQ(conflict.start, 50U);
+    EXPECT_EQ(conflict.end, 100U);
+    flk.ReleaseRangeLock(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 1});
+    EXPECT_FALSE(flk.GetRangeLockConflict(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::X, 2}, conflict));
+}
+
+TEST_F(FileLockUT, RangeLockWait)
+{
+    EXPECT_EQ(flk.SetRangeLock(id, RangeLock{0, 100, LockMode::X, 1}, false), 0);
+    auto fut1 = std::async(std::launch::async, [&]() {
+        return flk.SetRangeLock(id, RangeLock{50, 150, LockMode::X, 2}, true);
+    });
+    EXPECT_EQ(fut1.wait_for(std::chrono::milliseconds(100)), std::future_status::timeout);
+    /* releasing a range the waiter does not need keeps it waiting */
+    flk.ReleaseRangeLock(id, RangeLock{0, 50, LockMode::S, 1});
+    EXPECT_EQ(fut1.wait_for(std::chrono::milliseconds(100)), std::future_status::timeout);
+    flk.ReleaseRangeLock(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 1});
+    ASSERT_EQ(fut1.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(fut1.get(), 0);
+    flk.ReleaseRangeLock(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 2});
+}
+
+TEST_F(FileLockUT, RangeLockDeadlock)
+{
+    uint64_t first = id;
+    uint64_t second = id + 1;
+    uint64_t third = id + 2;
+    EXPECT_EQ(flk.SetRangeLock(first, RangeLock{0, 10, LockMode::X, 1}, false), 0);
+    EXPECT_EQ(flk.SetRangeLock(second, RangeLock{0, 10, LockMode::X, 2}, false), 0);
+    EXPECT_EQ(flk.SetRangeLock(third, RangeLock{0, 10, LockMode::X, 3}, false), 0);
+    /* 1 waits for 2, 2 waits for 3 */
+    auto wait1 = std::async(std::launch::async, [&]() {
+        return flk.SetRangeLock(second, RangeLock{0, 10, LockMode::X, 1}, true);
+    });
+    EXPECT_EQ(wait1.wait_for(std::chrono::milliseconds(100)), std::future_status::timeout);
+    auto wait2 = std::async(std::launch::async, [&]() {
+        return flk.SetRangeLock(third, RangeLock{0, 10, LockMode::X, 2}, true);
+    });
+    EXPECT_EQ(wait2.wait_for(std::chrono::milliseconds(100)), std::future_status::timeout);
+
+    /* 3 waiting for 1 closes the cycle, the others keep waiting */
+    EXPECT_EQ(flk.SetRangeLock(first, RangeLock{0, 10, LockMode::X, 3}, true), -EDEADLK);
+    /* flock locks are never reported */
+    EXPECT_EQ(flk.SetRangeLock(first, RangeLock{0, 10, LockMode::X, 1}, false, RangeLockType::FLOCK), 0);
+    EXPECT_EQ(wait2.wait_for(std::chrono::milliseconds(10)), std::future_status::timeout);
+
+    flk.ReleaseRangeLock(third, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 3});
+    ASSERT_EQ(wait2.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(wait2.get(), 0);
+    flk.ReleaseRangeLock(second, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 2});
+    ASSERT_EQ(wait1.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(wait1.get(), 0);
+
+    flk.ReleaseRangeLock(first, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 1}, RangeLockType::FLOCK);
+    for (int owner = 1; owner <= 3; ++owner) {
+        for (uint64_t inodeId : {first, second, third}) {
+            flk.ReleaseRangeLock(inodeId, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, static_cast<uint64_t>(owner)});
+        }
+    }
+    EXPECT_FALSE(flk.TestLocked(first, LockMode::X));
+}
+
+TEST_F(FileLockUT, RangeLockInterrupted)
+{
+    EXPECT_EQ(flk.SetRangeLock(id, RangeLock{0, 100, LockMode::X, 1}, false), 0);
+    std::atomic<bool> signalled = false;
+    auto waiting = std::async(std::launch::async, [&]() {
+        return flk.SetRangeLock(id, RangeLock{0, 100, LockMode::S, 2}, true, RangeLockType::POSIX,
+                                [&signalled]() { return signalled.load(); });
+    });
+    EXPECT_EQ(waiting.wait_for(std::chrono::milliseconds(100)), std::future_status::timeout);
+    signalled = true;
+    ASSERT_EQ(waiting.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(waiting.get(), -EINTR);
+    /* the interrupted owner took nothing */
+    RangeLock conflict;
+    flk.ReleaseRangeLock(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 1});
+    EXPECT_FALSE(flk.GetRangeLockConflict(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::X, 3}, conflict));
+}
+
+TEST_F(FileLockUT, FlockAndPosixAreIndependent)
+{
+    RangeLock whole{0, RANGE_LOCK_EOF, LockMode::X, 1};
+    EXPECT_EQ(flk.SetRangeLock(id, whole, false, RangeLockType::FLOCK), 0);
+    whole.owner = 2;
+    EXPECT_EQ(flk.SetRangeLock(id, whole, false, RangeLockType::FLOCK), -EAGAIN);
+    EXPECT_EQ(flk.SetRangeLock(id, whole, false, RangeLockType::POSIX), 0);
+    /* the store's own whole file locks are independent too */
+    EXPECT_TRUE(flk.TryGetFileLock(id, LockMode::X));
+    flk.ReleaseFileLock(id, LockMode::X);
+    flk.ReleaseRangeLock(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 1}, RangeLockType::FLOCK);
+    flk.ReleaseRangeLock(id, RangeLock{0, RANGE_LOCK_EOF, LockMode::S, 2}, RangeLockType::POSIX);
+    EXPECT_FALSE(flk.TestLocked(id, LockMode::X));
+}
+
 INSTANTIATE_TEST_SUITE_P(FileLockSuite,
                          FileLockUT,
                          ::testing::Values(std::make_tuple(LockMode::S, LockMode::S, true),
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "util/hot_file.h"
+
+class HotFileUT : public testing::Test {
+  protected:
+    void SetUp() override { tracker.SetThreshold(THRESHOLD); }
+
+    /* reads of one window starting at nowMs, true if any made the file hot */
+    bool ReadWindow(uint64_t inodeId, uint64_t nowMs, uint64_t reads)
+    {
+        bool becameHot = false;
+        for (uint64_t i = 0; i < reads; ++i) {
+            becameHot |= tracker.RecordRead(inodeId, nowMs + i % HOT_FILE_WINDOW_MS);
+        }
+        return becameHot;
+    }
+
+    static constexpr uint64_t THRESHOLD = 100;
+    static constexpr uint64_t START_MS = 1000000;
+    HotFileTracker tracker;
+};
+
+TEST_F(HotFileUT, BecomesHotOnceOverThreshold)
+{
+    EXPECT_FALSE(ReadWindow(1, START_MS, THRESHOLD - 1));
+    EXPECT_EQ(tracker.GetHotNum(), 0U);
+    EXPECT_TRUE(tracker.RecordRead(1, START_MS + 10));
+    EXPECT_EQ(tracker.GetHotNum(), 1U);
+    /* reported once */
+    EXPECT_FALSE(ReadWindow(1, START_MS + 20, THRESHOLD));
+    /* reads spread over windows never add up */
+    for (uint64_t window = 0; window < 10; ++window) {
+        EXPECT_FALSE(ReadWindow(2, START_MS + window * HOT_FILE_WINDOW_MS, THRESHOLD / 2));
+    }
+}
+
+TEST_F(HotFileUT, ReplicasVersioned)
+{
+    EXPECT_EQ(tracker.SetReplicas(1, {2, 3}), 0U);
+    ASSERT_TRUE(ReadWindow(1, START_MS, THRESHOLD));
+    uint64_t version = tracker.SetReplicas(1, {2, 3});
+    EXPECT_NE(version, 0U);
+    HotFileReplicas replicas = tracker.GetReplicas(1);
+    EXPECT_EQ(replicas.version, version);
+    EXPECT_EQ(replicas.nodeIds, std::vector<int>({2, 3}));
+    EXPECT_TRUE(tracker.GetReplicas(2).nodeIds.empty());
+
+    /* the next hot period gets a newer version */
+    EXPECT_EQ(tracker.Invalidate(1).version, version);
+    ASSERT_TRUE(ReadWindow(1, START_MS + HOT_FILE_WINDOW_MS, THRESHOLD));
+    EXPECT_GT(tracker.SetReplicas(1, {2}), version);
+}
+
+TEST_F(HotFileUT, CoolsDownWhenQuiet)
+{
+    ASSERT_TRUE(ReadWindow(1, START_MS, THRESHOLD));
+    tracker.SetReplicas(1, {2});
+    /* busy enough to stay hot */
+    EXPECT_FALSE(ReadWindow(1, START_MS + HOT_FILE_WINDOW_MS, THRESHOLD / 2));
+    EXPECT_FALSE(tracker.GetReplicas(1).nodeIds.empty());
+    /* a window with a single read, the next read turns it cold */
+    tracker.RecordRead(1, START_MS + 2 * HOT_FILE_WINDOW_MS);
+    tracker.RecordRead(1, START_MS + 3 * HOT_FILE_WINDOW_MS);
+    EXPECT_TRUE(tracker.GetReplicas(1).nodeIds.empty());
+    EXPECT_EQ(tracker.GetHotNum(), 0U);
+}
+
+TEST_F(HotFileUT, NoReplicasWhileWriting)
+{
+    ASSERT_TRUE(ReadWindow(1, START_MS, THRESHOLD));
+    uint64_t version = tracker.SetReplicas(1, {2, 3});
+    HotFileReplicas dropped = tracker.BeginWrite(1);
+    EXPECT_EQ(dropped.version, version);
+    EXPECT_EQ(dropped.nodeIds.size(), 2U);
+    EXPECT_TRUE(tracker.GetReplicas(1).nodeIds.empty());
+
+    EXPECT_FALSE(ReadWindow(1, START_MS + HOT_FILE_WINDOW_MS, THRESHOLD * 2));
+    EXPECT_EQ(tracker.SetReplicas(1, {2}), 0U);
+    tracker.EndWrite(1);
+    EXPECT_TRUE(ReadWindow(1, START_MS + 2 * HOT_FILE_WINDOW_MS, THRESHOLD));
+}
+
+TEST_F(HotFileUT, DisabledByZeroThreshold)
+{
+    tracker.SetThreshold(0);
+    EXPECT_FALSE(ReadWindow(1, START_MS, THRESHOLD * 10));
+    EXPECT_EQ(tracker.GetHotNum(), 0U);
+}
+
+TEST_F(HotFileUT, IdleFilesSwept)
+{
+    for (uint64_t inodeId = 0; inodeId < HOT_FILE_SHARD_NUM * HOT_FILE_SWEEP_SIZE * 2; ++inodeId) {
+        tracker.RecordRead(inodeId, START_MS);
+    }
+    ASSERT_TRUE(ReadWindow(1, START_MS, THRESHOLD));
+    /* long after, every shard sweeps its idle files on reads */
+    uint64_t later = START_MS + (HOT_FILE_IDLE_WINDOWS + 1) * HOT_FILE_WINDOW_MS;
+    for (uint64_t inodeId = 0; inodeId < HOT_FILE_SHARD_NUM * HOT_FILE_SWEEP_SIZE * 4; ++inodeId) {
+        tracker.RecordRead(inodeId + (1ULL << 40), later);
+    }
+    EXPECT_EQ(tracker.GetHotNum(), 0U);
+}
+
+TEST_F(HotFileUT, ConcurrentReads)
+{
+    constexpr int THREAD_NUM = 8;
+    std::atomic<int> becameHot = 0;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREAD_NUM; ++t) {
+        threads.emplace_back([this, &becameHot]() {
+            for (uint64_t i = 0; i < THRESHOLD; ++i) {
+                becameHot += tracker.RecordRead(42, START_MS + i);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(becameHot.load(), 1);
+}
+
+TEST(ReplicaCopiesUT, VersionsOfCopies)
+{
+    ReplicaCopies copies;
+    EXPECT_FALSE(copies.Contains(1));
+    copies.Set(1, 10);
+    EXPECT_TRUE(copies.Has(1, 10));
+    EXPECT_FALSE(copies.Has(1, 11));
+    /* a drop of an older version keeps the newer copy */
+    EXPECT_FALSE(copies.Drop(1, 9));
+    EXPECT_TRUE(copies.Drop(1, 10));
+    EXPECT_FALSE(copies.Contains(1));
+    EXPECT_EQ(copies.Size(), 0U);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
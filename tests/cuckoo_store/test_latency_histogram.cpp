@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "stats/latency_histogram.h"
+
+TEST(LatencyHistogramUT, BucketBounds)
+{
+    uint32_t lastIndex = 0;
+    for (uint64_t value = 0; value < (1ULL << 20); ++value) {
+        uint32_t index = LatencyHistograms::BucketIndex(value);
+        ASSERT_GE(index, lastIndex);
+        ASSERT_LE(value, LatencyHistograms::BucketUpperBound(index));
+        if (index > 0) {
+            ASSERT_GT(value, LatencyHistograms::BucketUpperBound(index - 1));
+        }
+        lastIndex = index;
+    }
+    EXPECT_EQ(LatencyHistograms::BucketIndex(UINT64_MAX), LatencyHistograms::BUCKET_NUM - 1);
+}
+
+TEST(LatencyHistogramUT, RelativeError)
+{
+    for (uint64_t value = 1; value < (1ULL << 35); value = value * 3 + 1) {
+        uint64_t upper = LatencyHistograms::BucketUpperBound(LatencyHistograms::BucketIndex(value));
+        EXPECT_LE(static_cast<double>(upper - value) / value, 1.0 / LatencyHistograms::SUB_BUCKET_NUM);
+    }
+}
+
+TEST(LatencyHistogramUT, PercentilesOfInterval)
+{
+    auto &histograms = LatencyHistograms::GetInstance();
+    LatencyHistograms::Snapshot current;
+    LatencyHistograms::Snapshot last{};
+    histograms.Collect(HIST_OBJ_GET, current);
+    LatencyHistograms::Percentiles(current, last);
+
+    /* 1000 values of 1..1000us recorded from several threads */
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([i, &histograms]() {
+            for (uint64_t us = i + 1; us <= 1000; us += 4) {
+                histograms.Record(HIST_OBJ_GET, us * 1000);
+            }
+        });
+    }
+    for (auto &t : threads) {
+        t.join();
+    }
+
+    histograms.Collect(HIST_OBJ_GET, current);
+    auto pct = LatencyHistograms::Percentiles(current, last);
+    EXPECT_EQ(pct.count, 1000U);
+    EXPECT_NEAR(static_cast<double>(pct.p50), 500000, 500000 / 16.0);
+    EXPECT_NEAR(static_cast<double>(pct.p99), 990000, 990000 / 16.0);
+    EXPECT_NEAR(static_cast<double>(pct.max), 1000000, 1000000 / 16.0);
+    EXPECT_LE(pct.p50, pct.p90);
+    EXPECT_LE(pct.p90, pct.p99);
+    EXPECT_LE(pct.p99, pct.p999);
+    EXPECT_LE(pct.p999, pct.max);
+
+    /* nothing new in the next interval */
+    histograms.Collect(HIST_OBJ_GET, current);
+    EXPECT_EQ(LatencyHistograms::Percentiles(current, last).count, 0U);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
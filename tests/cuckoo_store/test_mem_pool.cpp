@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdint>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "buffer/mem_pool.h"
+
+TEST(MemPoolUT, ReusesFreedBlocks)
+{
+    MemPool pool(4096, 16);
+    void *block = pool.alloc();
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % 512, 0U);
+    pool.free(block);
+    EXPECT_EQ(pool.alloc(), block);
+    pool.free(block);
+}
+
+TEST(MemPoolUT, UninitializedPool)
+{
+    MemPool pool;
+    EXPECT_EQ(pool.alloc(), nullptr);
+    EXPECT_TRUE(pool.calloc(4).empty());
+    pool.free(nullptr);
+}
+
+TEST(MemPoolUT, BulkAllocDistinct)
+{
+    MemPool pool(4096, 64);
+    /* the second bulk takes the cached blocks and adds new ones */
+    std::vector<void *> first = pool.calloc(40);
+    ASSERT_EQ(first.size(), 40U);
+    for (auto block : first) {
+        pool.free(block);
+    }
+    std::vector<void *> second = pool.calloc(100);
+    ASSERT_EQ(second.size(), 100U);
+    std::set<void *> distinct(second.begin(), second.end());
+    EXPECT_EQ(distinct.size(), second.size());
+    for (auto block : second) {
+        pool.free(block);
+    }
+}
+
+TEST(MemPoolUT, ConcurrentOwnership)
+{
+    MemPool pool(4096, 128);
+    pool.SetNumaAware(true);
+    constexpr int THREAD_NUM = 8;
+    constexpr int ROUNDS = 2000;
+    std::vector<std::thread> threads;
+    std::atomic<int> corrupted = 0;
+    for (int t = 0; t < THREAD_NUM; ++t) {
+        threads.emplace_back([&pool, &corrupted, t]() {
+            std::vector<uint64_t *> held;
+            for (int i = 0; i < ROUNDS; ++i) {
+                auto *block = static_cast<uint64_t *>(pool.alloc());
+                /* a block handed to two owners at once gets overwritten */
+                *block = t * ROUNDS + i;
+                held.push_back(block);
+                if (held.size() > 32 || i % 7 == 0) {
+                    for (auto *h : held) {
+                        corrupted += *h / ROUNDS != static_cast<uint64_t>(t);
+                        pool.free(h);
+                    }
+                    held.clear();
+                }
+            }
+            for (auto *h : held) {
+                pool.free(h);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(corrupted.load(), 0);
+}
+
+TEST(MemPoolUT, FreeOnOtherThread)
+{
+    MemPool pool(4096, 8);
+    std::vector<void *> blocks = pool.calloc(64);
+    ASSERT_EQ(blocks.size(), 64U);
+    std::thread([&pool, &blocks]() {
+        for (auto block : blocks) {
+            pool.free(block);
+        }
+    }).join();
+    /* the exited thread returned what fits into the depot */
+    std::vector<void *> again = pool.calloc(8);
+    EXPECT_EQ(again.size(), 8U);
+    for (auto block : again) {
+        pool.free(block);
+    }
+}
+
+TEST(MemPoolUT, PoolGoneBeforeThread)
+{
+    /* a new pool may reuse the address of the old one, cached blocks of the old one are dropped */
+    for (int i = 0; i < 4; ++i) {
+        auto *pool = new MemPool(1024 * (i + 1), 4);
+        void *block = pool->alloc();
+        pool->free(block);
+        delete pool;
+    }
+    MemPool pool(4096, 4);
+    void *block = pool.alloc();
+    ASSERT_NE(block, nullptr);
+    pool.free(block);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include "buffer/dir_open_instance.h"
+
+class OpenInstanceUT : public testing::Test {
+  protected:
+    void SetUp() override { budget = fd->GetOpenInstanceMemoryBudget(); }
+    void TearDown() override { fd->SetOpenInstanceMemoryBudget(budget); }
+
+    CuckooFd *fd = CuckooFd::GetInstance();
+    uint64_t budget = 0;
+};
+
+TEST_F(OpenInstanceUT, ClosedInstanceIsRecycled)
+{
+    std::shared_ptr<OpenInstance> openInstance = fd->WaitGetNewOpenInstance();
+    ASSERT_NE(openInstance, nullptr);
+    OpenInstance *recycled = openInstance.get();
+    openInstance->inodeId = 7;
+    openInstance->path = "/recycled";
+    openInstance->writeFail = true;
+    openInstance = nullptr;
+    EXPECT_GE(fd->GetIdleOpenInstanceNum(), 1U);
+
+    openInstance = fd->WaitGetNewOpenInstance();
+    EXPECT_EQ(openInstance.get(), recycled);
+    EXPECT_EQ(openInstance->fd, UINT64_MAX);
+    EXPECT_TRUE(openInstance->path.empty());
+    EXPECT_FALSE(openInstance->writeFail);
+    EXPECT_FALSE(openInstance->readStream.Constructed());
+}
+
+TEST_F(OpenInstanceUT, AttachAndDelete)
+{
+    uint32_t openNum = fd->GetOpenInstanceNum();
+    uint64_t first = fd->AttachFd(100, O_RDONLY, nullptr, 0, "/attach");
+    uint64_t second = fd->AttachFd(100, O_RDONLY, nullptr, 0, "/attach");
+    ASSERT_NE(first, UINT64_MAX);
+    ASSERT_NE(second, UINT64_MAX);
+    EXPECT_EQ(fd->GetOpenInstanceNum(), openNum + 2);
+    EXPECT_EQ(fd->GetOpenInstanceByFd(first)->path, "/attach");
+    EXPECT_EQ(fd->GetInodetoOpenInstanceSet(100).size(), 2U);
+
+    EXPECT_EQ(fd->DeleteOpenInstance(first), 0);
+    EXPECT_EQ(fd->DeleteOpenInstance(first), -EBADF);
+    EXPECT_EQ(fd->GetOpenInstanceByFd(first), nullptr);
+    EXPECT_EQ(fd->GetInodetoOpenInstanceSet(100).size(), 1U);
+    EXPECT_EQ(fd->DeleteOpenInstance(second), 0);
+    EXPECT_TRUE(fd->GetInodetoOpenInstanceSet(100).empty());
+    EXPECT_EQ(fd->GetOpenInstanceNum(), openNum);
+}
+
+TEST_F(OpenInstanceUT, OpenWaitsForBudget)
+{
+    std::shared_ptr<OpenInstance> held = fd->WaitGetNewOpenInstance();
+    ASSERT_NE(held, nullptr);
+    /* room for exactly the instance held */
+    fd->SetOpenInstanceMemoryBudget(fd->GetOpenInstanceMemory());
+
+    auto waiting = std::async(std::launch::async, [this]() { return fd->WaitGetNewOpenInstance(); });
+    EXPECT_EQ(waiting.wait_for(std::chrono::milliseconds(100)), std::future_status::timeout);
+    /* the rpc server never waits */
+    EXPECT_NE(fd->WaitGetNewOpenInstance(false), nullptr);
+
+    held = nullptr;
+    ASSERT_EQ(waiting.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_NE(waiting.get(), nullptr);
+}
+
+TEST_F(OpenInstanceUT, BuffersAreCharged)
+{
+    std::shared_ptr<OpenInstance> openInstance = fd->WaitGetNewOpenInstance();
+    ASSERT_NE(openInstance, nullptr);
+    int64_t used = fd->GetOpenInstanceMemory();
+
+    /* small file content read at open */
+    openInstance->SetReadBuffer(std::shared_ptr<char>((char *)malloc(4096), free), 4096);
+    EXPECT_EQ(fd->GetOpenInstanceMemory(), used + 4096);
+
+    /* the write buffer is charged once allocated, until released */
+    FixMemory writeBuffer;
+    ASSERT_TRUE(writeBuffer.Append("abc", 3));
+    EXPECT_EQ(fd->GetOpenInstanceMemory(), used + 4096 + CUCKOO_STORE_STREAM_MAX_SIZE);
+    writeBuffer.Release();
+    EXPECT_EQ(fd->GetOpenInstanceMemory(), used + 4096);
+
+    openInstance = nullptr;
+    EXPECT_EQ(fd->GetOpenInstanceMemory(), used - static_cast<int64_t>(sizeof(OpenInstance)));
+}
+
+TEST_F(OpenInstanceUT, ConcurrentAttachDelete)
+{
+    constexpr int THREAD_NUM = 8;
+    constexpr int ROUNDS = 2000;
+    uint32_t openNum = fd->GetOpenInstanceNum();
+    std::vector<std::thread> threads;
+    std::atomic<int> failed = 0;
+    for (int t = 0; t < THREAD_NUM; ++t) {
+        threads.emplace_back([this, &failed, t]() {
+            std::vector<uint64_t> held;
+            for (int i = 0; i < ROUNDS; ++i) {
+                uint64_t inodeId = 1000 + t * ROUNDS + i % 16;
+                uint64_t newFd = fd->AttachFd(inodeId, O_RDWR, nullptr, 0, "/concurrent");
+                held.push_back(newFd);
+                auto openInstance = fd->GetOpenInstanceByFd(newFd);
+                failed += openInstance == nullptr || openInstance->inodeId != inodeId;
+                if (held.size() > 8) {
+                    for (uint64_t heldFd : held) {
+                        failed += fd->DeleteOpenInstance(heldFd) != 0;
+                    }
+                    held.clear();
+                }
+            }
+            for (uint64_t heldFd : held) {
+                failed += fd->DeleteOpenInstance(heldFd) != 0;
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(failed.load(), 0);
+    EXPECT_EQ(fd->GetOpenInstanceNum(), openNum);
+}
+
+TEST_F(OpenInstanceUT, DirAttachAndDelete)
+{
+    uint64_t dirFd = fd->AttachDirFd(0);
+    ASSERT_NE(dirFd, UINT64_MAX);
+    DirOpenInstance *dirOpenInstance = fd->GetDirOpenInstanceByFd(dirFd);
+    ASSERT_NE(dirOpenInstance, nullptr);
+    EXPECT_EQ(dirOpenInstance->fd, dirFd);
+    EXPECT_EQ(fd->AddDirOpenInstance(dirFd, dirOpenInstance), -EBADF);
+    EXPECT_EQ(fd->DeleteDirOpenInstance(dirFd), 0);
+    EXPECT_EQ(fd->GetDirOpenInstanceByFd(dirFd), nullptr);
+    EXPECT_EQ(fd->DeleteDirOpenInstance(dirFd), -EBADF);
+}
+
+TEST_F(OpenInstanceUT, LookupDuringOpenClose)
+{
+    uint64_t stableFd = fd->AttachFd(200, O_RDONLY, nullptr, 0, "/stable");
+    std::atomic<bool> stop = false;
+    std::atomic<int> missed = 0;
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([this, &stop, &missed, stableFd]() {
+            while (!stop.load()) {
+                auto openInstance = fd->GetOpenInstanceByFd(stableFd);
+                missed += openInstance == nullptr || openInstance->inodeId != 200;
+            }
+        });
+    }
+    for (int i = 0; i < 2000; ++i) {
+        uint64_t newFd = fd->AttachFd(201, O_RDONLY, nullptr, 0, "/churn");
+        EXPECT_EQ(fd->DeleteOpenInstance(newFd), 0);
+    }
+    stop = true;
+    for (auto &reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(missed.load(), 0);
+    EXPECT_EQ(fd->DeleteOpenInstance(stableFd), 0);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "util/preload.h"
+
+TEST(PreloadPinsUT, PinnedOnceUntilDeadline)
+{
+    PreloadPins pins;
+    EXPECT_TRUE(pins.Pin(1, 1000));
+    EXPECT_TRUE(pins.Pin(2, 2000));
+    /* preloaded again, the later deadline wins and the caller drops its pin */
+    EXPECT_FALSE(pins.Pin(1, 3000));
+    EXPECT_FALSE(pins.Pin(2, 1500));
+    EXPECT_EQ(pins.Size(), 2U);
+
+    EXPECT_TRUE(pins.TakeExpired(999).empty());
+    EXPECT_EQ(pins.TakeExpired(2000), std::vector<uint64_t>({2}));
+    EXPECT_TRUE(pins.TakeExpired(2999).empty());
+    EXPECT_EQ(pins.TakeExpired(3000), std::vector<uint64_t>({1}));
+    EXPECT_EQ(pins.Size(), 0U);
+    /* pinned anew after it expired */
+    EXPECT_TRUE(pins.Pin(1, 4000));
+}
+
+TEST(PreloadPinsUT, ReleasedOnDelete)
+{
+    PreloadPins pins;
+    for (uint64_t inodeId = 1; inodeId <= 10; ++inodeId) {
+        pins.Pin(inodeId, 1000);
+    }
+    EXPECT_TRUE(pins.Release(5));
+    EXPECT_FALSE(pins.Release(5));
+    auto expired = pins.TakeExpired(1000);
+    std::sort(expired.begin(), expired.end());
+    EXPECT_EQ(expired, std::vector<uint64_t>({1, 2, 3, 4, 6, 7, 8, 9, 10}));
+}
+
+TEST(TokenBucketUT, LimitsRate)
+{
+    constexpr uint64_t RATE = 1000;
+    constexpr uint64_t START_MS = 1000000;
+    TokenBucket bucket(RATE);
+    /* a second of burst first */
+    EXPECT_EQ(bucket.Take(RATE, START_MS), 0U);
+    EXPECT_EQ(bucket.Take(1, START_MS), 0U);
+    EXPECT_EQ(bucket.Take(1, START_MS), 1U);
+    EXPECT_EQ(bucket.Take(RATE / 2, START_MS + 1), 0U);
+    EXPECT_EQ(bucket.Take(1, START_MS + 1), 500U);
+    EXPECT_EQ(bucket.Take(1, START_MS + 500), 1U);
+
+    /* over a long run the bytes taken follow the rate */
+    uint64_t nowMs = START_MS + 10000;
+    uint64_t taken = 0;
+    for (uint64_t endMs = nowMs + 10000; nowMs < endMs;) {
+        uint64_t wait = bucket.Take(300, nowMs);
+        if (wait == 0) {
+            taken += 300;
+        }
+        nowMs += std::max<uint64_t>(wait, 1);
+    }
+    EXPECT_GE(taken, 10 * RATE);
+    EXPECT_LE(taken, 11 * RATE + 300);
+}
+
+TEST(TokenBucketUT, LargeTakeAndUnlimited)
+{
+    TokenBucket bucket(100);
+    EXPECT_EQ(bucket.Take(1000, 5000), 0U);
+    EXPECT_EQ(bucket.Take(1, 5000), 9000U);
+    EXPECT_EQ(bucket.Take(1, 14000), 0U);
+
+    TokenBucket unlimited(0);
+    EXPECT_EQ(unlimited.Take(1ULL << 40, 1), 0U);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -55,13 +55,13 @@ TEST_F(CuckooStoreUT, ReadStreamInit)
 {
     int fileBlocks = (openInstance->currentSize + CUCKOO_BLOCK_SIZE - 1) / CUCKOO_BLOCK_SIZE;
 
-    EXPECT_TRUE(openInstance->readStream.Init(openInstance.get(), fileBlocks, CUCKOO_BLOCK_SIZE));
-    openInstance->readStream.StartPushThreaded();
+    EXPECT_TRUE(openInstance->readStream->Init(openInstance.get(), fileBlocks, CUCKOO_BLOCK_SIZE));
+    openInstance->readStream->StartPushThreaded();
 }
 
 TEST_F(CuckooStoreUT, ReadStreamReadZero)
 {
-    ssize_t ret = openInstance->readStream.WaitPop(readBuf, 0);
+    ssize_t ret = openInstance->readStream->WaitPop(readBuf, 0);
     EXPECT_EQ(ret, 0);
 }
 
@@ -69,10 +69,10 @@ TEST_F(CuckooStoreUT, ReadStreamReadExceed)
 {
     size_t largeSize = 2 * config->GetUint32(CuckooPropertyKey::CUCKOO_BLOCK_SIZE);
     char *buf = (char *)malloc(size);
-    auto index = openInstance->readStream.pipeIndex;
-    ssize_t ret = openInstance->readStream.WaitPop(buf, largeSize);
+    auto index = openInstance->readStream->pipeIndex;
+    ssize_t ret = openInstance->readStream->WaitPop(buf, largeSize);
     EXPECT_EQ(ret, largeSize);
-    EXPECT_EQ((index + 2) % openInstance->readStream.pipeNum, openInstance->readStream.pipeIndex);
+    EXPECT_EQ((index + 2) % openInstance->readStream->pipeNum, openInstance->readStream->pipeIndex);
     free(buf);
 }
 
@@ -80,13 +80,13 @@ TEST_F(CuckooStoreUT, ReadStreamReadHalf)
 {
     size_t halfSize = config->GetUint32(CuckooPropertyKey::CUCKOO_BLOCK_SIZE) / 2;
     char *buf = (char *)malloc(halfSize);
-    auto index = openInstance->readStream.pipeIndex;
-    ssize_t ret = openInstance->readStream.WaitPop(buf, halfSize);
+    auto index = openInstance->readStream->pipeIndex;
+    ssize_t ret = openInstance->readStream->WaitPop(buf, halfSize);
     EXPECT_EQ(ret, halfSize);
-    EXPECT_EQ(index, openInstance->readStream.pipeIndex);
-    ret = openInstance->readStream.WaitPop(buf, halfSize);
+    EXPECT_EQ(index, openInstance->readStream->pipeIndex);
+    ret = openInstance->readStream->WaitPop(buf, halfSize);
     EXPECT_EQ(ret, halfSize);
-    EXPECT_EQ((index + 1) % openInstance->readStream.pipeNum, openInstance->readStream.pipeIndex);
+    EXPECT_EQ((index + 1) % openInstance->readStream->pipeNum, openInstance->readStream->pipeIndex);
     free(buf);
 }
 
@@ -96,10 +96,10 @@ TEST_F(CuckooStoreUT, ReadStreamReadFull)
     char *buf = (char *)malloc(fullSize);
     ssize_t ret = 0;
     while (ret == (ssize_t)readSize) {
-        auto index = openInstance->readStream.pipeIndex;
-        ret = openInstance->readStream.WaitPop(buf, fullSize);
+        auto index = openInstance->readStream->pipeIndex;
+        ret = openInstance->readStream->WaitPop(buf, fullSize);
         EXPECT_EQ(ret, fullSize);
-        EXPECT_EQ((index + 1) % openInstance->readStream.pipeNum, openInstance->readStream.pipeIndex);
+        EXPECT_EQ((index + 1) % openInstance->readStream->pipeNum, openInstance->readStream->pipeIndex);
     }
     free(buf);
     openInstance = nullptr;
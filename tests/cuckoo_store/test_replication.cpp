@@ -0,0 +1,205 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "util/replication.h"
+
+using Ranges = std::vector<std::pair<uint64_t, uint64_t>>;
+
+TEST(ReplicationLogUT, FirstSyncShipsWholeFile)
+{
+    ReplicationLog log;
+    EXPECT_FALSE(log.Take(1, 2).has_value());
+    log.MarkDirty(1, 0, 100);
+    EXPECT_TRUE(log.Pending(1));
+    auto work = log.Take(1, 2);
+    ASSERT_TRUE(work.has_value());
+    EXPECT_TRUE(work->full);
+    log.Done(1, 2);
+    EXPECT_FALSE(log.Pending(1));
+    EXPECT_FALSE(log.Take(1, 2).has_value());
+}
+
+TEST(ReplicationLogUT, RangesMerged)
+{
+    ReplicationLog log;
+    log.MarkDirty(1, 0, 10);
+    log.Take(1, 2);
+    log.Done(1, 2);
+
+    log.MarkDirty(1, 100, 10);
+    log.MarkDirty(1, 0, 10);
+    log.MarkDirty(1, 10, 5);
+    log.MarkDirty(1, 105, 20);
+    log.MarkDirty(1, 50, 0);
+    auto work = log.Take(1, 2);
+    ASSERT_TRUE(work.has_value());
+    EXPECT_FALSE(work->full);
+    EXPECT_EQ(work->ranges, Ranges({{0, 15}, {100, 125}}));
+
+    /* a resize alone still syncs, to ship the size */
+    log.MarkDirty(1, 4096, 0);
+    work = log.Take(1, 2);
+    ASSERT_TRUE(work.has_value());
+    EXPECT_TRUE(work->ranges.empty());
+}
+
+TEST(ReplicationLogUT, WholeFileAfterFailureOrNewBackup)
+{
+    ReplicationLog log;
+    log.MarkDirty(1, 0, 10);
+    log.Take(1, 2);
+    log.Done(1, 2);
+
+    log.MarkDirty(1, 0, 10);
+    log.Take(1, 2);
+    log.Fail(1);
+    EXPECT_TRUE(log.Pending(1));
+    EXPECT_TRUE(log.Take(1, 2)->full);
+    log.Done(1, 2);
+
+    log.MarkDirty(1, 0, 10);
+    EXPECT_TRUE(log.Take(1, 3)->full);
+}
+
+TEST(ReplicationLogUT, ChangesDuringSyncKept)
+{
+    ReplicationLog log;
+    log.MarkDirty(1, 0, 10);
+    ASSERT_TRUE(log.Take(1, 2)->full);
+    /* written while the whole file is shipped */
+    log.MarkDirty(1, 20, 10);
+    log.Done(1, 2);
+    auto work = log.Take(1, 2);
+    ASSERT_TRUE(work.has_value());
+    EXPECT_FALSE(work->full);
+    EXPECT_EQ(work->ranges, Ranges({{20, 30}}));
+}
+
+TEST(ReplicationLogUT, TooManyRangesShipWhole)
+{
+    ReplicationLog log;
+    log.MarkDirty(1, 0, 1);
+    log.Take(1, 2);
+    log.Done(1, 2);
+    for (uint64_t i = 0; i <= REPLICATION_MAX_RANGES; ++i) {
+        log.MarkDirty(1, i * 2, 1);
+    }
+    EXPECT_TRUE(log.Take(1, 2)->full);
+}
+
+TEST(ReplicationLogUT, BackupMoved)
+{
+    ReplicationLog log;
+    for (uint64_t inodeId = 1; inodeId <= 4; ++inodeId) {
+        log.MarkDirty(inodeId, 0, 10);
+        log.Take(inodeId, inodeId % 2 == 0 ? 2 : 3);
+        log.Done(inodeId, inodeId % 2 == 0 ? 2 : 3);
+    }
+    /* node 2 is gone, its files are backed up on node 4 now */
+    auto moved = log.TakeMoved([](uint64_t inodeId) { return inodeId % 2 == 0 ? 4 : 3; });
+    std::sort(moved.begin(), moved.end());
+    EXPECT_EQ(moved, std::vector<uint64_t>({2, 4}));
+    EXPECT_TRUE(log.Pending(2));
+    EXPECT_FALSE(log.Pending(1));
+    EXPECT_TRUE(log.Take(4, 4)->full);
+
+    log.Forget(4);
+    EXPECT_FALSE(log.Take(4, 4).has_value());
+    EXPECT_EQ(log.Size(), 3U);
+}
+
+TEST(ReplicationLogUT, ConcurrentWrites)
+{
+    constexpr int THREAD_NUM = 8;
+    constexpr uint64_t WRITE_NUM = 1000;
+    ReplicationLog log;
+    log.MarkDirty(1, 0, 1);
+    log.Take(1, 2);
+    log.Done(1, 2);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREAD_NUM; ++t) {
+        threads.emplace_back([&log, t]() {
+            for (uint64_t i = 0; i < WRITE_NUM; ++i) {
+                log.MarkDirty(1, (t * WRITE_NUM + i) * 10, 10);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    auto work = log.Take(1, 2);
+    ASSERT_TRUE(work.has_value());
+    EXPECT_EQ(work->ranges, Ranges({{0, THREAD_NUM * WRITE_NUM * 10}}));
+}
+
+TEST(BackupCopiesUT, FillThenComplete)
+{
+    BackupCopies copies;
+    EXPECT_FALSE(copies.Accepts(1, 2));
+    copies.BeginFill(1, 2);
+    EXPECT_TRUE(copies.Accepts(1, 2));
+    EXPECT_FALSE(copies.Accepts(1, 3));
+    EXPECT_FALSE(copies.Current(1));
+    copies.Complete(1, 3);
+    EXPECT_FALSE(copies.Current(1));
+    copies.Complete(1, 2);
+    EXPECT_TRUE(copies.Current(1));
+    EXPECT_TRUE(copies.Accepts(1, 2));
+    copies.Erase(1);
+    EXPECT_FALSE(copies.Contains(1));
+    EXPECT_EQ(copies.Size(), 0U);
+}
+
+TEST(BackupCopiesUT, PromotedWhenPrimaryGone)
+{
+    BackupCopies copies;
+    copies.BeginFill(1, 2);
+    copies.Complete(1, 2);
+    copies.BeginFill(2, 2);
+    copies.BeginFill(3, 3);
+    copies.Complete(3, 3);
+
+    EXPECT_EQ(copies.Promote(2), std::vector<uint64_t>({1}));
+    EXPECT_TRUE(copies.Current(1));
+    /* the copy is no backup anymore, the old primary has to ship it whole again */
+    EXPECT_FALSE(copies.Accepts(1, 2));
+    EXPECT_FALSE(copies.Contains(2));
+    EXPECT_TRUE(copies.Accepts(3, 3));
+    EXPECT_TRUE(copies.Promote(2).empty());
+}
+
+TEST(BackupCopiesUT, PrimaryGoneMidShip)
+{
+    BackupCopies copies;
+    copies.BeginFill(1, 2);
+    copies.Complete(1, 2);
+    copies.BeginFill(2, 2);
+    copies.Complete(2, 2);
+
+    /* changes of 1 are being shipped, those of 2 are all in */
+    EXPECT_TRUE(copies.BeginChange(1, 2));
+    EXPECT_TRUE(copies.BeginChange(1, 2));
+    EXPECT_FALSE(copies.Current(1));
+    EXPECT_TRUE(copies.BeginChange(2, 2));
+    copies.Complete(2, 2);
+    EXPECT_TRUE(copies.Current(2));
+    /* changes of another primary do not apply */
+    EXPECT_FALSE(copies.BeginChange(2, 3));
+    EXPECT_FALSE(copies.BeginChange(4, 2));
+    EXPECT_TRUE(copies.Current(2));
+
+    /* the primary dies before the last chunk of 1, the half changed copy is dropped */
+    EXPECT_EQ(copies.Promote(2), std::vector<uint64_t>({2}));
+    EXPECT_FALSE(copies.Contains(1));
+    EXPECT_TRUE(copies.Current(2));
+    EXPECT_FALSE(copies.BeginChange(2, 2));
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
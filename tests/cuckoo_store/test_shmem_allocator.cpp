@@ -0,0 +1,163 @@
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "utils/cuckoo_shmem_allocator.h"
+
+class ShmemAllocatorUT : public testing::Test {
+  protected:
+    static constexpr uint64_t PAGE_COUNT = 32;
+
+    void SetUp() override
+    {
+        uint64_t size = (PAGE_COUNT + 1) * (sizeof(PaddedAtomic64) + CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE);
+        shmem = (char *)aligned_alloc(CUCKOO_SHMEM_ALLOCATOR_PAD_SIZE, size);
+        ASSERT_EQ(CuckooShmemAllocatorInit(&allocator, shmem, size), 0);
+        CuckooShmemAllocatorReset(&allocator);
+        ASSERT_GE(allocator.pageCount, PAGE_COUNT);
+        ASSERT_LE((uint64_t)(allocator.allocatableSpaceBase - shmem) +
+                      (uint64_t)allocator.pageCount * CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE,
+                  size);
+    }
+
+    void TearDown() override { free(shmem); }
+
+    CuckooShmemAllocatorStats Stats()
+    {
+        CuckooShmemAllocatorStats stats;
+        CuckooShmemAllocatorGetStats(&allocator, &stats);
+        return stats;
+    }
+
+    /* allocates blocks of the size until the allocator is exhausted */
+    std::vector<uint64_t> AllocateAll(uint64_t size)
+    {
+        std::vector<uint64_t> shifts;
+        uint64_t shift;
+        while ((shift = CuckooShmemAllocatorMalloc(&allocator, size)) != 0) {
+            shifts.push_back(shift);
+        }
+        return shifts;
+    }
+
+    char *shmem = nullptr;
+    CuckooShmemAllocator allocator;
+};
+
+TEST_F(ShmemAllocatorUT, FreedBlockIsReused)
+{
+    uint64_t shift = CuckooShmemAllocatorMalloc(&allocator, 1000);
+    ASSERT_NE(shift, 0U);
+    EXPECT_EQ(CUCKOO_SHMEM_ALLOCATOR_POINTER_GET_SIZE(CUCKOO_SHMEM_ALLOCATOR_GET_POINTER(&allocator, shift)), 1000U);
+    CuckooShmemAllocatorFree(&allocator, shift);
+    EXPECT_EQ(CuckooShmemAllocatorMalloc(&allocator, 2000), shift);
+    CuckooShmemAllocatorFree(&allocator, shift);
+
+    CuckooShmemAllocatorStats stats = Stats();
+    EXPECT_EQ(stats.allocCount, 2U);
+    EXPECT_EQ(stats.freeCount, 2U);
+    EXPECT_EQ(stats.freeListHits, 1U);
+    EXPECT_EQ(stats.usedBytes, 0U);
+    EXPECT_EQ(stats.requestedBytes, 0U);
+}
+
+TEST_F(ShmemAllocatorUT, CachedBlocksMergeAgain)
+{
+    /* exhaust with the smallest class, the cached frees have to be drained to serve whole pages */
+    std::vector<uint64_t> small = AllocateAll(100);
+    ASSERT_EQ(small.size(), allocator.pageCount * CUCKOO_SHMEM_ALLOCATOR_STATE_BIT_COUNT);
+    EXPECT_EQ(Stats().largestFreeBlock, 0U);
+    for (uint64_t shift : small) {
+        CuckooShmemAllocatorFree(&allocator, shift);
+    }
+    EXPECT_GT(Stats().cachedBytes, 0U);
+
+    std::vector<uint64_t> pages = AllocateAll(CUCKOO_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE - sizeof(MemoryHdr));
+    EXPECT_EQ(pages.size(), allocator.pageCount);
+    for (uint64_t shift : pages) {
+        CuckooShmemAllocatorFree(&allocator, shift);
+    }
+
+    /* and the other way round */
+    small = AllocateAll(100);
+    EXPECT_EQ(small.size(), allocator.pageCount * CUCKOO_SHMEM_ALLOCATOR_STATE_BIT_COUNT);
+    for (uint64_t shift : small) {
+        CuckooShmemAllocatorFree(&allocator, shift);
+    }
+    EXPECT_EQ(Stats().usedBytes, 0U);
+}
+
+TEST_F(ShmemAllocatorUT, Stats)
+{
+    uint64_t a = CuckooShmemAllocatorMalloc(&allocator, 100);
+    uint64_t b = CuckooShmemAllocatorMalloc(&allocator, 100 * 1024);
+    ASSERT_NE(a, 0U);
+    ASSERT_NE(b, 0U);
+    CuckooShmemAllocatorStats stats = Stats();
+    EXPECT_EQ(stats.totalBytes, (uint64_t)allocator.pageCount * CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE);
+    EXPECT_EQ(stats.requestedBytes, 100U + 100 * 1024);
+    EXPECT_EQ(stats.usedBytes, (uint64_t)CUCKOO_SHMEM_ALLOCATOR_MIN_BLOCK_SIZE + 128 * 1024);
+    EXPECT_EQ(stats.freeBytes, stats.totalBytes - stats.usedBytes);
+    EXPECT_EQ(stats.largestFreeBlock, CUCKOO_SHMEM_ALLOCATOR_PAGE_SIZE);
+    EXPECT_EQ(stats.allocCount, 2U);
+    EXPECT_GE(stats.allocMaxNs, stats.allocNs / 2);
+    CuckooShmemAllocatorFree(&allocator, a);
+    CuckooShmemAllocatorFree(&allocator, b);
+}
+
+TEST_F(ShmemAllocatorUT, ConcurrentBlocksDoNotOverlap)
+{
+    constexpr int THREAD_NUM = 8;
+    constexpr int ROUNDS = 20000;
+    std::vector<std::thread> threads;
+    std::atomic<int> corrupted = 0;
+    for (int t = 0; t < THREAD_NUM; ++t) {
+        threads.emplace_back([this, &corrupted, t]() {
+            std::mt19937_64 rng(t);
+            std::vector<std::pair<uint64_t, uint64_t>> held;
+            for (int i = 0; i < ROUNDS; ++i) {
+                uint64_t size = rng() % 4 == 0 ? 16 * 1024 + rng() % (200 * 1024) : 8 + rng() % 8000;
+                uint64_t shift = CuckooShmemAllocatorMalloc(&allocator, size);
+                if (shift != 0) {
+                    memset(CUCKOO_SHMEM_ALLOCATOR_GET_POINTER(&allocator, shift), t + 1, size);
+                    held.emplace_back(shift, size);
+                }
+                if (held.size() > 16 || (shift == 0 && !held.empty())) {
+                    size_t victim = rng() % held.size();
+                    auto [victimShift, victimSize] = held[victim];
+                    const char *p = CUCKOO_SHMEM_ALLOCATOR_GET_POINTER(&allocator, victimShift);
+                    for (uint64_t j = 0; j < victimSize; j += 511) {
+                        corrupted += p[j] != t + 1;
+                    }
+                    CuckooShmemAllocatorFree(&allocator, victimShift);
+                    held[victim] = held.back();
+                    held.pop_back();
+                }
+            }
+            for (auto [shift, size] : held) {
+                CuckooShmemAllocatorFree(&allocator, shift);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(corrupted.load(), 0);
+    CuckooShmemAllocatorStats stats = Stats();
+    EXPECT_EQ(stats.usedBytes, 0U);
+    EXPECT_EQ(stats.allocCount, stats.freeCount);
+
+    /* everything merges back into whole pages */
+    std::vector<uint64_t> pages = AllocateAll(CUCKOO_SHMEM_ALLOCATOR_MAX_SUPPORT_ALLOC_SIZE - sizeof(MemoryHdr));
+    EXPECT_EQ(pages.size(), allocator.pageCount);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,113 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <latch>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "thread_pool/thread_pool.h"
+
+TEST(ThreadPoolUT, RunAllTasks)
+{
+    auto pool = ThreadPool::CreateThreadPool(4, 1000, "ut_pool");
+    ASSERT_EQ(pool->Start(), 0);
+    constexpr int taskNum = 10000;
+    std::atomic<int> done{0};
+    for (int i = 0; i < taskNum; ++i) {
+        TaskPriority priority = i % 2 == 0 ? TaskPriority::FOREGROUND : TaskPriority::BACKGROUND;
+        pool->Submit({.taskName = "", .task = [&done]() { done.fetch_add(1); }, .priority = priority});
+    }
+    pool->Stop();
+    EXPECT_EQ(done.load(), taskNum);
+    EXPECT_EQ(pool->GetQueueDepth(TaskPriority::FOREGROUND), 0U);
+    EXPECT_EQ(pool->GetQueueDepth(TaskPriority::BACKGROUND), 0U);
+}
+
+TEST(ThreadPoolUT, QueueDepthNeverWraps)
+{
+    auto pool = ThreadPool::CreateThreadPool(4, 1000, "ut_pool");
+    ASSERT_EQ(pool->Start(), 0);
+    /* tasks are taken as soon as they are pushed, the exported depth must stay within the queue bound */
+    std::atomic<bool> submitting{true};
+    std::atomic<uint64_t> maxDepth{0};
+    std::thread sampler([&]() {
+        while (submitting.load()) {
+            uint64_t depth = pool->GetQueueDepth(TaskPriority::FOREGROUND);
+            if (depth > maxDepth.load()) {
+                maxDepth = depth;
+            }
+        }
+    });
+    for (int i = 0; i < 100000; ++i) {
+        pool->Submit({.taskName = "", .task = []() {}});
+    }
+    pool->Stop();
+    submitting = false;
+    sampler.join();
+    EXPECT_LE(maxDepth.load(), 1000U);
+}
+
+TEST(ThreadPoolUT, SubmitFromTask)
+{
+    auto pool = ThreadPool::CreateThreadPool(2, 100, "ut_pool");
+    ASSERT_EQ(pool->Start(), 0);
+    std::promise<void> promise;
+    pool->Submit({.taskName = "", .task = [&]() {
+                      pool->Submit({.taskName = "", .task = [&promise]() { promise.set_value(); }});
+                  }});
+    EXPECT_EQ(promise.get_future().wait_for(std::chrono::seconds(5)), std::future_status::ready);
+}
+
+TEST(ThreadPoolUT, ForegroundBeforeBackground)
+{
+    auto pool = ThreadPool::CreateThreadPool(1, 100, "ut_pool");
+    ASSERT_EQ(pool->Start(), 0);
+    /* hold the only worker so that the tasks below are queued together */
+    std::latch blocker(1);
+    pool->Submit({.taskName = "", .task = [&blocker]() { blocker.wait(); }});
+    while (pool->GetQueueDepth(TaskPriority::FOREGROUND) != 0) {
+        std::this_thread::yield();
+    }
+
+    std::vector<TaskPriority> order;
+    std::mutex mutex;
+    auto record = [&](TaskPriority priority) {
+        return [&, priority]() {
+            std::lock_guard lock(mutex);
+            order.push_back(priority);
+        };
+    };
+    pool->Submit({.taskName = "", .task = record(TaskPriority::BACKGROUND), .priority = TaskPriority::BACKGROUND});
+    pool->Submit({.taskName = "", .task = record(TaskPriority::FOREGROUND), .priority = TaskPriority::FOREGROUND});
+    EXPECT_EQ(pool->GetQueueDepth(TaskPriority::FOREGROUND), 1U);
+    EXPECT_EQ(pool->GetQueueDepth(TaskPriority::BACKGROUND), 1U);
+    blocker.count_down();
+    pool->Stop();
+
+    ASSERT_EQ(order.size(), 2U);
+    EXPECT_EQ(order[0], TaskPriority::FOREGROUND);
+    EXPECT_EQ(order[1], TaskPriority::BACKGROUND);
+}
+
+TEST(ThreadPoolUT, IdleWorkerSteals)
+{
+    auto pool = ThreadPool::CreateThreadPool(2, 100, "ut_pool");
+    ASSERT_EQ(pool->Start(), 0);
+    /* both tasks are pushed to the queue of the worker running the first one, the other worker must steal */
+    std::latch bothRunning(2);
+    pool->Submit({.taskName = "", .task = [&]() {
+                      pool->Submit({.taskName = "", .task = [&bothRunning]() { bothRunning.arrive_and_wait(); }});
+                      bothRunning.arrive_and_wait();
+                  }});
+    pool->Stop();
+    EXPECT_GE(pool->GetStealCount(), 1U);
+}
+
+int main(int argc, char **argv)
+{
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}